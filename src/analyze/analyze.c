@@ -44,6 +44,7 @@
 #if HAVE_SECCOMP
 #  include "seccomp-util.h"
 #endif
+#include "set.h"
 #include "sort-util.h"
 #include "special.h"
 #include "strv.h"
@@ -52,6 +53,7 @@
 #include "time-util.h"
 #include "unit-name.h"
 #include "util.h"
+#include "varlink.h"
 #include "verbs.h"
 
 #define SCALE_X (0.1 / 1000.0) /* pixels per us */
@@ -330,6 +332,141 @@ static HostInfo* free_host_info(HostInfo *hi) {
 
 DEFINE_TRIVIAL_CLEANUP_FUNC(HostInfo *, free_host_info);
 
+static bool unit_times_finish(UnitTimes *t, const BootTimes *boot_times) {
+        assert(t);
+        assert(boot_times);
+
+        subtract_timestamp(&t->activating, boot_times->reverse_offset);
+        subtract_timestamp(&t->activated, boot_times->reverse_offset);
+        subtract_timestamp(&t->deactivating, boot_times->reverse_offset);
+        subtract_timestamp(&t->deactivated, boot_times->reverse_offset);
+
+        if (t->activated >= t->activating)
+                t->time = t->activated - t->activating;
+        else if (t->deactivated >= t->activating)
+                t->time = t->deactivated - t->activating;
+        else
+                t->time = 0;
+
+        /* Units that were never activated are not of interest */
+        return t->activating != 0;
+}
+
+static int acquire_time_data_bulk(sd_bus *bus, const BootTimes *boot_times, UnitTimes **out) {
+        static const struct bus_properties_map property_map[] = {
+                { "Id",                              "s", NULL, offsetof(UnitTimes, name)         },
+                { "InactiveExitTimestampMonotonic",  "t", NULL, offsetof(UnitTimes, activating)   },
+                { "ActiveEnterTimestampMonotonic",   "t", NULL, offsetof(UnitTimes, activated)    },
+                { "ActiveExitTimestampMonotonic",    "t", NULL, offsetof(UnitTimes, deactivating) },
+                { "InactiveEnterTimestampMonotonic", "t", NULL, offsetof(UnitTimes, deactivated)  },
+                {},
+        };
+        _cleanup_(sd_bus_message_unrefp) sd_bus_message *m = NULL, *reply = NULL;
+        _cleanup_(sd_bus_error_free) sd_bus_error error = SD_BUS_ERROR_NULL;
+        _cleanup_(unit_times_free_arrayp) UnitTimes *unit_times = NULL;
+        size_t allocated = 0, c = 0;
+        int r;
+
+        /* Fetches the timestamps of all units with a single call, instead of one GetAll() per unit.
+         * Returns 0 if the manager does not implement the method, so that the caller can fall back to
+         * querying each unit on its own. */
+
+        r = bus_message_new_method_call(bus, &m, bus_systemd_mgr, "ListUnitPropertiesByPatterns");
+        if (r < 0)
+                return bus_log_create_error(r);
+
+        r = sd_bus_message_append_strv(m, NULL);
+        if (r < 0)
+                return bus_log_create_error(r);
+
+        r = sd_bus_message_append_strv(m, NULL);
+        if (r < 0)
+                return bus_log_create_error(r);
+
+        r = sd_bus_message_append_strv(m, STRV_MAKE("Id",
+                                                    "InactiveExitTimestampMonotonic",
+                                                    "ActiveEnterTimestampMonotonic",
+                                                    "ActiveExitTimestampMonotonic",
+                                                    "InactiveEnterTimestampMonotonic"));
+        if (r < 0)
+                return bus_log_create_error(r);
+
+        r = sd_bus_call(bus, m, 0, &error, &reply);
+        if (sd_bus_error_has_name(&error, SD_BUS_ERROR_UNKNOWN_METHOD)) {
+                log_debug("Manager does not support ListUnitPropertiesByPatterns(), querying units individually.");
+                return 0;
+        }
+        if (r < 0)
+                return log_error_errno(r, "Failed to get unit properties: %s", bus_error_message(&error, r));
+
+        r = sd_bus_message_enter_container(reply, SD_BUS_TYPE_ARRAY, "{oa{sa{sv}}}");
+        if (r < 0)
+                return bus_log_parse_error(r);
+
+        while ((r = sd_bus_message_enter_container(reply, SD_BUS_TYPE_DICT_ENTRY, "oa{sa{sv}}")) > 0) {
+                UnitTimes *t;
+
+                if (!GREEDY_REALLOC(unit_times, allocated, c + 2))
+                        return log_oom();
+
+                unit_times[c + 1].has_data = false;
+                t = &unit_times[c];
+                *t = (UnitTimes) {};
+
+                r = sd_bus_message_skip(reply, "o");
+                if (r < 0)
+                        return bus_log_parse_error(r);
+
+                r = sd_bus_message_enter_container(reply, SD_BUS_TYPE_ARRAY, "{sa{sv}}");
+                if (r < 0)
+                        return bus_log_parse_error(r);
+
+                while ((r = sd_bus_message_enter_container(reply, SD_BUS_TYPE_DICT_ENTRY, "sa{sv}")) > 0) {
+                        r = sd_bus_message_skip(reply, "s");
+                        if (r >= 0)
+                                r = bus_message_map_all_properties(reply, property_map, BUS_MAP_STRDUP, &error, t);
+                        if (r >= 0)
+                                r = sd_bus_message_exit_container(reply);
+                        if (r < 0) {
+                                t->name = mfree(t->name);
+                                return bus_log_parse_error(r);
+                        }
+                }
+                if (r >= 0)
+                        r = sd_bus_message_exit_container(reply);
+                if (r >= 0)
+                        r = sd_bus_message_exit_container(reply);
+                if (r < 0) {
+                        t->name = mfree(t->name);
+                        return bus_log_parse_error(r);
+                }
+
+                if (!t->name || !unit_times_finish(t, boot_times)) {
+                        t->name = mfree(t->name);
+                        continue;
+                }
+
+                t->has_data = true;
+                c++;
+        }
+        if (r < 0)
+                return bus_log_parse_error(r);
+
+        r = sd_bus_message_exit_container(reply);
+        if (r < 0)
+                return bus_log_parse_error(r);
+
+        /* Make sure we return an array even if no unit had any data */
+        if (!unit_times) {
+                unit_times = new0(UnitTimes, 1);
+                if (!unit_times)
+                        return log_oom();
+        }
+
+        *out = TAKE_PTR(unit_times);
+        return 1;
+}
+
 static int acquire_time_data(sd_bus *bus, UnitTimes **out) {
         static const struct bus_properties_map property_map[] = {
                 { "InactiveExitTimestampMonotonic",  "t", NULL, offsetof(UnitTimes, activating)   },
@@ -350,6 +487,17 @@ static int acquire_time_data(sd_bus *bus, UnitTimes **out) {
         if (r < 0)
                 return r;
 
+        r = acquire_time_data_bulk(bus, boot_times, &unit_times);
+        if (r < 0)
+                return r;
+        if (r > 0) {
+                for (UnitTimes *t = unit_times; t->has_data; t++)
+                        c++;
+
+                *out = TAKE_PTR(unit_times);
+                return c;
+        }
+
         r = bus_call_method(bus, bus_systemd_mgr, "ListUnits", &error, &reply, NULL);
         if (r < 0)
                 return log_error_errno(r, "Failed to list units: %s", bus_error_message(&error, r));
@@ -383,19 +531,7 @@ static int acquire_time_data(sd_bus *bus, UnitTimes **out) {
                         return log_error_errno(r, "Failed to get timestamp properties of unit %s: %s",
                                                u.id, bus_error_message(&error, r));
 
-                subtract_timestamp(&t->activating, boot_times->reverse_offset);
-                subtract_timestamp(&t->activated, boot_times->reverse_offset);
-                subtract_timestamp(&t->deactivating, boot_times->reverse_offset);
-                subtract_timestamp(&t->deactivated, boot_times->reverse_offset);
-
-                if (t->activated >= t->activating)
-                        t->time = t->activated - t->activating;
-                else if (t->deactivated >= t->activating)
-                        t->time = t->deactivated - t->activating;
-                else
-                        t->time = 0;
-
-                if (t->activating == 0)
+                if (!unit_times_finish(t, boot_times))
                         continue;
 
                 t->name = strdup(u.id);
@@ -893,7 +1029,7 @@ static bool times_in_range(const UnitTimes *times, const BootTimes *boot) {
         return times && times->activated > 0 && times->activated <= boot->finish_time;
 }
 
-static int list_dependencies_one(sd_bus *bus, const char *name, unsigned level, char ***units, unsigned branches) {
+static int list_dependencies_one(sd_bus *bus, const char *name, unsigned level, Set **units, unsigned branches) {
         _cleanup_strv_free_ char **deps = NULL;
         char **c;
         int r;
@@ -902,7 +1038,10 @@ static int list_dependencies_one(sd_bus *bus, const char *name, unsigned level,
         UnitTimes *times;
         BootTimes *boot;
 
-        if (strv_extend(units, name))
+        /* Every unit is expanded only once per chain, the set remembers which ones have been seen. A set
+         * rather than a list, so that lookups stay cheap on systems with many thousands of units. */
+        r = set_put_strdup(units, name);
+        if (r < 0)
                 return log_oom();
 
         r = list_dependencies_get_dependencies(bus, name, &deps);
@@ -944,7 +1083,7 @@ static int list_dependencies_one(sd_bus *bus, const char *name, unsigned level,
                 if (r < 0)
                         return r;
 
-                if (strv_contains(*units, *c)) {
+                if (set_contains(*units, *c)) {
                         r = list_dependencies_print("...", level + 1, (branches << 1) | (to_print ? 1 : 0),
                                                     true, NULL, boot);
                         if (r < 0)
@@ -963,7 +1102,7 @@ static int list_dependencies_one(sd_bus *bus, const char *name, unsigned level,
 }
 
 static int list_dependencies(sd_bus *bus, const char *name) {
-        _cleanup_strv_free_ char **units = NULL;
+        _cleanup_set_free_free_ Set *units = NULL;
         char ts[FORMAT_TIMESPAN_MAX];
         UnitTimes *times;
         int r;
@@ -1114,6 +1253,79 @@ static int analyze_blame(int argc, char *argv[], void *userdata) {
         return table_print(table, NULL);
 }
 
+static int analyze_generator_blame(int argc, char *argv[], void *userdata) {
+        _cleanup_(sd_bus_flush_close_unrefp) sd_bus *bus = NULL;
+        _cleanup_(sd_bus_message_unrefp) sd_bus_message *reply = NULL;
+        _cleanup_(sd_bus_error_free) sd_bus_error error = SD_BUS_ERROR_NULL;
+        _cleanup_(table_unrefp) Table *table = NULL;
+        const char *path;
+        usec_t start, finish;
+        TableCell *cell;
+        int r;
+
+        r = acquire_bus(&bus, NULL);
+        if (r < 0)
+                return bus_log_connect_error(r);
+
+        r = sd_bus_get_property(
+                        bus,
+                        "org.freedesktop.systemd1",
+                        "/org/freedesktop/systemd1",
+                        "org.freedesktop.systemd1.Manager",
+                        "GeneratorTimestampsMonotonic",
+                        &error,
+                        &reply,
+                        "a(stt)");
+        if (r < 0)
+                return log_error_errno(r, "Failed to get generator timestamps: %s", bus_error_message(&error, r));
+
+        table = table_new("time", "generator");
+        if (!table)
+                return log_oom();
+
+        table_set_header(table, false);
+
+        assert_se(cell = table_get_cell(table, 0, 0));
+        r = table_set_align_percent(table, cell, 100);
+        if (r < 0)
+                return r;
+
+        assert_se(cell = table_get_cell(table, 0, 1));
+        r = table_set_ellipsize_percent(table, cell, 100);
+        if (r < 0)
+                return r;
+
+        r = table_set_sort(table, (size_t) 0);
+        if (r < 0)
+                return r;
+
+        r = table_set_reverse(table, 0, true);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_message_enter_container(reply, 'a', "(stt)");
+        if (r < 0)
+                return bus_log_parse_error(r);
+
+        while ((r = sd_bus_message_read(reply, "(stt)", &path, &start, &finish)) > 0) {
+                r = table_add_many(table,
+                                   TABLE_TIMESPAN_MSEC, usec_sub_unsigned(finish, start),
+                                   TABLE_STRING, path);
+                if (r < 0)
+                        return table_log_add_error(r);
+        }
+        if (r < 0)
+                return bus_log_parse_error(r);
+
+        r = sd_bus_message_exit_container(reply);
+        if (r < 0)
+                return bus_log_parse_error(r);
+
+        (void) pager_open(arg_pager_flags);
+
+        return table_print(table, NULL);
+}
+
 static int analyze_time(int argc, char *argv[], void *userdata) {
         _cleanup_(sd_bus_flush_close_unrefp) sd_bus *bus = NULL;
         _cleanup_free_ char *buf = NULL;
@@ -1360,6 +1572,32 @@ static int dump(int argc, char *argv[], void *userdata) {
         return copy_bytes(fd, STDOUT_FILENO, UINT64_MAX, 0);
 }
 
+static int dump_metrics(int argc, char *argv[], void *userdata) {
+        _cleanup_(varlink_unrefp) Varlink *vl = NULL;
+        const char *error_id = NULL;
+        JsonVariant *reply = NULL;
+        int r;
+
+        if (arg_scope != UNIT_FILE_SYSTEM || arg_transport != BUS_TRANSPORT_LOCAL)
+                return log_error_errno(SYNTHETIC_ERRNO(EOPNOTSUPP),
+                                       "Metrics are only available for the local system service manager.");
+
+        r = varlink_connect_address(&vl, VARLINK_ADDR_PATH_MANAGER);
+        if (r < 0)
+                return log_error_errno(r, "Failed to connect to %s: %m", VARLINK_ADDR_PATH_MANAGER);
+
+        r = varlink_call(vl, "io.systemd.Manager.GetMetrics", NULL, &reply, &error_id, NULL);
+        if (r < 0)
+                return log_error_errno(r, "Failed to issue GetMetrics() varlink call: %m");
+        if (error_id)
+                return log_error_errno(SYNTHETIC_ERRNO(EBADMSG), "GetMetrics() varlink call failed: %s", error_id);
+
+        (void) pager_open(arg_pager_flags);
+
+        json_variant_dump(reply, JSON_FORMAT_PRETTY_AUTO|JSON_FORMAT_COLOR_AUTO, stdout, NULL);
+        return 0;
+}
+
 static int cat_config(int argc, char *argv[], void *userdata) {
         char **arg, **list;
         int r;
@@ -2181,10 +2419,12 @@ static int help(int argc, char *argv[], void *userdata) {
                "\nCommands:\n"
                "  [time]                   Print time required to boot the machine\n"
                "  blame                    Print list of running units ordered by time to init\n"
+               "  generator-blame          Print list of generators ordered by run time\n"
                "  critical-chain [UNIT...] Print a tree of the time critical chain of units\n"
                "  plot                     Output SVG graphic showing service initialization\n"
                "  dot [UNIT...]            Output dependency graph in %s format\n"
                "  dump                     Output state serialization of service manager\n"
+               "  metrics                  Show internal statistics of the service manager\n"
                "  cat-config               Show configuration file and drop-ins\n"
                "  unit-files               List files and symlinks for units\n"
                "  unit-paths               List load directories for units\n"
@@ -2395,6 +2635,7 @@ static int run(int argc, char *argv[]) {
                 { "help",              VERB_ANY, VERB_ANY, 0,            help                   },
                 { "time",              VERB_ANY, 1,        VERB_DEFAULT, analyze_time           },
                 { "blame",             VERB_ANY, 1,        0,            analyze_blame          },
+                { "generator-blame",   VERB_ANY, 1,        0,            analyze_generator_blame },
                 { "critical-chain",    VERB_ANY, VERB_ANY, 0,            analyze_critical_chain },
                 { "plot",              VERB_ANY, 1,        0,            analyze_plot           },
                 { "dot",               VERB_ANY, VERB_ANY, 0,            dot                    },
@@ -2407,6 +2648,7 @@ static int run(int argc, char *argv[]) {
                 { "get-log-target",    VERB_ANY, 1,        0,            get_log_target         },
                 { "service-watchdogs", VERB_ANY, 2,        0,            service_watchdogs      },
                 { "dump",              VERB_ANY, 1,        0,            dump                   },
+                { "metrics",           VERB_ANY, 1,        0,            dump_metrics           },
                 { "cat-config",        2,        VERB_ANY, 0,            cat_config             },
                 { "unit-files",        VERB_ANY, VERB_ANY, 0,            do_unit_files          },
                 { "unit-paths",        1,        1,        0,            dump_unit_paths        },
@@ -0,0 +1,144 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "memory-util.h"
+
+#define ARENA_CHUNK_SIZE_MIN (4U*1024U)
+#define ARENA_CHUNK_SIZE_MAX (64U*1024U)
+
+struct arena_chunk {
+        struct arena_chunk *next;
+        size_t size;
+        size_t n_used;
+};
+
+#define CHUNK_HEADER_SIZE ALIGN(sizeof(struct arena_chunk))
+
+static void* chunk_data(struct arena_chunk *c) {
+        return (uint8_t*) c + CHUNK_HEADER_SIZE;
+}
+
+void* arena_alloc(Arena *a, size_t size) {
+        struct arena_chunk *c;
+        size_t n;
+
+        assert(a);
+
+        if (size > SIZE_MAX - 8)
+                return NULL;
+        size = ALIGN(MAX(size, (size_t) 1));
+
+        c = a->first_chunk;
+        if (_likely_(c && c->size - c->n_used >= size)) {
+                void *p = (uint8_t*) chunk_data(c) + c->n_used;
+
+                c->n_used += size;
+                return p;
+        }
+
+        /* Objects larger than a quarter of a regular chunk get a chunk of their own, which is queued behind
+         * the current one, so that the space left in that isn't wasted. */
+        if (size > ARENA_CHUNK_SIZE_MAX / 4) {
+                if (size > SIZE_MAX - CHUNK_HEADER_SIZE)
+                        return NULL;
+
+                c = malloc(CHUNK_HEADER_SIZE + size);
+                if (!c)
+                        return NULL;
+
+                c->size = c->n_used = size;
+
+                if (a->first_chunk) {
+                        c->next = a->first_chunk->next;
+                        a->first_chunk->next = c;
+                } else {
+                        c->next = NULL;
+                        a->first_chunk = c;
+                }
+
+                return chunk_data(c);
+        }
+
+        /* Start out small, since most arenas only ever see a few objects, and then double the chunk size */
+        n = CLAMP(a->next_size, ARENA_CHUNK_SIZE_MIN, ARENA_CHUNK_SIZE_MAX);
+        while (n - CHUNK_HEADER_SIZE < size)
+                n *= 2;
+
+        c = malloc(n);
+        if (!c)
+                return NULL;
+
+        *c = (struct arena_chunk) {
+                .next = a->first_chunk,
+                .size = n - CHUNK_HEADER_SIZE,
+                .n_used = size,
+        };
+
+        a->first_chunk = c;
+        a->next_size = n * 2;
+
+        return chunk_data(c);
+}
+
+void* arena_alloc0(Arena *a, size_t size) {
+        void *p;
+
+        p = arena_alloc(a, size);
+        if (!p)
+                return NULL;
+
+        return memset(p, 0, size);
+}
+
+void* arena_memdup(Arena *a, const void *p, size_t size) {
+        void *q;
+
+        assert(p || size == 0);
+
+        q = arena_alloc(a, size);
+        if (!q)
+                return NULL;
+
+        memcpy_safe(q, p, size);
+        return q;
+}
+
+char* arena_strndup(Arena *a, const char *s, size_t n) {
+        char *p;
+
+        assert(s);
+
+        n = strnlen(s, n);
+        if (n == SIZE_MAX)
+                return NULL;
+
+        p = arena_alloc(a, n + 1);
+        if (!p)
+                return NULL;
+
+        memcpy(p, s, n);
+        p[n] = 0;
+
+        return p;
+}
+
+char* arena_strdup(Arena *a, const char *s) {
+        return arena_strndup(a, s, SIZE_MAX);
+}
+
+void arena_done(Arena *a) {
+        assert(a);
+
+        while (a->first_chunk) {
+                struct arena_chunk *c = a->first_chunk;
+
+                a->first_chunk = c->next;
+                free(c);
+        }
+
+        a->next_size = 0;
+}
@@ -0,0 +1,27 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+#pragma once
+
+#include <stddef.h>
+
+#include "macro.h"
+
+/* A region allocator: objects are carved out of larger chunks, and are never freed individually, but all at
+ * once with arena_done(). Useful for the many small allocations whose lifetime is bound to that of some
+ * other object, e.g. a message or an event. Returned memory is aligned to ALIGN(). An arena is owned by whoever embeds it, and must not be used by
+ * multiple threads at the same time, but any thread may use it. Zero-initialize it before use. */
+
+struct arena_chunk;
+
+typedef struct Arena {
+        struct arena_chunk *first_chunk;
+        size_t next_size;
+} Arena;
+
+void* arena_alloc(Arena *a, size_t size) _alloc_(2);
+void* arena_alloc0(Arena *a, size_t size) _alloc_(2);
+void* arena_memdup(Arena *a, const void *p, size_t size) _alloc_(3);
+char* arena_strndup(Arena *a, const char *s, size_t n);
+char* arena_strdup(Arena *a, const char *s);
+
+/* Releases all memory allocated from the arena. The arena may be reused afterwards. */
+void arena_done(Arena *a);
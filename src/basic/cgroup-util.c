@@ -20,6 +20,7 @@
 #include "fileio.h"
 #include "format-util.h"
 #include "fs-util.h"
+#include "io-util.h"
 #include "log.h"
 #include "login-util.h"
 #include "macro.h"
@@ -58,10 +59,41 @@ static int cg_enumerate_items(const char *controller, const char *path, FILE **_
         return 0;
 }
 
+static int cg_enumerate_items_at(int dfd, const char *item, FILE **_f) {
+        assert(dfd >= 0);
+        assert(item);
+        assert(_f);
+
+        return xfopenat(dfd, item, "re", O_NOFOLLOW, _f);
+}
+
+int cg_open_dir(const char *controller, const char *path) {
+        _cleanup_free_ char *fs = NULL;
+        int r, fd;
+
+        /* Returns an O_DIRECTORY fd for the specified cgroup, for use with the _at() calls below. This
+         * allows callers which look at the same cgroup (or its subtree) repeatedly to avoid building and
+         * resolving the full path for each attribute. */
+
+        r = cg_get_path(controller, path, NULL, &fs);
+        if (r < 0)
+                return r;
+
+        fd = open(fs, O_RDONLY|O_DIRECTORY|O_CLOEXEC);
+        if (fd < 0)
+                return -errno;
+
+        return fd;
+}
+
 int cg_enumerate_processes(const char *controller, const char *path, FILE **_f) {
         return cg_enumerate_items(controller, path, _f, "cgroup.procs");
 }
 
+int cg_enumerate_processes_at(int dfd, FILE **_f) {
+        return cg_enumerate_items_at(dfd, "cgroup.procs", _f);
+}
+
 int cg_read_pid(FILE *f, pid_t *_pid) {
         unsigned long ul;
 
@@ -87,22 +119,12 @@ int cg_read_pid(FILE *f, pid_t *_pid) {
         return 1;
 }
 
-int cg_read_event(
-                const char *controller,
-                const char *path,
-                const char *event,
-                char **ret) {
-
-        _cleanup_free_ char *events = NULL, *content = NULL;
+static int cg_parse_event(const char *content, const char *event, char **ret) {
         int r;
 
-        r = cg_get_path(controller, path, "cgroup.events", &events);
-        if (r < 0)
-                return r;
-
-        r = read_full_virtual_file(events, &content, NULL);
-        if (r < 0)
-                return r;
+        assert(content);
+        assert(event);
+        assert(ret);
 
         for (const char *p = content;;) {
                 _cleanup_free_ char *line = NULL, *key = NULL, *val = NULL;
@@ -133,6 +155,39 @@ int cg_read_event(
         }
 }
 
+int cg_read_event(
+                const char *controller,
+                const char *path,
+                const char *event,
+                char **ret) {
+
+        _cleanup_free_ char *events = NULL, *content = NULL;
+        int r;
+
+        r = cg_get_path(controller, path, "cgroup.events", &events);
+        if (r < 0)
+                return r;
+
+        r = read_full_virtual_file(events, &content, NULL);
+        if (r < 0)
+                return r;
+
+        return cg_parse_event(content, event, ret);
+}
+
+int cg_read_event_at(int dfd, const char *event, char **ret) {
+        _cleanup_free_ char *content = NULL;
+        int r;
+
+        assert(dfd >= 0);
+
+        r = read_full_file_full(dfd, "cgroup.events", UINT64_MAX, SIZE_MAX, 0, NULL, &content, NULL);
+        if (r < 0)
+                return r;
+
+        return cg_parse_event(content, event, ret);
+}
+
 bool cg_ns_supported(void) {
         static thread_local int enabled = -1;
 
@@ -181,6 +236,22 @@ int cg_enumerate_subgroups(const char *controller, const char *path, DIR **_d) {
         return 0;
 }
 
+int cg_enumerate_subgroups_at(int dfd, DIR **_d) {
+        DIR *d;
+
+        assert(dfd >= 0);
+        assert(_d);
+
+        /* Like cg_enumerate_subgroups(), but works on a cgroup directory fd. The fd is not consumed. */
+
+        d = xopendirat(dfd, ".", O_NOFOLLOW);
+        if (!d)
+                return -errno;
+
+        *_d = d;
+        return 0;
+}
+
 int cg_read_subgroup(DIR *d, char **fn) {
         struct dirent *de;
 
@@ -232,9 +303,8 @@ int cg_rmdir(const char *controller, const char *path) {
         return 0;
 }
 
-static int cg_kill_items(
-                const char *controller,
-                const char *path,
+static int cg_kill_items_at(
+                int dfd,
                 int sig,
                 CGroupFlags flags,
                 Set *s,
@@ -271,7 +341,7 @@ static int cg_kill_items(
                 pid_t pid = 0;
                 done = true;
 
-                r = cg_enumerate_items(controller, path, &f, item);
+                r = cg_enumerate_items_at(dfd, item, &f);
                 if (r < 0) {
                         if (ret >= 0 && r != -ENOENT)
                                 return r;
@@ -334,6 +404,30 @@ static int cg_kill_items(
         return ret;
 }
 
+int cg_kill_at(
+                int dfd,
+                int sig,
+                CGroupFlags flags,
+                Set *s,
+                cg_kill_log_func_t log_kill,
+                void *userdata) {
+        int r, q;
+
+        r = cg_kill_items_at(dfd, sig, flags, s, log_kill, userdata, "cgroup.procs");
+        if (r < 0 || sig != SIGKILL)
+                return r;
+
+        /* Only in case of killing with SIGKILL and when using cgroupsv2, kill remaining threads manually as
+           a workaround for kernel bug. It was fixed in 5.2-rc5 (c03cd7738a83), backported to 4.19.66
+           (4340d175b898) and 4.14.138 (feb6b123b7dd). On the legacy hierarchy there's no "cgroup.threads",
+           hence this is a NOP there. */
+        q = cg_kill_items_at(dfd, sig, flags, s, log_kill, userdata, "cgroup.threads");
+        if (q != 0)
+                return q;
+
+        return r;
+}
+
 int cg_kill(
                 const char *controller,
                 const char *path,
@@ -342,23 +436,60 @@ int cg_kill(
                 Set *s,
                 cg_kill_log_func_t log_kill,
                 void *userdata) {
+
+        _cleanup_close_ int dfd = -1;
+
+        dfd = cg_open_dir(controller, path);
+        if (dfd == -ENOENT)
+                return 0;
+        if (dfd < 0)
+                return dfd;
+
+        return cg_kill_at(dfd, sig, flags, s, log_kill, userdata);
+}
+
+static int cg_kill_kernel_sigkill_at(
+                int dfd,
+                int sig,
+                CGroupFlags flags,
+                Set *s,
+                cg_kill_log_func_t log_kill) {
+
+        _cleanup_free_ char *populated = NULL;
+        _cleanup_close_ int fd = -1;
         int r;
 
-        r = cg_kill_items(controller, path, sig, flags, s, log_kill, userdata, "cgroup.procs");
-        if (r < 0 || sig != SIGKILL)
+        /* Newer kernels (5.14+) can kill a whole subtree atomically by writing to "cgroup.kill", which also
+         * closes the race against forking processes for us. This can only be used if the caller doesn't
+         * need to know the individual processes killed or exclude some, and the cgroup is not going to be
+         * removed (which needs the walk below anyway). Returns -EOPNOTSUPP if not applicable. */
+
+        if (sig != SIGKILL ||
+            log_kill ||
+            !set_isempty(s) ||
+            (flags & (CGROUP_IGNORE_SELF|CGROUP_REMOVE)))
+                return -EOPNOTSUPP;
+
+        fd = openat(dfd, "cgroup.kill", O_WRONLY|O_CLOEXEC|O_NOFOLLOW);
+        if (fd < 0)
+                return errno == ENOENT ? -EOPNOTSUPP : -errno;
+
+        /* Make sure we can tell the caller whether anything got killed */
+        r = cg_read_event_at(dfd, "populated", &populated);
+        if (r < 0)
                 return r;
+        if (streq(populated, "0"))
+                return 0;
 
-        /* Only in case of killing with SIGKILL and when using cgroupsv2, kill remaining threads manually as
-           a workaround for kernel bug. It was fixed in 5.2-rc5 (c03cd7738a83), backported to 4.19.66
-           (4340d175b898) and 4.14.138 (feb6b123b7dd). */
-        r = cg_unified_controller(controller);
-        if (r <= 0)
+        r = loop_write(fd, "1", 1, false);
+        if (r < 0)
                 return r;
 
-        return cg_kill_items(controller, path, sig, flags, s, log_kill, userdata, "cgroup.threads");
+        return 1;
 }
 
-int cg_kill_recursive(
+static int cg_kill_recursive_internal(
+                int dfd,
                 const char *controller,
                 const char *path,
                 int sig,
@@ -367,23 +498,15 @@ int cg_kill_recursive(
                 cg_kill_log_func_t log_kill,
                 void *userdata) {
 
-        _cleanup_set_free_ Set *allocated_set = NULL;
         _cleanup_closedir_ DIR *d = NULL;
         int r, ret;
-        char *fn;
-
-        assert(path);
-        assert(sig >= 0);
 
-        if (!s) {
-                s = allocated_set = set_new(NULL);
-                if (!s)
-                        return -ENOMEM;
-        }
+        /* The cgroup path is only needed (and set) if CGROUP_REMOVE is specified, so that cg_rmdir() can
+         * take care of the compat hierarchy. Everything else is done relative to the directory fds. */
 
-        ret = cg_kill(controller, path, sig, flags, s, log_kill, userdata);
+        ret = cg_kill_at(dfd, sig, flags, s, log_kill, userdata);
 
-        r = cg_enumerate_subgroups(controller, path, &d);
+        r = cg_enumerate_subgroups_at(dfd, &d);
         if (r < 0) {
                 if (ret >= 0 && r != -ENOENT)
                         return r;
@@ -391,22 +514,35 @@ int cg_kill_recursive(
                 return ret;
         }
 
-        while ((r = cg_read_subgroup(d, &fn)) > 0) {
-                _cleanup_free_ char *p = NULL;
+        for (;;) {
+                _cleanup_free_ char *fn = NULL, *p = NULL;
+                _cleanup_close_ int child_fd = -1;
 
-                p = path_join(empty_to_root(path), fn);
-                free(fn);
-                if (!p)
-                        return -ENOMEM;
+                r = cg_read_subgroup(d, &fn);
+                if (r <= 0)
+                        break;
+
+                child_fd = openat(dirfd(d), fn, O_RDONLY|O_DIRECTORY|O_CLOEXEC|O_NOFOLLOW);
+                if (child_fd < 0) {
+                        if (errno != ENOENT && ret >= 0)
+                                ret = -errno;
+                        continue;
+                }
 
-                r = cg_kill_recursive(controller, p, sig, flags, s, log_kill, userdata);
+                if (path) {
+                        p = path_join(empty_to_root(path), fn);
+                        if (!p)
+                                return -ENOMEM;
+                }
+
+                r = cg_kill_recursive_internal(child_fd, controller, p, sig, flags, s, log_kill, userdata);
                 if (r != 0 && ret >= 0)
                         ret = r;
         }
         if (ret >= 0 && r < 0)
                 ret = r;
 
-        if (flags & CGROUP_REMOVE) {
+        if (path) {
                 r = cg_rmdir(controller, path);
                 if (r < 0 && ret >= 0 && !IN_SET(r, -ENOENT, -EBUSY))
                         return r;
@@ -415,6 +551,73 @@ int cg_kill_recursive(
         return ret;
 }
 
+int cg_kill_recursive_at(
+                int dfd,
+                int sig,
+                CGroupFlags flags,
+                Set *s,
+                cg_kill_log_func_t log_kill,
+                void *userdata) {
+
+        _cleanup_set_free_ Set *allocated_set = NULL;
+        int r;
+
+        assert(dfd >= 0);
+        assert(sig >= 0);
+
+        /* Removing cgroups requires their paths, use cg_kill_recursive() for that */
+        if (flags & CGROUP_REMOVE)
+                return -EOPNOTSUPP;
+
+        r = cg_kill_kernel_sigkill_at(dfd, sig, flags, s, log_kill);
+        if (r != -EOPNOTSUPP)
+                return r;
+
+        if (!s) {
+                s = allocated_set = set_new(NULL);
+                if (!s)
+                        return -ENOMEM;
+        }
+
+        return cg_kill_recursive_internal(dfd, NULL, NULL, sig, flags, s, log_kill, userdata);
+}
+
+int cg_kill_recursive(
+                const char *controller,
+                const char *path,
+                int sig,
+                CGroupFlags flags,
+                Set *s,
+                cg_kill_log_func_t log_kill,
+                void *userdata) {
+
+        _cleanup_set_free_ Set *allocated_set = NULL;
+        _cleanup_close_ int dfd = -1;
+        int r;
+
+        assert(path);
+        assert(sig >= 0);
+
+        dfd = cg_open_dir(controller, path);
+        if (dfd == -ENOENT)
+                return 0;
+        if (dfd < 0)
+                return dfd;
+
+        r = cg_kill_kernel_sigkill_at(dfd, sig, flags, s, log_kill);
+        if (r != -EOPNOTSUPP)
+                return r;
+
+        if (!s) {
+                s = allocated_set = set_new(NULL);
+                if (!s)
+                        return -ENOMEM;
+        }
+
+        return cg_kill_recursive_internal(dfd, controller, FLAGS_SET(flags, CGROUP_REMOVE) ? path : NULL,
+                                          sig, flags, s, log_kill, userdata);
+}
+
 static const char *controller_to_dirname(const char *controller) {
         const char *e;
 
@@ -847,6 +1050,51 @@ int cg_is_empty(const char *controller, const char *path) {
         return r == 0;
 }
 
+static int cg_is_empty_recursive_legacy_at(int dfd) {
+        _cleanup_closedir_ DIR *d = NULL;
+        _cleanup_fclose_ FILE *f = NULL;
+        pid_t pid;
+        int r;
+
+        r = cg_enumerate_processes_at(dfd, &f);
+        if (r == -ENOENT)
+                return true;
+        if (r < 0)
+                return r;
+
+        r = cg_read_pid(f, &pid);
+        if (r != 0)
+                return r < 0 ? r : false;
+
+        r = cg_enumerate_subgroups_at(dfd, &d);
+        if (r == -ENOENT)
+                return true;
+        if (r < 0)
+                return r;
+
+        for (;;) {
+                _cleanup_free_ char *fn = NULL;
+                _cleanup_close_ int child_fd = -1;
+
+                r = cg_read_subgroup(d, &fn);
+                if (r < 0)
+                        return r;
+                if (r == 0)
+                        return true;
+
+                child_fd = openat(dirfd(d), fn, O_RDONLY|O_DIRECTORY|O_CLOEXEC|O_NOFOLLOW);
+                if (child_fd < 0) {
+                        if (errno == ENOENT)
+                                continue;
+                        return -errno;
+                }
+
+                r = cg_is_empty_recursive_legacy_at(child_fd);
+                if (r <= 0)
+                        return r;
+        }
+}
+
 int cg_is_empty_recursive(const char *controller, const char *path) {
         int r;
 
@@ -873,35 +1121,15 @@ int cg_is_empty_recursive(const char *controller, const char *path) {
 
                 return streq(t, "0");
         } else {
-                _cleanup_closedir_ DIR *d = NULL;
-                char *fn;
-
-                r = cg_is_empty(controller, path);
-                if (r <= 0)
-                        return r;
+                _cleanup_close_ int dfd = -1;
 
-                r = cg_enumerate_subgroups(controller, path, &d);
-                if (r == -ENOENT)
+                dfd = cg_open_dir(controller, path);
+                if (dfd == -ENOENT)
                         return true;
-                if (r < 0)
-                        return r;
-
-                while ((r = cg_read_subgroup(d, &fn)) > 0) {
-                        _cleanup_free_ char *p = NULL;
-
-                        p = path_join(path, fn);
-                        free(fn);
-                        if (!p)
-                                return -ENOMEM;
+                if (dfd < 0)
+                        return dfd;
 
-                        r = cg_is_empty_recursive(controller, p);
-                        if (r <= 0)
-                                return r;
-                }
-                if (r < 0)
-                        return r;
-
-                return true;
+                return cg_is_empty_recursive_legacy_at(dfd);
         }
 }
 
@@ -1653,6 +1881,36 @@ int cg_set_attribute(const char *controller, const char *path, const char *attri
         return write_string_file(p, value, WRITE_STRING_FILE_DISABLE_BUFFER);
 }
 
+int cg_set_attribute_at(int dir_fd, const char *attribute, const char *value) {
+        _cleanup_close_ int fd = -1;
+        const char *line;
+        size_t l;
+        ssize_t n;
+
+        assert(dir_fd >= 0);
+        assert(attribute);
+        assert(value);
+
+        /* Like cg_set_attribute(), but relative to an fd of the cgroup directory, which saves the path
+         * lookup when many attributes of the same cgroup are written. The attribute has to be written with a
+         * single write(), like write_string_file() with WRITE_STRING_FILE_DISABLE_BUFFER does. */
+
+        fd = openat(dir_fd, attribute, O_WRONLY|O_CLOEXEC|O_NOCTTY);
+        if (fd < 0)
+                return -errno;
+
+        line = endswith(value, "\n") ? value : strjoina(value, "\n");
+        l = strlen(line);
+
+        n = write(fd, line, l);
+        if (n < 0)
+                return -errno;
+        if ((size_t) n != l)
+                return -EIO;
+
+        return 0;
+}
+
 int cg_get_attribute(const char *controller, const char *path, const char *attribute, char **ret) {
         _cleanup_free_ char *p = NULL;
         int r;
@@ -1664,6 +1922,21 @@ int cg_get_attribute(const char *controller, const char *path, const char *attri
         return read_one_line_file(p, ret);
 }
 
+int cg_get_attribute_at(int dfd, const char *attribute, char **ret) {
+        _cleanup_fclose_ FILE *f = NULL;
+        int r;
+
+        assert(dfd >= 0);
+        assert(attribute);
+        assert(ret);
+
+        r = xfopenat(dfd, attribute, "re", O_NOFOLLOW, &f);
+        if (r < 0)
+                return r;
+
+        return read_line(f, LONG_LINE_MAX, ret);
+}
+
 int cg_get_attribute_as_uint64(const char *controller, const char *path, const char *attribute, uint64_t *ret) {
         _cleanup_free_ char *value = NULL;
         uint64_t v;
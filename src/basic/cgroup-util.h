@@ -151,12 +151,17 @@ typedef enum CGroupUnified {
  * generate paths with multiple adjacent / removed.
  */
 
+int cg_open_dir(const char *controller, const char *path);
+
 int cg_enumerate_processes(const char *controller, const char *path, FILE **_f);
+int cg_enumerate_processes_at(int dfd, FILE **_f);
 int cg_read_pid(FILE *f, pid_t *_pid);
 int cg_read_event(const char *controller, const char *path, const char *event,
                   char **val);
+int cg_read_event_at(int dfd, const char *event, char **val);
 
 int cg_enumerate_subgroups(const char *controller, const char *path, DIR **_d);
+int cg_enumerate_subgroups_at(int dfd, DIR **_d);
 int cg_read_subgroup(DIR *d, char **fn);
 
 typedef enum CGroupFlags {
@@ -168,7 +173,9 @@ typedef enum CGroupFlags {
 typedef int (*cg_kill_log_func_t)(pid_t pid, int sig, void *userdata);
 
 int cg_kill(const char *controller, const char *path, int sig, CGroupFlags flags, Set *s, cg_kill_log_func_t kill_log, void *userdata);
+int cg_kill_at(int dfd, int sig, CGroupFlags flags, Set *s, cg_kill_log_func_t kill_log, void *userdata);
 int cg_kill_recursive(const char *controller, const char *path, int sig, CGroupFlags flags, Set *s, cg_kill_log_func_t kill_log, void *userdata);
+int cg_kill_recursive_at(int dfd, int sig, CGroupFlags flags, Set *s, cg_kill_log_func_t kill_log, void *userdata);
 
 int cg_split_spec(const char *spec, char **ret_controller, char **ret_path);
 int cg_mangle_path(const char *path, char **result);
@@ -185,7 +192,9 @@ typedef enum  {
 } CGroupKeyMode;
 
 int cg_set_attribute(const char *controller, const char *path, const char *attribute, const char *value);
+int cg_set_attribute_at(int dir_fd, const char *attribute, const char *value);
 int cg_get_attribute(const char *controller, const char *path, const char *attribute, char **ret);
+int cg_get_attribute_at(int dfd, const char *attribute, char **ret);
 int cg_get_keyed_attribute_full(const char *controller, const char *path, const char *attribute, char **keys, char **values, CGroupKeyMode mode);
 
 static inline int cg_get_keyed_attribute(
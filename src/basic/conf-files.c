@@ -19,6 +19,98 @@
 #include "string-util.h"
 #include "strv.h"
 #include "terminal-util.h"
+#include "time-util.h"
+
+/* Directory listings are cached per thread, keyed by the directory's identity and modification time. The
+ * same few directories are searched for many different kinds of config files and drop-ins, and this way
+ * only the first search needs to read them. Only the names are cached, since everything else may change
+ * without the directory's mtime changing. Directories that were modified very recently are not cached,
+ * since another modification within the timestamp granularity of the file system would go unnoticed. */
+#define DIR_LISTING_CACHE_MIN_AGE_USEC (2 * USEC_PER_SEC)
+
+typedef struct DirListing {
+        dev_t dev;
+        ino_t ino;
+        nsec_t mtime;
+        char **names;
+} DirListing;
+
+static DirListing* dir_listing_free(DirListing *l) {
+        if (!l)
+                return NULL;
+
+        strv_free(l->names);
+        return mfree(l);
+}
+
+DEFINE_PRIVATE_HASH_OPS_FULL(dir_listing_hash_ops, char, string_hash_func, string_compare_func, free,
+                             DirListing, dir_listing_free);
+
+static thread_local Hashmap *dir_listing_cache = NULL;
+
+static int dir_listing_get(DIR *dir, const char *dirpath, char ***ret) {
+        _cleanup_strv_free_ char **names = NULL;
+        _cleanup_free_ char *key = NULL;
+        DirListing *l;
+        struct dirent *de;
+        struct stat st;
+        int r;
+
+        assert(dir);
+        assert(dirpath);
+        assert(ret);
+
+        /* Returns the names of the entries in the directory, in no particular order. Returns 0 if the
+         * strv is owned by the cache, in which case it must not be modified or freed, and 1 if it is
+         * owned by the caller. */
+
+        if (fstat(dirfd(dir), &st) < 0)
+                return -errno;
+
+        l = hashmap_get(dir_listing_cache, dirpath);
+        if (l && l->dev == st.st_dev && l->ino == st.st_ino && l->mtime == timespec_load_nsec(&st.st_mtim)) {
+                *ret = l->names;
+                return 0;
+        }
+
+        FOREACH_DIRENT(de, dir, return -errno) {
+                r = strv_extend(&names, de->d_name);
+                if (r < 0)
+                        return r;
+        }
+
+        if (timespec_load(&st.st_mtim) + DIR_LISTING_CACHE_MIN_AGE_USEC > now(CLOCK_REALTIME)) {
+                /* Too new to be trusted, drop any old entry and don't cache it */
+                dir_listing_free(hashmap_remove(dir_listing_cache, dirpath));
+                *ret = TAKE_PTR(names);
+                return 1;
+        }
+
+        if (!l) {
+                key = strdup(dirpath);
+                if (!key)
+                        return -ENOMEM;
+
+                l = new0(DirListing, 1);
+                if (!l)
+                        return -ENOMEM;
+
+                r = hashmap_ensure_put(&dir_listing_cache, &dir_listing_hash_ops, key, l);
+                if (r < 0) {
+                        free(l);
+                        return r;
+                }
+                TAKE_PTR(key);
+        }
+
+        l->dev = st.st_dev;
+        l->ino = st.st_ino;
+        l->mtime = timespec_load_nsec(&st.st_mtim);
+        strv_free_and_replace(l->names, names);
+
+        *ret = l->names;
+        return 0;
+}
 
 static int files_add(
                 Hashmap *h,
@@ -29,8 +121,9 @@ static int files_add(
                 const char *path) {
 
         _cleanup_closedir_ DIR *dir = NULL;
+        _cleanup_strv_free_ char **uncached = NULL;
         const char *dirpath;
-        struct dirent *de;
+        char **names, **n;
         int r;
 
         assert(h);
@@ -47,30 +140,37 @@ static int files_add(
                 return log_debug_errno(errno, "Failed to open directory '%s': %m", dirpath);
         }
 
-        FOREACH_DIRENT(de, dir, return -errno) {
+        r = dir_listing_get(dir, dirpath, &names);
+        if (r < 0)
+                return log_debug_errno(r, "Failed to read directory '%s': %m", dirpath);
+        if (r > 0)
+                uncached = names;
+
+        STRV_FOREACH(n, names) {
+                const char *name = *n;
                 struct stat st;
                 char *p, *key;
 
                 /* Does this match the suffix? */
-                if (suffix && !endswith(de->d_name, suffix))
+                if (suffix && !endswith(name, suffix))
                         continue;
 
                 /* Has this file already been found in an earlier directory? */
-                if (hashmap_contains(h, de->d_name)) {
-                        log_debug("Skipping overridden file '%s/%s'.", dirpath, de->d_name);
+                if (hashmap_contains(h, name)) {
+                        log_debug("Skipping overridden file '%s/%s'.", dirpath, name);
                         continue;
                 }
 
                 /* Has this been masked in an earlier directory? */
-                if ((flags & CONF_FILES_FILTER_MASKED) && set_contains(masked, de->d_name)) {
-                        log_debug("File '%s/%s' is masked by previous entry.", dirpath, de->d_name);
+                if ((flags & CONF_FILES_FILTER_MASKED) && set_contains(masked, name)) {
+                        log_debug("File '%s/%s' is masked by previous entry.", dirpath, name);
                         continue;
                 }
 
                 /* Read file metadata if we shall validate the check for file masks, for node types or whether the node is marked executable. */
                 if (flags & (CONF_FILES_FILTER_MASKED|CONF_FILES_REGULAR|CONF_FILES_DIRECTORY|CONF_FILES_EXECUTABLE))
-                        if (fstatat(dirfd(dir), de->d_name, &st, 0) < 0) {
-                                log_debug_errno(errno, "Failed to stat '%s/%s', ignoring: %m", dirpath, de->d_name);
+                        if (fstatat(dirfd(dir), name, &st, 0) < 0) {
+                                log_debug_errno(errno, "Failed to stat '%s/%s', ignoring: %m", dirpath, name);
                                 continue;
                         }
 
@@ -80,11 +180,11 @@ static int files_add(
                                 assert(masked);
 
                                 /* Mark this one as masked */
-                                r = set_put_strdup(&masked, de->d_name);
+                                r = set_put_strdup(&masked, name);
                                 if (r < 0)
                                         return r;
 
-                                log_debug("File '%s/%s' is a mask.", dirpath, de->d_name);
+                                log_debug("File '%s/%s' is a mask.", dirpath, name);
                                 continue;
                         }
 
@@ -92,7 +192,7 @@ static int files_add(
                 if (flags & (CONF_FILES_REGULAR|CONF_FILES_DIRECTORY))
                         if (!((flags & CONF_FILES_DIRECTORY) && S_ISDIR(st.st_mode)) &&
                             !((flags & CONF_FILES_REGULAR) && S_ISREG(st.st_mode))) {
-                                log_debug("Ignoring '%s/%s', as it is not a of the right type.", dirpath, de->d_name);
+                                log_debug("Ignoring '%s/%s', as it is not a of the right type.", dirpath, name);
                                 continue;
                         }
 
@@ -103,18 +203,18 @@ static int files_add(
                          * executable for us, because if so, such errors are stuff we should log about. */
 
                         if ((st.st_mode & 0111) == 0) { /* not executable */
-                                log_debug("Ignoring '%s/%s', as it is not marked executable.", dirpath, de->d_name);
+                                log_debug("Ignoring '%s/%s', as it is not marked executable.", dirpath, name);
                                 continue;
                         }
 
                 if (flags & CONF_FILES_BASENAME) {
-                        p = strdup(de->d_name);
+                        p = strdup(name);
                         if (!p)
                                 return -ENOMEM;
 
                         key = p;
                 } else {
-                        p = path_join(dirpath, de->d_name);
+                        p = path_join(dirpath, name);
                         if (!p)
                                 return -ENOMEM;
 
@@ -609,17 +609,19 @@ static int fd_copy_regular(
                 const char *to,
                 uid_t override_uid,
                 gid_t override_gid,
-                CopyFlags copy_flags,
+                CopyFlags *copy_flags,
                 HardlinkContext *hardlink_context,
                 copy_progress_bytes_t progress,
                 void *userdata) {
 
         _cleanup_close_ int fdf = -1, fdt = -1;
+        bool copied = false;
         int r, q;
 
         assert(from);
         assert(st);
         assert(to);
+        assert(copy_flags);
 
         r = try_hardlink(hardlink_context, st, dt, to);
         if (r < 0)
@@ -631,21 +633,34 @@ static int fd_copy_regular(
         if (fdf < 0)
                 return -errno;
 
-        if (copy_flags & COPY_MAC_CREATE) {
+        if (*copy_flags & COPY_MAC_CREATE) {
                 r = mac_selinux_create_file_prepare_at(dt, to, S_IFREG);
                 if (r < 0)
                         return r;
         }
         fdt = openat(dt, to, O_WRONLY|O_CREAT|O_EXCL|O_CLOEXEC|O_NOCTTY|O_NOFOLLOW, st->st_mode & 07777);
-        if (copy_flags & COPY_MAC_CREATE)
+        if (*copy_flags & COPY_MAC_CREATE)
                 mac_selinux_create_file_clear();
         if (fdt < 0)
                 return -errno;
 
-        r = copy_bytes_full(fdf, fdt, UINT64_MAX, copy_flags, NULL, NULL, progress, userdata);
-        if (r < 0) {
-                (void) unlinkat(dt, to, 0);
-                return r;
+        if (*copy_flags & COPY_REFLINK) {
+                /* Both files are freshly opened, hence a full file reflink suffices. If the file system
+                 * doesn't support reflinks at all, don't bother trying again for the remaining files the
+                 * caller copies into the same place. */
+                r = btrfs_reflink(fdf, fdt);
+                if (r >= 0)
+                        copied = true;
+                else if (IN_SET(r, -ENOTTY, -EOPNOTSUPP, -EXDEV, -EINVAL))
+                        *copy_flags &= ~COPY_REFLINK;
+        }
+
+        if (!copied) {
+                r = copy_bytes_full(fdf, fdt, UINT64_MAX, *copy_flags & ~COPY_REFLINK, NULL, NULL, progress, userdata);
+                if (r < 0) {
+                        (void) unlinkat(dt, to, 0);
+                        return r;
+                }
         }
 
         if (fchown(fdt,
@@ -918,7 +933,7 @@ static int fd_copy_directory(
 
                         q = fd_copy_directory(dirfd(d), de->d_name, &buf, fdt, de->d_name, original_device, depth_left-1, override_uid, override_gid, copy_flags, hardlink_context, child_display_path, progress_path, progress_bytes, userdata);
                 } else if (S_ISREG(buf.st_mode))
-                        q = fd_copy_regular(dirfd(d), de->d_name, &buf, fdt, de->d_name, override_uid, override_gid, copy_flags, hardlink_context, progress_bytes, userdata);
+                        q = fd_copy_regular(dirfd(d), de->d_name, &buf, fdt, de->d_name, override_uid, override_gid, &copy_flags, hardlink_context, progress_bytes, userdata);
                 else if (S_ISLNK(buf.st_mode))
                         q = fd_copy_symlink(dirfd(d), de->d_name, &buf, fdt, de->d_name, override_uid, override_gid, copy_flags);
                 else if (S_ISFIFO(buf.st_mode))
@@ -973,7 +988,7 @@ int copy_tree_at_full(
                 return -errno;
 
         if (S_ISREG(st.st_mode))
-                return fd_copy_regular(fdf, from, &st, fdt, to, override_uid, override_gid, copy_flags, NULL, progress_bytes, userdata);
+                return fd_copy_regular(fdf, from, &st, fdt, to, override_uid, override_gid, &copy_flags, NULL, progress_bytes, userdata);
         else if (S_ISDIR(st.st_mode))
                 return fd_copy_directory(fdf, from, &st, fdt, to, st.st_dev, COPY_DEPTH_MAX, override_uid, override_gid, copy_flags, NULL, NULL, progress_path, progress_bytes, userdata);
         else if (S_ISLNK(st.st_mode))
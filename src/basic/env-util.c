@@ -10,10 +10,12 @@
 #include "env-util.h"
 #include "escape.h"
 #include "extract-word.h"
+#include "hashmap.h"
 #include "macro.h"
 #include "parse-util.h"
 #include "path-util.h"
 #include "process-util.h"
+#include "set.h"
 #include "stdio-util.h"
 #include "string-util.h"
 #include "strv.h"
@@ -141,7 +143,32 @@ bool strv_env_name_or_assignment_is_valid(char **l) {
         return true;
 }
 
-static int env_append(char **r, char ***k, char **a) {
+/* Environment blocks below this size are deduplicated with a linear search, as that is cheaper than setting up a
+ * hash table. Above it, assignments are indexed by their variable name, so that merging and cleaning large blocks
+ * (e.g. from big EnvironmentFile= sets) is not quadratic. */
+#define ENV_HASH_THRESHOLD 32U
+
+static void env_name_hash_func(const char *p, struct siphash *state) {
+        siphash24_compress(p, strcspn(p, "="), state);
+}
+
+static int env_name_compare_func(const char *a, const char *b) {
+        size_t na, nb;
+        int r;
+
+        na = strcspn(a, "=");
+        nb = strcspn(b, "=");
+
+        r = memcmp(a, b, MIN(na, nb));
+        if (r != 0)
+                return r;
+
+        return CMP(na, nb);
+}
+
+DEFINE_PRIVATE_HASH_OPS(env_name_hash_ops, char, env_name_hash_func, env_name_compare_func);
+
+static int env_append(char **r, char ***k, char **a, Hashmap *index) {
         assert(r);
         assert(k);
         assert(*k >= r);
@@ -154,19 +181,32 @@ static int env_append(char **r, char ***k, char **a) {
          *
          * This call adds every entry of 'a' to 'r', either overriding an existing matching entry, or appending to it.
          *
+         * If 'index' is non-NULL it must map the variable names of all assignments in 'r' to their position in 'r'
+         * (offset by one), and is kept up-to-date.
+         *
          * This call assumes 'r' has enough pre-allocated space to grow by all of 'a''s items. */
 
         for (; *a; a++) {
                 char **j, *c;
+                bool assignment;
                 size_t n;
+                int q;
 
                 n = strcspn(*a, "=");
-                if ((*a)[n] == '=')
+                assignment = (*a)[n] == '=';
+                if (assignment)
                         n++;
 
-                for (j = r; j < *k; j++)
-                        if (strneq(*j, *a, n))
-                                break;
+                if (index && assignment) {
+                        size_t i;
+
+                        i = PTR_TO_SIZE(hashmap_get(index, *a));
+                        j = i > 0 ? r + i - 1 : *k;
+                } else
+                        /* Entries without "=" match by prefix, which we cannot look up by name. */
+                        for (j = r; j < *k; j++)
+                                if (strneq(*j, *a, n))
+                                        break;
 
                 c = strdup(*a);
                 if (!c)
@@ -176,14 +216,26 @@ static int env_append(char **r, char ***k, char **a) {
                         (*k)[0] = c;
                         (*k)[1] = NULL;
                         (*k)++;
-                } else
+                } else {
+                        if (index)
+                                (void) hashmap_remove_value(index, *j, SIZE_TO_PTR(j - r + 1));
+
                         free_and_replace(*j, c); /* Override existing item */
+                }
+
+                if (index && assignment) {
+                        /* The key pointer may have changed, hence always replace */
+                        q = hashmap_replace(index, *j, SIZE_TO_PTR(j - r + 1));
+                        if (q < 0)
+                                return q;
+                }
         }
 
         return 0;
 }
 
 char **strv_env_merge(size_t n_lists, ...) {
+        _cleanup_hashmap_free_ Hashmap *index = NULL;
         _cleanup_strv_free_ char **ret = NULL;
         size_t n = 0;
         char **l, **k;
@@ -205,10 +257,16 @@ char **strv_env_merge(size_t n_lists, ...) {
         *ret = NULL;
         k = ret;
 
+        if (n >= ENV_HASH_THRESHOLD) {
+                index = hashmap_new(&env_name_hash_ops);
+                if (!index)
+                        return NULL;
+        }
+
         va_start(ap, n_lists);
         for (size_t i = 0; i < n_lists; i++) {
                 l = va_arg(ap, char**);
-                if (env_append(ret, &k, l) < 0) {
+                if (env_append(ret, &k, l, index) < 0) {
                         va_end(ap);
                         return NULL;
                 }
@@ -468,10 +526,47 @@ char *strv_env_pairs_get(char **l, const char *name) {
         return result;
 }
 
+static bool *env_find_duplicates(char **e, size_t n) {
+        _cleanup_set_free_ Set *seen = NULL;
+        _cleanup_free_ bool *duplicate = NULL;
+
+        /* Returns an array flagging all assignments in 'e' that are overridden by a later one, or NULL on OOM. */
+
+        duplicate = new0(bool, n);
+        if (!duplicate)
+                return NULL;
+
+        seen = set_new(&env_name_hash_ops);
+        if (!seen)
+                return NULL;
+
+        for (size_t i = n; i > 0; i--) {
+                int r;
+
+                if (!strchr(e[i-1], '='))
+                        continue;
+
+                r = set_put(seen, e[i-1]);
+                if (r < 0)
+                        return NULL;
+
+                duplicate[i-1] = r == 0;
+        }
+
+        return TAKE_PTR(duplicate);
+}
+
 char **strv_env_clean_with_callback(char **e, void (*invalid_callback)(const char *p, void *userdata), void *userdata) {
+        _cleanup_free_ bool *duplicates = NULL;
         char **p, **q;
+        size_t n_entries;
         int k = 0;
 
+        n_entries = strv_length(e);
+        if (n_entries >= ENV_HASH_THRESHOLD)
+                /* On OOM we simply fall back to the linear search below */
+                duplicates = env_find_duplicates(e, n_entries);
+
         STRV_FOREACH(p, e) {
                 size_t n;
                 bool duplicate = false;
@@ -484,11 +579,14 @@ char **strv_env_clean_with_callback(char **e, void (*invalid_callback)(const cha
                 }
 
                 n = strcspn(*p, "=");
-                STRV_FOREACH(q, p + 1)
-                        if (strneq(*p, *q, n) && (*q)[n] == '=') {
-                                duplicate = true;
-                                break;
-                        }
+                if (duplicates)
+                        duplicate = duplicates[p - e];
+                else
+                        STRV_FOREACH(q, p + 1)
+                                if (strneq(*p, *q, n) && (*q)[n] == '=') {
+                                        duplicate = true;
+                                        break;
+                                }
 
                 if (duplicate) {
                         free(*p);
@@ -1154,6 +1154,28 @@ static EndOfLineMarker categorize_eol(char c, ReadLineFlags flags) {
 
 DEFINE_TRIVIAL_CLEANUP_FUNC_FULL(FILE*, funlockfile, NULL);
 
+static int safe_fgetc_unlocked(FILE *f, char *ret) {
+        int k;
+
+        assert(f);
+        assert(ret);
+
+        /* Like safe_fgetc(), but for callers which already hold the stream lock, uses getc_unlocked() */
+
+        errno = 0;
+        k = getc_unlocked(f);
+        if (k == EOF) {
+                if (ferror_unlocked(f))
+                        return errno_or_else(EIO);
+
+                *ret = 0;
+                return 0;
+        }
+
+        *ret = k;
+        return 1;
+}
+
 int read_line_full(FILE *f, size_t limit, ReadLineFlags flags, char **ret) {
         size_t n = 0, allocated = 0, count = 0;
         _cleanup_free_ char *buffer = NULL;
@@ -1205,7 +1227,8 @@ int read_line_full(FILE *f, size_t limit, ReadLineFlags flags, char **ret) {
                         if (count >= INT_MAX) /* We couldn't return the counter anymore as "int", hence refuse this */
                                 return -ENOBUFS;
 
-                        r = safe_fgetc(f, &c);
+                        /* We hold the lock on the stream, hence avoid taking it again for each byte */
+                        r = safe_fgetc_unlocked(f, &c);
                         if (r < 0)
                                 return r;
                         if (r == 0) /* EOF is definitely EOL */
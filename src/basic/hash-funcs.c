@@ -84,6 +84,29 @@ const struct hash_ops trivial_hash_ops_free_free = {
         .free_value = free,
 };
 
+static uint64_t fast_hash_mix(uint64_t x, uint64_t key) {
+        /* The finalizer of MurmurHash3, applied to the value xor'ed with the hashmap's key. It's a
+         * bijection that spreads every input bit over the whole result, but it's not a PRF. */
+        x ^= key;
+        x ^= x >> 33;
+        x *= UINT64_C(0xff51afd7ed558ccd);
+        x ^= x >> 33;
+        x *= UINT64_C(0xc4ceb9fe1a85ec53);
+        x ^= x >> 33;
+
+        return x;
+}
+
+uint64_t trivial_fast_hash_func(const void *p, uint64_t key) {
+        return fast_hash_mix((uint64_t) (uintptr_t) p, key);
+}
+
+const struct hash_ops trivial_hash_ops_fast = {
+        .hash = trivial_hash_func,
+        .compare = trivial_compare_func,
+        .fast_hash = trivial_fast_hash_func,
+};
+
 void uint64_hash_func(const uint64_t *p, struct siphash *state) {
         siphash24_compress(p, sizeof(uint64_t), state);
 }
@@ -94,6 +117,16 @@ int uint64_compare_func(const uint64_t *a, const uint64_t *b) {
 
 DEFINE_HASH_OPS(uint64_hash_ops, uint64_t, uint64_hash_func, uint64_compare_func);
 
+uint64_t uint64_fast_hash_func(const uint64_t *p, uint64_t key) {
+        return fast_hash_mix(*p, key);
+}
+
+const struct hash_ops uint64_hash_ops_fast = {
+        .hash = (hash_func_t) uint64_hash_func,
+        .compare = (compare_func_t) uint64_compare_func,
+        .fast_hash = (fast_hash_func_t) uint64_fast_hash_func,
+};
+
 #if SIZEOF_DEV_T != 8
 void devt_hash_func(const dev_t *p, struct siphash *state) {
         siphash24_compress(p, sizeof(dev_t), state);
@@ -6,6 +6,7 @@
 #include "siphash24.h"
 
 typedef void (*hash_func_t)(const void *p, struct siphash *state);
+typedef uint64_t (*fast_hash_func_t)(const void *p, uint64_t key);
 typedef int (*compare_func_t)(const void *a, const void *b);
 
 struct hash_ops {
@@ -13,6 +14,11 @@ struct hash_ops {
         compare_func_t compare;
         free_func_t free_key;
         free_func_t free_value;
+
+        /* If set, used by hashmaps instead of siphash and the hash function above. This is much cheaper for
+         * small keys, but doesn't protect against hash collision attacks. Hence, only use this for keys that
+         * cannot be chosen by the peers we are talking to, e.g. pointers and IDs we allocate ourselves. */
+        fast_hash_func_t fast_hash;
 };
 
 #define _DEFINE_HASH_OPS(uq, name, type, hash_func, compare_func, free_key_func, free_value_func, scope) \
@@ -90,12 +96,16 @@ int trivial_compare_func(const void *a, const void *b) _const_;
 extern const struct hash_ops trivial_hash_ops;
 extern const struct hash_ops trivial_hash_ops_free;
 extern const struct hash_ops trivial_hash_ops_free_free;
+uint64_t trivial_fast_hash_func(const void *p, uint64_t key) _const_;
+extern const struct hash_ops trivial_hash_ops_fast;
 
 /* 32bit values we can always just embed in the pointer itself, but in order to support 32bit archs we need store 64bit
  * values indirectly, since they don't fit in a pointer. */
 void uint64_hash_func(const uint64_t *p, struct siphash *state);
 int uint64_compare_func(const uint64_t *a, const uint64_t *b) _pure_;
 extern const struct hash_ops uint64_hash_ops;
+uint64_t uint64_fast_hash_func(const uint64_t *p, uint64_t key) _pure_;
+extern const struct hash_ops uint64_hash_ops_fast;
 
 /* On some archs dev_t is 32bit, and on others 64bit. And sometimes it's 64bit on 32bit archs, and sometimes 32bit on
  * 64bit archs. Yuck! */
@@ -18,6 +18,7 @@
 #include "siphash24.h"
 #include "string-util.h"
 #include "strv.h"
+#include "unaligned.h"
 
 #if ENABLE_DEBUG_HASHMAP
 #include "list.h"
@@ -333,16 +334,25 @@ static uint8_t* hash_key(HashmapBase *h) {
 }
 
 static unsigned base_bucket_hash(HashmapBase *h, const void *p) {
-        struct siphash state;
         uint64_t hash;
 
-        siphash24_init(&state, hash_key(h));
+        if (h->hash_ops->fast_hash)
+                hash = h->hash_ops->fast_hash(p, unaligned_read_ne64(hash_key(h)));
+        else {
+                struct siphash state;
 
-        h->hash_ops->hash(p, &state);
+                siphash24_init(&state, hash_key(h));
 
-        hash = siphash24_finalize(&state);
+                h->hash_ops->hash(p, &state);
 
-        return (unsigned) (hash % n_buckets(h));
+                hash = siphash24_finalize(&state);
+        }
+
+        /* Map the upper 32 bits of the hash onto [0, n_buckets) with a multiplication and a shift
+         * rather than a division, which is noticeably slower and needed for every single lookup. See
+         * Lemire, D. 2019. Fast Random Integer Generation in an Interval. ACM Trans. Model. Comput.
+         * Simul. 29, 1, Article 3. https://arxiv.org/abs/1805.10941 */
+        return (unsigned) (((hash >> 32) * (uint64_t) n_buckets(h)) >> 32);
 }
 #define bucket_hash(h, p) base_bucket_hash(HASHMAP_BASE(h), p)
 
@@ -4,6 +4,7 @@
 #include <fcntl.h>
 #include <inttypes.h>
 #include <limits.h>
+#include <pthread.h>
 #include <stdarg.h>
 #include <stddef.h>
 #include <sys/signalfd.h>
@@ -16,6 +17,7 @@
 #include "sd-messages.h"
 
 #include "alloc-util.h"
+#include "async.h"
 #include "errno-util.h"
 #include "fd-util.h"
 #include "format-util.h"
@@ -39,6 +41,11 @@
 
 #define SNDBUF_SIZE (8*1024*1024)
 
+/* Maximum number of messages queued for the journal in asynchronous mode, and how many of them to pass to
+ * the kernel at once */
+#define LOG_ASYNC_QUEUE_MAX 4096U
+#define LOG_ASYNC_BATCH_MAX 64U
+
 static LogTarget log_target = LOG_TARGET_CONSOLE;
 static int log_max_level = LOG_INFO;
 static int log_facility = LOG_DAEMON;
@@ -59,6 +66,7 @@ static bool upgrade_syslog_to_journal = false;
 static bool always_reopen_console = false;
 static bool open_when_needed = false;
 static bool prohibit_ipc = false;
+static bool async = false;
 
 /* Akin to glibc's __abort_msg; which is private and we hence cannot
  * use here. */
@@ -221,6 +229,235 @@ fail:
         return r;
 }
 
+/* In asynchronous mode, journal messages are queued in memory and sent off in batches by a background
+ * thread with its own socket, so that logging doesn't have to wait for journald. Messages are sent in the
+ * order they were logged in. If the queue is full, messages are dropped, and how many were dropped is
+ * reported once there's room again. Forked off children log synchronously. */
+static struct {
+        pid_t pid; /* the process the thread has been started in */
+        bool failed;
+        bool registered;
+
+        pthread_mutex_t mutex;
+        pthread_cond_t queued, drained;
+
+        struct iovec *queue; /* ring buffer */
+        size_t queue_head, n_queue;
+        size_t n_sending;
+        uint64_t n_dropped;
+} log_async = {
+        .mutex = PTHREAD_MUTEX_INITIALIZER,
+        .queued = PTHREAD_COND_INITIALIZER,
+        .drained = PTHREAD_COND_INITIALIZER,
+};
+
+static int log_async_connect(void) {
+        static const union sockaddr_union sa = {
+                .un.sun_family = AF_UNIX,
+                .un.sun_path = "/run/systemd/journal/socket",
+        };
+        int fd;
+
+        fd = create_log_socket(SOCK_DGRAM);
+        if (fd < 0)
+                return fd;
+
+        if (connect(fd, &sa.sa, SOCKADDR_UN_LEN(sa.un)) < 0) {
+                safe_close(fd);
+                return -errno;
+        }
+
+        return fd;
+}
+
+static void* log_async_thread(void *p) {
+        struct iovec batch[LOG_ASYNC_BATCH_MAX];
+        struct mmsghdr msgs[LOG_ASYNC_BATCH_MAX];
+        char dropped[LINE_MAX];
+        int fd = -1;
+
+        /* Note that we must not log anything from this thread, we'd only end up queuing to ourselves */
+
+        (void) pthread_setname_np(pthread_self(), "log");
+
+        for (;;) {
+                uint64_t n_dropped;
+                size_t n = 0;
+
+                assert_se(pthread_mutex_lock(&log_async.mutex) == 0);
+
+                while (log_async.n_queue == 0 && log_async.n_dropped == 0)
+                        assert_se(pthread_cond_wait(&log_async.queued, &log_async.mutex) == 0);
+
+                while (n < ELEMENTSOF(batch) && log_async.n_queue > 0) {
+                        batch[n++] = log_async.queue[log_async.queue_head];
+                        log_async.queue_head = (log_async.queue_head + 1) % LOG_ASYNC_QUEUE_MAX;
+                        log_async.n_queue--;
+                }
+
+                log_async.n_sending = n;
+                n_dropped = log_async.n_dropped;
+                log_async.n_dropped = 0;
+
+                assert_se(pthread_mutex_unlock(&log_async.mutex) == 0);
+
+                if (fd < 0)
+                        fd = log_async_connect();
+                if (fd >= 0) {
+                        if (n_dropped > 0) {
+                                (void) snprintf(dropped, sizeof(dropped),
+                                                "PRIORITY=%i\n"
+                                                "SYSLOG_FACILITY=%i\n"
+                                                "SYSLOG_IDENTIFIER=%.256s\n"
+                                                "MESSAGE=Log queue overrun, dropped %" PRIu64 " messages.\n",
+                                                LOG_WARNING, LOG_FAC(log_facility),
+                                                program_invocation_short_name,
+                                                n_dropped);
+                                (void) send(fd, dropped, strlen(dropped), MSG_NOSIGNAL);
+                        }
+
+                        for (size_t i = 0; i < n;) {
+                                int k;
+
+                                for (size_t j = i; j < n; j++)
+                                        msgs[j - i] = (struct mmsghdr) {
+                                                .msg_hdr.msg_iov = batch + j,
+                                                .msg_hdr.msg_iovlen = 1,
+                                        };
+
+                                k = sendmmsg(fd, msgs, n - i, MSG_NOSIGNAL);
+                                if (k < 0) {
+                                        if (errno == EINTR)
+                                                continue;
+
+                                        /* Reconnect the next time, and drop what we couldn't send */
+                                        fd = safe_close(fd);
+                                        break;
+                                }
+
+                                i += k;
+                        }
+                }
+
+                for (size_t i = 0; i < n; i++)
+                        free(batch[i].iov_base);
+
+                assert_se(pthread_mutex_lock(&log_async.mutex) == 0);
+                log_async.n_sending = 0;
+                assert_se(pthread_cond_broadcast(&log_async.drained) == 0);
+                assert_se(pthread_mutex_unlock(&log_async.mutex) == 0);
+        }
+
+        return NULL;
+}
+
+static void log_async_flush(void) {
+
+        /* Waits until everything queued so far has been handed to the kernel */
+
+        if (log_async.pid == 0 || log_async.pid != getpid_cached())
+                return;
+
+        assert_se(pthread_mutex_lock(&log_async.mutex) == 0);
+
+        while (log_async.n_queue > 0 || log_async.n_sending > 0 || log_async.n_dropped > 0)
+                assert_se(pthread_cond_wait(&log_async.drained, &log_async.mutex) == 0);
+
+        assert_se(pthread_mutex_unlock(&log_async.mutex) == 0);
+}
+
+static bool log_async_active(void) {
+        int r;
+
+        if (!async || open_when_needed || log_async.failed)
+                return false;
+
+        if (log_async.pid == getpid_cached())
+                return true;
+
+        if (log_async.pid != 0) {
+                /* We are a forked off child, the thread is not around here. Let's log synchronously from
+                 * now on, and leave whatever was still queued to the parent. */
+                log_async.failed = true;
+                return false;
+        }
+
+        log_async.queue = new(struct iovec, LOG_ASYNC_QUEUE_MAX);
+        if (!log_async.queue) {
+                log_async.failed = true;
+                return false;
+        }
+
+        r = asynchronous_job(log_async_thread, NULL);
+        if (r < 0) {
+                log_async.queue = mfree(log_async.queue);
+                log_async.failed = true;
+                return false;
+        }
+
+        log_async.pid = getpid_cached();
+
+        /* Make sure the queue is flushed on exit(). This is inherited by children, but a NOP there. */
+        if (!log_async.registered) {
+                (void) atexit(log_async_flush);
+                log_async.registered = true;
+        }
+
+        return true;
+}
+
+static int log_async_enqueue(const struct iovec *iovec, size_t n) {
+        size_t size;
+        char *buf;
+
+        size = IOVEC_TOTAL_SIZE(iovec, n);
+        buf = malloc(size);
+        if (!buf)
+                return -ENOMEM;
+
+        for (size_t i = 0, offset = 0; i < n; offset += iovec[i].iov_len, i++)
+                memcpy_safe(buf + offset, iovec[i].iov_base, iovec[i].iov_len);
+
+        assert_se(pthread_mutex_lock(&log_async.mutex) == 0);
+
+        if (log_async.n_queue >= LOG_ASYNC_QUEUE_MAX) {
+                log_async.n_dropped++;
+                free(buf);
+        } else {
+                log_async.queue[(log_async.queue_head + log_async.n_queue) % LOG_ASYNC_QUEUE_MAX] = IOVEC_MAKE(buf, size);
+                log_async.n_queue++;
+        }
+
+        assert_se(pthread_cond_signal(&log_async.queued) == 0);
+        assert_se(pthread_mutex_unlock(&log_async.mutex) == 0);
+
+        return 1;
+}
+
+static int journal_send(const struct iovec *iovec, size_t n) {
+        struct msghdr mh = {
+                .msg_iov = (struct iovec*) iovec,
+                .msg_iovlen = n,
+        };
+        int r;
+
+        if (journal_fd < 0)
+                return 0;
+
+        if (log_async_active()) {
+                r = log_async_enqueue(iovec, n);
+                if (r != -ENOMEM)
+                        return r;
+
+                /* If we are out of memory, try to get the message out synchronously. */
+        }
+
+        if (sendmsg(journal_fd, &mh, MSG_NOSIGNAL) < 0)
+                return -errno;
+
+        return 1;
+}
+
 static bool stderr_is_journal(void) {
         _cleanup_free_ char *w = NULL;
         const char *e;
@@ -342,6 +579,8 @@ void log_set_target(LogTarget target) {
 void log_close(void) {
         /* Do not call from library code. */
 
+        log_async_flush();
+
         log_close_journal();
         log_close_syslog();
         log_close_kmsg();
@@ -607,7 +846,6 @@ static int write_to_journal(
 
         char header[LINE_MAX];
         struct iovec iovec[4] = {};
-        struct msghdr mh = {};
 
         if (journal_fd < 0)
                 return 0;
@@ -619,13 +857,7 @@ static int write_to_journal(
         iovec[2] = IOVEC_MAKE_STRING(buffer);
         iovec[3] = IOVEC_MAKE_STRING("\n");
 
-        mh.msg_iov = iovec;
-        mh.msg_iovlen = ELEMENTSOF(iovec);
-
-        if (sendmsg(journal_fd, &mh, MSG_NOSIGNAL) < 0)
-                return -errno;
-
-        return 1;
+        return journal_send(iovec, ELEMENTSOF(iovec));
 }
 
 int log_dispatch_internal(
@@ -848,6 +1080,9 @@ static void log_assert(
         log_abort_msg = buffer;
 
         log_dispatch_internal(level, 0, file, line, func, NULL, NULL, NULL, NULL, buffer);
+
+        /* We are going to abort, make sure the message (and everything before it) makes it out */
+        log_async_flush();
 }
 
 _noreturn_ void log_assert_failed(
@@ -961,9 +1196,6 @@ int log_struct_internal(
                         struct iovec iovec[17] = {};
                         size_t n = 0, i;
                         int r;
-                        struct msghdr mh = {
-                                .msg_iov = iovec,
-                        };
                         bool fallback = false;
 
                         /* If the journal is available do structured logging.
@@ -975,10 +1207,8 @@ int log_struct_internal(
                         r = log_format_iovec(iovec, ELEMENTSOF(iovec), &n, true, error, format, ap);
                         if (r < 0)
                                 fallback = true;
-                        else {
-                                mh.msg_iovlen = n;
-                                (void) sendmsg(journal_fd, &mh, MSG_NOSIGNAL);
-                        }
+                        else
+                                (void) journal_send(iovec, n);
 
                         va_end(ap);
                         for (i = 1; i < n; i += 2)
@@ -1053,10 +1283,6 @@ int log_struct_iovec_internal(
 
                 struct iovec iovec[1 + n_input_iovec*2];
                 char header[LINE_MAX];
-                struct msghdr mh = {
-                        .msg_iov = iovec,
-                        .msg_iovlen = 1 + n_input_iovec*2,
-                };
 
                 log_do_header(header, sizeof(header), level, error, file, line, func, NULL, NULL, NULL, NULL);
                 iovec[0] = IOVEC_MAKE_STRING(header);
@@ -1066,7 +1292,7 @@ int log_struct_iovec_internal(
                         iovec[1+i*2+1] = IOVEC_MAKE_STRING("\n");
                 }
 
-                if (sendmsg(journal_fd, &mh, MSG_NOSIGNAL) >= 0)
+                if (journal_send(iovec, ELEMENTSOF(iovec)) > 0)
                         return -ERRNO_VALUE(error);
         }
 
@@ -1218,6 +1444,17 @@ void log_parse_environment(void) {
         e = getenv("SYSTEMD_LOG_TID");
         if (e && log_show_tid_from_string(e) < 0)
                 log_warning("Failed to parse log tid '%s'. Ignoring.", e);
+
+        e = getenv("SYSTEMD_LOG_ASYNC");
+        if (e) {
+                int r;
+
+                r = parse_boolean(e);
+                if (r < 0)
+                        log_warning("Failed to parse log async '%s'. Ignoring.", e);
+                else
+                        log_set_async(r);
+        }
 }
 
 LogTarget log_get_target(void) {
@@ -1455,6 +1692,17 @@ void log_set_open_when_needed(bool b) {
         open_when_needed = b;
 }
 
+void log_set_async(bool b) {
+        /* PID 1 must never end up waiting for anything but itself, hence always logs synchronously */
+        if (b && getpid_cached() == 1)
+                return;
+
+        if (!b)
+                log_async_flush();
+
+        async = b;
+}
+
 void log_set_prohibit_ipc(bool b) {
         prohibit_ipc = b;
 }
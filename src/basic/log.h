@@ -259,6 +259,10 @@ void log_set_open_when_needed(bool b);
  * stderr, the console or kmsg */
 void log_set_prohibit_ipc(bool b);
 
+/* If turned on, messages to the journal are queued and sent off by a background thread, so that logging never
+ * has to wait for journald. The queue is flushed by log_close() and before aborting. */
+void log_set_async(bool b);
+
 int log_dup_console(void);
 
 int log_syntax_internal(
@@ -18,7 +18,10 @@ SYSCALLS = [
     'renameat2',
     'setns',
     'statx',
-    'epoll_pwait2']
+    'epoll_pwait2',
+    'mount_setattr',
+    'move_mount',
+    'open_tree']
 
 def dictify(f):
     def wrap(*args, **kwargs):
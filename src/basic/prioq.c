@@ -7,7 +7,12 @@
  * priority. Insertion and removal are Θ(log n). Optionally, the caller can
  * provide a pointer to an index which will be kept up-to-date by the prioq.
  *
- * The underlying algorithm used in this implementation is a Heap.
+ * The underlying algorithm used in this implementation is a 4-ary Heap: it is
+ * flatter than a binary heap, and the children of an item are adjacent in
+ * memory, which makes removal cheaper. Optionally, the caller can provide a
+ * function returning a 64bit key of an object. The key is stored next to the
+ * object pointer, and is what items are primarily ordered by, so that most
+ * comparisons don't need to dereference the objects.
  */
 
 #include <errno.h>
@@ -17,26 +22,33 @@
 #include "hashmap.h"
 #include "prioq.h"
 
+#define PRIOQ_ARITY 4U
+
 struct prioq_item {
         void *data;
         unsigned *idx;
+        uint64_t key;
 };
 
 struct Prioq {
+        prioq_key_func_t key_func;
         compare_func_t compare_func;
         unsigned n_items, n_allocated;
 
         struct prioq_item *items;
 };
 
-Prioq *prioq_new(compare_func_t compare_func) {
+Prioq *prioq_new_keyed(prioq_key_func_t key_func, compare_func_t compare_func) {
         Prioq *q;
 
+        assert(key_func || compare_func);
+
         q = new(Prioq, 1);
         if (!q)
                 return q;
 
         *q = (Prioq) {
+                .key_func = key_func,
                 .compare_func = compare_func,
         };
 
@@ -51,96 +63,105 @@ Prioq* prioq_free(Prioq *q) {
         return mfree(q);
 }
 
-int prioq_ensure_allocated(Prioq **q, compare_func_t compare_func) {
+int prioq_ensure_allocated_keyed(Prioq **q, prioq_key_func_t key_func, compare_func_t compare_func) {
         assert(q);
 
         if (*q)
                 return 0;
 
-        *q = prioq_new(compare_func);
+        *q = prioq_new_keyed(key_func, compare_func);
         if (!*q)
                 return -ENOMEM;
 
         return 0;
 }
 
-static void swap(Prioq *q, unsigned j, unsigned k) {
-        assert(q);
-        assert(j < q->n_items);
-        assert(k < q->n_items);
+static int compare_items(Prioq *q, const struct prioq_item *x, const struct prioq_item *y) {
+        int r;
 
-        assert(!q->items[j].idx || *(q->items[j].idx) == j);
-        assert(!q->items[k].idx || *(q->items[k].idx) == k);
+        if (q->key_func) {
+                r = CMP(x->key, y->key);
+                if (r != 0 || !q->compare_func)
+                        return r;
+        }
 
-        SWAP_TWO(q->items[j].data, q->items[k].data);
-        SWAP_TWO(q->items[j].idx, q->items[k].idx);
+        return q->compare_func(x->data, y->data);
+}
 
-        if (q->items[j].idx)
-                *q->items[j].idx = j;
+static void set_item(Prioq *q, unsigned idx, const struct prioq_item *i) {
+        q->items[idx] = *i;
 
-        if (q->items[k].idx)
-                *q->items[k].idx = k;
+        if (i->idx)
+                *i->idx = idx;
 }
 
 static unsigned shuffle_up(Prioq *q, unsigned idx) {
+        struct prioq_item i;
+
         assert(q);
         assert(idx < q->n_items);
 
+        /* Instead of swapping the item with its parents, move the parents down into the hole until we find
+         * the place for the item, and only write it there. */
+
+        i = q->items[idx];
+
         while (idx > 0) {
                 unsigned k;
 
-                k = (idx-1)/2;
+                k = (idx-1)/PRIOQ_ARITY;
 
-                if (q->compare_func(q->items[k].data, q->items[idx].data) <= 0)
+                if (compare_items(q, q->items + k, &i) <= 0)
                         break;
 
-                swap(q, idx, k);
+                set_item(q, idx, q->items + k);
                 idx = k;
         }
 
+        set_item(q, idx, &i);
         return idx;
 }
 
 static unsigned shuffle_down(Prioq *q, unsigned idx) {
+        struct prioq_item i;
+
         assert(q);
+        assert(idx < q->n_items);
 
-        for (;;) {
-                unsigned j, k, s;
+        i = q->items[idx];
 
-                k = (idx+1)*2; /* right child */
-                j = k-1;       /* left child */
+        for (;;) {
+                size_t first, last, s;
 
-                if (j >= q->n_items)
+                first = (size_t) idx * PRIOQ_ARITY + 1;
+                if (first >= q->n_items)
                         break;
 
-                if (q->compare_func(q->items[j].data, q->items[idx].data) < 0)
+                last = MIN(first + PRIOQ_ARITY, (size_t) q->n_items);
 
-                        /* So our left child is smaller than we are, let's
-                         * remember this fact */
-                        s = j;
-                else
-                        s = idx;
+                /* Find the smallest of our children… */
+                s = first;
+                for (size_t j = first + 1; j < last; j++)
+                        if (compare_items(q, q->items + j, q->items + s) < 0)
+                                s = j;
 
-                if (k < q->n_items &&
-                    q->compare_func(q->items[k].data, q->items[s].data) < 0)
-
-                        /* So our right child is smaller than we are, let's
-                         * remember this fact */
-                        s = k;
-
-                /* s now points to the smallest of the three items */
-
-                if (s == idx)
-                        /* No swap necessary, we're done */
+                /* …and stop if it isn't smaller than we are */
+                if (compare_items(q, q->items + s, &i) >= 0)
                         break;
 
-                swap(q, idx, s);
+                set_item(q, idx, q->items + s);
                 idx = s;
         }
 
+        set_item(q, idx, &i);
         return idx;
 }
 
+static void update_key(Prioq *q, struct prioq_item *i) {
+        if (q->key_func)
+                i->key = q->key_func(i->data);
+}
+
 int prioq_put(Prioq *q, void *data, unsigned *idx) {
         struct prioq_item *i;
         unsigned k;
@@ -164,6 +185,7 @@ int prioq_put(Prioq *q, void *data, unsigned *idx) {
         i = q->items + k;
         i->data = data;
         i->idx = idx;
+        update_key(q, i);
 
         if (idx)
                 *idx = k;
@@ -192,10 +214,7 @@ static void remove_item(Prioq *q, struct prioq_item *i) {
 
                 k = i - q->items;
 
-                i->data = l->data;
-                i->idx = l->idx;
-                if (i->idx)
-                        *i->idx = k;
+                set_item(q, k, l);
                 q->n_items--;
 
                 k = shuffle_down(q, k);
@@ -253,12 +272,30 @@ int prioq_reshuffle(Prioq *q, void *data, unsigned *idx) {
         if (!i)
                 return 0;
 
+        update_key(q, i);
+
         k = i - q->items;
         k = shuffle_down(q, k);
         shuffle_up(q, k);
         return 1;
 }
 
+void prioq_reshuffle_all(Prioq *q) {
+        if (!q)
+                return;
+
+        for (unsigned k = 0; k < q->n_items; k++)
+                update_key(q, q->items + k);
+
+        if (q->n_items <= 1)
+                return;
+
+        /* Rebuild the heap bottom-up, starting with the parent of the last item. This is O(n), rather than
+         * the O(n log n) of reshuffling every item individually. */
+        for (unsigned k = (q->n_items - 2) / PRIOQ_ARITY + 1; k > 0; k--)
+                shuffle_down(q, k - 1);
+}
+
 void *prioq_peek_by_index(Prioq *q, unsigned idx) {
         if (!q)
                 return NULL;
@@ -1,6 +1,7 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 #pragma once
 
+#include <inttypes.h>
 #include <stdbool.h>
 
 #include "hashmap.h"
@@ -10,14 +11,26 @@ typedef struct Prioq Prioq;
 
 #define PRIOQ_IDX_NULL (UINT_MAX)
 
-Prioq *prioq_new(compare_func_t compare);
+/* Returns the key items are ordered by. It is read when an item is added or reshuffled, and must not change in
+ * between. If a compare function is specified too, it is used to order items with the same key. */
+typedef uint64_t (*prioq_key_func_t)(const void *data);
+
+Prioq *prioq_new_keyed(prioq_key_func_t key_func, compare_func_t compare_func);
+static inline Prioq *prioq_new(compare_func_t compare_func) {
+        return prioq_new_keyed(NULL, compare_func);
+}
 Prioq *prioq_free(Prioq *q);
 DEFINE_TRIVIAL_CLEANUP_FUNC(Prioq*, prioq_free);
-int prioq_ensure_allocated(Prioq **q, compare_func_t compare_func);
+int prioq_ensure_allocated_keyed(Prioq **q, prioq_key_func_t key_func, compare_func_t compare_func);
+static inline int prioq_ensure_allocated(Prioq **q, compare_func_t compare_func) {
+        return prioq_ensure_allocated_keyed(q, NULL, compare_func);
+}
 
 int prioq_put(Prioq *q, void *data, unsigned *idx);
 int prioq_remove(Prioq *q, void *data, unsigned *idx);
 int prioq_reshuffle(Prioq *q, void *data, unsigned *idx);
+/* Call this after the keys or the order of many items changed at once, e.g. after a clock jump. */
+void prioq_reshuffle_all(Prioq *q);
 
 void *prioq_peek_by_index(Prioq *q, unsigned idx) _pure_;
 static inline void *prioq_peek(Prioq *q) {
@@ -179,6 +179,17 @@ int rm_rf_children(int fd, RemoveFlags flags, struct stat *root_dev) {
                         if (root_dev && st.st_dev != root_dev->st_dev)
                                 continue;
 
+                        /* Large trees tend to have many empty leaf directories. Try to remove the
+                         * directory right away, which saves us opening, reading and closing it. This is
+                         * safe even though we didn't check for mount points yet: rmdir() refuses those
+                         * with EBUSY. We can't take the shortcut if subvolumes shall be removed or a
+                         * device boundary is to be respected though, since btrfs allows removing empty
+                         * subvolumes like this. If this fails for any reason, take the slow path below,
+                         * which deals with everything properly. */
+                        if (!root_dev && !(flags & REMOVE_SUBVOLUME) &&
+                            unlinkat(fd, de->d_name, AT_REMOVEDIR) >= 0)
+                                continue;
+
                         subdir_fd = openat(fd, de->d_name, O_RDONLY|O_NONBLOCK|O_DIRECTORY|O_CLOEXEC|O_NOFOLLOW|O_NOATIME);
                         if (subdir_fd < 0) {
                                 if (ret == 0 && errno != ENOENT)
@@ -0,0 +1,128 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include "alloc-util.h"
+#include "string-intern.h"
+#include "strv.h"
+
+typedef struct InternedString {
+        unsigned n_ref;
+        char str[];
+} InternedString;
+
+struct StringInternTable {
+        /* Maps the string to its InternedString, the key points into the value */
+        Hashmap *strings;
+};
+
+static InternedString* interned_string_from_str(const char *s) {
+        return (InternedString*) (s - offsetof(InternedString, str));
+}
+
+StringInternTable* string_intern_table_free(StringInternTable *t) {
+        if (!t)
+                return NULL;
+
+        /* Strings still referenced at this point are leaked by their users, but free them anyway */
+        hashmap_free_free(t->strings);
+        return mfree(t);
+}
+
+size_t string_intern_table_size(StringInternTable *t) {
+        return t ? hashmap_size(t->strings) : 0;
+}
+
+const char* string_intern(StringInternTable **t, const char *s) {
+        InternedString *i;
+        size_t l;
+        int r;
+
+        assert(t);
+        assert(s);
+
+        if (*t) {
+                i = hashmap_get((*t)->strings, s);
+                if (i) {
+                        assert(i->n_ref > 0);
+                        assert(i->n_ref < UINT_MAX);
+
+                        i->n_ref++;
+                        return i->str;
+                }
+        } else {
+                *t = new0(StringInternTable, 1);
+                if (!*t)
+                        return NULL;
+        }
+
+        l = strlen(s);
+        i = malloc(offsetof(InternedString, str) + l + 1);
+        if (!i)
+                return NULL;
+
+        i->n_ref = 1;
+        memcpy(i->str, s, l + 1);
+
+        r = hashmap_ensure_put(&(*t)->strings, &string_hash_ops, i->str, i);
+        if (r < 0) {
+                free(i);
+                return NULL;
+        }
+
+        return i->str;
+}
+
+const char* string_unintern(StringInternTable *t, const char *s) {
+        InternedString *i;
+
+        if (!s)
+                return NULL;
+
+        assert(t);
+
+        i = interned_string_from_str(s);
+        assert(i->n_ref > 0);
+
+        if (--i->n_ref > 0)
+                return NULL;
+
+        assert_se(hashmap_remove(t->strings, s) == i);
+        free(i);
+
+        return NULL;
+}
+
+char** strv_intern(StringInternTable **t, char * const *l) {
+        _cleanup_free_ char **n = NULL;
+        size_t k = 0;
+
+        assert(t);
+
+        n = new(char*, strv_length((char**) l) + 1);
+        if (!n)
+                return NULL;
+
+        for (char * const *i = l; i && *i; i++) {
+                const char *s;
+
+                s = string_intern(t, *i);
+                if (!s) {
+                        n[k] = NULL;
+                        strv_unintern(*t, TAKE_PTR(n));
+                        return NULL;
+                }
+
+                n[k++] = (char*) s;
+        }
+
+        n[k] = NULL;
+        return TAKE_PTR(n);
+}
+
+char** strv_unintern(StringInternTable *t, char **l) {
+        char **i;
+
+        STRV_FOREACH(i, l)
+                string_unintern(t, *i);
+
+        return mfree(l);
+}
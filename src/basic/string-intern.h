@@ -0,0 +1,33 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+#pragma once
+
+#include "hashmap.h"
+
+/* A table of reference counted, immutable strings. Interning the same string twice returns the same pointer,
+ * hence interned strings taken from the same table may be compared with ==, and each distinct string is kept in
+ * memory only once, however many objects refer to it. */
+
+typedef struct StringInternTable StringInternTable;
+
+StringInternTable* string_intern_table_free(StringInternTable *t);
+DEFINE_TRIVIAL_CLEANUP_FUNC(StringInternTable*, string_intern_table_free);
+
+size_t string_intern_table_size(StringInternTable *t);
+
+/* Returns the interned copy of s, taking a reference to it. Allocates the table if necessary. Returns NULL on
+ * OOM. */
+const char* string_intern(StringInternTable **t, const char *s);
+
+/* Drops a reference to an interned string, s must have been returned by string_intern() on the same table.
+ * Always returns NULL. */
+const char* string_unintern(StringInternTable *t, const char *s);
+
+/* Interns all strings of l, and returns a newly allocated array of them. */
+char** strv_intern(StringInternTable **t, char * const *l);
+
+/* Unreferences all strings of l, which must have been interned in t, and frees the array itself. */
+char** strv_unintern(StringInternTable *t, char **l);
+
+static inline bool string_interned_equal(const char *a, const char *b) {
+        return a == b;
+}
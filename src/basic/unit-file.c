@@ -235,6 +235,135 @@ bool lookup_paths_timestamp_hash_same(const LookupPaths *lp, uint64_t timestamp_
         return updated == timestamp_hash;
 }
 
+int lookup_paths_dirs_timestamp_hash(const LookupPaths *lp, uint64_t *ret) {
+        uint64_t hash;
+        char **dir;
+
+        assert(lp);
+        assert(ret);
+
+        /* Like lookup_paths_timestamp_hash_same(), but also covers the .wants/, .requires/ and .d/
+         * subdirectories, i.e. changes that only affect units which are loaded already, such as enablement
+         * symlinks. This needs to list all unit directories, hence is much more expensive. Subdirectories
+         * are hashed independently of each other and summed up, so that the order of the entries doesn't
+         * matter. */
+
+        (void) lookup_paths_timestamp_hash_same(lp, 0, &hash);
+
+        STRV_FOREACH(dir, (char**) lp->search_path) {
+                _cleanup_closedir_ DIR *d = NULL;
+                struct dirent *de;
+
+                if (lookup_paths_mtime_exclude(lp, *dir))
+                        continue;
+
+                d = opendir(*dir);
+                if (!d) {
+                        if (errno == ENOENT)
+                                continue;
+
+                        return log_debug_errno(errno, "Failed to open \"%s\": %m", *dir);
+                }
+
+                FOREACH_DIRENT_ALL(de, d, return log_debug_errno(errno, "Failed to read \"%s\": %m", *dir)) {
+                        struct siphash state;
+                        struct stat st;
+
+                        if (!ENDSWITH_SET(de->d_name, ".wants", ".requires", ".d"))
+                                continue;
+
+                        if (fstatat(dirfd(d), de->d_name, &st, 0) < 0) {
+                                if (errno == ENOENT)
+                                        continue;
+
+                                return log_debug_errno(errno, "Failed to stat %s/%s: %m", *dir, de->d_name);
+                        }
+
+                        if (!S_ISDIR(st.st_mode))
+                                continue;
+
+                        siphash24_init(&state, HASH_KEY.bytes);
+                        siphash24_compress_string(*dir, &state);
+                        siphash24_compress_string(de->d_name, &state);
+                        siphash24_compress_usec_t(timespec_load(&st.st_mtim), &state);
+
+                        hash += siphash24_finalize(&state);
+                }
+        }
+
+        *ret = hash;
+        return 0;
+}
+
+int lookup_paths_generated_hash(const LookupPaths *lp, uint64_t *ret) {
+        uint64_t hash = 0;
+        char **dir;
+        int r;
+
+        assert(lp);
+        assert(ret);
+
+        /* The directories excluded from the mtime check above are rewritten by us, e.g. by each run of the
+         * generators, hence their modification times change even if the same files are put there again.
+         * Instead, hash what the name map is built from: the names and types of the entries, the targets of
+         * symlinks, and whether a file is empty. Generators run in parallel, hence the order in which
+         * entries are found is random: the hashes of all entries are simply summed up. */
+
+        STRV_FOREACH(dir, (char**) lp->search_path) {
+                _cleanup_closedir_ DIR *d = NULL;
+                struct dirent *de;
+
+                if (!lookup_paths_mtime_exclude(lp, *dir))
+                        continue;
+
+                d = opendir(*dir);
+                if (!d) {
+                        if (errno == ENOENT)
+                                continue;
+
+                        return log_debug_errno(errno, "Failed to open \"%s\": %m", *dir);
+                }
+
+                FOREACH_DIRENT_ALL(de, d, return log_debug_errno(errno, "Failed to read \"%s\": %m", *dir)) {
+                        struct siphash state;
+
+                        if (!unit_name_is_valid(de->d_name, UNIT_NAME_ANY) &&
+                            !ENDSWITH_SET(de->d_name, ".wants", ".requires", ".d"))
+                                continue;
+
+                        siphash24_init(&state, HASH_KEY.bytes);
+                        siphash24_compress_string(*dir, &state);
+                        siphash24_compress_string(de->d_name, &state);
+
+                        dirent_ensure_type(d, de);
+                        siphash24_compress(&de->d_type, sizeof(de->d_type), &state);
+
+                        if (de->d_type == DT_LNK) {
+                                _cleanup_free_ char *target = NULL;
+
+                                r = readlinkat_malloc(dirfd(d), de->d_name, &target);
+                                if (r < 0)
+                                        return log_debug_errno(r, "Failed to read symlink %s/%s: %m", *dir, de->d_name);
+
+                                siphash24_compress_string(target, &state);
+
+                        } else if (de->d_type == DT_REG) {
+                                struct stat st;
+
+                                if (fstatat(dirfd(d), de->d_name, &st, AT_SYMLINK_NOFOLLOW) < 0)
+                                        return log_debug_errno(errno, "Failed to stat %s/%s: %m", *dir, de->d_name);
+
+                                siphash24_compress_boolean(null_or_empty(&st), &state);
+                        }
+
+                        hash += siphash24_finalize(&state);
+                }
+        }
+
+        *ret = hash;
+        return 0;
+}
+
 int unit_file_build_name_map(
                 const LookupPaths *lp,
                 uint64_t *cache_timestamp_hash,
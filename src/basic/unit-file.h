@@ -44,6 +44,8 @@ int unit_symlink_name_compatible(const char *symlink, const char *target, bool i
 int unit_validate_alias_symlink_and_warn(const char *filename, const char *target);
 
 bool lookup_paths_timestamp_hash_same(const LookupPaths *lp, uint64_t timestamp_hash, uint64_t *ret_new);
+int lookup_paths_dirs_timestamp_hash(const LookupPaths *lp, uint64_t *ret);
+int lookup_paths_generated_hash(const LookupPaths *lp, uint64_t *ret);
 int unit_file_build_name_map(
                 const LookupPaths *lp,
                 uint64_t *cache_timestamp_hash,
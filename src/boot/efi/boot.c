@@ -1850,6 +1850,7 @@ static VOID config_entry_add_linux(
                 CHAR16 *os_version = NULL;
                 CHAR16 *os_version_id = NULL;
                 CHAR16 *os_build_id = NULL;
+                _cleanup_(FileHandleClosep) EFI_FILE_HANDLE handle = NULL;
 
                 err = uefi_call_wrapper(linux_dir->Read, 3, linux_dir, &bufsize, buf);
                 if (bufsize == 0 || EFI_ERROR(err))
@@ -1865,12 +1866,18 @@ static VOID config_entry_add_linux(
                 if (startswith(f->FileName, L"auto-"))
                         continue;
 
+                /* Open the binary once, and read the headers and the sections we need through the same
+                 * handle: opening files means walking the directory again on most firmware, which is slow */
+                err = uefi_call_wrapper(linux_dir->Open, 5, linux_dir, &handle, f->FileName, EFI_FILE_MODE_READ, 0ULL);
+                if (EFI_ERROR(err))
+                        continue;
+
                 /* look for .osrel and .cmdline sections in the .efi binary */
-                err = pe_file_locate_sections(linux_dir, f->FileName, sections, addrs, offs, szs);
+                err = pe_file_locate_sections(handle, sections, addrs, offs, szs);
                 if (EFI_ERROR(err))
                         continue;
 
-                err = file_read(linux_dir, f->FileName, offs[0], szs[0], &content, NULL);
+                err = file_handle_read(handle, offs[0], szs[0], &content, NULL);
                 if (EFI_ERROR(err))
                         continue;
 
@@ -1926,7 +1933,7 @@ static VOID config_entry_add_linux(
                         content = NULL;
 
                         /* read the embedded cmdline file */
-                        err = file_read(linux_dir, f->FileName, offs[1], szs[1], &content, NULL);
+                        err = file_handle_read(handle, offs[1], szs[1], &content, NULL);
                         if (!EFI_ERROR(err)) {
 
                                 /* chomp the newline */
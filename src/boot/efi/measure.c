@@ -299,14 +299,22 @@ static EFI_TCG2 * tcg2_interface_check(void) {
 }
 
 EFI_STATUS tpm_log_event(UINT32 pcrindex, const EFI_PHYSICAL_ADDRESS buffer, UINTN buffer_size, const CHAR16 *description) {
-        EFI_TCG *tpm1;
-        EFI_TCG2 *tpm2;
+        static BOOLEAN checked = FALSE;
+        static EFI_TCG *tpm1 = NULL;
+        static EFI_TCG2 *tpm2 = NULL;
+
+        /* Locating the protocol and querying its capabilities goes to the TPM on some firmware, hence only
+         * do that once, the result won't change while we are running. */
+        if (!checked) {
+                tpm2 = tcg2_interface_check();
+                if (!tpm2)
+                        tpm1 = tcg1_interface_check();
+                checked = TRUE;
+        }
 
-        tpm2 = tcg2_interface_check();
         if (tpm2)
                 return tpm2_measure_to_pcr_and_event_log(tpm2, pcrindex, buffer, buffer_size, description);
 
-        tpm1 = tcg1_interface_check();
         if (tpm1)
                 return tpm1_measure_to_pcr_and_event_log(tpm1, pcrindex, buffer, buffer_size, description);
 
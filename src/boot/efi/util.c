@@ -369,15 +369,10 @@ CHAR8 *strchra(CHAR8 *s, CHAR8 c) {
         return NULL;
 }
 
-EFI_STATUS file_read(EFI_FILE_HANDLE dir, const CHAR16 *name, UINTN off, UINTN size, CHAR8 **ret, UINTN *ret_size) {
-        _cleanup_(FileHandleClosep) EFI_FILE_HANDLE handle = NULL;
+EFI_STATUS file_handle_read(EFI_FILE_HANDLE handle, UINTN off, UINTN size, CHAR8 **ret, UINTN *ret_size) {
         _cleanup_freepool_ CHAR8 *buf = NULL;
         EFI_STATUS err;
 
-        err = uefi_call_wrapper(dir->Open, 5, dir, &handle, (CHAR16*) name, EFI_FILE_MODE_READ, 0ULL);
-        if (EFI_ERROR(err))
-                return err;
-
         if (size == 0) {
                 _cleanup_freepool_ EFI_FILE_INFO *info;
 
@@ -388,11 +383,10 @@ EFI_STATUS file_read(EFI_FILE_HANDLE dir, const CHAR16 *name, UINTN off, UINTN s
                 size = info->FileSize+1;
         }
 
-        if (off > 0) {
-                err = uefi_call_wrapper(handle->SetPosition, 2, handle, off);
-                if (EFI_ERROR(err))
-                        return err;
-        }
+        /* Always seek, the handle might have been used before */
+        err = uefi_call_wrapper(handle->SetPosition, 2, handle, off);
+        if (EFI_ERROR(err))
+                return err;
 
         buf = AllocatePool(size + 1);
         if (!buf)
@@ -411,6 +405,17 @@ EFI_STATUS file_read(EFI_FILE_HANDLE dir, const CHAR16 *name, UINTN off, UINTN s
         return err;
 }
 
+EFI_STATUS file_read(EFI_FILE_HANDLE dir, const CHAR16 *name, UINTN off, UINTN size, CHAR8 **ret, UINTN *ret_size) {
+        _cleanup_(FileHandleClosep) EFI_FILE_HANDLE handle = NULL;
+        EFI_STATUS err;
+
+        err = uefi_call_wrapper(dir->Open, 5, dir, &handle, (CHAR16*) name, EFI_FILE_MODE_READ, 0ULL);
+        if (EFI_ERROR(err))
+                return err;
+
+        return file_handle_read(handle, off, size, ret, ret_size);
+}
+
 EFI_STATUS log_oom(void) {
         Print(L"Out of memory.");
         (void) uefi_call_wrapper(BS->Stall, 1, 3 * 1000 * 1000);
@@ -18,10 +18,12 @@
 #include "bpf-firewall.h"
 #include "bpf-program.h"
 #include "fd-util.h"
+#include "in-addr-util.h"
 #include "ip-address-access.h"
 #include "memory-util.h"
 #include "missing_syscall.h"
 #include "unit.h"
+#include "string-util.h"
 #include "strv.h"
 #include "virt.h"
 
@@ -35,6 +37,33 @@ enum {
         ACCESS_DENIED  = 2,
 };
 
+/* A pair of LPM trie maps with the addresses of one verdict. These only depend on the configured address lists,
+ * hence they are shared between all units whose lists (including those of their slices) are identical, keyed by
+ * a string representation of them. */
+struct BPFFirewallAccessMaps {
+        unsigned n_ref;
+        Manager *manager;
+        char *key;
+        int ipv4_map_fd;
+        int ipv6_map_fd;
+};
+
+static BPFFirewallAccessMaps *bpf_firewall_access_maps_free(BPFFirewallAccessMaps *a) {
+        if (!a)
+                return NULL;
+
+        if (a->manager)
+                hashmap_remove_value(a->manager->bpf_firewall_access_maps, a->key, a);
+
+        safe_close(a->ipv4_map_fd);
+        safe_close(a->ipv6_map_fd);
+        free(a->key);
+        return mfree(a);
+}
+
+DEFINE_TRIVIAL_REF_UNREF_FUNC(BPFFirewallAccessMaps, bpf_firewall_access_maps, bpf_firewall_access_maps_free);
+DEFINE_TRIVIAL_CLEANUP_FUNC(BPFFirewallAccessMaps*, bpf_firewall_access_maps_unref);
+
 /* Compile instructions for one list of addresses, one direction and one specific verdict on matches. */
 
 static int add_lookup_instructions(
@@ -204,10 +233,8 @@ static int bpf_firewall_compile_bpf(
                 u->ip_accounting_egress_map_fd;
 
         access_enabled =
-                u->ipv4_allow_map_fd >= 0 ||
-                u->ipv6_allow_map_fd >= 0 ||
-                u->ipv4_deny_map_fd >= 0 ||
-                u->ipv6_deny_map_fd >= 0 ||
+                u->ip_allow_maps ||
+                u->ip_deny_maps ||
                 ip_allow_any ||
                 ip_deny_any;
 
@@ -233,26 +260,26 @@ static int bpf_firewall_compile_bpf(
                  * - Otherwise, access will be granted
                  */
 
-                if (u->ipv4_deny_map_fd >= 0) {
-                        r = add_lookup_instructions(p, u->ipv4_deny_map_fd, ETH_P_IP, is_ingress, ACCESS_DENIED);
+                if (u->ip_deny_maps && u->ip_deny_maps->ipv4_map_fd >= 0) {
+                        r = add_lookup_instructions(p, u->ip_deny_maps->ipv4_map_fd, ETH_P_IP, is_ingress, ACCESS_DENIED);
                         if (r < 0)
                                 return r;
                 }
 
-                if (u->ipv6_deny_map_fd >= 0) {
-                        r = add_lookup_instructions(p, u->ipv6_deny_map_fd, ETH_P_IPV6, is_ingress, ACCESS_DENIED);
+                if (u->ip_deny_maps && u->ip_deny_maps->ipv6_map_fd >= 0) {
+                        r = add_lookup_instructions(p, u->ip_deny_maps->ipv6_map_fd, ETH_P_IPV6, is_ingress, ACCESS_DENIED);
                         if (r < 0)
                                 return r;
                 }
 
-                if (u->ipv4_allow_map_fd >= 0) {
-                        r = add_lookup_instructions(p, u->ipv4_allow_map_fd, ETH_P_IP, is_ingress, ACCESS_ALLOWED);
+                if (u->ip_allow_maps && u->ip_allow_maps->ipv4_map_fd >= 0) {
+                        r = add_lookup_instructions(p, u->ip_allow_maps->ipv4_map_fd, ETH_P_IP, is_ingress, ACCESS_ALLOWED);
                         if (r < 0)
                                 return r;
                 }
 
-                if (u->ipv6_allow_map_fd >= 0) {
-                        r = add_lookup_instructions(p, u->ipv6_allow_map_fd, ETH_P_IPV6, is_ingress, ACCESS_ALLOWED);
+                if (u->ip_allow_maps && u->ip_allow_maps->ipv6_map_fd >= 0) {
+                        r = add_lookup_instructions(p, u->ip_allow_maps->ipv6_map_fd, ETH_P_IPV6, is_ingress, ACCESS_ALLOWED);
                         if (r < 0)
                                 return r;
                 }
@@ -405,21 +432,44 @@ static int bpf_firewall_add_access_items(
         return 0;
 }
 
+static int bpf_firewall_access_items_to_strv(IPAddressAccessItem *list, char ***l) {
+        IPAddressAccessItem *a;
+        int r;
+
+        assert(l);
+
+        LIST_FOREACH(items, a, list) {
+                char *s;
+
+                r = in_addr_prefix_to_string(a->family, &a->address, a->prefixlen, &s);
+                if (r < 0)
+                        return r;
+
+                r = strv_consume(l, s);
+                if (r < 0)
+                        return r;
+        }
+
+        return 0;
+}
+
 static int bpf_firewall_prepare_access_maps(
                 Unit *u,
                 int verdict,
-                int *ret_ipv4_map_fd,
-                int *ret_ipv6_map_fd,
+                BPFFirewallAccessMaps **ret_maps,
                 bool *ret_has_any) {
 
+        _cleanup_(bpf_firewall_access_maps_unrefp) BPFFirewallAccessMaps *maps = NULL;
         _cleanup_close_ int ipv4_map_fd = -1, ipv6_map_fd = -1;
+        _cleanup_strv_free_ char **items = NULL;
+        _cleanup_free_ char *joined = NULL, *key = NULL;
         size_t n_ipv4 = 0, n_ipv6 = 0;
         IPAddressAccessItem *list;
         Unit *p;
         int r;
 
-        assert(ret_ipv4_map_fd);
-        assert(ret_ipv6_map_fd);
+        assert(u);
+        assert(ret_maps);
         assert(ret_has_any);
 
         for (p = u; p; p = UNIT_DEREF(p->slice)) {
@@ -436,9 +486,42 @@ static int bpf_firewall_prepare_access_maps(
                 /* Skip making the LPM trie map in cases where we are using "any" in order to hack around
                  * needing CAP_SYS_ADMIN for allocating LPM trie map. */
                 if (ip_address_access_item_is_any(list)) {
+                        *ret_maps = NULL;
                         *ret_has_any = true;
                         return 0;
                 }
+
+                r = bpf_firewall_access_items_to_strv(list, &items);
+                if (r < 0)
+                        return r;
+        }
+
+        *ret_has_any = false;
+
+        if (n_ipv4 == 0 && n_ipv6 == 0) {
+                *ret_maps = NULL;
+                return 0;
+        }
+
+        /* The maps are sets of prefixes, hence neither the order of the items nor the unit in the slice hierarchy
+         * they were configured on matters for their contents */
+        strv_sort(items);
+        strv_uniq(items);
+
+        joined = strv_join(items, " ");
+        if (!joined)
+                return -ENOMEM;
+
+        key = strjoin(verdict == ACCESS_ALLOWED ? "allow " : "deny ", joined);
+        if (!key)
+                return -ENOMEM;
+
+        /* Units with the same effective address lists (which is typical for instances of the same template)
+         * can use the very same maps, there's no need to allocate them in the kernel over and over again. */
+        maps = bpf_firewall_access_maps_ref(hashmap_get(u->manager->bpf_firewall_access_maps, key));
+        if (maps) {
+                *ret_maps = TAKE_PTR(maps);
+                return 0;
         }
 
         if (n_ipv4 > 0) {
@@ -476,9 +559,22 @@ static int bpf_firewall_prepare_access_maps(
                         return r;
         }
 
-        *ret_ipv4_map_fd = TAKE_FD(ipv4_map_fd);
-        *ret_ipv6_map_fd = TAKE_FD(ipv6_map_fd);
-        *ret_has_any = false;
+        maps = new(BPFFirewallAccessMaps, 1);
+        if (!maps)
+                return -ENOMEM;
+
+        *maps = (BPFFirewallAccessMaps) {
+                .n_ref = 1,
+                .key = TAKE_PTR(key),
+                .ipv4_map_fd = TAKE_FD(ipv4_map_fd),
+                .ipv6_map_fd = TAKE_FD(ipv6_map_fd),
+        };
+
+        /* Failing to register the maps for sharing is not fatal, this unit just gets a private copy then */
+        if (hashmap_ensure_put(&u->manager->bpf_firewall_access_maps, &string_hash_ops, maps->key, maps) >= 0)
+                maps->manager = u->manager;
+
+        *ret_maps = TAKE_PTR(maps);
         return 0;
 }
 
@@ -550,11 +646,8 @@ int bpf_firewall_compile(Unit *u) {
         u->ip_bpf_ingress = bpf_program_unref(u->ip_bpf_ingress);
         u->ip_bpf_egress = bpf_program_unref(u->ip_bpf_egress);
 
-        u->ipv4_allow_map_fd = safe_close(u->ipv4_allow_map_fd);
-        u->ipv4_deny_map_fd = safe_close(u->ipv4_deny_map_fd);
-
-        u->ipv6_allow_map_fd = safe_close(u->ipv6_allow_map_fd);
-        u->ipv6_deny_map_fd = safe_close(u->ipv6_deny_map_fd);
+        u->ip_allow_maps = bpf_firewall_access_maps_unref(u->ip_allow_maps);
+        u->ip_deny_maps = bpf_firewall_access_maps_unref(u->ip_deny_maps);
 
         if (u->type != UNIT_SLICE) {
                 /* In inner nodes we only do accounting, we do not actually bother with access control. However, leaf
@@ -563,11 +656,11 @@ int bpf_firewall_compile(Unit *u) {
                  * means that all configure IP access rules *will* take effect on processes, even though we never
                  * compile them for inner nodes. */
 
-                r = bpf_firewall_prepare_access_maps(u, ACCESS_ALLOWED, &u->ipv4_allow_map_fd, &u->ipv6_allow_map_fd, &ip_allow_any);
+                r = bpf_firewall_prepare_access_maps(u, ACCESS_ALLOWED, &u->ip_allow_maps, &ip_allow_any);
                 if (r < 0)
                         return log_unit_error_errno(u, r, "Preparation of eBPF allow maps failed: %m");
 
-                r = bpf_firewall_prepare_access_maps(u, ACCESS_DENIED, &u->ipv4_deny_map_fd, &u->ipv6_deny_map_fd, &ip_deny_any);
+                r = bpf_firewall_prepare_access_maps(u, ACCESS_DENIED, &u->ip_deny_maps, &ip_deny_any);
                 if (r < 0)
                         return log_unit_error_errno(u, r, "Preparation of eBPF deny maps failed: %m");
         }
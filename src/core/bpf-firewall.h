@@ -13,6 +13,9 @@ enum {
 
 int bpf_firewall_supported(void);
 
+BPFFirewallAccessMaps *bpf_firewall_access_maps_ref(BPFFirewallAccessMaps *a);
+BPFFirewallAccessMaps *bpf_firewall_access_maps_unref(BPFFirewallAccessMaps *a);
+
 int bpf_firewall_compile(Unit *u);
 int bpf_firewall_install(Unit *u);
 int bpf_firewall_load_custom(Unit *u);
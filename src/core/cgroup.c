@@ -74,15 +74,50 @@ bool unit_has_host_root_cgroup(Unit *u) {
         return unit_has_name(u, SPECIAL_ROOT_SLICE);
 }
 
+static void unit_forget_cgroup_attribute(Unit *u, const char *attribute) {
+        char *key = NULL;
+
+        assert(u);
+        assert(attribute);
+
+        free(hashmap_remove2(u->cgroup_attributes, attribute, (void**) &key));
+        free(key);
+}
+
+static void unit_flush_cgroup_attributes(Unit *u) {
+        assert(u);
+
+        u->cgroup_attributes = hashmap_free(u->cgroup_attributes);
+}
+
 static int set_attribute_and_warn(Unit *u, const char *controller, const char *attribute, const char *value) {
         int r;
 
-        r = cg_set_attribute(controller, u->cgroup_path, attribute, value);
-        if (r < 0)
+        assert(u);
+        assert(attribute);
+        assert(value);
+
+        /* Realizing many units at once (at boot, or after changing a default that affects all of them)
+         * rewrites most attributes with the values they already have. Skip those. */
+        if (streq_ptr(hashmap_get(u->cgroup_attributes, attribute), value))
+                return 0;
+
+        if (u->cgroup_attribute_dir_fd >= 0)
+                r = cg_set_attribute_at(u->cgroup_attribute_dir_fd, attribute, value);
+        else
+                r = cg_set_attribute(controller, u->cgroup_path, attribute, value);
+        if (r < 0) {
+                unit_forget_cgroup_attribute(u, attribute);
                 log_unit_full_errno(u, LOG_LEVEL_CGROUP_WRITE(r), r, "Failed to set '%s' attribute on '%s' to '%.*s': %m",
                                     strna(attribute), isempty(u->cgroup_path) ? "/" : u->cgroup_path, (int) strcspn(value, NEWLINE), value);
+                return r;
+        }
 
-        return r;
+        unit_forget_cgroup_attribute(u, attribute);
+        if (hashmap_put_strdup(&u->cgroup_attributes, attribute, value) < 0)
+                log_oom_debug();
+
+        return 0;
 }
 
 static void cgroup_compat_warn(void) {
@@ -1142,6 +1177,15 @@ static void cgroup_context_apply(
         if (is_local_root) /* Make sure we don't try to display messages with an empty path. */
                 path = "/";
 
+        /* On the unified hierarchy all attributes live in the same directory, so look it up only once and
+         * write the attributes relative to it. */
+        if (cg_all_unified() > 0) {
+                _cleanup_free_ char *fs = NULL;
+
+                if (cg_get_path(SYSTEMD_CGROUP_CONTROLLER, u->cgroup_path, NULL, &fs) >= 0)
+                        u->cgroup_attribute_dir_fd = open(fs, O_RDONLY|O_DIRECTORY|O_CLOEXEC);
+        }
+
         /* We generally ignore errors caused by read-only mounted cgroup trees (assuming we are running in a container
          * then), and missing cgroups, i.e. EROFS and ENOENT. */
 
@@ -1428,6 +1472,8 @@ static void cgroup_context_apply(
 
         if (apply_mask & CGROUP_MASK_BPF_FIREWALL)
                 cgroup_apply_firewall(u);
+
+        u->cgroup_attribute_dir_fd = safe_close(u->cgroup_attribute_dir_fd);
 }
 
 static bool unit_get_needs_bpf_firewall(Unit *u) {
@@ -1767,7 +1813,7 @@ int unit_watch_cgroup(Unit *u) {
         if (unit_has_name(u, SPECIAL_ROOT_SLICE))
                 return 0;
 
-        r = hashmap_ensure_allocated(&u->manager->cgroup_control_inotify_wd_unit, &trivial_hash_ops);
+        r = hashmap_ensure_allocated(&u->manager->cgroup_control_inotify_wd_unit, &trivial_hash_ops_fast);
         if (r < 0)
                 return log_oom();
 
@@ -1830,7 +1876,7 @@ int unit_watch_cgroup_memory(Unit *u) {
         if (r == 0)
                 return 0;
 
-        r = hashmap_ensure_allocated(&u->manager->cgroup_memory_inotify_wd_unit, &trivial_hash_ops);
+        r = hashmap_ensure_allocated(&u->manager->cgroup_memory_inotify_wd_unit, &trivial_hash_ops_fast);
         if (r < 0)
                 return log_oom();
 
@@ -1906,6 +1952,11 @@ static int unit_update_cgroup(
                 return log_unit_error_errno(u, r, "Failed to create cgroup %s: %m", u->cgroup_path);
         created = r;
 
+        /* Attributes of a new cgroup and of newly created or removed v1 controller hierarchies start out
+         * with the kernel defaults again */
+        if (created || u->cgroup_realized_mask != target_mask)
+                unit_flush_cgroup_attributes(u);
+
         /* Start watching it */
         (void) unit_watch_cgroup(u);
         (void) unit_watch_cgroup_memory(u);
@@ -1922,6 +1973,8 @@ static int unit_update_cgroup(
                         log_unit_warning_errno(u, r, "Failed to enable/disable controllers on cgroup %s, ignoring: %m", u->cgroup_path);
 
                 /* Remember what's actually enabled now */
+                if (u->cgroup_enabled_mask != result_mask)
+                        unit_flush_cgroup_attributes(u);
                 u->cgroup_enabled_mask = result_mask;
 
                 migrate_mask = u->cgroup_realized_mask ^ target_mask;
@@ -2443,12 +2496,28 @@ int unit_realize_cgroup(Unit *u) {
         return unit_realize_cgroup_now(u, manager_state(u->manager));
 }
 
+/* How long accounting values read from cgroupfs are reused */
+#define CGROUP_ACCOUNTING_CACHE_USEC (100 * USEC_PER_MSEC)
+
+static bool accounting_cache_is_fresh(usec_t timestamp) {
+        return timestamp > 0 && now(CLOCK_MONOTONIC) < usec_add(timestamp, CGROUP_ACCOUNTING_CACHE_USEC);
+}
+
+static void unit_flush_accounting_cache(Unit *u) {
+        assert(u);
+
+        zero(u->accounting_cache);
+}
+
 void unit_release_cgroup(Unit *u) {
         assert(u);
 
         /* Forgets all cgroup details for this cgroup — but does *not* destroy the cgroup. This is hence OK to call
          * when we close down everything for reexecution, where we really want to leave the cgroup in place. */
 
+        unit_flush_cgroup_attributes(u);
+        unit_flush_accounting_cache(u);
+
         if (u->cgroup_path) {
                 (void) hashmap_remove(u->manager->cgroup_unit, u->cgroup_path);
                 u->cgroup_path = mfree(u->cgroup_path);
@@ -2754,6 +2823,26 @@ static void unit_remove_from_cgroup_empty_queue(Unit *u) {
         u->in_cgroup_empty_queue = false;
 }
 
+static bool unit_has_managed_oom_kill(Unit *u) {
+        assert(u);
+
+        /* systemd-oomd only kills cgroups below (or at) the cgroups it monitors, and it only monitors those
+         * that have ManagedOOMSwap= or ManagedOOMMemoryPressure= set to "kill". */
+
+        for (; u; u = UNIT_DEREF(u->slice)) {
+                CGroupContext *c;
+
+                c = unit_get_cgroup_context(u);
+                if (!c)
+                        continue;
+
+                if (c->moom_swap == MANAGED_OOM_KILL || c->moom_mem_pressure == MANAGED_OOM_KILL)
+                        return true;
+        }
+
+        return false;
+}
+
 int unit_check_oomd_kill(Unit *u) {
         _cleanup_free_ char *value = NULL;
         bool increased;
@@ -2763,6 +2852,11 @@ int unit_check_oomd_kill(Unit *u) {
         if (!u->cgroup_path)
                 return 0;
 
+        /* This is called for every exited child, avoid the xattr lookup if systemd-oomd can't have acted on
+         * this unit anyway. */
+        if (!unit_has_managed_oom_kill(u))
+                return 0;
+
         r = cg_all_unified();
         if (r < 0)
                 return log_unit_debug_errno(u, r, "Couldn't determine whether we are in all unified mode: %m");
@@ -3262,6 +3356,7 @@ int manager_notify_cgroup_empty(Manager *m, const char *cgroup) {
 }
 
 int unit_get_memory_current(Unit *u, uint64_t *ret) {
+        uint64_t v;
         int r;
 
         assert(u);
@@ -3273,21 +3368,38 @@ int unit_get_memory_current(Unit *u, uint64_t *ret) {
         if (!u->cgroup_path)
                 return -ENODATA;
 
+        if (accounting_cache_is_fresh(u->accounting_cache.memory_timestamp)) {
+                *ret = u->accounting_cache.memory_current;
+                return 0;
+        }
+
         /* The root cgroup doesn't expose this information, let's get it from /proc instead */
         if (unit_has_host_root_cgroup(u))
-                return procfs_memory_get_used(ret);
+                r = procfs_memory_get_used(&v);
+        else {
+                if ((u->cgroup_realized_mask & CGROUP_MASK_MEMORY) == 0)
+                        return -ENODATA;
 
-        if ((u->cgroup_realized_mask & CGROUP_MASK_MEMORY) == 0)
-                return -ENODATA;
+                r = cg_all_unified();
+                if (r < 0)
+                        return r;
 
-        r = cg_all_unified();
+                r = cg_get_attribute_as_uint64("memory", u->cgroup_path, r > 0 ? "memory.current" : "memory.usage_in_bytes", &v);
+        }
         if (r < 0)
                 return r;
 
-        return cg_get_attribute_as_uint64("memory", u->cgroup_path, r > 0 ? "memory.current" : "memory.usage_in_bytes", ret);
+        u->accounting_cache.memory_current = v;
+        u->accounting_cache.memory_timestamp = now(CLOCK_MONOTONIC);
+
+        *ret = v;
+        return 0;
 }
 
 int unit_get_tasks_current(Unit *u, uint64_t *ret) {
+        uint64_t v;
+        int r;
+
         assert(u);
         assert(ret);
 
@@ -3297,14 +3409,28 @@ int unit_get_tasks_current(Unit *u, uint64_t *ret) {
         if (!u->cgroup_path)
                 return -ENODATA;
 
+        if (accounting_cache_is_fresh(u->accounting_cache.tasks_timestamp)) {
+                *ret = u->accounting_cache.tasks_current;
+                return 0;
+        }
+
         /* The root cgroup doesn't expose this information, let's get it from /proc instead */
         if (unit_has_host_root_cgroup(u))
-                return procfs_tasks_get_current(ret);
+                r = procfs_tasks_get_current(&v);
+        else {
+                if ((u->cgroup_realized_mask & CGROUP_MASK_PIDS) == 0)
+                        return -ENODATA;
 
-        if ((u->cgroup_realized_mask & CGROUP_MASK_PIDS) == 0)
-                return -ENODATA;
+                r = cg_get_attribute_as_uint64("pids", u->cgroup_path, "pids.current", &v);
+        }
+        if (r < 0)
+                return r;
 
-        return cg_get_attribute_as_uint64("pids", u->cgroup_path, "pids.current", ret);
+        u->accounting_cache.tasks_current = v;
+        u->accounting_cache.tasks_timestamp = now(CLOCK_MONOTONIC);
+
+        *ret = v;
+        return 0;
 }
 
 static int unit_get_cpu_usage_raw(Unit *u, nsec_t *ret) {
@@ -3317,34 +3443,45 @@ static int unit_get_cpu_usage_raw(Unit *u, nsec_t *ret) {
         if (!u->cgroup_path)
                 return -ENODATA;
 
+        if (accounting_cache_is_fresh(u->accounting_cache.cpu_timestamp)) {
+                *ret = u->accounting_cache.cpu_usage_raw;
+                return 0;
+        }
+
         /* The root cgroup doesn't expose this information, let's get it from /proc instead */
         if (unit_has_host_root_cgroup(u))
-                return procfs_cpu_get_usage(ret);
-
-        /* Requisite controllers for CPU accounting are not enabled */
-        if ((get_cpu_accounting_mask() & ~u->cgroup_realized_mask) != 0)
-                return -ENODATA;
-
-        r = cg_all_unified();
-        if (r < 0)
-                return r;
-        if (r > 0) {
-                _cleanup_free_ char *val = NULL;
-                uint64_t us;
-
-                r = cg_get_keyed_attribute("cpu", u->cgroup_path, "cpu.stat", STRV_MAKE("usage_usec"), &val);
-                if (IN_SET(r, -ENOENT, -ENXIO))
+                r = procfs_cpu_get_usage(&ns);
+        else {
+                /* Requisite controllers for CPU accounting are not enabled */
+                if ((get_cpu_accounting_mask() & ~u->cgroup_realized_mask) != 0)
                         return -ENODATA;
-                if (r < 0)
-                        return r;
 
-                r = safe_atou64(val, &us);
+                r = cg_all_unified();
                 if (r < 0)
                         return r;
+                if (r > 0) {
+                        _cleanup_free_ char *val = NULL;
+                        uint64_t us;
 
-                ns = us * NSEC_PER_USEC;
-        } else
-                return cg_get_attribute_as_uint64("cpuacct", u->cgroup_path, "cpuacct.usage", ret);
+                        r = cg_get_keyed_attribute("cpu", u->cgroup_path, "cpu.stat", STRV_MAKE("usage_usec"), &val);
+                        if (IN_SET(r, -ENOENT, -ENXIO))
+                                return -ENODATA;
+                        if (r < 0)
+                                return r;
+
+                        r = safe_atou64(val, &us);
+                        if (r < 0)
+                                return r;
+
+                        ns = us * NSEC_PER_USEC;
+                } else
+                        r = cg_get_attribute_as_uint64("cpuacct", u->cgroup_path, "cpuacct.usage", &ns);
+        }
+        if (r < 0)
+                return r;
+
+        u->accounting_cache.cpu_usage_raw = ns;
+        u->accounting_cache.cpu_timestamp = now(CLOCK_MONOTONIC);
 
         *ret = ns;
         return 0;
@@ -3454,6 +3591,11 @@ static int unit_get_io_accounting_raw(Unit *u, uint64_t ret[static _CGROUP_IO_AC
         if (!FLAGS_SET(u->cgroup_realized_mask, CGROUP_MASK_IO))
                 return -ENODATA;
 
+        if (accounting_cache_is_fresh(u->accounting_cache.io_timestamp)) {
+                memcpy(ret, u->accounting_cache.io_raw, sizeof(u->accounting_cache.io_raw));
+                return 0;
+        }
+
         r = cg_get_path("io", u->cgroup_path, "io.stat", &path);
         if (r < 0)
                 return r;
@@ -3504,6 +3646,9 @@ static int unit_get_io_accounting_raw(Unit *u, uint64_t ret[static _CGROUP_IO_AC
                 }
         }
 
+        memcpy(u->accounting_cache.io_raw, acc, sizeof(acc));
+        u->accounting_cache.io_timestamp = now(CLOCK_MONOTONIC);
+
         memcpy(ret, acc, sizeof(acc));
         return 0;
 }
@@ -3552,6 +3697,7 @@ int unit_reset_cpu_accounting(Unit *u) {
         assert(u);
 
         u->cpu_usage_last = NSEC_INFINITY;
+        u->accounting_cache.cpu_timestamp = 0;
 
         r = unit_get_cpu_usage_raw(u, &u->cpu_usage_base);
         if (r < 0) {
@@ -3586,6 +3732,8 @@ int unit_reset_io_accounting(Unit *u) {
         for (CGroupIOAccountingMetric i = 0; i < _CGROUP_IO_ACCOUNTING_METRIC_MAX; i++)
                 u->io_accounting_last[i] = UINT64_MAX;
 
+        u->accounting_cache.io_timestamp = 0;
+
         r = unit_get_io_accounting_raw(u, u->io_accounting_base);
         if (r < 0) {
                 zero(u->io_accounting_base);
@@ -187,6 +187,22 @@ typedef enum CGroupIOAccountingMetric {
         _CGROUP_IO_ACCOUNTING_METRIC_INVALID = -EINVAL,
 } CGroupIOAccountingMetric;
 
+/* Accounting data recently read from a unit's cgroup. Reading all accounting properties of a unit at once, or
+ * the same property repeatedly in quick succession, is then answered without rereading the cgroupfs files. */
+typedef struct CGroupAccountingCache {
+        usec_t memory_timestamp;
+        uint64_t memory_current;
+
+        usec_t tasks_timestamp;
+        uint64_t tasks_current;
+
+        usec_t cpu_timestamp;
+        nsec_t cpu_usage_raw;
+
+        usec_t io_timestamp;
+        uint64_t io_raw[_CGROUP_IO_ACCOUNTING_METRIC_MAX];
+} CGroupAccountingCache;
+
 typedef struct Unit Unit;
 typedef struct Manager Manager;
 
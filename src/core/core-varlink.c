@@ -193,6 +193,187 @@ static int vl_method_subscribe_managed_oom_cgroups(
         return varlink_notify(m->managed_oom_varlink_request, v);
 }
 
+static int build_unit_accounting_json(Unit *u, JsonVariant **ret) {
+        uint64_t memory = UINT64_MAX, tasks = UINT64_MAX, io[_CGROUP_IO_ACCOUNTING_METRIC_MAX];
+        nsec_t cpu = NSEC_INFINITY;
+
+        assert(u);
+        assert(ret);
+
+        /* Everything we can't read (because accounting is off, or the controller isn't available) is simply
+         * left out of the record */
+        (void) unit_get_memory_current(u, &memory);
+        (void) unit_get_tasks_current(u, &tasks);
+        (void) unit_get_cpu_usage(u, &cpu);
+
+        for (CGroupIOAccountingMetric i = 0; i < _CGROUP_IO_ACCOUNTING_METRIC_MAX; i++)
+                if (unit_get_io_accounting(u, i, false, io + i) < 0)
+                        io[i] = UINT64_MAX;
+
+        return json_build(ret, JSON_BUILD_OBJECT(
+                                   JSON_BUILD_PAIR("unit", JSON_BUILD_STRING(u->id)),
+                                   JSON_BUILD_PAIR("cgroup", JSON_BUILD_STRING(u->cgroup_path)),
+                                   JSON_BUILD_PAIR_CONDITION(memory != UINT64_MAX, "memoryCurrent", JSON_BUILD_UNSIGNED(memory)),
+                                   JSON_BUILD_PAIR_CONDITION(tasks != UINT64_MAX, "tasksCurrent", JSON_BUILD_UNSIGNED(tasks)),
+                                   JSON_BUILD_PAIR_CONDITION(cpu != NSEC_INFINITY, "cpuUsageNSec", JSON_BUILD_UNSIGNED(cpu)),
+                                   JSON_BUILD_PAIR_CONDITION(io[CGROUP_IO_READ_BYTES] != UINT64_MAX, "ioReadBytes", JSON_BUILD_UNSIGNED(io[CGROUP_IO_READ_BYTES])),
+                                   JSON_BUILD_PAIR_CONDITION(io[CGROUP_IO_WRITE_BYTES] != UINT64_MAX, "ioWriteBytes", JSON_BUILD_UNSIGNED(io[CGROUP_IO_WRITE_BYTES])),
+                                   JSON_BUILD_PAIR_CONDITION(io[CGROUP_IO_READ_OPERATIONS] != UINT64_MAX, "ioReadOperations", JSON_BUILD_UNSIGNED(io[CGROUP_IO_READ_OPERATIONS])),
+                                   JSON_BUILD_PAIR_CONDITION(io[CGROUP_IO_WRITE_OPERATIONS] != UINT64_MAX, "ioWriteOperations", JSON_BUILD_UNSIGNED(io[CGROUP_IO_WRITE_OPERATIONS]))));
+}
+
+static int vl_method_get_unit_accounting(Varlink *link, JsonVariant *parameters, VarlinkMethodFlags flags, void *userdata) {
+
+        static const JsonDispatch dispatch_table[] = {
+                { "unit", JSON_VARIANT_STRING, json_dispatch_const_string, 0, 0 },
+                {}
+        };
+
+        _cleanup_(json_variant_unrefp) JsonVariant *v = NULL;
+        Manager *m = userdata;
+        const char *name = NULL, *k;
+        Unit *u, *last = NULL;
+        int r;
+
+        assert(link);
+        assert(m);
+
+        r = json_dispatch(parameters, dispatch_table, NULL, 0, &name);
+        if (r < 0)
+                return r;
+
+        if (name) {
+                u = manager_get_unit(m, name);
+                if (!u || !u->cgroup_path)
+                        return varlink_error(link, "io.systemd.Accounting.NoSuchUnit", NULL);
+
+                r = build_unit_accounting_json(u, &v);
+                if (r < 0)
+                        return r;
+
+                return varlink_reply(link, v);
+        }
+
+        /* Dumping all units at once requires streaming, since we reply once per unit */
+        if (!FLAGS_SET(flags, VARLINK_METHOD_MORE))
+                return varlink_error(link, "org.varlink.service.ExpectedMore", NULL);
+
+        HASHMAP_FOREACH_KEY(u, k, m->units) {
+                /* Skip aliases */
+                if (u->id != k)
+                        continue;
+
+                if (!u->cgroup_path)
+                        continue;
+
+                if (last) {
+                        r = build_unit_accounting_json(last, &v);
+                        if (r < 0)
+                                return r;
+
+                        r = varlink_notify(link, v);
+                        if (r < 0)
+                                return r;
+
+                        v = json_variant_unref(v);
+                }
+
+                last = u;
+        }
+
+        if (!last)
+                return varlink_error(link, "io.systemd.Accounting.NoSuchUnit", NULL);
+
+        r = build_unit_accounting_json(last, &v);
+        if (r < 0)
+                return r;
+
+        return varlink_reply(link, v);
+}
+
+#define LIST_COUNT(name, head)                                  \
+        ({                                                      \
+                typeof(head) _i;                                \
+                uint64_t _n = 0;                                \
+                LIST_FOREACH(name, _i, head)                    \
+                        _n++;                                   \
+                _n;                                             \
+        })
+
+static uint64_t manager_count_units(Manager *m) {
+        uint64_t n_units = 0;
+
+        assert(m);
+
+        for (UnitType t = 0; t < _UNIT_TYPE_MAX; t++)
+                n_units += LIST_COUNT(units_by_type, m->units_by_type[t]);
+
+        return n_units;
+}
+
+static int vl_method_get_metrics(Varlink *link, JsonVariant *parameters, VarlinkMethodFlags flags, void *userdata) {
+        _cleanup_(json_variant_unrefp) JsonVariant *v = NULL, *histogram = NULL;
+        Manager *m = userdata;
+        int r;
+
+        assert(link);
+        assert(m);
+
+        if (json_variant_elements(parameters) > 0)
+                return varlink_error_invalid_parameter(link, parameters);
+
+        r = metric_histogram_build_json(&m->loop_iterations, &histogram);
+        if (r < 0)
+                return r;
+
+        r = json_build(&v, JSON_BUILD_OBJECT(
+                                   JSON_BUILD_PAIR("units", JSON_BUILD_UNSIGNED(manager_count_units(m))),
+                                   JSON_BUILD_PAIR("jobs", JSON_BUILD_UNSIGNED(hashmap_size(m->jobs))),
+                                   JSON_BUILD_PAIR("installedJobs", JSON_BUILD_UNSIGNED(m->n_installed_jobs)),
+                                   JSON_BUILD_PAIR("failedJobs", JSON_BUILD_UNSIGNED(m->n_failed_jobs)),
+                                   JSON_BUILD_PAIR("queues", JSON_BUILD_OBJECT(
+                                                   JSON_BUILD_PAIR("load", JSON_BUILD_UNSIGNED(LIST_COUNT(load_queue, m->load_queue))),
+                                                   JSON_BUILD_PAIR("run", JSON_BUILD_UNSIGNED(prioq_size(m->run_queue))),
+                                                   JSON_BUILD_PAIR("dbusUnit", JSON_BUILD_UNSIGNED(LIST_COUNT(dbus_queue, m->dbus_unit_queue))),
+                                                   JSON_BUILD_PAIR("dbusJob", JSON_BUILD_UNSIGNED(LIST_COUNT(dbus_queue, m->dbus_job_queue))),
+                                                   JSON_BUILD_PAIR("cgroupRealize", JSON_BUILD_UNSIGNED(LIST_COUNT(cgroup_realize_queue, m->cgroup_realize_queue))),
+                                                   JSON_BUILD_PAIR("gcUnit", JSON_BUILD_UNSIGNED(LIST_COUNT(gc_queue, m->gc_unit_queue))),
+                                                   JSON_BUILD_PAIR("gcJob", JSON_BUILD_UNSIGNED(LIST_COUNT(gc_queue, m->gc_job_queue))),
+                                                   JSON_BUILD_PAIR("cleanup", JSON_BUILD_UNSIGNED(LIST_COUNT(cleanup_queue, m->cleanup_queue))))),
+                                   JSON_BUILD_PAIR("loopIterations", JSON_BUILD_UNSIGNED(m->loop_iterations.count)),
+                                   JSON_BUILD_PAIR("loopIterationMaxUSec", JSON_BUILD_UNSIGNED(m->loop_iterations.max)),
+                                   JSON_BUILD_PAIR("loopIterationHistogram", JSON_BUILD_VARIANT(histogram)),
+                                   JSON_BUILD_PAIR("reloads", JSON_BUILD_UNSIGNED(m->n_reloads)),
+                                   JSON_BUILD_PAIR_CONDITION(m->n_reloads > 0, "reloadLastUSec", JSON_BUILD_UNSIGNED(m->reload_last_usec)),
+                                   JSON_BUILD_PAIR_CONDITION(m->n_reloads > 0, "reloadMaxUSec", JSON_BUILD_UNSIGNED(m->reload_max_usec))));
+        if (r < 0)
+                return r;
+
+        return varlink_reply(link, v);
+}
+
+static int vl_method_list_metrics(Varlink *link, JsonVariant *parameters, VarlinkMethodFlags flags, void *userdata) {
+        Manager *m = userdata;
+
+        assert(link);
+        assert(m);
+
+        const Metric metrics[] = {
+                METRIC_GAUGE_MAKE("units", "Loaded units, not counting aliases", manager_count_units(m)),
+                METRIC_GAUGE_MAKE("jobs", "Pending jobs", hashmap_size(m->jobs)),
+                METRIC_GAUGE_MAKE("runningJobs", "Running jobs", m->n_running_jobs),
+                METRIC_COUNTER_MAKE("installedJobs", "Jobs installed since startup", m->n_installed_jobs),
+                METRIC_COUNTER_MAKE("failedJobs", "Jobs failed since startup", m->n_failed_jobs),
+                METRIC_GAUGE_MAKE("loadQueue", "Units in the load queue", LIST_COUNT(load_queue, m->load_queue)),
+                METRIC_GAUGE_MAKE("runQueue", "Jobs in the run queue", prioq_size(m->run_queue)),
+                METRIC_COUNTER_MAKE("reloads", "Reloads since startup", m->n_reloads),
+                METRIC_GAUGE_MAKE("reloadLastUSec", "Duration of the last reload", m->reload_last_usec),
+                METRIC_HISTOGRAM_MAKE("loopIterationUSec", "CPU time per main loop iteration", &m->loop_iterations),
+        };
+
+        return varlink_reply_metrics(link, parameters, metrics, ELEMENTSOF(metrics));
+}
+
 static int vl_method_get_user_record(Varlink *link, JsonVariant *parameters, VarlinkMethodFlags flags, void *userdata) {
 
         static const JsonDispatch dispatch_table[] = {
@@ -444,7 +625,10 @@ int manager_varlink_init(Manager *m) {
                         "io.systemd.UserDatabase.GetUserRecord",  vl_method_get_user_record,
                         "io.systemd.UserDatabase.GetGroupRecord", vl_method_get_group_record,
                         "io.systemd.UserDatabase.GetMemberships", vl_method_get_memberships,
-                        "io.systemd.ManagedOOM.SubscribeManagedOOMCGroups",  vl_method_subscribe_managed_oom_cgroups);
+                        "io.systemd.ManagedOOM.SubscribeManagedOOMCGroups",  vl_method_subscribe_managed_oom_cgroups,
+                        "io.systemd.Accounting.GetUnitAccounting", vl_method_get_unit_accounting,
+                        "io.systemd.Manager.GetMetrics", vl_method_get_metrics,
+                        "io.systemd.Metrics.List", vl_method_list_metrics);
         if (r < 0)
                 return log_error_errno(r, "Failed to register varlink methods: %m");
 
@@ -462,6 +646,14 @@ int manager_varlink_init(Manager *m) {
                 r = varlink_server_listen_address(s, VARLINK_ADDR_PATH_MANAGED_OOM, 0666);
                 if (r < 0)
                         return log_error_errno(r, "Failed to bind to varlink socket: %m");
+
+                r = varlink_server_listen_address(s, VARLINK_ADDR_PATH_ACCOUNTING, 0666);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to bind to varlink socket: %m");
+
+                r = varlink_server_listen_address(s, VARLINK_ADDR_PATH_MANAGER, 0666);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to bind to varlink socket: %m");
         }
 
         r = varlink_server_attach_event(s, m->event, SD_EVENT_PRIORITY_NORMAL);
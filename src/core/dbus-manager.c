@@ -11,6 +11,7 @@
 #include "bus-common-errors.h"
 #include "bus-get-properties.h"
 #include "bus-log-control-api.h"
+#include "bus-objects.h"
 #include "dbus-cgroup.h"
 #include "dbus-execute.h"
 #include "dbus-job.h"
@@ -225,6 +226,38 @@ static int property_get_environment(
         return sd_bus_message_append_strv(reply, l);
 }
 
+static int property_get_generator_timestamps(
+                sd_bus *bus,
+                const char *path,
+                const char *interface,
+                const char *property,
+                sd_bus_message *reply,
+                void *userdata,
+                sd_bus_error *error) {
+
+        Manager *m = userdata;
+        int r;
+
+        assert(bus);
+        assert(reply);
+        assert(m);
+
+        r = sd_bus_message_open_container(reply, 'a', "(stt)");
+        if (r < 0)
+                return r;
+
+        for (size_t i = 0; i < m->n_generator_timings; i++) {
+                r = sd_bus_message_append(reply, "(stt)",
+                                          m->generator_timings[i].path,
+                                          m->generator_timings[i].start,
+                                          m->generator_timings[i].finish);
+                if (r < 0)
+                        return r;
+        }
+
+        return sd_bus_message_close_container(reply);
+}
+
 static int property_get_show_status(
                 sd_bus *bus,
                 const char *path,
@@ -1073,6 +1106,22 @@ static int method_reset_failed(sd_bus_message *message, void *userdata, sd_bus_e
         return sd_bus_reply_method_return(message, NULL);
 }
 
+static bool unit_matches_states_and_patterns(Unit *u, char **states, char **patterns) {
+        assert(u);
+
+        if (!strv_isempty(states) &&
+            !strv_contains(states, unit_load_state_to_string(u->load_state)) &&
+            !strv_contains(states, unit_active_state_to_string(unit_active_state(u))) &&
+            !strv_contains(states, unit_sub_state_to_string(u)))
+                return false;
+
+        if (!strv_isempty(patterns) &&
+            !strv_fnmatch_or_empty(patterns, u->id, FNM_NOESCAPE))
+                return false;
+
+        return true;
+}
+
 static int list_units_filtered(sd_bus_message *message, void *userdata, sd_bus_error *error, char **states, char **patterns) {
         _cleanup_(sd_bus_message_unrefp) sd_bus_message *reply = NULL;
         Manager *m = userdata;
@@ -1101,14 +1150,7 @@ static int list_units_filtered(sd_bus_message *message, void *userdata, sd_bus_e
                 if (k != u->id)
                         continue;
 
-                if (!strv_isempty(states) &&
-                    !strv_contains(states, unit_load_state_to_string(u->load_state)) &&
-                    !strv_contains(states, unit_active_state_to_string(unit_active_state(u))) &&
-                    !strv_contains(states, unit_sub_state_to_string(u)))
-                        continue;
-
-                if (!strv_isempty(patterns) &&
-                    !strv_fnmatch_or_empty(patterns, u->id, FNM_NOESCAPE))
+                if (!unit_matches_states_and_patterns(u, states, patterns))
                         continue;
 
                 r = reply_unit_info(reply, u);
@@ -1154,6 +1196,78 @@ static int method_list_units_by_patterns(sd_bus_message *message, void *userdata
         return list_units_filtered(message, userdata, error, states, patterns);
 }
 
+static int method_list_unit_properties_by_patterns(sd_bus_message *message, void *userdata, sd_bus_error *error) {
+        _cleanup_(sd_bus_message_unrefp) sd_bus_message *reply = NULL;
+        _cleanup_strv_free_ char **states = NULL, **patterns = NULL, **properties = NULL;
+        Manager *m = userdata;
+        const char *k;
+        Unit *u;
+        int r;
+
+        assert(message);
+        assert(m);
+
+        /* Returns the properties of all matching units in one go, in the same format as
+         * GetManagedObjects(). This saves monitoring tools from issuing a GetAll() call per unit. */
+
+        r = sd_bus_message_read_strv(message, &states);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_message_read_strv(message, &patterns);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_message_read_strv(message, &properties);
+        if (r < 0)
+                return r;
+
+        /* Anyone can call this method */
+
+        r = mac_selinux_access_check(message, "status", error);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_message_new_method_return(message, &reply);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_message_open_container(reply, 'a', "{oa{sa{sv}}}");
+        if (r < 0)
+                return r;
+
+        HASHMAP_FOREACH_KEY(u, k, m->units) {
+                _cleanup_free_ char *path = NULL;
+
+                if (k != u->id)
+                        continue;
+
+                if (!unit_matches_states_and_patterns(u, states, patterns))
+                        continue;
+
+                r = mac_selinux_unit_access_check(u, message, "status", error);
+                if (r < 0)
+                        return r;
+
+                path = unit_dbus_path(u);
+                if (!path)
+                        return -ENOMEM;
+
+                /* An empty list of properties means all of them */
+                r = bus_message_append_object_properties(sd_bus_message_get_bus(message), reply, path,
+                                                         strv_isempty(properties) ? NULL : properties,
+                                                         error);
+                if (r < 0)
+                        return r;
+        }
+
+        r = sd_bus_message_close_container(reply);
+        if (r < 0)
+                return r;
+
+        return sd_bus_send(NULL, reply, NULL);
+}
+
 static int method_list_jobs(sd_bus_message *message, void *userdata, sd_bus_error *error) {
         _cleanup_(sd_bus_message_unrefp) sd_bus_message *reply = NULL;
         Manager *m = userdata;
@@ -1265,6 +1379,65 @@ static int method_unsubscribe(sd_bus_message *message, void *userdata, sd_bus_er
         return sd_bus_reply_method_return(message, NULL);
 }
 
+static int method_subscribe_units_changed(sd_bus_message *message, void *userdata, sd_bus_error *error) {
+        Manager *m = userdata;
+        int r;
+
+        assert(message);
+        assert(m);
+
+        /* Anyone can call this method */
+
+        r = mac_selinux_access_check(message, "status", error);
+        if (r < 0)
+                return r;
+
+        /* Direct connections receive all per-unit signals anyway, hence the batched one is only
+         * available on the API bus */
+        if (sd_bus_message_get_bus(message) != m->api_bus)
+                return sd_bus_error_set(error, SD_BUS_ERROR_NOT_SUPPORTED,
+                                        "Batched unit change signals are only available on the API bus.");
+
+        if (!m->subscribed_units_changed) {
+                r = sd_bus_track_new(sd_bus_message_get_bus(message), &m->subscribed_units_changed, NULL, NULL);
+                if (r < 0)
+                        return r;
+        }
+
+        r = sd_bus_track_add_sender(m->subscribed_units_changed, message);
+        if (r < 0)
+                return r;
+        if (r == 0)
+                return sd_bus_error_set(error, BUS_ERROR_ALREADY_SUBSCRIBED, "Client is already subscribed.");
+
+        return sd_bus_reply_method_return(message, NULL);
+}
+
+static int method_unsubscribe_units_changed(sd_bus_message *message, void *userdata, sd_bus_error *error) {
+        Manager *m = userdata;
+        int r;
+
+        assert(message);
+        assert(m);
+
+        /* Anyone can call this method */
+
+        r = mac_selinux_access_check(message, "status", error);
+        if (r < 0)
+                return r;
+
+        if (sd_bus_message_get_bus(message) == m->api_bus) {
+                r = sd_bus_track_remove_sender(m->subscribed_units_changed, message);
+                if (r < 0)
+                        return r;
+        } else
+                r = 0;
+        if (r == 0)
+                return sd_bus_error_set(error, BUS_ERROR_NOT_SUBSCRIBED, "Client is not subscribed.");
+
+        return sd_bus_reply_method_return(message, NULL);
+}
+
 static int dump_impl(sd_bus_message *message, void *userdata, sd_bus_error *error, int (*reply)(sd_bus_message *, char *)) {
         _cleanup_free_ char *dump = NULL;
         Manager *m = userdata;
@@ -1346,8 +1519,7 @@ int verify_run_space_and_log(const char *message) {
         return 0;
 }
 
-static int method_reload(sd_bus_message *message, void *userdata, sd_bus_error *error) {
-        Manager *m = userdata;
+static int method_reload_generic(sd_bus_message *message, Manager *m, bool if_changed, sd_bus_error *error) {
         int r;
 
         assert(message);
@@ -1377,11 +1549,20 @@ static int method_reload(sd_bus_message *message, void *userdata, sd_bus_error *
         if (r < 0)
                 return r;
 
+        m->reload_if_changed = if_changed;
         m->objective = MANAGER_RELOAD;
 
         return 1;
 }
 
+static int method_reload(sd_bus_message *message, void *userdata, sd_bus_error *error) {
+        return method_reload_generic(message, userdata, false, error);
+}
+
+static int method_reload_if_changed(sd_bus_message *message, void *userdata, sd_bus_error *error) {
+        return method_reload_generic(message, userdata, true, error);
+}
+
 static int method_reexecute(sd_bus_message *message, void *userdata, sd_bus_error *error) {
         Manager *m = userdata;
         int r;
@@ -2643,6 +2824,7 @@ const sd_bus_vtable bus_manager_vtable[] = {
         BUS_PROPERTY_DUAL_TIMESTAMP("SecurityFinishTimestamp", offsetof(Manager, timestamps[MANAGER_TIMESTAMP_SECURITY_FINISH]), SD_BUS_VTABLE_PROPERTY_CONST),
         BUS_PROPERTY_DUAL_TIMESTAMP("GeneratorsStartTimestamp", offsetof(Manager, timestamps[MANAGER_TIMESTAMP_GENERATORS_START]), SD_BUS_VTABLE_PROPERTY_CONST),
         BUS_PROPERTY_DUAL_TIMESTAMP("GeneratorsFinishTimestamp", offsetof(Manager, timestamps[MANAGER_TIMESTAMP_GENERATORS_FINISH]), SD_BUS_VTABLE_PROPERTY_CONST),
+        SD_BUS_PROPERTY("GeneratorTimestampsMonotonic", "a(stt)", property_get_generator_timestamps, 0, 0),
         BUS_PROPERTY_DUAL_TIMESTAMP("UnitsLoadStartTimestamp", offsetof(Manager, timestamps[MANAGER_TIMESTAMP_UNITS_LOAD_START]), SD_BUS_VTABLE_PROPERTY_CONST),
         BUS_PROPERTY_DUAL_TIMESTAMP("UnitsLoadFinishTimestamp", offsetof(Manager, timestamps[MANAGER_TIMESTAMP_UNITS_LOAD_FINISH]), SD_BUS_VTABLE_PROPERTY_CONST),
         BUS_PROPERTY_DUAL_TIMESTAMP("InitRDSecurityStartTimestamp", offsetof(Manager, timestamps[MANAGER_TIMESTAMP_INITRD_SECURITY_START]), SD_BUS_VTABLE_PROPERTY_CONST),
@@ -3007,6 +3189,15 @@ const sd_bus_vtable bus_manager_vtable[] = {
                                  SD_BUS_PARAM(units),
                                  method_list_units_by_patterns,
                                  SD_BUS_VTABLE_UNPRIVILEGED),
+        SD_BUS_METHOD_WITH_NAMES("ListUnitPropertiesByPatterns",
+                                 "asasas",
+                                 SD_BUS_PARAM(states)
+                                 SD_BUS_PARAM(patterns)
+                                 SD_BUS_PARAM(properties),
+                                 "a{oa{sa{sv}}}",
+                                 SD_BUS_PARAM(units),
+                                 method_list_unit_properties_by_patterns,
+                                 SD_BUS_VTABLE_UNPRIVILEGED),
         SD_BUS_METHOD_WITH_NAMES("ListUnitsByNames",
                                  "as",
                                  SD_BUS_PARAM(names),
@@ -3030,6 +3221,16 @@ const sd_bus_vtable bus_manager_vtable[] = {
                       NULL,
                       method_unsubscribe,
                       SD_BUS_VTABLE_UNPRIVILEGED),
+        SD_BUS_METHOD("SubscribeUnitsChanged",
+                      NULL,
+                      NULL,
+                      method_subscribe_units_changed,
+                      SD_BUS_VTABLE_UNPRIVILEGED),
+        SD_BUS_METHOD("UnsubscribeUnitsChanged",
+                      NULL,
+                      NULL,
+                      method_unsubscribe_units_changed,
+                      SD_BUS_VTABLE_UNPRIVILEGED),
         SD_BUS_METHOD_WITH_NAMES("Dump",
                                  NULL,,
                                  "s",
@@ -3061,6 +3262,11 @@ const sd_bus_vtable bus_manager_vtable[] = {
                       NULL,
                       method_reload,
                       SD_BUS_VTABLE_UNPRIVILEGED),
+        SD_BUS_METHOD("ReloadIfChanged",
+                      NULL,
+                      NULL,
+                      method_reload_if_changed,
+                      SD_BUS_VTABLE_UNPRIVILEGED),
         SD_BUS_METHOD("Reexecute",
                       NULL,
                       NULL,
@@ -3317,6 +3523,10 @@ const sd_bus_vtable bus_manager_vtable[] = {
                                  SD_BUS_PARAM(id)
                                  SD_BUS_PARAM(unit),
                                  0),
+        SD_BUS_SIGNAL_WITH_NAMES("UnitsChanged",
+                                 "a(so)",
+                                 SD_BUS_PARAM(units),
+                                 0),
         SD_BUS_SIGNAL_WITH_NAMES("UnitRemoved",
                                  "so",
                                  SD_BUS_PARAM(id)
@@ -3447,6 +3657,56 @@ void bus_manager_send_reloading(Manager *m, bool active) {
                 log_debug_errno(r, "Failed to send reloading signal: %m");
 }
 
+void bus_manager_send_units_changed(Manager *m) {
+        _cleanup_(sd_bus_message_unrefp) sd_bus_message *message = NULL;
+        _cleanup_ordered_set_free_ OrderedSet *pending = NULL;
+        const char *id;
+        int r;
+
+        assert(m);
+
+        pending = TAKE_PTR(m->pending_units_changed);
+
+        /* Only clients on the API bus can subscribe, don't bother if they are all gone */
+        if (!m->api_bus || sd_bus_track_count(m->subscribed_units_changed) <= 0)
+                return;
+
+        r = sd_bus_message_new_signal(m->api_bus, &message, "/org/freedesktop/systemd1", "org.freedesktop.systemd1.Manager", "UnitsChanged");
+        if (r < 0)
+                goto fail;
+
+        r = sd_bus_message_open_container(message, 'a', "(so)");
+        if (r < 0)
+                goto fail;
+
+        ORDERED_SET_FOREACH(id, pending) {
+                _cleanup_free_ char *p = NULL;
+
+                p = unit_dbus_path_from_name(id);
+                if (!p) {
+                        r = -ENOMEM;
+                        goto fail;
+                }
+
+                r = sd_bus_message_append(message, "(so)", id, p);
+                if (r < 0)
+                        goto fail;
+        }
+
+        r = sd_bus_message_close_container(message);
+        if (r < 0)
+                goto fail;
+
+        r = sd_bus_send(m->api_bus, message, NULL);
+        if (r < 0)
+                goto fail;
+
+        return;
+
+fail:
+        log_debug_errno(r, "Failed to send UnitsChanged signal: %m");
+}
+
 static int send_changed_signal(sd_bus *bus, void *userdata) {
         assert(bus);
 
@@ -1632,6 +1632,13 @@ void bus_unit_send_change_signal(Unit *u) {
                 log_unit_debug_errno(u, r, "Failed to send unit change signal for %s: %m", u->id);
 
         u->sent_dbus_new_signal = true;
+
+        /* Remember the unit for the next batched UnitsChanged signal, if anybody asked for it */
+        if (sd_bus_track_count(u->manager->subscribed_units_changed) > 0) {
+                r = ordered_set_put_strdup(&u->manager->pending_units_changed, u->id);
+                if (r < 0)
+                        log_unit_debug_errno(u, r, "Failed to queue unit for UnitsChanged signal, ignoring: %m");
+        }
 }
 
 void bus_unit_send_pending_change_signal(Unit *u, bool including_new) {
@@ -2394,6 +2401,9 @@ int bus_unit_set_properties(
                                 return r;
 
                         for_real = true;
+
+                        /* Some of the properties we are about to change might be constant ones */
+                        bus_unit_invalidate_property_cache(u);
                         continue;
                 }
 
@@ -8,8 +8,10 @@
 
 #include "alloc-util.h"
 #include "bus-common-errors.h"
+#include "bus-control.h"
 #include "bus-error.h"
 #include "bus-internal.h"
+#include "bus-objects.h"
 #include "bus-polkit.h"
 #include "bus-util.h"
 #include "dbus-automount.h"
@@ -622,6 +624,13 @@ static int bus_setup_api_vtables(Manager *m, sd_bus *bus) {
         assert(m);
         assert(bus);
 
+        /* Keep the serialized values of constant properties around, so that clients that enumerate all
+         * units and their properties don't need us to regenerate them each time. Everything that changes
+         * such properties calls bus_invalidate_property_cache() or goes through the D-Bus queues. */
+        r = bus_property_cache_set_enabled(bus, true);
+        if (r < 0)
+                return r;
+
 #if HAVE_SELINUX
         r = sd_bus_add_filter(bus, NULL, mac_selinux_filter, m);
         if (r < 0)
@@ -724,6 +733,15 @@ static int bus_on_connection(sd_event_source *s, int fd, uint32_t revents, void
                 return 0;
         }
 
+        /* The private socket is AF_UNIX, hence the peer runs on our host. Clients such as configuration
+         * management agents may issue a lot of calls over one connection, don't read the same bits from
+         * /proc for each of them. */
+        r = bus_peer_creds_cache_set_enabled(bus, true);
+        if (r < 0) {
+                log_warning_errno(r, "Failed to enable peer credentials cache for new connection: %m");
+                return 0;
+        }
+
         r = sd_bus_start(bus);
         if (r < 0) {
                 log_warning_errno(r, "Failed to start new connection bus: %m");
@@ -992,6 +1010,8 @@ static void destroy_bus(Manager *m, sd_bus **bus) {
         /* Get rid of tracked clients on this bus */
         if (m->subscribed && sd_bus_track_get_bus(m->subscribed) == *bus)
                 m->subscribed = sd_bus_track_unref(m->subscribed);
+        if (m->subscribed_units_changed && sd_bus_track_get_bus(m->subscribed_units_changed) == *bus)
+                m->subscribed_units_changed = sd_bus_track_unref(m->subscribed_units_changed);
 
         HASHMAP_FOREACH(j, m->jobs)
                 if (j->bus_track && sd_bus_track_get_bus(j->bus_track) == *bus)
@@ -1049,8 +1069,11 @@ void bus_done(Manager *m) {
         bus_done_private(m);
 
         assert(!m->subscribed);
+        assert(!m->subscribed_units_changed);
 
         m->deserialized_subscribed = strv_free(m->deserialized_subscribed);
+        m->deserialized_subscribed_units_changed = strv_free(m->deserialized_subscribed_units_changed);
+        m->pending_units_changed = ordered_set_free(m->pending_units_changed);
         bus_verify_polkit_async_registry_free(m->polkit_registry);
 }
 
@@ -1182,6 +1205,70 @@ int bus_verify_set_environment_async(Manager *m, sd_bus_message *call, sd_bus_er
         return bus_verify_polkit_async(call, CAP_SYS_ADMIN, "org.freedesktop.systemd1.set-environment", NULL, false, UID_INVALID, &m->polkit_registry, error);
 }
 
+static bool manager_property_cache_is_empty(Manager *m) {
+        sd_bus *b;
+
+        assert(m);
+
+        if (m->api_bus && !hashmap_isempty(m->api_bus->property_cache))
+                return false;
+
+        SET_FOREACH(b, m->private_buses)
+                if (!hashmap_isempty(b->property_cache))
+                        return false;
+
+        return true;
+}
+
+void bus_invalidate_property_cache(Manager *m, const char *path) {
+        sd_bus *b;
+
+        assert(m);
+
+        /* Drops cached property values of the object at the specified path, or of all objects if NULL */
+
+        if (m->api_bus)
+                bus_property_cache_invalidate(m->api_bus, path, NULL);
+
+        SET_FOREACH(b, m->private_buses)
+                bus_property_cache_invalidate(b, path, NULL);
+}
+
+void bus_unit_invalidate_property_cache(Unit *u) {
+        _cleanup_free_ char *p = NULL;
+
+        assert(u);
+
+        if (!u->id)
+                return;
+
+        /* unit_add_to_dbus_queue() calls us a lot, hence avoid formatting the paths if nothing is cached */
+        if (manager_property_cache_is_empty(u->manager))
+                return;
+
+        /* If we can't format the path, we'll flush everything, which is always safe */
+        p = unit_dbus_path(u);
+        bus_invalidate_property_cache(u->manager, p);
+
+        if (!sd_id128_is_null(u->invocation_id)) {
+                free(p);
+                p = unit_dbus_path_invocation_id(u);
+                bus_invalidate_property_cache(u->manager, p);
+        }
+}
+
+void bus_job_invalidate_property_cache(Job *j) {
+        _cleanup_free_ char *p = NULL;
+
+        assert(j);
+
+        if (manager_property_cache_is_empty(j->manager))
+                return;
+
+        p = job_dbus_path(j);
+        bus_invalidate_property_cache(j->manager, p);
+}
+
 uint64_t manager_bus_n_queued_write(Manager *m) {
         uint64_t c = 0;
         sd_bus *b;
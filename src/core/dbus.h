@@ -30,6 +30,10 @@ int bus_verify_set_environment_async(Manager *m, sd_bus_message *call, sd_bus_er
 
 int bus_forward_agent_released(Manager *m, const char *path);
 
+void bus_invalidate_property_cache(Manager *m, const char *path);
+void bus_unit_invalidate_property_cache(Unit *u);
+void bus_job_invalidate_property_cache(Job *j);
+
 uint64_t manager_bus_n_queued_write(Manager *m);
 
 void dump_bus_properties(FILE *f);
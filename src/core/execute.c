@@ -3285,6 +3285,101 @@ finalize:
         return r;
 }
 
+static bool exec_may_reuse_mount_namespace(
+                const Unit *u,
+                ExecCommandFlags command_flags,
+                const ExecContext *context,
+                const ExecParameters *params,
+                const ExecRuntime *runtime) {
+
+        assert(u);
+        assert(context);
+        assert(params);
+
+        if (!context->reuse_mount_namespace)
+                return false;
+
+        /* The runtime might be shared with other units via JoinsNamespaceOf=, whose settings differ */
+        if (!runtime || runtime->mntns_storage_socket[0] < 0 || !streq_ptr(runtime->id, u->id))
+                return false;
+
+        /* Only share the namespace between processes it would be set up identically for: commands that run
+         * with the full sandbox, and not just the one that gets the credentials mounted. */
+        if (!FLAGS_SET(params->flags, EXEC_APPLY_SANDBOXING|EXEC_APPLY_CHROOT) ||
+            FLAGS_SET(command_flags, EXEC_COMMAND_FULLY_PRIVILEGED))
+                return false;
+
+        if (exec_context_has_credentials(context))
+                return false;
+
+        /* With PrivateUsers= the mount namespace would be owned by a user namespace that later processes
+         * are not part of. */
+        if (context->private_users)
+                return false;
+
+        return true;
+}
+
+static int apply_shareable_mount_namespace(
+                const Unit *u,
+                ExecCommandFlags command_flags,
+                const ExecContext *context,
+                const ExecParameters *params,
+                const ExecRuntime *runtime,
+                char **error_path) {
+
+        _cleanup_close_ int ns = -1;
+        int r, q;
+
+        assert(runtime);
+        assert(runtime->mntns_storage_socket[0] >= 0);
+        assert(runtime->mntns_storage_socket[1] >= 0);
+
+        /* Works like setup_shareable_ns(): the first process of the unit sets up the mount namespace and
+         * stores a reference to it in the socket pair, all later ones just join it, which is a lot cheaper
+         * than building it from scratch again. */
+
+        if (lockf(runtime->mntns_storage_socket[0], F_LOCK, 0) < 0)
+                return -errno;
+
+        ns = receive_one_fd(runtime->mntns_storage_socket[0], MSG_DONTWAIT);
+        if (ns == -EAGAIN) {
+                r = apply_mount_namespace(u, command_flags, context, params, runtime, error_path);
+                if (r < 0)
+                        goto fail;
+
+                ns = open("/proc/self/ns/mnt", O_RDONLY|O_CLOEXEC|O_NOCTTY);
+                if (ns < 0) {
+                        r = -errno;
+                        goto fail;
+                }
+
+                r = 1;
+
+        } else if (ns < 0) {
+                r = ns;
+                goto fail;
+
+        } else {
+                /* This also changes our root and working directory to the ones of the namespace */
+                if (setns(ns, CLONE_NEWNS) < 0) {
+                        r = -errno;
+                        goto fail;
+                }
+
+                log_unit_debug(u, "Joined previously set up mount namespace.");
+                r = 0;
+        }
+
+        q = send_one_fd(runtime->mntns_storage_socket[1], ns, MSG_DONTWAIT);
+        if (q < 0)
+                r = q;
+
+fail:
+        (void) lockf(runtime->mntns_storage_socket[0], F_ULOCK, 0);
+        return r;
+}
+
 static int apply_working_directory(
                 const ExecContext *context,
                 const ExecParameters *params,
@@ -3470,7 +3565,7 @@ static int close_remaining_fds(
                 const int *fds, size_t n_fds) {
 
         size_t n_dont_close = 0;
-        int dont_close[n_fds + 12];
+        int dont_close[n_fds + 14];
 
         assert(params);
 
@@ -3491,6 +3586,7 @@ static int close_remaining_fds(
         if (runtime) {
                 append_socket_pair(dont_close, &n_dont_close, runtime->netns_storage_socket);
                 append_socket_pair(dont_close, &n_dont_close, runtime->ipcns_storage_socket);
+                append_socket_pair(dont_close, &n_dont_close, runtime->mntns_storage_socket);
         }
 
         if (dcreds) {
@@ -4256,7 +4352,10 @@ static int exec_child(
         if (needs_mount_namespace) {
                 _cleanup_free_ char *error_path = NULL;
 
-                r = apply_mount_namespace(unit, command->flags, context, params, runtime, &error_path);
+                if (exec_may_reuse_mount_namespace(unit, command->flags, context, params, runtime))
+                        r = apply_shareable_mount_namespace(unit, command->flags, context, params, runtime, &error_path);
+                else
+                        r = apply_mount_namespace(unit, command->flags, context, params, runtime, &error_path);
                 if (r < 0) {
                         *exit_status = EXIT_NAMESPACE;
                         return log_unit_error_errno(unit, r, "Failed to set up mount namespacing%s%s: %m",
@@ -4763,6 +4862,9 @@ int exec_spawn(Unit *unit,
                 }
         }
 
+        /* Note that this needs to be a real fork(), not vfork() or clone(CLONE_VM): exec_child() allocates
+         * memory, modifies the environment, talks to NSS and PAM, logs, and might even fork again
+         * (PAM), all of which would corrupt our own state if the address space was shared. */
         pid = fork();
         if (pid < 0)
                 return log_unit_error_errno(unit, errno, "Failed to fork: %m");
@@ -6100,6 +6202,7 @@ static ExecRuntime* exec_runtime_free(ExecRuntime *rt, bool destroy) {
         rt->var_tmp_dir = mfree(rt->var_tmp_dir);
         safe_close_pair(rt->netns_storage_socket);
         safe_close_pair(rt->ipcns_storage_socket);
+        safe_close_pair(rt->mntns_storage_socket);
         return mfree(rt);
 }
 
@@ -6125,6 +6228,7 @@ static int exec_runtime_allocate(ExecRuntime **ret, const char *id) {
                 .id = TAKE_PTR(id_copy),
                 .netns_storage_socket = { -1, -1 },
                 .ipcns_storage_socket = { -1, -1 },
+                .mntns_storage_socket = { -1, -1 },
         };
 
         *ret = n;
@@ -6138,6 +6242,7 @@ static int exec_runtime_add(
                 char **var_tmp_dir,
                 int netns_storage_socket[2],
                 int ipcns_storage_socket[2],
+                int mntns_storage_socket[2],
                 ExecRuntime **ret) {
 
         _cleanup_(exec_runtime_freep) ExecRuntime *rt = NULL;
@@ -6146,7 +6251,7 @@ static int exec_runtime_add(
         assert(m);
         assert(id);
 
-        /* tmp_dir, var_tmp_dir, {net,ipc}ns_storage_socket fds are donated on success */
+        /* tmp_dir, var_tmp_dir, {net,ipc,mnt}ns_storage_socket fds are donated on success */
 
         r = exec_runtime_allocate(&rt, id);
         if (r < 0)
@@ -6170,6 +6275,11 @@ static int exec_runtime_add(
                 rt->ipcns_storage_socket[1] = TAKE_FD(ipcns_storage_socket[1]);
         }
 
+        if (mntns_storage_socket) {
+                rt->mntns_storage_socket[0] = TAKE_FD(mntns_storage_socket[0]);
+                rt->mntns_storage_socket[1] = TAKE_FD(mntns_storage_socket[1]);
+        }
+
         rt->manager = m;
 
         if (ret)
@@ -6186,7 +6296,8 @@ static int exec_runtime_make(
                 ExecRuntime **ret) {
 
         _cleanup_(namespace_cleanup_tmpdirp) char *tmp_dir = NULL, *var_tmp_dir = NULL;
-        _cleanup_close_pair_ int netns_storage_socket[2] = { -1, -1 }, ipcns_storage_socket[2] = { -1, -1 };
+        _cleanup_close_pair_ int netns_storage_socket[2] = { -1, -1 }, ipcns_storage_socket[2] = { -1, -1 },
+                mntns_storage_socket[2] = { -1, -1 };
         int r;
 
         assert(m);
@@ -6194,7 +6305,8 @@ static int exec_runtime_make(
         assert(id);
 
         /* It is not necessary to create ExecRuntime object. */
-        if (!c->private_network && !c->private_ipc && !c->private_tmp && !c->network_namespace_path) {
+        if (!c->private_network && !c->private_ipc && !c->private_tmp && !c->network_namespace_path &&
+            !c->reuse_mount_namespace) {
                 *ret = NULL;
                 return 0;
         }
@@ -6218,7 +6330,12 @@ static int exec_runtime_make(
                         return -errno;
         }
 
-        r = exec_runtime_add(m, id, &tmp_dir, &var_tmp_dir, netns_storage_socket, ipcns_storage_socket, ret);
+        if (c->reuse_mount_namespace) {
+                if (socketpair(AF_UNIX, SOCK_DGRAM|SOCK_CLOEXEC, 0, mntns_storage_socket) < 0)
+                        return -errno;
+        }
+
+        r = exec_runtime_add(m, id, &tmp_dir, &var_tmp_dir, netns_storage_socket, ipcns_storage_socket, mntns_storage_socket, ret);
         if (r < 0)
                 return r;
 
@@ -6565,7 +6682,9 @@ int exec_runtime_deserialize_one(Manager *m, const char *value, FDSet *fds) {
         }
 
 finalize:
-        r = exec_runtime_add(m, id, &tmp_dir, &var_tmp_dir, netns_fdpair, ipcns_fdpair, NULL);
+        /* The mount namespace is not serialized on purpose: the unit's settings might have changed, hence
+         * let's rather set up a new one on the next invocation. */
+        r = exec_runtime_add(m, id, &tmp_dir, &var_tmp_dir, netns_fdpair, ipcns_fdpair, NULL, NULL);
         if (r < 0)
                 return log_debug_errno(r, "Failed to add exec-runtime: %m");
         return 0;
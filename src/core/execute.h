@@ -120,6 +120,10 @@ struct ExecRuntime {
 
         /* Like netns_storage_socket, but the file descriptor is referring to the IPC namespace. */
         int ipcns_storage_socket[2];
+
+        /* Like netns_storage_socket, but the file descriptor is referring to the mount namespace set up
+         * for the first process of the unit, which is joined by later ones if ReuseMountNamespace= is on. */
+        int mntns_storage_socket[2];
 };
 
 typedef enum ExecDirectoryType {
@@ -284,6 +288,7 @@ struct ExecContext {
         bool private_users;
         bool private_mounts;
         bool private_ipc;
+        bool reuse_mount_namespace;
         bool protect_kernel_tunables;
         bool protect_kernel_modules;
         bool protect_kernel_logs;
@@ -100,6 +100,7 @@ Job* job_free(Job *j) {
         assert(!j->object_list);
 
         job_unlink(j);
+        bus_job_invalidate_property_cache(j);
 
         sd_bus_track_unref(j->bus_track);
         strv_free(j->deserialized_clients);
@@ -967,6 +968,41 @@ static void job_fail_dependencies(Unit *u, UnitDependency d) {
         }
 }
 
+static void job_log_finished(Job *j, JobResult result) {
+        char waiting_buf[FORMAT_TIMESPAN_MAX], running_buf[FORMAT_TIMESPAN_MAX];
+        usec_t n, waiting = 0, running = 0;
+
+        assert(j);
+
+        if (!DEBUG_LOGGING)
+                return;
+
+        /* Splits the lifetime of the job into the time it spent waiting for the jobs it is ordered
+         * after, and the time it spent running, i.e. until the unit reached its new state. Both end up
+         * in the journal as separate fields too, so that boot profiling tools can pick them up. */
+
+        n = now(CLOCK_MONOTONIC);
+        if (timestamp_is_set(j->begin_running_usec)) {
+                running = usec_sub_unsigned(n, j->begin_running_usec);
+                if (timestamp_is_set(j->begin_usec))
+                        waiting = usec_sub_unsigned(j->begin_running_usec, j->begin_usec);
+        } else if (timestamp_is_set(j->begin_usec))
+                waiting = usec_sub_unsigned(n, j->begin_usec);
+
+        log_struct(LOG_DEBUG,
+                   LOG_UNIT_MESSAGE(j->unit, "Job %" PRIu32 " %s/%s finished, result=%s, waited %s, ran %s",
+                                    j->id, j->unit->id, job_type_to_string(j->type), job_result_to_string(result),
+                                    format_timespan(waiting_buf, sizeof waiting_buf, waiting, USEC_PER_MSEC),
+                                    format_timespan(running_buf, sizeof running_buf, running, USEC_PER_MSEC)),
+                   "JOB_ID=%" PRIu32, j->id,
+                   "JOB_TYPE=%s", job_type_to_string(j->type),
+                   "JOB_RESULT=%s", job_result_to_string(result),
+                   "JOB_WAITING_USEC=" USEC_FMT, waiting,
+                   "JOB_RUNNING_USEC=" USEC_FMT, running,
+                   LOG_UNIT_ID(j->unit),
+                   LOG_UNIT_INVOCATION_ID(j->unit));
+}
+
 int job_finish_and_invalidate(Job *j, JobResult result, bool recursive, bool already) {
         Unit *u;
         Unit *other;
@@ -982,8 +1018,7 @@ int job_finish_and_invalidate(Job *j, JobResult result, bool recursive, bool alr
 
         j->result = result;
 
-        log_unit_debug(u, "Job %" PRIu32 " %s/%s finished, result=%s",
-                       j->id, u->id, job_type_to_string(t), job_result_to_string(result));
+        job_log_finished(j, result);
 
         /* If this job did nothing to the respective unit we don't log the status message */
         if (!already)
@@ -1174,6 +1209,9 @@ void job_add_to_dbus_queue(Job *j) {
         assert(j);
         assert(j->installed);
 
+        /* The job type is constant on the bus, but may change when jobs are merged */
+        bus_job_invalidate_property_cache(j);
+
         if (j->in_dbus_queue)
                 return;
 
@@ -104,13 +104,9 @@ int unit_load_dropin(Unit *u) {
         if (r <= 0)
                 return 0;
 
-        if (!u->dropin_paths)
-                u->dropin_paths = TAKE_PTR(l);
-        else {
-                r = strv_extend_strv(&u->dropin_paths, l, true);
-                if (r < 0)
-                        return log_oom();
-        }
+        r = unit_add_dropin_paths(u, l);
+        if (r < 0)
+                return log_oom();
 
         u->dropin_mtime = 0;
         STRV_FOREACH(f, u->dropin_paths)
@@ -27,6 +27,7 @@
 #include "capability-util.h"
 #include "cgroup-util.h"
 #include "clock-util.h"
+#include "conf-files.h"
 #include "conf-parser.h"
 #include "cpu-set-util.h"
 #include "dbus-manager.h"
@@ -161,6 +162,9 @@ static size_t arg_random_seed_size;
 /* A copy of the original environment block */
 static char **saved_env = NULL;
 
+/* The modification times of the configuration files when they were last parsed */
+static uint64_t config_timestamp_hash = 0;
+
 static int parse_configuration(const struct rlimit *saved_rlimit_nofile,
                                const struct rlimit *saved_rlimit_memlock);
 
@@ -194,6 +198,92 @@ static int manager_find_user_config_paths(char ***ret_files, char ***ret_dirs) {
         return 0;
 }
 
+static int manager_find_config_paths(char ***ret_files, char ***ret_dirs, const char **ret_suffix) {
+        _cleanup_strv_free_ char **files = NULL, **dirs = NULL;
+        int r;
+
+        if (arg_system) {
+                files = strv_new(PKGSYSCONFDIR "/system.conf");
+                dirs = strv_copy(CONF_PATHS_STRV("systemd"));
+                if (!files || !dirs)
+                        return -ENOMEM;
+
+                *ret_suffix = "system.conf.d";
+        } else {
+                r = manager_find_user_config_paths(&files, &dirs);
+                if (r < 0)
+                        return r;
+
+                *ret_suffix = "user.conf.d";
+        }
+
+        *ret_files = TAKE_PTR(files);
+        *ret_dirs = TAKE_PTR(dirs);
+        return 0;
+}
+
+#define CONFIG_HASH_KEY SD_ID128_MAKE(6f,0e,93,d2,1a,c4,47,58,b3,7d,29,e1,84,5c,0a,f6)
+
+static int manager_config_timestamp_hash(uint64_t *ret) {
+        _cleanup_strv_free_ char **files = NULL, **dirs = NULL, **dropin_dirs = NULL, **dropins = NULL;
+        struct siphash state;
+        const char *suffix;
+        char **f;
+        int r;
+
+        assert(ret);
+
+        /* Hashes the names and modification times of all configuration files parse_config_file() reads, so
+         * that ReloadIfChanged() can tell whether they changed. */
+
+        r = manager_find_config_paths(&files, &dirs, &suffix);
+        if (r < 0)
+                return r;
+
+        r = strv_extend_strv_concat(&dropin_dirs, dirs, strjoina("/", suffix));
+        if (r < 0)
+                return r;
+
+        r = conf_files_list_strv(&dropins, ".conf", NULL, 0, (const char* const*) dropin_dirs);
+        if (r < 0)
+                return r;
+
+        r = strv_extend_strv(&files, dropins, false);
+        if (r < 0)
+                return r;
+
+        siphash24_init(&state, CONFIG_HASH_KEY.bytes);
+
+        STRV_FOREACH(f, files) {
+                struct stat st;
+
+                if (stat(*f, &st) < 0) {
+                        if (errno == ENOENT)
+                                continue;
+
+                        return -errno;
+                }
+
+                siphash24_compress_string(*f, &state);
+                siphash24_compress_usec_t(timespec_load(&st.st_mtim), &state);
+        }
+
+        *ret = siphash24_finalize(&state);
+        return 0;
+}
+
+static bool manager_config_changed(void) {
+        uint64_t hash;
+
+        if (config_timestamp_hash == 0)
+                return true;
+
+        if (manager_config_timestamp_hash(&hash) < 0)
+                return true;
+
+        return hash != config_timestamp_hash;
+}
+
 _noreturn_ static void freeze_or_exit_or_reboot(void) {
 
         /* If we are running in a container, let's prefer exiting, after all we can propagate an exit code to
@@ -703,19 +793,17 @@ static int parse_config_file(void) {
         const char *suffix;
         int r;
 
-        if (arg_system)
-                suffix = "system.conf.d";
-        else {
-                r = manager_find_user_config_paths(&files, &dirs);
-                if (r < 0)
-                        return log_error_errno(r, "Failed to determine config file paths: %m");
+        r = manager_find_config_paths(&files, &dirs, &suffix);
+        if (r < 0)
+                return log_error_errno(r, "Failed to determine config file paths: %m");
 
-                suffix = "user.conf.d";
-        }
+        /* Determine this before parsing, so that concurrent modifications are caught next time */
+        if (manager_config_timestamp_hash(&config_timestamp_hash) < 0)
+                config_timestamp_hash = 0;
 
         (void) config_parse_many(
-                        (const char* const*) (files ?: STRV_MAKE(PKGSYSCONFDIR "/system.conf")),
-                        (const char* const*) (dirs ?: CONF_PATHS_STRV("systemd")),
+                        (const char* const*) files,
+                        (const char* const*) dirs,
                         suffix,
                         "Manager\0",
                         config_item_table_lookup, items,
@@ -1881,6 +1969,18 @@ static int invoke_main_loop(
                         LogTarget saved_log_target;
                         int saved_log_level;
 
+                        if (m->reload_if_changed) {
+                                m->reload_if_changed = false;
+
+                                if (!manager_config_changed() && manager_reload_needed(m) == 0) {
+                                        log_info("Nothing changed, not reloading.");
+
+                                        m->objective = MANAGER_OK;
+                                        (void) bus_send_pending_reload_message(m);
+                                        break;
+                                }
+                        }
+
                         log_info("Reloading.");
 
                         /* First, save any overridden log level/target, then parse the configuration file, which might
@@ -3,6 +3,9 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <linux/kd.h>
+#if HAVE_MALLINFO2
+#include <malloc.h>
+#endif
 #include <sys/epoll.h>
 #include <sys/inotify.h>
 #include <sys/ioctl.h>
@@ -39,6 +42,7 @@
 #include "dirent-util.h"
 #include "env-util.h"
 #include "escape.h"
+#include "event-util.h"
 #include "exec-util.h"
 #include "execute.h"
 #include "exit-status.h"
@@ -78,6 +82,7 @@
 #include "syslog-util.h"
 #include "terminal-util.h"
 #include "time-util.h"
+#include "tmpfile-util.h"
 #include "transaction.h"
 #include "umask-util.h"
 #include "unit-name.h"
@@ -102,6 +107,11 @@
 /* How many units and jobs to process of the bus queue before returning to the event loop. */
 #define MANAGER_BUS_MESSAGE_BUDGET 100U
 
+/* How long to spend sweeping the unit GC queue before returning to the event loop, and how many units to sweep
+ * between checking the clock. */
+#define MANAGER_GC_UNIT_BUDGET_USEC (5*USEC_PER_MSEC)
+#define MANAGER_GC_UNIT_CHECK_INTERVAL 32U
+
 static int manager_dispatch_notify_fd(sd_event_source *source, int fd, uint32_t revents, void *userdata);
 static int manager_dispatch_cgroups_agent_fd(sd_event_source *source, int fd, uint32_t revents, void *userdata);
 static int manager_dispatch_signal_fd(sd_event_source *source, int fd, uint32_t revents, void *userdata);
@@ -701,6 +711,35 @@ static void manager_free_unit_name_maps(Manager *m) {
         m->unit_cache_timestamp_hash = 0;
 }
 
+static void manager_update_unit_dirs_hashes(Manager *m) {
+        assert(m);
+
+        if (lookup_paths_generated_hash(&m->lookup_paths, &m->unit_cache_generated_hash) < 0)
+                m->unit_cache_generated_hash = 0;
+
+        if (lookup_paths_dirs_timestamp_hash(&m->lookup_paths, &m->unit_dirs_timestamp_hash) < 0)
+                m->unit_dirs_timestamp_hash = 0;
+}
+
+static bool manager_unit_name_maps_up_to_date(Manager *m, char **old_search_path) {
+        uint64_t old_generated_hash;
+
+        assert(m);
+
+        /* Checks whether the unit name maps built before a reload still reflect the unit directories. The
+         * search path must be the same, the directories we don't write ourselves must not have been modified,
+         * and the contents of those we do write (generator output in particular) must be the same again. */
+
+        old_generated_hash = m->unit_cache_generated_hash;
+        manager_update_unit_dirs_hashes(m);
+
+        return m->unit_id_map &&
+                old_generated_hash != 0 &&
+                old_generated_hash == m->unit_cache_generated_hash &&
+                strv_equal(old_search_path, m->lookup_paths.search_path) &&
+                lookup_paths_timestamp_hash_same(&m->lookup_paths, m->unit_cache_timestamp_hash, NULL);
+}
+
 static int manager_setup_run_queue(Manager *m) {
         int r;
 
@@ -1214,17 +1253,31 @@ good:
 
 static unsigned manager_dispatch_gc_unit_queue(Manager *m) {
         unsigned n = 0, gc_marker;
+        uint64_t iteration;
+        usec_t start, d;
         Unit *u;
 
         assert(m);
 
-        /* log_debug("Running GC..."); */
+        if (!m->gc_unit_queue)
+                return 0;
+
+        /* If the previous time slice ran out during this event loop iteration, let the event loop run first */
+        if (m->gc_unit_queue_yielded &&
+            sd_event_get_iteration(m->event, &iteration) >= 0 &&
+            iteration == m->gc_unit_queue_yield_iteration)
+                return 0;
+
+        m->gc_unit_queue_yielded = false;
 
+        /* Each time slice uses a new marker, since the units swept in an earlier one might have changed state
+         * since. This means some units might be swept more than once, but the results are always consistent. */
         m->gc_marker += _GC_OFFSET_MAX;
         if (m->gc_marker + _GC_OFFSET_MAX <= _GC_OFFSET_MAX)
                 m->gc_marker = 1;
 
         gc_marker = m->gc_marker;
+        start = now(CLOCK_MONOTONIC);
 
         while ((u = m->gc_unit_queue)) {
                 assert(u->in_gc_queue);
@@ -1243,8 +1296,25 @@ static unsigned manager_dispatch_gc_unit_queue(Manager *m) {
                         u->gc_marker = gc_marker + GC_OFFSET_BAD;
                         unit_add_to_cleanup_queue(u);
                 }
+
+                /* After mass destruction of units the queue might be very long, don't stall the event loop
+                 * for all of it. During reloads we want to finish quickly though, like the bus queue. */
+                if (n % MANAGER_GC_UNIT_CHECK_INTERVAL == 0 &&
+                    m->gc_unit_queue &&
+                    !MANAGER_IS_RELOADING(m) &&
+                    usec_sub_unsigned(now(CLOCK_MONOTONIC), start) >= MANAGER_GC_UNIT_BUDGET_USEC) {
+
+                        if (sd_event_get_iteration(m->event, &m->gc_unit_queue_yield_iteration) >= 0)
+                                m->gc_unit_queue_yielded = true;
+                        break;
+                }
         }
 
+        d = usec_sub_unsigned(now(CLOCK_MONOTONIC), start);
+        m->gc_unit_sweep_last_usec = d;
+        m->gc_unit_sweep_max_usec = MAX(m->gc_unit_sweep_max_usec, d);
+        m->n_gc_unit_swept += n;
+
         return n;
 }
 
@@ -1365,6 +1435,7 @@ Manager* manager_free(Manager *m) {
 
         hashmap_free(m->units);
         hashmap_free(m->units_by_invocation_id);
+        string_intern_table_free(m->interned_strings);
         hashmap_free(m->jobs);
         hashmap_free(m->watch_pids);
         hashmap_free(m->watch_bus);
@@ -1374,6 +1445,9 @@ Manager* manager_free(Manager *m) {
         set_free(m->startup_units);
         set_free(m->failed_units);
 
+        assert(hashmap_isempty(m->bpf_firewall_access_maps));
+        hashmap_free(m->bpf_firewall_access_maps);
+
         sd_event_source_unref(m->signal_event_source);
         sd_event_source_unref(m->sigchld_event_source);
         sd_event_source_unref(m->notify_event_source);
@@ -1399,6 +1473,7 @@ Manager* manager_free(Manager *m) {
         free(m->notify_socket);
 
         lookup_paths_free(&m->lookup_paths);
+        exec_dir_timing_free_many(m->generator_timings, m->n_generator_timings);
         strv_free(m->transient_environment);
         strv_free(m->client_environment);
 
@@ -1640,6 +1715,7 @@ int manager_startup(Manager *m, FILE *serialization, FDSet *fds) {
         manager_preset_all(m);
 
         lookup_paths_log(&m->lookup_paths);
+        manager_update_unit_dirs_hashes(m);
 
         {
                 /* This block is (optionally) done with the reloading counter bumped */
@@ -1693,6 +1769,11 @@ int manager_startup(Manager *m, FILE *serialization, FDSet *fds) {
                         log_warning_errno(r, "Failed to deserialized tracked clients, ignoring: %m");
                 m->deserialized_subscribed = strv_free(m->deserialized_subscribed);
 
+                r = bus_track_coldplug(m, &m->subscribed_units_changed, false, m->deserialized_subscribed_units_changed);
+                if (r < 0)
+                        log_warning_errno(r, "Failed to deserialized tracked UnitsChanged clients, ignoring: %m");
+                m->deserialized_subscribed_units_changed = strv_free(m->deserialized_subscribed_units_changed);
+
                 r = manager_varlink_init(m);
                 if (r < 0)
                         log_warning_errno(r, "Failed to set up Varlink server, ignoring: %m");
@@ -1723,7 +1804,9 @@ int manager_add_job(
                 sd_bus_error *error,
                 Job **ret) {
 
+        char buf[FORMAT_TIMESPAN_MAX];
         Transaction *tr;
+        usec_t ts;
         int r;
 
         assert(m);
@@ -1748,6 +1831,8 @@ int manager_add_job(
         if (!tr)
                 return -ENOMEM;
 
+        ts = now(CLOCK_MONOTONIC);
+
         r = transaction_add_job_and_dependencies(tr, type, unit, NULL, true, false,
                                                  IN_SET(mode, JOB_IGNORE_DEPENDENCIES, JOB_IGNORE_REQUIREMENTS),
                                                  mode == JOB_IGNORE_DEPENDENCIES, error);
@@ -1766,6 +1851,10 @@ int manager_add_job(
                         goto tr_abort;
         }
 
+        log_unit_debug(unit, "Built transaction for %s/%s with %u units in %s.",
+                       unit->id, job_type_to_string(type), hashmap_size(tr->jobs),
+                       format_timespan(buf, sizeof buf, usec_sub_unsigned(now(CLOCK_MONOTONIC), ts), 1));
+
         r = transaction_activate(tr, m, mode, affected_jobs, error);
         if (r < 0)
                 goto tr_abort;
@@ -1900,6 +1989,36 @@ static int manager_dispatch_target_deps_queue(Manager *m) {
         return r;
 }
 
+static void manager_prefetch_load_queue(Manager *m) {
+        Unit *u;
+
+        assert(m);
+
+        /* Ask the kernel to read the fragment files of all queued units into the page cache, so that on a cold
+         * cache the I/O for the later ones is already in flight while we are busy parsing the earlier ones. New
+         * units are always prepended to the queue, hence we can stop at the first unit we already covered. */
+
+        LIST_FOREACH(load_queue, u, m->load_queue) {
+                _cleanup_close_ int fd = -1;
+                const char *path;
+
+                if (u->load_prefetched)
+                        break;
+
+                u->load_prefetched = true;
+
+                path = hashmap_get(m->unit_id_map, u->id);
+                if (!path)
+                        continue;
+
+                fd = open(path, O_RDONLY|O_CLOEXEC|O_NOCTTY|O_NONBLOCK);
+                if (fd < 0)
+                        continue;
+
+                (void) posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+        }
+}
+
 unsigned manager_dispatch_load_queue(Manager *m) {
         Unit *u;
         unsigned n = 0;
@@ -1918,6 +2037,8 @@ unsigned manager_dispatch_load_queue(Manager *m) {
         while ((u = m->load_queue)) {
                 assert(u->in_load_queue);
 
+                manager_prefetch_load_queue(m);
+
                 unit_load(u);
                 n++;
         }
@@ -2102,6 +2223,84 @@ void manager_dump_units(Manager *s, FILE *f, const char *prefix) {
                         unit_dump(u, f, prefix);
 }
 
+static void manager_dump_gc_statistics(Manager *m, FILE *f, const char *prefix) {
+        char buf_last[FORMAT_TIMESPAN_MAX], buf_max[FORMAT_TIMESPAN_MAX];
+        unsigned n_queued = 0;
+        Unit *u;
+
+        assert(m);
+        assert(f);
+
+        LIST_FOREACH(gc_queue, u, m->gc_unit_queue)
+                n_queued++;
+
+        fprintf(f,
+                "%sUnit GC: %u units queued, %" PRIu64 " units swept, last sweep %s, longest sweep %s\n",
+                strempty(prefix),
+                n_queued,
+                m->n_gc_unit_swept,
+                format_timespan(buf_last, sizeof buf_last, m->gc_unit_sweep_last_usec, 1),
+                format_timespan(buf_max, sizeof buf_max, m->gc_unit_sweep_max_usec, 1));
+}
+
+static void manager_dump_memory_statistics(Manager *m, FILE *f, const char *prefix) {
+        char buf[FORMAT_BYTES_MAX];
+        unsigned n_jobs;
+
+        assert(m);
+        assert(f);
+
+        /* Shows the number of objects per subsystem, along with the memory their fixed-size part takes up,
+         * to find out which data structure grows with the number of units. */
+
+        for (UnitType t = 0; t < _UNIT_TYPE_MAX; t++) {
+                unsigned n = 0;
+                Unit *u;
+
+                LIST_FOREACH(units_by_type, u, m->units_by_type[t])
+                        n++;
+
+                if (n == 0)
+                        continue;
+
+                fprintf(f, "%sMemory %s units: %u units, %s\n",
+                        strempty(prefix),
+                        unit_type_to_string(t),
+                        n,
+                        strna(format_bytes(buf, sizeof buf, (uint64_t) n * unit_vtable[t]->object_size)));
+        }
+
+        n_jobs = hashmap_size(m->jobs);
+        fprintf(f, "%sMemory jobs: %u jobs, %s\n",
+                strempty(prefix),
+                n_jobs,
+                strna(format_bytes(buf, sizeof buf, (uint64_t) n_jobs * sizeof(Job))));
+
+        fprintf(f,
+                "%sMemory names: %u unit names, %u invocation IDs, %u watched bus names, %u watched PID entries, %u cgroups\n",
+                strempty(prefix),
+                hashmap_size(m->units),
+                hashmap_size(m->units_by_invocation_id),
+                hashmap_size(m->watch_bus),
+                hashmap_size(m->watch_pids),
+                hashmap_size(m->cgroup_unit));
+
+        fprintf(f, "%sMemory D-Bus: %u private connections\n",
+                strempty(prefix),
+                set_size(m->private_buses));
+
+#if HAVE_MALLINFO2
+        char buf_free[FORMAT_BYTES_MAX];
+        struct mallinfo2 mi;
+
+        mi = mallinfo2();
+        fprintf(f, "%sMemory allocated: %s in use, %s free in heap\n",
+                strempty(prefix),
+                strna(format_bytes(buf, sizeof buf, mi.uordblks + mi.hblkhd)),
+                strna(format_bytes(buf_free, sizeof buf_free, mi.fordblks)));
+#endif
+}
+
 void manager_dump(Manager *m, FILE *f, const char *prefix) {
         assert(m);
         assert(f);
@@ -2120,6 +2319,9 @@ void manager_dump(Manager *m, FILE *f, const char *prefix) {
 
         manager_dump_units(m, f, prefix);
         manager_dump_jobs(m, f, prefix);
+        manager_dump_gc_statistics(m, f, prefix);
+        manager_dump_memory_statistics(m, f, prefix);
+        event_dump_statistics(m->event, f, prefix);
 }
 
 int manager_get_dump_string(Manager *m, char **ret) {
@@ -2237,6 +2439,13 @@ static unsigned manager_dispatch_dbus_queue(Manager *m) {
                         budget--;
         }
 
+        /* All units that changed since the last time (including those whose signals were forced out
+         * early) are announced to the UnitsChanged subscribers in a single message. */
+        if (!ordered_set_isempty(m->pending_units_changed)) {
+                bus_manager_send_units_changed(m);
+                n++;
+        }
+
         while (budget != 0 && (j = m->dbus_job_queue)) {
                 assert(j->in_dbus_queue);
 
@@ -2339,10 +2548,38 @@ static void manager_invoke_notify_message(
         }
 }
 
-static int manager_dispatch_notify_fd(sd_event_source *source, int fd, uint32_t revents, void *userdata) {
+/* How many notification messages to process per wakeup at most */
+#define NOTIFY_BATCH_MAX 64U
+
+typedef struct NotifySender {
+        pid_t pid;
+        Unit *unit;          /* The unit whose cgroup the PID is in, if any */
+        bool watchdog_seen;  /* Did we already process a plain WATCHDOG=1 from it in this batch? */
+} NotifySender;
+
+static NotifySender* notify_sender_acquire(Manager *m, NotifySender *senders, size_t *n_senders, pid_t pid) {
+        assert(m);
+        assert(senders);
+        assert(n_senders);
+
+        for (size_t i = 0; i < *n_senders; i++)
+                if (senders[i].pid == pid)
+                        return senders + i;
+
+        /* Each message adds at most one sender, hence this cannot overflow */
+        assert(*n_senders < NOTIFY_BATCH_MAX);
+
+        senders[*n_senders] = (NotifySender) {
+                .pid = pid,
+                .unit = manager_get_unit_by_pid_cgroup(m, pid),
+        };
+
+        return senders + (*n_senders)++;
+}
+
+static int manager_dispatch_one_notify_message(Manager *m, NotifySender *senders, size_t *n_senders) {
 
         _cleanup_fdset_free_ FDSet *fds = NULL;
-        Manager *m = userdata;
         char buf[NOTIFY_BUFFER_MAX+1];
         struct iovec iovec = {
                 .iov_base = buf,
@@ -2361,6 +2598,7 @@ static int manager_dispatch_notify_fd(sd_event_source *source, int fd, uint32_t
         struct ucred *ucred = NULL;
         _cleanup_free_ Unit **array_copy = NULL;
         _cleanup_strv_free_ char **tags = NULL;
+        NotifySender *sender;
         Unit *u1, *u2, **array;
         int r, *fd_array = NULL;
         size_t n_fds = 0;
@@ -2368,16 +2606,10 @@ static int manager_dispatch_notify_fd(sd_event_source *source, int fd, uint32_t
         ssize_t n;
 
         assert(m);
-        assert(m->notify_fd == fd);
-
-        if (revents != EPOLLIN) {
-                log_warning("Got unexpected poll event for notify fd.");
-                return 0;
-        }
 
         n = recvmsg_safe(m->notify_fd, &msghdr, MSG_DONTWAIT|MSG_CMSG_CLOEXEC|MSG_TRUNC);
         if (IN_SET(n, -EAGAIN, -EINTR))
-                return 0; /* Spurious wakeup, try again */
+                return -EAGAIN; /* Nothing (more) to read, try again on the next wakeup */
         if (n == -EXFULL) {
                 log_warning("Got message with truncated control data (too many fds sent?), ignoring.");
                 return 0;
@@ -2445,11 +2677,22 @@ static int manager_dispatch_notify_fd(sd_event_source *source, int fd, uint32_t
         if (manager_process_barrier_fd(tags, fds))
                 return 0;
 
+        /* Resolving the cgroup of the sender requires a /proc access, hence do that only once per sender
+         * and batch. Services with a watchdog might send many pings in quick succession, processing more
+         * than one of them per batch has no effect. */
+        sender = notify_sender_acquire(m, senders, n_senders, ucred->pid);
+        if (fdset_isempty(fds) && strv_equal(tags, STRV_MAKE("WATCHDOG=1"))) {
+                if (sender->watchdog_seen)
+                        return 0;
+
+                sender->watchdog_seen = true;
+        }
+
         /* Increase the generation counter used for filtering out duplicate unit invocations. */
         m->notifygen++;
 
         /* Notify every unit that might be interested, which might be multiple. */
-        u1 = manager_get_unit_by_pid_cgroup(m, ucred->pid);
+        u1 = sender->unit;
         u2 = hashmap_get(m->watch_pids, PID_TO_PTR(ucred->pid));
         array = hashmap_get(m->watch_pids, PID_TO_PTR(-ucred->pid));
         if (array) {
@@ -2487,6 +2730,33 @@ static int manager_dispatch_notify_fd(sd_event_source *source, int fd, uint32_t
         return 0;
 }
 
+static int manager_dispatch_notify_fd(sd_event_source *source, int fd, uint32_t revents, void *userdata) {
+        NotifySender senders[NOTIFY_BATCH_MAX];
+        Manager *m = userdata;
+        size_t n_senders = 0;
+        int r;
+
+        assert(m);
+        assert(m->notify_fd == fd);
+
+        if (revents != EPOLLIN) {
+                log_warning("Got unexpected poll event for notify fd.");
+                return 0;
+        }
+
+        /* Handle a batch of messages per wakeup, so that a constant stream of notifications doesn't cost
+         * an event loop iteration each. The batch is bounded so that we don't starve other event sources. */
+        for (unsigned i = 0; i < NOTIFY_BATCH_MAX; i++) {
+                r = manager_dispatch_one_notify_message(m, senders, &n_senders);
+                if (r == -EAGAIN)
+                        break;
+                if (r < 0)
+                        return r;
+        }
+
+        return 0;
+}
+
 static void manager_invoke_sigchld_event(
                 Manager *m,
                 Unit *u,
@@ -2535,7 +2805,10 @@ static int manager_dispatch_sigchld(sd_event_source *source, void *userdata) {
                 _cleanup_free_ char *name = NULL;
                 Unit *u1, *u2, **array;
 
-                (void) get_process_comm(si.si_pid, &name);
+                /* Reading the process name is an extra /proc access per exited child, which adds up on
+                 * fork-heavy systems, hence only do it if we actually log it. */
+                if (DEBUG_LOGGING)
+                        (void) get_process_comm(si.si_pid, &name);
 
                 log_debug("Child "PID_FMT" (%s) died (code=%s, status=%i/%s)",
                           si.si_pid, strna(name),
@@ -2916,6 +3189,7 @@ static int manager_dispatch_jobs_in_progress(sd_event_source *source, usec_t use
 
 int manager_loop(Manager *m) {
         RateLimit rl = { .interval = 1*USEC_PER_SEC, .burst = 50000 };
+        usec_t cpu_last = USEC_INFINITY;
         int r;
 
         assert(m);
@@ -2929,7 +3203,13 @@ int manager_loop(Manager *m) {
                 return log_error_errno(r, "Failed to enable SIGCHLD event source: %m");
 
         while (m->objective == MANAGER_OK) {
-                usec_t wait_usec, watchdog_usec;
+                usec_t wait_usec, watchdog_usec, cpu;
+
+                /* Account the CPU time the previous iteration took */
+                cpu = now(CLOCK_THREAD_CPUTIME_ID);
+                if (cpu_last != USEC_INFINITY)
+                        metric_histogram_record(&m->loop_iterations, usec_sub_unsigned(cpu, cpu_last));
+                cpu_last = cpu;
 
                 watchdog_usec = manager_get_watchdog(m, WATCHDOG_RUNTIME);
                 if (m->runtime_watchdog_running)
@@ -2970,6 +3250,10 @@ int manager_loop(Manager *m) {
                 else
                         wait_usec = USEC_INFINITY;
 
+                /* If the GC yielded to the event loop, only process what is pending and come back to it */
+                if (m->gc_unit_queue)
+                        wait_usec = 0;
+
                 r = sd_event_run(m->event, wait_usec);
                 if (r < 0)
                         return log_error_errno(r, "Failed to run event loop: %m");
@@ -3290,6 +3574,7 @@ int manager_serialize(
         }
 
         bus_track_serialize(m->subscribed, f, "subscribed");
+        bus_track_serialize(m->subscribed_units_changed, f, "subscribed-units-changed");
 
         r = dynamic_user_serialize(m, f, fds);
         if (r < 0)
@@ -3726,6 +4011,11 @@ int manager_deserialize(Manager *m, FILE *f, FDSet *fds) {
                         if (strv_extend(&m->deserialized_subscribed, val) < 0)
                                 return -ENOMEM;
 
+                } else if ((val = startswith(l, "subscribed-units-changed="))) {
+
+                        if (strv_extend(&m->deserialized_subscribed_units_changed, val) < 0)
+                                return -ENOMEM;
+
                 } else {
                         ManagerTimestamp q;
 
@@ -3749,14 +4039,33 @@ int manager_deserialize(Manager *m, FILE *f, FDSet *fds) {
         return manager_deserialize_units(m, f, fds);
 }
 
+static void manager_log_reload_phase(const char *phase, usec_t *ts) {
+        char buf[FORMAT_TIMESPAN_MAX];
+        usec_t n;
+
+        assert(phase);
+        assert(ts);
+
+        if (!DEBUG_LOGGING)
+                return;
+
+        n = now(CLOCK_MONOTONIC);
+        log_debug("Reload: %s took %s.", phase, format_timespan(buf, sizeof buf, usec_sub_unsigned(n, *ts), 1));
+        *ts = n;
+}
+
 int manager_reload(Manager *m) {
         _cleanup_(manager_reloading_stopp) Manager *reloading = NULL;
         _cleanup_fdset_free_ FDSet *fds = NULL;
+        _cleanup_strv_free_ char **search_path = NULL;
         _cleanup_fclose_ FILE *f = NULL;
+        usec_t ts, start;
         int r;
 
         assert(m);
 
+        ts = start = now(CLOCK_MONOTONIC);
+
         r = manager_open_serialization(m, &f);
         if (r < 0)
                 return log_error_errno(r, "Failed to create serialization file: %m");
@@ -3775,6 +4084,8 @@ int manager_reload(Manager *m) {
         if (fseeko(f, 0, SEEK_SET) < 0)
                 return log_error_errno(errno, "Failed to seek to beginning of serialization: %m");
 
+        manager_log_reload_phase("serialization", &ts);
+
         /* 💀 This is the point of no return, from here on there is no way back. 💀 */
         reloading = NULL;
 
@@ -3785,13 +4096,17 @@ int manager_reload(Manager *m) {
          * it.*/
 
         manager_clear_jobs_and_units(m);
+        bus_invalidate_property_cache(m, NULL);
         lookup_paths_flush_generator(&m->lookup_paths);
+        search_path = TAKE_PTR(m->lookup_paths.search_path);
         lookup_paths_free(&m->lookup_paths);
         exec_runtime_vacuum(m);
         dynamic_user_vacuum(m, false);
         m->uid_refs = hashmap_free(m->uid_refs);
         m->gid_refs = hashmap_free(m->gid_refs);
 
+        manager_log_reload_phase("flushing units and jobs", &ts);
+
         r = lookup_paths_init(&m->lookup_paths, m->unit_file_scope, 0, NULL);
         if (r < 0)
                 log_warning_errno(r, "Failed to initialize path lookup table, ignoring: %m");
@@ -3799,15 +4114,24 @@ int manager_reload(Manager *m) {
         (void) manager_run_environment_generators(m);
         (void) manager_run_generators(m);
 
+        manager_log_reload_phase("running generators", &ts);
+
         lookup_paths_log(&m->lookup_paths);
 
-        /* We flushed out generated files, for which we don't watch mtime, so we should flush the old map. */
-        manager_free_unit_name_maps(m);
+        /* We flushed out generated files, for which we don't watch mtime. Building the name maps means reading
+         * all unit directories though, hence keep them if the generators put the same files in place again,
+         * and nothing else changed either. */
+        if (manager_unit_name_maps_up_to_date(m, search_path))
+                log_debug("Unit directories unchanged, reusing unit name maps.");
+        else
+                manager_free_unit_name_maps(m);
 
         /* First, enumerate what we can from kernel and suchlike */
         manager_enumerate_perpetual(m);
         manager_enumerate(m);
 
+        manager_log_reload_phase("enumeration", &ts);
+
         /* Second, deserialize our stored data */
         r = manager_deserialize(m, f, fds);
         if (r < 0)
@@ -3816,6 +4140,8 @@ int manager_reload(Manager *m) {
         /* We don't need the serialization anymore */
         f = safe_fclose(f);
 
+        manager_log_reload_phase("deserialization", &ts);
+
         /* Re-register notify_fd as event source, and set up other sockets/communication channels we might need */
         (void) manager_setup_notify(m);
         (void) manager_setup_cgroups_agent(m);
@@ -3827,8 +4153,11 @@ int manager_reload(Manager *m) {
         /* Clean up runtime objects no longer referenced */
         manager_vacuum(m);
 
+        manager_log_reload_phase("coldplugging", &ts);
+
         /* Clean up deserialized tracked clients */
         m->deserialized_subscribed = strv_free(m->deserialized_subscribed);
+        m->deserialized_subscribed_units_changed = strv_free(m->deserialized_subscribed_units_changed);
 
         /* Consider the reload process complete now. */
         assert(m->n_reloading > 0);
@@ -3841,6 +4170,10 @@ int manager_reload(Manager *m) {
 
         manager_ready(m);
 
+        m->n_reloads++;
+        m->reload_last_usec = usec_sub_unsigned(now(CLOCK_MONOTONIC), start);
+        m->reload_max_usec = MAX(m->reload_max_usec, m->reload_last_usec);
+
         m->send_reloading_done = true;
         return 0;
 }
@@ -4071,16 +4404,19 @@ static bool generator_path_any(const char* const* paths) {
         return found;
 }
 
-static int manager_run_environment_generators(Manager *m) {
+static int manager_execute_environment_generators(Manager *m, char ***env) {
         char **tmp = NULL; /* this is only used in the forked process, no cleanup here */
         _cleanup_strv_free_ char **paths = NULL;
         void* args[] = {
                 [STDOUT_GENERATE] = &tmp,
                 [STDOUT_COLLECT] = &tmp,
-                [STDOUT_CONSUME] = &m->transient_environment,
+                [STDOUT_CONSUME] = env,
         };
         int r;
 
+        assert(m);
+        assert(env);
+
         if (MANAGER_IS_TEST_RUN(m) && !(m->test_run_flags & MANAGER_TEST_RUN_ENV_GENERATORS))
                 return 0;
 
@@ -4098,9 +4434,52 @@ static int manager_run_environment_generators(Manager *m) {
         return r;
 }
 
+static int manager_run_environment_generators(Manager *m) {
+        return manager_execute_environment_generators(m, &m->transient_environment);
+}
+
+static void manager_execute_generators(
+                Manager *m,
+                char **paths,
+                const char *normal,
+                const char *early,
+                const char *late,
+                ExecDirTiming **ret_timings,
+                size_t *ret_n_timings) {
+
+        const char *argv[5];
+
+        assert(m);
+
+        argv[0] = NULL; /* Leave this empty, execute_directory() will fill something in */
+        argv[1] = normal;
+        argv[2] = early;
+        argv[3] = late;
+        argv[4] = NULL;
+
+        RUN_WITH_UMASK(0022)
+                (void) execute_directories_full((const char* const*) paths, DEFAULT_TIMEOUT_USEC, NULL, NULL,
+                                                (char**) argv, m->transient_environment,
+                                                EXEC_DIR_PARALLEL | EXEC_DIR_IGNORE_ERRORS | EXEC_DIR_SET_SYSTEMD_EXEC_PID,
+                                                ret_timings, ret_n_timings);
+}
+
+static void manager_log_generator_timings(Manager *m) {
+        char buf[FORMAT_TIMESPAN_MAX];
+
+        assert(m);
+
+        for (size_t i = 0; i < m->n_generator_timings; i++) {
+                const ExecDirTiming *t = m->generator_timings + i;
+
+                log_debug("Generator %s finished in %s.",
+                          t->path,
+                          format_timespan(buf, sizeof buf, usec_sub_unsigned(t->finish, t->start), USEC_PER_MSEC));
+        }
+}
+
 static int manager_run_generators(Manager *m) {
         _cleanup_strv_free_ char **paths = NULL;
-        const char *argv[5];
         int r;
 
         assert(m);
@@ -4121,17 +4500,16 @@ static int manager_run_generators(Manager *m) {
                 goto finish;
         }
 
-        argv[0] = NULL; /* Leave this empty, execute_directory() will fill something in */
-        argv[1] = m->lookup_paths.generator;
-        argv[2] = m->lookup_paths.generator_early;
-        argv[3] = m->lookup_paths.generator_late;
-        argv[4] = NULL;
-
-        RUN_WITH_UMASK(0022)
-                (void) execute_directories((const char* const*) paths, DEFAULT_TIMEOUT_USEC, NULL, NULL,
-                                           (char**) argv, m->transient_environment,
-                                           EXEC_DIR_PARALLEL | EXEC_DIR_IGNORE_ERRORS | EXEC_DIR_SET_SYSTEMD_EXEC_PID);
+        m->generator_timings = exec_dir_timing_free_many(m->generator_timings, m->n_generator_timings);
+        m->n_generator_timings = 0;
 
+        manager_execute_generators(m, paths,
+                                   m->lookup_paths.generator,
+                                   m->lookup_paths.generator_early,
+                                   m->lookup_paths.generator_late,
+                                   &m->generator_timings,
+                                   &m->n_generator_timings);
+        manager_log_generator_timings(m);
         r = 0;
 
 finish:
@@ -4139,6 +4517,206 @@ finish:
         return r;
 }
 
+#define GENERATOR_HASH_KEY SD_ID128_MAKE(b1,4c,2e,0f,5d,93,4a,67,8e,21,c6,75,0b,d8,3f,94)
+
+static int generator_output_hash(const char *path, const char *relpath, uint64_t *sum) {
+        _cleanup_closedir_ DIR *d = NULL;
+        struct dirent *de;
+        int r;
+
+        assert(path);
+        assert(sum);
+
+        /* Sums up the hashes of all files below 'path', covering relative paths, types, symlink targets and
+         * contents. Generators run in parallel, so the order in which the files are found doesn't matter. */
+
+        d = opendir(path);
+        if (!d) {
+                if (errno == ENOENT)
+                        return 0;
+
+                return -errno;
+        }
+
+        FOREACH_DIRENT(de, d, return -errno) {
+                _cleanup_free_ char *p = NULL, *q = NULL;
+                struct siphash state;
+                struct stat st;
+
+                p = path_join(path, de->d_name);
+                q = relpath ? path_join(relpath, de->d_name) : strdup(de->d_name);
+                if (!p || !q)
+                        return -ENOMEM;
+
+                if (fstatat(dirfd(d), de->d_name, &st, AT_SYMLINK_NOFOLLOW) < 0)
+                        return -errno;
+
+                siphash24_init(&state, GENERATOR_HASH_KEY.bytes);
+                siphash24_compress_string(q, &state);
+                siphash24_compress(&(mode_t) { st.st_mode & S_IFMT }, sizeof(mode_t), &state);
+
+                if (S_ISDIR(st.st_mode)) {
+                        r = generator_output_hash(p, q, sum);
+                        if (r < 0)
+                                return r;
+
+                } else if (S_ISLNK(st.st_mode)) {
+                        _cleanup_free_ char *target = NULL;
+
+                        r = readlinkat_malloc(dirfd(d), de->d_name, &target);
+                        if (r < 0)
+                                return r;
+
+                        siphash24_compress_string(target, &state);
+
+                } else if (S_ISREG(st.st_mode)) {
+                        _cleanup_free_ char *contents = NULL;
+                        size_t size;
+
+                        r = read_full_file(p, &contents, &size);
+                        if (r < 0)
+                                return r;
+
+                        siphash24_compress(contents, size, &state);
+                }
+
+                *sum += siphash24_finalize(&state);
+        }
+
+        return 0;
+}
+
+static int generator_output_equal(const char *a, const char *b) {
+        uint64_t x = 0, y = 0;
+        int r;
+
+        r = generator_output_hash(a, NULL, &x);
+        if (r < 0)
+                return r;
+
+        r = generator_output_hash(b, NULL, &y);
+        if (r < 0)
+                return r;
+
+        return x == y;
+}
+
+static int manager_generators_changed(Manager *m) {
+        _cleanup_(rm_rf_physical_and_freep) char *t = NULL;
+        _cleanup_strv_free_ char **paths = NULL;
+        const char *normal, *early, *late;
+        int r;
+
+        assert(m);
+
+        /* Runs the generators into a temporary directory, and compares what they generate with what they
+         * generated last time. */
+
+        if (MANAGER_IS_TEST_RUN(m) && !(m->test_run_flags & MANAGER_TEST_RUN_GENERATORS))
+                return false;
+
+        if (!m->lookup_paths.generator || !m->lookup_paths.generator_early || !m->lookup_paths.generator_late)
+                return -EOPNOTSUPP;
+
+        paths = generator_binary_paths(m->unit_file_scope);
+        if (!paths)
+                return -ENOMEM;
+
+        r = tempfn_random(m->lookup_paths.generator, NULL, &t);
+        if (r < 0)
+                return r;
+
+        if (mkdir(t, 0755) < 0) {
+                t = mfree(t);
+                return -errno;
+        }
+
+        normal = prefix_roota(t, "normal");
+        early = prefix_roota(t, "early");
+        late = prefix_roota(t, "late");
+
+        if (mkdir(normal, 0755) < 0 || mkdir(early, 0755) < 0 || mkdir(late, 0755) < 0)
+                return -errno;
+
+        if (generator_path_any((const char* const*) paths))
+                manager_execute_generators(m, paths, normal, early, late, NULL, NULL);
+
+        r = generator_output_equal(m->lookup_paths.generator, normal);
+        if (r <= 0)
+                return r < 0 ? r : true;
+
+        r = generator_output_equal(m->lookup_paths.generator_early, early);
+        if (r <= 0)
+                return r < 0 ? r : true;
+
+        r = generator_output_equal(m->lookup_paths.generator_late, late);
+        if (r <= 0)
+                return r < 0 ? r : true;
+
+        return false;
+}
+
+static int manager_environment_generators_changed(Manager *m) {
+        _cleanup_strv_free_ char **env = NULL;
+        int r;
+
+        assert(m);
+
+        env = strv_copy(m->transient_environment);
+        if (!env)
+                return -ENOMEM;
+
+        r = manager_execute_environment_generators(m, &env);
+        if (r < 0)
+                return r;
+
+        return !strv_equal(env, m->transient_environment);
+}
+
+int manager_reload_needed(Manager *m) {
+        uint64_t hash;
+        Unit *u;
+        int r;
+
+        assert(m);
+
+        /* Checks whether a reload would change anything: whether any unit file, drop-in or unit directory
+         * changed since the last reload, or the generators now generate something else. Returns > 0 if so,
+         * and also if we can't tell. */
+
+        HASHMAP_FOREACH(u, m->units)
+                if (unit_need_daemon_reload(u)) {
+                        log_unit_debug(u, "Unit configuration changed on disk.");
+                        return true;
+                }
+
+        r = lookup_paths_dirs_timestamp_hash(&m->lookup_paths, &hash);
+        if (r < 0)
+                return log_debug_errno(r, "Failed to check unit directories for changes: %m");
+        if (hash != m->unit_dirs_timestamp_hash) {
+                log_debug("Unit directories changed.");
+                return true;
+        }
+
+        r = manager_environment_generators_changed(m);
+        if (r < 0)
+                return log_debug_errno(r, "Failed to check environment generators for changes: %m");
+        if (r > 0) {
+                log_debug("Output of environment generators changed.");
+                return true;
+        }
+
+        r = manager_generators_changed(m);
+        if (r < 0)
+                return log_debug_errno(r, "Failed to check generators for changes: %m");
+        if (r > 0) {
+                log_debug("Output of generators changed.");
+                return true;
+        }
+
+        return false;
+}
+
 int manager_transient_environment_add(Manager *m, char **plus) {
         char **a;
 
@@ -10,12 +10,16 @@
 
 #include "cgroup-util.h"
 #include "cgroup.h"
+#include "exec-util.h"
 #include "fdset.h"
 #include "hashmap.h"
 #include "ip-address-access.h"
 #include "list.h"
+#include "metrics.h"
+#include "ordered-set.h"
 #include "prioq.h"
 #include "ratelimit.h"
+#include "string-intern.h"
 #include "varlink.h"
 
 struct libmnt_monitor;
@@ -234,6 +238,11 @@ struct Manager {
         Hashmap *unit_name_map;
         Set *unit_path_cache;
         uint64_t unit_cache_timestamp_hash;
+        uint64_t unit_cache_generated_hash;
+        uint64_t unit_dirs_timestamp_hash;
+
+        /* Strings that many units refer to, e.g. the paths of drop-ins applying to all units of a type */
+        StringInternTable *interned_strings;
 
         char **transient_environment;  /* The environment, as determined from config files, kernel cmdline and environment generators */
         char **client_environment;     /* Environment variables created by clients through the bus API */
@@ -245,6 +254,10 @@ struct Manager {
 
         dual_timestamp timestamps[_MANAGER_TIMESTAMP_MAX];
 
+        /* Runtimes of the individual generators on the last startup or reload, in the order they finished */
+        ExecDirTiming *generator_timings;
+        size_t n_generator_timings;
+
         /* Data specific to the device subsystem */
         sd_device_monitor *device_monitor;
         Hashmap *devices_by_sysfs;
@@ -271,6 +284,13 @@ struct Manager {
         sd_bus_track *subscribed;
         char **deserialized_subscribed;
 
+        /* Clients that subscribed to the batched UnitsChanged signal instead, and the names of the units
+         * to announce in the next one. Unless they are also regular subscribers above, such clients do
+         * not cause the per-unit PropertiesChanged signals to be generated for them. */
+        sd_bus_track *subscribed_units_changed;
+        char **deserialized_subscribed_units_changed;
+        OrderedSet *pending_units_changed;
+
         /* This is used during reloading: before the reload we queue
          * the reply message here, and afterwards we send it */
         sd_bus_message *pending_reload_message;
@@ -279,12 +299,23 @@ struct Manager {
 
         bool send_reloading_done;
 
+        /* Set by ReloadIfChanged(): skip the reload if manager_reload_needed() says nothing changed */
+        bool reload_if_changed;
+
         uint32_t current_job_id;
         uint32_t default_unit_job_id;
 
         /* Data specific to the Automount subsystem */
         int dev_autofs_fd;
 
+        /* Data specific to the timer subsystem: calendar expression string => CalendarCacheEntry */
+        Hashmap *timer_calendar_cache;
+
+        /* BPF firewall access maps shared between units with identical address lists, keyed by a string
+         * representation of the lists. Entries are not owned by this hashmap, they remove themselves once
+         * the last unit lets go of them. */
+        Hashmap *bpf_firewall_access_maps;
+
         /* Data specific to the cgroup subsystem */
         Hashmap *cgroup_unit;
         CGroupMask cgroup_supported;
@@ -309,6 +340,14 @@ struct Manager {
 
         unsigned gc_marker;
 
+        /* Set when sweeping the unit GC queue ran out of its time slice, together with the event loop
+         * iteration that happened in, and statistics for the dump. */
+        bool gc_unit_queue_yielded;
+        uint64_t gc_unit_queue_yield_iteration;
+        uint64_t n_gc_unit_swept;
+        usec_t gc_unit_sweep_last_usec;
+        usec_t gc_unit_sweep_max_usec;
+
         /* The stat() data the last time we saw /etc/localtime */
         usec_t etc_localtime_mtime;
         bool etc_localtime_accessible;
@@ -377,6 +416,17 @@ struct Manager {
         unsigned n_installed_jobs;
         unsigned n_failed_jobs;
 
+        /* Statistics about the main loop and reloads, exposed via varlink. Main loop iterations are measured in
+         * CPU time, so that time spent waiting for events is not included. */
+        MetricHistogram loop_iterations;
+        unsigned n_reloads;
+        usec_t reload_last_usec;
+        usec_t reload_max_usec;
+
+        /* The last generation used when walking the job graph of a transaction, see
+         * transaction_next_generation() */
+        unsigned transaction_generation;
+
         /* Jobs in progress watching */
         unsigned n_running_jobs;
         unsigned n_on_console;
@@ -505,6 +555,7 @@ int manager_serialize(Manager *m, FILE *f, FDSet *fds, bool switching_root);
 int manager_deserialize(Manager *m, FILE *f, FDSet *fds);
 
 int manager_reload(Manager *m);
+int manager_reload_needed(Manager *m);
 
 void manager_reset_failed(Manager *m);
 
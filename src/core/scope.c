@@ -498,7 +498,7 @@ static int scope_deserialize_item(Unit *u, const char *key, const char *value, F
                 if (parse_pid(value, &pid) < 0)
                         log_unit_debug(u, "Failed to parse pids value: %s", value);
                 else {
-                        r = set_ensure_put(&u->pids, NULL, PID_TO_PTR(pid));
+                        r = set_ensure_put(&u->pids, &trivial_hash_ops_fast, PID_TO_PTR(pid));
                         if (r < 0)
                                 return r;
                 }
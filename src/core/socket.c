@@ -15,6 +15,7 @@
 #include "bus-error.h"
 #include "bus-util.h"
 #include "copy.h"
+#include "cpu-set-util.h"
 #include "dbus-socket.h"
 #include "dbus-unit.h"
 #include "def.h"
@@ -295,6 +296,53 @@ _pure_ static bool socket_has_exec(Socket *s) {
         return false;
 }
 
+static int socket_shard_ports(Socket *s) {
+        SocketPort *p;
+        int n;
+
+        assert(s);
+
+        /* With ShardListeners= we open one SO_REUSEPORT listening socket per CPU for each IP port, so that
+         * the kernel can spread incoming connections or datagrams across them instead of having all CPUs
+         * contend on a single socket queue. The copies are inserted next to the original port, hence the
+         * service gets them passed in the same order. */
+
+        if (!s->shard_listeners || s->accept)
+                return 0;
+
+        n = cpus_in_affinity_mask();
+        if (n < 0)
+                return log_unit_warning_errno(UNIT(s), n, "Failed to determine number of CPUs, not sharding listening sockets: %m");
+
+        LIST_FOREACH(port, p, s->ports) {
+                if (p->type != SOCKET_SOCKET)
+                        continue;
+
+                if (!IN_SET(socket_address_family(&p->address), AF_INET, AF_INET6))
+                        continue;
+
+                for (int i = 1; i < n; i++) {
+                        SocketPort *copy;
+
+                        copy = new(SocketPort, 1);
+                        if (!copy)
+                                return log_oom();
+
+                        *copy = (SocketPort) {
+                                .socket = s,
+                                .type = SOCKET_SOCKET,
+                                .fd = -1,
+                                .address = p->address,
+                        };
+
+                        LIST_INSERT_AFTER(port, s->ports, p, copy);
+                        p = copy;
+                }
+        }
+
+        return 0;
+}
+
 static int socket_add_extras(Socket *s) {
         Unit *u = UNIT(s);
         int r;
@@ -337,6 +385,10 @@ static int socket_add_extras(Socket *s) {
                         return r;
         }
 
+        r = socket_shard_ports(s);
+        if (r < 0)
+                return r;
+
         r = socket_add_mount_dependencies(s);
         if (r < 0)
                 return r;
@@ -408,6 +460,9 @@ static int socket_verify(Socket *s) {
         if (s->accept && have_non_accept_socket(s))
                 return log_unit_error_errno(UNIT(s), SYNTHETIC_ERRNO(ENOEXEC), "Unit configured for accepting sockets, but sockets are non-accepting. Refusing.");
 
+        if (s->accept && s->shard_listeners)
+                return log_unit_error_errno(UNIT(s), SYNTHETIC_ERRNO(ENOEXEC), "ShardListeners= is not supported for accepting sockets. Refusing.");
+
         if (s->accept && s->max_connections <= 0)
                 return log_unit_error_errno(UNIT(s), SYNTHETIC_ERRNO(ENOEXEC), "MaxConnection= setting too small. Refusing.");
 
@@ -698,6 +753,11 @@ static void socket_dump(Unit *u, FILE *f, const char *prefix) {
                         "%sReusePort: %s\n",
                          prefix, yes_no(s->reuse_port));
 
+        if (s->shard_listeners)
+                fprintf(f,
+                        "%sShardListeners: %s\n",
+                        prefix, yes_no(s->shard_listeners));
+
         if (s->smack)
                 fprintf(f,
                         "%sSmackLabel: %s\n",
@@ -1476,7 +1536,7 @@ static int socket_address_listen_do(
                         s->backlog,
                         s->bind_ipv6_only,
                         s->bind_to_device,
-                        s->reuse_port,
+                        s->reuse_port || s->shard_listeners,
                         s->free_bind,
                         s->transparent,
                         s->directory_mode,
@@ -2740,7 +2800,7 @@ static int socket_deserialize_item(Unit *u, const char *key, const char *value,
                         log_unit_debug(u, "Failed to parse socket value: %s", value);
                 else
                         LIST_FOREACH(port, p, s->ports)
-                                if (socket_address_is(&p->address, value+skip, type)) {
+                                if (p->fd < 0 && socket_address_is(&p->address, value+skip, type)) {
                                         socket_port_take_fd(p, fds, fd);
                                         break;
                                 }
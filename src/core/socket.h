@@ -146,6 +146,7 @@ struct Socket {
         char *bind_to_device;
         char *tcp_congestion;
         bool reuse_port;
+        bool shard_listeners;
         long mq_maxmsg;
         long mq_msgsize;
 
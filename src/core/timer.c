@@ -354,6 +354,71 @@ static void timer_enter_elapsed(Timer *t, bool leave_around) {
                 timer_enter_dead(t, TIMER_SUCCESS);
 }
 
+typedef struct CalendarCacheEntry {
+        usec_t base;             /* The time the next elapse was calculated from */
+        usec_t next;             /* The result, USEC_INFINITY if the expression won't elapse anymore */
+        usec_t localtime_mtime;  /* The mtime of /etc/localtime at the time of the calculation */
+} CalendarCacheEntry;
+
+static int timer_calendar_spec_next_usec(Manager *m, const CalendarSpec *spec, usec_t base, usec_t *ret) {
+        _cleanup_free_ CalendarCacheEntry *new_entry = NULL;
+        _cleanup_free_ char *key = NULL;
+        CalendarCacheEntry *e;
+        usec_t next;
+        int r;
+
+        assert(m);
+        assert(spec);
+        assert(ret);
+
+        /* Many timers tend to use the same calendar expressions, and calculating the next elapse is not
+         * cheap: it involves a lot of mktime() calls, and for expressions with a time zone even a fork().
+         * Hence remember the last result for each expression. For every base time between the one it was
+         * calculated from and the calculated elapse itself the result is the same, which covers timers
+         * that elapsed together as well as recalculations after clock changes. */
+
+        if (calendar_spec_to_string(spec, &key) < 0)
+                return calendar_spec_next_usec(spec, base, ret);
+
+        e = hashmap_get(m->timer_calendar_cache, key);
+        if (e && e->localtime_mtime == m->etc_localtime_mtime && base >= e->base && base < e->next) {
+                if (e->next == USEC_INFINITY)
+                        return -ENOENT;
+
+                *ret = e->next;
+                return 0;
+        }
+
+        r = calendar_spec_next_usec(spec, base, &next);
+        if (r == -ENOENT)
+                next = USEC_INFINITY;
+        else if (r < 0)
+                return r;
+
+        if (!e) {
+                /* Failing to cache the result is not fatal */
+                new_entry = new(CalendarCacheEntry, 1);
+                if (new_entry &&
+                    hashmap_ensure_put(&m->timer_calendar_cache, &string_hash_ops_free_free, key, new_entry) >= 0) {
+                        TAKE_PTR(key);
+                        e = TAKE_PTR(new_entry);
+                }
+        }
+
+        if (e)
+                *e = (CalendarCacheEntry) {
+                        .base = base,
+                        .next = next,
+                        .localtime_mtime = m->etc_localtime_mtime,
+                };
+
+        if (next == USEC_INFINITY)
+                return -ENOENT;
+
+        *ret = next;
+        return 0;
+}
+
 static void add_random(Timer *t, usec_t *v) {
         char s[FORMAT_TIMESPAN_MAX];
         usec_t add;
@@ -417,7 +482,7 @@ static void timer_enter_waiting(Timer *t, bool time_change) {
                                         b = ts.realtime;
                         }
 
-                        r = calendar_spec_next_usec(v->calendar_spec, b, &v->next_elapse);
+                        r = timer_calendar_spec_next_usec(UNIT(t)->manager, v->calendar_spec, b, &v->next_elapse);
                         if (r < 0)
                                 continue;
 
@@ -866,6 +931,12 @@ static void timer_timezone_change(Unit *u) {
         }
 }
 
+static void timer_shutdown(Manager *m) {
+        assert(m);
+
+        m->timer_calendar_cache = hashmap_free(m->timer_calendar_cache);
+}
+
 static int timer_clean(Unit *u, ExecCleanMask mask) {
         Timer *t = TIMER(u);
         int r;
@@ -959,5 +1030,7 @@ const UnitVTable timer_vtable = {
         .time_change = timer_time_change,
         .timezone_change = timer_timezone_change,
 
+        .shutdown = timer_shutdown,
+
         .bus_set_property = bus_timer_set_property,
 };
@@ -481,18 +481,39 @@ static int transaction_verify_order_one(Transaction *tr, Job *j, Job *from, unsi
         return 0;
 }
 
-static int transaction_verify_order(Transaction *tr, unsigned *generation, sd_bus_error *e) {
+static unsigned transaction_next_generation(Manager *m) {
+        Job *j;
+
+        assert(m);
+
+        /* The cycle detection looks at installed jobs too, so their generation counters must never match
+         * the one of a new walk of the graph by accident. Instead of resetting the counters of all
+         * installed jobs before each transaction, which is expensive if many jobs are queued, keep
+         * counting manager-wide, and only reset them when the counter wraps. 0 is never returned, as that's
+         * what new jobs start with. */
+
+        if (m->transaction_generation == UINT_MAX) {
+                HASHMAP_FOREACH(j, m->jobs)
+                        j->generation = 0;
+
+                m->transaction_generation = 0;
+        }
+
+        return ++m->transaction_generation;
+}
+
+static int transaction_verify_order(Transaction *tr, Manager *m, sd_bus_error *e) {
         Job *j;
         int r;
         unsigned g;
 
         assert(tr);
-        assert(generation);
+        assert(m);
 
         /* Check if the ordering graph is cyclic. If it is, try to fix
          * that up by dropping one of the jobs. */
 
-        g = (*generation)++;
+        g = transaction_next_generation(m);
 
         HASHMAP_FOREACH(j, tr->jobs) {
                 r = transaction_verify_order_one(tr, j, NULL, g, e);
@@ -508,7 +529,10 @@ static void transaction_collect_garbage(Transaction *tr) {
 
         assert(tr);
 
-        /* Drop jobs that are not required by any other job */
+        /* Drop jobs that are not required by any other job. A job without an object list has no
+         * dependencies that would be deleted along with it, so only the current entry is removed and we
+         * can continue iterating, instead of starting over for every job we collect. Jobs that become
+         * garbage only because of a job collected later in the same pass are picked up by the next one. */
 
         do {
                 Job *j;
@@ -523,7 +547,7 @@ static void transaction_collect_garbage(Transaction *tr) {
                                 log_trace("Garbage collecting job %s/%s", j->unit->id, job_type_to_string(j->type));
                                 transaction_delete_job(tr, j, true);
                                 again = true;
-                                break;
+                                continue;
                         }
 
                         log_trace("Keeping job %s/%s because of %s/%s",
@@ -697,23 +721,21 @@ int transaction_activate(
                 Set *affected_jobs,
                 sd_bus_error *e) {
 
-        Job *j;
+        char buf_order[FORMAT_TIMESPAN_MAX], buf_merge[FORMAT_TIMESPAN_MAX], buf_apply[FORMAT_TIMESPAN_MAX];
+        usec_t ts_start, ts_order, ts_merge, ts_apply;
+        unsigned n_jobs;
         int r;
-        unsigned generation = 1;
 
         assert(tr);
+        assert(m);
 
         /* This applies the changes recorded in tr->jobs to
          * the actual list of jobs, if possible. */
 
-        /* Reset the generation counter of all installed jobs. The detection of cycles
-         * looks at installed jobs. If they had a non-zero generation from some previous
-         * walk of the graph, the algorithm would break. */
-        HASHMAP_FOREACH(j, m->jobs)
-                j->generation = 0;
+        ts_start = now(CLOCK_MONOTONIC);
 
         /* First step: figure out which jobs matter */
-        transaction_find_jobs_that_matter_to_anchor(tr->anchor_job, generation++);
+        transaction_find_jobs_that_matter_to_anchor(tr->anchor_job, transaction_next_generation(m));
 
         /* Second step: Try not to stop any running services if
          * we don't have to. Don't try to reverse running
@@ -732,7 +754,7 @@ int transaction_activate(
 
                 /* Fifth step: verify order makes sense and correct
                  * cycles if necessary and possible */
-                r = transaction_verify_order(tr, &generation, e);
+                r = transaction_verify_order(tr, m, e);
                 if (r >= 0)
                         break;
 
@@ -743,6 +765,8 @@ int transaction_activate(
                  * graph is still cyclic... */
         }
 
+        ts_order = now(CLOCK_MONOTONIC);
+
         for (;;) {
                 /* Sixth step: let's drop unmergeable entries if
                  * necessary and possible, merge entries we can
@@ -771,6 +795,9 @@ int transaction_activate(
         if (r < 0)
                 return log_notice_errno(r, "Requested transaction contradicts existing jobs: %s", bus_error_message(e, r));
 
+        ts_merge = now(CLOCK_MONOTONIC);
+        n_jobs = hashmap_size(tr->jobs);
+
         /* Tenth step: apply changes */
         r = transaction_apply(tr, m, mode, affected_jobs);
         if (r < 0)
@@ -778,6 +805,15 @@ int transaction_activate(
 
         assert(hashmap_isempty(tr->jobs));
 
+        ts_apply = now(CLOCK_MONOTONIC);
+
+        log_unit_debug(tr->anchor_job->unit,
+                       "Activated transaction for %s/%s with %u jobs (ordering: %s, merging: %s, applying: %s).",
+                       tr->anchor_job->unit->id, job_type_to_string(tr->anchor_job->type), n_jobs,
+                       format_timespan(buf_order, sizeof buf_order, usec_sub_unsigned(ts_order, ts_start), 1),
+                       format_timespan(buf_merge, sizeof buf_merge, usec_sub_unsigned(ts_merge, ts_order), 1),
+                       format_timespan(buf_apply, sizeof buf_apply, usec_sub_unsigned(ts_apply, ts_merge), 1));
+
         if (!hashmap_isempty(m->jobs)) {
                 /* Are there any jobs now? Then make sure we have the
                  * idle pipe around. We don't really care too much
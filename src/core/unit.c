@@ -100,6 +100,7 @@ Unit* unit_new(Manager *m, size_t size) {
         u->on_failure_job_mode = JOB_REPLACE;
         u->cgroup_control_inotify_wd = -1;
         u->cgroup_memory_inotify_wd = -1;
+        u->cgroup_attribute_dir_fd = -1;
         u->job_timeout = USEC_INFINITY;
         u->job_running_timeout = USEC_INFINITY;
         u->ref_uid = UID_INVALID;
@@ -110,10 +111,6 @@ Unit* unit_new(Manager *m, size_t size) {
 
         u->ip_accounting_ingress_map_fd = -1;
         u->ip_accounting_egress_map_fd = -1;
-        u->ipv4_allow_map_fd = -1;
-        u->ipv6_allow_map_fd = -1;
-        u->ipv4_deny_map_fd = -1;
-        u->ipv6_deny_map_fd = -1;
 
         u->last_section_private = -1;
 
@@ -346,6 +343,7 @@ int unit_choose_id(Unit *u, const char *name) {
                 assert_se(set_remove(u->aliases, name)); /* see set_get() above… */
 
         u->id = s; /* Old u->id is now stored in the set, and s is not stored anywhere */
+        u->dbus_path = mfree(u->dbus_path);
         unit_add_to_dbus_queue(u);
 
         return 0;
@@ -443,6 +441,7 @@ void unit_add_to_load_queue(Unit *u) {
 
         LIST_PREPEND(load_queue, u->manager->load_queue, u);
         u->in_load_queue = true;
+        u->load_prefetched = false;
 }
 
 void unit_add_to_cleanup_queue(Unit *u) {
@@ -472,11 +471,16 @@ void unit_add_to_dbus_queue(Unit *u) {
         assert(u);
         assert(u->type != _UNIT_TYPE_INVALID);
 
+        /* Whatever changed might include properties we declared constant on the bus, such as the
+         * description. Do this before the shortcuts below, they are only about the signals. */
+        bus_unit_invalidate_property_cache(u);
+
         if (u->load_state == UNIT_STUB || u->in_dbus_queue)
                 return;
 
         /* Shortcut things if nobody cares */
         if (sd_bus_track_count(u->manager->subscribed) <= 0 &&
+            sd_bus_track_count(u->manager->subscribed_units_changed) <= 0 &&
             sd_bus_track_count(u->bus_track) <= 0 &&
             set_isempty(u->manager->private_buses)) {
                 u->sent_dbus_new_signal = true;
@@ -619,6 +623,7 @@ Unit* unit_free(Unit *u) {
                 unit_remove_transient(u);
 
         bus_unit_send_removed_signal(u);
+        bus_unit_invalidate_property_cache(u);
 
         unit_done(u);
 
@@ -708,10 +713,8 @@ Unit* unit_free(Unit *u) {
         safe_close(u->ip_accounting_ingress_map_fd);
         safe_close(u->ip_accounting_egress_map_fd);
 
-        safe_close(u->ipv4_allow_map_fd);
-        safe_close(u->ipv6_allow_map_fd);
-        safe_close(u->ipv4_deny_map_fd);
-        safe_close(u->ipv6_deny_map_fd);
+        bpf_firewall_access_maps_unref(u->ip_allow_maps);
+        bpf_firewall_access_maps_unref(u->ip_deny_maps);
 
         bpf_program_unref(u->ip_bpf_ingress);
         bpf_program_unref(u->ip_bpf_ingress_installed);
@@ -732,7 +735,7 @@ Unit* unit_free(Unit *u) {
         strv_free(u->documentation);
         free(u->fragment_path);
         free(u->source_path);
-        strv_free(u->dropin_paths);
+        strv_unintern(u->manager->interned_strings, u->dropin_paths);
         free(u->instance);
 
         free(u->job_timeout_reboot_arg);
@@ -740,6 +743,7 @@ Unit* unit_free(Unit *u) {
 
         set_free_free(u->aliases);
         free(u->id);
+        free(u->dbus_path);
 
         return mfree(u);
 }
@@ -2486,11 +2490,11 @@ int unit_watch_pid(Unit *u, pid_t pid, bool exclusive) {
         if (exclusive)
                 manager_unwatch_pid(u->manager, pid);
 
-        r = set_ensure_allocated(&u->pids, NULL);
+        r = set_ensure_allocated(&u->pids, &trivial_hash_ops_fast);
         if (r < 0)
                 return r;
 
-        r = hashmap_ensure_allocated(&u->manager->watch_pids, NULL);
+        r = hashmap_ensure_allocated(&u->manager->watch_pids, &trivial_hash_ops_fast);
         if (r < 0)
                 return r;
 
@@ -2968,7 +2972,15 @@ char *unit_dbus_path(Unit *u) {
         if (!u->id)
                 return NULL;
 
-        return unit_dbus_path_from_name(u->id);
+        /* The object path is needed for every property change signal and in every unit and job listing,
+         * hence escape the name only once and hand out copies. */
+        if (!u->dbus_path) {
+                u->dbus_path = unit_dbus_path_from_name(u->id);
+                if (!u->dbus_path)
+                        return NULL;
+        }
+
+        return strdup(u->dbus_path);
 }
 
 char *unit_dbus_path_invocation_id(Unit *u) {
@@ -4019,6 +4031,38 @@ char* unit_concat_strv(char **l, UnitWriteFlags flags) {
         return TAKE_PTR(result);
 }
 
+int unit_add_dropin_paths(Unit *u, char * const *paths) {
+        size_t n, allocated;
+        char * const *i;
+
+        assert(u);
+
+        /* Drop-in paths are interned: the drop-ins for a unit type (e.g. service.d/) or a prefix apply to many
+         * units, and there is no point in keeping a copy of their paths for each of them. Paths already
+         * listed are skipped. */
+
+        n = allocated = strv_length(u->dropin_paths);
+        if (!GREEDY_REALLOC(u->dropin_paths, allocated, n + strv_length((char**) paths) + 1))
+                return -ENOMEM;
+        u->dropin_paths[n] = NULL;
+
+        STRV_FOREACH(i, paths) {
+                const char *s;
+
+                if (strv_contains(u->dropin_paths, *i))
+                        continue;
+
+                s = string_intern(&u->manager->interned_strings, *i);
+                if (!s)
+                        return -ENOMEM;
+
+                u->dropin_paths[n++] = (char*) s;
+                u->dropin_paths[n] = NULL;
+        }
+
+        return 0;
+}
+
 int unit_write_setting(Unit *u, UnitWriteFlags flags, const char *name, const char *data) {
         _cleanup_free_ char *p = NULL, *q = NULL, *escaped = NULL;
         const char *dir, *wrapped;
@@ -4093,12 +4137,9 @@ int unit_write_setting(Unit *u, UnitWriteFlags flags, const char *name, const ch
         if (r < 0)
                 return r;
 
-        r = strv_push(&u->dropin_paths, q);
+        r = unit_add_dropin_paths(u, STRV_MAKE(q));
         if (r < 0)
                 return r;
-        q = NULL;
-
-        strv_uniq(u->dropin_paths);
 
         u->dropin_mtime = now(CLOCK_REALTIME);
 
@@ -4136,17 +4177,23 @@ int unit_make_transient(Unit *u) {
         if (!UNIT_VTABLE(u)->can_transient)
                 return -EOPNOTSUPP;
 
-        (void) mkdir_p_label(u->manager->lookup_paths.transient, 0755);
-
         path = path_join(u->manager->lookup_paths.transient, u->id);
         if (!path)
                 return -ENOMEM;
 
         /* Let's open the file we'll write the transient settings into. This file is kept open as long as we are
-         * creating the transient, and is closed in unit_load(), as soon as we start loading the file. */
+         * creating the transient, and is closed in unit_load(), as soon as we start loading the file.
+         *
+         * The directory exists pretty much always, except for the very first transient unit. Only create it
+         * if needed, since creating it with the right label for every transient unit adds up when clients
+         * create lots of them in short succession. */
 
         RUN_WITH_UMASK(0022) {
                 f = fopen(path, "we");
+                if (!f && errno == ENOENT) {
+                        (void) mkdir_p_label(u->manager->lookup_paths.transient, 0755);
+                        f = fopen(path, "we");
+                }
                 if (!f)
                         return -errno;
         }
@@ -4157,7 +4204,7 @@ int unit_make_transient(Unit *u) {
         free_and_replace(u->fragment_path, path);
 
         u->source_path = mfree(u->source_path);
-        u->dropin_paths = strv_free(u->dropin_paths);
+        u->dropin_paths = strv_unintern(u->manager->interned_strings, u->dropin_paths);
         u->fragment_mtime = u->source_mtime = u->dropin_mtime = 0;
 
         u->load_state = UNIT_STUB;
@@ -17,6 +17,7 @@
 #include "cgroup.h"
 
 typedef struct UnitRef UnitRef;
+typedef struct BPFFirewallAccessMaps BPFFirewallAccessMaps;
 
 typedef enum KillOperation {
         KILL_TERMINATE,
@@ -122,6 +123,7 @@ typedef struct Unit {
 
         char *id;   /* The one special name that we use for identification */
         char *instance;
+        char *dbus_path; /* The escaped D-Bus object path of 'id', built on first use, see unit_dbus_path() */
 
         Set *aliases; /* All the other names. */
 
@@ -137,7 +139,7 @@ typedef struct Unit {
 
         char *fragment_path; /* if loaded from a config file this is the primary path to it */
         char *source_path; /* if converted, the source file */
-        char **dropin_paths;
+        char **dropin_paths; /* interned in manager->interned_strings, see unit_add_dropin_paths() */
 
         usec_t fragment_not_found_timestamp_hash;
         usec_t fragment_mtime;
@@ -275,6 +277,8 @@ typedef struct Unit {
         uint64_t io_accounting_base[_CGROUP_IO_ACCOUNTING_METRIC_MAX];
         uint64_t io_accounting_last[_CGROUP_IO_ACCOUNTING_METRIC_MAX]; /* the most recently read value */
 
+        CGroupAccountingCache accounting_cache;
+
         /* Counterparts in the cgroup filesystem */
         char *cgroup_path;
         CGroupMask cgroup_realized_mask;           /* In which hierarchies does this unit's cgroup exist? (only relevant on cgroup v1) */
@@ -286,6 +290,13 @@ typedef struct Unit {
         int cgroup_control_inotify_wd;
         int cgroup_memory_inotify_wd;
 
+        /* The cgroup attributes we last wrote successfully (attribute name → value), so that unchanged
+         * ones are not written again when the cgroup is realized again. Flushed whenever the cgroup or the
+         * set of controllers enabled on it changes. */
+        Hashmap *cgroup_attributes;
+        /* An fd of the cgroup directory, only valid while cgroup_context_apply() runs on cgroup v2 */
+        int cgroup_attribute_dir_fd;
+
         /* Device Controller BPF program */
         BPFProgram *bpf_device_control_installed;
 
@@ -293,10 +304,8 @@ typedef struct Unit {
         int ip_accounting_ingress_map_fd;
         int ip_accounting_egress_map_fd;
 
-        int ipv4_allow_map_fd;
-        int ipv6_allow_map_fd;
-        int ipv4_deny_map_fd;
-        int ipv6_deny_map_fd;
+        BPFFirewallAccessMaps *ip_allow_maps;
+        BPFFirewallAccessMaps *ip_deny_maps;
 
         BPFProgram *ip_bpf_ingress, *ip_bpf_ingress_installed;
         BPFProgram *ip_bpf_egress, *ip_bpf_egress_installed;
@@ -360,6 +369,9 @@ typedef struct Unit {
         bool in_target_deps_queue:1;
         bool in_stop_when_unneeded_queue:1;
 
+        /* Whether we already asked the kernel to read ahead the fragment while in the load queue */
+        bool load_prefetched:1;
+
         bool sent_dbus_new_signal:1;
 
         bool job_running_timeout_set:1;
@@ -820,6 +832,7 @@ int unit_setup_dynamic_creds(Unit *u);
 char* unit_escape_setting(const char *s, UnitWriteFlags flags, char **buf);
 char* unit_concat_strv(char **l, UnitWriteFlags flags);
 
+int unit_add_dropin_paths(Unit *u, char * const *paths);
 int unit_write_setting(Unit *u, UnitWriteFlags flags, const char *name, const char *data);
 int unit_write_settingf(Unit *u, UnitWriteFlags mode, const char *name, const char *format, ...) _printf_(4,5);
 
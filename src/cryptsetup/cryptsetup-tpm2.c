@@ -1,14 +1,187 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
+#include "sd-id128.h"
+
 #include "alloc-util.h"
 #include "cryptsetup-tpm2.h"
 #include "fileio.h"
 #include "hexdecoct.h"
 #include "json.h"
+#include "memory-util.h"
+#include "missing_syscall.h"
 #include "parse-util.h"
 #include "random-util.h"
+#include "siphash24.h"
 #include "tpm2-util.h"
 
+/* Unsealed keys are cached only for a short time, just enough to cover the volumes unlocked during boot */
+#define TPM2_CACHE_TIMEOUT_USEC (2 * USEC_PER_MINUTE)
+
+#define TPM2_CACHE_HASH_KEY SD_ID128_MAKE(4e,a1,13,4c,2d,95,4b,57,8f,02,b5,4c,9a,c8,1e,73)
+
+/* The cached record: this header, followed by the sealed blob, the policy hash and the unsealed key. The
+ * key name is derived from a hash of the sealed data only, hence the sealed data is stored too, and compared
+ * when looking a cached key up. */
+typedef struct Tpm2CacheHeader {
+        uint32_t pcr_mask;
+        uint32_t reserved;
+        uint64_t blob_size;
+        uint64_t policy_hash_size;
+        uint64_t key_size;
+} Tpm2CacheHeader;
+
+static int tpm2_cache_name(
+                uint32_t pcr_mask,
+                const void *blob,
+                size_t blob_size,
+                const void *policy_hash,
+                size_t policy_hash_size,
+                char **ret) {
+
+        struct siphash state;
+        uint64_t h;
+        char *n;
+
+        assert(blob);
+        assert(ret);
+
+        siphash24_init(&state, TPM2_CACHE_HASH_KEY.bytes);
+        siphash24_compress(&pcr_mask, sizeof(pcr_mask), &state);
+        siphash24_compress(blob, blob_size, &state);
+        if (policy_hash_size > 0)
+                siphash24_compress(policy_hash, policy_hash_size, &state);
+        h = siphash24_finalize(&state);
+
+        if (asprintf(&n, "cryptsetup-tpm2:%016" PRIx64, h) < 0)
+                return -ENOMEM;
+
+        *ret = n;
+        return 0;
+}
+
+static int tpm2_cache_lookup(
+                uint32_t pcr_mask,
+                const void *blob,
+                size_t blob_size,
+                const void *policy_hash,
+                size_t policy_hash_size,
+                void **ret_decrypted_key,
+                size_t *ret_decrypted_key_size) {
+
+        _cleanup_(erase_and_freep) uint8_t *p = NULL;
+        _cleanup_free_ char *name = NULL;
+        Tpm2CacheHeader h;
+        key_serial_t serial;
+        size_t m = 256;
+        void *key;
+        long n;
+        int r;
+
+        assert(ret_decrypted_key);
+        assert(ret_decrypted_key_size);
+
+        r = tpm2_cache_name(pcr_mask, blob, blob_size, policy_hash, policy_hash_size, &name);
+        if (r < 0)
+                return r;
+
+        serial = request_key("user", name, NULL, 0);
+        if (serial == -1)
+                return errno == ENOKEY ? 0 : -errno;
+
+        for (;;) {
+                p = new(uint8_t, m);
+                if (!p)
+                        return -ENOMEM;
+
+                n = keyctl(KEYCTL_READ, (unsigned long) serial, (unsigned long) p, (unsigned long) m, 0);
+                if (n < 0)
+                        return -errno;
+                if ((size_t) n <= m)
+                        break;
+
+                if (m > LONG_MAX / 2) /* overflow check */
+                        return -ENOMEM;
+
+                m *= 2;
+                p = erase_and_free(p);
+        }
+
+        if ((size_t) n < sizeof(h))
+                return 0;
+
+        memcpy(&h, p, sizeof(h));
+        if (h.pcr_mask != pcr_mask ||
+            h.blob_size != blob_size ||
+            h.policy_hash_size != policy_hash_size ||
+            sizeof(h) + blob_size + policy_hash_size + h.key_size != (size_t) n)
+                return 0;
+
+        /* Hash collision? Then this entry is not ours */
+        if (memcmp(p + sizeof(h), blob, blob_size) != 0 ||
+            memcmp_safe(p + sizeof(h) + blob_size, policy_hash, policy_hash_size) != 0)
+                return 0;
+
+        key = memdup(p + sizeof(h) + blob_size + policy_hash_size, h.key_size);
+        if (!key)
+                return -ENOMEM;
+
+        *ret_decrypted_key = key;
+        *ret_decrypted_key_size = h.key_size;
+        return 1;
+}
+
+static int tpm2_cache_add(
+                uint32_t pcr_mask,
+                const void *blob,
+                size_t blob_size,
+                const void *policy_hash,
+                size_t policy_hash_size,
+                const void *decrypted_key,
+                size_t decrypted_key_size) {
+
+        _cleanup_(erase_and_freep) uint8_t *p = NULL;
+        _cleanup_free_ char *name = NULL;
+        key_serial_t serial;
+        Tpm2CacheHeader h;
+        uint8_t *q;
+        size_t n;
+        int r;
+
+        r = tpm2_cache_name(pcr_mask, blob, blob_size, policy_hash, policy_hash_size, &name);
+        if (r < 0)
+                return r;
+
+        h = (Tpm2CacheHeader) {
+                .pcr_mask = pcr_mask,
+                .blob_size = blob_size,
+                .policy_hash_size = policy_hash_size,
+                .key_size = decrypted_key_size,
+        };
+
+        n = sizeof(h) + blob_size + policy_hash_size + decrypted_key_size;
+        p = new(uint8_t, n);
+        if (!p)
+                return -ENOMEM;
+
+        q = mempcpy(p, &h, sizeof(h));
+        q = mempcpy(q, blob, blob_size);
+        if (policy_hash_size > 0)
+                q = mempcpy(q, policy_hash, policy_hash_size);
+        memcpy(q, decrypted_key, decrypted_key_size);
+
+        serial = add_key("user", name, p, n, KEY_SPEC_USER_KEYRING);
+        if (serial == -1)
+                return -errno;
+
+        if (keyctl(KEYCTL_SET_TIMEOUT,
+                   (unsigned long) serial,
+                   (unsigned long) DIV_ROUND_UP(TPM2_CACHE_TIMEOUT_USEC, USEC_PER_SEC), 0, 0) < 0)
+                log_debug_errno(errno, "Failed to adjust kernel keyring key timeout: %m");
+
+        log_debug("Added unsealed TPM2 key to kernel keyring as %" PRIi32 ".", serial);
+        return 0;
+}
+
 int acquire_tpm2_key(
                 const char *volume_name,
                 const char *device,
@@ -20,6 +193,7 @@ int acquire_tpm2_key(
                 size_t key_data_size,
                 const void *policy_hash,
                 size_t policy_hash_size,
+                bool cache,
                 void **ret_decrypted_key,
                 size_t *ret_decrypted_key_size) {
 
@@ -62,7 +236,29 @@ int acquire_tpm2_key(
                 blob = loaded_blob;
         }
 
-        return tpm2_unseal(device, pcr_mask, blob, blob_size, policy_hash, policy_hash_size, ret_decrypted_key, ret_decrypted_key_size);
+        if (cache) {
+                /* Volumes sharing the same sealed key (e.g. a key file referenced by multiple crypttab
+                 * entries) only need to talk to the TPM once, which is slow and serializes all unlocks. */
+                r = tpm2_cache_lookup(pcr_mask, blob, blob_size, policy_hash, policy_hash_size, ret_decrypted_key, ret_decrypted_key_size);
+                if (r > 0) {
+                        log_debug("Found unsealed TPM2 key in kernel keyring, not contacting TPM2 device.");
+                        return 0;
+                }
+                if (r < 0)
+                        log_debug_errno(r, "Failed to look up unsealed TPM2 key in kernel keyring, ignoring: %m");
+        }
+
+        r = tpm2_unseal(device, pcr_mask, blob, blob_size, policy_hash, policy_hash_size, ret_decrypted_key, ret_decrypted_key_size);
+        if (r < 0)
+                return r;
+
+        if (cache) {
+                r = tpm2_cache_add(pcr_mask, blob, blob_size, policy_hash, policy_hash_size, *ret_decrypted_key, *ret_decrypted_key_size);
+                if (r < 0)
+                        log_debug_errno(r, "Failed to add unsealed TPM2 key to kernel keyring, ignoring: %m");
+        }
+
+        return 0;
 }
 
 int find_tpm2_auto_data(
@@ -20,6 +20,7 @@ int acquire_tpm2_key(
                 size_t key_data_size,
                 const void *policy_hash,
                 size_t policy_hash_size,
+                bool cache,
                 void **ret_decrypted_key,
                 size_t *ret_decrypted_key_size);
 
@@ -48,6 +49,7 @@ static inline int acquire_tpm2_key(
                 size_t key_data_size,
                 const void *policy_hash,
                 size_t policy_hash_size,
+                bool cache,
                 void **ret_decrypted_key,
                 size_t *ret_decrypted_key_size) {
 
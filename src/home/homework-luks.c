@@ -1217,9 +1217,16 @@ int home_prepare_luks(
                 if (r < 0)
                         goto fail;
 
-                r = run_fsck(setup->dm_node, fstype);
-                if (r < 0)
-                        goto fail;
+                /* If we could set the dirty flag just now, the image was cleanly deactivated last time,
+                 * i.e. the file system was unmounted and the flag removed only after that. In that case
+                 * there's no point in checking the file system. */
+                if (marked_dirty)
+                        log_info("Image was deactivated cleanly, skipping file system check.");
+                else {
+                        r = run_fsck(setup->dm_node, fstype);
+                        if (r < 0)
+                                goto fail;
+                }
 
                 r = home_unshare_and_mount(setup->dm_node, fstype, user_record_luks_discard(h), user_record_mount_flags(h));
                 if (r < 0)
@@ -4,6 +4,9 @@
 #include "string-table.h"
 #include "util.h"
 
+/* Upper limit for the number of threads used for decompressing xz images */
+#define XZ_DECODER_THREADS_MAX 8U
+
 void import_compress_free(ImportCompress *c) {
         assert(c);
 
@@ -54,7 +57,22 @@ int import_uncompress_detect(ImportCompress *c, const void *data, size_t size) {
         if (memcmp(data, xz_signature, sizeof(xz_signature)) == 0) {
                 lzma_ret xzr;
 
+#if HAVE_LZMA_STREAM_DECODER_MT
+                /* Images compressed with multiple blocks (e.g. "xz -T0") can be decompressed in parallel,
+                 * which matters a lot for large images, as decompression is usually the bottleneck. The
+                 * decoder falls back to single-threaded mode on its own if the file consists of a single
+                 * block only, or if running multiple threads would exceed the memory limit. */
+                lzma_mt mt = {
+                        .flags = LZMA_TELL_UNSUPPORTED_CHECK | LZMA_CONCATENATED,
+                        .threads = CLAMP(lzma_cputhreads(), 1U, XZ_DECODER_THREADS_MAX),
+                        .memlimit_threading = lzma_physmem() / 4,
+                        .memlimit_stop = UINT64_MAX,
+                };
+
+                xzr = lzma_stream_decoder_mt(&c->xz, &mt);
+#else
                 xzr = lzma_stream_decoder(&c->xz, UINT64_MAX, LZMA_TELL_UNSUPPORTED_CHECK | LZMA_CONCATENATED);
+#endif
                 if (xzr != LZMA_OK)
                         return -EIO;
 
@@ -4,6 +4,8 @@
 
 #include "alloc-util.h"
 #include "btrfs-util.h"
+#include "errno-util.h"
+#include "memory-util.h"
 #include "qcow2-util.h"
 #include "sparse-endian.h"
 #include "util.h"
@@ -14,6 +16,9 @@
 #define QCOW2_COMPRESSED (1ULL << 62)
 #define QCOW2_ZERO (1ULL << 0)
 
+/* Clusters that are adjacent both in the source and in the destination are copied in one go, up to this size */
+#define QCOW2_COPY_RUN_MAX (1024ULL*1024ULL)
+
 typedef struct _packed_ Header {
       be32_t magic;
       be32_t version;
@@ -61,29 +66,42 @@ static uint32_t HEADER_HEADER_LENGTH(const Header *h) {
         return be32toh(h->header_length);
 }
 
-static int copy_cluster(
+static int copy_clusters(
                 int sfd, uint64_t soffset,
                 int dfd, uint64_t doffset,
-                uint64_t cluster_size,
-                void *buffer) {
+                uint64_t size,
+                void *buffer,
+                bool *try_reflink) {
 
         ssize_t l;
         int r;
 
-        r = btrfs_clone_range(sfd, soffset, dfd, doffset, cluster_size);
-        if (r >= 0)
-                return r;
+        assert(try_reflink);
+
+        if (*try_reflink) {
+                r = btrfs_clone_range(sfd, soffset, dfd, doffset, size);
+                if (r >= 0)
+                        return r;
+
+                /* If the file system doesn't do reflinks, don't bother trying again for the other clusters */
+                if (ERRNO_IS_NOT_SUPPORTED(r) || IN_SET(r, -ENOTTY, -EXDEV, -EINVAL))
+                        *try_reflink = false;
+        }
 
-        l = pread(sfd, buffer, cluster_size, soffset);
+        l = pread(sfd, buffer, size, soffset);
         if (l < 0)
                 return -errno;
-        if ((uint64_t) l != cluster_size)
+        if ((uint64_t) l != size)
                 return -EIO;
 
-        l = pwrite(dfd, buffer, cluster_size, doffset);
+        /* The destination file starts out empty, hence there's no need to write zeroes, and it stays sparse */
+        if (memeqzero(buffer, size))
+                return 0;
+
+        l = pwrite(dfd, buffer, size, doffset);
         if (l < 0)
                 return -errno;
-        if ((uint64_t) l != cluster_size)
+        if ((uint64_t) l != size)
                 return -EIO;
 
         return 0;
@@ -135,6 +153,9 @@ static int decompress_cluster(
         if (r != Z_STREAM_END || sz != cluster_size)
                 return -EIO;
 
+        if (memeqzero(buffer2, cluster_size))
+                return 0;
+
         l = pwrite(dfd, buffer2, cluster_size, doffset);
         if (l < 0)
                 return -errno;
@@ -227,9 +248,10 @@ static int verify_header(const Header *header) {
 }
 
 int qcow2_convert(int qcow2_fd, int raw_fd) {
-        _cleanup_free_ void *buffer1 = NULL, *buffer2 = NULL;
+        _cleanup_free_ void *buffer1 = NULL, *buffer2 = NULL, *copy_buffer = NULL;
         _cleanup_free_ be64_t *l1_table = NULL, *l2_table = NULL;
-        uint64_t sz, i;
+        uint64_t sz, i, copy_buffer_size, run_soffset = 0, run_doffset = 0, run_size = 0;
+        bool try_reflink = true;
         Header header;
         ssize_t l;
         int r;
@@ -260,6 +282,11 @@ int qcow2_convert(int qcow2_fd, int raw_fd) {
         if (!buffer2)
                 return -ENOMEM;
 
+        copy_buffer_size = MAX(HEADER_CLUSTER_SIZE(&header), QCOW2_COPY_RUN_MAX);
+        copy_buffer = malloc(copy_buffer_size);
+        if (!copy_buffer)
+                return -ENOMEM;
+
         /* Empty the file if it exists, we rely on zero bits */
         if (ftruncate(raw_fd, 0) < 0)
                 return -errno;
@@ -301,22 +328,54 @@ int qcow2_convert(int qcow2_fd, int raw_fd) {
                         if (r == 0)
                                 continue;
 
-                        if (compressed)
+                        if (compressed) {
                                 r = decompress_cluster(
                                                 qcow2_fd, data_begin,
                                                 raw_fd, p,
                                                 compressed_size, HEADER_CLUSTER_SIZE(&header),
                                                 buffer1, buffer2);
-                        else
-                                r = copy_cluster(
-                                                qcow2_fd, data_begin,
-                                                raw_fd, p,
-                                                HEADER_CLUSTER_SIZE(&header), buffer1);
-                        if (r < 0)
-                                return r;
+                                if (r < 0)
+                                        return r;
+
+                                continue;
+                        }
+
+                        /* Images are usually written sequentially, hence consecutive clusters tend to be
+                         * consecutive in the image file, too. Collect those, and copy them together. */
+                        if (run_size > 0 &&
+                            data_begin == run_soffset + run_size &&
+                            p == run_doffset + run_size &&
+                            run_size + HEADER_CLUSTER_SIZE(&header) <= copy_buffer_size) {
+                                run_size += HEADER_CLUSTER_SIZE(&header);
+                                continue;
+                        }
+
+                        if (run_size > 0) {
+                                r = copy_clusters(
+                                                qcow2_fd, run_soffset,
+                                                raw_fd, run_doffset,
+                                                run_size, copy_buffer,
+                                                &try_reflink);
+                                if (r < 0)
+                                        return r;
+                        }
+
+                        run_soffset = data_begin;
+                        run_doffset = p;
+                        run_size = HEADER_CLUSTER_SIZE(&header);
                 }
         }
 
+        if (run_size > 0) {
+                r = copy_clusters(
+                                qcow2_fd, run_soffset,
+                                raw_fd, run_doffset,
+                                run_size, copy_buffer,
+                                &try_reflink);
+                if (r < 0)
+                        return r;
+        }
+
         return 0;
 }
 
@@ -33,6 +33,10 @@
 
 #define JOURNAL_WAIT_TIMEOUT (10*USEC_PER_SEC)
 
+/* How much readily available data to serialize ahead of time, so that microhttpd gets handed larger
+ * chunks instead of one entry per callback */
+#define ENTRIES_PREFETCH_MAX (64U*1024U)
+
 static char *arg_key_pem = NULL;
 static char *arg_cert_pem = NULL;
 static char *arg_trust_pem = NULL;
@@ -135,6 +139,42 @@ static int request_meta_ensure_tmp(RequestMeta *m) {
         return 0;
 }
 
+static int request_meta_prefetch_entries(RequestMeta *m) {
+        int r;
+
+        assert(m);
+        assert(m->tmp);
+
+        /* Append further entries to the temporary file as long as they are available without waiting,
+         * until the prefetch limit is hit. */
+
+        for (;;) {
+                off_t sz;
+
+                sz = ftello(m->tmp);
+                if (sz == (off_t) -1)
+                        return -errno;
+                if ((uint64_t) sz >= ENTRIES_PREFETCH_MAX)
+                        return 0;
+
+                if (m->n_entries_set &&
+                    m->n_entries <= 0)
+                        return 0;
+
+                r = sd_journal_next(m->journal);
+                if (r <= 0)
+                        return r;
+
+                if (m->n_entries_set)
+                        m->n_entries -= 1;
+
+                r = show_journal_entry(m->tmp, m->journal, m->mode, 0, OUTPUT_FULL_WIDTH,
+                                   NULL, NULL, NULL);
+                if (r < 0)
+                        return r;
+        }
+}
+
 static ssize_t request_reader_entries(
                 void *cls,
                 uint64_t pos,
@@ -223,6 +263,12 @@ static ssize_t request_reader_entries(
                         return MHD_CONTENT_READER_END_WITH_ERROR;
                 }
 
+                r = request_meta_prefetch_entries(m);
+                if (r < 0) {
+                        log_error_errno(r, "Failed to serialize items: %m");
+                        return MHD_CONTENT_READER_END_WITH_ERROR;
+                }
+
                 sz = ftello(m->tmp);
                 if (sz == (off_t) -1) {
                         log_error_errno(errno, "Failed to retrieve file position: %m");
@@ -497,7 +543,7 @@ static int request_handler_entries(
         if (r < 0)
                 return mhd_respond(connection, MHD_HTTP_BAD_REQUEST, "Failed to seek in journal.");
 
-        response = MHD_create_response_from_callback(MHD_SIZE_UNKNOWN, 4*1024, request_reader_entries, m, NULL);
+        response = MHD_create_response_from_callback(MHD_SIZE_UNKNOWN, ENTRIES_PREFETCH_MAX, request_reader_entries, m, NULL);
         if (!response)
                 return respond_oom(connection);
 
@@ -37,6 +37,7 @@ static const char* arg_listen_https = NULL;
 static char** arg_files = NULL; /* Do not free this. */
 static bool arg_compress = true;
 static bool arg_seal = false;
+static unsigned arg_threads = 0;
 static int http_socket = -1, https_socket = -1;
 static char** arg_gnutls_log = NULL;
 
@@ -191,6 +192,86 @@ static void request_meta_free(void *cls,
         }
 }
 
+static int process_source_data(struct MHD_Connection *connection, RemoteSource *source) {
+        int r;
+
+        assert(source);
+
+        for (;;) {
+                r = process_source(source,
+                                   journal_remote_server_global->compress,
+                                   journal_remote_server_global->seal);
+                if (r == -EAGAIN)
+                        return 0;
+                if (r < 0) {
+                        if (r == -ENOBUFS)
+                                log_warning_errno(r, "Entry is above the maximum of %u, aborting connection %p.",
+                                                  DATA_SIZE_MAX, connection);
+                        else if (r == -E2BIG)
+                                log_warning_errno(r, "Entry with more fields than the maximum of %u, aborting connection %p.",
+                                                  ENTRY_FIELD_COUNT_MAX, connection);
+                        else
+                                log_warning_errno(r, "Failed to process data, aborting connection %p: %m",
+                                                  connection);
+                        return r;
+                }
+        }
+}
+
+#if HAVE_ZSTD
+static int process_compressed_data(
+                struct MHD_Connection *connection,
+                const char *data,
+                size_t size,
+                RemoteSource *source) {
+
+        _cleanup_free_ void *buffer = NULL;
+        ZSTD_inBuffer input = {
+                .src = data,
+                .size = size,
+        };
+        size_t buffer_size;
+        int r;
+
+        assert(source);
+        assert(source->zstd);
+
+        buffer_size = ZSTD_DStreamOutSize();
+        buffer = malloc(buffer_size);
+        if (!buffer)
+                return -ENOMEM;
+
+        for (;;) {
+                ZSTD_outBuffer output = {
+                        .dst = buffer,
+                        .size = buffer_size,
+                };
+                size_t k;
+
+                k = ZSTD_decompressStream(source->zstd, &output, &input);
+                if (ZSTD_isError(k))
+                        return log_warning_errno(SYNTHETIC_ERRNO(EBADMSG),
+                                                 "Failed to decompress data, aborting connection %p: %s",
+                                                 connection, ZSTD_getErrorName(k));
+
+                if (output.pos > 0) {
+                        r = journal_importer_push_data(&source->importer, buffer, output.pos);
+                        if (r < 0)
+                                return r;
+
+                        /* Process what we have right-away, so that we never need to buffer more than a
+                         * single (decompressed) entry. */
+                        r = process_source_data(connection, source);
+                        if (r < 0)
+                                return r;
+                }
+
+                if (input.pos >= input.size && output.pos < output.size)
+                        return 0;
+        }
+}
+#endif
+
 static int process_http_upload(
                 struct MHD_Connection *connection,
                 const char *upload_data,
@@ -209,6 +290,19 @@ static int process_http_upload(
         if (*upload_data_size) {
                 log_trace("Received %zu bytes", *upload_data_size);
 
+#if HAVE_ZSTD
+                if (source->zstd) {
+                        r = process_compressed_data(connection, upload_data, *upload_data_size, source);
+                        if (r == -ENOMEM)
+                                return mhd_respond_oom(connection);
+                        if (r < 0)
+                                return MHD_NO;
+
+                        *upload_data_size = 0;
+                        return MHD_YES;
+                }
+#endif
+
                 r = journal_importer_push_data(&source->importer,
                                                upload_data, *upload_data_size);
                 if (r < 0)
@@ -218,25 +312,9 @@ static int process_http_upload(
         } else
                 finished = true;
 
-        for (;;) {
-                r = process_source(source,
-                                   journal_remote_server_global->compress,
-                                   journal_remote_server_global->seal);
-                if (r == -EAGAIN)
-                        break;
-                if (r < 0) {
-                        if (r == -ENOBUFS)
-                                log_warning_errno(r, "Entry is above the maximum of %u, aborting connection %p.",
-                                                  DATA_SIZE_MAX, connection);
-                        else if (r == -E2BIG)
-                                log_warning_errno(r, "Entry with more fields than the maximum of %u, aborting connection %p.",
-                                                  ENTRY_FIELD_COUNT_MAX, connection);
-                        else
-                                log_warning_errno(r, "Failed to process data, aborting connection %p: %m",
-                                                  connection);
-                        return MHD_NO;
-                }
-        }
+        r = process_source_data(connection, source);
+        if (r < 0)
+                return MHD_NO;
 
         if (!finished)
                 return MHD_YES;
@@ -269,6 +347,9 @@ static mhd_result request_handler(
         int r, code, fd;
         _cleanup_free_ char *hostname = NULL;
         bool chunked = false;
+#if HAVE_ZSTD
+        bool compressed = false;
+#endif
 
         assert(connection);
         assert(connection_cls);
@@ -302,6 +383,17 @@ static mhd_result request_handler(
                 chunked = true;
         }
 
+        header = MHD_lookup_connection_value(connection, MHD_HEADER_KIND, "Content-Encoding");
+        if (header && !strcaseeq(header, "identity")) {
+#if HAVE_ZSTD
+                if (strcaseeq(header, "zstd"))
+                        compressed = true;
+                else
+#endif
+                        return mhd_respondf(connection, 0, MHD_HTTP_UNSUPPORTED_MEDIA_TYPE,
+                                            "Unsupported Content-Encoding type: %s", header);
+        }
+
         header = MHD_lookup_connection_value(connection, MHD_HEADER_KIND, "Content-Length");
         if (header) {
                 size_t len;
@@ -358,6 +450,17 @@ static mhd_result request_handler(
                 return mhd_respondf(connection, r, MHD_HTTP_INTERNAL_SERVER_ERROR, "%m");
 
         hostname = NULL;
+
+#if HAVE_ZSTD
+        if (compressed) {
+                RemoteSource *source = *connection_cls;
+
+                source->zstd = ZSTD_createDCtx();
+                if (!source->zstd)
+                        return respond_oom(connection);
+        }
+#endif
+
         return MHD_YES;
 }
 
@@ -604,6 +707,12 @@ static int create_remoteserver(
         if (r < 0)
                 return log_error_errno(r, "Failed to set up signals: %m");
 
+        if (arg_threads > 0) {
+                r = writer_pool_new(arg_threads, arg_compress, arg_seal, &s->pool);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to start writer threads: %m");
+        }
+
         n = sd_listen_fds(true);
         if (n < 0)
                 return log_error_errno(n, "Failed to read listening file descriptors from environment: %m");
@@ -792,6 +901,7 @@ static int help(void) {
                "  -o --output=FILE|DIR      Write output to FILE or DIR/external-*.journal\n"
                "     --compress[=BOOL]      Use compression in the output journal (default: yes)\n"
                "     --seal[=BOOL]          Use event sealing (default: no)\n"
+               "     --threads=N            Write output files in N threads\n"
                "     --key=FILENAME         SSL key in PEM format (default:\n"
                "                            \"" PRIV_KEY_FILE "\")\n"
                "     --cert=FILENAME        SSL certificate in PEM format (default:\n"
@@ -820,6 +930,7 @@ static int parse_argv(int argc, char *argv[]) {
                 ARG_SPLIT_MODE,
                 ARG_COMPRESS,
                 ARG_SEAL,
+                ARG_THREADS,
                 ARG_KEY,
                 ARG_CERT,
                 ARG_TRUST,
@@ -838,6 +949,7 @@ static int parse_argv(int argc, char *argv[]) {
                 { "split-mode",   required_argument, NULL, ARG_SPLIT_MODE   },
                 { "compress",     optional_argument, NULL, ARG_COMPRESS     },
                 { "seal",         optional_argument, NULL, ARG_SEAL         },
+                { "threads",      required_argument, NULL, ARG_THREADS      },
                 { "key",          required_argument, NULL, ARG_KEY          },
                 { "cert",         required_argument, NULL, ARG_CERT         },
                 { "trust",        required_argument, NULL, ARG_TRUST        },
@@ -977,6 +1089,15 @@ static int parse_argv(int argc, char *argv[]) {
                                 return r;
                         break;
 
+                case ARG_THREADS:
+                        r = safe_atou(optarg, &arg_threads);
+                        if (r < 0)
+                                return log_error_errno(r, "Failed to parse number of threads: %s", optarg);
+                        if (arg_threads > WRITER_POOL_THREADS_MAX)
+                                return log_error_errno(SYNTHETIC_ERRNO(ERANGE),
+                                                       "Number of threads must be at most %u.", WRITER_POOL_THREADS_MAX);
+                        break;
+
                 case ARG_GNUTLS_LOG:
 #if HAVE_GNUTLS
                         for (const char* p = optarg;;) {
@@ -1159,6 +1280,9 @@ static int run(int argc, char **argv) {
                         return log_error_errno(r, "Failed to run event loop: %m");
         }
 
+        /* Make sure the count below includes everything still queued for the writer threads */
+        writer_pool_flush(s.pool);
+
         notify_message = NULL;
         (void) sd_notifyf(false,
                           "STOPPING=1\n"
@@ -19,6 +19,10 @@ void source_free(RemoteSource *source) {
         sd_event_source_unref(source->event);
         sd_event_source_unref(source->buffer_event);
 
+#if HAVE_ZSTD
+        ZSTD_freeDCtx(source->zstd);
+#endif
+
         free(source);
 }
 
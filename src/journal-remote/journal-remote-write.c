@@ -1,7 +1,48 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
+#include <pthread.h>
+#include <signal.h>
+
 #include "alloc-util.h"
 #include "journal-remote.h"
+#include "list.h"
+
+/* Entries queued for a worker before the main thread blocks and waits for it to catch up */
+#define WRITER_QUEUE_MAX 1024U
+
+typedef struct WriterEntry WriterEntry;
+
+struct WriterEntry {
+        Writer *writer;
+        dual_timestamp ts;
+        sd_id128_t boot_id;
+        size_t n_iovec;
+
+        LIST_FIELDS(WriterEntry, entries);
+
+        struct iovec iovec[];
+};
+
+struct WriterWorker {
+        WriterPool *pool;
+        pthread_t thread;
+
+        LIST_HEAD(WriterEntry, queue);
+        WriterEntry *queue_tail;
+        size_t n_queued;
+};
+
+struct WriterPool {
+        pthread_mutex_t mutex;
+        pthread_cond_t work, done;
+        bool shutdown;
+
+        WriterWorker *workers;
+        unsigned n_workers, next_worker;
+        size_t n_pending; /* entries queued or being written, by all workers */
+
+        bool compress, seal;
+};
 
 static int do_rotate(JournalFile **f, bool compress, bool seal) {
         int r = journal_file_rotate(f, compress, UINT64_MAX, seal, NULL);
@@ -31,13 +72,39 @@ Writer* writer_new(RemoteServer *server) {
         w->n_ref = 1;
         w->server = server;
 
+        /* Spread the writers over the workers, all entries for one writer go to the same one, so that they
+         * are written in order */
+        if (server && server->pool) {
+                w->worker = server->pool->workers + server->pool->next_worker;
+                server->pool->next_worker = (server->pool->next_worker + 1) % server->pool->n_workers;
+        }
+
         return w;
 }
 
+static void writer_wait_pending(Writer *w) {
+        WriterPool *p;
+
+        assert(w);
+
+        if (!w->worker)
+                return;
+
+        p = w->worker->pool;
+
+        assert_se(pthread_mutex_lock(&p->mutex) == 0);
+        while (w->n_pending > 0)
+                assert_se(pthread_cond_wait(&p->done, &p->mutex) == 0);
+        assert_se(pthread_mutex_unlock(&p->mutex) == 0);
+}
+
 static Writer* writer_free(Writer *w) {
         if (!w)
                 return NULL;
 
+        /* Let the worker finish with our entries before we close the file under its feet */
+        writer_wait_pending(w);
+
         if (w->journal) {
                 log_debug("Closing journal file %s.", w->journal->path);
                 journal_file_close(w->journal);
@@ -56,51 +123,324 @@ static Writer* writer_free(Writer *w) {
 
 DEFINE_TRIVIAL_REF_UNREF_FUNC(Writer, writer, writer_free);
 
+static int writer_append(
+                Writer *w,
+                const JournalFileEntry *entries, size_t n,
+                bool compress, bool seal,
+                size_t *ret_n_written) {
+
+        bool rotated = false;
+        size_t done = 0;
+        int r = 0;
+
+        assert(w);
+        assert(entries);
+        assert(n > 0);
+        assert(ret_n_written);
+
+        /* Appends the entries in one go, and rotates once if that fails. Returns the number of entries
+         * written before an error occurred in *ret_n_written. */
+
+        if (journal_file_rotate_suggested(w->journal, 0)) {
+                log_info("%s: Journal header limits reached or header out-of-date, rotating",
+                         w->journal->path);
+                r = do_rotate(&w->journal, compress, seal);
+                if (r < 0)
+                        goto finish;
+        }
+
+        for (;;) {
+                size_t k;
+
+                r = journal_file_append_entries(w->journal, entries + done, n - done, &w->seqnum, &k);
+                done += k;
+                if (r >= 0 || r == -EBADMSG)
+                        break;
+
+                /* Rotate again if the file filled up after we made progress in a fresh one */
+                if (rotated && k == 0)
+                        break;
+
+                log_debug_errno(r, "%s: Write failed, rotating: %m", w->journal->path);
+                r = do_rotate(&w->journal, compress, seal);
+                if (r < 0)
+                        break;
+
+                log_debug("%s: Successfully rotated journal", w->journal->path);
+                log_debug("Retrying write.");
+                rotated = true;
+        }
+
+finish:
+        *ret_n_written = done;
+        return r;
+}
+
+static void writer_queue(Writer *w, struct iovec_wrapper *iovw, dual_timestamp *ts, sd_id128_t *boot_id) {
+        WriterWorker *worker = w->worker;
+        WriterPool *p = worker->pool;
+        WriterEntry *e;
+        uint8_t *data;
+
+        /* The importer reuses its buffer for the next entry, hence copy this one for the worker */
+        e = malloc(offsetof(WriterEntry, iovec) + sizeof(struct iovec) * iovw->count + iovw_size(iovw));
+        if (!e) {
+                log_oom();
+                return;
+        }
+
+        *e = (WriterEntry) {
+                .writer = w,
+                .ts = *ts,
+                .boot_id = *boot_id,
+                .n_iovec = iovw->count,
+        };
+
+        data = (uint8_t*) (e->iovec + iovw->count);
+        for (size_t i = 0; i < iovw->count; i++) {
+                e->iovec[i] = IOVEC_MAKE(data, iovw->iovec[i].iov_len);
+                data = mempcpy(data, iovw->iovec[i].iov_base, iovw->iovec[i].iov_len);
+        }
+
+        assert_se(pthread_mutex_lock(&p->mutex) == 0);
+
+        while (worker->n_queued >= WRITER_QUEUE_MAX)
+                assert_se(pthread_cond_wait(&p->done, &p->mutex) == 0);
+
+        LIST_INSERT_AFTER(entries, worker->queue, worker->queue_tail, e);
+        worker->queue_tail = e;
+        worker->n_queued++;
+        w->n_pending++;
+        p->n_pending++;
+
+        assert_se(pthread_cond_broadcast(&p->work) == 0);
+        assert_se(pthread_mutex_unlock(&p->mutex) == 0);
+}
+
 int writer_write(Writer *w,
                  struct iovec_wrapper *iovw,
                  dual_timestamp *ts,
                  sd_id128_t *boot_id,
                  bool compress,
                  bool seal) {
+        size_t k;
         int r;
 
         assert(w);
         assert(iovw);
         assert(iovw->count > 0);
 
-        if (journal_file_rotate_suggested(w->journal, 0)) {
-                log_info("%s: Journal header limits reached or header out-of-date, rotating",
-                         w->journal->path);
-                r = do_rotate(&w->journal, compress, seal);
-                if (r < 0)
-                        return r;
+        if (w->worker) {
+                /* Errors are logged by the worker, we won't hear about them here */
+                writer_queue(w, iovw, ts, boot_id);
+                return 0;
         }
 
-        r = journal_file_append_entry(w->journal, ts, boot_id,
-                                      iovw->iovec, iovw->count,
-                                      &w->seqnum, NULL, NULL);
-        if (r >= 0) {
+        r = writer_append(w,
+                          &(JournalFileEntry) {
+                                  .ts = *ts,
+                                  .boot_id = boot_id,
+                                  .iovec = iovw->iovec,
+                                  .n_iovec = iovw->count,
+                          }, 1,
+                          compress, seal, &k);
+        if (k > 0 && w->server)
+                w->server->event_count += 1;
+
+        return r < 0 ? r : 0;
+}
+
+static void writer_worker_write(WriterWorker *worker, WriterEntry *queue) {
+        WriterPool *p = worker->pool;
+        _cleanup_free_ JournalFileEntry *batch = NULL;
+        size_t n_allocated = 0;
+
+        /* Writes out the entries taken from the queue, in batches of consecutive entries for the same
+         * writer, and then marks them as done. */
+
+        while (queue) {
+                Writer *w = queue->writer;
+                WriterEntry *e;
+                size_t n = 0, done = 0, n_written = 0;
+
+                LIST_FOREACH(entries, e, queue) {
+                        if (e->writer != w)
+                                break;
+
+                        if (!GREEDY_REALLOC(batch, n_allocated, n + 1)) {
+                                log_oom();
+                                break;
+                        }
+
+                        batch[n++] = (JournalFileEntry) {
+                                .ts = e->ts,
+                                .boot_id = &e->boot_id,
+                                .iovec = e->iovec,
+                                .n_iovec = e->n_iovec,
+                        };
+                }
+
+                while (done < n) {
+                        size_t k;
+                        int r;
+
+                        r = writer_append(w, batch + done, n - done, p->compress, p->seal, &k);
+                        done += k;
+                        n_written += k;
+                        if (r >= 0)
+                                break;
+
+                        if (r == -EBADMSG)
+                                log_error_errno(r, "Entry is invalid, ignoring.");
+                        else
+                                log_error_errno(r, "Failed to write entry of %zu bytes: %m",
+                                                IOVEC_TOTAL_SIZE(batch[done].iovec, batch[done].n_iovec));
+                        done++;
+                }
+
+                /* If we couldn't even allocate the batch, drop the first entry, so that we make progress */
+                if (n == 0)
+                        n = 1;
+
+                assert_se(pthread_mutex_lock(&p->mutex) == 0);
+
+                assert(w->n_pending >= n);
+                w->n_pending -= n;
+                p->n_pending -= n;
                 if (w->server)
-                        w->server->event_count += 1;
-                return 0;
-        } else if (r == -EBADMSG)
-                return r;
+                        w->server->event_count += n_written;
 
-        log_debug_errno(r, "%s: Write failed, rotating: %m", w->journal->path);
-        r = do_rotate(&w->journal, compress, seal);
-        if (r < 0)
-                return r;
-        else
-                log_debug("%s: Successfully rotated journal", w->journal->path);
+                assert_se(pthread_cond_broadcast(&p->done) == 0);
+                assert_se(pthread_mutex_unlock(&p->mutex) == 0);
+
+                /* The writer must not be touched anymore from here on, it might be gone already */
+                for (size_t i = 0; i < n; i++) {
+                        e = queue;
+                        queue = e->entries_next;
+                        free(e);
+                }
+        }
+}
+
+static void* writer_worker_thread(void *userdata) {
+        WriterWorker *worker = userdata;
+        WriterPool *p = worker->pool;
+
+        (void) pthread_setname_np(pthread_self(), "journal-writer");
+
+        assert_se(pthread_mutex_lock(&p->mutex) == 0);
+
+        for (;;) {
+                WriterEntry *queue;
+
+                while (!worker->queue && !p->shutdown)
+                        assert_se(pthread_cond_wait(&p->work, &p->mutex) == 0);
+
+                if (!worker->queue)
+                        break;
+
+                queue = TAKE_PTR(worker->queue);
+                worker->queue_tail = NULL;
+                worker->n_queued = 0;
+
+                /* The main thread might be waiting for queue space */
+                assert_se(pthread_cond_broadcast(&p->done) == 0);
+                assert_se(pthread_mutex_unlock(&p->mutex) == 0);
+
+                writer_worker_write(worker, queue);
+
+                assert_se(pthread_mutex_lock(&p->mutex) == 0);
+        }
+
+        assert_se(pthread_mutex_unlock(&p->mutex) == 0);
+
+        return NULL;
+}
+
+int writer_pool_new(unsigned n_threads, bool compress, bool seal, WriterPool **ret) {
+        _cleanup_(writer_pool_freep) WriterPool *p = NULL;
+        sigset_t ss, saved_ss;
+        int r;
+
+        assert(n_threads > 0);
+        assert(ret);
+
+        p = new(WriterPool, 1);
+        if (!p)
+                return -ENOMEM;
+
+        *p = (WriterPool) {
+                .mutex = PTHREAD_MUTEX_INITIALIZER,
+                .work = PTHREAD_COND_INITIALIZER,
+                .done = PTHREAD_COND_INITIALIZER,
+                .compress = compress,
+                .seal = seal,
+        };
+
+        p->workers = new0(WriterWorker, MIN(n_threads, WRITER_POOL_THREADS_MAX));
+        if (!p->workers)
+                return -ENOMEM;
+
+        /* Signals are handled by the event loop of the main thread */
+        assert_se(sigfillset(&ss) >= 0);
+        r = pthread_sigmask(SIG_BLOCK, &ss, &saved_ss);
+        if (r > 0)
+                return -r;
+
+        for (unsigned i = 0; i < MIN(n_threads, WRITER_POOL_THREADS_MAX); i++) {
+                WriterWorker *worker = p->workers + i;
+
+                worker->pool = p;
+
+                r = pthread_create(&worker->thread, NULL, writer_worker_thread, worker);
+                if (r > 0) {
+                        r = -r;
+                        break;
+                }
+
+                p->n_workers++;
+                r = 0;
+        }
+
+        (void) pthread_sigmask(SIG_SETMASK, &saved_ss, NULL);
 
-        log_debug("Retrying write.");
-        r = journal_file_append_entry(w->journal, ts, boot_id,
-                                      iovw->iovec, iovw->count,
-                                      &w->seqnum, NULL, NULL);
         if (r < 0)
                 return r;
 
-        if (w->server)
-                w->server->event_count += 1;
+        *ret = TAKE_PTR(p);
         return 0;
 }
+
+void writer_pool_flush(WriterPool *p) {
+        if (!p)
+                return;
+
+        assert_se(pthread_mutex_lock(&p->mutex) == 0);
+
+        while (p->n_pending > 0)
+                assert_se(pthread_cond_wait(&p->done, &p->mutex) == 0);
+
+        assert_se(pthread_mutex_unlock(&p->mutex) == 0);
+}
+
+WriterPool* writer_pool_free(WriterPool *p) {
+        if (!p)
+                return NULL;
+
+        assert_se(pthread_mutex_lock(&p->mutex) == 0);
+        p->shutdown = true;
+        assert_se(pthread_cond_broadcast(&p->work) == 0);
+        assert_se(pthread_mutex_unlock(&p->mutex) == 0);
+
+        /* The workers write out whatever is still queued before they exit */
+        for (unsigned i = 0; i < p->n_workers; i++)
+                assert_se(pthread_join(p->workers[i].thread, NULL) == 0);
+
+        free(p->workers);
+
+        assert_se(pthread_cond_destroy(&p->done) == 0);
+        assert_se(pthread_cond_destroy(&p->work) == 0);
+        assert_se(pthread_mutex_destroy(&p->mutex) == 0);
+
+        return mfree(p);
+}
@@ -5,6 +5,8 @@
 #include "journal-importer.h"
 
 typedef struct RemoteServer RemoteServer;
+typedef struct WriterPool WriterPool;
+typedef struct WriterWorker WriterWorker;
 
 typedef struct Writer {
         JournalFile *journal;
@@ -16,9 +18,22 @@ typedef struct Writer {
 
         uint64_t seqnum;
 
+        /* If set, all writes to the journal file happen on this worker thread, and the journal file must
+         * not be touched from the main thread while n_pending > 0. n_pending is protected by the pool's
+         * mutex. */
+        WriterWorker *worker;
+        size_t n_pending;
+
         unsigned n_ref;
 } Writer;
 
+#define WRITER_POOL_THREADS_MAX 64U
+
+int writer_pool_new(unsigned n_threads, bool compress, bool seal, WriterPool **ret);
+WriterPool* writer_pool_free(WriterPool *p);
+DEFINE_TRIVIAL_CLEANUP_FUNC(WriterPool*, writer_pool_free);
+void writer_pool_flush(WriterPool *p);
+
 Writer* writer_new(RemoteServer* server);
 Writer* writer_ref(Writer *w);
 Writer* writer_unref(Writer *w);
@@ -358,6 +358,7 @@ void journal_remote_server_destroy(RemoteServer *s) {
 
         writer_unref(s->_single_writer);
         hashmap_free(s->writers);
+        s->pool = writer_pool_free(s->pool);
 
         sd_event_source_unref(s->sigterm_event);
         sd_event_source_unref(s->sigint_event);
@@ -31,6 +31,7 @@ struct RemoteServer {
 
         Hashmap *writers;
         Writer *_single_writer;
+        WriterPool *pool; /* if set, writers append on worker threads */
         uint64_t event_count;
 
 #if HAVE_MICROHTTPD
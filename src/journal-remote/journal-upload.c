@@ -53,6 +53,7 @@ static const char *arg_machine = NULL;
 static bool arg_merge = false;
 static int arg_follow = -1;
 static const char *arg_save_state = NULL;
+static bool arg_compress = false;
 
 static void close_fd_input(Uploader *u);
 
@@ -171,6 +172,96 @@ static int load_cursor_state(Uploader *u) {
         return 0;
 }
 
+#if HAVE_ZSTD
+static size_t compressed_input_callback(void *buf, size_t size, size_t nmemb, void *userp) {
+        Uploader *u = userp;
+        ZSTD_outBuffer output = {
+                .dst = buf,
+                .size = size * nmemb,
+        };
+
+        assert(u);
+        assert(u->zstd);
+        assert(!size_multiply_overflow(size, nmemb));
+
+        /* Pulls uncompressed data from the actual input callback and passes it through the compressor. Each
+         * upload is a single zstd frame. */
+
+        while (!u->zstd_done) {
+                ZSTD_inBuffer input;
+                size_t k;
+
+                if (u->zstd_buffer_pos >= u->zstd_buffer_len && !u->zstd_input_eof) {
+                        size_t n;
+
+                        n = u->zstd_input_callback(u->zstd_buffer, 1, u->zstd_buffer_size, u->zstd_input_data);
+                        if (IN_SET(n, CURL_READFUNC_ABORT, CURL_READFUNC_PAUSE))
+                                return n;
+
+                        u->zstd_buffer_pos = 0;
+                        u->zstd_buffer_len = n;
+                        u->zstd_input_eof = n == 0;
+                }
+
+                input = (ZSTD_inBuffer) {
+                        .src = u->zstd_buffer,
+                        .size = u->zstd_buffer_len,
+                        .pos = u->zstd_buffer_pos,
+                };
+
+                /* Flush whenever we consumed a chunk of input, so that the server sees entries timely also
+                 * when we are following the journal. */
+                k = ZSTD_compressStream2(u->zstd, &output, &input, u->zstd_input_eof ? ZSTD_e_end : ZSTD_e_flush);
+                if (ZSTD_isError(k)) {
+                        log_error("Failed to compress data: %s", ZSTD_getErrorName(k));
+                        return CURL_READFUNC_ABORT;
+                }
+
+                u->zstd_buffer_pos = input.pos;
+
+                if (k == 0 && u->zstd_input_eof)
+                        u->zstd_done = true;
+                else if (output.pos >= output.size)
+                        break;
+                else if (k == 0 && output.pos > 0)
+                        /* Everything we had is flushed out, don't wait for more input */
+                        break;
+        }
+
+        log_debug("%s: compressed %zu bytes", __func__, output.pos);
+        return output.pos;
+}
+
+static int setup_compression(Uploader *u,
+                             size_t (*input_callback)(void *ptr,
+                                                      size_t size,
+                                                      size_t nmemb,
+                                                      void *userdata),
+                             void *data) {
+        assert(u);
+        assert(input_callback);
+
+        if (!u->zstd) {
+                u->zstd = ZSTD_createCCtx();
+                if (!u->zstd)
+                        return log_oom();
+
+                u->zstd_buffer_size = ZSTD_CStreamInSize();
+                u->zstd_buffer = malloc(u->zstd_buffer_size);
+                if (!u->zstd_buffer)
+                        return log_oom();
+        } else
+                (void) ZSTD_CCtx_reset(u->zstd, ZSTD_reset_session_only);
+
+        u->zstd_buffer_pos = u->zstd_buffer_len = 0;
+        u->zstd_input_eof = u->zstd_done = false;
+        u->zstd_input_callback = input_callback;
+        u->zstd_input_data = data;
+
+        return 0;
+}
+#endif
+
 int start_upload(Uploader *u,
                  size_t (*input_callback)(void *ptr,
                                           size_t size,
@@ -200,6 +291,13 @@ int start_upload(Uploader *u,
                         return log_oom();
                 h = l;
 
+                if (arg_compress) {
+                        l = curl_slist_append(h, "Content-Encoding: zstd");
+                        if (!l)
+                                return log_oom();
+                        h = l;
+                }
+
                 u->header = TAKE_PTR(h);
         }
 
@@ -226,11 +324,22 @@ int start_upload(Uploader *u,
                             LOG_ERR, return -EXFULL);
 
                 /* set where to read from */
-                easy_setopt(curl, CURLOPT_READFUNCTION, input_callback,
-                            LOG_ERR, return -EXFULL);
+#if HAVE_ZSTD
+                if (arg_compress) {
+                        easy_setopt(curl, CURLOPT_READFUNCTION, compressed_input_callback,
+                                    LOG_ERR, return -EXFULL);
 
-                easy_setopt(curl, CURLOPT_READDATA, data,
-                            LOG_ERR, return -EXFULL);
+                        easy_setopt(curl, CURLOPT_READDATA, u,
+                                    LOG_ERR, return -EXFULL);
+                } else
+#endif
+                {
+                        easy_setopt(curl, CURLOPT_READFUNCTION, input_callback,
+                                    LOG_ERR, return -EXFULL);
+
+                        easy_setopt(curl, CURLOPT_READDATA, data,
+                                    LOG_ERR, return -EXFULL);
+                }
 
                 /* use our special own mime type and chunked transfer */
                 easy_setopt(curl, CURLOPT_HTTPHEADER, u->header,
@@ -278,6 +387,16 @@ int start_upload(Uploader *u,
                                        "curl_easy_setopt CURLOPT_URL failed: %s",
                                        curl_easy_strerror(code));
 
+#if HAVE_ZSTD
+        if (arg_compress) {
+                int r;
+
+                r = setup_compression(u, input_callback, data);
+                if (r < 0)
+                        return r;
+        }
+#endif
+
         u->uploading = true;
 
         return 0;
@@ -463,6 +582,11 @@ static void destroy_uploader(Uploader *u) {
         curl_slist_free_all(u->header);
         free(u->answer);
 
+#if HAVE_ZSTD
+        ZSTD_freeCCtx(u->zstd);
+        free(u->zstd_buffer);
+#endif
+
         free(u->last_cursor);
         free(u->current_cursor);
 
@@ -565,6 +689,7 @@ static int parse_config(void) {
                 { "Upload",  "ServerKeyFile",          config_parse_path_or_ignore, 0, &arg_key    },
                 { "Upload",  "ServerCertificateFile",  config_parse_path_or_ignore, 0, &arg_cert   },
                 { "Upload",  "TrustedCertificateFile", config_parse_path_or_ignore, 0, &arg_trust  },
+                { "Upload",  "Compression",            config_parse_bool,           0, &arg_compress },
                 {}
         };
 
@@ -609,6 +734,7 @@ static int help(void) {
                "     --follow[=BOOL]        Do [not] wait for input\n"
                "     --save-state[=FILE]    Save uploaded cursors (default \n"
                "                            " STATE_FILE ")\n"
+               "     --compress[=BOOL]      Do [not] compress uploaded data with zstd\n"
                "\nSee the %s for details.\n",
                program_invocation_short_name,
                link);
@@ -629,6 +755,7 @@ static int parse_argv(int argc, char *argv[]) {
                 ARG_AFTER_CURSOR,
                 ARG_FOLLOW,
                 ARG_SAVE_STATE,
+                ARG_COMPRESS,
         };
 
         static const struct option options[] = {
@@ -648,6 +775,7 @@ static int parse_argv(int argc, char *argv[]) {
                 { "after-cursor", required_argument, NULL, ARG_AFTER_CURSOR   },
                 { "follow",       optional_argument, NULL, ARG_FOLLOW         },
                 { "save-state",   optional_argument, NULL, ARG_SAVE_STATE     },
+                { "compress",     optional_argument, NULL, ARG_COMPRESS       },
                 {}
         };
 
@@ -760,6 +888,12 @@ static int parse_argv(int argc, char *argv[]) {
                         arg_save_state = optarg ?: STATE_FILE;
                         break;
 
+                case ARG_COMPRESS:
+                        r = parse_boolean_argument("--compress", optarg, &arg_compress);
+                        if (r < 0)
+                                return r;
+                        break;
+
                 case '?':
                         return log_error_errno(SYNTHETIC_ERRNO(EINVAL),
                                                "Unknown option %s.",
@@ -786,6 +920,10 @@ static int parse_argv(int argc, char *argv[]) {
                 return log_error_errno(SYNTHETIC_ERRNO(EINVAL),
                                        "Input arguments make no sense with journal input.");
 
+        if (arg_compress && !HAVE_ZSTD)
+                return log_error_errno(SYNTHETIC_ERRNO(EOPNOTSUPP),
+                                       "Compression requested, but zstd support is not compiled in.");
+
         return 1;
 }
 
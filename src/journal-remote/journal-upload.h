@@ -4,6 +4,10 @@
 
 #include <inttypes.h>
 
+#if HAVE_ZSTD
+#include <zstd.h>
+#endif
+
 #include "sd-event.h"
 #include "sd-journal.h"
 
@@ -43,6 +47,16 @@ typedef struct Uploader {
         /* journal stuff */
         sd_journal* journal;
 
+#if HAVE_ZSTD
+        /* compression stuff */
+        ZSTD_CCtx *zstd;
+        void *zstd_buffer;
+        size_t zstd_buffer_size, zstd_buffer_pos, zstd_buffer_len;
+        bool zstd_input_eof, zstd_done;
+        size_t (*zstd_input_callback)(void *ptr, size_t size, size_t nmemb, void *userdata);
+        void *zstd_input_data;
+#endif
+
         entry_state entry_state;
         const void *field_data;
         size_t field_pos, field_length;
@@ -0,0 +1,458 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <pthread.h>
+#include <signal.h>
+
+#include "alloc-util.h"
+#include "fd-util.h"
+#include "fileio.h"
+#include "hashmap.h"
+#include "journal-internal.h"
+#include "journalctl-parallel.h"
+#include "logs-show.h"
+#include "set.h"
+#include "string-util.h"
+#include "strv.h"
+
+/* Number of entries handed to a worker at once */
+#define CHUNK_ENTRIES 256U
+
+/* Number of chunks in flight per worker */
+#define CHUNKS_PER_THREAD 4U
+
+typedef struct ParallelEntry {
+        const char *path; /* interned in ParallelOutput.paths */
+        uint64_t offset;
+} ParallelEntry;
+
+typedef struct ParallelChunk {
+        ParallelEntry entries[CHUNK_ENTRIES];
+        size_t n_entries;
+
+        /* Set by the worker */
+        bool done;
+        char *buffer;
+        size_t size;
+        int error;
+} ParallelChunk;
+
+typedef struct ParallelWorker {
+        ParallelOutput *parent;
+
+        pthread_t thread;
+        bool started;
+
+        sd_journal *journal;
+        Hashmap *extra_journals; /* path → sd_journal, for files that were added after we started */
+} ParallelWorker;
+
+struct ParallelOutput {
+        FILE *f;
+        OutputMode mode;
+        OutputFlags flags;
+        char **output_fields;
+
+        Set *paths;
+        JournalFile *last_file;
+        const char *last_path;
+
+        /* Chunks are queued, taken by the workers and written out in order, using a ring buffer. The
+         * counters only ever increase. The chunk with index n_queued is filled by the main thread, and
+         * the chunks between n_written and n_queued are owned by the workers until they are done. */
+        pthread_mutex_t mutex;
+        pthread_cond_t cond;
+        bool quit;
+
+        ParallelChunk *chunks;
+        size_t n_chunks;
+        uint64_t n_queued, n_taken, n_written;
+
+        ParallelWorker *workers;
+        unsigned n_workers;
+};
+
+bool parallel_output_mode_supported(OutputMode mode) {
+        /* Only output modes that format each entry on its own, without state carried over from the
+         * previous one, and which don't highlight --grep matches */
+        return IN_SET(mode,
+                      OUTPUT_EXPORT,
+                      OUTPUT_JSON,
+                      OUTPUT_JSON_PRETTY,
+                      OUTPUT_JSON_SSE,
+                      OUTPUT_JSON_SEQ);
+}
+
+static int parallel_worker_get_journal(ParallelWorker *w, const ParallelEntry *e, sd_journal **ret) {
+        sd_journal *j;
+        int r;
+
+        assert(w);
+        assert(e);
+        assert(ret);
+
+        r = journal_seek_entry(w->journal, e->path, e->offset);
+        if (r != -ENOENT) {
+                *ret = w->journal;
+                return r;
+        }
+
+        /* A file that appeared after we opened ours, let's open it on its own */
+        j = hashmap_get(w->extra_journals, e->path);
+        if (!j) {
+                r = sd_journal_open_files(&j, (const char**) STRV_MAKE(e->path), 0);
+                if (r < 0)
+                        return r;
+
+                r = hashmap_ensure_put(&w->extra_journals, &string_hash_ops, e->path, j);
+                if (r < 0) {
+                        sd_journal_close(j);
+                        return r;
+                }
+        }
+
+        *ret = j;
+        return journal_seek_entry(j, e->path, e->offset);
+}
+
+static int parallel_worker_format(ParallelWorker *w, ParallelChunk *c) {
+        ParallelOutput *p;
+        FILE *m;
+        int r = 0;
+
+        assert(w);
+        assert(c);
+
+        p = w->parent;
+
+        m = open_memstream_unlocked(&c->buffer, &c->size);
+        if (!m)
+                return -ENOMEM;
+
+        for (size_t i = 0; i < c->n_entries; i++) {
+                sd_journal *j;
+
+                r = parallel_worker_get_journal(w, c->entries + i, &j);
+                if (r >= 0)
+                        r = show_journal_entry(m, j, p->mode, 0, p->flags, p->output_fields, NULL, NULL);
+                if (r == -EADDRNOTAVAIL) /* The file went away or got truncated in the meantime */
+                        r = 0;
+                if (r < 0)
+                        break;
+        }
+
+        if (r >= 0)
+                r = fflush_and_check(m);
+
+        /* This updates the buffer one last time, which is ours to free either way */
+        fclose(m);
+
+        return r;
+}
+
+static void *parallel_worker_thread(void *userdata) {
+        ParallelWorker *w = userdata;
+        ParallelOutput *p;
+
+        assert(w);
+
+        p = w->parent;
+
+        (void) pthread_setname_np(pthread_self(), "journalctl-out");
+
+        assert_se(pthread_mutex_lock(&p->mutex) == 0);
+
+        for (;;) {
+                ParallelChunk *c;
+                int r;
+
+                while (!p->quit && p->n_taken == p->n_queued)
+                        assert_se(pthread_cond_wait(&p->cond, &p->mutex) == 0);
+                if (p->quit)
+                        break;
+
+                c = p->chunks + p->n_taken++ % p->n_chunks;
+
+                assert_se(pthread_mutex_unlock(&p->mutex) == 0);
+                r = parallel_worker_format(w, c);
+                assert_se(pthread_mutex_lock(&p->mutex) == 0);
+
+                c->error = r;
+                c->done = true;
+                assert_se(pthread_cond_broadcast(&p->cond) == 0);
+        }
+
+        assert_se(pthread_mutex_unlock(&p->mutex) == 0);
+
+        return NULL;
+}
+
+int parallel_output_new(
+                sd_journal *j,
+                unsigned n_threads,
+                FILE *f,
+                OutputMode mode,
+                OutputFlags flags,
+                char **output_fields,
+                ParallelOutput **ret) {
+
+        _cleanup_(parallel_output_freep) ParallelOutput *p = NULL;
+        _cleanup_strv_free_ char **paths = NULL;
+        sigset_t ss, saved_ss;
+        JournalFile *jf;
+        int r;
+
+        assert(j);
+        assert(n_threads > 0);
+        assert(f);
+        assert(parallel_output_mode_supported(mode));
+        assert(ret);
+
+        n_threads = MIN(n_threads, PARALLEL_OUTPUT_THREADS_MAX);
+
+        ORDERED_HASHMAP_FOREACH(jf, j->files) {
+                r = strv_extend(&paths, jf->path);
+                if (r < 0)
+                        return r;
+        }
+
+        p = new(ParallelOutput, 1);
+        if (!p)
+                return -ENOMEM;
+
+        *p = (ParallelOutput) {
+                .f = f,
+                .mode = mode,
+                .flags = flags,
+                .mutex = PTHREAD_MUTEX_INITIALIZER,
+                .cond = PTHREAD_COND_INITIALIZER,
+        };
+
+        p->output_fields = strv_copy(output_fields);
+        if (output_fields && !p->output_fields)
+                return -ENOMEM;
+
+        p->n_chunks = n_threads * CHUNKS_PER_THREAD;
+        p->chunks = new0(ParallelChunk, p->n_chunks);
+        p->workers = new0(ParallelWorker, n_threads);
+        if (!p->chunks || !p->workers)
+                return -ENOMEM;
+
+        /* Each worker gets its own journal object, and thus its own mmap cache. They are opened here, so
+         * that they are freed by the thread that allocated them. */
+        for (; p->n_workers < n_threads; p->n_workers++) {
+                ParallelWorker *w = p->workers + p->n_workers;
+
+                w->parent = p;
+
+                r = sd_journal_open_files(&w->journal, (const char**) paths, 0);
+                if (r < 0)
+                        return r;
+        }
+
+        /* The workers don't handle any signals */
+        assert_se(sigfillset(&ss) >= 0);
+        r = pthread_sigmask(SIG_BLOCK, &ss, &saved_ss);
+        if (r > 0)
+                return -r;
+
+        for (unsigned i = 0; i < p->n_workers; i++) {
+                r = pthread_create(&p->workers[i].thread, NULL, parallel_worker_thread, p->workers + i);
+                if (r > 0) {
+                        r = -r;
+                        break;
+                }
+
+                p->workers[i].started = true;
+        }
+
+        (void) pthread_sigmask(SIG_SETMASK, &saved_ss, NULL);
+
+        if (r < 0)
+                return r;
+
+        *ret = TAKE_PTR(p);
+        return 0;
+}
+
+ParallelOutput* parallel_output_free(ParallelOutput *p) {
+        if (!p)
+                return NULL;
+
+        assert_se(pthread_mutex_lock(&p->mutex) == 0);
+        p->quit = true;
+        assert_se(pthread_cond_broadcast(&p->cond) == 0);
+        assert_se(pthread_mutex_unlock(&p->mutex) == 0);
+
+        for (unsigned i = 0; i < p->n_workers; i++) {
+                ParallelWorker *w = p->workers + i;
+                sd_journal *j;
+
+                if (w->started)
+                        (void) pthread_join(w->thread, NULL);
+
+                sd_journal_close(w->journal);
+
+                while ((j = hashmap_steal_first(w->extra_journals)))
+                        sd_journal_close(j);
+                hashmap_free(w->extra_journals);
+        }
+
+        for (size_t i = 0; i < p->n_chunks; i++)
+                free(p->chunks[i].buffer);
+
+        free(p->workers);
+        free(p->chunks);
+        set_free_free(p->paths);
+        strv_free(p->output_fields);
+
+        assert_se(pthread_cond_destroy(&p->cond) == 0);
+        assert_se(pthread_mutex_destroy(&p->mutex) == 0);
+
+        return mfree(p);
+}
+
+static int parallel_output_write_one(ParallelOutput *p, bool wait) {
+        ParallelChunk *c;
+        int r;
+
+        assert(p);
+
+        /* Writes out the oldest chunk, if it has been formatted already. Returns > 0 if something was
+         * written, 0 if there's nothing (yet). */
+
+        if (p->n_written == p->n_queued)
+                return 0;
+
+        c = p->chunks + p->n_written % p->n_chunks;
+
+        assert_se(pthread_mutex_lock(&p->mutex) == 0);
+        while (!c->done) {
+                if (!wait) {
+                        assert_se(pthread_mutex_unlock(&p->mutex) == 0);
+                        return 0;
+                }
+
+                assert_se(pthread_cond_wait(&p->cond, &p->mutex) == 0);
+        }
+        assert_se(pthread_mutex_unlock(&p->mutex) == 0);
+
+        r = c->error;
+        if (r < 0)
+                return log_error_errno(r, "Failed to format journal entries: %m");
+
+        fwrite(c->buffer, 1, c->size, p->f);
+
+        c->buffer = mfree(c->buffer);
+        c->size = 0;
+        c->n_entries = 0;
+        c->done = false;
+
+        p->n_written++;
+        return 1;
+}
+
+static void parallel_output_queue(ParallelOutput *p) {
+        assert(p);
+
+        /* Hands the chunk that is being filled to the workers */
+
+        assert_se(pthread_mutex_lock(&p->mutex) == 0);
+        p->n_queued++;
+        assert_se(pthread_cond_signal(&p->cond) == 0);
+        assert_se(pthread_mutex_unlock(&p->mutex) == 0);
+}
+
+static int parallel_output_intern_path(ParallelOutput *p, JournalFile *f, const char **ret) {
+        const char *path;
+        int r;
+
+        assert(p);
+        assert(f);
+        assert(ret);
+
+        /* The journal files of the journal we iterate over might be closed before the workers get to
+         * their entries, hence keep our own copy of their paths. Usually we get many entries in a row
+         * from the same file. */
+
+        if (f == p->last_file && streq(f->path, p->last_path)) {
+                *ret = p->last_path;
+                return 0;
+        }
+
+        path = set_get(p->paths, f->path);
+        if (!path) {
+                r = set_put_strdup(&p->paths, f->path);
+                if (r < 0)
+                        return r;
+
+                assert_se(path = set_get(p->paths, f->path));
+        }
+
+        p->last_file = f;
+        *ret = p->last_path = path;
+        return 0;
+}
+
+int parallel_output_add(ParallelOutput *p, sd_journal *j) {
+        ParallelChunk *c;
+        const char *path;
+        int r;
+
+        assert(p);
+        assert(j);
+
+        /* Queues the current entry of the specified journal for output */
+
+        if (!j->current_file)
+                return -EADDRNOTAVAIL;
+
+        r = parallel_output_intern_path(p, j->current_file, &path);
+        if (r < 0)
+                return log_oom();
+
+        /* Make sure the chunk we fill is not in use anymore */
+        while (p->n_queued - p->n_written >= p->n_chunks) {
+                r = parallel_output_write_one(p, true);
+                if (r < 0)
+                        return r;
+        }
+
+        c = p->chunks + p->n_queued % p->n_chunks;
+        c->entries[c->n_entries++] = (ParallelEntry) {
+                .path = path,
+                .offset = j->current_file->current_offset,
+        };
+
+        if (c->n_entries >= CHUNK_ENTRIES)
+                parallel_output_queue(p);
+
+        /* Write out whatever is ready already, but don't wait for it */
+        do {
+                r = parallel_output_write_one(p, false);
+                if (r < 0)
+                        return r;
+        } while (r > 0);
+
+        return 0;
+}
+
+int parallel_output_flush(ParallelOutput *p) {
+        int r;
+
+        assert(p);
+
+        /* Writes out everything queued so far, in order */
+
+        /* Queue the chunk that is being filled, if there is one */
+        if (p->n_queued - p->n_written < p->n_chunks &&
+            p->chunks[p->n_queued % p->n_chunks].n_entries > 0)
+                parallel_output_queue(p);
+
+        while (p->n_written < p->n_queued) {
+                r = parallel_output_write_one(p, true);
+                if (r < 0)
+                        return r;
+        }
+
+        return 0;
+}
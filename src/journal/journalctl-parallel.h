@@ -0,0 +1,31 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+#pragma once
+
+#include <stdio.h>
+
+#include "sd-journal.h"
+
+#include "macro.h"
+#include "output-mode.h"
+
+/* Formats the entries a journal object iterates over in worker threads, each with its own journal object
+ * (and hence its own mmap cache) on the same files, and writes the results out in order. */
+typedef struct ParallelOutput ParallelOutput;
+
+#define PARALLEL_OUTPUT_THREADS_MAX 64U
+
+bool parallel_output_mode_supported(OutputMode mode);
+
+int parallel_output_new(
+                sd_journal *j,
+                unsigned n_threads,
+                FILE *f,
+                OutputMode mode,
+                OutputFlags flags,
+                char **output_fields,
+                ParallelOutput **ret);
+ParallelOutput* parallel_output_free(ParallelOutput *p);
+DEFINE_TRIVIAL_CLEANUP_FUNC(ParallelOutput*, parallel_output_free);
+
+int parallel_output_add(ParallelOutput *p, sd_journal *j);
+int parallel_output_flush(ParallelOutput *p);
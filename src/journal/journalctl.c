@@ -40,10 +40,12 @@
 #include "id128-print.h"
 #include "io-util.h"
 #include "journal-def.h"
+#include "journal-grep-index.h"
 #include "journal-internal.h"
 #include "journal-util.h"
 #include "journal-vacuum.h"
 #include "journal-verify.h"
+#include "journalctl-parallel.h"
 #include "locale-util.h"
 #include "log.h"
 #include "logs-show.h"
@@ -129,10 +131,13 @@ static uint64_t arg_vacuum_size = 0;
 static uint64_t arg_vacuum_n_files = 0;
 static usec_t arg_vacuum_time = 0;
 static char **arg_output_fields = NULL;
+static unsigned arg_threads = 0;
 #if HAVE_PCRE2
 static const char *arg_pattern = NULL;
 static pcre2_code *arg_compiled_pattern = NULL;
 static int arg_case_sensitive = -1; /* -1 means be smart */
+static uint32_t *arg_pattern_trigrams = NULL;
+static size_t arg_n_pattern_trigrams = 0;
 #endif
 
 static enum {
@@ -187,6 +192,76 @@ static int pattern_compile(const char *pattern, unsigned flags, pcre2_code **out
         *out = p;
         return 0;
 }
+
+/* The DATA objects that might match the pattern, according to the grep index of a journal file */
+typedef struct GrepCandidates {
+        bool indexed;
+        uint32_t *offsets;
+        size_t n_offsets;
+} GrepCandidates;
+
+static GrepCandidates* grep_candidates_free(GrepCandidates *c) {
+        if (!c)
+                return NULL;
+
+        free(c->offsets);
+        return mfree(c);
+}
+
+DEFINE_TRIVIAL_CLEANUP_FUNC(GrepCandidates*, grep_candidates_free);
+
+DEFINE_PRIVATE_HASH_OPS_FULL(grep_candidates_hash_ops, char, string_hash_func, string_compare_func, free,
+                             GrepCandidates, grep_candidates_free);
+
+static Hashmap *grep_candidates = NULL;
+
+static int grep_index_may_match(sd_journal *j) {
+        GrepCandidates *c;
+        JournalFile *f;
+        Object *o;
+        int r;
+
+        /* Returns 0 if the grep index of the journal file says that the current entry can't match the
+         * pattern, > 0 if it might, or if there's no index. */
+
+        f = j->current_file;
+        if (arg_n_pattern_trigrams == 0 || !f)
+                return 1;
+
+        c = hashmap_get(grep_candidates, f->path);
+        if (!c) {
+                _cleanup_(grep_candidates_freep) GrepCandidates *n = NULL;
+                _cleanup_free_ char *path = NULL;
+
+                path = strdup(f->path);
+                n = new0(GrepCandidates, 1);
+                if (!path || !n)
+                        return log_oom();
+
+                r = journal_grep_index_query(f, arg_pattern_trigrams, arg_n_pattern_trigrams, &n->offsets, &n->n_offsets);
+                if (r < 0)
+                        log_debug_errno(r, "Failed to read grep index of %s, ignoring: %m", f->path);
+                else if (r > 0)
+                        log_debug("Using grep index of %s, %zu candidate messages.", f->path, n->n_offsets);
+                n->indexed = r > 0;
+
+                r = hashmap_ensure_put(&grep_candidates, &grep_candidates_hash_ops, path, n);
+                if (r < 0)
+                        return log_oom();
+
+                TAKE_PTR(path);
+                c = TAKE_PTR(n);
+        }
+
+        if (!c->indexed)
+                return 1;
+
+        r = journal_file_move_to_object(f, OBJECT_ENTRY, f->current_offset, &o);
+        if (r < 0)
+                return 1; /* Let the real matching deal with it */
+
+        return journal_grep_index_entry_may_match(f, o, c->offsets, c->n_offsets);
+}
 #endif
 
 static int add_matches_for_device(sd_journal *j, const char *devpath) {
@@ -365,6 +440,7 @@ static int help(void) {
                "                               json, json-pretty, json-sse, json-seq, cat,\n"
                "                               with-unit)\n"
                "     --output-fields=LIST    Select fields to print in verbose/export/json modes\n"
+               "     --threads=N             Format export/json output in N threads\n"
                "     --utc                   Express time in Coordinated Universal Time (UTC)\n"
                "  -x --catalog               Add message explanations where available\n"
                "     --no-full               Ellipsize fields\n"
@@ -454,6 +530,7 @@ static int parse_argv(int argc, char *argv[]) {
                 ARG_VACUUM_TIME,
                 ARG_NO_HOSTNAME,
                 ARG_OUTPUT_FIELDS,
+                ARG_THREADS,
                 ARG_NAMESPACE,
         };
 
@@ -521,6 +598,7 @@ static int parse_argv(int argc, char *argv[]) {
                 { "vacuum-time",          required_argument, NULL, ARG_VACUUM_TIME          },
                 { "no-hostname",          no_argument,       NULL, ARG_NO_HOSTNAME          },
                 { "output-fields",        required_argument, NULL, ARG_OUTPUT_FIELDS        },
+                { "threads",              required_argument, NULL, ARG_THREADS              },
                 { "namespace",            required_argument, NULL, ARG_NAMESPACE            },
                 {}
         };
@@ -765,6 +843,15 @@ static int parse_argv(int argc, char *argv[]) {
                         arg_action = arg_action == ACTION_ROTATE ? ACTION_ROTATE_AND_VACUUM : ACTION_VACUUM;
                         break;
 
+                case ARG_THREADS:
+                        r = safe_atou(optarg, &arg_threads);
+                        if (r < 0)
+                                return log_error_errno(r, "Failed to parse number of threads: %s", optarg);
+                        if (arg_threads > PARALLEL_OUTPUT_THREADS_MAX)
+                                return log_error_errno(SYNTHETIC_ERRNO(ERANGE),
+                                                       "Number of threads must be at most %u.", PARALLEL_OUTPUT_THREADS_MAX);
+                        break;
+
                 case ARG_VACUUM_FILES:
                         r = safe_atou64(optarg, &arg_vacuum_n_files);
                         if (r < 0)
@@ -1068,6 +1155,14 @@ static int parse_argv(int argc, char *argv[]) {
                 return log_error_errno(SYNTHETIC_ERRNO(EINVAL),
                                        "Please specify either --reverse= or --follow=, not both.");
 
+        if (arg_threads > 1 && arg_follow)
+                return log_error_errno(SYNTHETIC_ERRNO(EINVAL),
+                                       "--threads= is not supported with --follow.");
+
+        if (arg_threads > 1 && !parallel_output_mode_supported(arg_output))
+                return log_error_errno(SYNTHETIC_ERRNO(EINVAL),
+                                       "--threads= is only supported with the export and json output modes.");
+
         if (!IN_SET(arg_action, ACTION_SHOW, ACTION_DUMP_CATALOG, ACTION_LIST_CATALOG) && optind < argc)
                 return log_error_errno(SYNTHETIC_ERRNO(EINVAL),
                                        "Extraneous arguments starting with '%s'",
@@ -1124,6 +1219,11 @@ static int parse_argv(int argc, char *argv[]) {
                 r = pattern_compile(arg_pattern, flags, &arg_compiled_pattern);
                 if (r < 0)
                         return r;
+
+                /* The grep index is case insensitive, hence the casing doesn't matter for it */
+                r = journal_grep_pattern_trigrams(arg_pattern, &arg_pattern_trigrams, &arg_n_pattern_trigrams);
+                if (r < 0)
+                        return log_oom();
         }
 #endif
 
@@ -2131,6 +2231,7 @@ int main(int argc, char *argv[]) {
         bool previous_boot_id_valid = false, first_line = true, ellipsized = false, need_seek = false;
         bool use_cursor = false, after_cursor = false;
         _cleanup_(sd_journal_closep) sd_journal *j = NULL;
+        _cleanup_(parallel_output_freep) ParallelOutput *parallel = NULL;
         sd_id128_t previous_boot_id;
         int n_shown = 0, r, poll_fd = -1;
 
@@ -2314,6 +2415,9 @@ int main(int argc, char *argv[]) {
         if (r < 0)
                 goto finish;
 
+        /* We usually read the journal in file order, let the kernel read ahead for us on cold caches */
+        journal_set_prefetch(j, true);
+
         switch (arg_action) {
 
         case ACTION_NEW_ID128:
@@ -2614,6 +2718,17 @@ int main(int argc, char *argv[]) {
                 }
         }
 
+        if (arg_threads > 1) {
+                r = parallel_output_new(j, arg_threads, stdout, arg_output,
+                                        arg_all * OUTPUT_SHOW_ALL |
+                                        arg_full * OUTPUT_FULL_WIDTH |
+                                        colors_enabled() * OUTPUT_COLOR |
+                                        arg_utc * OUTPUT_UTC,
+                                        arg_output_fields, &parallel);
+                if (r < 0)
+                        log_warning_errno(r, "Failed to start output threads, continuing without: %m");
+        }
+
         for (;;) {
                 while (arg_lines < 0 || n_shown < arg_lines || (arg_follow && !first_line)) {
                         int flags;
@@ -2662,9 +2777,17 @@ int main(int argc, char *argv[]) {
                                 r = sd_journal_get_monotonic_usec(j, NULL, &boot_id);
                                 if (r >= 0) {
                                         if (previous_boot_id_valid &&
-                                            !sd_id128_equal(boot_id, previous_boot_id))
+                                            !sd_id128_equal(boot_id, previous_boot_id)) {
+                                                /* Everything before has to be written out first */
+                                                if (parallel) {
+                                                        r = parallel_output_flush(parallel);
+                                                        if (r < 0)
+                                                                goto finish;
+                                                }
+
                                                 printf("%s-- Boot "SD_ID128_FORMAT_STR" --%s\n",
                                                        ansi_highlight(), SD_ID128_FORMAT_VAL(boot_id), ansi_normal());
+                                        }
 
                                         previous_boot_id = boot_id;
                                         previous_boot_id_valid = true;
@@ -2678,6 +2801,14 @@ int main(int argc, char *argv[]) {
                                 size_t len;
                                 PCRE2_SIZE *ovec;
 
+                                r = grep_index_may_match(j);
+                                if (r < 0)
+                                        goto finish;
+                                if (r == 0) {
+                                        need_seek = true;
+                                        continue;
+                                }
+
                                 md = sym_pcre2_match_data_create(1, NULL);
                                 if (!md)
                                         return log_oom();
@@ -2731,8 +2862,11 @@ int main(int argc, char *argv[]) {
                                 arg_utc * OUTPUT_UTC |
                                 arg_no_hostname * OUTPUT_NO_HOSTNAME;
 
-                        r = show_journal_entry(stdout, j, arg_output, 0, flags,
-                                               arg_output_fields, highlight, &ellipsized);
+                        if (parallel)
+                                r = parallel_output_add(parallel, j);
+                        else
+                                r = show_journal_entry(stdout, j, arg_output, 0, flags,
+                                                       arg_output_fields, highlight, &ellipsized);
                         need_seek = true;
                         if (r == -EADDRNOTAVAIL)
                                 break;
@@ -2756,6 +2890,12 @@ int main(int argc, char *argv[]) {
                         }
                 }
 
+                if (parallel) {
+                        r = parallel_output_flush(parallel);
+                        if (r < 0)
+                                goto finish;
+                }
+
                 if (!arg_follow) {
                         if (n_shown == 0 && !arg_quiet)
                                 printf("-- No entries --\n");
@@ -2808,6 +2948,9 @@ finish:
         free(arg_verify_key);
 
 #if HAVE_PCRE2
+        hashmap_free(grep_candidates);
+        free(arg_pattern_trigrams);
+
         if (arg_compiled_pattern) {
                 sym_pcre2_code_free(arg_compiled_pattern);
 
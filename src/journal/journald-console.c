@@ -16,6 +16,9 @@
 #include "stdio-util.h"
 #include "terminal-util.h"
 
+/* Warn once every 30s if we missed console messages */
+#define WARN_FORWARD_CONSOLE_MISSED_USEC (30 * USEC_PER_SEC)
+
 static bool prefix_timestamp(void) {
 
         static int cached_printk_time = -1;
@@ -90,14 +93,44 @@ void server_forward_console(
         /* Before you ask: yes, on purpose we open/close the console for each log line we write individually. This is a
          * good strategy to avoid journald getting killed by the kernel's SAK concept (it doesn't fix this entirely,
          * but minimizes the time window the kernel might end up killing journald due to SAK). It also makes things
-         * easier for us so that we don't have to recover from hangups and suchlike triggered on the console. */
+         * easier for us so that we don't have to recover from hangups and suchlike triggered on the console.
+         *
+         * We open the console in non-blocking mode: a slow (e.g. serial) console shouldn't stall the
+         * processing of log messages for everybody else. If the output buffer is full we drop the line. */
 
-        fd = open_terminal(tty, O_WRONLY|O_NOCTTY|O_CLOEXEC);
+        fd = open_terminal(tty, O_WRONLY|O_NOCTTY|O_CLOEXEC|O_NONBLOCK);
         if (fd < 0) {
                 log_debug_errno(fd, "Failed to open %s for logging: %m", tty);
                 return;
         }
 
-        if (writev(fd, iovec, n) < 0)
+        if (writev(fd, iovec, n) < 0) {
+                if (errno == EAGAIN) {
+                        s->n_forward_console_missed++;
+                        return;
+                }
+
                 log_debug_errno(errno, "Failed to write to %s for logging: %m", tty);
+        }
+}
+
+void server_maybe_warn_forward_console_missed(Server *s) {
+        usec_t n;
+
+        assert(s);
+
+        if (s->n_forward_console_missed <= 0)
+                return;
+
+        n = now(CLOCK_MONOTONIC);
+        if (s->last_warn_forward_console_missed + WARN_FORWARD_CONSOLE_MISSED_USEC > n)
+                return;
+
+        server_driver_message(s, 0, NULL,
+                              LOG_MESSAGE("Forwarding to console missed %u messages.",
+                                          s->n_forward_console_missed),
+                              NULL);
+
+        s->n_forward_console_missed = 0;
+        s->last_warn_forward_console_missed = n;
 }
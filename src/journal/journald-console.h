@@ -4,3 +4,5 @@
 #include "journald-server.h"
 
 void server_forward_console(Server *s, int priority, const char *identifier, const char *message, const struct ucred *ucred);
+
+void server_maybe_warn_forward_console_missed(Server *s);
@@ -14,6 +14,7 @@
 #include "io-util.h"
 #include "journal-util.h"
 #include "journald-context.h"
+#include "journald-rate-limit.h"
 #include "parse-util.h"
 #include "path-util.h"
 #include "process-util.h"
@@ -48,6 +49,11 @@
  *    stream connection. This should improve cases where a service process logs immediately before exiting and we
  *    previously had trouble associating the log message with the service.
  *
+ * Metadata derived from the cgroup path of a client and from the unit it belongs to (i.e. the unit name, invocation
+ * ID, log level and extra fields) is kept in a separate ClientCgroup object, which is shared between all clients in
+ * the same cgroup. Since that's typically where most of the data read from /run lives, short-lived processes of a
+ * service don't need to reread it, but only the few per-process fields from /proc.
+ *
  * NB: With and without the metadata cache: the implicitly added entry metadata in the journal (with the exception of
  *     UID/PID/GID and SELinux label) must be understood as possibly slightly out of sync (i.e. sometimes slightly older
  *     and sometimes slightly newer than what was current at the log event).
@@ -59,15 +65,16 @@
 /* Data older than 5s we flush out */
 #define MAX_USEC (5*USEC_PER_SEC)
 
-/* Keep at most 16K entries in the cache. (Note though that this limit may be violated if enough streams pin entries in
- * the cache, in which case we *do* permit this limit to be breached. That's safe however, as the number of stream
- * clients itself is limited.) */
-#define CACHE_MAX_FALLBACK 128U
+/* Keep at most 16K entries in the cache, and no more than fit into the memory budget calculated below. (Note though
+ * that this limit may be violated if enough streams pin entries in the cache, in which case we *do* permit this limit
+ * to be breached. That's safe however, as the number of stream clients itself is limited.) We always permit at least
+ * CACHE_MAX_MIN entries though, regardless of their size. */
 #define CACHE_MAX_MAX (16*1024U)
 #define CACHE_MAX_MIN 64U
+#define CACHE_BUDGET_FALLBACK (64U*1024U*1024U)
 
-static size_t cache_max(void) {
-        static size_t cached = -1;
+static size_t cache_budget(void) {
+        static size_t cached = SIZE_MAX;
 
         if (cached == SIZE_MAX) {
                 uint64_t mem_total;
@@ -76,28 +83,198 @@ static size_t cache_max(void) {
                 r = procfs_memory_get(&mem_total, NULL);
                 if (r < 0) {
                         log_warning_errno(r, "Cannot query /proc/meminfo for MemTotal: %m");
-                        cached = CACHE_MAX_FALLBACK;
+                        cached = CACHE_BUDGET_FALLBACK;
                 } else
                         /* Cache entries are usually a few kB, but the process cmdline is controlled by the
-                         * user and can be up to _SC_ARG_MAX, usually 2MB. Let's say that approximately up to
-                         * 1/8th of memory may be used by the cache.
-                         *
-                         * In the common case, this formula gives 64 cache entries for each GB of RAM.
-                         */
-                        cached = CLAMP(mem_total / 8 / sc_arg_max(), CACHE_MAX_MIN, CACHE_MAX_MAX);
+                         * user and can be up to _SC_ARG_MAX, usually 2MB. Hence we account for the actual
+                         * size of the entries, rather than their number, and let approximately up to 1/8th
+                         * of memory be used by the cache. */
+                        cached = MIN(mem_total / 8, (uint64_t) SIZE_MAX - 1);
         }
 
         return cached;
 }
 
-static int client_context_compare(const void *a, const void *b) {
-        const ClientContext *x = a, *y = b;
+static bool cache_over_limit(Server *s, size_t limit) {
+        size_t n;
+
+        assert(s);
+
+        n = hashmap_size(s->client_contexts);
+        if (n > limit)
+                return true;
+
+        return n > CACHE_MAX_MIN && s->client_contexts_size > cache_budget();
+}
+
+static size_t client_cgroup_size(const ClientCgroup *g) {
+        assert(g);
+
+        return sizeof(ClientCgroup) +
+                strlen_ptr(g->path) +
+                strlen_ptr(g->session) +
+                strlen_ptr(g->unit) +
+                strlen_ptr(g->user_unit) +
+                strlen_ptr(g->slice) +
+                strlen_ptr(g->user_slice) +
+                g->extra_fields_n_iovec * sizeof(struct iovec) +
+                IOVEC_TOTAL_SIZE(g->extra_fields_iovec, g->extra_fields_n_iovec);
+}
+
+static void client_cgroup_update_size(Server *s, ClientCgroup *g) {
+        assert(s);
+        assert(g);
+        assert(s->client_contexts_size >= g->size);
+
+        s->client_contexts_size -= g->size;
+        g->size = client_cgroup_size(g);
+        s->client_contexts_size += g->size;
+}
+
+static size_t client_context_size(const ClientContext *c) {
+        assert(c);
+
+        return sizeof(ClientContext) +
+                strlen_ptr(c->comm) +
+                strlen_ptr(c->exe) +
+                strlen_ptr(c->cmdline) +
+                strlen_ptr(c->capeff) +
+                c->label_size;
+}
+
+static void client_context_update_size(Server *s, ClientContext *c) {
+        assert(s);
+        assert(c);
+        assert(s->client_contexts_size >= c->size);
+
+        s->client_contexts_size -= c->size;
+        c->size = client_context_size(c);
+        s->client_contexts_size += c->size;
+}
+
+static void client_cgroup_reset_unit_data(Server *s, ClientCgroup *g) {
+        assert(s);
+        assert(g);
+
+        g->timestamp = USEC_INFINITY;
+
+        g->invocation_id = SD_ID128_NULL;
+
+        g->log_level_max = -1;
+
+        g->extra_fields_iovec = mfree(g->extra_fields_iovec);
+        g->extra_fields_n_iovec = 0;
+        g->extra_fields_data = mfree(g->extra_fields_data);
+        g->extra_fields_mtime = NSEC_INFINITY;
+
+        g->log_ratelimit_interval = s->ratelimit_interval;
+        g->log_ratelimit_burst = s->ratelimit_burst;
+}
+
+static int client_cgroup_new(Server *s, const char *path, const char *unit_id, ClientCgroup **ret) {
+        ClientCgroup *g;
         int r;
 
-        r = CMP(x->timestamp, y->timestamp);
-        if (r != 0)
+        assert(s);
+        assert(!!path != !!unit_id);
+        assert(ret);
+
+        /* Creates a new cgroup object, either shared for the specified cgroup path, or private to one
+         * client, if all we know is the unit name. */
+
+        g = new(ClientCgroup, 1);
+        if (!g)
+                return -ENOMEM;
+
+        *g = (ClientCgroup) {
+                .n_ref = 1,
+                .owner_uid = UID_INVALID,
+        };
+
+        client_cgroup_reset_unit_data(s, g);
+
+        if (path) {
+                g->path = strdup(path);
+                if (!g->path) {
+                        free(g);
+                        return -ENOMEM;
+                }
+
+                (void) cg_path_get_session(g->path, &g->session);
+
+                if (cg_path_get_owner_uid(g->path, &g->owner_uid) < 0)
+                        g->owner_uid = UID_INVALID;
+
+                (void) cg_path_get_unit(g->path, &g->unit);
+                (void) cg_path_get_user_unit(g->path, &g->user_unit);
+                (void) cg_path_get_slice(g->path, &g->slice);
+                (void) cg_path_get_user_slice(g->path, &g->user_slice);
+
+                r = hashmap_ensure_put(&s->client_cgroups, &string_hash_ops, g->path, g);
+        } else {
+                g->unit = strdup(unit_id);
+                r = g->unit ? 0 : -ENOMEM;
+        }
+        if (r < 0) {
+                free(g->path);
+                free(g->session);
+                free(g->unit);
+                free(g->user_unit);
+                free(g->slice);
+                free(g->user_slice);
+                free(g);
                 return r;
+        }
+
+        if (g->unit)
+                g->ratelimit_id = journal_ratelimit_id(s->ratelimit, g->unit);
+
+        client_cgroup_update_size(s, g);
+
+        *ret = g;
+        return 0;
+}
+
+static ClientCgroup* client_cgroup_unref(Server *s, ClientCgroup *g) {
+        assert(s);
+
+        if (!g)
+                return NULL;
+
+        assert(g->n_ref > 0);
 
+        g->n_ref--;
+        if (g->n_ref > 0)
+                return NULL;
+
+        if (g->path)
+                assert_se(hashmap_remove(s->client_cgroups, g->path) == g);
+
+        client_cgroup_reset_unit_data(s, g);
+
+        assert(s->client_contexts_size >= g->size);
+        s->client_contexts_size -= g->size;
+
+        free(g->path);
+        free(g->session);
+        free(g->unit);
+        free(g->user_unit);
+        free(g->slice);
+        free(g->user_slice);
+
+        return mfree(g);
+}
+
+static uint64_t client_context_key(const void *p) {
+        const ClientContext *c = p;
+
+        return c->timestamp;
+}
+
+static int client_context_compare(const void *a, const void *b) {
+        const ClientContext *x = a, *y = b;
+
+        /* Only used for contexts with the same timestamp */
         return CMP(x->pid, y->pid);
 }
 
@@ -109,7 +286,7 @@ static int client_context_new(Server *s, pid_t pid, ClientContext **ret) {
         assert(pid_is_valid(pid));
         assert(ret);
 
-        r = prioq_ensure_allocated(&s->client_contexts_lru, client_context_compare);
+        r = prioq_ensure_allocated_keyed(&s->client_contexts_lru, client_context_key, client_context_compare);
         if (r < 0)
                 return r;
 
@@ -123,13 +300,8 @@ static int client_context_new(Server *s, pid_t pid, ClientContext **ret) {
                 .gid = GID_INVALID,
                 .auditid = AUDIT_SESSION_INVALID,
                 .loginuid = UID_INVALID,
-                .owner_uid = UID_INVALID,
                 .lru_index = PRIOQ_IDX_NULL,
                 .timestamp = USEC_INFINITY,
-                .extra_fields_mtime = NSEC_INFINITY,
-                .log_level_max = -1,
-                .log_ratelimit_interval = s->ratelimit_interval,
-                .log_ratelimit_burst = s->ratelimit_burst,
         };
 
         r = hashmap_ensure_put(&s->client_contexts, NULL, PID_TO_PTR(pid), c);
@@ -157,28 +329,14 @@ static void client_context_reset(Server *s, ClientContext *c) {
         c->auditid = AUDIT_SESSION_INVALID;
         c->loginuid = UID_INVALID;
 
-        c->cgroup = mfree(c->cgroup);
-        c->session = mfree(c->session);
-        c->owner_uid = UID_INVALID;
-        c->unit = mfree(c->unit);
-        c->user_unit = mfree(c->user_unit);
-        c->slice = mfree(c->slice);
-        c->user_slice = mfree(c->user_slice);
-
-        c->invocation_id = SD_ID128_NULL;
+        c->cgroup = client_cgroup_unref(s, c->cgroup);
 
         c->label = mfree(c->label);
         c->label_size = 0;
 
-        c->extra_fields_iovec = mfree(c->extra_fields_iovec);
-        c->extra_fields_n_iovec = 0;
-        c->extra_fields_data = mfree(c->extra_fields_data);
-        c->extra_fields_mtime = NSEC_INFINITY;
-
-        c->log_level_max = -1;
-
-        c->log_ratelimit_interval = s->ratelimit_interval;
-        c->log_ratelimit_burst = s->ratelimit_burst;
+        assert(s->client_contexts_size >= c->size);
+        s->client_contexts_size -= c->size;
+        c->size = 0;
 }
 
 static ClientContext* client_context_free(Server *s, ClientContext *c) {
@@ -270,6 +428,7 @@ static int client_context_read_label(
 
 static int client_context_read_cgroup(Server *s, ClientContext *c, const char *unit_id) {
         _cleanup_free_ char *t = NULL;
+        ClientCgroup *g;
         int r;
 
         assert(c);
@@ -280,65 +439,59 @@ static int client_context_read_cgroup(Server *s, ClientContext *c, const char *u
                 /* We use the unit ID passed in as fallback if we have nothing cached yet and cg_pid_get_path_shifted()
                  * failed or process is running in a root cgroup. Zombie processes are automatically migrated to root cgroup
                  * on cgroup v1 and we want to be able to map log messages from them too. */
-                if (unit_id && !c->unit) {
-                        c->unit = strdup(unit_id);
-                        if (c->unit)
+                if (unit_id && !c->cgroup)
+                        if (client_cgroup_new(s, NULL, unit_id, &c->cgroup) >= 0)
                                 return 0;
-                }
 
                 return r;
         }
 
         /* Let's shortcut this if the cgroup path didn't change */
-        if (streq_ptr(c->cgroup, t))
+        if (c->cgroup && streq_ptr(c->cgroup->path, t))
                 return 0;
 
-        free_and_replace(c->cgroup, t);
-
-        (void) cg_path_get_session(c->cgroup, &t);
-        free_and_replace(c->session, t);
-
-        if (cg_path_get_owner_uid(c->cgroup, &c->owner_uid) < 0)
-                c->owner_uid = UID_INVALID;
-
-        (void) cg_path_get_unit(c->cgroup, &t);
-        free_and_replace(c->unit, t);
-
-        (void) cg_path_get_user_unit(c->cgroup, &t);
-        free_and_replace(c->user_unit, t);
+        /* Sibling processes share the cgroup data, so look for an existing object first */
+        g = hashmap_get(s->client_cgroups, t);
+        if (g) {
+                g->n_ref++;
+                s->client_cgroup_hits++;
+        } else {
+                r = client_cgroup_new(s, t, NULL, &g);
+                if (r < 0)
+                        return r;
 
-        (void) cg_path_get_slice(c->cgroup, &t);
-        free_and_replace(c->slice, t);
+                s->client_cgroup_misses++;
+        }
 
-        (void) cg_path_get_user_slice(c->cgroup, &t);
-        free_and_replace(c->user_slice, t);
+        client_cgroup_unref(s, c->cgroup);
+        c->cgroup = g;
 
         return 0;
 }
 
-static int client_context_read_invocation_id(
+static int client_cgroup_read_invocation_id(
                 Server *s,
-                ClientContext *c) {
+                ClientCgroup *g) {
 
         _cleanup_free_ char *p = NULL, *value = NULL;
         int r;
 
         assert(s);
-        assert(c);
+        assert(g);
 
         /* Read the invocation ID of a unit off a unit.
          * PID 1 stores it in a per-unit symlink in /run/systemd/units/
          * User managers store it in a per-unit symlink under /run/user/<uid>/systemd/units/ */
 
-        if (!c->unit)
+        if (!g->unit)
                 return 0;
 
-        if (c->user_unit) {
-                r = asprintf(&p, "/run/user/" UID_FMT "/systemd/units/invocation:%s", c->owner_uid, c->user_unit);
+        if (g->user_unit) {
+                r = asprintf(&p, "/run/user/" UID_FMT "/systemd/units/invocation:%s", g->owner_uid, g->user_unit);
                 if (r < 0)
                         return r;
         } else {
-                p = strjoin("/run/systemd/units/invocation:", c->unit);
+                p = strjoin("/run/systemd/units/invocation:", g->unit);
                 if (!p)
                         return -ENOMEM;
         }
@@ -347,21 +500,21 @@ static int client_context_read_invocation_id(
         if (r < 0)
                 return r;
 
-        return sd_id128_from_string(value, &c->invocation_id);
+        return sd_id128_from_string(value, &g->invocation_id);
 }
 
-static int client_context_read_log_level_max(
+static int client_cgroup_read_log_level_max(
                 Server *s,
-                ClientContext *c) {
+                ClientCgroup *g) {
 
         _cleanup_free_ char *value = NULL;
         const char *p;
         int r, ll;
 
-        if (!c->unit)
+        if (!g->unit)
                 return 0;
 
-        p = strjoina("/run/systemd/units/log-level-max:", c->unit);
+        p = strjoina("/run/systemd/units/log-level-max:", g->unit);
         r = readlink_malloc(p, &value);
         if (r < 0)
                 return r;
@@ -370,13 +523,13 @@ static int client_context_read_log_level_max(
         if (ll < 0)
                 return ll;
 
-        c->log_level_max = ll;
+        g->log_level_max = ll;
         return 0;
 }
 
-static int client_context_read_extra_fields(
+static int client_cgroup_read_extra_fields(
                 Server *s,
-                ClientContext *c) {
+                ClientCgroup *g) {
 
         size_t size = 0, n_iovec = 0, n_allocated = 0, left;
         _cleanup_free_ struct iovec *iovec = NULL;
@@ -387,12 +540,12 @@ static int client_context_read_extra_fields(
         uint8_t *q;
         int r;
 
-        if (!c->unit)
+        if (!g->unit)
                 return 0;
 
-        p = strjoina("/run/systemd/units/log-extra-fields:", c->unit);
+        p = strjoina("/run/systemd/units/log-extra-fields:", g->unit);
 
-        if (c->extra_fields_mtime != NSEC_INFINITY) {
+        if (g->extra_fields_mtime != NSEC_INFINITY) {
                 if (stat(p, &st) < 0) {
                         if (errno == ENOENT)
                                 return 0;
@@ -400,7 +553,7 @@ static int client_context_read_extra_fields(
                         return -errno;
                 }
 
-                if (timespec_load_nsec(&st.st_mtim) == c->extra_fields_mtime)
+                if (timespec_load_nsec(&st.st_mtim) == g->extra_fields_mtime)
                         return 0;
         }
 
@@ -453,51 +606,78 @@ static int client_context_read_extra_fields(
                 left -= n, q += n;
         }
 
-        free(c->extra_fields_iovec);
-        free(c->extra_fields_data);
+        free(g->extra_fields_iovec);
+        free(g->extra_fields_data);
 
-        c->extra_fields_iovec = TAKE_PTR(iovec);
-        c->extra_fields_n_iovec = n_iovec;
-        c->extra_fields_data = TAKE_PTR(data);
-        c->extra_fields_mtime = timespec_load_nsec(&st.st_mtim);
+        g->extra_fields_iovec = TAKE_PTR(iovec);
+        g->extra_fields_n_iovec = n_iovec;
+        g->extra_fields_data = TAKE_PTR(data);
+        g->extra_fields_mtime = timespec_load_nsec(&st.st_mtim);
 
         return 0;
 }
 
-static int client_context_read_log_ratelimit_interval(ClientContext *c) {
+static int client_cgroup_read_log_ratelimit_interval(ClientCgroup *g) {
         _cleanup_free_ char *value = NULL;
         const char *p;
         int r;
 
-        assert(c);
+        assert(g);
 
-        if (!c->unit)
+        if (!g->unit)
                 return 0;
 
-        p = strjoina("/run/systemd/units/log-rate-limit-interval:", c->unit);
+        p = strjoina("/run/systemd/units/log-rate-limit-interval:", g->unit);
         r = readlink_malloc(p, &value);
         if (r < 0)
                 return r;
 
-        return safe_atou64(value, &c->log_ratelimit_interval);
+        return safe_atou64(value, &g->log_ratelimit_interval);
 }
 
-static int client_context_read_log_ratelimit_burst(ClientContext *c) {
+static int client_cgroup_read_log_ratelimit_burst(ClientCgroup *g) {
         _cleanup_free_ char *value = NULL;
         const char *p;
         int r;
 
-        assert(c);
+        assert(g);
 
-        if (!c->unit)
+        if (!g->unit)
                 return 0;
 
-        p = strjoina("/run/systemd/units/log-rate-limit-burst:", c->unit);
+        p = strjoina("/run/systemd/units/log-rate-limit-burst:", g->unit);
         r = readlink_malloc(p, &value);
         if (r < 0)
                 return r;
 
-        return safe_atou(value, &c->log_ratelimit_burst);
+        return safe_atou(value, &g->log_ratelimit_burst);
+}
+
+static void client_cgroup_maybe_refresh(Server *s, ClientCgroup *g, usec_t timestamp) {
+        assert(s);
+        assert(g);
+
+        /* The unit data is shared between all clients in the cgroup, hence refresh it only once per
+         * REFRESH_USEC for all of them. If it wasn't refreshed for a while, flush it out entirely, like we
+         * do for the per-client data. */
+
+        if (g->timestamp != USEC_INFINITY) {
+                if (g->timestamp + REFRESH_USEC >= timestamp)
+                        return;
+
+                if (g->timestamp + MAX_USEC < timestamp)
+                        client_cgroup_reset_unit_data(s, g);
+        }
+
+        (void) client_cgroup_read_invocation_id(s, g);
+        (void) client_cgroup_read_log_level_max(s, g);
+        (void) client_cgroup_read_extra_fields(s, g);
+        (void) client_cgroup_read_log_ratelimit_interval(g);
+        (void) client_cgroup_read_log_ratelimit_burst(g);
+
+        g->timestamp = timestamp;
+
+        client_cgroup_update_size(s, g);
 }
 
 static void client_context_really_refresh(
@@ -523,14 +703,13 @@ static void client_context_really_refresh(
         (void) audit_loginuid_from_pid(c->pid, &c->loginuid);
 
         (void) client_context_read_cgroup(s, c, unit_id);
-        (void) client_context_read_invocation_id(s, c);
-        (void) client_context_read_log_level_max(s, c);
-        (void) client_context_read_extra_fields(s, c);
-        (void) client_context_read_log_ratelimit_interval(c);
-        (void) client_context_read_log_ratelimit_burst(c);
+        if (c->cgroup)
+                client_cgroup_maybe_refresh(s, c->cgroup, timestamp);
 
         c->timestamp = timestamp;
 
+        client_context_update_size(s, c);
+
         if (c->in_lru) {
                 assert(c->n_ref == 0);
                 assert_se(prioq_reshuffle(s->client_contexts_lru, c, &c->lru_index) >= 0);
@@ -579,6 +758,7 @@ void client_context_maybe_refresh(
         return;
 
 refresh:
+        s->client_context_refreshes++;
         client_context_really_refresh(s, c, ucred, label, label_size, unit_id, timestamp);
 }
 
@@ -611,11 +791,11 @@ static void client_context_try_shrink_to(Server *s, size_t limit) {
                 s->last_cache_pid_flush = t;
         }
 
-        /* Bring the number of cache entries below the indicated limit, so that we can create a new entry without
-         * breaching the limit. Note that we only flush out entries that aren't pinned here. This means the number of
+        /* Bring the number of cache entries below the indicated limit, and their size below the memory budget, so
+         * that we can create a new entry without breaching the limits. Note that we only flush out entries that aren't pinned here. This means the number of
          * cache entries may very well grow beyond the limit, if all entries stored remain pinned. */
 
-        while (hashmap_size(s->client_contexts) > limit) {
+        while (cache_over_limit(s, limit)) {
                 c = prioq_pop(s->client_contexts_lru);
                 if (!c)
                         break; /* All remaining entries are pinned, give up */
@@ -626,6 +806,7 @@ static void client_context_try_shrink_to(Server *s, size_t limit) {
                 c->in_lru = false;
 
                 client_context_free(s, c);
+                s->client_context_evictions++;
         }
 }
 
@@ -641,9 +822,12 @@ void client_context_flush_all(Server *s) {
 
         assert(prioq_size(s->client_contexts_lru) == 0);
         assert(hashmap_size(s->client_contexts) == 0);
+        assert(hashmap_size(s->client_cgroups) == 0);
+        assert(s->client_contexts_size == 0);
 
         s->client_contexts_lru = prioq_free(s->client_contexts_lru);
         s->client_contexts = hashmap_free(s->client_contexts);
+        s->client_cgroups = hashmap_free(s->client_cgroups);
 }
 
 static int client_context_get_internal(
@@ -666,6 +850,7 @@ static int client_context_get_internal(
 
         c = hashmap_get(s->client_contexts, PID_TO_PTR(pid));
         if (c) {
+                s->client_context_hits++;
 
                 if (add_ref) {
                         if (c->in_lru) {
@@ -684,7 +869,9 @@ static int client_context_get_internal(
                 return 0;
         }
 
-        client_context_try_shrink_to(s, cache_max()-1);
+        s->client_context_misses++;
+
+        client_context_try_shrink_to(s, CACHE_MAX_MAX-1);
 
         r = client_context_new(s, pid, &c);
         if (r < 0)
@@ -784,3 +971,21 @@ void client_context_acquire_default(Server *s) {
 
         }
 }
+
+int client_context_build_statistics(Server *s, JsonVariant **ret) {
+        assert(s);
+        assert(ret);
+
+        return json_build(ret, JSON_BUILD_OBJECT(
+                                JSON_BUILD_PAIR("contexts", JSON_BUILD_UNSIGNED(hashmap_size(s->client_contexts))),
+                                JSON_BUILD_PAIR("contextsMax", JSON_BUILD_UNSIGNED(CACHE_MAX_MAX)),
+                                JSON_BUILD_PAIR("cgroups", JSON_BUILD_UNSIGNED(hashmap_size(s->client_cgroups))),
+                                JSON_BUILD_PAIR("size", JSON_BUILD_UNSIGNED(s->client_contexts_size)),
+                                JSON_BUILD_PAIR("sizeMax", JSON_BUILD_UNSIGNED(cache_budget())),
+                                JSON_BUILD_PAIR("hits", JSON_BUILD_UNSIGNED(s->client_context_hits)),
+                                JSON_BUILD_PAIR("misses", JSON_BUILD_UNSIGNED(s->client_context_misses)),
+                                JSON_BUILD_PAIR("refreshes", JSON_BUILD_UNSIGNED(s->client_context_refreshes)),
+                                JSON_BUILD_PAIR("evictions", JSON_BUILD_UNSIGNED(s->client_context_evictions)),
+                                JSON_BUILD_PAIR("cgroupHits", JSON_BUILD_UNSIGNED(s->client_cgroup_hits)),
+                                JSON_BUILD_PAIR("cgroupMisses", JSON_BUILD_UNSIGNED(s->client_cgroup_misses))));
+}
@@ -7,45 +7,34 @@
 
 #include "sd-id128.h"
 
+#include "json.h"
 #include "time-util.h"
 
 typedef struct ClientContext ClientContext;
+typedef struct ClientCgroup ClientCgroup;
 
 #include "journald-server.h"
 
-struct ClientContext {
+/* Metadata derived from the cgroup of a client, and from the unit it belongs to. Shared between all clients in
+ * the same cgroup. */
+struct ClientCgroup {
         unsigned n_ref;
-        unsigned lru_index;
         usec_t timestamp;
-        bool in_lru;
+        size_t size;
 
-        pid_t pid;
-        uid_t uid;
-        gid_t gid;
-
-        char *comm;
-        char *exe;
-        char *cmdline;
-        char *capeff;
-
-        uint32_t auditid;
-        uid_t loginuid;
-
-        char *cgroup;
+        char *path; /* NULL if not shared, but made up from a unit name passed in */
         char *session;
         uid_t owner_uid;
 
         char *unit;
         char *user_unit;
+        uint64_t ratelimit_id; /* Rate limit group of the unit, derived from its name */
 
         char *slice;
         char *user_slice;
 
         sd_id128_t invocation_id;
 
-        char *label;
-        size_t label_size;
-
         int log_level_max;
 
         struct iovec *extra_fields_iovec;
@@ -57,6 +46,31 @@ struct ClientContext {
         unsigned log_ratelimit_burst;
 };
 
+struct ClientContext {
+        unsigned n_ref;
+        unsigned lru_index;
+        usec_t timestamp;
+        size_t size;
+        bool in_lru;
+
+        pid_t pid;
+        uid_t uid;
+        gid_t gid;
+
+        char *comm;
+        char *exe;
+        char *cmdline;
+        char *capeff;
+
+        uint32_t auditid;
+        uid_t loginuid;
+
+        ClientCgroup *cgroup;
+
+        char *label;
+        size_t label_size;
+};
+
 int client_context_get(
                 Server *s,
                 pid_t pid,
@@ -86,16 +100,18 @@ void client_context_maybe_refresh(
 void client_context_acquire_default(Server *s);
 void client_context_flush_all(Server *s);
 
+int client_context_build_statistics(Server *s, JsonVariant **ret);
+
 static inline size_t client_context_extra_fields_n_iovec(const ClientContext *c) {
-        return c ? c->extra_fields_n_iovec : 0;
+        return c && c->cgroup ? c->cgroup->extra_fields_n_iovec : 0;
 }
 
 static inline bool client_context_test_priority(const ClientContext *c, int priority) {
-        if (!c)
+        if (!c || !c->cgroup)
                 return true;
 
-        if (c->log_level_max < 0)
+        if (c->cgroup->log_level_max < 0)
                 return true;
 
-        return LOG_PRI(priority) <= c->log_level_max;
+        return LOG_PRI(priority) <= c->cgroup->log_level_max;
 }
@@ -0,0 +1,202 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include "alloc-util.h"
+#include "format-util.h"
+#include "id128-util.h"
+#include "journald-follow.h"
+#include "json.h"
+#include "lookup3.h"
+#include "set.h"
+#include "stdio-util.h"
+#include "time-util.h"
+#include "utf8.h"
+
+/* Clients may subscribe to the entries we write via the io.systemd.Journal.Subscribe() varlink method. Each
+ * entry is then sent to them right after it was appended, in the same format "journalctl -o json" uses, so
+ * that followers of the live journal don't have to wait for inotify events and map the tail of the file
+ * themselves. Unless there are subscribers, none of this costs anything. */
+
+int server_add_subscriber(Server *s, Varlink *link) {
+        int r;
+
+        assert(s);
+        assert(link);
+
+        r = set_ensure_put(&s->subscribers, NULL, link);
+        if (r < 0)
+                return r;
+        if (r > 0)
+                varlink_ref(link);
+
+        return 0;
+}
+
+void server_remove_subscriber(Server *s, Varlink *link) {
+        assert(s);
+        assert(link);
+
+        if (set_remove(s->subscribers, link))
+                varlink_unref(link);
+}
+
+static int field_value(const struct iovec *iovec, size_t name_len, JsonVariant **ret) {
+        const char *value = (const char*) iovec->iov_base + name_len + 1;
+        size_t size = iovec->iov_len - name_len - 1;
+
+        if (utf8_is_printable(value, size))
+                return json_variant_new_stringn(ret, value, size);
+
+        return json_variant_new_array_bytes(ret, value, size);
+}
+
+static bool field_name_equal(const struct iovec *iovec, const char *name, size_t name_len) {
+        return iovec->iov_len > name_len &&
+                ((const char*) iovec->iov_base)[name_len] == '=' &&
+                memcmp(iovec->iov_base, name, name_len) == 0;
+}
+
+static int build_entry(JournalFile *f, const JournalFileEntry *e, uint64_t seqnum, JsonVariant **ret) {
+        char sid[SD_ID128_STRING_MAX], bid[SD_ID128_STRING_MAX], realtime[DECIMAL_STR_MAX(usec_t)],
+                monotonic[DECIMAL_STR_MAX(usec_t)];
+        _cleanup_free_ char *cursor = NULL;
+        JsonVariant **array = NULL;
+        uint64_t xor_hash = 0;
+        size_t n = 0;
+        int r;
+
+        assert(f);
+        assert(e);
+        assert(ret);
+
+        /* Hashed the same way as in journal_file_append_entry_items(), so that the cursor is identical to
+         * the one readers get for this entry from the file */
+        for (size_t i = 0; i < e->n_iovec; i++)
+                xor_hash ^= jenkins_hash64(e->iovec[i].iov_base, e->iovec[i].iov_len);
+
+        if (asprintf(&cursor,
+                     "s=%s;i=%"PRIx64";b=%s;m=%"PRIx64";t=%"PRIx64";x=%"PRIx64,
+                     sd_id128_to_string(f->header->seqnum_id, sid), seqnum,
+                     sd_id128_to_string(f->header->boot_id, bid), e->ts.monotonic,
+                     e->ts.realtime,
+                     xor_hash) < 0)
+                return -ENOMEM;
+
+        xsprintf(realtime, USEC_FMT, e->ts.realtime);
+        xsprintf(monotonic, USEC_FMT, e->ts.monotonic);
+
+        array = new0(JsonVariant*, 8 + e->n_iovec * 2);
+        if (!array)
+                return -ENOMEM;
+
+        r = json_variant_new_string(array + n++, "__CURSOR");
+        if (r >= 0)
+                r = json_variant_new_string(array + n++, cursor);
+        if (r >= 0)
+                r = json_variant_new_string(array + n++, "__REALTIME_TIMESTAMP");
+        if (r >= 0)
+                r = json_variant_new_string(array + n++, realtime);
+        if (r >= 0)
+                r = json_variant_new_string(array + n++, "__MONOTONIC_TIMESTAMP");
+        if (r >= 0)
+                r = json_variant_new_string(array + n++, monotonic);
+        if (r >= 0)
+                r = json_variant_new_string(array + n++, "_BOOT_ID");
+        if (r >= 0)
+                r = json_variant_new_string(array + n++, bid);
+        if (r < 0)
+                goto finish;
+
+        for (size_t i = 0; i < e->n_iovec; i++) {
+                _cleanup_(json_variant_unrefp) JsonVariant *values = NULL;
+                const char *name = e->iovec[i].iov_base, *eq;
+                size_t name_len, n_values = 0;
+                bool seen = false;
+
+                eq = memchr(name, '=', e->iovec[i].iov_len);
+                if (!eq)
+                        continue;
+                name_len = eq - name;
+
+                /* Fields that show up more than once are turned into an array of all their values, at the
+                 * position of the first one */
+                for (size_t k = 0; k < i && !seen; k++)
+                        seen = field_name_equal(e->iovec + k, name, name_len);
+                if (seen)
+                        continue;
+
+                for (size_t k = i; k < e->n_iovec; k++)
+                        n_values += field_name_equal(e->iovec + k, name, name_len);
+
+                r = json_variant_new_stringn(array + n++, name, name_len);
+                if (r < 0)
+                        goto finish;
+
+                if (n_values == 1) {
+                        r = field_value(e->iovec + i, name_len, array + n++);
+                        if (r < 0)
+                                goto finish;
+
+                        continue;
+                }
+
+                for (size_t k = i; k < e->n_iovec; k++) {
+                        _cleanup_(json_variant_unrefp) JsonVariant *v = NULL;
+
+                        if (!field_name_equal(e->iovec + k, name, name_len))
+                                continue;
+
+                        r = field_value(e->iovec + k, name_len, &v);
+                        if (r < 0)
+                                goto finish;
+
+                        r = json_variant_append_array(&values, v);
+                        if (r < 0)
+                                goto finish;
+                }
+
+                array[n++] = TAKE_PTR(values);
+        }
+
+        r = json_variant_new_object(ret, array, n);
+
+finish:
+        json_variant_unref_many(array, n);
+        free(array);
+
+        return r;
+}
+
+void server_publish_entries(Server *s, JournalFile *f, const JournalFileEntry *entries, size_t n, uint64_t last_seqnum) {
+        int r;
+
+        assert(s);
+        assert(f);
+        assert(entries || n == 0);
+        assert(last_seqnum >= n);
+
+        if (set_isempty(s->subscribers))
+                return;
+
+        for (size_t i = 0; i < n; i++) {
+                _cleanup_(json_variant_unrefp) JsonVariant *entry = NULL, *parameters = NULL;
+                Varlink *link;
+
+                r = build_entry(f, entries + i, last_seqnum - n + 1 + i, &entry);
+                if (r >= 0)
+                        r = json_build(&parameters, JSON_BUILD_OBJECT(JSON_BUILD_PAIR("entry", JSON_BUILD_VARIANT(entry))));
+                if (r < 0) {
+                        log_warning_errno(r, "Failed to build entry for subscribers, ignoring: %m");
+                        continue;
+                }
+
+                SET_FOREACH(link, s->subscribers) {
+                        r = varlink_notify(link, parameters);
+                        if (r < 0) {
+                                /* Most likely the client doesn't keep up, and its output buffer is full. We
+                                 * can't tell it that it missed entries, hence disconnect it. */
+                                log_debug_errno(r, "Failed to send entry to subscriber, disconnecting: %m");
+                                (void) varlink_close(link);
+                        }
+                }
+        }
+}
@@ -0,0 +1,11 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+#pragma once
+
+#include "journal-file.h"
+#include "journald-server.h"
+#include "varlink.h"
+
+int server_add_subscriber(Server *s, Varlink *link);
+void server_remove_subscriber(Server *s, Varlink *link);
+
+void server_publish_entries(Server *s, JournalFile *f, const JournalFileEntry *entries, size_t n, uint64_t last_seqnum);
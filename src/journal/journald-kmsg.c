@@ -22,6 +22,35 @@
 #include "process-util.h"
 #include "stdio-util.h"
 #include "string-util.h"
+#include "strv.h"
+
+/* Each read() on /dev/kmsg returns a single record. Process a number of them per wakeup, but not too many,
+ * so that we don't starve the other event sources during a kernel log storm. */
+#define DEV_KMSG_RECORDS_PER_DISPATCH 256U
+
+/* Kernel log storms are usually caused by a single device. Hence remember the udev fields we attach to
+ * device-tagged messages for a short while, so that we don't have to look up the device and read its udev
+ * database entry again for each message. */
+#define KMSG_DEVICE_CACHE_USEC (5 * USEC_PER_SEC)
+#define KMSG_DEVICES_MAX 256U
+
+typedef struct KmsgDevice {
+        char *id;
+        usec_t timestamp;
+        char **fields;
+} KmsgDevice;
+
+static KmsgDevice* kmsg_device_free(KmsgDevice *d) {
+        if (!d)
+                return NULL;
+
+        free(d->id);
+        strv_free(d->fields);
+        return mfree(d);
+}
+
+DEFINE_TRIVIAL_CLEANUP_FUNC(KmsgDevice*, kmsg_device_free);
+DEFINE_PRIVATE_HASH_OPS_WITH_VALUE_DESTRUCTOR(kmsg_device_hash_ops, char, string_hash_func, string_compare_func, KmsgDevice, kmsg_device_free);
 
 void server_forward_kmsg(
                 Server *s,
@@ -94,6 +123,92 @@ static bool is_us(const char *identifier, const char *pid) {
                streq(identifier, program_invocation_short_name);
 }
 
+static int kmsg_device_fields(sd_device *d, char ***ret) {
+        _cleanup_strv_free_ char **l = NULL;
+        const char *g;
+        size_t j = 0;
+        char *b;
+
+        assert(ret);
+
+        if (!d) {
+                *ret = NULL;
+                return 0;
+        }
+
+        if (sd_device_get_devname(d, &g) >= 0) {
+                b = strjoin("_UDEV_DEVNODE=", g);
+                if (!b || strv_consume(&l, b) < 0)
+                        return -ENOMEM;
+        }
+
+        if (sd_device_get_sysname(d, &g) >= 0) {
+                b = strjoin("_UDEV_SYSNAME=", g);
+                if (!b || strv_consume(&l, b) < 0)
+                        return -ENOMEM;
+        }
+
+        FOREACH_DEVICE_DEVLINK(d, g) {
+
+                if (j >= N_IOVEC_UDEV_FIELDS)
+                        break;
+
+                b = strjoin("_UDEV_DEVLINK=", g);
+                if (!b || strv_consume(&l, b) < 0)
+                        return -ENOMEM;
+
+                j++;
+        }
+
+        *ret = TAKE_PTR(l);
+        return 0;
+}
+
+static char **kmsg_device_get_fields(Server *s, const char *id) {
+        _cleanup_(kmsg_device_freep) KmsgDevice *d = NULL;
+        _cleanup_(sd_device_unrefp) sd_device *device = NULL;
+        KmsgDevice *cached;
+        usec_t n;
+
+        assert(s);
+        assert(id);
+
+        n = now(CLOCK_MONOTONIC);
+
+        cached = hashmap_get(s->kmsg_devices, id);
+        if (cached) {
+                if (cached->timestamp + KMSG_DEVICE_CACHE_USEC > n)
+                        return cached->fields;
+
+                kmsg_device_free(hashmap_remove(s->kmsg_devices, id));
+        }
+
+        /* Devices which don't exist (anymore) are cached too, hence the result may be NULL */
+        (void) sd_device_new_from_device_id(&device, id);
+
+        d = new(KmsgDevice, 1);
+        if (!d)
+                return NULL;
+
+        *d = (KmsgDevice) {
+                .id = strdup(id),
+                .timestamp = n,
+        };
+        if (!d->id)
+                return NULL;
+
+        if (kmsg_device_fields(device, &d->fields) < 0)
+                return NULL;
+
+        if (hashmap_size(s->kmsg_devices) >= KMSG_DEVICES_MAX)
+                hashmap_clear(s->kmsg_devices);
+
+        if (hashmap_ensure_put(&s->kmsg_devices, &kmsg_device_hash_ops, d->id, d) < 0)
+                return NULL;
+
+        return TAKE_PTR(d)->fields;
+}
+
 void dev_kmsg_record(Server *s, char *p, size_t l) {
 
         _cleanup_free_ char *message = NULL, *syslog_priority = NULL, *syslog_pid = NULL, *syslog_facility = NULL, *syslog_identifier = NULL, *source_time = NULL, *identifier = NULL, *pid = NULL;
@@ -210,43 +325,12 @@ void dev_kmsg_record(Server *s, char *p, size_t l) {
         }
 
         if (kernel_device) {
-                _cleanup_(sd_device_unrefp) sd_device *d = NULL;
-
-                if (sd_device_new_from_device_id(&d, kernel_device) >= 0) {
-                        const char *g;
-                        char *b;
-
-                        if (sd_device_get_devname(d, &g) >= 0) {
-                                b = strjoin("_UDEV_DEVNODE=", g);
-                                if (b) {
-                                        iovec[n++] = IOVEC_MAKE_STRING(b);
-                                        z++;
-                                }
-                        }
-
-                        if (sd_device_get_sysname(d, &g) >= 0) {
-                                b = strjoin("_UDEV_SYSNAME=", g);
-                                if (b) {
-                                        iovec[n++] = IOVEC_MAKE_STRING(b);
-                                        z++;
-                                }
-                        }
-
-                        j = 0;
-                        FOREACH_DEVICE_DEVLINK(d, g) {
-
-                                if (j >= N_IOVEC_UDEV_FIELDS)
-                                        break;
-
-                                b = strjoin("_UDEV_DEVLINK=", g);
-                                if (b) {
-                                        iovec[n++] = IOVEC_MAKE_STRING(b);
-                                        z++;
-                                }
-
-                                j++;
-                        }
-                }
+                char **fields, **field;
+
+                /* These are owned by the cache, hence are not counted in 'z' */
+                fields = kmsg_device_get_fields(s, kernel_device);
+                STRV_FOREACH(field, fields)
+                        iovec[n++] = IOVEC_MAKE_STRING(*field);
         }
 
         if (asprintf(&source_time, "_SOURCE_MONOTONIC_TIMESTAMP=%llu", usec) >= 0)
@@ -360,7 +444,15 @@ static int dispatch_dev_kmsg(sd_event_source *es, int fd, uint32_t revents, void
         if (!(revents & EPOLLIN))
                 log_error("Got invalid event from epoll for /dev/kmsg: %"PRIx32, revents);
 
-        return server_read_dev_kmsg(s);
+        for (unsigned i = 0; i < DEV_KMSG_RECORDS_PER_DISPATCH; i++) {
+                int r;
+
+                r = server_read_dev_kmsg(s);
+                if (r <= 0)
+                        return r;
+        }
+
+        return 0;
 }
 
 int server_open_dev_kmsg(Server *s) {
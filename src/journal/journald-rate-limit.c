@@ -37,13 +37,12 @@ struct JournalRateLimitPool {
 struct JournalRateLimitGroup {
         JournalRateLimit *parent;
 
-        char *id;
+        uint64_t id;
 
         /* Interval is stored to keep track of when the group expires */
         usec_t interval;
 
         JournalRateLimitPool pools[POOLS_MAX];
-        uint64_t hash;
 
         LIST_FIELDS(JournalRateLimitGroup, bucket);
         LIST_FIELDS(JournalRateLimitGroup, lru);
@@ -81,12 +80,11 @@ static void journal_ratelimit_group_free(JournalRateLimitGroup *g) {
                         g->parent->lru_tail = g->lru_prev;
 
                 LIST_REMOVE(lru, g->parent->lru, g);
-                LIST_REMOVE(bucket, g->parent->buckets[g->hash % BUCKETS_MAX], g);
+                LIST_REMOVE(bucket, g->parent->buckets[g->id % BUCKETS_MAX], g);
 
                 g->parent->n_groups--;
         }
 
-        free(g->id);
         free(g);
 }
 
@@ -122,27 +120,21 @@ static void journal_ratelimit_vacuum(JournalRateLimit *r, usec_t ts) {
                 journal_ratelimit_group_free(r->lru_tail);
 }
 
-static JournalRateLimitGroup* journal_ratelimit_group_new(JournalRateLimit *r, const char *id, usec_t interval, usec_t ts) {
+static JournalRateLimitGroup* journal_ratelimit_group_new(JournalRateLimit *r, uint64_t id, usec_t interval, usec_t ts) {
         JournalRateLimitGroup *g;
 
         assert(r);
-        assert(id);
 
         g = new0(JournalRateLimitGroup, 1);
         if (!g)
                 return NULL;
 
-        g->id = strdup(id);
-        if (!g->id)
-                goto fail;
-
-        g->hash = siphash24_string(g->id, r->hash_key);
-
+        g->id = id;
         g->interval = interval;
 
         journal_ratelimit_vacuum(r, ts);
 
-        LIST_PREPEND(bucket, r->buckets[g->hash % BUCKETS_MAX], g);
+        LIST_PREPEND(bucket, r->buckets[g->id % BUCKETS_MAX], g);
         LIST_PREPEND(lru, r->lru, g);
         if (!g->lru_next)
                 r->lru_tail = g;
@@ -150,10 +142,6 @@ static JournalRateLimitGroup* journal_ratelimit_group_new(JournalRateLimit *r, c
 
         g->parent = r;
         return g;
-
-fail:
-        journal_ratelimit_group_free(g);
-        return NULL;
 }
 
 static unsigned burst_modulate(unsigned burst, uint64_t available) {
@@ -184,15 +172,25 @@ static unsigned burst_modulate(unsigned burst, uint64_t available) {
         return burst;
 }
 
-int journal_ratelimit_test(JournalRateLimit *r, const char *id, usec_t rl_interval, unsigned rl_burst, int priority, uint64_t available) {
-        uint64_t h;
+uint64_t journal_ratelimit_id(JournalRateLimit *r, const char *name) {
+        assert(name);
+
+        /* Turns the name of a rate limit group (i.e. a unit name) into the key to pass to
+         * journal_ratelimit_test(). This is supposed to be done once per client, so that the hot path only
+         * has to deal with integers. */
+
+        if (!r)
+                return 0;
+
+        return siphash24_string(name, r->hash_key);
+}
+
+int journal_ratelimit_test(JournalRateLimit *r, uint64_t id, usec_t rl_interval, unsigned rl_burst, int priority, uint64_t available) {
         JournalRateLimitGroup *g;
         JournalRateLimitPool *p;
         unsigned burst;
         usec_t ts;
 
-        assert(id);
-
         /* Returns:
          *
          * 0     → the log message shall be suppressed,
@@ -205,11 +203,10 @@ int journal_ratelimit_test(JournalRateLimit *r, const char *id, usec_t rl_interv
 
         ts = now(CLOCK_MONOTONIC);
 
-        h = siphash24_string(id, r->hash_key);
-        g = r->buckets[h % BUCKETS_MAX];
+        g = r->buckets[id % BUCKETS_MAX];
 
         LIST_FOREACH(bucket, g, g)
-                if (streq(g->id, id))
+                if (g->id == id)
                         break;
 
         if (!g) {
@@ -7,4 +7,5 @@ typedef struct JournalRateLimit JournalRateLimit;
 
 JournalRateLimit *journal_ratelimit_new(void);
 void journal_ratelimit_free(JournalRateLimit *r);
-int journal_ratelimit_test(JournalRateLimit *r, const char *id, usec_t rl_interval, unsigned rl_burst, int priority, uint64_t available);
+uint64_t journal_ratelimit_id(JournalRateLimit *r, const char *name);
+int journal_ratelimit_test(JournalRateLimit *r, uint64_t id, usec_t rl_interval, unsigned rl_burst, int priority, uint64_t available);
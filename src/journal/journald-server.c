@@ -34,6 +34,7 @@
 #include "journal-vacuum.h"
 #include "journald-audit.h"
 #include "journald-context.h"
+#include "journald-follow.h"
 #include "journald-kmsg.h"
 #include "journald-native.h"
 #include "journald-rate-limit.h"
@@ -49,6 +50,7 @@
 #include "process-util.h"
 #include "rm-rf.h"
 #include "selinux-util.h"
+#include "set.h"
 #include "signal-util.h"
 #include "socket-util.h"
 #include "stdio-util.h"
@@ -78,6 +80,19 @@
 
 #define DEFERRED_CLOSES_MAX (4096)
 
+/* Write out queued entries right away when we have this many or this much of them. Entries larger
+ * than PENDING_ENTRY_SIZE_MAX are not queued at all, to avoid copying them around. */
+#define PENDING_ENTRIES_MAX 256U
+#define PENDING_BYTES_MAX (1U*1024U*1024U)
+#define PENDING_ENTRY_SIZE_MAX (64U*1024U)
+
+/* Datagrams to receive from the native and syslog sockets with one recvmmsg() call, and the size of the
+ * receive buffer for each of them but the first */
+#define DEFAULT_DATAGRAM_BATCH_SIZE 16U
+#define DATAGRAM_BATCH_SIZE_MAX 1024U
+#define DATAGRAM_SLOT_SIZE_MIN (64U*1024U)
+#define DATAGRAM_SLOT_SIZE_MAX (8U*1024U*1024U)
+
 #define IDLE_TIMEOUT_USEC (30*USEC_PER_SEC)
 
 static int determine_path_usage(
@@ -292,6 +307,9 @@ static int open_journal(
         if (r < 0)
                 return r;
 
+        journal_file_set_offload_threads(f, s->compress_threads);
+        f->grep_index = s->grep_index;
+
         *ret = TAKE_PTR(f);
         return r;
 }
@@ -614,6 +632,9 @@ void server_rotate(Server *s) {
 
         log_debug("Rotating...");
 
+        /* Make sure queued entries end up in the files we are about to rotate */
+        server_write_pending_entries(s);
+
         /* First, rotate the system journal (either in its runtime flavour or in its runtime flavour) */
         (void) do_rotate(s, &s->runtime_journal, "runtime", false, 0);
         (void) do_rotate(s, &s->system_journal, "system", s->seal, 0);
@@ -640,6 +661,8 @@ void server_sync(Server *s) {
         JournalFile *f;
         int r;
 
+        server_write_pending_entries(s);
+
         if (s->system_journal) {
                 r = journal_file_set_offline(s->system_journal, false);
                 if (r < 0)
@@ -673,9 +696,22 @@ static void do_vacuum(Server *s, JournalStorage *storage, bool verbose) {
         if (verbose)
                 server_space_usage_message(s, storage);
 
-        r = journal_directory_vacuum(storage->path, storage->space.limit,
-                                     storage->metrics.n_max_files, s->max_retention_usec,
-                                     &s->oldest_file_usec, verbose);
+        /* Remember what we learnt about the archived files, so that the next run only needs to look at what
+         * changed. If that doesn't work out, read the whole directory every time. */
+        if (!storage->vacuum_cache) {
+                r = journal_vacuum_cache_new(storage->path, &storage->vacuum_cache);
+                if (r < 0)
+                        log_debug_errno(r, "Failed to set up vacuum cache for %s, ignoring: %m", storage->path);
+        }
+
+        if (storage->vacuum_cache)
+                r = journal_vacuum_cache_vacuum(storage->vacuum_cache, storage->space.limit,
+                                                storage->metrics.n_max_files, s->max_retention_usec,
+                                                &s->oldest_file_usec, verbose);
+        else
+                r = journal_directory_vacuum(storage->path, storage->space.limit,
+                                             storage->metrics.n_max_files, s->max_retention_usec,
+                                             &s->oldest_file_usec, verbose);
         if (r < 0 && r != -ENOENT)
                 log_warning_errno(r, "Failed to vacuum %s, ignoring: %m", storage->path);
 
@@ -789,23 +825,63 @@ static bool shall_try_append_again(JournalFile *f, int r) {
         }
 }
 
-static void write_to_journal(Server *s, uid_t uid, struct iovec *iovec, size_t n, int priority) {
-        bool vacuumed = false, rotate = false;
-        struct dual_timestamp ts;
-        JournalFile *f;
-        int r;
+struct PendingEntry {
+        uid_t uid;
+        int priority;
+        dual_timestamp ts;
+        size_t n_iovec;
+        struct iovec iovec[];
+};
+
+static PendingEntry* pending_entry_new(
+                uid_t uid,
+                int priority,
+                const dual_timestamp *ts,
+                const struct iovec *iovec, size_t n) {
+
+        PendingEntry *e;
+        uint8_t *p;
+
+        assert(ts);
+        assert(iovec || n == 0);
+
+        /* The iovec array and the payloads are stored in the same allocation as the entry itself */
+        e = malloc(offsetof(PendingEntry, iovec) + n * sizeof(struct iovec) + IOVEC_TOTAL_SIZE(iovec, n));
+        if (!e)
+                return NULL;
+
+        *e = (PendingEntry) {
+                .uid = uid,
+                .priority = priority,
+                .ts = *ts,
+                .n_iovec = n,
+        };
+
+        p = (uint8_t*) (e->iovec + n);
+        for (size_t i = 0; i < n; i++) {
+                e->iovec[i] = IOVEC_MAKE(p, iovec[i].iov_len);
+                p = mempcpy(p, iovec[i].iov_base, iovec[i].iov_len);
+        }
 
+        return e;
+}
+
+static bool pending_entries_same_journal(Server *s, uid_t a, uid_t b) {
         assert(s);
-        assert(iovec);
-        assert(n > 0);
 
-        /* Get the closest, linearized time we have for this log event from the event loop. (Note that we do not use
-         * the source time, and not even the time the event was originally seen, but instead simply the time we started
-         * processing it, as we want strictly linear ordering in what we write out.) */
-        assert_se(sd_event_now(s->event, CLOCK_REALTIME, &ts.realtime) >= 0);
-        assert_se(sd_event_now(s->event, CLOCK_MONOTONIC, &ts.monotonic) >= 0);
+        /* Whether two entries would end up in the same journal file, see find_journal() */
+        return s->runtime_journal || a == b || (uid_for_system_journal(a) && uid_for_system_journal(b));
+}
 
-        if (ts.realtime < s->last_realtime_clock) {
+static JournalFile* find_journal_for_write(Server *s, uid_t uid, const dual_timestamp *ts, bool *vacuumed) {
+        bool rotate = false;
+        JournalFile *f;
+
+        assert(s);
+        assert(ts);
+        assert(vacuumed);
+
+        if (ts->realtime < s->last_realtime_clock) {
                 /* When the time jumps backwards, let's immediately rotate. Of course, this should not happen during
                  * regular operation. However, when it does happen, then we should make sure that we start fresh files
                  * to ensure that the entries in the journal files are strictly ordered by time, in order to ensure
@@ -817,7 +893,7 @@ static void write_to_journal(Server *s, uid_t uid, struct iovec *iovec, size_t n
 
                 f = find_journal(s, uid);
                 if (!f)
-                        return;
+                        return NULL;
 
                 if (journal_file_rotate_suggested(f, s->max_file_usec)) {
                         log_debug("%s: Journal header limits reached or header out-of-date, rotating.", f->path);
@@ -828,39 +904,221 @@ static void write_to_journal(Server *s, uid_t uid, struct iovec *iovec, size_t n
         if (rotate) {
                 server_rotate(s);
                 server_vacuum(s, false);
-                vacuumed = true;
+                *vacuumed = true;
 
                 f = find_journal(s, uid);
-                if (!f)
-                        return;
         }
 
-        s->last_realtime_clock = ts.realtime;
+        return f;
+}
 
-        r = journal_file_append_entry(f, &ts, NULL, iovec, n, &s->seqnum, NULL, NULL);
-        if (r >= 0) {
-                server_schedule_sync(s, priority);
+static void write_entries_to_journal(Server *s, uid_t uid, const JournalFileEntry *batch, size_t n, int priority) {
+        bool vacuumed = false;
+        size_t done = 0;
+        JournalFile *f;
+        usec_t start;
+        int r;
+
+        assert(s);
+        assert(batch);
+        assert(n > 0);
+
+        start = now(CLOCK_MONOTONIC);
+
+        /* All entries passed in here go to the same journal file and are ordered by their realtime
+         * timestamps, hence we can check for rotation once and then append them in a single batch. */
+
+        f = find_journal_for_write(s, uid, &batch[0].ts, &vacuumed);
+        if (!f)
                 return;
+
+        s->last_realtime_clock = batch[n-1].ts.realtime;
+
+        while (done < n) {
+                const JournalFileEntry *e;
+                size_t k;
+
+                r = journal_file_append_entries(f, batch + done, n - done, &s->seqnum, &k);
+                server_publish_entries(s, f, batch + done, k, s->seqnum);
+                s->n_entries_written += k;
+                done += k;
+                if (r >= 0)
+                        break;
+
+                /* Rotate again if the file filled up after we made progress in a fresh one */
+                if (k > 0)
+                        vacuumed = false;
+
+                if (!vacuumed && shall_try_append_again(f, r)) {
+                        server_rotate(s);
+                        server_vacuum(s, false);
+                        vacuumed = true;
+
+                        f = find_journal(s, uid);
+                        if (!f)
+                                break;
+
+                        log_debug("Retrying write.");
+                        continue;
+                }
+
+                e = batch + done;
+                log_error_errno(r, "Failed to write entry (%zu items, %zu bytes)%s, ignoring: %m",
+                                e->n_iovec, IOVEC_TOTAL_SIZE(e->iovec, e->n_iovec),
+                                vacuumed ? " despite vacuuming" : "");
+                s->n_entries_failed++;
+                done++;
         }
 
-        if (vacuumed || !shall_try_append_again(f, r)) {
-                log_error_errno(r, "Failed to write entry (%zu items, %zu bytes), ignoring: %m", n, IOVEC_TOTAL_SIZE(iovec, n));
+        if (done > 0)
+                server_schedule_sync(s, priority);
+
+        metric_histogram_record(&s->write_batch, usec_sub_unsigned(now(CLOCK_MONOTONIC), start));
+}
+
+static void pending_entries_free(PendingEntry **entries, size_t n) {
+        for (size_t i = 0; i < n; i++)
+                free(entries[i]);
+
+        free(entries);
+}
+
+void server_write_pending_entries(Server *s) {
+        _cleanup_free_ JournalFileEntry *batch = NULL;
+        PendingEntry **entries;
+        size_t n;
+
+        assert(s);
+
+        /* Rotation and vacuuming done while writing might call back into us, and might also log
+         * messages of their own. Those are queued up anew and written on the next iteration. */
+        if (s->writing_pending_entries || s->n_pending_entries == 0)
                 return;
-        }
 
-        server_rotate(s);
-        server_vacuum(s, false);
+        entries = TAKE_PTR(s->pending_entries);
+        n = s->n_pending_entries;
+        s->n_pending_entries = s->n_pending_allocated = s->pending_bytes = 0;
 
-        f = find_journal(s, uid);
-        if (!f)
+        batch = new(JournalFileEntry, n);
+        if (!batch) {
+                log_oom();
+                pending_entries_free(entries, n);
                 return;
+        }
+
+        for (size_t i = 0; i < n; i++)
+                batch[i] = (JournalFileEntry) {
+                        .ts = entries[i]->ts,
+                        .iovec = entries[i]->iovec,
+                        .n_iovec = entries[i]->n_iovec,
+                };
+
+        s->writing_pending_entries = true;
+
+        for (size_t i = 0, j; i < n; i = j) {
+                int priority = entries[i]->priority;
+
+                for (j = i + 1; j < n; j++) {
+                        if (!pending_entries_same_journal(s, entries[i]->uid, entries[j]->uid) ||
+                            entries[j]->ts.realtime < entries[j-1]->ts.realtime)
+                                break;
+
+                        priority = MIN(priority, entries[j]->priority);
+                }
+
+                write_entries_to_journal(s, entries[i]->uid, batch + i, j - i, priority);
+        }
+
+        s->writing_pending_entries = false;
+
+        pending_entries_free(entries, n);
+}
+
+static int dispatch_pending_entries(sd_event_source *es, void *userdata) {
+        Server *s = userdata;
+
+        assert(s);
+
+        server_write_pending_entries(s);
+        return 0;
+}
+
+static int server_open_pending_event_source(Server *s) {
+        int r;
 
-        log_debug("Retrying write.");
-        r = journal_file_append_entry(f, &ts, NULL, iovec, n, &s->seqnum, NULL, NULL);
+        assert(s);
+
+        /* Entries are written out from a defer event source that has a lower priority than all our
+         * input sources, so that everything that is queued on the sockets is processed first and then
+         * written in a single batch, before we go back to sleep. */
+        r = sd_event_add_defer(s->event, &s->pending_event_source, dispatch_pending_entries, s);
         if (r < 0)
-                log_error_errno(r, "Failed to write entry (%zu items, %zu bytes) despite vacuuming, ignoring: %m", n, IOVEC_TOTAL_SIZE(iovec, n));
-        else
-                server_schedule_sync(s, priority);
+                return log_error_errno(r, "Failed to add pending entries event source: %m");
+
+        r = sd_event_source_set_priority(s->pending_event_source, SD_EVENT_PRIORITY_NORMAL+10);
+        if (r < 0)
+                return log_error_errno(r, "Failed to set pending entries event source priority: %m");
+
+        r = sd_event_source_set_enabled(s->pending_event_source, SD_EVENT_OFF);
+        if (r < 0)
+                return log_error_errno(r, "Failed to disable pending entries event source: %m");
+
+        (void) sd_event_source_set_description(s->pending_event_source, "pending-entries");
+
+        return 0;
+}
+
+static void write_to_journal(Server *s, uid_t uid, struct iovec *iovec, size_t n, int priority) {
+        struct dual_timestamp ts;
+        PendingEntry *e = NULL;
+        size_t sz;
+        int r;
+
+        assert(s);
+        assert(iovec);
+        assert(n > 0);
+
+        /* Get the closest, linearized time we have for this log event from the event loop. (Note that we do not use
+         * the source time, and not even the time the event was originally seen, but instead simply the time we started
+         * processing it, as we want strictly linear ordering in what we write out.) */
+        assert_se(sd_event_now(s->event, CLOCK_REALTIME, &ts.realtime) >= 0);
+        assert_se(sd_event_now(s->event, CLOCK_MONOTONIC, &ts.monotonic) >= 0);
+
+        /* Instead of writing each entry right away, queue it up, and write all entries we got during one
+         * event loop iteration in one go once the input sockets are drained. Large and important entries
+         * are not delayed, and neither are entries if we cannot queue them. */
+        sz = IOVEC_TOTAL_SIZE(iovec, n);
+        if (s->pending_event_source && sz <= PENDING_ENTRY_SIZE_MAX &&
+            GREEDY_REALLOC(s->pending_entries, s->n_pending_allocated, s->n_pending_entries + 1))
+                e = pending_entry_new(uid, priority, &ts, iovec, n);
+        if (e) {
+                s->pending_entries[s->n_pending_entries++] = e;
+                s->pending_bytes += sz;
+
+                r = sd_event_source_set_enabled(s->pending_event_source, SD_EVENT_ONESHOT);
+                if (r < 0)
+                        log_warning_errno(r, "Failed to enable pending entries event source, writing immediately: %m");
+
+                if (r < 0 ||
+                    priority <= LOG_CRIT ||
+                    s->n_pending_entries >= PENDING_ENTRIES_MAX ||
+                    s->pending_bytes >= PENDING_BYTES_MAX)
+                        server_write_pending_entries(s);
+
+                return;
+        }
+
+        /* Keep the ordering intact: write out everything queued before this entry first */
+        server_write_pending_entries(s);
+
+        write_entries_to_journal(
+                        s, uid,
+                        &(JournalFileEntry) {
+                                .ts = ts,
+                                .iovec = iovec,
+                                .n_iovec = n,
+                        }, 1,
+                        priority);
 }
 
 #define IOVEC_ADD_NUMERIC_FIELD(iovec, n, value, type, isset, format, field)  \
@@ -933,19 +1191,23 @@ static void dispatch_message_real(
                 IOVEC_ADD_NUMERIC_FIELD(iovec, n, c->auditid, uint32_t, audit_session_is_valid, "%" PRIu32, "_AUDIT_SESSION");
                 IOVEC_ADD_NUMERIC_FIELD(iovec, n, c->loginuid, uid_t, uid_is_valid, UID_FMT, "_AUDIT_LOGINUID");
 
-                IOVEC_ADD_STRING_FIELD(iovec, n, c->cgroup, "_SYSTEMD_CGROUP"); /* A path */
-                IOVEC_ADD_STRING_FIELD(iovec, n, c->session, "_SYSTEMD_SESSION");
-                IOVEC_ADD_NUMERIC_FIELD(iovec, n, c->owner_uid, uid_t, uid_is_valid, UID_FMT, "_SYSTEMD_OWNER_UID");
-                IOVEC_ADD_STRING_FIELD(iovec, n, c->unit, "_SYSTEMD_UNIT"); /* Unit names are bounded by UNIT_NAME_MAX */
-                IOVEC_ADD_STRING_FIELD(iovec, n, c->user_unit, "_SYSTEMD_USER_UNIT");
-                IOVEC_ADD_STRING_FIELD(iovec, n, c->slice, "_SYSTEMD_SLICE");
-                IOVEC_ADD_STRING_FIELD(iovec, n, c->user_slice, "_SYSTEMD_USER_SLICE");
+                if (c->cgroup) {
+                        const ClientCgroup *g = c->cgroup;
 
-                IOVEC_ADD_ID128_FIELD(iovec, n, c->invocation_id, "_SYSTEMD_INVOCATION_ID");
+                        IOVEC_ADD_STRING_FIELD(iovec, n, g->path, "_SYSTEMD_CGROUP"); /* A path */
+                        IOVEC_ADD_STRING_FIELD(iovec, n, g->session, "_SYSTEMD_SESSION");
+                        IOVEC_ADD_NUMERIC_FIELD(iovec, n, g->owner_uid, uid_t, uid_is_valid, UID_FMT, "_SYSTEMD_OWNER_UID");
+                        IOVEC_ADD_STRING_FIELD(iovec, n, g->unit, "_SYSTEMD_UNIT"); /* Unit names are bounded by UNIT_NAME_MAX */
+                        IOVEC_ADD_STRING_FIELD(iovec, n, g->user_unit, "_SYSTEMD_USER_UNIT");
+                        IOVEC_ADD_STRING_FIELD(iovec, n, g->slice, "_SYSTEMD_SLICE");
+                        IOVEC_ADD_STRING_FIELD(iovec, n, g->user_slice, "_SYSTEMD_USER_SLICE");
 
-                if (c->extra_fields_n_iovec > 0) {
-                        memcpy(iovec + n, c->extra_fields_iovec, c->extra_fields_n_iovec * sizeof(struct iovec));
-                        n += c->extra_fields_n_iovec;
+                        IOVEC_ADD_ID128_FIELD(iovec, n, g->invocation_id, "_SYSTEMD_INVOCATION_ID");
+
+                        if (g->extra_fields_n_iovec > 0) {
+                                memcpy(iovec + n, g->extra_fields_iovec, g->extra_fields_n_iovec * sizeof(struct iovec));
+                                n += g->extra_fields_n_iovec;
+                        }
                 }
         }
 
@@ -968,15 +1230,19 @@ static void dispatch_message_real(
                 IOVEC_ADD_NUMERIC_FIELD(iovec, n, o->auditid, uint32_t, audit_session_is_valid, "%" PRIu32, "OBJECT_AUDIT_SESSION");
                 IOVEC_ADD_NUMERIC_FIELD(iovec, n, o->loginuid, uid_t, uid_is_valid, UID_FMT, "OBJECT_AUDIT_LOGINUID");
 
-                IOVEC_ADD_STRING_FIELD(iovec, n, o->cgroup, "OBJECT_SYSTEMD_CGROUP");
-                IOVEC_ADD_STRING_FIELD(iovec, n, o->session, "OBJECT_SYSTEMD_SESSION");
-                IOVEC_ADD_NUMERIC_FIELD(iovec, n, o->owner_uid, uid_t, uid_is_valid, UID_FMT, "OBJECT_SYSTEMD_OWNER_UID");
-                IOVEC_ADD_STRING_FIELD(iovec, n, o->unit, "OBJECT_SYSTEMD_UNIT");
-                IOVEC_ADD_STRING_FIELD(iovec, n, o->user_unit, "OBJECT_SYSTEMD_USER_UNIT");
-                IOVEC_ADD_STRING_FIELD(iovec, n, o->slice, "OBJECT_SYSTEMD_SLICE");
-                IOVEC_ADD_STRING_FIELD(iovec, n, o->user_slice, "OBJECT_SYSTEMD_USER_SLICE");
+                if (o->cgroup) {
+                        const ClientCgroup *g = o->cgroup;
+
+                        IOVEC_ADD_STRING_FIELD(iovec, n, g->path, "OBJECT_SYSTEMD_CGROUP");
+                        IOVEC_ADD_STRING_FIELD(iovec, n, g->session, "OBJECT_SYSTEMD_SESSION");
+                        IOVEC_ADD_NUMERIC_FIELD(iovec, n, g->owner_uid, uid_t, uid_is_valid, UID_FMT, "OBJECT_SYSTEMD_OWNER_UID");
+                        IOVEC_ADD_STRING_FIELD(iovec, n, g->unit, "OBJECT_SYSTEMD_UNIT");
+                        IOVEC_ADD_STRING_FIELD(iovec, n, g->user_unit, "OBJECT_SYSTEMD_USER_UNIT");
+                        IOVEC_ADD_STRING_FIELD(iovec, n, g->slice, "OBJECT_SYSTEMD_SLICE");
+                        IOVEC_ADD_STRING_FIELD(iovec, n, g->user_slice, "OBJECT_SYSTEMD_USER_SLICE");
 
-                IOVEC_ADD_ID128_FIELD(iovec, n, o->invocation_id, "OBJECT_SYSTEMD_INVOCATION_ID=");
+                        IOVEC_ADD_ID128_FIELD(iovec, n, g->invocation_id, "OBJECT_SYSTEMD_INVOCATION_ID=");
+                }
         }
 
         assert(n <= m);
@@ -1006,13 +1272,13 @@ static void dispatch_message_real(
         if (s->split_mode == SPLIT_UID && c && uid_is_valid(c->uid))
                 /* Split up strictly by (non-root) UID */
                 journal_uid = c->uid;
-        else if (s->split_mode == SPLIT_LOGIN && c && c->uid > 0 && uid_is_valid(c->owner_uid))
+        else if (s->split_mode == SPLIT_LOGIN && c && c->uid > 0 && c->cgroup && uid_is_valid(c->cgroup->owner_uid))
                 /* Split up by login UIDs.  We do this only if the
                  * realuid is not root, in order not to accidentally
                  * leak privileged information to the user that is
                  * logged by a privileged process that is part of an
                  * unprivileged session. */
-                journal_uid = c->owner_uid;
+                journal_uid = c->cgroup->owner_uid;
         else
                 journal_uid = 0;
 
@@ -1068,7 +1334,52 @@ void server_driver_message(Server *s, pid_t object_pid, const char *message_id,
         }
 }
 
-void server_dispatch_message(
+bool server_message_suppressed(Server *s, ClientContext *c, int priority) {
+        uint64_t available = 0;
+        const ClientCgroup *g;
+        int rl;
+
+        assert(s);
+
+        /* Returns true if a message of the specified priority from the specified client is not going to be
+         * stored, either because of the configuration or because the client exceeded its rate limit. In the
+         * latter case the message is counted as suppressed, hence call this exactly once per message, and
+         * only dispatch it with server_dispatch_checked_message() afterwards. Transports that know the
+         * priority early use this to skip the work of preparing a message that is dropped anyway. */
+
+        if (LOG_PRI(priority) > s->max_level_store)
+                return true;
+
+        /* Stop early in case the information will not be stored
+         * in a journal. */
+        if (s->storage == STORAGE_NONE)
+                return true;
+
+        if (!c || !c->cgroup || !c->cgroup->unit)
+                return false;
+
+        g = c->cgroup;
+
+        (void) determine_space(s, &available, NULL);
+
+        rl = journal_ratelimit_test(s->ratelimit, g->ratelimit_id, g->log_ratelimit_interval, g->log_ratelimit_burst, priority & LOG_PRIMASK, available);
+        if (rl == 0) {
+                s->n_messages_suppressed++;
+                return true;
+        }
+
+        /* Write a suppression message if we suppressed something */
+        if (rl > 1)
+                server_driver_message(s, c->pid,
+                                      "MESSAGE_ID=" SD_MESSAGE_JOURNAL_DROPPED_STR,
+                                      LOG_MESSAGE("Suppressed %i messages from %s", rl - 1, g->unit),
+                                      "N_DROPPED=%i", rl - 1,
+                                      NULL);
+
+        return false;
+}
+
+void server_dispatch_checked_message(
                 Server *s,
                 struct iovec *iovec, size_t n, size_t m,
                 ClientContext *c,
@@ -1076,43 +1387,37 @@ void server_dispatch_message(
                 int priority,
                 pid_t object_pid) {
 
-        uint64_t available = 0;
-        int rl;
-
         assert(s);
         assert(iovec || n == 0);
 
         if (n == 0)
                 return;
 
-        if (LOG_PRI(priority) > s->max_level_store)
-                return;
+        dispatch_message_real(s, iovec, n, m, c, tv, priority, object_pid);
+}
 
-        /* Stop early in case the information will not be stored
-         * in a journal. */
-        if (s->storage == STORAGE_NONE)
-                return;
+void server_dispatch_message(
+                Server *s,
+                struct iovec *iovec, size_t n, size_t m,
+                ClientContext *c,
+                const struct timeval *tv,
+                int priority,
+                pid_t object_pid) {
 
-        if (c && c->unit) {
-                (void) determine_space(s, &available, NULL);
+        assert(s);
+        assert(iovec || n == 0);
 
-                rl = journal_ratelimit_test(s->ratelimit, c->unit, c->log_ratelimit_interval, c->log_ratelimit_burst, priority & LOG_PRIMASK, available);
-                if (rl == 0)
-                        return;
+        if (n == 0)
+                return;
 
-                /* Write a suppression message if we suppressed something */
-                if (rl > 1)
-                        server_driver_message(s, c->pid,
-                                              "MESSAGE_ID=" SD_MESSAGE_JOURNAL_DROPPED_STR,
-                                              LOG_MESSAGE("Suppressed %i messages from %s", rl - 1, c->unit),
-                                              "N_DROPPED=%i", rl - 1,
-                                              NULL);
-        }
+        if (server_message_suppressed(s, c, priority))
+                return;
 
         dispatch_message_real(s, iovec, n, m, c, tv, priority, object_pid);
 }
 
 int server_flush_to_var(Server *s, bool require_flag_file) {
+        _cleanup_set_free_ Set *copied = NULL;
         char ts[FORMAT_TIMESPAN_MAX];
         sd_journal *j = NULL;
         const char *fn;
@@ -1128,6 +1433,8 @@ int server_flush_to_var(Server *s, bool require_flag_file) {
         if (s->namespace) /* Flushing concept does not exist for namespace instances */
                 return 0;
 
+        server_write_pending_entries(s);
+
         if (!s->runtime_journal) /* Nothing to flush? */
                 return 0;
 
@@ -1164,7 +1471,7 @@ int server_flush_to_var(Server *s, bool require_flag_file) {
                         goto finish;
                 }
 
-                r = journal_file_copy_entry(f, s->system_journal, o, f->current_offset);
+                r = journal_file_copy_entry(f, s->system_journal, o, f->current_offset, &copied);
                 if (r >= 0)
                         continue;
 
@@ -1176,6 +1483,9 @@ int server_flush_to_var(Server *s, bool require_flag_file) {
                 server_rotate(s);
                 server_vacuum(s, false);
 
+                /* The remembered DATA objects refer to the file we just rotated away */
+                copied = set_free(copied);
+
                 if (!s->system_journal) {
                         log_notice("Didn't flush runtime journal since rotation of system journal wasn't successful.");
                         r = -EIO;
@@ -1183,7 +1493,7 @@ int server_flush_to_var(Server *s, bool require_flag_file) {
                 }
 
                 log_debug("Retrying write.");
-                r = journal_file_copy_entry(f, s->system_journal, o, f->current_offset);
+                r = journal_file_copy_entry(f, s->system_journal, o, f->current_offset, &copied);
                 if (r < 0) {
                         log_error_errno(r, "Can't write entry: %m");
                         goto finish;
@@ -1234,6 +1544,8 @@ static int server_relinquish_var(Server *s) {
 
         log_debug("Relinquishing %s...", s->system_storage.path);
 
+        server_write_pending_entries(s);
+
         (void) system_journal_open(s, false, true);
 
         s->system_journal = journal_file_close(s->system_journal);
@@ -1248,76 +1560,97 @@ static int server_relinquish_var(Server *s) {
         return 0;
 }
 
-int server_process_datagram(
-                sd_event_source *es,
-                int fd,
-                uint32_t revents,
-                void *userdata) {
-
-        Server *s = userdata;
-        struct ucred *ucred = NULL;
-        struct timeval *tv = NULL;
-        struct cmsghdr *cmsg;
-        char *label = NULL;
-        size_t label_len = 0, m;
-        struct iovec iovec;
-        ssize_t n;
-        int *fds = NULL, v = 0;
-        size_t n_fds = 0;
-
-        /* We use NAME_MAX space for the SELinux label here. The kernel currently enforces no limit, but
-         * according to suggestions from the SELinux people this will change and it will probably be
-         * identical to NAME_MAX. For now we use that, but this should be updated one day when the final
-         * limit is known. */
-        CMSG_BUFFER_TYPE(CMSG_SPACE(sizeof(struct ucred)) +
+/* We use NAME_MAX space for the SELinux label here. The kernel currently enforces no limit, but
+ * according to suggestions from the SELinux people this will change and it will probably be
+ * identical to NAME_MAX. For now we use that, but this should be updated one day when the final
+ * limit is known. */
+typedef CMSG_BUFFER_TYPE(CMSG_SPACE(sizeof(struct ucred)) +
                          CMSG_SPACE(sizeof(struct timeval)) +
                          CMSG_SPACE(sizeof(int)) + /* fd */
-                         CMSG_SPACE(NAME_MAX) /* selinux label */) control;
+                         CMSG_SPACE(NAME_MAX) /* selinux label */) DatagramControl;
 
-        union sockaddr_union sa = {};
+struct DatagramBatch {
+        size_t n_slots;
+        size_t slot_size;
 
-        struct msghdr msghdr = {
-                .msg_iov = &iovec,
-                .msg_iovlen = 1,
-                .msg_control = &control,
-                .msg_controllen = sizeof(control),
-                .msg_name = &sa,
-                .msg_namelen = sizeof(sa),
-        };
+        /* slot 0 is received into Server.buffer, which is sized after the first pending datagram, the
+         * others into fixed size slots of this buffer */
+        uint8_t *buffer;
+        struct iovec *iovecs;
+        struct mmsghdr *msgs;
+        DatagramControl *controls;
 
-        assert(s);
-        assert(fd == s->native_fd || fd == s->syslog_fd || fd == s->audit_fd);
-
-        if (revents != EPOLLIN)
-                return log_error_errno(SYNTHETIC_ERRNO(EIO),
-                                       "Got invalid event from epoll for datagram fd: %" PRIx32,
-                                       revents);
+        /* Whether a datagram did not fit into its slot during the last batch */
+        bool truncated;
+};
 
-        /* Try to get the right size, if we can. (Not all sockets support SIOCINQ, hence we just try, but don't rely on
-         * it.) */
-        (void) ioctl(fd, SIOCINQ, &v);
+static DatagramBatch* datagram_batch_free(DatagramBatch *b) {
+        if (!b)
+                return NULL;
 
-        /* Fix it up, if it is too small. We use the same fixed value as auditd here. Awful! */
-        m = PAGE_ALIGN(MAX3((size_t) v + 1,
-                            (size_t) LINE_MAX,
-                            ALIGN(sizeof(struct nlmsghdr)) + ALIGN((size_t) MAX_AUDIT_MESSAGE_LENGTH)) + 1);
+        free(b->buffer);
+        free(b->iovecs);
+        free(b->msgs);
+        free(b->controls);
+        return mfree(b);
+}
 
-        if (!GREEDY_REALLOC(s->buffer, s->buffer_size, m))
-                return log_oom();
+static int datagram_batch_ensure(DatagramBatch **b, size_t n_slots, size_t slot_size) {
+        DatagramBatch *d;
 
-        iovec = IOVEC_MAKE(s->buffer, s->buffer_size - 1); /* Leave room for trailing NUL we add later */
+        assert(b);
+        assert(n_slots > 1);
+        assert(slot_size > 0);
 
-        n = recvmsg_safe(fd, &msghdr, MSG_DONTWAIT|MSG_CMSG_CLOEXEC);
-        if (IN_SET(n, -EINTR, -EAGAIN))
-                return 0;
-        if (n == -EXFULL) {
-                log_warning("Got message with truncated control data (too many fds sent?), ignoring.");
+        d = *b;
+        if (d && d->n_slots == n_slots && d->slot_size >= slot_size)
                 return 0;
+
+        d = datagram_batch_free(d);
+        *b = NULL;
+
+        d = new(DatagramBatch, 1);
+        if (!d)
+                return -ENOMEM;
+
+        *d = (DatagramBatch) {
+                .n_slots = n_slots,
+                .slot_size = slot_size,
+                .buffer = malloc((n_slots - 1) * slot_size),
+                .iovecs = new(struct iovec, n_slots),
+                .msgs = new(struct mmsghdr, n_slots),
+                .controls = new(DatagramControl, n_slots),
+        };
+        if (!d->buffer || !d->iovecs || !d->msgs || !d->controls) {
+                datagram_batch_free(d);
+                return -ENOMEM;
         }
-        if (n < 0)
-                return log_error_errno(n, "recvmsg() failed: %m");
 
-        CMSG_FOREACH(cmsg, &msghdr)
+        *b = d;
+        return 0;
+}
+
+static void server_process_received_datagram(
+                Server *s,
+                int fd,
+                char *buffer,
+                size_t n,
+                struct msghdr *msghdr,
+                const union sockaddr_union *sa) {
+
+        struct ucred *ucred = NULL;
+        struct timeval *tv = NULL;
+        struct cmsghdr *cmsg;
+        char *label = NULL;
+        size_t label_len = 0;
+        int *fds = NULL;
+        size_t n_fds = 0;
+
+        assert(s);
+        assert(buffer);
+        assert(msghdr);
+
+        CMSG_FOREACH(cmsg, msghdr)
                 if (cmsg->cmsg_level == SOL_SOCKET &&
                     cmsg->cmsg_type == SCM_CREDENTIALS &&
                     cmsg->cmsg_len == CMSG_LEN(sizeof(struct ucred))) {
@@ -1341,17 +1674,17 @@ int server_process_datagram(
                 }
 
         /* And a trailing NUL, just in case */
-        s->buffer[n] = 0;
+        buffer[n] = 0;
 
         if (fd == s->syslog_fd) {
                 if (n > 0 && n_fds == 0)
-                        server_process_syslog_message(s, s->buffer, n, ucred, tv, label, label_len);
+                        server_process_syslog_message(s, buffer, n, ucred, tv, label, label_len);
                 else if (n_fds > 0)
                         log_warning("Got file descriptors via syslog socket. Ignoring.");
 
         } else if (fd == s->native_fd) {
                 if (n > 0 && n_fds == 0)
-                        server_process_native_message(s, s->buffer, n, ucred, tv, label, label_len);
+                        server_process_native_message(s, buffer, n, ucred, tv, label, label_len);
                 else if (n == 0 && n_fds == 1)
                         server_process_native_file(s, fds[0], ucred, tv, label, label_len);
                 else if (n_fds > 0)
@@ -1359,14 +1692,154 @@ int server_process_datagram(
 
         } else {
                 assert(fd == s->audit_fd);
+                assert(sa);
 
                 if (n > 0 && n_fds == 0)
-                        server_process_audit_message(s, s->buffer, n, ucred, &sa, msghdr.msg_namelen);
+                        server_process_audit_message(s, buffer, n, ucred, sa, msghdr->msg_namelen);
                 else if (n_fds > 0)
                         log_warning("Got file descriptors via audit socket. Ignoring.");
         }
 
         close_many(fds, n_fds);
+}
+
+static int server_process_datagram_batch(Server *s, int fd) {
+        DatagramBatch *b;
+        bool truncated = false;
+        size_t slot_size;
+        int n, r;
+
+        assert(s);
+        assert(s->datagram_batch_size > 1);
+
+        /* Drain up to datagram_batch_size datagrams with a single recvmmsg() call. The first one is
+         * received into the main buffer, which has been sized to fit it. The others go into slots of a
+         * fixed size, which is doubled whenever a datagram did not fit, up to DATAGRAM_SLOT_SIZE_MAX. */
+
+        slot_size = DATAGRAM_SLOT_SIZE_MIN;
+        if (s->datagram_batch) {
+                slot_size = s->datagram_batch->slot_size;
+                if (s->datagram_batch->truncated)
+                        slot_size = MIN(slot_size * 2, DATAGRAM_SLOT_SIZE_MAX);
+        }
+
+        r = datagram_batch_ensure(&s->datagram_batch, s->datagram_batch_size, slot_size);
+        if (r < 0)
+                return log_oom();
+
+        b = s->datagram_batch;
+
+        for (size_t i = 0; i < b->n_slots; i++) {
+                if (i == 0)
+                        b->iovecs[i] = IOVEC_MAKE(s->buffer, s->buffer_size - 1); /* Leave room for trailing NUL we add later */
+                else
+                        b->iovecs[i] = IOVEC_MAKE(b->buffer + (i - 1) * b->slot_size, b->slot_size - 1);
+
+                b->msgs[i] = (struct mmsghdr) {
+                        .msg_hdr = {
+                                .msg_iov = b->iovecs + i,
+                                .msg_iovlen = 1,
+                                .msg_control = b->controls + i,
+                                .msg_controllen = sizeof(DatagramControl),
+                        },
+                };
+        }
+
+        n = recvmmsg(fd, b->msgs, b->n_slots, MSG_DONTWAIT|MSG_CMSG_CLOEXEC, NULL);
+        if (n < 0) {
+                if (IN_SET(errno, EINTR, EAGAIN))
+                        return 0;
+
+                return log_error_errno(errno, "recvmmsg() failed: %m");
+        }
+
+        for (int i = 0; i < n; i++) {
+                struct msghdr *mh = &b->msgs[i].msg_hdr;
+
+                if (FLAGS_SET(mh->msg_flags, MSG_CTRUNC)) {
+                        cmsg_close_all(mh);
+                        log_warning("Got message with truncated control data (too many fds sent?), ignoring.");
+                        continue;
+                }
+
+                if (FLAGS_SET(mh->msg_flags, MSG_TRUNC)) {
+                        cmsg_close_all(mh);
+                        log_warning("Got datagram larger than receive buffer (%zu bytes), ignoring.", mh->msg_iov->iov_len);
+                        truncated = true;
+                        continue;
+                }
+
+                server_process_received_datagram(s, fd, mh->msg_iov->iov_base, b->msgs[i].msg_len, mh, NULL);
+        }
+
+        b->truncated = truncated;
+
+        server_refresh_idle_timer(s);
+        return 0;
+}
+
+int server_process_datagram(
+                sd_event_source *es,
+                int fd,
+                uint32_t revents,
+                void *userdata) {
+
+        Server *s = userdata;
+        struct iovec iovec;
+        ssize_t n;
+        int v = 0;
+        size_t m;
+
+        DatagramControl control;
+
+        union sockaddr_union sa = {};
+
+        struct msghdr msghdr = {
+                .msg_iov = &iovec,
+                .msg_iovlen = 1,
+                .msg_control = &control,
+                .msg_controllen = sizeof(control),
+                .msg_name = &sa,
+                .msg_namelen = sizeof(sa),
+        };
+
+        assert(s);
+        assert(fd == s->native_fd || fd == s->syslog_fd || fd == s->audit_fd);
+
+        if (revents != EPOLLIN)
+                return log_error_errno(SYNTHETIC_ERRNO(EIO),
+                                       "Got invalid event from epoll for datagram fd: %" PRIx32,
+                                       revents);
+
+        /* Try to get the right size, if we can. (Not all sockets support SIOCINQ, hence we just try, but don't rely on
+         * it.) */
+        (void) ioctl(fd, SIOCINQ, &v);
+
+        /* Fix it up, if it is too small. We use the same fixed value as auditd here. Awful! */
+        m = PAGE_ALIGN(MAX3((size_t) v + 1,
+                            (size_t) LINE_MAX,
+                            ALIGN(sizeof(struct nlmsghdr)) + ALIGN((size_t) MAX_AUDIT_MESSAGE_LENGTH)) + 1);
+
+        if (!GREEDY_REALLOC(s->buffer, s->buffer_size, m))
+                return log_oom();
+
+        /* The audit socket is a netlink socket, which needs the sender address, and is low traffic anyway */
+        if (fd != s->audit_fd && s->datagram_batch_size > 1)
+                return server_process_datagram_batch(s, fd);
+
+        iovec = IOVEC_MAKE(s->buffer, s->buffer_size - 1); /* Leave room for trailing NUL we add later */
+
+        n = recvmsg_safe(fd, &msghdr, MSG_DONTWAIT|MSG_CMSG_CLOEXEC);
+        if (IN_SET(n, -EINTR, -EAGAIN))
+                return 0;
+        if (n == -EXFULL) {
+                log_warning("Got message with truncated control data (too many fds sent?), ignoring.");
+                return 0;
+        }
+        if (n < 0)
+                return log_error_errno(n, "recvmsg() failed: %m");
+
+        server_process_received_datagram(s, fd, s->buffer, n, &msghdr, &sa);
 
         server_refresh_idle_timer(s);
         return 0;
@@ -2008,6 +2481,65 @@ static int vl_method_relinquish_var(Varlink *link, JsonVariant *parameters, Varl
         return varlink_reply(link, NULL);
 }
 
+static int vl_method_get_context_cache_statistics(Varlink *link, JsonVariant *parameters, VarlinkMethodFlags flags, void *userdata) {
+        _cleanup_(json_variant_unrefp) JsonVariant *v = NULL;
+        Server *s = userdata;
+        int r;
+
+        assert(link);
+        assert(s);
+
+        if (json_variant_elements(parameters) > 0)
+                return varlink_error_invalid_parameter(link, parameters);
+
+        r = client_context_build_statistics(s, &v);
+        if (r < 0)
+                return log_error_errno(r, "Failed to build client context cache statistics: %m");
+
+        return varlink_reply(link, v);
+}
+
+static int vl_method_list_metrics(Varlink *link, JsonVariant *parameters, VarlinkMethodFlags flags, void *userdata) {
+        Server *s = userdata;
+
+        assert(link);
+        assert(s);
+
+        const Metric metrics[] = {
+                METRIC_COUNTER_MAKE("entriesWritten", "Entries written to journal files", s->n_entries_written),
+                METRIC_COUNTER_MAKE("entriesFailed", "Entries that could not be written", s->n_entries_failed),
+                METRIC_COUNTER_MAKE("messagesSuppressed", "Messages dropped due to rate limiting", s->n_messages_suppressed),
+                METRIC_GAUGE_MAKE("pendingEntries", "Entries queued for writing", s->n_pending_entries),
+                METRIC_GAUGE_MAKE("stdoutStreams", "Connected stdout streams", s->n_stdout_streams),
+                METRIC_HISTOGRAM_MAKE("writeBatchUSec", "Time spent writing a batch of entries", &s->write_batch),
+        };
+
+        return varlink_reply_metrics(link, parameters, metrics, ELEMENTSOF(metrics));
+}
+
+static int vl_method_subscribe(Varlink *link, JsonVariant *parameters, VarlinkMethodFlags flags, void *userdata) {
+        Server *s = userdata;
+        int r;
+
+        assert(link);
+        assert(s);
+
+        if (json_variant_elements(parameters) > 0)
+                return varlink_error_invalid_parameter(link, parameters);
+        if (!FLAGS_SET(flags, VARLINK_METHOD_MORE))
+                return varlink_error(link, "org.varlink.service.ExpectedMore", NULL);
+
+        log_debug("Received client request to subscribe to journal entries.");
+
+        /* There's no reply to this, just one notification for each entry written from now on, until the
+         * client disconnects. */
+        r = server_add_subscriber(s, link);
+        if (r < 0)
+                return log_error_errno(r, "Failed to add subscriber: %m");
+
+        return 0;
+}
+
 static int vl_connect(VarlinkServer *server, Varlink *link, void *userdata) {
         Server *s = userdata;
 
@@ -2027,6 +2559,8 @@ static void vl_disconnect(VarlinkServer *server, Varlink *link, void *userdata)
         assert(link);
         assert(s);
 
+        server_remove_subscriber(s, link);
+
         (void) server_start_or_stop_idle_timer(s); /* maybe we are idle now */
 }
 
@@ -2043,10 +2577,13 @@ static int server_open_varlink(Server *s, const char *socket, int fd) {
 
         r = varlink_server_bind_method_many(
                         s->varlink_server,
-                        "io.systemd.Journal.Synchronize",   vl_method_synchronize,
-                        "io.systemd.Journal.Rotate",        vl_method_rotate,
-                        "io.systemd.Journal.FlushToVar",    vl_method_flush_to_var,
-                        "io.systemd.Journal.RelinquishVar", vl_method_relinquish_var);
+                        "io.systemd.Journal.Synchronize",                vl_method_synchronize,
+                        "io.systemd.Journal.Rotate",                     vl_method_rotate,
+                        "io.systemd.Journal.FlushToVar",                 vl_method_flush_to_var,
+                        "io.systemd.Journal.RelinquishVar",              vl_method_relinquish_var,
+                        "io.systemd.Journal.GetContextCacheStatistics",  vl_method_get_context_cache_statistics,
+                        "io.systemd.Journal.Subscribe",                  vl_method_subscribe,
+                        "io.systemd.Metrics.List",                       vl_method_list_metrics);
         if (r < 0)
                 return r;
 
@@ -2211,6 +2748,7 @@ int server_init(Server *s, const char *namespace) {
                 .max_level_wall = LOG_EMERG,
 
                 .line_max = DEFAULT_LINE_MAX,
+                .datagram_batch_size = DEFAULT_DATAGRAM_BATCH_SIZE,
 
                 .runtime_storage.name = "Runtime Journal",
                 .system_storage.name = "System Journal",
@@ -2242,6 +2780,12 @@ int server_init(Server *s, const char *namespace) {
                 s->ratelimit_interval = s->ratelimit_burst = 0;
         }
 
+        if (s->datagram_batch_size > DATAGRAM_BATCH_SIZE_MAX) {
+                log_warning("DatagramBatchSize= set to %u, which is too large, bumping down to %u.",
+                            s->datagram_batch_size, DATAGRAM_BATCH_SIZE_MAX);
+                s->datagram_batch_size = DATAGRAM_BATCH_SIZE_MAX;
+        }
+
         e = getenv("RUNTIME_DIRECTORY");
         if (e)
                 s->runtime_directory = strdup(e);
@@ -2389,6 +2933,10 @@ int server_init(Server *s, const char *namespace) {
         if (r < 0)
                 return r;
 
+        r = server_open_pending_event_source(s);
+        if (r < 0)
+                return r;
+
         s->ratelimit = journal_ratelimit_new();
         if (!s->ratelimit)
                 return log_oom();
@@ -2435,6 +2983,8 @@ void server_maybe_append_tags(Server *s) {
         JournalFile *f;
         usec_t n;
 
+        server_write_pending_entries(s);
+
         n = now(CLOCK_REALTIME);
 
         if (s->system_journal)
@@ -2448,6 +2998,10 @@ void server_maybe_append_tags(Server *s) {
 void server_done(Server *s) {
         assert(s);
 
+        /* Entries logged while writing out the queue are dropped, there's no one left to write them */
+        server_write_pending_entries(s);
+        pending_entries_free(s->pending_entries, s->n_pending_entries);
+
         free(s->namespace);
         free(s->namespace_field);
 
@@ -2464,11 +3018,13 @@ void server_done(Server *s) {
         ordered_hashmap_free_with_destructor(s->user_journals, journal_file_close);
 
         varlink_server_unref(s->varlink_server);
+        set_free_with_destructor(s->subscribers, varlink_unref);
 
         sd_event_source_unref(s->syslog_event_source);
         sd_event_source_unref(s->native_event_source);
         sd_event_source_unref(s->stdout_event_source);
         sd_event_source_unref(s->dev_kmsg_event_source);
+        hashmap_free(s->kmsg_devices);
         sd_event_source_unref(s->audit_event_source);
         sd_event_source_unref(s->sync_event_source);
         sd_event_source_unref(s->sigusr1_event_source);
@@ -2480,6 +3036,7 @@ void server_done(Server *s) {
         sd_event_source_unref(s->notify_event_source);
         sd_event_source_unref(s->watchdog_event_source);
         sd_event_source_unref(s->idle_event_source);
+        sd_event_source_unref(s->pending_event_source);
         sd_event_unref(s->event);
 
         safe_close(s->syslog_fd);
@@ -2497,9 +3054,13 @@ void server_done(Server *s) {
                 munmap(s->kernel_seqnum, sizeof(uint64_t));
 
         free(s->buffer);
+        datagram_batch_free(s->datagram_batch);
         free(s->tty_path);
         free(s->cgroup_root);
         free(s->hostname_field);
+        journal_vacuum_cache_free(s->runtime_storage.vacuum_cache);
+        journal_vacuum_cache_free(s->system_storage.vacuum_cache);
+
         free(s->runtime_storage.path);
         free(s->system_storage.path);
         free(s->runtime_directory);
@@ -7,14 +7,18 @@
 #include "sd-event.h"
 
 typedef struct Server Server;
+typedef struct PendingEntry PendingEntry;
+typedef struct DatagramBatch DatagramBatch;
 
 #include "conf-parser.h"
 #include "hashmap.h"
 #include "journal-file.h"
+#include "journal-vacuum.h"
 #include "journald-context.h"
 #include "journald-rate-limit.h"
 #include "journald-stream.h"
 #include "list.h"
+#include "metrics.h"
 #include "prioq.h"
 #include "time-util.h"
 #include "varlink.h"
@@ -57,6 +61,8 @@ typedef struct JournalStorage {
 
         JournalMetrics metrics;
         JournalStorageSpace space;
+
+        JournalVacuumCache *vacuum_cache;
 } JournalStorage;
 
 struct Server {
@@ -87,6 +93,7 @@ struct Server {
         sd_event_source *notify_event_source;
         sd_event_source *watchdog_event_source;
         sd_event_source *idle_event_source;
+        sd_event_source *pending_event_source;
 
         JournalFile *runtime_journal;
         JournalFile *system_journal;
@@ -94,9 +101,24 @@ struct Server {
 
         uint64_t seqnum;
 
+        /* Entries that have been processed but not written yet, see write_to_journal() */
+        PendingEntry **pending_entries;
+        size_t n_pending_entries, n_pending_allocated;
+        size_t pending_bytes;
+
+        /* Statistics, exposed via io.systemd.Metrics.List() */
+        uint64_t n_entries_written;
+        uint64_t n_entries_failed;
+        uint64_t n_messages_suppressed;
+        MetricHistogram write_batch;
+
         char *buffer;
         size_t buffer_size;
 
+        /* Receive buffers for the datagrams following the first one in a batch, see server_process_datagram() */
+        DatagramBatch *datagram_batch;
+        unsigned datagram_batch_size;
+
         JournalRateLimit *ratelimit;
         usec_t sync_interval_usec;
         usec_t ratelimit_interval;
@@ -106,7 +128,9 @@ struct Server {
         JournalStorage system_storage;
 
         JournalCompressOptions compress;
+        unsigned compress_threads;
         bool seal;
+        bool grep_index;
         bool read_kmsg;
         int set_audit;
 
@@ -118,6 +142,9 @@ struct Server {
         unsigned n_forward_syslog_missed;
         usec_t last_warn_forward_syslog_missed;
 
+        unsigned n_forward_console_missed;
+        usec_t last_warn_forward_console_missed;
+
         usec_t max_retention_usec;
         usec_t max_file_usec;
         usec_t oldest_file_usec;
@@ -142,11 +169,13 @@ struct Server {
         Set *deferred_closes;
 
         uint64_t *kernel_seqnum;
+        Hashmap *kmsg_devices;
         bool dev_kmsg_readable:1;
 
         bool send_watchdog:1;
         bool sent_notify_ready:1;
         bool sync_scheduled:1;
+        bool writing_pending_entries:1;
 
         char machine_id_field[sizeof("_MACHINE_ID=") + 32];
         char boot_id_field[sizeof("_BOOT_ID=") + 32];
@@ -166,6 +195,15 @@ struct Server {
         /* Caching of client metadata */
         Hashmap *client_contexts;
         Prioq *client_contexts_lru;
+        Hashmap *client_cgroups;
+        size_t client_contexts_size;
+
+        uint64_t client_context_hits;
+        uint64_t client_context_misses;
+        uint64_t client_context_refreshes;
+        uint64_t client_context_evictions;
+        uint64_t client_cgroup_hits;
+        uint64_t client_cgroup_misses;
 
         usec_t last_cache_pid_flush;
 
@@ -173,6 +211,7 @@ struct Server {
         ClientContext *pid1_context; /* the context of PID 1 */
 
         VarlinkServer *varlink_server;
+        Set *subscribers; /* varlink connections that get each entry we write */
 };
 
 #define SERVER_MACHINE_ID(s) ((s)->machine_id_field + STRLEN("_MACHINE_ID="))
@@ -192,6 +231,8 @@ struct Server {
 /* kmsg: Maximum number of extra fields we'll import from udev's devices */
 #define N_IOVEC_UDEV_FIELDS 32
 
+bool server_message_suppressed(Server *s, ClientContext *c, int priority);
+void server_dispatch_checked_message(Server *s, struct iovec *iovec, size_t n, size_t m, ClientContext *c, const struct timeval *tv, int priority, pid_t object_pid);
 void server_dispatch_message(Server *s, struct iovec *iovec, size_t n, size_t m, ClientContext *c, const struct timeval *tv, int priority, pid_t object_pid);
 void server_driver_message(Server *s, pid_t object_pid, const char *message_id, const char *format, ...) _sentinel_ _printf_(4,0);
 
@@ -213,6 +254,7 @@ SplitMode split_mode_from_string(const char *s) _pure_;
 int server_init(Server *s, const char *namespace);
 void server_done(Server *s);
 void server_sync(Server *s);
+void server_write_pending_entries(Server *s);
 int server_vacuum(Server *s, bool verbose);
 void server_rotate(Server *s);
 int server_schedule_sync(Server *s, int priority);
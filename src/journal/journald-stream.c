@@ -53,6 +53,10 @@ typedef enum StdoutStreamState {
 /* The different types of log record terminators: a real \n was read, a NUL character was read, the maximum line length
  * was reached, or the end of the stream was reached */
 
+/* Room in front of the data in the stream buffer, so that even the first line in it can be turned into a
+ * MESSAGE= field in place */
+#define STDOUT_STREAM_HEADROOM STRLEN("MESSAGE=")
+
 typedef enum LineBreak {
         LINE_BREAK_NEWLINE,
         LINE_BREAK_NUL,
@@ -72,6 +76,7 @@ struct StdoutStream {
         struct ucred ucred;
         char *label;
         char *identifier;
+        char *identifier_field;
         char *unit_id;
         int priority;
         bool level_prefix:1;
@@ -82,6 +87,7 @@ struct StdoutStream {
         bool fdstore:1;
         bool in_notify_queue:1;
 
+        /* The data read from the stream starts at STDOUT_STREAM_HEADROOM into the buffer, see stdout_stream_log() */
         char *buffer;
         size_t length;
         size_t allocated;
@@ -125,6 +131,7 @@ StdoutStream* stdout_stream_free(StdoutStream *s) {
         safe_close(s->fd);
         free(s->label);
         free(s->identifier);
+        free(s->identifier_field);
         free(s->unit_id);
         free(s->state_file);
         free(s->buffer);
@@ -243,19 +250,22 @@ fail:
 
 static int stdout_stream_log(
                 StdoutStream *s,
-                const char *p,
+                char *line,
                 LineBreak line_break) {
 
         struct iovec *iovec;
         int priority;
         char syslog_priority[] = "PRIORITY=\0";
         char syslog_facility[STRLEN("SYSLOG_FACILITY=") + DECIMAL_STR_MAX(int) + 1];
-        _cleanup_free_ char *message = NULL, *syslog_identifier = NULL;
+        char saved[STRLEN("MESSAGE=")];
         size_t n = 0, m;
+        const char *p = line;
+        bool suppressed;
+        char *message;
         int r;
 
         assert(s);
-        assert(p);
+        assert(line);
 
         assert(line_break >= 0);
         assert(line_break < _LINE_BREAK_MAX);
@@ -279,6 +289,9 @@ static int stdout_stream_log(
         if (isempty(p))
                 return 0;
 
+        /* Check the rate limit before doing any of the work below, the forwarding is not subject to it */
+        suppressed = server_message_suppressed(s->server, s->context, priority);
+
         if (s->forward_to_syslog || s->server->forward_to_syslog)
                 server_forward_syslog(s->server, syslog_fixup_facility(priority), s->identifier, p, &s->ucred, NULL);
 
@@ -291,6 +304,9 @@ static int stdout_stream_log(
         if (s->server->forward_to_wall)
                 server_forward_wall(s->server, priority, s->identifier, p, &s->ucred);
 
+        if (suppressed)
+                return 0;
+
         m = N_IOVEC_META_FIELDS + 7 + client_context_extra_fields_n_iovec(s->context);
         iovec = newa(struct iovec, m);
 
@@ -305,11 +321,10 @@ static int stdout_stream_log(
                 iovec[n++] = IOVEC_MAKE_STRING(syslog_facility);
         }
 
-        if (s->identifier) {
-                syslog_identifier = strjoin("SYSLOG_IDENTIFIER=", s->identifier);
-                if (syslog_identifier)
-                        iovec[n++] = IOVEC_MAKE_STRING(syslog_identifier);
-        }
+        if (s->identifier && !s->identifier_field)
+                s->identifier_field = strjoin("SYSLOG_IDENTIFIER=", s->identifier);
+        if (s->identifier_field)
+                iovec[n++] = IOVEC_MAKE_STRING(s->identifier_field);
 
         static const char * const line_break_field_table[_LINE_BREAK_MAX] = {
                 [LINE_BREAK_NEWLINE]    = NULL, /* Do not add field if traditional newline */
@@ -326,11 +341,18 @@ static int stdout_stream_log(
         if (c)
                 iovec[n++] = IOVEC_MAKE_STRING(c);
 
-        message = strjoin("MESSAGE=", p);
-        if (message)
-                iovec[n++] = IOVEC_MAKE_STRING(message);
+        /* The line is passed on straight from the stream buffer, without copying it. There's always room
+         * for the field name in front of it: it's either the headroom at the beginning of the buffer, or
+         * the end of a line processed earlier, or the priority prefix of this one. Let's put the field name
+         * there for this call, and revert back afterwards. */
+        message = line + (p - line) - STRLEN("MESSAGE=");
+        memcpy(saved, message, sizeof(saved));
+        memcpy(message, "MESSAGE=", STRLEN("MESSAGE="));
+        iovec[n++] = IOVEC_MAKE(message, STRLEN("MESSAGE=") + strlen(p));
+
+        server_dispatch_checked_message(s->server, iovec, n, m, s->context, NULL, priority, 0);
 
-        server_dispatch_message(s->server, iovec, n, m, s->context, NULL, priority, 0);
+        memcpy(message, saved, sizeof(saved));
         return 0;
 }
 
@@ -476,29 +498,31 @@ static int stdout_stream_scan(
                 size_t *ret_consumed) {
 
         size_t consumed = 0;
-        int r;
+        char saved;
+        int r = 0;
 
         assert(s);
         assert(p);
 
+        /* There's always room for one more byte after the data, though it might contain data read later
+         * on. Let's put a NUL there for this call, and revert back afterwards. This way we can look for both
+         * kinds of line terminators in a single pass with strchrnul(), which is vectorized in libc, rather
+         * than with one memchr() for each. */
+        saved = p[remaining];
+        p[remaining] = 0;
+
         for (;;) {
                 LineBreak line_break;
                 size_t skip, found;
-                char *end1, *end2;
+                char *end;
 
-                end1 = memchr(p, '\n', remaining);
-                end2 = memchr(p, 0, end1 ? (size_t) (end1 - p) : remaining);
+                end = strchrnul(p, '\n');
+                found = end - p;
 
-                if (end2) {
-                        /* We found a NUL terminator */
-                        found = end2 - p;
-                        skip = found + 1;
-                        line_break = LINE_BREAK_NUL;
-                } else if (end1) {
-                        /* We found a \n terminator */
-                        found = end1 - p;
+                if (found < remaining) {
+                        /* We found a \n or a NUL terminator */
                         skip = found + 1;
-                        line_break = LINE_BREAK_NEWLINE;
+                        line_break = *end == '\n' ? LINE_BREAK_NEWLINE : LINE_BREAK_NUL;
                 } else if (remaining >= s->server->line_max) {
                         /* Force a line break after the maximum line length */
                         found = skip = s->server->line_max;
@@ -508,7 +532,7 @@ static int stdout_stream_scan(
 
                 r = stdout_stream_found(s, p, found, line_break);
                 if (r < 0)
-                        return r;
+                        goto finish;
 
                 p += skip;
                 consumed += skip;
@@ -518,15 +542,19 @@ static int stdout_stream_scan(
         if (force_flush >= 0 && remaining > 0) {
                 r = stdout_stream_found(s, p, remaining, force_flush);
                 if (r < 0)
-                        return r;
+                        goto finish;
 
                 consumed += remaining;
+                p += remaining;
+                remaining = 0;
         }
 
         if (ret_consumed)
                 *ret_consumed = consumed;
 
-        return 0;
+finish:
+        p[remaining] = saved;
+        return r;
 }
 
 static int stdout_stream_process(sd_event_source *es, int fd, uint32_t revents, void *userdata) {
@@ -535,8 +563,8 @@ static int stdout_stream_process(sd_event_source *es, int fd, uint32_t revents,
         size_t limit, consumed;
         struct ucred *ucred;
         struct iovec iovec;
+        char *data, *p;
         ssize_t l;
-        char *p;
         int r;
 
         struct msghdr msghdr = {
@@ -554,18 +582,20 @@ static int stdout_stream_process(sd_event_source *es, int fd, uint32_t revents,
         }
 
         /* If the buffer is almost full, add room for another 1K */
-        if (s->length + 512 >= s->allocated) {
-                if (!GREEDY_REALLOC(s->buffer, s->allocated, s->length + 1 + 1024)) {
+        if (STDOUT_STREAM_HEADROOM + s->length + 512 >= s->allocated) {
+                if (!GREEDY_REALLOC(s->buffer, s->allocated, STDOUT_STREAM_HEADROOM + s->length + 1 + 1024)) {
                         log_oom();
                         goto terminate;
                 }
         }
 
+        data = s->buffer + STDOUT_STREAM_HEADROOM;
+
         /* Try to make use of the allocated buffer in full, but never read more than the configured line size. Also,
          * always leave room for a terminating NUL we might need to add. */
-        limit = MIN(s->allocated - 1, s->server->line_max);
+        limit = MIN(s->allocated - STDOUT_STREAM_HEADROOM - 1, s->server->line_max);
         assert(s->length <= limit);
-        iovec = IOVEC_MAKE(s->buffer + s->length, limit - s->length);
+        iovec = IOVEC_MAKE(data + s->length, limit - s->length);
 
         l = recvmsg(s->fd, &msghdr, MSG_DONTWAIT|MSG_CMSG_CLOEXEC);
         if (l < 0) {
@@ -578,7 +608,7 @@ static int stdout_stream_process(sd_event_source *es, int fd, uint32_t revents,
         cmsg_close_all(&msghdr);
 
         if (l == 0) {
-                (void) stdout_stream_scan(s, s->buffer, s->length, /* force_flush = */ LINE_BREAK_EOF, NULL);
+                (void) stdout_stream_scan(s, data, s->length, /* force_flush = */ LINE_BREAK_EOF, NULL);
                 goto terminate;
         }
 
@@ -589,15 +619,15 @@ static int stdout_stream_process(sd_event_source *es, int fd, uint32_t revents,
         if (ucred && ucred->pid != s->ucred.pid) {
                 /* Force out any previously half-written lines from a different process, before we switch to
                  * the new ucred structure for everything we just added */
-                r = stdout_stream_scan(s, s->buffer, s->length, /* force_flush = */ LINE_BREAK_PID_CHANGE, NULL);
+                r = stdout_stream_scan(s, data, s->length, /* force_flush = */ LINE_BREAK_PID_CHANGE, NULL);
                 if (r < 0)
                         goto terminate;
 
                 s->context = client_context_release(s->server, s->context);
 
-                p = s->buffer + s->length;
+                p = data + s->length;
         } else {
-                p = s->buffer;
+                p = data;
                 l += s->length;
         }
 
@@ -612,7 +642,7 @@ static int stdout_stream_process(sd_event_source *es, int fd, uint32_t revents,
         /* Move what wasn't consumed to the front of the buffer */
         assert(consumed <= (size_t) l);
         s->length = l - consumed;
-        memmove(s->buffer, p + consumed, s->length);
+        memmove(data, p + consumed, s->length);
 
         return 1;
 
@@ -322,7 +322,7 @@ void server_process_syslog_message(
         ClientContext *context = NULL;
         struct iovec *iovec;
         size_t n = 0, m, i, leading_ws, syslog_ts_len;
-        bool store_raw;
+        bool store_raw, suppressed;
 
         assert(s);
         assert(buf);
@@ -372,6 +372,12 @@ void server_process_syslog_message(
         if (!client_context_test_priority(context, priority))
                 return;
 
+        /* Check the rate limit before parsing the rest of the message. If it is suppressed and there's
+         * nothing to forward it to, we are done. */
+        suppressed = server_message_suppressed(s, context, priority);
+        if (suppressed && !s->forward_to_syslog && !s->forward_to_kmsg && !s->forward_to_console && !s->forward_to_wall)
+                return;
+
         syslog_ts = msg;
         syslog_ts_len = syslog_skip_timestamp(&msg);
         if (syslog_ts_len == 0)
@@ -392,6 +398,9 @@ void server_process_syslog_message(
         if (s->forward_to_wall)
                 server_forward_wall(s, priority, identifier, msg, ucred);
 
+        if (suppressed)
+                return;
+
         m = N_IOVEC_META_FIELDS + 8 + client_context_extra_fields_n_iovec(context);
         iovec = newa(struct iovec, m);
 
@@ -447,7 +456,7 @@ void server_process_syslog_message(
                 iovec[n++] = IOVEC_MAKE(msg_raw, hlen + raw_len);
         }
 
-        server_dispatch_message(s, iovec, n, m, context, tv, priority, 0);
+        server_dispatch_checked_message(s, iovec, n, m, context, tv, priority, 0);
 }
 
 int server_open_syslog_socket(Server *s, const char *syslog_socket) {
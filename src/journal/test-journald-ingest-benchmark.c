@@ -0,0 +1,499 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* Load generator for a running journald instance. Forks a number of native, syslog and stdout stream
+ * clients which send messages with random sizes and fields to the sockets of the specified journal
+ * namespace, while the parent follows the journal and records when each message shows up. Use a
+ * dedicated namespace with rate limiting turned off, e.g.:
+ *
+ *     # mkdir -p /etc/systemd/journald@bench.conf.d
+ *     # printf '[Journal]\nRateLimitIntervalSec=0\n' >/etc/systemd/journald@bench.conf.d/50-bench.conf
+ *     # systemctl start systemd-journald@bench.socket
+ *     # test-journald-ingest-benchmark --namespace=bench
+ *
+ * Note that latencies are measured until the entry is seen by a reader, i.e. include the inotify wakeup,
+ * which is an upper bound for the time until journal_file_append_entry() finished. */
+
+#include <getopt.h>
+#include <math.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "sd-id128.h"
+#include "sd-journal.h"
+
+#include "alloc-util.h"
+#include "fd-util.h"
+#include "fileio.h"
+#include "format-util.h"
+#include "io-util.h"
+#include "log.h"
+#include "main-func.h"
+#include "parse-util.h"
+#include "process-util.h"
+#include "random-util.h"
+#include "socket-util.h"
+#include "stdio-util.h"
+#include "sort-util.h"
+#include "string-util.h"
+#include "time-util.h"
+
+typedef enum ClientType {
+        CLIENT_NATIVE,
+        CLIENT_SYSLOG,
+        CLIENT_STDOUT,
+        _CLIENT_TYPE_MAX,
+} ClientType;
+
+static const char *const client_type_name[_CLIENT_TYPE_MAX] = {
+        [CLIENT_NATIVE] = "native",
+        [CLIENT_SYSLOG] = "syslog",
+        [CLIENT_STDOUT] = "stdout",
+};
+
+static const char *arg_namespace = NULL;
+static unsigned arg_messages = 100000;
+static unsigned arg_clients[_CLIENT_TYPE_MAX] = { 4, 2, 2 };
+static size_t arg_min_size = 16;
+static size_t arg_max_size = 4096;
+static unsigned arg_fields = 4;
+static unsigned arg_cardinality = 100;
+static usec_t arg_idle_timeout = 10 * USEC_PER_SEC;
+
+static char identifier[STRLEN("bench-") + SD_ID128_STRING_MAX];
+
+static int parse_argv(int argc, char *argv[]) {
+        enum {
+                ARG_NAMESPACE = 0x100,
+                ARG_MESSAGES,
+                ARG_NATIVE,
+                ARG_SYSLOG,
+                ARG_STDOUT,
+                ARG_MIN_SIZE,
+                ARG_MAX_SIZE,
+                ARG_FIELDS,
+                ARG_CARDINALITY,
+        };
+
+        static const struct option options[] = {
+                { "help",        no_argument,       NULL, 'h'             },
+                { "namespace",   required_argument, NULL, ARG_NAMESPACE   },
+                { "messages",    required_argument, NULL, ARG_MESSAGES    },
+                { "native",      required_argument, NULL, ARG_NATIVE      },
+                { "syslog",      required_argument, NULL, ARG_SYSLOG      },
+                { "stdout",      required_argument, NULL, ARG_STDOUT      },
+                { "min-size",    required_argument, NULL, ARG_MIN_SIZE    },
+                { "max-size",    required_argument, NULL, ARG_MAX_SIZE    },
+                { "fields",      required_argument, NULL, ARG_FIELDS      },
+                { "cardinality", required_argument, NULL, ARG_CARDINALITY },
+                {}
+        };
+
+        int c, r;
+
+        assert(argc >= 0);
+        assert(argv);
+
+        while ((c = getopt_long(argc, argv, "h", options, NULL)) >= 0)
+                switch (c) {
+
+                case 'h':
+                        printf("%s [OPTION...]\n\n"
+                               "  --namespace=NAME    Journal namespace to send to (default: none)\n"
+                               "  --messages=N        Total number of messages (default: %u)\n"
+                               "  --native=N          Number of native protocol clients (default: %u)\n"
+                               "  --syslog=N          Number of syslog clients (default: %u)\n"
+                               "  --stdout=N          Number of stdout stream clients (default: %u)\n"
+                               "  --min-size=BYTES    Minimum message size (default: %zu)\n"
+                               "  --max-size=BYTES    Maximum message size (default: %zu)\n"
+                               "  --fields=N          Extra fields per native message (default: %u)\n"
+                               "  --cardinality=N     Distinct values per extra field (default: %u)\n",
+                               program_invocation_short_name, arg_messages,
+                               arg_clients[CLIENT_NATIVE], arg_clients[CLIENT_SYSLOG], arg_clients[CLIENT_STDOUT],
+                               arg_min_size, arg_max_size, arg_fields, arg_cardinality);
+                        return 0;
+
+                case ARG_NAMESPACE:
+                        arg_namespace = optarg;
+                        break;
+
+                case ARG_MESSAGES:
+                        r = safe_atou(optarg, &arg_messages);
+                        if (r < 0 || arg_messages == 0)
+                                return log_error_errno(r < 0 ? r : SYNTHETIC_ERRNO(EINVAL), "Failed to parse --messages=: %s", optarg);
+                        break;
+
+                case ARG_NATIVE:
+                case ARG_SYSLOG:
+                case ARG_STDOUT:
+                        r = safe_atou(optarg, &arg_clients[c - ARG_NATIVE]);
+                        if (r < 0)
+                                return log_error_errno(r, "Failed to parse number of clients: %s", optarg);
+                        break;
+
+                case ARG_MIN_SIZE:
+                case ARG_MAX_SIZE: {
+                        uint64_t sz;
+
+                        r = parse_size(optarg, 1024, &sz);
+                        if (r < 0 || sz == 0 || sz > LONG_LINE_MAX)
+                                return log_error_errno(r < 0 ? r : SYNTHETIC_ERRNO(ERANGE), "Failed to parse message size: %s", optarg);
+
+                        if (c == ARG_MIN_SIZE)
+                                arg_min_size = sz;
+                        else
+                                arg_max_size = sz;
+                        break;
+                }
+
+                case ARG_FIELDS:
+                        r = safe_atou(optarg, &arg_fields);
+                        if (r < 0)
+                                return log_error_errno(r, "Failed to parse --fields=: %s", optarg);
+                        break;
+
+                case ARG_CARDINALITY:
+                        r = safe_atou(optarg, &arg_cardinality);
+                        if (r < 0 || arg_cardinality == 0)
+                                return log_error_errno(r < 0 ? r : SYNTHETIC_ERRNO(EINVAL), "Failed to parse --cardinality=: %s", optarg);
+                        break;
+
+                case '?':
+                        return -EINVAL;
+
+                default:
+                        assert_not_reached("Unhandled option");
+                }
+
+        if (arg_min_size > arg_max_size)
+                return log_error_errno(SYNTHETIC_ERRNO(EINVAL), "--min-size= must not be larger than --max-size=.");
+
+        if (arg_clients[CLIENT_NATIVE] + arg_clients[CLIENT_SYSLOG] + arg_clients[CLIENT_STDOUT] == 0)
+                return log_error_errno(SYNTHETIC_ERRNO(EINVAL), "At least one client is required.");
+
+        return 1;
+}
+
+static const char *socket_path(ClientType type, char *buf, size_t size) {
+        static const char *const socket_name[_CLIENT_TYPE_MAX] = {
+                [CLIENT_NATIVE] = "socket",
+                [CLIENT_SYSLOG] = "dev-log",
+                [CLIENT_STDOUT] = "stdout",
+        };
+
+        if (arg_namespace)
+                assert_se(snprintf(buf, size, "/run/systemd/journal.%s/%s", arg_namespace, socket_name[type]) < (int) size);
+        else
+                assert_se(snprintf(buf, size, "/run/systemd/journal/%s", socket_name[type]) < (int) size);
+
+        return buf;
+}
+
+static int connect_client(ClientType type) {
+        union sockaddr_union sa;
+        char path[PATH_MAX];
+        _cleanup_close_ int fd = -1;
+        int r, salen;
+
+        salen = sockaddr_un_set_path(&sa.un, socket_path(type, path, sizeof path));
+        if (salen < 0)
+                return salen;
+
+        fd = socket(AF_UNIX, (type == CLIENT_STDOUT ? SOCK_STREAM : SOCK_DGRAM)|SOCK_CLOEXEC, 0);
+        if (fd < 0)
+                return -errno;
+
+        if (connect(fd, &sa.sa, salen) < 0)
+                return log_error_errno(errno, "Failed to connect to %s: %m", path);
+
+        if (type == CLIENT_STDOUT) {
+                _cleanup_free_ char *header = NULL;
+
+                /* Identifier, unit ID, priority, level prefix, forward to syslog, kmsg, console */
+                header = strjoin(identifier, "\n\n6\n0\n0\n0\n0\n");
+                if (!header)
+                        return -ENOMEM;
+
+                r = loop_write(fd, header, strlen(header), false);
+                if (r < 0)
+                        return r;
+        }
+
+        return TAKE_FD(fd);
+}
+
+static size_t random_size(void) {
+        double l, h;
+
+        /* Log-uniform distribution between the minimum and maximum size, i.e. small messages are much more
+         * common than large ones, like in real life */
+        l = log((double) arg_min_size);
+        h = log((double) arg_max_size);
+
+        return CLAMP((size_t) exp(l + (h - l) * random_u32() / UINT32_MAX), arg_min_size, arg_max_size);
+}
+
+static int run_client(ClientType type, unsigned index, unsigned n_messages) {
+        _cleanup_free_ char *prefix = NULL, *buf = NULL, *fields = NULL;
+        _cleanup_close_ int fd = -1;
+        size_t buf_size;
+        int r;
+
+        fd = connect_client(type);
+        if (fd < 0)
+                return fd;
+
+        /* Stdout streams got the identifier in the stream header already */
+        if (type == CLIENT_NATIVE)
+                prefix = strjoin("SYSLOG_IDENTIFIER=", identifier, "\nPRIORITY=6\nMESSAGE=");
+        else if (type == CLIENT_SYSLOG)
+                prefix = strjoin("<14>", identifier, ": ");
+        else
+                prefix = strdup("");
+        if (!prefix)
+                return log_oom();
+
+        /* Prefix, the benchmark header, padding and newline */
+        buf_size = strlen(prefix) + 64 + arg_max_size + 1;
+        buf = malloc(buf_size);
+        fields = malloc(arg_fields * (STRLEN("BENCH_FIELD_=value-\n") + 2 * DECIMAL_STR_MAX(unsigned)) + 1);
+        if (!buf || !fields)
+                return log_oom();
+
+        for (unsigned i = 0; i < n_messages; i++) {
+                size_t size, n;
+                char *f = fields;
+                int k;
+
+                /* The message carries its sequence number and send timestamp, so that the reader can match
+                 * it up, whichever protocol was used to send it. */
+                k = snprintf(buf, buf_size, "%sbench %s %u %u " USEC_FMT " ",
+                             prefix, client_type_name[type], index, i, now(CLOCK_MONOTONIC));
+                assert_se(k > 0 && (size_t) k + arg_max_size < buf_size);
+
+                size = random_size();
+                for (n = k; n < (size_t) k + size; n++)
+                        buf[n] = 'a' + n % 26;
+                if (type != CLIENT_SYSLOG)
+                        buf[n++] = '\n';
+
+                if (type == CLIENT_NATIVE) {
+                        for (unsigned j = 0; j < arg_fields; j++)
+                                f += sprintf(f, "BENCH_FIELD_%u=value-%u\n", j, (unsigned) random_u64_range(arg_cardinality));
+
+                        r = writev(fd, (struct iovec[]) {
+                                                IOVEC_MAKE(buf, n),
+                                                IOVEC_MAKE(fields, f - fields),
+                                        }, 2);
+                        if (r < 0)
+                                return log_error_errno(errno, "Failed to send native message: %m");
+                } else if (type == CLIENT_SYSLOG) {
+                        if (send(fd, buf, n, 0) < 0)
+                                return log_error_errno(errno, "Failed to send syslog message: %m");
+                } else {
+                        r = loop_write(fd, buf, n, false);
+                        if (r < 0)
+                                return log_error_errno(r, "Failed to write to stdout stream: %m");
+                }
+        }
+
+        return 0;
+}
+
+static int journald_cpu_usage(pid_t pid, usec_t *ret) {
+        _cleanup_free_ char *path = NULL, *line = NULL;
+        unsigned long utime, stime;
+        const char *p;
+        int r;
+
+        /* Fields 14 and 15 of /proc/PID/stat, after the (possibly weird) comm field */
+        if (asprintf(&path, "/proc/" PID_FMT "/stat", pid) < 0)
+                return -ENOMEM;
+
+        r = read_one_line_file(path, &line);
+        if (r < 0)
+                return r;
+
+        p = strrchr(line, ')');
+        if (!p)
+                return -EIO;
+
+        if (sscanf(p + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &utime, &stime) != 2)
+                return -EIO;
+
+        *ret = (utime + stime) * USEC_PER_SEC / sysconf(_SC_CLK_TCK);
+        return 0;
+}
+
+static int journald_pid(pid_t *ret) {
+        _cleanup_close_ int fd = -1;
+        struct ucred ucred;
+        int r;
+
+        /* The peer of a stdout stream connection is journald itself */
+        fd = connect_client(CLIENT_STDOUT);
+        if (fd < 0)
+                return fd;
+
+        r = getpeercred(fd, &ucred);
+        if (r < 0)
+                return r;
+
+        *ret = ucred.pid;
+        return 0;
+}
+
+static int compare_usec(const usec_t *a, const usec_t *b) {
+        return CMP(*a, *b);
+}
+
+static usec_t percentile(const usec_t *l, size_t n, unsigned p) {
+        assert(n > 0);
+
+        return l[MIN(n * p / 100, n - 1)];
+}
+
+static int run(int argc, char *argv[]) {
+        _cleanup_(sd_journal_closep) sd_journal *j = NULL;
+        _cleanup_free_ usec_t *latencies = NULL;
+        _cleanup_free_ pid_t *pids = NULL;
+        char a[FORMAT_TIMESPAN_MAX], b[FORMAT_TIMESPAN_MAX], c[FORMAT_TIMESPAN_MAX], d[FORMAT_TIMESPAN_MAX],
+                s[FORMAT_BYTES_MAX];
+        uint64_t usage_before = 0, usage_after = 0, growth;
+        usec_t start, last = 0, cpu_before = 0, cpu_after = 0;
+        unsigned n_clients, n_pids = 0, n_seen = 0, n_sent = 0;
+        const char *match;
+        pid_t journald;
+        sd_id128_t id;
+        int r;
+
+        log_setup();
+
+        r = parse_argv(argc, argv);
+        if (r <= 0)
+                return r;
+
+        assert_se(sd_id128_randomize(&id) >= 0);
+        xsprintf(identifier, "bench-%s", sd_id128_to_string(id, (char[SD_ID128_STRING_MAX]) {}));
+
+        r = journald_pid(&journald);
+        if (r < 0)
+                return log_error_errno(r, "Failed to determine journald PID: %m");
+
+        r = sd_journal_open_namespace(&j, arg_namespace, SD_JOURNAL_LOCAL_ONLY);
+        if (r < 0)
+                return log_error_errno(r, "Failed to open journal: %m");
+
+        match = strjoina("SYSLOG_IDENTIFIER=", identifier);
+        r = sd_journal_add_match(j, match, 0);
+        if (r < 0)
+                return log_error_errno(r, "Failed to add match: %m");
+
+        r = sd_journal_seek_tail(j);
+        if (r < 0)
+                return log_error_errno(r, "Failed to seek to the end of the journal: %m");
+
+        /* Set up inotify watches before anything is sent */
+        (void) sd_journal_get_fd(j);
+        (void) sd_journal_get_usage(j, &usage_before);
+        (void) journald_cpu_usage(journald, &cpu_before);
+
+        n_clients = arg_clients[CLIENT_NATIVE] + arg_clients[CLIENT_SYSLOG] + arg_clients[CLIENT_STDOUT];
+        latencies = new(usec_t, arg_messages);
+        pids = new(pid_t, n_clients);
+        if (!latencies || !pids)
+                return log_oom();
+
+        log_info("Sending %u messages of %zu…%zu bytes from %u native, %u syslog and %u stdout clients as %s.",
+                 arg_messages, arg_min_size, arg_max_size,
+                 arg_clients[CLIENT_NATIVE], arg_clients[CLIENT_SYSLOG], arg_clients[CLIENT_STDOUT], identifier);
+
+        start = now(CLOCK_MONOTONIC);
+
+        for (ClientType t = 0; t < _CLIENT_TYPE_MAX; t++)
+                for (unsigned i = 0; i < arg_clients[t]; i++) {
+                        unsigned n;
+
+                        /* Distribute messages evenly, the first clients get the remainder */
+                        n = arg_messages / n_clients + (n_pids < arg_messages % n_clients);
+
+                        r = safe_fork("(bench-client)", FORK_DEATHSIG|FORK_LOG, &pids[n_pids]);
+                        if (r < 0)
+                                return r;
+                        if (r == 0)
+                                _exit(run_client(t, i, n) < 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+
+                        n_pids++;
+                        n_sent += n;
+                }
+
+        while (n_seen < n_sent) {
+                _cleanup_free_ char *m = NULL;
+                const void *data;
+                size_t length;
+                usec_t sent;
+
+                r = sd_journal_next(j);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to iterate through journal: %m");
+                if (r == 0) {
+                        r = sd_journal_wait(j, arg_idle_timeout);
+                        if (r < 0)
+                                return log_error_errno(r, "Failed to wait for journal changes: %m");
+                        if (r == SD_JOURNAL_NOP) {
+                                log_warning("No new messages within %s, giving up. Is rate limiting disabled?",
+                                            format_timespan(a, sizeof a, arg_idle_timeout, 0));
+                                break;
+                        }
+                        continue;
+                }
+
+                r = sd_journal_get_data(j, "MESSAGE", &data, &length);
+                if (r < 0)
+                        continue;
+
+                m = strndup(data, length);
+                if (!m)
+                        return log_oom();
+
+                if (sscanf(m, "MESSAGE=bench %*s %*u %*u " USEC_FMT, &sent) != 1)
+                        continue;
+
+                last = now(CLOCK_MONOTONIC);
+                latencies[n_seen++] = usec_sub_unsigned(last, sent);
+        }
+
+        for (unsigned i = 0; i < n_pids; i++)
+                (void) wait_for_terminate_and_check("(bench-client)", pids[i], WAIT_LOG);
+
+        (void) sd_journal_process(j);
+        (void) sd_journal_get_usage(j, &usage_after);
+        (void) journald_cpu_usage(journald, &cpu_after);
+
+        if (n_seen == 0)
+                return log_error_errno(SYNTHETIC_ERRNO(ENODATA), "No messages received.");
+
+        typesafe_qsort(latencies, n_seen, compare_usec);
+        growth = usage_after > usage_before ? usage_after - usage_before : 0;
+
+        printf("Messages:       %u sent, %u seen\n", n_sent, n_seen);
+        printf("Throughput:     %.0f msg/s over %s\n",
+               (double) n_seen * USEC_PER_SEC / MAX(last - start, (usec_t) 1),
+               format_timespan(a, sizeof a, last - start, USEC_PER_MSEC));
+        printf("Latency:        p50 %s, p90 %s, p99 %s, max %s\n",
+               format_timespan(a, sizeof a, percentile(latencies, n_seen, 50), 1),
+               format_timespan(b, sizeof b, percentile(latencies, n_seen, 90), 1),
+               format_timespan(c, sizeof c, percentile(latencies, n_seen, 99), 1),
+               format_timespan(d, sizeof d, latencies[n_seen - 1], 1));
+        printf("journald CPU:   %s total, %.1f µs/msg\n",
+               format_timespan(a, sizeof a, usec_sub_unsigned(cpu_after, cpu_before), USEC_PER_MSEC),
+               (double) usec_sub_unsigned(cpu_after, cpu_before) / n_seen);
+        printf("File growth:    %s, %.0f bytes/msg\n",
+               strna(format_bytes(s, sizeof s, growth)),
+               (double) growth / n_seen);
+
+        return 0;
+}
+
+DEFINE_MAIN_FUNCTION(run);
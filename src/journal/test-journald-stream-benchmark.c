@@ -0,0 +1,120 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <linux/sockios.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "alloc-util.h"
+#include "fd-util.h"
+#include "journald-server.h"
+#include "journald-stream.h"
+#include "parse-util.h"
+#include "tests.h"
+#include "time-util.h"
+
+static unsigned arg_lines = 200000;
+
+static void dummy_server_init(Server *s) {
+        *s = (Server) {
+                .syslog_fd = -1,
+                .native_fd = -1,
+                .stdout_fd = -1,
+                .dev_kmsg_fd = -1,
+                .audit_fd = -1,
+                .hostname_fd = -1,
+                .notify_fd = -1,
+                .storage = STORAGE_NONE,
+                .line_max = 48*1024,
+        };
+        assert_se(sd_event_default(&s->event) >= 0);
+}
+
+static void drain(Server *s, int fd) {
+        int v;
+
+        while (ioctl(fd, SIOCINQ, &v) == 0 && v > 0)
+                assert_se(sd_event_run(s->event, UINT64_MAX) >= 0);
+}
+
+static void test_lines(size_t line_size) {
+        /* Identifier, unit ID, priority, level prefix, forward to syslog, kmsg, console */
+        static const char header[] = "benchmark\n\n6\n0\n0\n0\n0\n";
+        char ts[FORMAT_TIMESPAN_MAX];
+        _cleanup_free_ char *buf = NULL;
+        StdoutStream *stream;
+        size_t n_per_buf, size;
+        unsigned n_written = 0;
+        int fds[2] = { -1, -1 };
+        usec_t t;
+        Server s;
+
+        assert_se(line_size > 1);
+
+        /* Fill a buffer with as many complete lines as fit into 64K */
+        n_per_buf = MAX(64*1024 / line_size, 1u);
+        size = n_per_buf * line_size;
+        buf = malloc(size);
+        assert_se(buf);
+
+        for (size_t i = 0; i < size; i++)
+                buf[i] = i % line_size == line_size - 1 ? '\n' : 'a' + i % 26;
+
+        assert_se(socketpair(AF_UNIX, SOCK_STREAM|SOCK_CLOEXEC|SOCK_NONBLOCK, 0, fds) >= 0);
+        dummy_server_init(&s);
+        assert_se(stdout_stream_install(&s, fds[0], &stream) >= 0);
+
+        assert_se(write(fds[1], header, sizeof(header) - 1) == sizeof(header) - 1);
+        drain(&s, fds[0]);
+
+        t = now(CLOCK_MONOTONIC);
+
+        while (n_written < arg_lines) {
+                size_t left = size;
+                const char *p = buf;
+
+                while (left > 0) {
+                        ssize_t k;
+
+                        k = write(fds[1], p, left);
+                        if (k < 0) {
+                                assert_se(errno == EAGAIN);
+                                assert_se(sd_event_run(s.event, UINT64_MAX) >= 0);
+                                continue;
+                        }
+
+                        p += k;
+                        left -= k;
+                }
+
+                n_written += n_per_buf;
+        }
+
+        drain(&s, fds[0]);
+
+        t = now(CLOCK_MONOTONIC) - t;
+
+        log_info("%4zu byte lines: %u lines in %s, %.0f lines/s",
+                 line_size, n_written,
+                 format_timespan(ts, sizeof(ts), t, USEC_PER_MSEC),
+                 (double) n_written * USEC_PER_SEC / MAX(t, (usec_t) 1));
+
+        if (s.n_stdout_streams > 0)
+                stdout_stream_destroy(stream);
+        server_done(&s);
+        safe_close(fds[1]);
+}
+
+int main(int argc, char *argv[]) {
+        test_setup_logging(LOG_INFO);
+
+        if (argc >= 2)
+                assert_se(safe_atou(argv[1], &arg_lines) >= 0);
+
+        test_lines(16);
+        test_lines(80);
+        test_lines(512);
+        test_lines(4096);
+
+        return 0;
+}
@@ -66,6 +66,7 @@ struct sd_dhcp_server {
 
         Hashmap *leases_by_client_id;
         DHCPLease **bound_leases;
+        uint32_t n_bound_leases; /* number of non-NULL entries in bound_leases */
         DHCPLease invalid_lease;
 
         uint32_t max_lease_time, default_lease_time;
@@ -23,6 +23,7 @@
 
 #define DHCP_DEFAULT_LEASE_TIME_USEC USEC_PER_HOUR
 #define DHCP_MAX_LEASE_TIME_USEC (USEC_PER_HOUR*12)
+#define DHCP_SERVER_RECEIVE_BATCH_MAX 16U
 
 static DHCPLease *dhcp_lease_free(DHCPLease *lease) {
         if (!lease)
@@ -90,13 +91,16 @@ int sd_dhcp_server_configure_pool(
 
                 server->pool_offset = offset;
                 server->pool_size = size;
+                server->n_bound_leases = 0;
 
                 server->address = address->s_addr;
                 server->netmask = netmask;
                 server->subnet = address->s_addr & netmask;
 
-                if (server_off >= offset && server_off - offset < size)
+                if (server_off >= offset && server_off - offset < size) {
                         server->bound_leases[server_off - offset] = &server->invalid_lease;
+                        server->n_bound_leases++;
+                }
 
                 /* Drop any leases associated with the old address range */
                 hashmap_clear(server->leases_by_client_id);
@@ -744,6 +748,9 @@ int dhcp_server_handle_message(sd_dhcp_server *server, DHCPMessage *message,
                 /* for now pick a random free address from the pool */
                 if (existing_lease)
                         address = existing_lease->address;
+                else if (server->n_bound_leases >= server->pool_size)
+                        /* no free addresses left, don't bother scanning the pool */
+                        return 0;
                 else {
                         struct siphash state;
                         uint64_t hash;
@@ -888,6 +895,8 @@ int dhcp_server_handle_message(sd_dhcp_server *server, DHCPMessage *message,
                                 log_dhcp_server(server, "ACK (0x%x)",
                                                 be32toh(req->message->xid));
 
+                                if (!server->bound_leases[pool_offset])
+                                        server->n_bound_leases++;
                                 server->bound_leases[pool_offset] = lease;
                                 hashmap_put(server->leases_by_client_id,
                                             &lease->client_id, lease);
@@ -929,6 +938,8 @@ int dhcp_server_handle_message(sd_dhcp_server *server, DHCPMessage *message,
 
                 if (server->bound_leases[pool_offset] == existing_lease) {
                         server->bound_leases[pool_offset] = NULL;
+                        assert(server->n_bound_leases > 0);
+                        server->n_bound_leases--;
                         hashmap_remove(server->leases_by_client_id, existing_lease);
                         dhcp_lease_free(existing_lease);
 
@@ -942,11 +953,9 @@ int dhcp_server_handle_message(sd_dhcp_server *server, DHCPMessage *message,
         return 0;
 }
 
-static int server_receive_message(sd_event_source *s, int fd,
-                                  uint32_t revents, void *userdata) {
+static int server_receive_one(sd_dhcp_server *server, int fd) {
         _cleanup_free_ DHCPMessage *message = NULL;
         CMSG_BUFFER_TYPE(CMSG_SPACE(sizeof(struct in_pktinfo))) control;
-        sd_dhcp_server *server = userdata;
         struct iovec iov = {};
         struct msghdr msg = {
                 .msg_iov = &iov,
@@ -961,6 +970,8 @@ static int server_receive_message(sd_event_source *s, int fd,
         assert(server);
 
         buflen = next_datagram_size_fd(fd);
+        if (IN_SET(buflen, -EAGAIN, -EINTR))
+                return 0;
         if (buflen < 0)
                 return buflen;
 
@@ -976,7 +987,7 @@ static int server_receive_message(sd_event_source *s, int fd,
         if (len < 0)
                 return len;
         if ((size_t) len < sizeof(DHCPMessage))
-                return 0;
+                return 1;
 
         CMSG_FOREACH(cmsg, &msg) {
                 if (cmsg->cmsg_level == IPPROTO_IP &&
@@ -987,7 +998,7 @@ static int server_receive_message(sd_event_source *s, int fd,
                         /* TODO figure out if this can be done as a filter on
                          * the socket, like for IPv6 */
                         if (server->ifindex != info->ipi_ifindex)
-                                return 0;
+                                return 1;
 
                         break;
                 }
@@ -997,6 +1008,25 @@ static int server_receive_message(sd_event_source *s, int fd,
         if (r < 0)
                 log_dhcp_server_errno(server, r, "Couldn't process incoming message: %m");
 
+        return 1;
+}
+
+static int server_receive_message(sd_event_source *s, int fd,
+                                  uint32_t revents, void *userdata) {
+        sd_dhcp_server *server = userdata;
+        int r;
+
+        assert(server);
+
+        /* After a host reboot many clients show up at once. Handle a couple of queued messages per
+         * wakeup rather than going through the event loop for each of them, but not too many, to not
+         * starve other event sources. */
+        for (unsigned i = 0; i < DHCP_SERVER_RECEIVE_BATCH_MAX; i++) {
+                r = server_receive_one(server, fd);
+                if (r <= 0)
+                        return r;
+        }
+
         return 0;
 }
 
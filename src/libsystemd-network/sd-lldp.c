@@ -400,7 +400,7 @@ _public_ int sd_lldp_new(sd_lldp **ret) {
         if (!lldp->neighbor_by_id)
                 return -ENOMEM;
 
-        r = prioq_ensure_allocated(&lldp->neighbor_by_expiry, lldp_neighbor_prioq_compare_func);
+        r = prioq_ensure_allocated_keyed(&lldp->neighbor_by_expiry, lldp_neighbor_prioq_key_func, NULL);
         if (r < 0)
                 return r;
 
@@ -14,6 +14,9 @@
 #include "bus-internal.h"
 #include "bus-message.h"
 #include "capability-util.h"
+#include "fd-util.h"
+#include "io-util.h"
+#include "missing_syscall.h"
 #include "process-util.h"
 #include "stdio-util.h"
 #include "string-util.h"
@@ -722,8 +725,97 @@ _public_ int sd_bus_get_name_creds(
         return 0;
 }
 
+int bus_peer_creds_cache_set_enabled(sd_bus *bus, bool b) {
+        assert_return(bus, -EINVAL);
+        assert_return(bus = bus_resolve(bus), -ENOPKG);
+        assert_return(!bus_pid_changed(bus), -ECHILD);
+
+        bus->peer_creds_cache_enabled = b;
+        if (!b)
+                bus_peer_creds_cache_flush(bus);
+
+        return 0;
+}
+
+void bus_peer_creds_cache_flush(sd_bus *bus) {
+        assert(bus);
+
+        bus->peer_creds = sd_bus_creds_unref(bus->peer_creds);
+        bus->peer_pidfd = safe_close(bus->peer_pidfd);
+}
+
+int bus_peer_creds_cache_get(sd_bus *bus, pid_t pid, uint64_t mask, sd_bus_creds **ret) {
+        int r;
+
+        assert(bus);
+        assert(ret);
+
+        /* Credentials augmented from /proc are read over and over again for the same peer if it issues many
+         * calls, e.g. for SELinux access checks. If enabled, we hence keep what we read about the peer of a
+         * direct connection (i.e. the process identified by SO_PEERCRED) around, and return it here, with
+         * whatever else was asked for read in addition. A pidfd tells us when the peer exits, at which point
+         * we forget everything, so that a different process that reuses the PID never gets to see this.
+         *
+         * Returns 1 and a borrowed reference if the cache applies, 0 and NULL otherwise. */
+
+        if (!bus->peer_creds_cache_enabled ||
+            !bus->ucred_valid ||
+            !pid_is_valid(pid) ||
+            pid != bus->ucred.pid ||
+            !(mask & SD_BUS_CREDS_AUGMENT))
+                goto not_applicable;
+
+        if (bus->peer_creds) {
+                r = fd_wait_for_event(bus->peer_pidfd, POLLIN, 0);
+                if (r != 0) /* The peer exited, or we can't tell */
+                        bus_peer_creds_cache_flush(bus);
+        }
+
+        if (!bus->peer_creds) {
+                _cleanup_(sd_bus_creds_unrefp) sd_bus_creds *c = NULL;
+                _cleanup_close_ int fd = -1;
+
+                fd = pidfd_open(pid, 0);
+                if (fd < 0) {
+                        /* Without pidfds we can't tell reliably when the peer exits, hence don't cache */
+                        if (!ERRNO_IS_NOT_SUPPORTED(errno) && !ERRNO_IS_PRIVILEGE(errno) && errno != ESRCH)
+                                return -errno;
+
+                        goto not_applicable;
+                }
+
+                c = bus_creds_new();
+                if (!c)
+                        return -ENOMEM;
+
+                c->pid = pid;
+                c->mask = SD_BUS_CREDS_PID;
+
+                bus->peer_creds = TAKE_PTR(c);
+                bus->peer_pidfd = TAKE_FD(fd);
+        }
+
+        r = bus_creds_add_more(bus->peer_creds, mask & ~(SD_BUS_CREDS_TID|SD_BUS_CREDS_TID_COMM), pid, 0);
+        if (r < 0) {
+                bus_peer_creds_cache_flush(bus);
+
+                if (r == -ESRCH)
+                        goto not_applicable;
+
+                return r;
+        }
+
+        *ret = bus->peer_creds;
+        return 1;
+
+not_applicable:
+        *ret = NULL;
+        return 0;
+}
+
 _public_ int sd_bus_get_owner_creds(sd_bus *bus, uint64_t mask, sd_bus_creds **ret) {
         _cleanup_(sd_bus_creds_unrefp) sd_bus_creds *c = NULL;
+        sd_bus_creds *cache;
         bool do_label, do_groups;
         pid_t pid = 0;
         int r;
@@ -737,7 +829,9 @@ _public_ int sd_bus_get_owner_creds(sd_bus *bus, uint64_t mask, sd_bus_creds **r
         if (!BUS_IS_OPEN(bus->state))
                 return -ENOTCONN;
 
-        if (!bus->is_local)
+        /* Augmenting from /proc only makes sense if the peer runs on our host. Whoever enabled the peer
+         * credentials cache on a connection set up from an fd told us that's the case. */
+        if (!bus->is_local && !bus->peer_creds_cache_enabled)
                 mask &= ~SD_BUS_CREDS_AUGMENT;
 
         do_label = bus->label && (mask & SD_BUS_CREDS_SELINUX_CONTEXT);
@@ -786,6 +880,14 @@ _public_ int sd_bus_get_owner_creds(sd_bus *bus, uint64_t mask, sd_bus_creds **r
                 c->mask |= SD_BUS_CREDS_SUPPLEMENTARY_GIDS;
         }
 
+        r = bus_peer_creds_cache_get(bus, pid, mask, &cache);
+        if (r < 0)
+                return r;
+
+        r = bus_creds_augment_from(c, mask, cache);
+        if (r < 0)
+                return r;
+
         r = bus_creds_add_more(c, mask, pid, 0);
         if (r < 0 && r != -ESRCH) /* If the process vanished, then don't complain, just return what we got */
                 return r;
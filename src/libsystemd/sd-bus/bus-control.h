@@ -1,9 +1,15 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 #pragma once
 
+#include <stdbool.h>
+
 #include "sd-bus.h"
 
 int bus_add_match_internal(sd_bus *bus, const char *match, uint64_t *ret_counter);
 int bus_add_match_internal_async(sd_bus *bus, sd_bus_slot **ret, const char *match, sd_bus_message_handler_t callback, void *userdata);
 
 int bus_remove_match_internal(sd_bus *bus, const char *match);
+
+int bus_peer_creds_cache_set_enabled(sd_bus *bus, bool b);
+void bus_peer_creds_cache_flush(sd_bus *bus);
+int bus_peer_creds_cache_get(sd_bus *bus, pid_t pid, uint64_t mask, sd_bus_creds **ret);
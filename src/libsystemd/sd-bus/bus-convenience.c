@@ -3,6 +3,7 @@
 #include <unistd.h>
 #include <sys/types.h>
 
+#include "bus-control.h"
 #include "bus-internal.h"
 #include "bus-message.h"
 #include "bus-signature.h"
@@ -611,7 +612,7 @@ _public_ int sd_bus_set_property(
 }
 
 _public_ int sd_bus_query_sender_creds(sd_bus_message *call, uint64_t mask, sd_bus_creds **ret) {
-        sd_bus_creds *c;
+        sd_bus_creds *c, *cache;
         int r;
 
         assert_return(call, -EINVAL);
@@ -646,7 +647,11 @@ _public_ int sd_bus_query_sender_creds(sd_bus_message *call, uint64_t mask, sd_b
                         return sd_bus_get_owner_creds(call->bus, mask, ret);
         }
 
-        r = bus_creds_extend_by_pid(c, mask, ret);
+        r = bus_peer_creds_cache_get(call->bus, c->pid, mask, &cache);
+        if (r < 0)
+                return r;
+
+        r = bus_creds_extend_by_pid(c, mask, cache, ret);
         if (r == -ESRCH) {
                 /* Process doesn't exist anymore? propagate the few things we have */
                 *ret = sd_bus_creds_ref(c);
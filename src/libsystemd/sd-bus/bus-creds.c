@@ -1102,31 +1102,18 @@ int bus_creds_add_more(sd_bus_creds *c, uint64_t mask, pid_t pid, pid_t tid) {
         if (tid > 0 && tid != pid && !pid_is_unwaited(tid))
                 return -ESRCH;
 
-        c->augmented = missing & c->mask;
+        c->augmented |= missing & c->mask;
 
         return 0;
 }
 
-int bus_creds_extend_by_pid(sd_bus_creds *c, uint64_t mask, sd_bus_creds **ret) {
-        _cleanup_(sd_bus_creds_unrefp) sd_bus_creds *n = NULL;
-        int r;
-
+static int bus_creds_copy_fields(sd_bus_creds *n, sd_bus_creds *c, uint64_t mask) {
+        assert(n);
         assert(c);
-        assert(ret);
-
-        if ((mask & ~c->mask) == 0 || (!(mask & SD_BUS_CREDS_AUGMENT))) {
-                /* There's already all data we need, or augmentation
-                 * wasn't turned on. */
 
-                *ret = sd_bus_creds_ref(c);
-                return 0;
-        }
-
-        n = bus_creds_new();
-        if (!n)
-                return -ENOMEM;
+        /* Copies over the fields included in 'mask' that 'c' has. Fields 'n' has already are not copied. */
 
-        /* Copy the original data over */
+        mask &= ~n->mask;
 
         if (c->mask & mask & SD_BUS_CREDS_PID) {
                 n->pid = c->pid;
@@ -1325,8 +1312,71 @@ int bus_creds_extend_by_pid(sd_bus_creds *c, uint64_t mask, sd_bus_creds **ret)
                 n->mask |= SD_BUS_CREDS_DESCRIPTION;
         }
 
+        return 0;
+}
+
+int bus_creds_augment_from(sd_bus_creds *c, uint64_t mask, sd_bus_creds *from) {
+        uint64_t missing;
+        int r;
+
+        assert(c);
+
+        /* Fills in what is missing in 'c' from 'from', a set of credentials previously read from /proc for
+         * the same process. Everything taken over is hence marked as augmented. */
+
+        if (!from || !(mask & SD_BUS_CREDS_AUGMENT))
+                return 0;
+
+        missing = mask & from->mask & ~c->mask;
+
+        /* These fields share their storage, hence take them over either all at once or not at all */
+        if (c->mask & (SD_BUS_CREDS_CGROUP|SD_BUS_CREDS_SESSION|SD_BUS_CREDS_UNIT|SD_BUS_CREDS_USER_UNIT|SD_BUS_CREDS_SLICE|SD_BUS_CREDS_USER_SLICE|SD_BUS_CREDS_OWNER_UID))
+                missing &= ~(SD_BUS_CREDS_CGROUP|SD_BUS_CREDS_SESSION|SD_BUS_CREDS_UNIT|SD_BUS_CREDS_USER_UNIT|SD_BUS_CREDS_SLICE|SD_BUS_CREDS_USER_SLICE|SD_BUS_CREDS_OWNER_UID);
+        if (c->mask & (SD_BUS_CREDS_EFFECTIVE_CAPS|SD_BUS_CREDS_PERMITTED_CAPS|SD_BUS_CREDS_INHERITABLE_CAPS|SD_BUS_CREDS_BOUNDING_CAPS))
+                missing &= ~(SD_BUS_CREDS_EFFECTIVE_CAPS|SD_BUS_CREDS_PERMITTED_CAPS|SD_BUS_CREDS_INHERITABLE_CAPS|SD_BUS_CREDS_BOUNDING_CAPS);
+
+        /* Per-thread data is not something we take from elsewhere */
+        missing &= ~(SD_BUS_CREDS_TID|SD_BUS_CREDS_TID_COMM);
+
+        r = bus_creds_copy_fields(c, from, missing);
+        if (r < 0)
+                return r;
+
+        c->augmented |= missing & c->mask;
+        return 0;
+}
+
+int bus_creds_extend_by_pid(sd_bus_creds *c, uint64_t mask, sd_bus_creds *cache, sd_bus_creds **ret) {
+        _cleanup_(sd_bus_creds_unrefp) sd_bus_creds *n = NULL;
+        int r;
+
+        assert(c);
+        assert(ret);
+
+        if ((mask & ~c->mask) == 0 || (!(mask & SD_BUS_CREDS_AUGMENT))) {
+                /* There's already all data we need, or augmentation
+                 * wasn't turned on. */
+
+                *ret = sd_bus_creds_ref(c);
+                return 0;
+        }
+
+        n = bus_creds_new();
+        if (!n)
+                return -ENOMEM;
+
+        /* Copy the original data over */
+        r = bus_creds_copy_fields(n, c, mask);
+        if (r < 0)
+                return r;
+
         n->augmented = c->augmented & n->mask;
 
+        /* Take what we can from what was read about the same process before */
+        r = bus_creds_augment_from(n, mask, cache);
+        if (r < 0)
+                return r;
+
         /* Get more data */
 
         r = bus_creds_add_more(n, mask, 0, 0);
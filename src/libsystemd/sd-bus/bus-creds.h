@@ -69,4 +69,5 @@ void bus_creds_done(sd_bus_creds *c);
 
 int bus_creds_add_more(sd_bus_creds *c, uint64_t mask, pid_t pid, pid_t tid);
 
-int bus_creds_extend_by_pid(sd_bus_creds *c, uint64_t mask, sd_bus_creds **ret);
+int bus_creds_augment_from(sd_bus_creds *c, uint64_t mask, sd_bus_creds *from);
+int bus_creds_extend_by_pid(sd_bus_creds *c, uint64_t mask, sd_bus_creds *cache, sd_bus_creds **ret);
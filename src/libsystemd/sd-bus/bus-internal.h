@@ -214,6 +214,8 @@ struct sd_bus {
         bool attach_timestamp:1;
         bool connected_signal:1;
         bool close_on_exit:1;
+        bool property_cache_enabled:1;
+        bool peer_creds_cache_enabled:1;
 
         signed int use_memfd:2;
 
@@ -243,6 +245,7 @@ struct sd_bus {
         Hashmap *nodes;
         Hashmap *vtable_methods;
         Hashmap *vtable_properties;
+        Hashmap *property_cache;
 
         union sockaddr_union sockaddr;
         socklen_t sockaddr_size;
@@ -269,6 +272,10 @@ struct sd_bus {
         gid_t *groups;
         size_t n_groups;
 
+        /* What we read from /proc about the peer of a direct connection, until it exits */
+        sd_bus_creds *peer_creds;
+        int peer_pidfd;
+
         uint64_t creds_mask;
 
         int *fds;
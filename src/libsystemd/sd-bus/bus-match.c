@@ -52,11 +52,22 @@ static bool BUS_MATCH_IS_COMPARE(enum bus_match_node_type t) {
 }
 
 static bool BUS_MATCH_CAN_HASH(enum bus_match_node_type t) {
-        return (t >= BUS_MATCH_MESSAGE_TYPE && t <= BUS_MATCH_PATH) ||
+        return (t >= BUS_MATCH_MESSAGE_TYPE && t <= BUS_MATCH_PATH_NAMESPACE) ||
                 (t >= BUS_MATCH_ARG && t <= BUS_MATCH_ARG_LAST) ||
+                (t >= BUS_MATCH_ARG_NAMESPACE && t <= BUS_MATCH_ARG_NAMESPACE_LAST) ||
                 (t >= BUS_MATCH_ARG_HAS && t <= BUS_MATCH_ARG_HAS_LAST);
 }
 
+/* For the namespace matches, returns the separator of the labels. The values of these are hashed too, but then
+ * looked up by each prefix of the tested string that they could match. */
+static char BUS_MATCH_NAMESPACE_SEPARATOR(enum bus_match_node_type t) {
+        if (t == BUS_MATCH_PATH_NAMESPACE)
+                return '/';
+        if (t >= BUS_MATCH_ARG_NAMESPACE && t <= BUS_MATCH_ARG_NAMESPACE_LAST)
+                return '.';
+        return 0;
+}
+
 static void bus_match_node_free(struct bus_match_node *node) {
         assert(node);
         assert(node->parent);
@@ -183,15 +194,6 @@ static bool value_node_test(
                 return false;
         }
 
-        case BUS_MATCH_ARG_NAMESPACE ... BUS_MATCH_ARG_NAMESPACE_LAST:
-                if (value_str)
-                        return namespace_simple_pattern(node->value.str, value_str);
-
-                return false;
-
-        case BUS_MATCH_PATH_NAMESPACE:
-                return path_simple_pattern(node->value.str, value_str);
-
         case BUS_MATCH_ARG_PATH ... BUS_MATCH_ARG_PATH_LAST:
                 if (value_str)
                         return path_complex_pattern(node->value.str, value_str);
@@ -238,6 +240,57 @@ static bool value_node_same(
         }
 }
 
+static int bus_match_run_namespace(
+                sd_bus *bus,
+                struct bus_match_node *node,
+                char separator,
+                const char *value,
+                sd_bus_message *m) {
+
+        _cleanup_free_ char *prefix = NULL;
+        size_t l;
+        int r;
+
+        assert(node);
+        assert(separator != 0);
+        assert(value);
+
+        if (hashmap_isempty(node->compare.children))
+                return 0;
+
+        /* A namespace matches if it equals the value, or is a prefix of it that ends right before or right
+         * after a separator, see simple_pattern_check(). Instead of testing every namespace against the value,
+         * look up each of these prefixes, which is independent of the number of matches. */
+
+        l = strlen(value);
+        prefix = strdup(value);
+        if (!prefix)
+                return -ENOMEM;
+
+        for (size_t i = 0; i <= l; i++) {
+                struct bus_match_node *found;
+
+                if (i < l && value[i] != separator && (i == 0 || value[i-1] != separator))
+                        continue;
+
+                prefix[i] = 0;
+                found = hashmap_get(node->compare.children, prefix);
+                prefix[i] = value[i];
+
+                if (!found)
+                        continue;
+
+                r = bus_match_run(bus, found, m);
+                if (r != 0)
+                        return r;
+
+                if (bus && bus->match_callbacks_modified)
+                        return 0;
+        }
+
+        return 0;
+}
+
 int bus_match_run(
                 sd_bus *bus,
                 struct bus_match_node *node,
@@ -383,7 +436,15 @@ int bus_match_run(
 
                 /* Lookup via hash table, nice! So let's jump directly. */
 
-                if (test_str)
+                if (BUS_MATCH_NAMESPACE_SEPARATOR(node->type) != 0) {
+                        if (test_str) {
+                                r = bus_match_run_namespace(bus, node, BUS_MATCH_NAMESPACE_SEPARATOR(node->type), test_str, m);
+                                if (r != 0)
+                                        return r;
+                        }
+
+                        found = NULL;
+                } else if (test_str)
                         found = hashmap_get(node->compare.children, test_str);
                 else if (test_strv) {
                         char **i;
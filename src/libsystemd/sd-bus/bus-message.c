@@ -3114,10 +3114,29 @@ static bool message_end_of_array(sd_bus_message *m, size_t index) {
         }
 }
 
+static int message_verify_signature(sd_bus_message *m) {
+        assert(m);
+
+        if (!m->signature_unverified)
+                return 0;
+
+        if (!signature_is_valid(strempty(m->root_container.signature), true))
+                return -EBADMSG;
+
+        m->signature_unverified = false;
+        return 0;
+}
+
 _public_ int sd_bus_message_at_end(sd_bus_message *m, int complete) {
+        int r;
+
         assert_return(m, -EINVAL);
         assert_return(m->sealed, -EPERM);
 
+        r = message_verify_signature(m);
+        if (r < 0)
+                return r;
+
         if (complete && m->n_containers > 0)
                 return false;
 
@@ -3362,6 +3381,10 @@ _public_ int sd_bus_message_read_basic(sd_bus_message *m, char type, void *p) {
         assert_return(m->sealed, -EPERM);
         assert_return(bus_type_is_basic(type), -EINVAL);
 
+        r = message_verify_signature(m);
+        if (r < 0)
+                return r;
+
         if (message_end_of_signature(m))
                 return -ENXIO;
 
@@ -4073,6 +4096,10 @@ _public_ int sd_bus_message_enter_container(sd_bus_message *m,
         assert_return(m->sealed, -EPERM);
         assert_return(type != 0 || !contents, -EINVAL);
 
+        r = message_verify_signature(m);
+        if (r < 0)
+                return r;
+
         if (type == 0 || !contents) {
                 const char *cc;
                 char tt;
@@ -4235,6 +4262,10 @@ _public_ int sd_bus_message_peek_type(sd_bus_message *m, char *type, const char
         assert_return(m, -EINVAL);
         assert_return(m->sealed, -EPERM);
 
+        r = message_verify_signature(m);
+        if (r < 0)
+                return r;
+
         if (message_end_of_signature(m))
                 goto eof;
 
@@ -4418,6 +4449,10 @@ _public_ int sd_bus_message_readv(
         assert_return(m->sealed, -EPERM);
         assert_return(types, -EINVAL);
 
+        r = message_verify_signature(m);
+        if (r < 0)
+                return r;
+
         if (isempty(types))
                 return 0;
 
@@ -4620,6 +4655,10 @@ _public_ int sd_bus_message_skip(sd_bus_message *m, const char *types) {
         assert_return(m, -EINVAL);
         assert_return(m->sealed, -EPERM);
 
+        r = message_verify_signature(m);
+        if (r < 0)
+                return r;
+
         /* If types is NULL, read exactly one element */
         if (!types) {
                 struct bus_container *c;
@@ -4793,6 +4832,10 @@ _public_ int sd_bus_message_read_array(
         assert_return(size, -EINVAL);
         assert_return(!BUS_MESSAGE_NEED_BSWAP(m), -EOPNOTSUPP);
 
+        r = message_verify_signature(m);
+        if (r < 0)
+                return r;
+
         r = sd_bus_message_enter_container(m, SD_BUS_TYPE_ARRAY, CHAR_TO_STR(type));
         if (r < 0)
                 return r;
@@ -4965,10 +5008,11 @@ static int message_peek_field_string(
         return 0;
 }
 
-static int message_peek_field_signature(
+static int message_peek_field_signature_full(
                 sd_bus_message *m,
                 size_t *ri,
                 size_t item_size,
+                bool verify,
                 const char **ret) {
 
         size_t l;
@@ -5003,7 +5047,7 @@ static int message_peek_field_signature(
                         return r;
         }
 
-        if (!validate_signature(q, l))
+        if (verify ? !validate_signature(q, l) : !validate_nul(q, l))
                 return -EBADMSG;
 
         if (ret)
@@ -5012,6 +5056,15 @@ static int message_peek_field_signature(
         return 0;
 }
 
+static int message_peek_field_signature(
+                sd_bus_message *m,
+                size_t *ri,
+                size_t item_size,
+                const char **ret) {
+
+        return message_peek_field_signature_full(m, ri, item_size, true, ret);
+}
+
 static int message_skip_fields(
                 sd_bus_message *m,
                 size_t *ri,
@@ -5398,7 +5451,9 @@ int bus_message_parse_fields(sd_bus_message *m) {
                         if (!streq(signature, "g"))
                                 return -EBADMSG;
 
-                        r = message_peek_field_signature(m, &ri, item_size, &s);
+                        /* The body signature is only needed once the body is read, see
+                         * message_verify_signature() */
+                        r = message_peek_field_signature_full(m, &ri, item_size, false, &s);
                         if (r < 0)
                                 return r;
 
@@ -5407,6 +5462,7 @@ int bus_message_parse_fields(sd_bus_message *m) {
                                 return -ENOMEM;
 
                         free_and_replace(m->root_container.signature, c);
+                        m->signature_unverified = true;
                         break;
                 }
 
@@ -5729,6 +5785,9 @@ _public_ const char* sd_bus_message_get_signature(sd_bus_message *m, int complet
 
         assert_return(m, NULL);
 
+        if (message_verify_signature(m) < 0)
+                return NULL;
+
         c = complete ? &m->root_container : message_get_last_container(m);
         return strempty(c->signature);
 }
@@ -5834,6 +5893,10 @@ _public_ int sd_bus_message_verify_type(sd_bus_message *m, char type, const char
         assert_return(type || contents, -EINVAL);
         assert_return(!contents || !type || bus_type_is_container(type), -EINVAL);
 
+        r = message_verify_signature(m);
+        if (r < 0)
+                return r;
+
         r = sd_bus_message_peek_type(m, &t, &c);
         if (r <= 0)
                 return r;
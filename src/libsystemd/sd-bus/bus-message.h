@@ -86,6 +86,11 @@ struct sd_bus_message {
         bool poisoned:1;
         bool sensitive:1;
 
+        /* Set on received dbus1 messages until the body signature has been validated, which happens the
+         * first time the body is accessed. This way messages that are only routed, filtered or
+         * forwarded don't pay for it. */
+        bool signature_unverified:1;
+
         /* The first and last bytes of the message */
         struct bus_header *header;
         void *footer;
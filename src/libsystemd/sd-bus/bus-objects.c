@@ -752,6 +752,274 @@ static int vtable_append_one_property(
         return 0;
 }
 
+/* The property cache keeps, per object path and vtable, a pre-serialized "a{sv}" fragment of all
+ * properties marked SD_BUS_VTABLE_PROPERTY_CONST, so that GetAll() and GetManagedObjects() calls on
+ * objects that did not change only have to invoke the getters of the remaining properties. It is
+ * disabled by default, since getters of properties marked constant are not necessarily pure: a bus
+ * owner enabling it must invalidate the cache with bus_property_cache_invalidate() whenever it changes
+ * such a property behind our back. */
+
+typedef struct BusPropertyCacheEntry BusPropertyCacheEntry;
+typedef struct BusPropertyCacheNode BusPropertyCacheNode;
+
+struct BusPropertyCacheEntry {
+        struct node_vtable *vtable;
+        void *userdata;
+        sd_bus_message *fragment; /* NULL if the vtable has no cacheable properties */
+        LIST_FIELDS(BusPropertyCacheEntry, entries);
+};
+
+struct BusPropertyCacheNode {
+        char *path;
+        LIST_HEAD(BusPropertyCacheEntry, entries);
+};
+
+static BusPropertyCacheEntry* property_cache_entry_free(BusPropertyCacheEntry *e) {
+        if (!e)
+                return NULL;
+
+        sd_bus_message_unref(e->fragment);
+        return mfree(e);
+}
+
+static BusPropertyCacheNode* property_cache_node_free(BusPropertyCacheNode *n) {
+        BusPropertyCacheEntry *e;
+
+        if (!n)
+                return NULL;
+
+        while ((e = n->entries)) {
+                LIST_REMOVE(entries, n->entries, e);
+                property_cache_entry_free(e);
+        }
+
+        free(n->path);
+        return mfree(n);
+}
+
+DEFINE_TRIVIAL_CLEANUP_FUNC(BusPropertyCacheNode*, property_cache_node_free);
+
+DEFINE_PRIVATE_HASH_OPS_WITH_VALUE_DESTRUCTOR(property_cache_hash_ops,
+                                              char, string_hash_func, string_compare_func,
+                                              BusPropertyCacheNode, property_cache_node_free);
+
+static bool vtable_property_is_cacheable(const sd_bus_vtable *v) {
+        assert(v);
+
+        /* File descriptors are duplicated into each message they are appended to, hence don't try to
+         * cache them. */
+        return FLAGS_SET(v->flags, SD_BUS_VTABLE_PROPERTY_CONST) &&
+                !strchr(v->x.property.signature, SD_BUS_TYPE_UNIX_FD);
+}
+
+static int property_cache_build_fragment(
+                sd_bus *bus,
+                const char *path,
+                struct node_vtable *c,
+                void *userdata,
+                sd_bus_message **ret,
+                sd_bus_error *error) {
+
+        _cleanup_(sd_bus_message_unrefp) sd_bus_message *m = NULL;
+        const sd_bus_vtable *v;
+        bool any = false;
+        int r;
+
+        assert(bus);
+        assert(path);
+        assert(c);
+        assert(ret);
+
+        r = sd_bus_message_new(bus, &m, SD_BUS_MESSAGE_METHOD_RETURN);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_message_open_container(m, 'a', "{sv}");
+        if (r < 0)
+                return r;
+
+        v = c->vtable;
+        for (v = bus_vtable_next(c->vtable, v); v->type != _SD_BUS_VTABLE_END; v = bus_vtable_next(c->vtable, v)) {
+                if (!IN_SET(v->type, _SD_BUS_VTABLE_PROPERTY, _SD_BUS_VTABLE_WRITABLE_PROPERTY))
+                        continue;
+
+                if (v->flags & (SD_BUS_VTABLE_HIDDEN|SD_BUS_VTABLE_PROPERTY_EXPLICIT))
+                        continue;
+
+                if (!vtable_property_is_cacheable(v))
+                        continue;
+
+                r = vtable_append_one_property(bus, m, path, c, v, userdata, error);
+                if (r < 0)
+                        return r;
+                if (bus->nodes_modified)
+                        return 0;
+
+                any = true;
+        }
+
+        if (!any) {
+                *ret = NULL;
+                return 1;
+        }
+
+        r = sd_bus_message_close_container(m);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_message_seal(m, UINT32_MAX, 0);
+        if (r < 0)
+                return r;
+
+        /* The fragment is never sent, it is only copied from. Drop the reference it holds on the bus, so
+         * that the cache doesn't pin the connection. */
+        m->bus = sd_bus_unref(m->bus);
+
+        *ret = TAKE_PTR(m);
+        return 1;
+}
+
+static int property_cache_get(
+                sd_bus *bus,
+                const char *path,
+                struct node_vtable *c,
+                void *userdata,
+                BusPropertyCacheEntry **ret,
+                sd_bus_error *error) {
+
+        _cleanup_(property_cache_node_freep) BusPropertyCacheNode *new_node = NULL;
+        _cleanup_(sd_bus_message_unrefp) sd_bus_message *fragment = NULL;
+        BusPropertyCacheNode *n;
+        BusPropertyCacheEntry *e;
+        int r;
+
+        assert(bus);
+        assert(path);
+        assert(c);
+        assert(ret);
+
+        n = hashmap_get(bus->property_cache, path);
+        if (n)
+                LIST_FOREACH(entries, e, n->entries)
+                        if (e->vtable == c) {
+                                if (e->userdata == userdata) {
+                                        *ret = e;
+                                        return 1;
+                                }
+
+                                /* The object behind this path changed, drop the stale entry */
+                                LIST_REMOVE(entries, n->entries, e);
+                                property_cache_entry_free(e);
+                                break;
+                        }
+
+        r = property_cache_build_fragment(bus, path, c, userdata, &fragment, error);
+        if (r <= 0)
+                return r;
+
+        if (!n) {
+                r = hashmap_ensure_allocated(&bus->property_cache, &property_cache_hash_ops);
+                if (r < 0)
+                        return r;
+
+                new_node = new0(BusPropertyCacheNode, 1);
+                if (!new_node)
+                        return -ENOMEM;
+
+                new_node->path = strdup(path);
+                if (!new_node->path)
+                        return -ENOMEM;
+
+                r = hashmap_put(bus->property_cache, new_node->path, new_node);
+                if (r < 0)
+                        return r;
+
+                n = TAKE_PTR(new_node);
+        }
+
+        e = new(BusPropertyCacheEntry, 1);
+        if (!e)
+                return -ENOMEM;
+
+        *e = (BusPropertyCacheEntry) {
+                .vtable = c,
+                .userdata = userdata,
+                .fragment = TAKE_PTR(fragment),
+        };
+
+        LIST_PREPEND(entries, n->entries, e);
+
+        *ret = e;
+        return 1;
+}
+
+static int property_cache_append(sd_bus_message *reply, BusPropertyCacheEntry *e) {
+        int r;
+
+        assert(reply);
+        assert(e);
+
+        if (!e->fragment)
+                return 0;
+
+        r = sd_bus_message_rewind(e->fragment, true);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_message_enter_container(e->fragment, 'a', "{sv}");
+        if (r < 0)
+                return r;
+
+        r = sd_bus_message_copy(reply, e->fragment, true);
+        if (r < 0)
+                return r;
+
+        return sd_bus_message_exit_container(e->fragment);
+}
+
+int bus_property_cache_set_enabled(sd_bus *bus, bool b) {
+        assert(bus);
+
+        bus->property_cache_enabled = b;
+        if (!b)
+                bus->property_cache = hashmap_free(bus->property_cache);
+
+        return 0;
+}
+
+void bus_property_cache_invalidate(sd_bus *bus, const char *path, const char *interface) {
+        BusPropertyCacheNode *n;
+        BusPropertyCacheEntry *e, *next;
+
+        assert(bus);
+
+        if (hashmap_isempty(bus->property_cache))
+                return;
+
+        if (!path) {
+                hashmap_clear(bus->property_cache);
+                return;
+        }
+
+        n = hashmap_get(bus->property_cache, path);
+        if (!n)
+                return;
+
+        if (interface)
+                LIST_FOREACH_SAFE(entries, e, next, n->entries) {
+                        if (!streq(e->vtable->interface, interface))
+                                continue;
+
+                        LIST_REMOVE(entries, n->entries, e);
+                        property_cache_entry_free(e);
+                }
+
+        if (!interface || !n->entries) {
+                hashmap_remove(bus->property_cache, path);
+                property_cache_node_free(n);
+        }
+}
+
 static int vtable_append_all_properties(
                 sd_bus *bus,
                 sd_bus_message *reply,
@@ -761,6 +1029,7 @@ static int vtable_append_all_properties(
                 sd_bus_error *error) {
 
         const sd_bus_vtable *v;
+        bool cached = false;
         int r;
 
         assert(bus);
@@ -771,6 +1040,26 @@ static int vtable_append_all_properties(
         if (c->vtable[0].flags & SD_BUS_VTABLE_HIDDEN)
                 return 1;
 
+        /* Only replies are served from the cache: signals are generated rarely, and sensitive data
+         * shall not linger in memory longer than necessary. */
+        if (bus->property_cache_enabled &&
+            reply->header->type == SD_BUS_MESSAGE_METHOD_RETURN &&
+            !FLAGS_SET(c->vtable->flags, SD_BUS_VTABLE_SENSITIVE)) {
+                BusPropertyCacheEntry *e;
+
+                r = property_cache_get(bus, path, c, userdata, &e, error);
+                if (r < 0)
+                        return r;
+                if (bus->nodes_modified)
+                        return 0;
+
+                r = property_cache_append(reply, e);
+                if (r < 0)
+                        return r;
+
+                cached = true;
+        }
+
         v = c->vtable;
         for (v = bus_vtable_next(c->vtable, v); v->type != _SD_BUS_VTABLE_END; v = bus_vtable_next(c->vtable, v)) {
                 if (!IN_SET(v->type, _SD_BUS_VTABLE_PROPERTY, _SD_BUS_VTABLE_WRITABLE_PROPERTY))
@@ -779,6 +1068,9 @@ static int vtable_append_all_properties(
                 if (v->flags & SD_BUS_VTABLE_HIDDEN)
                         continue;
 
+                if (cached && vtable_property_is_cacheable(v))
+                        continue;
+
                 /* Let's not include properties marked as "explicit" in any message that contains a generic
                  * dump of properties, but only in those generated as a response to an explicit request. */
                 if (v->flags & SD_BUS_VTABLE_PROPERTY_EXPLICIT)
@@ -801,6 +1093,69 @@ static int vtable_append_all_properties(
         return 1;
 }
 
+static bool vtable_property_matches(const sd_bus_vtable *v, char **properties) {
+        assert(v);
+
+        if (!IN_SET(v->type, _SD_BUS_VTABLE_PROPERTY, _SD_BUS_VTABLE_WRITABLE_PROPERTY))
+                return false;
+
+        if (v->flags & SD_BUS_VTABLE_HIDDEN)
+                return false;
+
+        return strv_contains(properties, v->x.property.member);
+}
+
+static bool vtable_has_matching_properties(struct node_vtable *c, char **properties) {
+        const sd_bus_vtable *v;
+
+        assert(c);
+
+        if (c->vtable[0].flags & SD_BUS_VTABLE_HIDDEN)
+                return false;
+
+        v = c->vtable;
+        for (v = bus_vtable_next(c->vtable, v); v->type != _SD_BUS_VTABLE_END; v = bus_vtable_next(c->vtable, v))
+                if (vtable_property_matches(v, properties))
+                        return true;
+
+        return false;
+}
+
+static int vtable_append_matching_properties(
+                sd_bus *bus,
+                sd_bus_message *reply,
+                const char *path,
+                struct node_vtable *c,
+                void *userdata,
+                char **properties,
+                sd_bus_error *error) {
+
+        const sd_bus_vtable *v;
+        int r;
+
+        assert(bus);
+        assert(reply);
+        assert(path);
+        assert(c);
+
+        /* Like vtable_append_all_properties(), but only for the listed properties. Since they are
+         * requested by name, this includes properties marked "explicit". */
+
+        v = c->vtable;
+        for (v = bus_vtable_next(c->vtable, v); v->type != _SD_BUS_VTABLE_END; v = bus_vtable_next(c->vtable, v)) {
+                if (!vtable_property_matches(v, properties))
+                        continue;
+
+                r = vtable_append_one_property(bus, reply, path, c, v, userdata, error);
+                if (r < 0)
+                        return r;
+                if (bus->nodes_modified)
+                        return 0;
+        }
+
+        return 1;
+}
+
 static int property_get_all_callbacks_run(
                 sd_bus *bus,
                 sd_bus_message *m,
@@ -1056,6 +1411,7 @@ static int object_manager_serialize_path(
                 const char *prefix,
                 const char *path,
                 bool require_fallback,
+                char **properties,
                 sd_bus_error *error) {
 
         const char *previous_interface = NULL;
@@ -1080,6 +1436,9 @@ static int object_manager_serialize_path(
                 if (require_fallback && !i->is_fallback)
                         continue;
 
+                if (properties && !vtable_has_matching_properties(i, properties))
+                        continue;
+
                 r = node_vtable_get_userdata(bus, path, i, &u, error);
                 if (r < 0)
                         return r;
@@ -1104,21 +1463,25 @@ static int object_manager_serialize_path(
                         if (r < 0)
                                 return r;
 
-                        r = sd_bus_message_append(reply, "{sa{sv}}", "org.freedesktop.DBus.Peer", 0);
-                        if (r < 0)
-                                return r;
+                        /* The standard interfaces have no properties, hence skip them if specific ones
+                         * were asked for */
+                        if (!properties) {
+                                r = sd_bus_message_append(reply, "{sa{sv}}", "org.freedesktop.DBus.Peer", 0);
+                                if (r < 0)
+                                        return r;
 
-                        r = sd_bus_message_append(reply, "{sa{sv}}", "org.freedesktop.DBus.Introspectable", 0);
-                        if (r < 0)
-                                return r;
+                                r = sd_bus_message_append(reply, "{sa{sv}}", "org.freedesktop.DBus.Introspectable", 0);
+                                if (r < 0)
+                                        return r;
 
-                        r = sd_bus_message_append(reply, "{sa{sv}}", "org.freedesktop.DBus.Properties", 0);
-                        if (r < 0)
-                                return r;
+                                r = sd_bus_message_append(reply, "{sa{sv}}", "org.freedesktop.DBus.Properties", 0);
+                                if (r < 0)
+                                        return r;
 
-                        r = sd_bus_message_append(reply, "{sa{sv}}", "org.freedesktop.DBus.ObjectManager", 0);
-                        if (r < 0)
-                                return r;
+                                r = sd_bus_message_append(reply, "{sa{sv}}", "org.freedesktop.DBus.ObjectManager", 0);
+                                if (r < 0)
+                                        return r;
+                        }
 
                         found_something = true;
                 }
@@ -1152,7 +1515,10 @@ static int object_manager_serialize_path(
                                 return r;
                 }
 
-                r = vtable_append_all_properties(bus, reply, path, i, u, error);
+                if (properties)
+                        r = vtable_append_matching_properties(bus, reply, path, i, u, properties, error);
+                else
+                        r = vtable_append_all_properties(bus, reply, path, i, u, error);
                 if (r < 0)
                         return r;
                 if (bus->nodes_modified)
@@ -1188,6 +1554,7 @@ static int object_manager_serialize_path_and_fallbacks(
                 sd_bus *bus,
                 sd_bus_message *reply,
                 const char *path,
+                char **properties,
                 sd_bus_error *error) {
 
         _cleanup_free_ char *prefix = NULL;
@@ -1200,7 +1567,7 @@ static int object_manager_serialize_path_and_fallbacks(
         assert(error);
 
         /* First, add all vtables registered for this path */
-        r = object_manager_serialize_path(bus, reply, path, path, false, error);
+        r = object_manager_serialize_path(bus, reply, path, path, false, properties, error);
         if (r < 0)
                 return r;
         if (bus->nodes_modified)
@@ -1214,7 +1581,7 @@ static int object_manager_serialize_path_and_fallbacks(
                 return -ENOMEM;
 
         OBJECT_PATH_FOREACH_PREFIX(prefix, path) {
-                r = object_manager_serialize_path(bus, reply, prefix, path, true, error);
+                r = object_manager_serialize_path(bus, reply, prefix, path, true, properties, error);
                 if (r < 0)
                         return r;
                 if (bus->nodes_modified)
@@ -1264,7 +1631,7 @@ static int process_get_managed_objects(
                 return r;
 
         SET_FOREACH(path, s) {
-                r = object_manager_serialize_path_and_fallbacks(bus, reply, path, &error);
+                r = object_manager_serialize_path_and_fallbacks(bus, reply, path, NULL, &error);
                 if (r < 0)
                         return bus_maybe_reply_error(m, r, &error);
 
@@ -1283,6 +1650,36 @@ static int process_get_managed_objects(
         return 1;
 }
 
+int bus_message_append_object_properties(
+                sd_bus *bus,
+                sd_bus_message *reply,
+                const char *path,
+                char **properties,
+                sd_bus_error *error) {
+
+        int r;
+
+        assert(bus);
+        assert(reply);
+        assert(path);
+        assert(error);
+
+        /* Appends a "{oa{sa{sv}}}" entry, as in the reply to GetManagedObjects(), for the object at the
+         * specified path, limited to the listed properties, or with all properties if NULL. This is for
+         * implementing methods that return the properties of many objects at once. Appends nothing if
+         * there's no such object. */
+
+        r = object_manager_serialize_path_and_fallbacks(bus, reply, path, properties, error);
+        if (r < 0)
+                return r;
+
+        /* We can't restart here, since the reply has been partially filled in already */
+        if (bus->nodes_modified)
+                return -EAGAIN;
+
+        return 0;
+}
+
 static int object_find_and_run(
                 sd_bus *bus,
                 sd_bus_message *m,
@@ -2296,6 +2693,8 @@ _public_ int sd_bus_emit_properties_changed_strv(
 
         BUS_DONT_DESTROY(bus);
 
+        bus_property_cache_invalidate(bus, path, interface);
+
         pl = strlen(path);
         assert(pl <= BUS_PATH_SIZE_MAX);
         prefix = new(char, pl + 1);
@@ -2529,6 +2928,8 @@ _public_ int sd_bus_emit_object_added(sd_bus *bus, const char *path) {
         if (!BUS_IS_OPEN(bus->state))
                 return -ENOTCONN;
 
+        bus_property_cache_invalidate(bus, path, NULL);
+
         r = bus_find_parent_object_manager(bus, &object_manager, path);
         if (r < 0)
                 return r;
@@ -2706,6 +3107,8 @@ _public_ int sd_bus_emit_object_removed(sd_bus *bus, const char *path) {
         if (!BUS_IS_OPEN(bus->state))
                 return -ENOTCONN;
 
+        bus_property_cache_invalidate(bus, path, NULL);
+
         r = bus_find_parent_object_manager(bus, &object_manager, path);
         if (r < 0)
                 return r;
@@ -2943,6 +3346,7 @@ _public_ int sd_bus_emit_interfaces_added(sd_bus *bus, const char *path, const c
 _public_ int sd_bus_emit_interfaces_removed_strv(sd_bus *bus, const char *path, char **interfaces) {
         _cleanup_(sd_bus_message_unrefp) sd_bus_message *m = NULL;
         struct node *object_manager;
+        char **i;
         int r;
 
         assert_return(bus, -EINVAL);
@@ -2956,6 +3360,9 @@ _public_ int sd_bus_emit_interfaces_removed_strv(sd_bus *bus, const char *path,
         if (strv_isempty(interfaces))
                 return 0;
 
+        STRV_FOREACH(i, interfaces)
+                bus_property_cache_invalidate(bus, path, *i);
+
         r = bus_find_parent_object_manager(bus, &object_manager, path);
         if (r < 0)
                 return r;
@@ -9,6 +9,11 @@ bool bus_vtable_has_names(const sd_bus_vtable *vtable);
 int bus_process_object(sd_bus *bus, sd_bus_message *m);
 void bus_node_gc(sd_bus *b, struct node *n);
 
+int bus_message_append_object_properties(sd_bus *bus, sd_bus_message *reply, const char *path, char **properties, sd_bus_error *error);
+
+int bus_property_cache_set_enabled(sd_bus *bus, bool b);
+void bus_property_cache_invalidate(sd_bus *bus, const char *path, const char *interface);
+
 int introspect_path(
                 sd_bus *bus,
                 const char *path,
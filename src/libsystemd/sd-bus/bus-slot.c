@@ -155,6 +155,10 @@ void bus_slot_disconnect(sd_bus_slot *slot, bool unref) {
                         LIST_REMOVE(vtables, slot->node_vtable.node->vtables, &slot->node_vtable);
                         slot->bus->nodes_modified = true;
 
+                        /* Cache entries refer to the vtable, and fallback vtables may be cached below
+                         * any number of paths, hence flush everything. */
+                        bus_property_cache_invalidate(slot->bus, NULL, NULL);
+
                         bus_node_gc(slot->bus, slot->node_vtable.node);
                 }
 
@@ -31,6 +31,12 @@
 
 #define SNDBUF_SIZE (8*1024*1024)
 
+/* Maximum number of iovecs to write queued messages with at once */
+#define WRITE_IOVEC_MAX 256U
+
+/* Minimum number of bytes to read at once, if possible */
+#define READ_SIZE_MIN (4U*1024U)
+
 static void iovec_advance(struct iovec iov[], unsigned *idx, size_t size) {
 
         while (size > 0) {
@@ -1009,38 +1015,59 @@ int bus_socket_take_fd(sd_bus *b) {
         return bus_socket_start_auth(b);
 }
 
-int bus_socket_write_message(sd_bus *bus, sd_bus_message *m, size_t *idx) {
+int bus_socket_write_messages(sd_bus *bus, sd_bus_message **messages, size_t n_messages, size_t *idx) {
+        sd_bus_message *m;
         struct iovec *iov;
+        size_t n = 0, n_iovec = 0;
         ssize_t k;
-        size_t n;
         unsigned j;
         int r;
 
         assert(bus);
-        assert(m);
+        assert(messages);
+        assert(n_messages > 0);
         assert(idx);
         assert(IN_SET(bus->state, BUS_RUNNING, BUS_HELLO));
 
+        m = messages[0];
+
         if (*idx >= BUS_MESSAGE_SIZE(m))
                 return 0;
 
-        r = bus_message_setup_iovec(m);
-        if (r < 0)
-                return r;
+        /* Writes as many of the messages as possible with a single syscall. *idx is the offset into the first
+         * message, and is increased by the number of bytes written, which hence might go beyond the first
+         * message. File descriptors must be sent along with the first byte of the message they belong to, so
+         * only the first message in a batch may carry any. */
 
-        n = m->n_iovec * sizeof(struct iovec);
-        iov = newa(struct iovec, n);
-        memcpy_safe(iov, m->iovec, n);
+        for (; n < n_messages; n++) {
+                if (n > 0 && messages[n]->n_fds > 0)
+                        break;
+
+                r = bus_message_setup_iovec(messages[n]);
+                if (r < 0)
+                        return r;
+
+                if (n > 0 && n_iovec + messages[n]->n_iovec > WRITE_IOVEC_MAX)
+                        break;
+
+                n_iovec += messages[n]->n_iovec;
+        }
+
+        iov = newa(struct iovec, n_iovec);
+        for (size_t i = 0, p = 0; i < n; i++) {
+                memcpy_safe(iov + p, messages[i]->iovec, messages[i]->n_iovec * sizeof(struct iovec));
+                p += messages[i]->n_iovec;
+        }
 
         j = 0;
         iovec_advance(iov, &j, *idx);
 
         if (bus->prefer_writev)
-                k = writev(bus->output_fd, iov, m->n_iovec);
+                k = writev(bus->output_fd, iov + j, n_iovec - j);
         else {
                 struct msghdr mh = {
-                        .msg_iov = iov,
-                        .msg_iovlen = m->n_iovec,
+                        .msg_iov = iov + j,
+                        .msg_iovlen = n_iovec - j,
                 };
 
                 if (m->n_fds > 0 && *idx == 0) {
@@ -1058,7 +1085,7 @@ int bus_socket_write_message(sd_bus *bus, sd_bus_message *m, size_t *idx) {
                 k = sendmsg(bus->output_fd, &mh, MSG_DONTWAIT|MSG_NOSIGNAL);
                 if (k < 0 && errno == ENOTSOCK) {
                         bus->prefer_writev = true;
-                        k = writev(bus->output_fd, iov, m->n_iovec);
+                        k = writev(bus->output_fd, iov + j, n_iovec - j);
                 }
         }
 
@@ -1139,6 +1166,9 @@ static int bus_socket_make_message(sd_bus *bus, size_t size) {
                            bus->rbuffer_size - size);
                 if (!b)
                         return -ENOMEM;
+
+                /* We read ahead, don't let the message keep the whole buffer around */
+                bus->rbuffer = realloc(bus->rbuffer, size) ?: bus->rbuffer;
         } else
                 b = NULL;
 
@@ -1175,7 +1205,7 @@ int bus_socket_read_message(sd_bus *bus) {
         struct msghdr mh;
         struct iovec iov = {};
         ssize_t k;
-        size_t need;
+        size_t need, want;
         int r;
         void *b;
         CMSG_BUFFER_TYPE(CMSG_SPACE(sizeof(int) * BUS_FDS_MAX)) control;
@@ -1191,13 +1221,19 @@ int bus_socket_read_message(sd_bus *bus) {
         if (bus->rbuffer_size >= need)
                 return bus_socket_make_message(bus, need);
 
-        b = realloc(bus->rbuffer, need);
+        /* Unless fd passing is enabled, read more than the current message needs, so that bursts of small
+         * messages are parsed with few syscalls. Leftovers are kept in rbuffer for the next call. With fd
+         * passing we can't: a read covering more than one message might return the fds of a later message,
+         * and we couldn't tell them apart from those of the current one. */
+        want = bus->can_fds ? need : MAX(need, (size_t) READ_SIZE_MIN);
+
+        b = realloc(bus->rbuffer, want);
         if (!b)
                 return -ENOMEM;
 
         bus->rbuffer = b;
 
-        iov = IOVEC_MAKE((uint8_t *)bus->rbuffer + bus->rbuffer_size, need - bus->rbuffer_size);
+        iov = IOVEC_MAKE((uint8_t *)bus->rbuffer + bus->rbuffer_size, want - bus->rbuffer_size);
 
         if (bus->prefer_readv) {
                 k = readv(bus->input_fd, &iov, 1);
@@ -216,6 +216,8 @@ static sd_bus* bus_free(sd_bus *b) {
 
         hashmap_free_free(b->vtable_methods);
         hashmap_free_free(b->vtable_properties);
+        hashmap_free(b->property_cache);
+        bus_peer_creds_cache_flush(b);
 
         assert(hashmap_isempty(b->nodes));
         hashmap_free(b->nodes);
@@ -243,6 +245,7 @@ _public_ int sd_bus_new(sd_bus **ret) {
                 .input_fd = -1,
                 .output_fd = -1,
                 .inotify_fd = -1,
+                .peer_pidfd = -1,
                 .message_version = 1,
                 .creds_mask = SD_BUS_CREDS_WELL_KNOWN_NAMES|SD_BUS_CREDS_UNIQUE_NAME,
                 .accept_fd = true,
@@ -604,8 +607,8 @@ int bus_start_running(sd_bus *bus) {
         assert(bus->state < BUS_HELLO);
 
         /* We start all method call timeouts when we enter BUS_HELLO or BUS_RUNNING mode. At this point let's convert
-         * all relative to absolute timestamps. Note that we do not reshuffle the reply callback priority queue since
-         * adding a fixed value to all entries should not alter the internal order. */
+         * all relative to absolute timestamps. Adding a fixed value to all entries does not alter their order, but
+         * the priority queue caches the timeouts, hence refresh it in one go. */
 
         n = now(CLOCK_MONOTONIC);
         ORDERED_HASHMAP_FOREACH(c, bus->reply_callbacks) {
@@ -615,6 +618,8 @@ int bus_start_running(sd_bus *bus) {
                 c->timeout_usec = usec_add(n, c->timeout_usec);
         }
 
+        prioq_reshuffle_all(bus->reply_callbacks_prioq);
+
         if (bus->bus_client) {
                 bus_set_state(bus, BUS_HELLO);
                 return 1;
@@ -1974,6 +1979,21 @@ int bus_seal_synthetic_message(sd_bus *b, sd_bus_message *m) {
         return sd_bus_message_seal(m, 0xFFFFFFFFULL, 0);
 }
 
+static void log_message_sent(sd_bus_message *m) {
+        log_debug("Sent message type=%s sender=%s destination=%s path=%s interface=%s member=%s cookie=%" PRIu64 " reply_cookie=%" PRIu64 " signature=%s error-name=%s error-message=%s",
+                  bus_message_type_to_string(m->header->type),
+                  strna(sd_bus_message_get_sender(m)),
+                  strna(sd_bus_message_get_destination(m)),
+                  strna(sd_bus_message_get_path(m)),
+                  strna(sd_bus_message_get_interface(m)),
+                  strna(sd_bus_message_get_member(m)),
+                  BUS_MESSAGE_COOKIE(m),
+                  m->reply_cookie,
+                  strna(m->root_container.signature),
+                  strna(m->error.name),
+                  strna(m->error.message));
+}
+
 static int bus_write_message(sd_bus *bus, sd_bus_message *m, size_t *idx) {
         int r;
 
@@ -1985,18 +2005,7 @@ static int bus_write_message(sd_bus *bus, sd_bus_message *m, size_t *idx) {
                 return r;
 
         if (*idx >= BUS_MESSAGE_SIZE(m))
-                log_debug("Sent message type=%s sender=%s destination=%s path=%s interface=%s member=%s cookie=%" PRIu64 " reply_cookie=%" PRIu64 " signature=%s error-name=%s error-message=%s",
-                          bus_message_type_to_string(m->header->type),
-                          strna(sd_bus_message_get_sender(m)),
-                          strna(sd_bus_message_get_destination(m)),
-                          strna(sd_bus_message_get_path(m)),
-                          strna(sd_bus_message_get_interface(m)),
-                          strna(sd_bus_message_get_member(m)),
-                          BUS_MESSAGE_COOKIE(m),
-                          m->reply_cookie,
-                          strna(m->root_container.signature),
-                          strna(m->error.name),
-                          strna(m->error.message));
+                log_message_sent(m);
 
         return r;
 }
@@ -2008,29 +2017,32 @@ static int dispatch_wqueue(sd_bus *bus) {
         assert(IN_SET(bus->state, BUS_RUNNING, BUS_HELLO));
 
         while (bus->wqueue_size > 0) {
+                size_t n = 0;
 
-                r = bus_write_message(bus, bus->wqueue[0], &bus->windex);
+                /* Write as many queued messages at once as possible, bus->windex is the offset into the
+                 * first one */
+                r = bus_socket_write_messages(bus, bus->wqueue, bus->wqueue_size, &bus->windex);
                 if (r < 0)
                         return r;
-                else if (r == 0)
+                if (r == 0)
                         /* Didn't do anything this time */
                         return ret;
-                else if (bus->windex >= BUS_MESSAGE_SIZE(bus->wqueue[0])) {
-                        /* Fully written. Let's drop the entry from
-                         * the queue.
-                         *
-                         * This isn't particularly optimized, but
-                         * well, this is supposed to be our worst-case
-                         * buffer only, and the socket buffer is
-                         * supposed to be our primary buffer, and if
-                         * it got full, then all bets are off
-                         * anyway. */
-
-                        bus->wqueue_size--;
-                        bus_message_unref_queued(bus->wqueue[0], bus);
-                        memmove(bus->wqueue, bus->wqueue + 1, sizeof(sd_bus_message*) * bus->wqueue_size);
-                        bus->windex = 0;
 
+                /* Drop all fully written entries from the queue.
+                 *
+                 * This isn't particularly optimized, but well, this is supposed to be our worst-case buffer
+                 * only, and the socket buffer is supposed to be our primary buffer, and if it got full, then
+                 * all bets are off anyway. */
+                while (n < bus->wqueue_size && bus->windex >= BUS_MESSAGE_SIZE(bus->wqueue[n])) {
+                        bus->windex -= BUS_MESSAGE_SIZE(bus->wqueue[n]);
+                        log_message_sent(bus->wqueue[n]);
+                        bus_message_unref_queued(bus->wqueue[n], bus);
+                        n++;
+                }
+
+                if (n > 0) {
+                        bus->wqueue_size -= n;
+                        memmove(bus->wqueue, bus->wqueue + n, sizeof(sd_bus_message*) * bus->wqueue_size);
                         ret = 1;
                 }
         }
@@ -2224,16 +2236,11 @@ static usec_t calc_elapse(sd_bus *bus, uint64_t usec) {
                 return usec_add(now(CLOCK_MONOTONIC), usec);
 }
 
-static int timeout_compare(const void *a, const void *b) {
-        const struct reply_callback *x = a, *y = b;
-
-        if (x->timeout_usec != 0 && y->timeout_usec == 0)
-                return -1;
-
-        if (x->timeout_usec == 0 && y->timeout_usec != 0)
-                return 1;
+static uint64_t timeout_key(const void *p) {
+        const struct reply_callback *c = p;
 
-        return CMP(x->timeout_usec, y->timeout_usec);
+        /* Callbacks without timeout go last */
+        return c->timeout_usec == 0 ? UINT64_MAX : c->timeout_usec;
 }
 
 _public_ int sd_bus_call_async(
@@ -2265,11 +2272,11 @@ _public_ int sd_bus_call_async(
         if (!callback && !slot && !m->sealed)
                 m->header->flags |= BUS_MESSAGE_NO_REPLY_EXPECTED;
 
-        r = ordered_hashmap_ensure_allocated(&bus->reply_callbacks, &uint64_hash_ops);
+        r = ordered_hashmap_ensure_allocated(&bus->reply_callbacks, &uint64_hash_ops_fast);
         if (r < 0)
                 return r;
 
-        r = prioq_ensure_allocated(&bus->reply_callbacks_prioq, timeout_compare);
+        r = prioq_ensure_allocated_keyed(&bus->reply_callbacks_prioq, timeout_key, NULL);
         if (r < 0)
                 return r;
 
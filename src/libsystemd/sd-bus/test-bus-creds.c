@@ -1,10 +1,158 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
+#include <sys/socket.h>
+#include <unistd.h>
+
 #include "sd-bus.h"
 
+#include "bus-control.h"
+#include "bus-creds.h"
 #include "bus-dump.h"
+#include "bus-internal.h"
 #include "cgroup-util.h"
+#include "fd-util.h"
+#include "path-util.h"
+#include "process-util.h"
+#include "rm-rf.h"
+#include "socket-util.h"
+#include "strv.h"
 #include "tests.h"
+#include "tmpfile-util.h"
+
+#define N_CALLS 3
+
+static int filter(sd_bus_message *m, void *userdata, sd_bus_error *error) {
+        sd_bus_message **calls = userdata;
+
+        for (size_t i = 0; i < N_CALLS; i++)
+                if (!calls[i]) {
+                        calls[i] = sd_bus_message_ref(m);
+                        break;
+                }
+
+        return 1;
+}
+
+static void test_peer_creds_cache(void) {
+        _cleanup_(rm_rf_physical_and_freep) char *tmpdir = NULL;
+        _cleanup_(sd_bus_flush_close_unrefp) sd_bus *server = NULL;
+        sd_bus_message *calls[N_CALLS] = {};
+        _cleanup_close_ int listen_fd = -1, fd = -1;
+        _cleanup_free_ char *address = NULL;
+        union sockaddr_union sa;
+        char **first = NULL;
+        sd_id128_t id;
+        pid_t pid;
+        int r, sa_len;
+
+        log_info("/* %s */", __func__);
+
+        assert_se(mkdtemp_malloc("/tmp/test-bus-creds.XXXXXX", &tmpdir) >= 0);
+        assert_se(address = path_join(tmpdir, "socket"));
+
+        sa_len = sockaddr_un_set_path(&sa.un, address);
+        assert_se(sa_len >= 0);
+
+        listen_fd = socket(AF_UNIX, SOCK_STREAM|SOCK_CLOEXEC, 0);
+        assert_se(listen_fd >= 0);
+        assert_se(bind(listen_fd, &sa.sa, sa_len) >= 0);
+        assert_se(listen(listen_fd, 1) >= 0);
+
+        /* The peer needs to be a process of its own, so that SO_PEERCRED refers to it, and we can watch
+         * it go away */
+        r = safe_fork("(bus-creds-client)", FORK_DEATHSIG|FORK_LOG, &pid);
+        assert_se(r >= 0);
+        if (r == 0) {
+                _cleanup_(sd_bus_flush_close_unrefp) sd_bus *client = NULL;
+                _cleanup_free_ char *bus_address = NULL;
+
+                assert_se(bus_address = strjoin("unix:path=", address));
+                assert_se(sd_bus_new(&client) >= 0);
+                assert_se(sd_bus_set_address(client, bus_address) >= 0);
+                assert_se(sd_bus_set_anonymous(client, true) >= 0);
+                assert_se(sd_bus_start(client) >= 0);
+
+                for (size_t i = 0; i < N_CALLS; i++) {
+                        _cleanup_(sd_bus_message_unrefp) sd_bus_message *m = NULL;
+
+                        assert_se(sd_bus_message_new_method_call(client, &m, NULL, "/test", "org.freedesktop.systemd.test", "Test") >= 0);
+                        assert_se(sd_bus_message_set_expect_reply(m, false) >= 0);
+                        assert_se(sd_bus_send(client, m, NULL) >= 0);
+                }
+
+                assert_se(sd_bus_flush(client) >= 0);
+
+                for (;;)
+                        assert_se(sd_bus_wait(client, UINT64_MAX) >= 0);
+        }
+
+        fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK|SOCK_CLOEXEC);
+        assert_se(fd >= 0);
+
+        assert_se(sd_id128_randomize(&id) >= 0);
+        assert_se(sd_bus_new(&server) >= 0);
+        assert_se(sd_bus_set_fd(server, fd, fd) >= 0);
+        TAKE_FD(fd);
+        assert_se(sd_bus_set_server(server, true, id) >= 0);
+        assert_se(sd_bus_set_anonymous(server, true) >= 0);
+        assert_se(sd_bus_negotiate_creds(server, true, SD_BUS_CREDS_PID) >= 0);
+        assert_se(bus_peer_creds_cache_set_enabled(server, true) >= 0);
+        assert_se(sd_bus_add_filter(server, NULL, filter, calls) >= 0);
+        assert_se(sd_bus_start(server) >= 0);
+
+        while (!calls[N_CALLS-1]) {
+                r = sd_bus_process(server, NULL);
+                assert_se(r >= 0);
+                if (r == 0)
+                        assert_se(sd_bus_wait(server, UINT64_MAX) >= 0);
+        }
+
+        /* The first call fills the cache, the second one is served from it */
+        for (size_t i = 0; i < N_CALLS - 1; i++) {
+                _cleanup_(sd_bus_creds_unrefp) sd_bus_creds *c = NULL;
+                char **l;
+
+                assert_se(sd_bus_query_sender_creds(calls[i], SD_BUS_CREDS_PID|SD_BUS_CREDS_CMDLINE|SD_BUS_CREDS_AUGMENT, &c) >= 0);
+                assert_se(sd_bus_creds_get_augmented_mask(c) & SD_BUS_CREDS_CMDLINE);
+                assert_se(sd_bus_creds_get_cmdline(c, &l) >= 0);
+
+                if (!server->peer_creds) {
+                        log_notice("pidfds not available, skipping remaining checks.");
+                        goto finish;
+                }
+
+                assert_se(server->peer_creds->pid == pid);
+
+                if (first)
+                        assert_se(strv_equal(first, l));
+                else
+                        assert_se(first = strv_copy(l));
+        }
+
+        /* Once the peer is gone, so is the cache */
+        assert_se(kill(pid, SIGKILL) >= 0);
+        assert_se(wait_for_terminate(pid, NULL) >= 0);
+        pid = 0;
+
+        {
+                _cleanup_(sd_bus_creds_unrefp) sd_bus_creds *c = NULL;
+
+                assert_se(sd_bus_query_sender_creds(calls[N_CALLS-1], SD_BUS_CREDS_PID|SD_BUS_CREDS_CMDLINE|SD_BUS_CREDS_AUGMENT, &c) >= 0);
+                assert_se(!(sd_bus_creds_get_mask(c) & SD_BUS_CREDS_CMDLINE));
+                assert_se(!server->peer_creds);
+                assert_se(server->peer_pidfd < 0);
+        }
+
+finish:
+        if (pid > 0) {
+                (void) kill(pid, SIGKILL);
+                (void) wait_for_terminate(pid, NULL);
+        }
+
+        strv_free(first);
+        for (size_t i = 0; i < N_CALLS; i++)
+                sd_bus_message_unref(calls[i]);
+}
 
 int main(int argc, char *argv[]) {
         _cleanup_(sd_bus_creds_unrefp) sd_bus_creds *creds = NULL;
@@ -30,5 +178,7 @@ int main(int argc, char *argv[]) {
                 bus_creds_dump(creds, NULL, true);
         }
 
+        test_peer_creds_cache();
+
         return 0;
 }
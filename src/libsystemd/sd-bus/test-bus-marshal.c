@@ -105,6 +105,49 @@ static void test_bus_label_escape(void) {
         test_bus_label_escape_one(":1", "_3a1");
 }
 
+static void test_lazy_signature_one(char signature, int expected) {
+        _cleanup_(sd_bus_message_unrefp) sd_bus_message *m = NULL;
+        _cleanup_(sd_bus_unrefp) sd_bus *bus = NULL;
+        const uint8_t blob[] = {
+                /* Fixed header: little endian method call, version 1, 4 bytes of body, serial 1, 39 bytes
+                 * of header fields */
+                'l', 1, 0, 1, 4, 0, 0, 0, 1, 0, 0, 0, 39, 0, 0, 0,
+                /* PATH "/" */
+                1, 1, 'o', 0, 1, 0, 0, 0, '/', 0, 0, 0, 0, 0, 0, 0,
+                /* MEMBER "Foo" */
+                3, 1, 's', 0, 3, 0, 0, 0, 'F', 'o', 'o', 0, 0, 0, 0, 0,
+                /* SIGNATURE */
+                8, 1, 'g', 0, 1, signature, 0, 0,
+                /* Body */
+                42, 0, 0, 0,
+        };
+        void *buffer;
+        uint32_t u;
+
+        log_info("/* %s(%c) */", __func__, signature);
+
+        assert_se(sd_bus_new(&bus) >= 0);
+        assert_se(buffer = memdup(blob, sizeof(blob)));
+
+        /* The body signature is only validated when the body is accessed */
+        assert_se(bus_message_from_malloc(bus, buffer, sizeof(blob), NULL, 0, NULL, &m) >= 0);
+        assert_se(streq(sd_bus_message_get_member(m), "Foo"));
+
+        assert_se(sd_bus_message_read_basic(m, 'u', &u) == expected);
+        if (expected > 0) {
+                assert_se(u == 42);
+                assert_se(streq(sd_bus_message_get_signature(m, true), "u"));
+        } else {
+                assert_se(sd_bus_message_peek_type(m, NULL, NULL) == expected);
+                assert_se(!sd_bus_message_get_signature(m, true));
+        }
+}
+
+static void test_lazy_signature(void) {
+        test_lazy_signature_one('u', 1);
+        test_lazy_signature_one('}', -EBADMSG);
+}
+
 int main(int argc, char *argv[]) {
         _cleanup_(sd_bus_message_unrefp) sd_bus_message *m = NULL, *copy = NULL;
         int r, boolean;
@@ -124,6 +167,8 @@ int main(int argc, char *argv[]) {
 
         test_setup_logging(LOG_INFO);
 
+        test_lazy_signature();
+
         r = sd_bus_default_user(&bus);
         if (r < 0)
                 r = sd_bus_default_system(&bus);
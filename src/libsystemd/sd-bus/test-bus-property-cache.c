@@ -0,0 +1,243 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <sys/socket.h>
+
+#include "sd-bus.h"
+
+#include "bus-internal.h"
+#include "bus-objects.h"
+#include "string-util.h"
+#include "strv.h"
+#include "tests.h"
+
+typedef struct Object {
+        const char *name;
+        uint32_t counter;
+        unsigned n_name_calls;
+        unsigned n_counter_calls;
+} Object;
+
+static int property_get_name(
+                sd_bus *bus,
+                const char *path,
+                const char *interface,
+                const char *property,
+                sd_bus_message *reply,
+                void *userdata,
+                sd_bus_error *error) {
+
+        Object *o = userdata;
+
+        o->n_name_calls++;
+        return sd_bus_message_append(reply, "s", o->name);
+}
+
+static int property_get_counter(
+                sd_bus *bus,
+                const char *path,
+                const char *interface,
+                const char *property,
+                sd_bus_message *reply,
+                void *userdata,
+                sd_bus_error *error) {
+
+        Object *o = userdata;
+
+        o->n_counter_calls++;
+        return sd_bus_message_append(reply, "u", o->counter);
+}
+
+static const sd_bus_vtable vtable[] = {
+        SD_BUS_VTABLE_START(0),
+        SD_BUS_PROPERTY("Name", "s", property_get_name, 0, SD_BUS_VTABLE_PROPERTY_CONST),
+        SD_BUS_PROPERTY("Counter", "u", property_get_counter, 0, SD_BUS_VTABLE_PROPERTY_EMITS_CHANGE),
+        SD_BUS_PROPERTY("Explicit", "s", property_get_name, 0, SD_BUS_VTABLE_PROPERTY_CONST|SD_BUS_VTABLE_PROPERTY_EXPLICIT),
+        SD_BUS_VTABLE_END
+};
+
+static int reply_handler(sd_bus_message *m, void *userdata, sd_bus_error *error) {
+        sd_bus_message **reply = userdata;
+
+        *reply = sd_bus_message_ref(m);
+        return 0;
+}
+
+static void get_all(sd_bus *server, sd_bus *client, const char *expected_name, uint32_t expected_counter) {
+        _cleanup_(sd_bus_message_unrefp) sd_bus_message *reply = NULL;
+        bool seen_name = false, seen_counter = false;
+        const char *name;
+
+        assert_se(sd_bus_call_method_async(client, NULL, NULL, "/test", "org.freedesktop.DBus.Properties", "GetAll",
+                                           reply_handler, &reply, "s", "org.freedesktop.systemd.test") >= 0);
+
+        while (!reply) {
+                int r;
+
+                r = sd_bus_process(client, NULL);
+                assert_se(r >= 0);
+                if (r > 0)
+                        continue;
+
+                r = sd_bus_process(server, NULL);
+                assert_se(r >= 0);
+                if (r == 0)
+                        assert_se(sd_bus_wait(client, 100 * USEC_PER_MSEC) >= 0);
+        }
+
+        assert_se(!sd_bus_message_is_method_error(reply, NULL));
+        assert_se(sd_bus_message_enter_container(reply, 'a', "{sv}") > 0);
+
+        while (sd_bus_message_enter_container(reply, 'e', "sv") > 0) {
+                assert_se(sd_bus_message_read(reply, "s", &name) >= 0);
+
+                if (streq(name, "Name")) {
+                        const char *s;
+
+                        assert_se(!seen_name);
+                        assert_se(sd_bus_message_read(reply, "v", "s", &s) >= 0);
+                        assert_se(streq(s, expected_name));
+                        seen_name = true;
+                } else if (streq(name, "Counter")) {
+                        uint32_t u;
+
+                        assert_se(!seen_counter);
+                        assert_se(sd_bus_message_read(reply, "v", "u", &u) >= 0);
+                        assert_se(u == expected_counter);
+                        seen_counter = true;
+                } else
+                        assert_not_reached("Unexpected property");
+
+                assert_se(sd_bus_message_exit_container(reply) >= 0);
+        }
+
+        assert_se(sd_bus_message_exit_container(reply) >= 0);
+        assert_se(seen_name && seen_counter);
+}
+
+static void test_append_object_properties(sd_bus *server, Object *o) {
+        _cleanup_(sd_bus_error_free) sd_bus_error error = SD_BUS_ERROR_NULL;
+        _cleanup_(sd_bus_message_unrefp) sd_bus_message *m = NULL;
+        const char *path, *interface, *name, *s;
+        uint32_t u;
+
+        log_info("/* %s */", __func__);
+
+        assert_se(sd_bus_message_new(server, &m, SD_BUS_MESSAGE_METHOD_RETURN) >= 0);
+        assert_se(sd_bus_message_open_container(m, 'a', "{oa{sa{sv}}}") >= 0);
+        assert_se(bus_message_append_object_properties(server, m, "/test", STRV_MAKE("Counter", "Explicit", "Foo"), &error) >= 0);
+        assert_se(bus_message_append_object_properties(server, m, "/nonexistent", NULL, &error) >= 0);
+        assert_se(sd_bus_message_close_container(m) >= 0);
+        assert_se(sd_bus_message_seal(m, 1, 0) >= 0);
+
+        /* Only the requested properties are included, and so are explicit ones */
+        assert_se(sd_bus_message_enter_container(m, 'a', "{oa{sa{sv}}}") > 0);
+        assert_se(sd_bus_message_enter_container(m, 'e', "oa{sa{sv}}") > 0);
+        assert_se(sd_bus_message_read(m, "o", &path) >= 0);
+        assert_se(streq(path, "/test"));
+        assert_se(sd_bus_message_enter_container(m, 'a', "{sa{sv}}") > 0);
+        assert_se(sd_bus_message_enter_container(m, 'e', "sa{sv}") > 0);
+        assert_se(sd_bus_message_read(m, "s", &interface) >= 0);
+        assert_se(streq(interface, "org.freedesktop.systemd.test"));
+        assert_se(sd_bus_message_enter_container(m, 'a', "{sv}") > 0);
+        assert_se(sd_bus_message_read(m, "{sv}", &name, "u", &u) >= 0);
+        assert_se(streq(name, "Counter"));
+        assert_se(u == o->counter);
+        assert_se(sd_bus_message_read(m, "{sv}", &name, "s", &s) >= 0);
+        assert_se(streq(name, "Explicit"));
+        assert_se(streq(s, o->name));
+        assert_se(sd_bus_message_at_end(m, false) > 0);
+        assert_se(sd_bus_message_exit_container(m) >= 0);
+        assert_se(sd_bus_message_exit_container(m) >= 0);
+        assert_se(sd_bus_message_at_end(m, false) > 0);
+        assert_se(sd_bus_message_exit_container(m) >= 0);
+        assert_se(sd_bus_message_exit_container(m) >= 0);
+        assert_se(sd_bus_message_at_end(m, false) > 0);
+}
+
+static void test_property_cache(bool enabled) {
+        _cleanup_(sd_bus_slot_unrefp) sd_bus_slot *slot = NULL;
+        _cleanup_(sd_bus_flush_close_unrefp) sd_bus *server = NULL, *client = NULL;
+        Object o = {
+                .name = "foo",
+        };
+        int pair[2] = { -1, -1 };
+        sd_id128_t id;
+
+        log_info("/* %s(enabled=%s) */", __func__, yes_no(enabled));
+
+        assert_se(socketpair(AF_UNIX, SOCK_STREAM|SOCK_CLOEXEC|SOCK_NONBLOCK, 0, pair) >= 0);
+        assert_se(sd_id128_randomize(&id) >= 0);
+
+        assert_se(sd_bus_new(&server) >= 0);
+        assert_se(sd_bus_set_fd(server, pair[0], pair[0]) >= 0);
+        assert_se(sd_bus_set_server(server, true, id) >= 0);
+        assert_se(sd_bus_set_anonymous(server, true) >= 0);
+        assert_se(sd_bus_start(server) >= 0);
+
+        assert_se(sd_bus_new(&client) >= 0);
+        assert_se(sd_bus_set_fd(client, pair[1], pair[1]) >= 0);
+        assert_se(sd_bus_set_anonymous(client, true) >= 0);
+        assert_se(sd_bus_start(client) >= 0);
+
+        while (!sd_bus_is_ready(server) || !sd_bus_is_ready(client)) {
+                assert_se(sd_bus_process(client, NULL) >= 0);
+                assert_se(sd_bus_process(server, NULL) >= 0);
+        }
+
+        assert_se(bus_property_cache_set_enabled(server, enabled) >= 0);
+        assert_se(sd_bus_add_object_vtable(server, &slot, "/test", "org.freedesktop.systemd.test", vtable, &o) >= 0);
+
+        get_all(server, client, "foo", 0);
+        assert_se(o.n_name_calls == 1);
+        assert_se(o.n_counter_calls == 1);
+
+        /* Constant properties are served from the cache, everything else is still looked up */
+        o.counter = 1;
+        get_all(server, client, "foo", 1);
+        assert_se(o.n_name_calls == (enabled ? 1 : 2));
+        assert_se(o.n_counter_calls == 2);
+
+        /* Changes signalled on the interface drop the cached values */
+        o.name = "bar";
+        o.counter = 2;
+        assert_se(sd_bus_emit_properties_changed(server, "/test", "org.freedesktop.systemd.test", "Counter", NULL) >= 0);
+        get_all(server, client, "bar", 2);
+        assert_se(o.n_name_calls == (enabled ? 2 : 3));
+        assert_se(o.n_counter_calls == 4); /* one more for the signal */
+
+        /* Changes signalled on other interfaces don't */
+        o.name = "baz";
+        assert_se(sd_bus_emit_properties_changed(server, "/test", "org.freedesktop.systemd.other", "Counter", NULL) == -ENOENT);
+        get_all(server, client, enabled ? "bar" : "baz", 2);
+        assert_se(o.n_name_calls == (enabled ? 2 : 4));
+
+        /* Explicit invalidation */
+        bus_property_cache_invalidate(server, "/test", NULL);
+        get_all(server, client, "baz", 2);
+        assert_se(o.n_name_calls == (enabled ? 3 : 5));
+
+        o.name = "waldo";
+        bus_property_cache_invalidate(server, NULL, NULL);
+        get_all(server, client, "waldo", 2);
+        assert_se(o.n_name_calls == (enabled ? 4 : 6));
+        assert_se(hashmap_size(server->property_cache) == enabled);
+
+        /* Removing the vtable flushes everything, the cache must not refer to it anymore */
+        slot = sd_bus_slot_unref(slot);
+        assert_se(hashmap_isempty(server->property_cache));
+
+        assert_se(sd_bus_add_object_vtable(server, &slot, "/test", "org.freedesktop.systemd.test", vtable, &o) >= 0);
+        get_all(server, client, "waldo", 2);
+        assert_se(o.n_name_calls == (enabled ? 5 : 7));
+
+        test_append_object_properties(server, &o);
+}
+
+int main(int argc, char *argv[]) {
+        test_setup_logging(LOG_INFO);
+
+        test_property_cache(false);
+        test_property_cache(true);
+
+        return 0;
+}
@@ -0,0 +1,117 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <fcntl.h>
+#include <sys/socket.h>
+
+#include "sd-bus.h"
+
+#include "bus-internal.h"
+#include "fd-util.h"
+#include "string-util.h"
+#include "tests.h"
+
+#define N_MESSAGES 4000U
+#define FD_EVERY 97U
+#define PAYLOAD_SIZE 4096U
+
+static void test_queue_batch(bool fds) {
+        _cleanup_(sd_bus_flush_close_unrefp) sd_bus *server = NULL, *client = NULL;
+        _cleanup_close_ int null_fd = -1;
+        _cleanup_free_ char *payload = NULL;
+        int pair[2] = { -1, -1 };
+        unsigned received = 0;
+        uint64_t n_queued;
+        sd_id128_t id;
+        int r;
+
+        log_info("/* %s(fds=%s) */", __func__, yes_no(fds));
+
+        assert_se(socketpair(AF_UNIX, SOCK_STREAM|SOCK_CLOEXEC|SOCK_NONBLOCK, 0, pair) >= 0);
+        assert_se((null_fd = open("/dev/null", O_RDONLY|O_CLOEXEC)) >= 0);
+        assert_se(sd_id128_randomize(&id) >= 0);
+
+        assert_se(sd_bus_new(&server) >= 0);
+        assert_se(sd_bus_set_fd(server, pair[0], pair[0]) >= 0);
+        assert_se(sd_bus_set_server(server, true, id) >= 0);
+        assert_se(sd_bus_set_anonymous(server, true) >= 0);
+        assert_se(sd_bus_negotiate_fds(server, fds) >= 0);
+        assert_se(sd_bus_start(server) >= 0);
+
+        assert_se(sd_bus_new(&client) >= 0);
+        assert_se(sd_bus_set_fd(client, pair[1], pair[1]) >= 0);
+        assert_se(sd_bus_set_anonymous(client, true) >= 0);
+        assert_se(sd_bus_negotiate_fds(client, fds) >= 0);
+        assert_se(sd_bus_start(client) >= 0);
+
+        /* Finish authentication */
+        while (!sd_bus_is_ready(server) || !sd_bus_is_ready(client)) {
+                assert_se(sd_bus_process(client, NULL) >= 0);
+                assert_se(sd_bus_process(server, NULL) >= 0);
+        }
+        assert_se((sd_bus_can_send(client, 'h') > 0) == fds);
+
+        /* Send more than the socket buffers can take without reading anything, so that most of the messages
+         * end up in the write queue, and are written and read in batches later on. */
+        assert_se(payload = malloc(PAYLOAD_SIZE + 1));
+        memset(payload, 'x', PAYLOAD_SIZE);
+        payload[PAYLOAD_SIZE] = 0;
+
+        for (unsigned i = 0; i < N_MESSAGES; i++) {
+                _cleanup_(sd_bus_message_unrefp) sd_bus_message *m = NULL;
+
+                assert_se(sd_bus_message_new_signal(client, &m, "/test", "org.freedesktop.systemd.test", "Batch") >= 0);
+                assert_se(sd_bus_message_append(m, "us", i, payload) >= 0);
+                if (fds && i % FD_EVERY == 0)
+                        assert_se(sd_bus_message_append(m, "h", null_fd) >= 0);
+                assert_se(sd_bus_send(client, m, NULL) >= 0);
+        }
+
+        assert_se(sd_bus_get_n_queued_write(client, &n_queued) >= 0);
+        log_info("%" PRIu64 " messages queued", n_queued);
+        assert_se(n_queued > 0);
+
+        while (received < N_MESSAGES) {
+                _cleanup_(sd_bus_message_unrefp) sd_bus_message *m = NULL;
+                const char *s;
+                unsigned i;
+
+                assert_se(sd_bus_process(client, NULL) >= 0);
+
+                r = sd_bus_process(server, &m);
+                assert_se(r >= 0);
+                if (r == 0)
+                        assert_se(sd_bus_wait(server, 100 * USEC_PER_MSEC) >= 0);
+                if (!m)
+                        continue;
+
+                assert_se(sd_bus_message_is_signal(m, "org.freedesktop.systemd.test", "Batch"));
+
+                /* Messages arrive in order, and fds with the message they were sent with */
+                assert_se(sd_bus_message_read(m, "us", &i, &s) >= 0);
+                assert_se(i == received);
+                assert_se(streq(s, payload));
+
+                if (fds && i % FD_EVERY == 0) {
+                        int fd;
+
+                        assert_se(streq(sd_bus_message_get_signature(m, true), "ush"));
+                        assert_se(sd_bus_message_read(m, "h", &fd) >= 0);
+                        assert_se(fcntl(fd, F_GETFD) >= 0);
+                } else
+                        assert_se(streq(sd_bus_message_get_signature(m, true), "us"));
+
+                received++;
+        }
+
+        assert_se(sd_bus_get_n_queued_write(client, &n_queued) >= 0);
+        assert_se(n_queued == 0);
+}
+
+int main(int argc, char *argv[]) {
+        test_setup_logging(LOG_INFO);
+
+        test_queue_batch(false);
+        test_queue_batch(true);
+
+        return 0;
+}
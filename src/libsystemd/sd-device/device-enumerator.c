@@ -391,6 +391,11 @@ static int enumerator_scan_dir_and_add_devices(sd_device_enumerator *enumerator,
                         continue;
                 }
 
+                /* Check this first, as it only needs the syspath, while the checks below need to read the
+                 * udev database or the uevent file. */
+                if (!device_match_parent(device, enumerator->match_parent, NULL))
+                        continue;
+
                 initialized = sd_device_get_is_initialized(device);
                 if (initialized < 0) {
                         if (initialized != -ENOENT)
@@ -416,9 +421,6 @@ static int enumerator_scan_dir_and_add_devices(sd_device_enumerator *enumerator,
                      sd_device_get_ifindex(device, NULL) >= 0))
                         continue;
 
-                if (!device_match_parent(device, enumerator->match_parent, NULL))
-                        continue;
-
                 if (!match_tag(enumerator, device))
                         continue;
 
@@ -634,6 +636,7 @@ static int parent_crawl_children(sd_device_enumerator *enumerator, const char *p
 
         FOREACH_DIRENT_ALL(dent, dir, return -errno) {
                 _cleanup_free_ char *child = NULL;
+                char uevent[strlen(dent->d_name) + STRLEN("/uevent") + 1];
                 int k;
 
                 if (dent->d_name[0] == '.')
@@ -646,9 +649,16 @@ static int parent_crawl_children(sd_device_enumerator *enumerator, const char *p
                 if (!child)
                         return -ENOMEM;
 
-                k = parent_add_child(enumerator, child);
-                if (k < 0)
-                        r = k;
+                /* Most directories below a device are not devices themselves (e.g. "power/" or "queue/").
+                 * Check for the uevent file relative to the already opened directory, before resolving the
+                 * full path of the child. We still need to descend into them, though, as they may contain
+                 * devices, e.g. "net/". */
+                (void) sprintf(uevent, "%s/uevent", dent->d_name);
+                if (faccessat(dirfd(dir), uevent, F_OK, AT_SYMLINK_NOFOLLOW) >= 0 || errno != ENOENT) {
+                        k = parent_add_child(enumerator, child);
+                        if (k < 0)
+                                r = k;
+                }
 
                 if (maxdepth > 0)
                         parent_crawl_children(enumerator, child, maxdepth - 1);
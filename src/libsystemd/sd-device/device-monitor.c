@@ -51,6 +51,9 @@ struct sd_device_monitor {
 
 #define UDEV_MONITOR_MAGIC                0xfeedcafe
 
+/* Maximum number of devices to receive and dispatch in one event loop iteration */
+#define DEVICE_MONITOR_RECEIVE_BATCH_MAX  16U
+
 typedef struct monitor_netlink_header {
         /* "libudev" prefix to distinguish libudev and kernel messages */
         char prefix[8];
@@ -226,16 +229,38 @@ _public_ int sd_device_monitor_stop(sd_device_monitor *m) {
 }
 
 static int device_monitor_event_handler(sd_event_source *s, int fd, uint32_t revents, void *userdata) {
-        _cleanup_(sd_device_unrefp) sd_device *device = NULL;
-        sd_device_monitor *m = userdata;
+        _cleanup_(sd_device_monitor_unrefp) sd_device_monitor *m = NULL;
 
-        assert(m);
+        assert(userdata);
 
-        if (device_monitor_receive_device(m, &device) <= 0)
-                return 0;
+        /* The callback might drop the last reference to the monitor, keep it around until we are done */
+        m = sd_device_monitor_ref(userdata);
+
+        /* During storms (think coldplug) going back to the event loop for every single uevent is costly, and
+         * makes it more likely that the socket's receive buffer overruns. Hence, process a couple of
+         * messages in one go, but not too many, to not starve other event sources. */
+        for (unsigned n = 0; n < DEVICE_MONITOR_RECEIVE_BATCH_MAX; n++) {
+                _cleanup_(sd_device_unrefp) sd_device *device = NULL;
+                int r, code;
 
-        if (m->callback)
-                return m->callback(m, device, m->userdata);
+                r = device_monitor_receive_device(m, &device);
+                if (r < 0)
+                        break;
+                if (r == 0)
+                        continue;
+
+                if (m->callback) {
+                        r = m->callback(m, device, m->userdata);
+                        if (r < 0)
+                                return r;
+                }
+
+                /* Stop if the callback stopped or disabled us, or asked the event loop to exit */
+                if (!m->event_source ||
+                    sd_event_source_get_enabled(m->event_source, NULL) <= 0 ||
+                    sd_event_get_exit_code(m->event, &code) >= 0)
+                        break;
+        }
 
         return 0;
 }
@@ -445,7 +470,10 @@ int device_monitor_receive_device(sd_device_monitor *m, sd_device **ret) {
 
         buflen = recvmsg(m->sock, &smsg, 0);
         if (buflen < 0) {
-                if (errno != EINTR)
+                if (errno == ENOBUFS)
+                        log_debug_errno(errno, "sd-device-monitor: Receive buffer overrun, some events have been lost. "
+                                        "Consider increasing the receive buffer size.");
+                else if (!IN_SET(errno, EINTR, EAGAIN))
                         log_debug_errno(errno, "sd-device-monitor: Failed to receive message: %m");
                 return -errno;
         }
@@ -16,6 +16,7 @@
 #include "fileio.h"
 #include "fs-util.h"
 #include "hashmap.h"
+#include "io-util.h"
 #include "macro.h"
 #include "parse-util.h"
 #include "path-util.h"
@@ -2038,7 +2039,9 @@ _public_ int sd_device_set_sysattr_valuef(sd_device *device, const char *sysattr
 }
 
 _public_ int sd_device_trigger(sd_device *device, sd_device_action_t action) {
-        const char *s;
+        _cleanup_close_ int fd = -1;
+        const char *s, *syspath, *path;
+        int r;
 
         assert_return(device, -EINVAL);
 
@@ -2046,5 +2049,26 @@ _public_ int sd_device_trigger(sd_device *device, sd_device_action_t action) {
         if (!s)
                 return -EINVAL;
 
-        return sd_device_set_sysattr_value(device, "uevent", s);
+        /* This is called for every device on coldplug, hence write the action directly instead of going
+         * through sd_device_set_sysattr_value(), which copies the value and sets up a FILE stream for
+         * it. The action string written to "uevent" is never cached anyway. */
+
+        r = sd_device_get_syspath(device, &syspath);
+        if (r < 0)
+                return r;
+
+        path = prefix_roota(syspath, "uevent");
+
+        fd = open(path, O_WRONLY|O_CLOEXEC|O_NOCTTY|O_NOFOLLOW);
+        if (fd < 0)
+                r = -errno;
+        else
+                r = loop_write(fd, s, strlen(s), false);
+        if (r < 0) {
+                /* On failure, clear cache entry, as we do not know how it fails. */
+                device_remove_cached_sysattr_value(device, "uevent");
+                return r;
+        }
+
+        return 0;
 }
@@ -80,6 +80,19 @@ struct sd_event_source {
          * effectively become one when rate-limited, this is part of the common fields. */
         unsigned earliest_index;
         unsigned latest_index;
+        /* The times the two prioqs are ordered by. They may lag behind when a timer is moved to a later time,
+         * see event_source_time_prioq_peek(). */
+        usec_t earliest_key;
+        usec_t latest_key;
+
+        /* Only maintained if $SD_EVENT_STATISTICS is set */
+        struct {
+                uint64_t n_dispatched;
+                usec_t cpu_usec;
+                usec_t max_dispatch_usec;
+                usec_t max_latency_usec;
+                usec_t ready_usec; /* when the source last became pending */
+        } statistics;
 
         union {
                 struct {
@@ -89,6 +102,7 @@ struct sd_event_source {
                         uint32_t revents;
                         bool registered:1;
                         bool owned:1;
+                        bool lingering:1; /* still in the epoll set while a oneshot source is dispatched */
                 } io;
                 struct {
                         sd_event_time_handler_t callback;
@@ -2,6 +2,7 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stdio.h>
 
 #include "sd-event.h"
 
@@ -11,3 +12,5 @@ int event_reset_time(sd_event *e, sd_event_source **s,
                      int64_t priority, const char *description, bool force_reset);
 int event_source_disable(sd_event_source *s);
 int event_source_is_enabled(sd_event_source *s);
+
+void event_dump_statistics(sd_event *e, FILE *f, const char *prefix);
@@ -11,6 +11,7 @@
 #include "alloc-util.h"
 #include "env-util.h"
 #include "event-source.h"
+#include "event-util.h"
 #include "fd-util.h"
 #include "fs-util.h"
 #include "hashmap.h"
@@ -133,6 +134,7 @@ struct sd_event {
         bool need_process_child:1;
         bool watchdog:1;
         bool profile_delays:1;
+        bool statistics:1;
 
         int exit_code;
 
@@ -254,7 +256,7 @@ static int earliest_time_prioq_compare(const void *a, const void *b) {
                 return 1;
 
         /* Order by time */
-        return CMP(time_event_source_next(x), time_event_source_next(y));
+        return CMP(x->earliest_key, y->earliest_key);
 }
 
 static usec_t time_event_source_latest(const sd_event_source *s) {
@@ -291,7 +293,7 @@ static int latest_time_prioq_compare(const void *a, const void *b) {
                 return 1;
 
         /* Order by time */
-        return CMP(time_event_source_latest(x), time_event_source_latest(y));
+        return CMP(x->latest_key, y->latest_key);
 }
 
 static int exit_prioq_compare(const void *a, const void *b) {
@@ -411,6 +413,11 @@ _public_ int sd_event_new(sd_event** ret) {
                 e->profile_delays = true;
         }
 
+        if (secure_getenv("SD_EVENT_STATISTICS")) {
+                log_debug("Event source statistics enabled.");
+                e->statistics = true;
+        }
+
         *ret = e;
         return 0;
 
@@ -451,6 +458,7 @@ static void source_io_unregister(sd_event_source *s) {
                                 strna(s->description), event_source_type_to_string(s->type));
 
         s->io.registered = false;
+        s->io.lingering = false;
 }
 
 static int source_io_register(
@@ -473,6 +481,7 @@ static int source_io_register(
                 return -errno;
 
         s->io.registered = true;
+        s->io.lingering = false;
 
         return 0;
 }
@@ -787,11 +796,70 @@ static void event_source_time_prioq_reshuffle(sd_event_source *s) {
                 assert_se(d = event_get_clock_data(s->event, s->type));
         }
 
+        s->earliest_key = time_event_source_next(s);
+        s->latest_key = time_event_source_latest(s);
+
         prioq_reshuffle(d->earliest, s, &s->earliest_index);
         prioq_reshuffle(d->latest, s, &s->latest_index);
         d->needs_rearm = true;
 }
 
+static void event_source_time_prioq_update(sd_event_source *s) {
+        struct clock_data *d;
+
+        assert(s);
+        assert(EVENT_SOURCE_IS_TIME(s->type));
+
+        /* Called whenever the time or accuracy of a timer changed. Timers are commonly pushed into the
+         * future again and again before they elapse (think timeouts and watchdogs), hence if neither of the
+         * two times moved earlier we leave the prioqs alone: the keys they are ordered by stay lower
+         * bounds, and are only brought up-to-date once the event source shows up at the top of a prioq,
+         * see event_source_time_prioq_peek(). That makes re-arming a timer to a later time O(1). */
+
+        if (s->ratelimited ||
+            time_event_source_next(s) < s->earliest_key ||
+            time_event_source_latest(s) < s->latest_key) {
+                event_source_time_prioq_reshuffle(s);
+                return;
+        }
+
+        assert_se(d = event_get_clock_data(s->event, s->type));
+        d->needs_rearm = true;
+}
+
+static sd_event_source* event_source_time_prioq_peek(Prioq *q, bool latest) {
+        sd_event_source *s;
+
+        /* Returns the top of the earliest or latest prioq of a clock, after fixing up the ordering of
+         * event sources whose time was moved into the future since they were last placed, see
+         * event_source_time_prioq_update(). Each such event source is moved down only once, no matter how
+         * often it was re-armed in between. */
+
+        for (;;) {
+                usec_t t;
+
+                s = prioq_peek(q);
+                if (!s)
+                        return NULL;
+
+                if (latest) {
+                        t = time_event_source_latest(s);
+                        if (t == s->latest_key)
+                                return s;
+
+                        s->latest_key = t;
+                        prioq_reshuffle(q, s, &s->latest_index);
+                } else {
+                        t = time_event_source_next(s);
+                        if (t == s->earliest_key)
+                                return s;
+
+                        s->earliest_key = t;
+                        prioq_reshuffle(q, s, &s->earliest_index);
+                }
+        }
+}
+
 static void event_source_time_prioq_remove(
                 sd_event_source *s,
                 struct clock_data *d) {
@@ -1007,6 +1075,9 @@ static int source_set_pending(sd_event_source *s, bool b) {
         if (b) {
                 s->pending_iteration = s->event->iteration;
 
+                if (s->event->statistics)
+                        s->statistics.ready_usec = now(CLOCK_MONOTONIC);
+
                 r = prioq_put(s->event->pending, s, &s->pending_index);
                 if (r < 0) {
                         s->pending = false;
@@ -1205,6 +1276,9 @@ static int event_source_time_prioq_put(
         assert(s);
         assert(d);
 
+        s->earliest_key = time_event_source_next(s);
+        s->latest_key = time_event_source_latest(s);
+
         r = prioq_put(d->earliest, s, &s->earliest_index);
         if (r < 0)
                 return r;
@@ -2130,6 +2204,7 @@ _public_ int sd_event_source_set_io_fd(sd_event_source *s, int fd) {
                 return 0;
 
         if (event_source_is_offline(s)) {
+                source_io_unregister(s);
                 s->io.fd = fd;
                 s->io.registered = false;
         } else {
@@ -2373,7 +2448,8 @@ static int event_source_offline(
         switch (s->type) {
 
         case SOURCE_IO:
-                source_io_unregister(s);
+                if (!s->io.lingering)
+                        source_io_unregister(s);
                 break;
 
         case SOURCE_TIME_REALTIME:
@@ -2579,7 +2655,7 @@ _public_ int sd_event_source_set_time(sd_event_source *s, uint64_t usec) {
 
         s->time.next = usec;
 
-        event_source_time_prioq_reshuffle(s);
+        event_source_time_prioq_update(s);
         return 0;
 }
 
@@ -2629,7 +2705,7 @@ _public_ int sd_event_source_set_time_accuracy(sd_event_source *s, uint64_t usec
 
         s->time.accuracy = usec;
 
-        event_source_time_prioq_reshuffle(s);
+        event_source_time_prioq_update(s);
         return 0;
 }
 
@@ -2990,7 +3066,7 @@ static int event_arm_timer(
         else
                 d->needs_rearm = false;
 
-        a = prioq_peek(d->earliest);
+        a = event_source_time_prioq_peek(d->earliest, /* latest= */ false);
         if (!a || a->enabled == SD_EVENT_OFF || time_event_source_next(a) == USEC_INFINITY) {
 
                 if (d->fd < 0)
@@ -3007,7 +3083,7 @@ static int event_arm_timer(
                 return 0;
         }
 
-        b = prioq_peek(d->latest);
+        b = event_source_time_prioq_peek(d->latest, /* latest= */ true);
         assert_se(b && b->enabled != SD_EVENT_OFF);
 
         t = sleep_between(e, time_event_source_next(a), time_event_source_latest(b));
@@ -3087,7 +3163,7 @@ static int process_timer(
         assert(d);
 
         for (;;) {
-                s = prioq_peek(d->earliest);
+                s = event_source_time_prioq_peek(d->earliest, /* latest= */ false);
                 if (!s || time_event_source_next(s) > n)
                         break;
 
@@ -3452,6 +3528,7 @@ static int process_inotify(sd_event *e) {
 
 static int source_dispatch(sd_event_source *s) {
         _cleanup_(sd_event_unrefp) sd_event *saved_event = NULL;
+        usec_t begin_usec = USEC_INFINITY, begin_cpu_usec = USEC_INFINITY;
         EventSourceType saved_type;
         int r = 0;
 
@@ -3499,9 +3576,28 @@ static int source_dispatch(sd_event_source *s) {
         }
 
         if (s->enabled == SD_EVENT_ONESHOT) {
+                /* Oneshot IO sources are frequently re-enabled right from their handler. The kernel already
+                 * disarmed the fd when it reported it to us, and we won't call epoll_wait() before the
+                 * handler returns, hence leave it in the epoll set until then, so that re-enabling it takes
+                 * a single EPOLL_CTL_MOD instead of EPOLL_CTL_DEL followed by EPOLL_CTL_ADD. */
+                if (s->type == SOURCE_IO)
+                        s->io.lingering = s->io.registered;
+
                 r = sd_event_source_set_enabled(s, SD_EVENT_OFF);
-                if (r < 0)
+                if (r < 0) {
+                        if (s->type == SOURCE_IO)
+                                s->io.lingering = false;
                         return r;
+                }
+        }
+
+        if (saved_event->statistics) {
+                begin_usec = now(CLOCK_MONOTONIC);
+                begin_cpu_usec = now(CLOCK_THREAD_CPUTIME_ID);
+
+                if (s->statistics.ready_usec != 0 && begin_usec > s->statistics.ready_usec)
+                        s->statistics.max_latency_usec = MAX(s->statistics.max_latency_usec,
+                                                             begin_usec - s->statistics.ready_usec);
         }
 
         s->dispatching = true;
@@ -3582,6 +3678,17 @@ static int source_dispatch(sd_event_source *s) {
 
         s->dispatching = false;
 
+        if (saved_event->statistics) {
+                s->statistics.n_dispatched++;
+                s->statistics.cpu_usec += usec_sub_unsigned(now(CLOCK_THREAD_CPUTIME_ID), begin_cpu_usec);
+                s->statistics.max_dispatch_usec = MAX(s->statistics.max_dispatch_usec,
+                                                      usec_sub_unsigned(now(CLOCK_MONOTONIC), begin_usec));
+        }
+
+        /* The handler didn't re-enable the oneshot IO source, so now remove it from the epoll set for real */
+        if (saved_type == SOURCE_IO && s->io.lingering)
+                source_io_unregister(s);
+
         if (r < 0) {
                 log_debug_errno(r, "Event source %s (type %s) returned error, %s: %m",
                                 strna(s->description),
@@ -4448,3 +4555,54 @@ _public_ int sd_event_source_is_ratelimited(sd_event_source *s) {
 
         return s->ratelimited;
 }
+
+_public_ int sd_event_source_get_statistics(
+                sd_event_source *s,
+                uint64_t *ret_n_dispatched,
+                uint64_t *ret_cpu_usec,
+                uint64_t *ret_max_dispatch_usec,
+                uint64_t *ret_max_latency_usec) {
+
+        assert_return(s, -EINVAL);
+        assert_return(!event_pid_changed(s->event), -ECHILD);
+
+        if (!s->event->statistics)
+                return -ENODATA;
+
+        if (ret_n_dispatched)
+                *ret_n_dispatched = s->statistics.n_dispatched;
+        if (ret_cpu_usec)
+                *ret_cpu_usec = s->statistics.cpu_usec;
+        if (ret_max_dispatch_usec)
+                *ret_max_dispatch_usec = s->statistics.max_dispatch_usec;
+        if (ret_max_latency_usec)
+                *ret_max_latency_usec = s->statistics.max_latency_usec;
+
+        return 0;
+}
+
+void event_dump_statistics(sd_event *e, FILE *f, const char *prefix) {
+        sd_event_source *s;
+
+        assert(f);
+
+        if (!e || !e->statistics)
+                return;
+
+        LIST_FOREACH(sources, s, e->sources) {
+                char cpu[FORMAT_TIMESPAN_MAX], dispatch[FORMAT_TIMESPAN_MAX], latency[FORMAT_TIMESPAN_MAX];
+
+                if (s->statistics.n_dispatched == 0)
+                        continue;
+
+                fprintf(f,
+                        "%sEvent source %s (%s): dispatched %" PRIu64 " times, CPU %s, longest dispatch %s, longest latency %s\n",
+                        strempty(prefix),
+                        strna(s->description),
+                        strna(event_source_type_to_string(s->type)),
+                        s->statistics.n_dispatched,
+                        format_timespan(cpu, sizeof cpu, s->statistics.cpu_usec, 1),
+                        format_timespan(dispatch, sizeof dispatch, s->statistics.max_dispatch_usec, 1),
+                        format_timespan(latency, sizeof latency, s->statistics.max_latency_usec, 1));
+        }
+}
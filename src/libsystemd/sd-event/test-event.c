@@ -5,7 +5,9 @@
 #include "sd-event.h"
 
 #include "alloc-util.h"
+#include "event-util.h"
 #include "fd-util.h"
+#include "fileio.h"
 #include "fs-util.h"
 #include "log.h"
 #include "macro.h"
@@ -19,6 +21,7 @@
 #include "stdio-util.h"
 #include "string-util.h"
 #include "tests.h"
+#include "time-util.h"
 #include "tmpfile-util.h"
 #include "util.h"
 
@@ -694,6 +697,187 @@ static void test_ratelimit(void) {
         assert_se(count == 20);
 }
 
+static int oneshot_io_handler(sd_event_source *s, int fd, uint32_t revents, void *userdata) {
+        unsigned *c = (unsigned*) userdata;
+
+        assert_se(sd_event_source_get_enabled(s, NULL) == 0);
+
+        /* Re-arm ourselves the first two times only */
+        if (++(*c) < 3)
+                assert_se(sd_event_source_set_enabled(s, SD_EVENT_ONESHOT) >= 0);
+
+        return 0;
+}
+
+static void test_oneshot_io(void) {
+        _cleanup_close_pair_ int p[2] = {-1, -1};
+        _cleanup_(sd_event_unrefp) sd_event *e = NULL;
+        _cleanup_(sd_event_source_unrefp) sd_event_source *s = NULL;
+        unsigned count = 0;
+
+        log_info("/* %s */", __func__);
+
+        assert_se(sd_event_new(&e) >= 0);
+        assert_se(pipe2(p, O_CLOEXEC|O_NONBLOCK) >= 0);
+
+        assert_se(sd_event_add_io(e, &s, p[0], EPOLLIN, oneshot_io_handler, &count) >= 0);
+        assert_se(sd_event_source_set_enabled(s, SD_EVENT_ONESHOT) >= 0);
+
+        /* The pipe stays readable, hence the source is dispatched as long as it re-arms itself */
+        assert_se(write(p[1], "1", 1) == 1);
+
+        for (unsigned i = 0; i < 3; i++)
+                assert_se(sd_event_run(e, 0) > 0);
+        assert_se(count == 3);
+
+        /* Now it didn't, so it must not be dispatched anymore */
+        assert_se(sd_event_run(e, 0) == 0);
+        assert_se(count == 3);
+
+        /* Unless enabled again from the outside */
+        assert_se(sd_event_source_set_enabled(s, SD_EVENT_ONESHOT) >= 0);
+        assert_se(sd_event_run(e, 0) > 0);
+        assert_se(count == 4);
+        assert_se(sd_event_run(e, 0) == 0);
+
+        /* Moving a disabled source to another fd must not leave the old one behind */
+        assert_se(sd_event_source_set_io_fd(s, p[1]) >= 0);
+        assert_se(sd_event_source_set_io_events(s, EPOLLOUT) >= 0);
+        assert_se(sd_event_source_set_enabled(s, SD_EVENT_ONESHOT) >= 0);
+        assert_se(sd_event_run(e, 0) > 0);
+        assert_se(count == 5);
+        assert_se(sd_event_run(e, 0) == 0);
+}
+
+static int rearm_time_handler(sd_event_source *s, uint64_t usec, void *userdata) {
+        sd_event_source **last = userdata;
+
+        *last = s;
+        return 0;
+}
+
+static void test_time_rearm(void) {
+        _cleanup_(sd_event_unrefp) sd_event *e = NULL;
+        sd_event_source *sources[10000] = {}, *a = NULL, *b = NULL, *last = NULL;
+        char buf_later[FORMAT_TIMESPAN_MAX], buf_earlier[FORMAT_TIMESPAN_MAX];
+        usec_t base, t, t_later, t_earlier;
+
+        log_info("/* %s */", __func__);
+
+        assert_se(sd_event_new(&e) >= 0);
+        assert_se(sd_event_now(e, CLOCK_MONOTONIC, &base) >= 0);
+
+        for (size_t i = 0; i < ELEMENTSOF(sources); i++)
+                assert_se(sd_event_add_time(e, sources + i, CLOCK_MONOTONIC, base + USEC_PER_HOUR + i, 1,
+                                            rearm_time_handler, &last) >= 0);
+
+        /* Moving timers into the future is the common case (timeouts, watchdogs), and doesn't reorder the
+         * prioqs right away. Moving them into the past does. Compare the two. */
+        t = now(CLOCK_MONOTONIC);
+        for (unsigned k = 1; k <= 10; k++)
+                for (size_t i = 0; i < ELEMENTSOF(sources); i++)
+                        assert_se(sd_event_source_set_time(sources[i],
+                                                           base + USEC_PER_HOUR + k * ELEMENTSOF(sources) + i) >= 0);
+        t_later = now(CLOCK_MONOTONIC) - t;
+
+        t = now(CLOCK_MONOTONIC);
+        for (unsigned k = 1; k <= 10; k++)
+                for (size_t i = 0; i < ELEMENTSOF(sources); i++)
+                        assert_se(sd_event_source_set_time(sources[i],
+                                                           base + USEC_PER_HOUR - k * ELEMENTSOF(sources) - i) >= 0);
+        t_earlier = now(CLOCK_MONOTONIC) - t;
+
+        log_info("Re-armed %zu timers 10 times: %s later, %s earlier",
+                 ELEMENTSOF(sources),
+                 format_timespan(buf_later, sizeof buf_later, t_later, 1),
+                 format_timespan(buf_earlier, sizeof buf_earlier, t_earlier, 1));
+
+        /* Push everything into the far future, then let a single timer elapse, which must be the only one
+         * dispatched */
+        for (size_t i = 0; i < ELEMENTSOF(sources); i++)
+                assert_se(sd_event_source_set_time(sources[i], base + 2 * USEC_PER_HOUR + i) >= 0);
+        assert_se(sd_event_source_set_time(sources[4711], 1) >= 0);
+
+        assert_se(sd_event_run(e, 0) > 0);
+        assert_se(last == sources[4711]);
+        last = NULL;
+        assert_se(sd_event_run(e, 0) == 0);
+        assert_se(!last);
+
+        for (size_t i = 0; i < ELEMENTSOF(sources); i++)
+                sources[i] = sd_event_source_unref(sources[i]);
+
+        /* A timer that is at the top of the prioqs and gets pushed back must not determine the wakeup */
+        assert_se(sd_event_now(e, CLOCK_MONOTONIC, &base) >= 0);
+        assert_se(sd_event_add_time(e, &a, CLOCK_MONOTONIC, base + 10 * USEC_PER_MSEC, 1, rearm_time_handler, &last) >= 0);
+        assert_se(sd_event_add_time(e, &b, CLOCK_MONOTONIC, base + 50 * USEC_PER_MSEC, 1, rearm_time_handler, &last) >= 0);
+        assert_se(sd_event_source_set_time(a, base + USEC_PER_HOUR) >= 0);
+
+        assert_se(sd_event_run(e, UINT64_MAX) > 0);
+        assert_se(last == b);
+        assert_se(now(CLOCK_MONOTONIC) >= base + 50 * USEC_PER_MSEC);
+
+        a = sd_event_source_unref(a);
+        b = sd_event_source_unref(b);
+}
+
+static int statistics_defer_handler(sd_event_source *s, void *userdata) {
+        unsigned *c = (unsigned*) userdata;
+
+        /* Burn a little CPU time */
+        for (usec_t t = now(CLOCK_THREAD_CPUTIME_ID); now(CLOCK_THREAD_CPUTIME_ID) < t + 100;)
+                ;
+
+        if (++(*c) >= 3)
+                assert_se(sd_event_source_set_enabled(s, SD_EVENT_OFF) >= 0);
+
+        return 0;
+}
+
+static void test_statistics(void) {
+        _cleanup_(sd_event_unrefp) sd_event *e = NULL;
+        _cleanup_(sd_event_source_unrefp) sd_event_source *s = NULL;
+        _cleanup_free_ char *dump = NULL;
+        _cleanup_fclose_ FILE *f = NULL;
+        uint64_t n, cpu, dispatch, latency;
+        unsigned count = 0;
+        size_t size;
+
+        log_info("/* %s */", __func__);
+
+        /* Without $SD_EVENT_STATISTICS nothing is tracked */
+        assert_se(sd_event_new(&e) >= 0);
+        assert_se(sd_event_add_defer(e, &s, statistics_defer_handler, &count) >= 0);
+        assert_se(sd_event_source_get_statistics(s, &n, &cpu, &dispatch, &latency) == -ENODATA);
+        s = sd_event_source_unref(s);
+        e = sd_event_unref(e);
+
+        assert_se(setenv("SD_EVENT_STATISTICS", "1", 1) >= 0);
+        assert_se(sd_event_new(&e) >= 0);
+        assert_se(unsetenv("SD_EVENT_STATISTICS") >= 0);
+
+        assert_se(sd_event_add_defer(e, &s, statistics_defer_handler, &count) >= 0);
+        assert_se(sd_event_source_set_description(s, "test-statistics") >= 0);
+        assert_se(sd_event_source_set_enabled(s, SD_EVENT_ON) >= 0);
+        assert_se(sd_event_source_get_statistics(s, &n, &cpu, &dispatch, &latency) >= 0);
+        assert_se(n == 0 && cpu == 0 && dispatch == 0 && latency == 0);
+
+        while (count < 3)
+                assert_se(sd_event_run(e, 0) > 0);
+
+        assert_se(sd_event_source_get_statistics(s, &n, &cpu, &dispatch, &latency) >= 0);
+        assert_se(n == 3);
+        assert_se(cpu >= 300);
+        assert_se(dispatch >= 100);
+        log_info("dispatched %" PRIu64 " times, CPU %" PRIu64 "us, longest dispatch %" PRIu64 "us, longest latency %" PRIu64 "us",
+                 n, cpu, dispatch, latency);
+
+        assert_se(f = open_memstream_unlocked(&dump, &size));
+        event_dump_statistics(e, f, "-> ");
+        assert_se(fflush_and_check(f) >= 0);
+        assert_se(startswith(dump, "-> Event source test-statistics (defer): dispatched 3 times"));
+}
+
 static void test_simple_timeout(void) {
         _cleanup_(sd_event_unrefp) sd_event *e = NULL;
         usec_t f, t, some_time;
@@ -731,5 +915,11 @@ int main(int argc, char *argv[]) {
 
         test_ratelimit();
 
+        test_oneshot_io();
+
+        test_time_rearm();
+
+        test_statistics();
+
         return 0;
 }
@@ -35,6 +35,7 @@ struct sd_hwdb {
         OrderedHashmap *properties;
         Iterator properties_iterator;
         bool properties_modified;
+        char *properties_modalias; /* the modalias the properties were looked up for */
 };
 
 struct linebuf {
@@ -251,31 +252,35 @@ static int trie_search_f(sd_hwdb *hwdb, const char *search) {
                         i += p;
                 }
 
-                child = node_lookup_f(hwdb, node, '*');
-                if (child) {
-                        linebuf_add_char(&buf, '*');
-                        err = trie_fnmatch_f(hwdb, child, 0, &buf, search + i);
-                        if (err < 0)
-                                return err;
-                        linebuf_rem_char(&buf);
-                }
+                /* Children are sorted by character, glob children can only exist if the first one is not
+                 * beyond '[', which is the highest of the three. This saves three lookups for most nodes. */
+                if (node->children_count > 0 && trie_node_child(hwdb, node, 0)->c <= '[') {
+                        child = node_lookup_f(hwdb, node, '*');
+                        if (child) {
+                                linebuf_add_char(&buf, '*');
+                                err = trie_fnmatch_f(hwdb, child, 0, &buf, search + i);
+                                if (err < 0)
+                                        return err;
+                                linebuf_rem_char(&buf);
+                        }
 
-                child = node_lookup_f(hwdb, node, '?');
-                if (child) {
-                        linebuf_add_char(&buf, '?');
-                        err = trie_fnmatch_f(hwdb, child, 0, &buf, search + i);
-                        if (err < 0)
-                                return err;
-                        linebuf_rem_char(&buf);
-                }
+                        child = node_lookup_f(hwdb, node, '?');
+                        if (child) {
+                                linebuf_add_char(&buf, '?');
+                                err = trie_fnmatch_f(hwdb, child, 0, &buf, search + i);
+                                if (err < 0)
+                                        return err;
+                                linebuf_rem_char(&buf);
+                        }
 
-                child = node_lookup_f(hwdb, node, '[');
-                if (child) {
-                        linebuf_add_char(&buf, '[');
-                        err = trie_fnmatch_f(hwdb, child, 0, &buf, search + i);
-                        if (err < 0)
-                                return err;
-                        linebuf_rem_char(&buf);
+                        child = node_lookup_f(hwdb, node, '[');
+                        if (child) {
+                                linebuf_add_char(&buf, '[');
+                                err = trie_fnmatch_f(hwdb, child, 0, &buf, search + i);
+                                if (err < 0)
+                                        return err;
+                                linebuf_rem_char(&buf);
+                        }
                 }
 
                 if (search[i] == '\0') {
@@ -367,6 +372,7 @@ static sd_hwdb *hwdb_free(sd_hwdb *hwdb) {
                 munmap((void *)hwdb->map, hwdb->st.st_size);
         safe_fclose(hwdb->f);
         ordered_hashmap_free(hwdb->properties);
+        free(hwdb->properties_modalias);
         return mfree(hwdb);
 }
 
@@ -397,13 +403,27 @@ bool hwdb_validate(sd_hwdb *hwdb) {
 }
 
 static int properties_prepare(sd_hwdb *hwdb, const char *modalias) {
+        int r;
+
         assert(hwdb);
         assert(modalias);
 
+        /* Callers often query several keys for the same modalias in a row, hence don't search again if
+         * we already have the properties for it. */
+        if (streq_ptr(hwdb->properties_modalias, modalias))
+                return 0;
+
+        hwdb->properties_modalias = mfree(hwdb->properties_modalias);
         ordered_hashmap_clear(hwdb->properties);
         hwdb->properties_modified = true;
 
-        return trie_search_f(hwdb, modalias);
+        r = trie_search_f(hwdb, modalias);
+        if (r < 0)
+                return r;
+
+        /* Not being able to remember the modalias just means we'll search again next time */
+        hwdb->properties_modalias = strdup(modalias);
+        return 0;
 }
 
 _public_ int sd_hwdb_get(sd_hwdb *hwdb, const char *modalias, const char *key, const char **_value) {
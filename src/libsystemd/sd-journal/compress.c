@@ -17,6 +17,7 @@
 #endif
 
 #if HAVE_ZSTD
+#include <zdict.h>
 #include <zstd.h>
 #include <zstd_errors.h>
 #endif
@@ -38,6 +39,18 @@ DEFINE_TRIVIAL_CLEANUP_FUNC_FULL(LZ4F_compressionContext_t, LZ4F_freeCompression
 DEFINE_TRIVIAL_CLEANUP_FUNC_FULL(LZ4F_decompressionContext_t, LZ4F_freeDecompressionContext, NULL);
 #endif
 
+struct CompressionDictionary {
+        void *data;
+        size_t size;
+#if HAVE_ZSTD
+        /* The digested dictionaries and the compression context are set up lazily, as most users only ever
+         * need one direction */
+        ZSTD_CDict *cdict;
+        ZSTD_DDict *ddict;
+        ZSTD_CCtx *cctx;
+#endif
+};
+
 #if HAVE_ZSTD
 DEFINE_TRIVIAL_CLEANUP_FUNC_FULL(ZSTD_CCtx*, ZSTD_freeCCtx, NULL);
 DEFINE_TRIVIAL_CLEANUP_FUNC_FULL(ZSTD_DCtx*, ZSTD_freeDCtx, NULL);
@@ -66,6 +79,82 @@ static const char* const object_compressed_table[_OBJECT_COMPRESSED_MAX] = {
 
 DEFINE_STRING_TABLE_LOOKUP(object_compressed, int);
 
+int compression_dictionary_new(const void *data, size_t size, CompressionDictionary **ret) {
+#if HAVE_ZSTD
+        _cleanup_(compression_dictionary_freep) CompressionDictionary *d = NULL;
+
+        assert(data);
+        assert(ret);
+
+        if (size <= 0)
+                return -EINVAL;
+
+        d = new0(CompressionDictionary, 1);
+        if (!d)
+                return -ENOMEM;
+
+        d->data = memdup(data, size);
+        if (!d->data)
+                return -ENOMEM;
+
+        d->size = size;
+
+        *ret = TAKE_PTR(d);
+        return 0;
+#else
+        return -EPROTONOSUPPORT;
+#endif
+}
+
+CompressionDictionary* compression_dictionary_free(CompressionDictionary *d) {
+        if (!d)
+                return NULL;
+
+#if HAVE_ZSTD
+        ZSTD_freeCDict(d->cdict);
+        ZSTD_freeDDict(d->ddict);
+        ZSTD_freeCCtx(d->cctx);
+#endif
+
+        free(d->data);
+        return mfree(d);
+}
+
+int compression_dictionary_train(
+                const void *samples, const size_t *sample_sizes, size_t n_samples,
+                size_t max_size,
+                void **ret, size_t *ret_size) {
+#if HAVE_ZSTD
+        _cleanup_free_ void *buf = NULL;
+        size_t k;
+
+        assert(samples);
+        assert(sample_sizes);
+        assert(max_size > 0);
+        assert(ret);
+        assert(ret_size);
+
+        if (n_samples > UINT_MAX)
+                return -E2BIG;
+
+        buf = malloc(max_size);
+        if (!buf)
+                return -ENOMEM;
+
+        k = ZDICT_trainFromBuffer(buf, max_size, samples, sample_sizes, n_samples);
+        if (ZDICT_isError(k))
+                return log_debug_errno(SYNTHETIC_ERRNO(ENODATA),
+                                       "Failed to train ZSTD dictionary from %zu samples: %s",
+                                       n_samples, ZDICT_getErrorName(k));
+
+        *ret = TAKE_PTR(buf);
+        *ret_size = k;
+        return 0;
+#else
+        return -EPROTONOSUPPORT;
+#endif
+}
+
 int compress_blob_xz(const void *src, uint64_t src_size,
                      void *dst, size_t dst_alloc_size, size_t *dst_size) {
 #if HAVE_XZ
@@ -157,6 +246,43 @@ int compress_blob_zstd(
 #endif
 }
 
+int compress_blob_zstd_dictionary(
+                CompressionDictionary *d,
+                const void *src, uint64_t src_size,
+                void *dst, size_t dst_alloc_size, size_t *dst_size) {
+#if HAVE_ZSTD
+        size_t k;
+
+        assert(d);
+        assert(src);
+        assert(src_size > 0);
+        assert(dst);
+        assert(dst_alloc_size > 0);
+        assert(dst_size);
+
+        if (!d->cdict) {
+                d->cdict = ZSTD_createCDict(d->data, d->size, ZSTD_CLEVEL_DEFAULT);
+                if (!d->cdict)
+                        return -ENOMEM;
+        }
+
+        if (!d->cctx) {
+                d->cctx = ZSTD_createCCtx();
+                if (!d->cctx)
+                        return -ENOMEM;
+        }
+
+        k = ZSTD_compress_usingCDict(d->cctx, dst, dst_alloc_size, src, src_size, d->cdict);
+        if (ZSTD_isError(k))
+                return zstd_ret_to_errno(k);
+
+        *dst_size = k;
+        return 0;
+#else
+        return -EPROTONOSUPPORT;
+#endif
+}
+
 int decompress_blob_xz(const void *src, uint64_t src_size,
                        void **dst, size_t *dst_alloc_size, size_t* dst_size, size_t dst_max) {
 
@@ -257,12 +383,46 @@ int decompress_blob_lz4(const void *src, uint64_t src_size,
 #endif
 }
 
+#if HAVE_ZSTD
+static int zstd_ref_dictionary(ZSTD_DCtx *dctx, CompressionDictionary *d, const void *src, size_t src_size) {
+        size_t k;
+
+        assert(dctx);
+
+        /* Only frames that were compressed with a dictionary carry its ID. Frames without one must be
+         * decompressed without the dictionary, since it would also alter the initial decoder state. */
+        if (!d || ZSTD_getDictID_fromFrame(src, src_size) == 0)
+                return 0;
+
+        if (!d->ddict) {
+                d->ddict = ZSTD_createDDict(d->data, d->size);
+                if (!d->ddict)
+                        return -ENOMEM;
+        }
+
+        k = ZSTD_DCtx_refDDict(dctx, d->ddict);
+        if (ZSTD_isError(k))
+                return zstd_ret_to_errno(k);
+
+        return 0;
+}
+#endif
+
 int decompress_blob_zstd(
                 const void *src, uint64_t src_size,
                 void **dst, size_t *dst_alloc_size, size_t *dst_size, size_t dst_max) {
 
+        return decompress_blob_zstd_dictionary(NULL, src, src_size, dst, dst_alloc_size, dst_size, dst_max);
+}
+
+int decompress_blob_zstd_dictionary(
+                CompressionDictionary *d,
+                const void *src, uint64_t src_size,
+                void **dst, size_t *dst_alloc_size, size_t *dst_size, size_t dst_max) {
+
 #if HAVE_ZSTD
         uint64_t size;
+        int r;
 
         assert(src);
         assert(src_size > 0);
@@ -287,6 +447,10 @@ int decompress_blob_zstd(
         if (!dctx)
                 return -ENOMEM;
 
+        r = zstd_ref_dictionary(dctx, d, src, src_size);
+        if (r < 0)
+                return r;
+
         ZSTD_inBuffer input = {
                 .src = src,
                 .size = src_size,
@@ -310,11 +474,14 @@ int decompress_blob_zstd(
 #endif
 }
 
-int decompress_blob(
+int decompress_blob_full(
                 int compression,
+                CompressionDictionary *d,
                 const void *src, uint64_t src_size,
                 void **dst, size_t *dst_alloc_size, size_t* dst_size, size_t dst_max) {
 
+        /* Dictionaries are only defined for ZSTD, for the other algorithms the dictionary is ignored */
+
         if (compression == OBJECT_COMPRESSED_XZ)
                 return decompress_blob_xz(
                                 src, src_size,
@@ -324,7 +491,8 @@ int decompress_blob(
                                 src, src_size,
                                 dst, dst_alloc_size, dst_size, dst_max);
         else if (compression == OBJECT_COMPRESSED_ZSTD)
-                return decompress_blob_zstd(
+                return decompress_blob_zstd_dictionary(
+                                d,
                                 src, src_size,
                                 dst, dst_alloc_size, dst_size, dst_max);
         else
@@ -457,7 +625,19 @@ int decompress_startswith_zstd(
                 void **buffer, size_t *buffer_size,
                 const void *prefix, size_t prefix_len,
                 uint8_t extra) {
+
+        return decompress_startswith_zstd_dictionary(NULL, src, src_size, buffer, buffer_size, prefix, prefix_len, extra);
+}
+
+int decompress_startswith_zstd_dictionary(
+                CompressionDictionary *d,
+                const void *src, uint64_t src_size,
+                void **buffer, size_t *buffer_size,
+                const void *prefix, size_t prefix_len,
+                uint8_t extra) {
 #if HAVE_ZSTD
+        int r;
+
         assert(src);
         assert(src_size > 0);
         assert(buffer);
@@ -476,6 +656,10 @@ int decompress_startswith_zstd(
         if (!dctx)
                 return -ENOMEM;
 
+        r = zstd_ref_dictionary(dctx, d, src, src_size);
+        if (r < 0)
+                return r;
+
         if (!(greedy_realloc(buffer, buffer_size, MAX(ZSTD_DStreamOutSize(), prefix_len + 1), 1)))
                 return -ENOMEM;
 
@@ -503,8 +687,9 @@ int decompress_startswith_zstd(
 #endif
 }
 
-int decompress_startswith(
+int decompress_startswith_full(
                 int compression,
+                CompressionDictionary *d,
                 const void *src, uint64_t src_size,
                 void **buffer, size_t *buffer_size,
                 const void *prefix, size_t prefix_len,
@@ -524,7 +709,8 @@ int decompress_startswith(
                                 prefix, prefix_len,
                                 extra);
         else if (compression == OBJECT_COMPRESSED_ZSTD)
-                return decompress_startswith_zstd(
+                return decompress_startswith_zstd_dictionary(
+                                d,
                                 src, src_size,
                                 buffer, buffer_size,
                                 prefix, prefix_len,
@@ -827,6 +1013,9 @@ int decompress_stream_lz4(int in, int out, uint64_t max_bytes) {
 #endif
 }
 
+/* Maximum number of worker threads to use for compressing streams with zstd */
+#define ZSTD_STREAM_WORKERS_MAX 4L
+
 int compress_stream_zstd(int fdf, int fdt, uint64_t max_bytes) {
 #if HAVE_ZSTD
         _cleanup_(ZSTD_freeCCtxp) ZSTD_CCtx *cctx = NULL;
@@ -834,6 +1023,7 @@ int compress_stream_zstd(int fdf, int fdt, uint64_t max_bytes) {
         size_t in_allocsize, out_allocsize;
         size_t z;
         uint64_t left = max_bytes, in_bytes = 0;
+        long ncpus;
 
         assert(fdf >= 0);
         assert(fdt >= 0);
@@ -851,6 +1041,16 @@ int compress_stream_zstd(int fdf, int fdt, uint64_t max_bytes) {
         if (ZSTD_isError(z))
                 log_debug("Failed to enable ZSTD checksum, ignoring: %s", ZSTD_getErrorName(z));
 
+        /* Streams are typically large (think coredumps), hence let zstd compress on multiple threads in the
+         * background if it has been built with support for that, while we keep feeding it with data. If
+         * not, this fails, and we'll compress on this thread only. */
+        ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+        if (ncpus > 1) {
+                z = ZSTD_CCtx_setParameter(cctx, ZSTD_c_nbWorkers, (int) MIN(ncpus, ZSTD_STREAM_WORKERS_MAX));
+                if (ZSTD_isError(z))
+                        log_debug("Failed to enable ZSTD worker threads, ignoring: %s", ZSTD_getErrorName(z));
+        }
+
         /* This loop read from the input file, compresses that entire chunk,
          * and writes all output produced to the output file.
          */
@@ -4,10 +4,22 @@
 #include <unistd.h>
 
 #include "journal-def.h"
+#include "macro.h"
+
+typedef struct CompressionDictionary CompressionDictionary;
 
 const char* object_compressed_to_string(int compression);
 int object_compressed_from_string(const char *compression);
 
+int compression_dictionary_new(const void *data, size_t size, CompressionDictionary **ret);
+CompressionDictionary* compression_dictionary_free(CompressionDictionary *d);
+DEFINE_TRIVIAL_CLEANUP_FUNC(CompressionDictionary*, compression_dictionary_free);
+
+int compression_dictionary_train(
+                const void *samples, const size_t *sample_sizes, size_t n_samples,
+                size_t max_size,
+                void **ret, size_t *ret_size);
+
 int compress_blob_xz(const void *src, uint64_t src_size,
                      void *dst, size_t dst_alloc_size, size_t *dst_size);
 int compress_blob_lz4(const void *src, uint64_t src_size,
@@ -36,15 +48,43 @@ static inline int compress_blob(const void *src, uint64_t src_size,
         return r;
 }
 
+int compress_blob_zstd_dictionary(CompressionDictionary *d,
+                                  const void *src, uint64_t src_size,
+                                  void *dst, size_t dst_alloc_size, size_t *dst_size);
+
+/* Like compress_blob(), but makes use of the specified dictionary, if there is one */
+static inline int compress_blob_full(CompressionDictionary *d,
+                                     const void *src, uint64_t src_size,
+                                     void *dst, size_t dst_alloc_size, size_t *dst_size) {
+        int r;
+
+        if (!d)
+                return compress_blob(src, src_size, dst, dst_alloc_size, dst_size);
+
+        r = compress_blob_zstd_dictionary(d, src, src_size, dst, dst_alloc_size, dst_size);
+        if (r == 0)
+                return OBJECT_COMPRESSED_ZSTD;
+
+        return r;
+}
+
 int decompress_blob_xz(const void *src, uint64_t src_size,
                        void **dst, size_t *dst_alloc_size, size_t* dst_size, size_t dst_max);
 int decompress_blob_lz4(const void *src, uint64_t src_size,
                         void **dst, size_t *dst_alloc_size, size_t* dst_size, size_t dst_max);
 int decompress_blob_zstd(const void *src, uint64_t src_size,
                         void **dst, size_t *dst_alloc_size, size_t* dst_size, size_t dst_max);
-int decompress_blob(int compression,
-                    const void *src, uint64_t src_size,
-                    void **dst, size_t *dst_alloc_size, size_t* dst_size, size_t dst_max);
+int decompress_blob_zstd_dictionary(CompressionDictionary *d,
+                                    const void *src, uint64_t src_size,
+                                    void **dst, size_t *dst_alloc_size, size_t* dst_size, size_t dst_max);
+int decompress_blob_full(int compression, CompressionDictionary *d,
+                         const void *src, uint64_t src_size,
+                         void **dst, size_t *dst_alloc_size, size_t* dst_size, size_t dst_max);
+static inline int decompress_blob(int compression,
+                                  const void *src, uint64_t src_size,
+                                  void **dst, size_t *dst_alloc_size, size_t* dst_size, size_t dst_max) {
+        return decompress_blob_full(compression, NULL, src, src_size, dst, dst_alloc_size, dst_size, dst_max);
+}
 
 int decompress_startswith_xz(const void *src, uint64_t src_size,
                              void **buffer, size_t *buffer_size,
@@ -58,11 +98,23 @@ int decompress_startswith_zstd(const void *src, uint64_t src_size,
                                void **buffer, size_t *buffer_size,
                                const void *prefix, size_t prefix_len,
                                uint8_t extra);
-int decompress_startswith(int compression,
-                          const void *src, uint64_t src_size,
-                          void **buffer, size_t *buffer_size,
-                          const void *prefix, size_t prefix_len,
-                          uint8_t extra);
+int decompress_startswith_zstd_dictionary(CompressionDictionary *d,
+                                          const void *src, uint64_t src_size,
+                                          void **buffer, size_t *buffer_size,
+                                          const void *prefix, size_t prefix_len,
+                                          uint8_t extra);
+int decompress_startswith_full(int compression, CompressionDictionary *d,
+                               const void *src, uint64_t src_size,
+                               void **buffer, size_t *buffer_size,
+                               const void *prefix, size_t prefix_len,
+                               uint8_t extra);
+static inline int decompress_startswith(int compression,
+                                        const void *src, uint64_t src_size,
+                                        void **buffer, size_t *buffer_size,
+                                        const void *prefix, size_t prefix_len,
+                                        uint8_t extra) {
+        return decompress_startswith_full(compression, NULL, src, src_size, buffer, buffer_size, prefix, prefix_len, extra);
+}
 
 int compress_stream_xz(int fdf, int fdt, uint64_t max_bytes);
 int compress_stream_lz4(int fdf, int fdt, uint64_t max_bytes);
@@ -304,6 +304,10 @@ void FSPRG_GenState0(void *state, const void *mpk, const void *seed, size_t seed
 }
 
 void FSPRG_Evolve(void *state) {
+        FSPRG_EvolveN(state, 1);
+}
+
+void FSPRG_EvolveN(void *state, uint64_t steps) {
         gcry_mpi_t n, x;
         uint16_t secpar;
         uint64_t epoch;
@@ -315,8 +319,10 @@ void FSPRG_Evolve(void *state) {
         x = mpi_import(state + 2 + 1 * secpar / 8, secpar / 8);
         epoch = uint64_import(state + 2 + 2 * secpar / 8, 8);
 
-        gcry_mpi_mulm(x, x, x, n);
-        epoch++;
+        /* Import and export the state only once, not for every single squaring */
+        for (uint64_t i = 0; i < steps; i++)
+                gcry_mpi_mulm(x, x, x, n);
+        epoch += steps;
 
         mpi_export(state + 2 + 1 * secpar / 8, secpar / 8, x);
         uint64_export(state + 2 + 2 * secpar / 8, 8, epoch);
@@ -50,6 +50,9 @@ void FSPRG_GenState0(void *state, const void *mpk, const void *seed, size_t seed
 
 void FSPRG_Evolve(void *state);
 
+/* Evolve state by the specified number of epochs, equivalent to calling FSPRG_Evolve() that often. */
+void FSPRG_EvolveN(void *state, uint64_t steps);
+
 uint64_t FSPRG_GetEpoch(const void *state) _pure_;
 
 /* Seek to any arbitrary state (by providing msk together with seed from GenState0). */
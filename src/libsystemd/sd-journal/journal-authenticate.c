@@ -13,6 +13,10 @@
 #include "memory-util.h"
 #include "time-util.h"
 
+/* Evolving the key by one epoch takes a few µs, while seeking takes about as long as a few hundred epochs. Hence,
+ * when we only have to move forward by a bit, evolve instead of seeking. */
+#define FSPRG_SEEK_EVOLVE_MAX 512U
+
 static uint64_t journal_file_tag_seqnum(JournalFile *f) {
         uint64_t r;
 
@@ -143,22 +147,20 @@ int journal_file_fsprg_evolve(JournalFile *f, uint64_t realtime) {
                 return r;
 
         epoch = FSPRG_GetEpoch(f->fsprg_state);
-        if (epoch < goal)
-                log_debug("Evolving FSPRG key from epoch %"PRIu64" to %"PRIu64".", epoch, goal);
+        if (epoch > goal)
+                return -ESTALE;
+        if (epoch == goal)
+                return 0;
 
-        for (;;) {
-                if (epoch > goal)
-                        return -ESTALE;
-                if (epoch == goal)
-                        return 0;
+        /* Without the secret key there's no shortcut, the key has to be squared once per epoch. But after a
+         * longer downtime, do so in one go. */
+        log_debug("Evolving FSPRG key from epoch %"PRIu64" to %"PRIu64".", epoch, goal);
+        FSPRG_EvolveN(f->fsprg_state, goal - epoch);
 
-                FSPRG_Evolve(f->fsprg_state);
-                epoch = FSPRG_GetEpoch(f->fsprg_state);
-        }
+        return 0;
 }
 
 int journal_file_fsprg_seek(JournalFile *f, uint64_t goal) {
-        void *msk;
         uint64_t epoch;
 
         assert(f);
@@ -175,8 +177,8 @@ int journal_file_fsprg_seek(JournalFile *f, uint64_t goal) {
                 if (goal == epoch)
                         return 0;
 
-                if (goal == epoch+1) {
-                        FSPRG_Evolve(f->fsprg_state);
+                if (goal > epoch && goal - epoch <= FSPRG_SEEK_EVOLVE_MAX) {
+                        FSPRG_EvolveN(f->fsprg_state, goal - epoch);
                         return 0;
                 }
         } else {
@@ -189,9 +191,17 @@ int journal_file_fsprg_seek(JournalFile *f, uint64_t goal) {
 
         log_debug("Seeking FSPRG key to %"PRIu64".", goal);
 
-        msk = alloca(FSPRG_mskinbytes(FSPRG_RECOMMENDED_SECPAR));
-        FSPRG_GenMK(msk, NULL, f->fsprg_seed, f->fsprg_seed_size, FSPRG_RECOMMENDED_SECPAR);
-        FSPRG_Seek(f->fsprg_state, goal, msk, f->fsprg_seed, f->fsprg_seed_size);
+        /* Deriving the secret key from the seed means generating two large primes, which is by far the most
+         * expensive part of seeking. Verification seeks once per tag, hence keep the key around. */
+        if (!f->fsprg_msk) {
+                f->fsprg_msk = malloc(FSPRG_mskinbytes(FSPRG_RECOMMENDED_SECPAR));
+                if (!f->fsprg_msk)
+                        return -ENOMEM;
+
+                FSPRG_GenMK(f->fsprg_msk, NULL, f->fsprg_seed, f->fsprg_seed_size, FSPRG_RECOMMENDED_SECPAR);
+        }
+
+        FSPRG_Seek(f->fsprg_state, goal, f->fsprg_msk, f->fsprg_seed, f->fsprg_seed_size);
         return 0;
 }
 
@@ -274,6 +284,12 @@ int journal_file_hmac_put_object(JournalFile *f, ObjectType type, Object *o, uin
                 gcry_md_write(f->hmac, &o->tag.seqnum, sizeof(o->tag.seqnum));
                 gcry_md_write(f->hmac, &o->tag.epoch, sizeof(o->tag.epoch));
                 break;
+
+        case OBJECT_COMPRESSION_DICTIONARY:
+                /* All */
+                gcry_md_write(f->hmac, o->compression_dictionary.payload, le64toh(o->object.size) - offsetof(CompressionDictionaryObject, payload));
+                break;
+
         default:
                 return -EINVAL;
         }
@@ -462,6 +478,13 @@ int journal_file_append_first_tag(JournalFile *f) {
         if (r < 0)
                 return r;
 
+        if (JOURNAL_HEADER_COMPRESSION_DICTIONARY(f->header)) {
+                r = journal_file_hmac_put_object(f, OBJECT_COMPRESSION_DICTIONARY, NULL,
+                                                 le64toh(f->header->compression_dictionary_offset));
+                if (r < 0)
+                        return r;
+        }
+
         r = journal_file_append_tag(f);
         if (r < 0)
                 return r;
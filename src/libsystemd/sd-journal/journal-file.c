@@ -23,6 +23,7 @@
 #include "journal-authenticate.h"
 #include "journal-def.h"
 #include "journal-file.h"
+#include "journal-grep-index.h"
 #include "lookup3.h"
 #include "memory-util.h"
 #include "path-util.h"
@@ -37,9 +38,25 @@
 #define DEFAULT_DATA_HASH_TABLE_SIZE (2047ULL*sizeof(HashItem))
 #define DEFAULT_FIELD_HASH_TABLE_SIZE (333ULL*sizeof(HashItem))
 
+/* Files smaller than this are not considered representative when sizing the hash tables of their successors */
+#define JOURNAL_HASH_TABLE_TEMPLATE_MIN (1ULL*1024ULL*1024ULL)
+
 #define DEFAULT_COMPRESS_THRESHOLD (512ULL)
 #define MIN_COMPRESS_THRESHOLD (8ULL)
 
+/* With a trained dictionary even short objects compress well, hence use a lower default threshold */
+/* Payloads at least this large are hashed and compressed in worker threads, if enabled */
+#define OFFLOAD_MIN_SIZE (16U*1024U)
+#define OFFLOAD_THREADS_MAX 64U
+
+#define DEFAULT_DICTIONARY_COMPRESS_THRESHOLD (64ULL)
+
+/* How large a compression dictionary may get, how much data to sample from the previous file to train it on
+ * rotation, and the largest data object to consider as a sample */
+#define COMPRESSION_DICTIONARY_MAX_BYTES (16 * 1024ULL)            /* 16 KiB */
+#define COMPRESSION_DICTIONARY_SAMPLES_BYTES (512 * 1024ULL)       /* 512 KiB */
+#define COMPRESSION_DICTIONARY_SAMPLE_MAX_BYTES (4 * 1024ULL)      /* 4 KiB */
+
 /* This is the minimum journal file size */
 #define JOURNAL_FILE_SIZE_MIN (512 * 1024ULL)             /* 512 KiB */
 
@@ -85,6 +102,11 @@
 /* Longest hash chain to rotate after */
 #define HASH_CHAIN_DEPTH_MAX 100
 
+/* How far ahead of the iterator to read in entry objects, and how much of the next entry array, if
+ * prefetching is enabled */
+#define JOURNAL_PREFETCH_BYTES (512 * 1024ULL)                /* 512 KiB */
+#define JOURNAL_PREFETCH_ENTRY_ARRAY_BYTES (64 * 1024ULL)     /* 64 KiB */
+
 #ifdef __clang__
 #  pragma GCC diagnostic ignored "-Waddress-of-packed-member"
 #endif
@@ -396,9 +418,11 @@ JournalFile* journal_file_close(JournalFile *f) {
         mmap_cache_unref(f->mmap);
 
         ordered_hashmap_free_free(f->chain_cache);
+        free(f->boot_ids);
 
 #if HAVE_COMPRESSION
         free(f->compress_buffer);
+        compression_dictionary_free(f->compression_dictionary);
 #endif
 
 #if HAVE_GCRYPT
@@ -408,6 +432,7 @@ JournalFile* journal_file_close(JournalFile *f) {
                 free(f->fsprg_state);
 
         free(f->fsprg_seed);
+        erase_and_free(f->fsprg_msk);
 
         if (f->hmac)
                 gcry_md_close(f->hmac);
@@ -430,7 +455,8 @@ static int journal_file_init_header(JournalFile *f, JournalFile *template) {
                 f->compress_xz * HEADER_INCOMPATIBLE_COMPRESSED_XZ |
                 f->compress_lz4 * HEADER_INCOMPATIBLE_COMPRESSED_LZ4 |
                 f->compress_zstd * HEADER_INCOMPATIBLE_COMPRESSED_ZSTD |
-                f->keyed_hash * HEADER_INCOMPATIBLE_KEYED_HASH);
+                f->keyed_hash * HEADER_INCOMPATIBLE_KEYED_HASH |
+                f->compact * HEADER_INCOMPATIBLE_COMPACT);
 
         h.compatible_flags = htole32(
                 f->seal * HEADER_COMPATIBLE_SEALED);
@@ -497,7 +523,7 @@ static bool warn_wrong_flags(const JournalFile *f, bool compatible) {
                                   f->path, type, flags & ~any);
                 flags = (flags & any) & ~supported;
                 if (flags) {
-                        const char* strv[5];
+                        const char* strv[7];
                         unsigned n = 0;
                         _cleanup_free_ char *t = NULL;
 
@@ -513,6 +539,10 @@ static bool warn_wrong_flags(const JournalFile *f, bool compatible) {
                                         strv[n++] = "zstd-compressed";
                                 if (flags & HEADER_INCOMPATIBLE_KEYED_HASH)
                                         strv[n++] = "keyed-hash";
+                                if (flags & HEADER_INCOMPATIBLE_COMPRESSION_DICTIONARY)
+                                        strv[n++] = "compression-dictionary";
+                                if (flags & HEADER_INCOMPATIBLE_COMPACT)
+                                        strv[n++] = "compact";
                         }
                         strv[n] = NULL;
                         assert(n < ELEMENTSOF(strv));
@@ -557,6 +587,13 @@ static int journal_file_verify_header(JournalFile *f) {
         if (JOURNAL_HEADER_SEALED(f->header) && !JOURNAL_HEADER_CONTAINS(f->header, n_entry_arrays))
                 return -EBADMSG;
 
+        /* Dictionaries are only defined for ZSTD */
+        if (JOURNAL_HEADER_COMPRESSION_DICTIONARY(f->header) &&
+            (!JOURNAL_HEADER_CONTAINS(f->header, compression_dictionary_offset) ||
+             !JOURNAL_HEADER_COMPRESSED_ZSTD(f->header) ||
+             le64toh(f->header->compression_dictionary_offset) == 0))
+                return -EBADMSG;
+
         arena_size = le64toh(READ_NOW(f->header->arena_size));
 
         if (UINT64_MAX - header_size < arena_size || header_size + arena_size > (uint64_t) f->last_stat.st_size)
@@ -571,6 +608,10 @@ static int journal_file_verify_header(JournalFile *f) {
             !VALID64(le64toh(f->header->entry_array_offset)))
                 return -ENODATA;
 
+        if (JOURNAL_HEADER_CONTAINS(f->header, compression_dictionary_offset) &&
+            !VALID64(le64toh(f->header->compression_dictionary_offset)))
+                return -ENODATA;
+
         if (f->writable) {
                 sd_id128_t machine_id;
                 uint8_t state;
@@ -615,6 +656,7 @@ static int journal_file_verify_header(JournalFile *f) {
         f->seal = JOURNAL_HEADER_SEALED(f->header);
 
         f->keyed_hash = JOURNAL_HEADER_KEYED_HASH(f->header);
+        f->compact = JOURNAL_HEADER_COMPACT(f->header);
 
         return 0;
 }
@@ -686,6 +728,10 @@ static int journal_file_allocate(JournalFile *f, uint64_t offset, uint64_t size)
         if (f->metrics.max_size > 0 && new_size > f->metrics.max_size)
                 return -E2BIG;
 
+        /* Objects beyond 4G can't be referenced from compact files */
+        if (f->compact && new_size > JOURNAL_COMPACT_SIZE_MAX)
+                return -E2BIG;
+
         if (new_size > f->metrics.min_size && f->metrics.keep_free > 0) {
                 struct statvfs svfs;
 
@@ -703,6 +749,8 @@ static int journal_file_allocate(JournalFile *f, uint64_t offset, uint64_t size)
         new_size = DIV_ROUND_UP(new_size, FILE_SIZE_INCREASE) * FILE_SIZE_INCREASE;
         if (f->metrics.max_size > 0 && new_size > f->metrics.max_size)
                 new_size = f->metrics.max_size;
+        if (f->compact && new_size > JOURNAL_COMPACT_SIZE_MAX)
+                new_size = PAGE_ALIGN_DOWN(JOURNAL_COMPACT_SIZE_MAX);
 
         /* Note that the glibc fallocate() fallback is very
            inefficient, hence we try to minimize the allocation area
@@ -768,6 +816,7 @@ static uint64_t minimum_header_size(Object *o) {
                 [OBJECT_FIELD_HASH_TABLE] = sizeof(HashTableObject),
                 [OBJECT_ENTRY_ARRAY] = sizeof(EntryArrayObject),
                 [OBJECT_TAG] = sizeof(TagObject),
+                [OBJECT_COMPRESSION_DICTIONARY] = sizeof(CompressionDictionaryObject),
         };
 
         if (o->object.type >= ELEMENTSOF(table) || table[o->object.type] <= 0)
@@ -834,17 +883,17 @@ static int journal_file_check_object(JournalFile *f, uint64_t offset, Object *o)
 
                 sz = le64toh(READ_NOW(o->object.size));
                 if (sz < offsetof(EntryObject, items) ||
-                    (sz - offsetof(EntryObject, items)) % sizeof(EntryItem) != 0)
+                    (sz - offsetof(EntryObject, items)) % journal_file_entry_item_size(f) != 0)
                         return log_debug_errno(SYNTHETIC_ERRNO(EBADMSG),
                                                "Bad entry size (<= %zu): %" PRIu64 ": %" PRIu64,
                                                offsetof(EntryObject, items),
                                                sz,
                                                offset);
 
-                if ((sz - offsetof(EntryObject, items)) / sizeof(EntryItem) <= 0)
+                if ((sz - offsetof(EntryObject, items)) / journal_file_entry_item_size(f) <= 0)
                         return log_debug_errno(SYNTHETIC_ERRNO(EBADMSG),
                                                "Invalid number items in entry: %" PRIu64 ": %" PRIu64,
-                                               (sz - offsetof(EntryObject, items)) / sizeof(EntryItem),
+                                               (sz - offsetof(EntryObject, items)) / journal_file_entry_item_size(f),
                                                offset);
 
                 if (le64toh(o->entry.seqnum) <= 0)
@@ -919,6 +968,16 @@ static int journal_file_check_object(JournalFile *f, uint64_t offset, Object *o)
                                                le64toh(o->tag.epoch), offset);
 
                 break;
+
+        case OBJECT_COMPRESSION_DICTIONARY:
+                if (le64toh(o->object.size) <= offsetof(CompressionDictionaryObject, payload))
+                        return log_debug_errno(SYNTHETIC_ERRNO(EBADMSG),
+                                               "Bad object size (<= %zu): %" PRIu64 ": %" PRIu64,
+                                               offsetof(CompressionDictionaryObject, payload),
+                                               le64toh(o->object.size),
+                                               offset);
+
+                break;
         }
 
         return 0;
@@ -1113,7 +1172,7 @@ int journal_file_append_object(
         return 0;
 }
 
-static int journal_file_setup_data_hash_table(JournalFile *f) {
+static int journal_file_setup_data_hash_table(JournalFile *f, JournalFile *template) {
         uint64_t s, p;
         Object *o;
         int r;
@@ -1130,6 +1189,25 @@ static int journal_file_setup_data_hash_table(JournalFile *f) {
         if (s < DEFAULT_DATA_HASH_TABLE_SIZE)
                 s = DEFAULT_DATA_HASH_TABLE_SIZE;
 
+        /* The hash table cannot be resized once the file exists. If we replace a file whose payloads were more
+         * diverse than estimated above (e.g. because of high-cardinality fields), size the table after the
+         * number of data objects per byte observed there instead, so that the new file doesn't run into the
+         * fill level limit and is rotated early again. */
+        if (template &&
+            JOURNAL_HEADER_CONTAINS(template->header, n_data) &&
+            le64toh(template->header->n_data) > 0 &&
+            le64toh(template->header->arena_size) >= JOURNAL_HASH_TABLE_TEMPLATE_MIN) {
+                uint64_t bytes_per_item, t;
+
+                bytes_per_item = MAX(le64toh(template->header->arena_size) / le64toh(template->header->n_data), 1U);
+                t = (f->metrics.max_size / bytes_per_item * 4 / 3) * sizeof(HashItem);
+                if (t > s) {
+                        log_debug("Replaced journal file %s has %"PRIu64" bytes per data object, growing data hash table.",
+                                  template->path, bytes_per_item);
+                        s = t;
+                }
+        }
+
         log_debug("Reserving %"PRIu64" entries in data hash table.", s / sizeof(HashItem));
 
         r = journal_file_append_object(f,
@@ -1147,7 +1225,7 @@ static int journal_file_setup_data_hash_table(JournalFile *f) {
         return 0;
 }
 
-static int journal_file_setup_field_hash_table(JournalFile *f) {
+static int journal_file_setup_field_hash_table(JournalFile *f, JournalFile *template) {
         uint64_t s, p;
         Object *o;
         int r;
@@ -1156,9 +1234,13 @@ static int journal_file_setup_field_hash_table(JournalFile *f) {
         assert(f->header);
 
         /* We use a fixed size hash table for the fields as this
-         * number should grow very slowly only */
+         * number should grow very slowly only. If the file we replace
+         * had more fields than fit at a 75% fill level, use that as
+         * the estimate instead. */
 
         s = DEFAULT_FIELD_HASH_TABLE_SIZE;
+        if (template && JOURNAL_HEADER_CONTAINS(template->header, n_fields))
+                s = MAX(s, DIV_ROUND_UP(le64toh(template->header->n_fields) * 4, 3) * sizeof(HashItem));
         log_debug("Reserving %"PRIu64" entries in field hash table.", s / sizeof(HashItem));
 
         r = journal_file_append_object(f,
@@ -1228,6 +1310,163 @@ int journal_file_map_field_hash_table(JournalFile *f) {
         return 0;
 }
 
+#if HAVE_COMPRESSION
+static int journal_file_collect_dictionary_samples(
+                JournalFile *f,
+                void **ret_samples,
+                size_t **ret_sizes,
+                size_t *ret_n_samples) {
+
+        _cleanup_free_ size_t *sizes = NULL;
+        _cleanup_free_ uint8_t *samples = NULL;
+        size_t n_sizes_allocated = 0, n_samples = 0, n_samples_allocated = 0, total = 0;
+        uint64_t n_buckets;
+        int r;
+
+        assert(f);
+        assert(f->header);
+        assert(ret_samples);
+        assert(ret_sizes);
+        assert(ret_n_samples);
+
+        /* Picks the payloads of data objects from the specified file as training samples for a compression
+         * dictionary. We walk the hash table buckets in order, which gives us a reasonably random subset of
+         * all data objects, since their position is determined by the hash of their payload. */
+
+        r = journal_file_map_data_hash_table(f);
+        if (r < 0)
+                return r;
+
+        n_buckets = le64toh(f->header->data_hash_table_size) / sizeof(HashItem);
+
+        for (uint64_t i = 0; i < n_buckets && total < COMPRESSION_DICTIONARY_SAMPLES_BYTES; i++) {
+                uint64_t p;
+
+                p = le64toh(f->data_hash_table[i].head_hash_offset);
+                while (p > 0 && total < COMPRESSION_DICTIONARY_SAMPLES_BYTES) {
+                        const void *data;
+                        size_t l;
+                        Object *o;
+                        int compression;
+
+                        r = journal_file_move_to_object(f, OBJECT_DATA, p, &o);
+                        if (r < 0)
+                                return r;
+
+                        l = le64toh(READ_NOW(o->object.size));
+                        if (l <= offsetof(Object, data.payload))
+                                return -EBADMSG;
+                        l -= offsetof(Object, data.payload);
+
+                        compression = o->object.flags & OBJECT_COMPRESSION_MASK;
+                        if (compression) {
+                                r = decompress_blob_full(compression, f->compression_dictionary,
+                                                         o->data.payload, l,
+                                                         &f->compress_buffer, &f->compress_buffer_size, &l,
+                                                         COMPRESSION_DICTIONARY_SAMPLE_MAX_BYTES + 1);
+                                if (r < 0)
+                                        return r;
+
+                                data = f->compress_buffer;
+                        } else
+                                data = o->data.payload;
+
+                        if (l <= COMPRESSION_DICTIONARY_SAMPLE_MAX_BYTES) {
+                                if (!GREEDY_REALLOC(samples, n_samples_allocated, total + l) ||
+                                    !GREEDY_REALLOC(sizes, n_sizes_allocated, n_samples + 1))
+                                        return -ENOMEM;
+
+                                memcpy(samples + total, data, l);
+                                sizes[n_samples++] = l;
+                                total += l;
+                        }
+
+                        p = le64toh(o->data.next_hash_offset);
+                }
+        }
+
+        if (n_samples <= 0)
+                return -ENODATA;
+
+        *ret_samples = TAKE_PTR(samples);
+        *ret_sizes = TAKE_PTR(sizes);
+        *ret_n_samples = n_samples;
+        return 0;
+}
+
+static int journal_file_setup_compression_dictionary(JournalFile *f, JournalFile *template) {
+        _cleanup_(compression_dictionary_freep) CompressionDictionary *d = NULL;
+        _cleanup_free_ void *samples = NULL, *dictionary = NULL;
+        _cleanup_free_ size_t *sizes = NULL;
+        size_t n_samples, size;
+        uint64_t p;
+        Object *o;
+        int r;
+
+        assert(f);
+        assert(f->header);
+        assert(template);
+
+        /* Trains a dictionary on the data objects of the file we are replacing, and stores it in the new
+         * file, so that all data objects we add can refer to it. This only makes sense before the first
+         * data object is added. */
+
+        r = journal_file_collect_dictionary_samples(template, &samples, &sizes, &n_samples);
+        if (r < 0)
+                return r;
+
+        r = compression_dictionary_train(samples, sizes, n_samples, COMPRESSION_DICTIONARY_MAX_BYTES, &dictionary, &size);
+        if (r < 0)
+                return r;
+
+        r = compression_dictionary_new(dictionary, size, &d);
+        if (r < 0)
+                return r;
+
+        r = journal_file_append_object(f,
+                                       OBJECT_COMPRESSION_DICTIONARY,
+                                       offsetof(Object, compression_dictionary.payload) + size,
+                                       &o, &p);
+        if (r < 0)
+                return r;
+
+        memcpy(o->compression_dictionary.payload, dictionary, size);
+
+        f->header->compression_dictionary_offset = htole64(p);
+        f->header->incompatible_flags |= htole32(HEADER_INCOMPATIBLE_COMPRESSION_DICTIONARY);
+
+        log_debug("Trained %zu byte compression dictionary from %zu data objects of %s.",
+                  size, n_samples, template->path);
+
+        f->compression_dictionary = TAKE_PTR(d);
+        return 0;
+}
+
+static int journal_file_load_compression_dictionary(JournalFile *f) {
+        uint64_t s;
+        Object *o;
+        int r;
+
+        assert(f);
+        assert(f->header);
+
+        if (!JOURNAL_HEADER_COMPRESSION_DICTIONARY(f->header))
+                return 0;
+
+        r = journal_file_move_to_object(f, OBJECT_COMPRESSION_DICTIONARY, le64toh(f->header->compression_dictionary_offset), &o);
+        if (r < 0)
+                return r;
+
+        s = le64toh(READ_NOW(o->object.size));
+        if (s <= offsetof(Object, compression_dictionary.payload))
+                return -EBADMSG;
+
+        return compression_dictionary_new(o->compression_dictionary.payload,
+                                          s - offsetof(Object, compression_dictionary.payload),
+                                          &f->compression_dictionary);
+}
+#endif
+
 static int journal_file_link_field(
                 JournalFile *f,
                 Object *o,
@@ -1494,8 +1733,8 @@ int journal_file_find_data_object_with_hash(
 
                         l -= offsetof(Object, data.payload);
 
-                        r = decompress_blob(o->object.flags & OBJECT_COMPRESSION_MASK,
-                                            o->data.payload, l, &f->compress_buffer, &f->compress_buffer_size, &rsize, 0);
+                        r = decompress_blob_full(o->object.flags & OBJECT_COMPRESSION_MASK, f->compression_dictionary,
+                                                 o->data.payload, l, &f->compress_buffer, &f->compress_buffer_size, &rsize, 0);
                         if (r < 0)
                                 return r;
 
@@ -1655,12 +1894,26 @@ static int journal_file_append_field(
         return 0;
 }
 
-static int journal_file_append_data(
+/* The hash and compressed payload of a data object, calculated ahead of time by a worker thread, see
+ * journal_file_offload() */
+typedef struct OffloadedData {
+        uint64_t hash;
+        uint64_t jenkins_hash;
+        bool done;
+
+        bool compress_done;
+        int compression;
+        void *compressed;
+        size_t compressed_size;
+} OffloadedData;
+
+static int journal_file_append_data_with_hash(
                 JournalFile *f,
-                const void *data, uint64_t size,
+                const void *data, uint64_t size, uint64_t hash,
+                const OffloadedData *offloaded,
                 Object **ret, uint64_t *ret_offset) {
 
-        uint64_t hash, p;
+        uint64_t p;
         uint64_t osize;
         Object *o;
         int r, compression = 0;
@@ -1669,8 +1922,6 @@ static int journal_file_append_data(
         assert(f);
         assert(data || size == 0);
 
-        hash = journal_file_hash_data(f, data, size);
-
         r = journal_file_find_data_object_with_hash(f, data, size, hash, &o, &p);
         if (r < 0)
                 return r;
@@ -1693,10 +1944,19 @@ static int journal_file_append_data(
         o->data.hash = htole64(hash);
 
 #if HAVE_COMPRESSION
-        if (JOURNAL_FILE_COMPRESS(f) && size >= f->compress_threshold_bytes) {
+        if (offloaded && offloaded->compress_done) {
+                /* Compressed by a worker thread already, or found not worth compressing */
+                compression = offloaded->compression;
+                if (compression > 0) {
+                        memcpy(o->data.payload, offloaded->compressed, offloaded->compressed_size);
+                        o->object.size = htole64(offsetof(Object, data.payload) + offloaded->compressed_size);
+                        o->object.flags |= compression;
+                }
+
+        } else if (JOURNAL_FILE_COMPRESS(f) && size >= f->compress_threshold_bytes) {
                 size_t rsize = 0;
 
-                compression = compress_blob(data, size, o->data.payload, size - 1, &rsize);
+                compression = compress_blob_full(f->compression_dictionary, data, size, o->data.payload, size - 1, &rsize);
 
                 if (compression >= 0) {
                         o->object.size = htole64(offsetof(Object, data.payload) + rsize);
@@ -1756,8 +2016,21 @@ static int journal_file_append_data(
         return 0;
 }
 
-uint64_t journal_file_entry_n_items(Object *o) {
+static int journal_file_append_data(
+                JournalFile *f,
+                const void *data, uint64_t size,
+                Object **ret, uint64_t *ret_offset) {
+
+        assert(f);
+        assert(data || size == 0);
+
+        return journal_file_append_data_with_hash(f, data, size, journal_file_hash_data(f, data, size), NULL, ret, ret_offset);
+}
+
+uint64_t journal_file_entry_n_items(JournalFile *f, Object *o) {
         uint64_t sz;
+
+        assert(f);
         assert(o);
 
         if (o->object.type != OBJECT_ENTRY)
@@ -1767,12 +2040,13 @@ uint64_t journal_file_entry_n_items(Object *o) {
         if (sz < offsetof(Object, entry.items))
                 return 0;
 
-        return (sz - offsetof(Object, entry.items)) / sizeof(EntryItem);
+        return (sz - offsetof(Object, entry.items)) / journal_file_entry_item_size(f);
 }
 
-uint64_t journal_file_entry_array_n_items(Object *o) {
+uint64_t journal_file_entry_array_n_items(JournalFile *f, Object *o) {
         uint64_t sz;
 
+        assert(f);
         assert(o);
 
         if (o->object.type != OBJECT_ENTRY_ARRAY)
@@ -1782,7 +2056,18 @@ uint64_t journal_file_entry_array_n_items(Object *o) {
         if (sz < offsetof(Object, entry_array.items))
                 return 0;
 
-        return (sz - offsetof(Object, entry_array.items)) / sizeof(uint64_t);
+        return (sz - offsetof(Object, entry_array.items)) / journal_file_entry_array_item_size(f);
+}
+
+static void write_entry_array_item(JournalFile *f, Object *o, uint64_t i, uint64_t p) {
+        assert(f);
+        assert(o);
+
+        if (f->compact) {
+                assert(p <= UINT32_MAX);
+                o->entry_array.items.compact[i] = htole32(p);
+        } else
+                o->entry_array.items.regular[i] = htole64(p);
 }
 
 uint64_t journal_file_hash_table_n_items(Object *o) {
@@ -1800,9 +2085,17 @@ uint64_t journal_file_hash_table_n_items(Object *o) {
         return (sz - offsetof(Object, hash_table.items)) / sizeof(HashItem);
 }
 
+/* Remembers where in an entry array chain we linked an entry last, so that consecutive appends don't need to
+ * walk the chain from the beginning */
+typedef struct EntryArrayHint {
+        uint64_t array; /* offset of the entry array object */
+        uint64_t begin; /* index of its first item in the chain */
+} EntryArrayHint;
+
 static int link_entry_into_array(JournalFile *f,
                                  le64_t *first,
                                  le64_t *idx,
+                                 EntryArrayHint *hint,
                                  uint64_t p) {
         int r;
         uint64_t n = 0, ap = 0, q, i, a, hidx;
@@ -1816,16 +2109,31 @@ static int link_entry_into_array(JournalFile *f,
 
         a = le64toh(*first);
         i = hidx = le64toh(READ_NOW(*idx));
+
+        /* If we linked into this chain before, start from the array we used last time, instead of walking
+         * the whole chain again */
+        if (hint && hint->array > 0 && hint->begin <= hidx) {
+                a = hint->array;
+                i = hidx - hint->begin;
+        }
+
         while (a > 0) {
 
                 r = journal_file_move_to_object(f, OBJECT_ENTRY_ARRAY, a, &o);
                 if (r < 0)
                         return r;
 
-                n = journal_file_entry_array_n_items(o);
+                n = journal_file_entry_array_n_items(f, o);
                 if (i < n) {
-                        o->entry_array.items[i] = htole64(p);
+                        write_entry_array_item(f, o, i, p);
                         *idx = htole64(hidx + 1);
+
+                        if (hint)
+                                *hint = (EntryArrayHint) {
+                                        .array = a,
+                                        .begin = hidx - i,
+                                };
+
                         return 0;
                 }
 
@@ -1843,7 +2151,7 @@ static int link_entry_into_array(JournalFile *f,
                 n = 4;
 
         r = journal_file_append_object(f, OBJECT_ENTRY_ARRAY,
-                                       offsetof(Object, entry_array.items) + n * sizeof(uint64_t),
+                                       offsetof(Object, entry_array.items) + n * journal_file_entry_array_item_size(f),
                                        &o, &q);
         if (r < 0)
                 return r;
@@ -1854,7 +2162,7 @@ static int link_entry_into_array(JournalFile *f,
                 return r;
 #endif
 
-        o->entry_array.items[i] = htole64(p);
+        write_entry_array_item(f, o, i, p);
 
         if (ap == 0)
                 *first = htole64(q);
@@ -1871,6 +2179,12 @@ static int link_entry_into_array(JournalFile *f,
 
         *idx = htole64(hidx + 1);
 
+        if (hint)
+                *hint = (EntryArrayHint) {
+                        .array = q,
+                        .begin = hidx - i,
+                };
+
         return 0;
 }
 
@@ -1898,7 +2212,7 @@ static int link_entry_into_array_plus_one(JournalFile *f,
                 le64_t i;
 
                 i = htole64(hidx - 1);
-                r = link_entry_into_array(f, first, &i, p);
+                r = link_entry_into_array(f, first, &i, NULL, p);
                 if (r < 0)
                         return r;
         }
@@ -1915,7 +2229,7 @@ static int journal_file_link_entry_item(JournalFile *f, Object *o, uint64_t offs
         assert(o);
         assert(offset > 0);
 
-        p = le64toh(o->entry.items[i].object_offset);
+        p = journal_file_entry_item_object_offset(f, o, i);
         r = journal_file_move_to_object(f, OBJECT_DATA, p, &o);
         if (r < 0)
                 return r;
@@ -1927,7 +2241,7 @@ static int journal_file_link_entry_item(JournalFile *f, Object *o, uint64_t offs
                                               offset);
 }
 
-static int journal_file_link_entry(JournalFile *f, Object *o, uint64_t offset) {
+static int journal_file_link_entry(JournalFile *f, Object *o, uint64_t offset, EntryArrayHint *hint) {
         uint64_t n;
         int r;
 
@@ -1945,6 +2259,7 @@ static int journal_file_link_entry(JournalFile *f, Object *o, uint64_t offset) {
         r = link_entry_into_array(f,
                                   &f->header->entry_array_offset,
                                   &f->header->n_entries,
+                                  hint,
                                   offset);
         if (r < 0)
                 return r;
@@ -1958,7 +2273,7 @@ static int journal_file_link_entry(JournalFile *f, Object *o, uint64_t offset) {
         f->header->tail_entry_monotonic = o->entry.monotonic;
 
         /* Link up the items */
-        n = journal_file_entry_n_items(o);
+        n = journal_file_entry_n_items(f, o);
         for (uint64_t i = 0; i < n; i++) {
                 r = journal_file_link_entry_item(f, o, offset, i);
                 if (r < 0)
@@ -1975,6 +2290,7 @@ static int journal_file_append_entry_internal(
                 uint64_t xor_hash,
                 const EntryItem items[], unsigned n_items,
                 uint64_t *seqnum,
+                EntryArrayHint *hint,
                 Object **ret, uint64_t *ret_offset) {
         uint64_t np;
         uint64_t osize;
@@ -1986,14 +2302,20 @@ static int journal_file_append_entry_internal(
         assert(items || n_items == 0);
         assert(ts);
 
-        osize = offsetof(Object, entry.items) + (n_items * sizeof(EntryItem));
+        osize = offsetof(Object, entry.items) + (n_items * journal_file_entry_item_size(f));
 
         r = journal_file_append_object(f, OBJECT_ENTRY, osize, &o, &np);
         if (r < 0)
                 return r;
 
         o->entry.seqnum = htole64(journal_file_entry_seqnum(f, seqnum));
-        memcpy_safe(o->entry.items, items, n_items * sizeof(EntryItem));
+        if (f->compact)
+                for (unsigned i = 0; i < n_items; i++) {
+                        assert(le64toh(items[i].object_offset) <= UINT32_MAX);
+                        o->entry.items.compact[i].object_offset = htole32(le64toh(items[i].object_offset));
+                }
+        else
+                memcpy_safe(o->entry.items.regular, items, n_items * sizeof(EntryItem));
         o->entry.realtime = htole64(ts->realtime);
         o->entry.monotonic = htole64(ts->monotonic);
         o->entry.xor_hash = htole64(xor_hash);
@@ -2007,7 +2329,7 @@ static int journal_file_append_entry_internal(
                 goto fail;
 #endif
 
-        r = journal_file_link_entry(f, o, np);
+        r = journal_file_link_entry(f, o, np, hint);
         if (r < 0)
                 goto fail;
 
@@ -2106,55 +2428,92 @@ int journal_file_enable_post_change_timer(JournalFile *f, sd_event *e, usec_t t)
         return r;
 }
 
+void journal_file_set_offload_threads(JournalFile *f, unsigned n) {
+        assert(f);
+
+        f->n_offload_threads = MIN(n, OFFLOAD_THREADS_MAX);
+}
+
 static int entry_item_cmp(const EntryItem *a, const EntryItem *b) {
         return CMP(le64toh(a->object_offset), le64toh(b->object_offset));
 }
 
-int journal_file_append_entry(
+/* A data object we already appended or looked up during a batch of appends, keyed by its hash */
+typedef struct BatchDataItem {
+        uint64_t hash;
+        const struct iovec *iovec;
+        uint64_t offset;
+        uint64_t xor_hash;
+} BatchDataItem;
+
+typedef struct BatchDataCache {
+        Hashmap *by_hash;
+        BatchDataItem *items; /* allocated once, so that the hashmap may point into it */
+        size_t n_items, n_allocated;
+} BatchDataCache;
+
+static void batch_data_cache_done(BatchDataCache *c) {
+        assert(c);
+
+        hashmap_free(c->by_hash);
+        free(c->items);
+}
+
+static int journal_file_validate_timestamp(const dual_timestamp *ts) {
+        assert(ts);
+
+        if (!VALID_REALTIME(ts->realtime))
+                return log_debug_errno(SYNTHETIC_ERRNO(EBADMSG),
+                                       "Invalid realtime timestamp %" PRIu64 ", refusing entry.",
+                                       ts->realtime);
+        if (!VALID_MONOTONIC(ts->monotonic))
+                return log_debug_errno(SYNTHETIC_ERRNO(EBADMSG),
+                                       "Invalid monotomic timestamp %" PRIu64 ", refusing entry.",
+                                       ts->monotonic);
+
+        return 0;
+}
+
+static int journal_file_append_entry_items(
                 JournalFile *f,
-                const dual_timestamp *ts,
-                const sd_id128_t *boot_id,
-                const struct iovec iovec[], unsigned n_iovec,
-                uint64_t *seqnum,
-                Object **ret, uint64_t *ret_offset) {
+                const struct iovec iovec[], size_t n_iovec,
+                BatchDataCache *cache,
+                const OffloadedData *offloaded,
+                EntryItem *items,
+                uint64_t *ret_xor_hash) {
 
-        EntryItem *items;
-        int r;
         uint64_t xor_hash = 0;
-        struct dual_timestamp _ts;
+        int r;
 
         assert(f);
         assert(f->header);
         assert(iovec || n_iovec == 0);
+        assert(items || n_iovec == 0);
+        assert(ret_xor_hash);
 
-        if (ts) {
-                if (!VALID_REALTIME(ts->realtime))
-                        return log_debug_errno(SYNTHETIC_ERRNO(EBADMSG),
-                                               "Invalid realtime timestamp %" PRIu64 ", refusing entry.",
-                                               ts->realtime);
-                if (!VALID_MONOTONIC(ts->monotonic))
-                        return log_debug_errno(SYNTHETIC_ERRNO(EBADMSG),
-                                               "Invalid monotomic timestamp %" PRIu64 ", refusing entry.",
-                                               ts->monotonic);
-        } else {
-                dual_timestamp_get(&_ts);
-                ts = &_ts;
-        }
+        for (size_t i = 0; i < n_iovec; i++) {
+                const OffloadedData *d = offloaded && offloaded[i].done ? offloaded + i : NULL;
+                BatchDataItem *c = NULL;
+                uint64_t p, h, hash;
+                Object *o;
 
-#if HAVE_GCRYPT
-        r = journal_file_maybe_append_tag(f, ts->realtime);
-        if (r < 0)
-                return r;
-#endif
+                hash = d ? d->hash : journal_file_hash_data(f, iovec[i].iov_base, iovec[i].iov_len);
 
-        /* alloca() can't take 0, hence let's allocate at least one */
-        items = newa(EntryItem, MAX(1u, n_iovec));
+                /* Within a batch the same fields show up over and over again. Short-cut the lookup in the
+                 * file's hash table for them. */
+                if (cache) {
+                        c = hashmap_get(cache->by_hash, &hash);
+                        if (c && memcmp_nn(c->iovec->iov_base, c->iovec->iov_len,
+                                           iovec[i].iov_base, iovec[i].iov_len) == 0) {
+                                xor_hash ^= c->xor_hash;
 
-        for (unsigned i = 0; i < n_iovec; i++) {
-                uint64_t p;
-                Object *o;
+                                items[i].object_offset = htole64(c->offset);
+                                items[i].hash = htole64(hash);
+                                continue;
+                        }
+                }
 
-                r = journal_file_append_data(f, iovec[i].iov_base, iovec[i].iov_len, &o, &p);
+                r = journal_file_append_data_with_hash(f, iovec[i].iov_base, iovec[i].iov_len, hash, d, &o, &p);
                 if (r < 0)
                         return r;
 
@@ -2168,19 +2527,37 @@ int journal_file_append_entry(
                  * files things are easier, we can just take the value from the stored record directly. */
 
                 if (JOURNAL_HEADER_KEYED_HASH(f->header))
-                        xor_hash ^= jenkins_hash64(iovec[i].iov_base, iovec[i].iov_len);
+                        h = d ? d->jenkins_hash : jenkins_hash64(iovec[i].iov_base, iovec[i].iov_len);
                 else
-                        xor_hash ^= le64toh(o->data.hash);
+                        h = le64toh(o->data.hash);
+
+                xor_hash ^= h;
 
                 items[i].object_offset = htole64(p);
                 items[i].hash = o->data.hash;
+
+                /* On hash collisions we simply don't cache the second object */
+                if (cache && !c && cache->n_items < cache->n_allocated) {
+                        c = cache->items + cache->n_items;
+                        *c = (BatchDataItem) {
+                                .hash = hash,
+                                .iovec = iovec + i,
+                                .offset = p,
+                                .xor_hash = h,
+                        };
+
+                        if (hashmap_put(cache->by_hash, &c->hash, c) > 0)
+                                cache->n_items++;
+                }
         }
 
-        /* Order by the position on disk, in order to improve seek
-         * times for rotating media. */
-        typesafe_qsort(items, n_iovec, entry_item_cmp);
+        *ret_xor_hash = xor_hash;
+        return 0;
+}
 
-        r = journal_file_append_entry_internal(f, ts, boot_id, xor_hash, items, n_iovec, seqnum, ret, ret_offset);
+static void journal_file_finish_append(JournalFile *f, int *r) {
+        assert(f);
+        assert(r);
 
         /* If the memory mapping triggered a SIGBUS then we return an
          * IO error and ignore the error code passed down to us, since
@@ -2188,12 +2565,320 @@ int journal_file_append_entry(
          * mapping page */
 
         if (mmap_cache_got_sigbus(f->mmap, f->cache_fd))
-                r = -EIO;
+                *r = -EIO;
 
         if (f->post_change_timer)
                 schedule_post_change(f);
         else
                 journal_file_post_change(f);
+}
+
+int journal_file_append_entry(
+                JournalFile *f,
+                const dual_timestamp *ts,
+                const sd_id128_t *boot_id,
+                const struct iovec iovec[], unsigned n_iovec,
+                uint64_t *seqnum,
+                Object **ret, uint64_t *ret_offset) {
+
+        EntryItem *items;
+        int r;
+        uint64_t xor_hash = 0;
+        struct dual_timestamp _ts;
+
+        assert(f);
+        assert(f->header);
+        assert(iovec || n_iovec == 0);
+
+        if (ts) {
+                r = journal_file_validate_timestamp(ts);
+                if (r < 0)
+                        return r;
+        } else {
+                dual_timestamp_get(&_ts);
+                ts = &_ts;
+        }
+
+#if HAVE_GCRYPT
+        r = journal_file_maybe_append_tag(f, ts->realtime);
+        if (r < 0)
+                return r;
+#endif
+
+        /* alloca() can't take 0, hence let's allocate at least one */
+        items = newa(EntryItem, MAX(1u, n_iovec));
+
+        r = journal_file_append_entry_items(f, iovec, n_iovec, NULL, NULL, items, &xor_hash);
+        if (r < 0)
+                return r;
+
+        /* Order by the position on disk, in order to improve seek
+         * times for rotating media. */
+        typesafe_qsort(items, n_iovec, entry_item_cmp);
+
+        r = journal_file_append_entry_internal(f, ts, boot_id, xor_hash, items, n_iovec, seqnum, NULL, ret, ret_offset);
+
+        journal_file_finish_append(f, &r);
+
+        return r;
+}
+
+typedef struct OffloadJob {
+        /* Copied from the file, so that the workers never touch the memory mapping */
+        bool keyed_hash;
+        sd_id128_t file_id;
+        bool compress;
+        uint64_t compress_threshold_bytes;
+
+        const struct iovec **iovecs;
+        OffloadedData **results;
+        size_t n;
+
+        unsigned n_threads;
+        unsigned index;
+} OffloadJob;
+
+static void offload_job_run(const OffloadJob *j, unsigned index) {
+        assert(j);
+
+        /* Thread number 'index' processes every n_threads'th item */
+
+        for (size_t i = index; i < j->n; i += j->n_threads) {
+                const struct iovec *iov = j->iovecs[i];
+                OffloadedData *d = j->results[i];
+
+                if (j->keyed_hash) {
+                        d->hash = siphash24(iov->iov_base, iov->iov_len, j->file_id.bytes);
+                        d->jenkins_hash = jenkins_hash64(iov->iov_base, iov->iov_len);
+                } else
+                        d->hash = d->jenkins_hash = jenkins_hash64(iov->iov_base, iov->iov_len);
+
+                d->done = true;
+
+#if HAVE_COMPRESSION
+                if (j->compress && iov->iov_len >= j->compress_threshold_bytes) {
+                        d->compressed = malloc(iov->iov_len - 1);
+                        if (!d->compressed)
+                                continue; /* Let the main thread deal with it */
+
+                        d->compression = compress_blob(iov->iov_base, iov->iov_len,
+                                                       d->compressed, iov->iov_len - 1, &d->compressed_size);
+                        if (d->compression < 0)
+                                /* Compression didn't work, we don't really care why, let's continue without compression */
+                                d->compression = 0;
+                        if (d->compression == 0)
+                                d->compressed = mfree(d->compressed);
+                }
+
+                d->compress_done = true;
+#endif
+        }
+}
+
+static void *offload_job_thread(void *arg) {
+        OffloadJob *j = arg;
+
+        (void) pthread_setname_np(pthread_self(), "journal-offload");
+
+        offload_job_run(j, j->index);
+        free(j);
+
+        return NULL;
+}
+
+static void journal_file_offload(
+                JournalFile *f,
+                const JournalFileEntry entries[], size_t n_entries,
+                OffloadedData *offloaded) {
+
+        _cleanup_free_ const struct iovec **iovecs = NULL;
+        _cleanup_free_ OffloadedData **results = NULL;
+        _cleanup_free_ pthread_t *threads = NULL;
+        unsigned n_threads, n_started = 0;
+        sigset_t ss, saved_ss;
+        size_t n = 0, k = 0;
+        OffloadJob job;
+        int r;
+
+        assert(f);
+        assert(f->header);
+        assert(entries);
+        assert(offloaded);
+
+        /* Calculate the hashes of the large payloads in this batch and compress them in a number of worker
+         * threads, so that verbose clients logging huge fields hold up the others for less time. The objects
+         * are still appended on the calling thread afterwards, in order. Everything that can't be done here
+         * is left to the calling thread. */
+
+        for (size_t i = 0; i < n_entries; i++)
+                for (size_t l = 0; l < entries[i].n_iovec; l++)
+                        if (entries[i].iovec[l].iov_len >= OFFLOAD_MIN_SIZE)
+                                n++;
+
+        /* With only one large payload we'd just wait for the worker, so don't bother */
+        n_threads = MIN3(f->n_offload_threads, n, OFFLOAD_THREADS_MAX);
+        if (n_threads < 2)
+                return;
+
+        iovecs = new(const struct iovec*, n);
+        results = new(OffloadedData*, n);
+        threads = new(pthread_t, n_threads);
+        if (!iovecs || !results || !threads)
+                return;
+
+        for (size_t i = 0, m = 0; i < n_entries; i++)
+                for (size_t l = 0; l < entries[i].n_iovec; l++, m++)
+                        if (entries[i].iovec[l].iov_len >= OFFLOAD_MIN_SIZE) {
+                                iovecs[k] = entries[i].iovec + l;
+                                results[k] = offloaded + m;
+                                k++;
+                        }
+
+        assert(k == n);
+
+        job = (OffloadJob) {
+                .keyed_hash = JOURNAL_HEADER_KEYED_HASH(f->header),
+                .file_id = f->header->file_id,
+                /* The dictionary is not safe to use from multiple threads, leave compression with it to our caller */
+#if HAVE_COMPRESSION
+                .compress = JOURNAL_FILE_COMPRESS(f) && !f->compression_dictionary,
+#endif
+                .compress_threshold_bytes = f->compress_threshold_bytes,
+                .iovecs = iovecs,
+                .results = results,
+                .n = n,
+                .n_threads = n_threads,
+        };
+
+        /* The workers only touch the payloads and their own allocations, hence block all signals for them */
+        assert_se(sigfillset(&ss) >= 0);
+        r = pthread_sigmask(SIG_BLOCK, &ss, &saved_ss);
+        if (r > 0)
+                return;
+
+        /* Thread 0 is the calling thread */
+        for (unsigned t = 1; t < n_threads; t++) {
+                OffloadJob *copy;
+
+                copy = newdup(OffloadJob, &job, 1);
+                if (!copy)
+                        break;
+
+                copy->index = t;
+
+                r = pthread_create(threads + n_started, NULL, offload_job_thread, copy);
+                if (r > 0) {
+                        log_debug_errno(r, "Failed to start offload thread, ignoring: %m");
+                        free(copy);
+                        break;
+                }
+
+                n_started++;
+        }
+
+        (void) pthread_sigmask(SIG_SETMASK, &saved_ss, NULL);
+
+        offload_job_run(&job, 0);
+
+        /* Do the parts of the threads that we failed to start ourselves */
+        for (unsigned t = n_started + 1; t < n_threads; t++)
+                offload_job_run(&job, t);
+
+        for (unsigned t = 0; t < n_started; t++)
+                (void) pthread_join(threads[t], NULL);
+}
+
+static void offloaded_data_free_many(OffloadedData *offloaded, size_t n) {
+        if (!offloaded)
+                return;
+
+        for (size_t i = 0; i < n; i++)
+                free(offloaded[i].compressed);
+
+        free(offloaded);
+}
+
+int journal_file_append_entries(
+                JournalFile *f,
+                const JournalFileEntry entries[], size_t n_entries,
+                uint64_t *seqnum,
+                size_t *ret_n_appended) {
+
+        _cleanup_(batch_data_cache_done) BatchDataCache cache = {};
+        _cleanup_free_ EntryItem *items = NULL;
+        OffloadedData *offloaded = NULL;
+        EntryArrayHint hint = {};
+        size_t n_items = 0, n_total = 0, i = 0, base = 0;
+        int r = 0;
+
+        assert(f);
+        assert(f->header);
+        assert(entries || n_entries == 0);
+
+        /* Appends a series of entries in one go. This is equivalent to calling journal_file_append_entry()
+         * for each of them, but data objects shared between the entries are looked up only once, the main
+         * entry array chain is walked only once, and the change is posted only once. Returns the number of
+         * entries appended before an error occurred in *ret_n_appended, so that the caller can act on the
+         * failed entry and continue with the rest. */
+
+        for (size_t k = 0; k < n_entries; k++) {
+                n_items = MAX(n_items, entries[k].n_iovec);
+                n_total += entries[k].n_iovec;
+        }
+
+        items = new(EntryItem, MAX(1u, n_items));
+        cache.items = new(BatchDataItem, MAX(1u, n_total));
+        cache.by_hash = hashmap_new(&uint64_hash_ops);
+        if (!items || !cache.items || !cache.by_hash) {
+                r = -ENOMEM;
+                goto finish;
+        }
+
+        cache.n_allocated = n_total;
+
+        if (f->n_offload_threads > 0 && n_total > 0) {
+                offloaded = new0(OffloadedData, n_total);
+                if (offloaded)
+                        journal_file_offload(f, entries, n_entries, offloaded);
+        }
+
+        for (; i < n_entries; i++) {
+                const JournalFileEntry *e = entries + i;
+                uint64_t xor_hash;
+
+                assert(e->iovec || e->n_iovec == 0);
+
+                r = journal_file_validate_timestamp(&e->ts);
+                if (r < 0)
+                        break;
+
+#if HAVE_GCRYPT
+                r = journal_file_maybe_append_tag(f, e->ts.realtime);
+                if (r < 0)
+                        break;
+#endif
+
+                r = journal_file_append_entry_items(f, e->iovec, e->n_iovec, &cache,
+                                                    offloaded ? offloaded + base : NULL,
+                                                    items, &xor_hash);
+                if (r < 0)
+                        break;
+
+                base += e->n_iovec;
+
+                typesafe_qsort(items, e->n_iovec, entry_item_cmp);
+
+                r = journal_file_append_entry_internal(f, &e->ts, e->boot_id, xor_hash, items, e->n_iovec, seqnum, &hint, NULL, NULL);
+                if (r < 0)
+                        break;
+        }
+
+finish:
+        offloaded_data_free_many(offloaded, n_total);
+        journal_file_finish_append(f, &r);
+
+        if (ret_n_appended)
+                *ret_n_appended = i;
 
         return r;
 }
@@ -2245,6 +2930,60 @@ static void chain_cache_put(
         ci->last_index = last_index;
 }
 
+static void journal_file_prefetch(JournalFile *f, Object *o, uint64_t a, uint64_t i) {
+        uint64_t p, begin, end, next;
+
+        assert(f);
+        assert(o);
+
+        /* When iterating, entry objects (and the data objects written along with them) are located in
+         * file order, hence ask the kernel to read in the range ahead of the iterator asynchronously,
+         * instead of taking one page fault after the other on cold caches. */
+
+        if (!f->prefetch)
+                return;
+
+        p = journal_file_entry_array_item(f, o, i);
+        if (p == 0)
+                return;
+
+        if (p < f->prefetch_begin || p > f->prefetch_end)
+                /* We seeked somewhere else, start from scratch */
+                f->prefetch_begin = f->prefetch_end = p;
+
+        if (f->last_direction == DIRECTION_DOWN) {
+                if (p + JOURNAL_PREFETCH_BYTES / 2 < f->prefetch_end)
+                        return;
+
+                begin = f->prefetch_end;
+                end = MIN(p + JOURNAL_PREFETCH_BYTES, (uint64_t) f->last_stat.st_size);
+
+                if (end > begin) {
+                        (void) posix_fadvise(f->fd, begin, end - begin, POSIX_FADV_WILLNEED);
+                        f->prefetch_end = end;
+                }
+
+                /* Entry arrays are singly linked, hence we can only read ahead the next one when going
+                 * forward. */
+                next = le64toh(o->entry_array.next_entry_array_offset);
+                if (next > 0 && a != f->prefetch_entry_array) {
+                        (void) posix_fadvise(f->fd, next, JOURNAL_PREFETCH_ENTRY_ARRAY_BYTES, POSIX_FADV_WILLNEED);
+                        f->prefetch_entry_array = a;
+                }
+        } else {
+                if (f->prefetch_begin + JOURNAL_PREFETCH_BYTES / 2 < p)
+                        return;
+
+                begin = p > JOURNAL_PREFETCH_BYTES ? p - JOURNAL_PREFETCH_BYTES : 0;
+                end = f->prefetch_begin;
+
+                if (end > begin) {
+                        (void) posix_fadvise(f->fd, begin, end - begin, POSIX_FADV_WILLNEED);
+                        f->prefetch_begin = begin;
+                }
+        }
+}
+
 static int generic_array_get(
                 JournalFile *f,
                 uint64_t first,
@@ -2275,9 +3014,9 @@ static int generic_array_get(
                 if (r < 0)
                         return r;
 
-                k = journal_file_entry_array_n_items(o);
+                k = journal_file_entry_array_n_items(f, o);
                 if (i < k) {
-                        p = le64toh(o->entry_array.items[i]);
+                        p = journal_file_entry_array_item(f, o, i);
                         goto found;
                 }
 
@@ -2290,7 +3029,9 @@ static int generic_array_get(
 
 found:
         /* Let's cache this item for the next invocation */
-        chain_cache_put(f->chain_cache, ci, first, a, le64toh(o->entry_array.items[0]), t, i);
+        chain_cache_put(f->chain_cache, ci, first, a, journal_file_entry_array_item(f, o, 0), t, i);
+
+        journal_file_prefetch(f, o, a, i);
 
         r = journal_file_move_to_object(f, OBJECT_ENTRY, p, &o);
         if (r < 0)
@@ -2396,13 +3137,13 @@ static int generic_array_bisect(
                 if (r < 0)
                         return r;
 
-                k = journal_file_entry_array_n_items(array);
+                k = journal_file_entry_array_n_items(f, array);
                 right = MIN(k, n);
                 if (right <= 0)
                         return 0;
 
                 i = right - 1;
-                lp = p = le64toh(array->entry_array.items[i]);
+                lp = p = journal_file_entry_array_item(f, array, i);
                 if (p <= 0)
                         r = -EBADMSG;
                 else
@@ -2435,7 +3176,7 @@ static int generic_array_bisect(
                                 if (last_index > 0) {
                                         uint64_t x = last_index - 1;
 
-                                        p = le64toh(array->entry_array.items[x]);
+                                        p = journal_file_entry_array_item(f, array, x);
                                         if (p <= 0)
                                                 return -EBADMSG;
 
@@ -2455,7 +3196,7 @@ static int generic_array_bisect(
                                 if (last_index < right) {
                                         uint64_t y = last_index + 1;
 
-                                        p = le64toh(array->entry_array.items[y]);
+                                        p = journal_file_entry_array_item(f, array, y);
                                         if (p <= 0)
                                                 return -EBADMSG;
 
@@ -2485,7 +3226,7 @@ static int generic_array_bisect(
                                 assert(left < right);
                                 i = (left + right) / 2;
 
-                                p = le64toh(array->entry_array.items[i]);
+                                p = journal_file_entry_array_item(f, array, i);
                                 if (p <= 0)
                                         r = -EBADMSG;
                                 else
@@ -2533,14 +3274,14 @@ found:
                 return 0;
 
         /* Let's cache this item for the next invocation */
-        chain_cache_put(f->chain_cache, ci, first, a, le64toh(array->entry_array.items[0]), t, subtract_one ? (i > 0 ? i-1 : UINT64_MAX) : i);
+        chain_cache_put(f->chain_cache, ci, first, a, journal_file_entry_array_item(f, array, 0), t, subtract_one ? (i > 0 ? i-1 : UINT64_MAX) : i);
 
         if (subtract_one && i == 0)
                 p = last_p;
         else if (subtract_one)
-                p = le64toh(array->entry_array.items[i-1]);
+                p = journal_file_entry_array_item(f, array, i-1);
         else
-                p = le64toh(array->entry_array.items[i]);
+                p = journal_file_entry_array_item(f, array, i);
 
         r = journal_file_move_to_object(f, OBJECT_ENTRY, p, &o);
         if (r < 0)
@@ -3249,6 +3990,10 @@ void journal_file_dump(JournalFile *f) {
                                le64toh(o->tag.epoch));
                         break;
 
+                case OBJECT_COMPRESSION_DICTIONARY:
+                        printf("Type: OBJECT_COMPRESSION_DICTIONARY\n");
+                        break;
+
                 default:
                         printf("Type: unknown (%i)\n", o->object.type);
                         break;
@@ -3294,7 +4039,7 @@ void journal_file_print_header(JournalFile *f) {
                "Sequential number ID: %s\n"
                "State: %s\n"
                "Compatible flags:%s%s\n"
-               "Incompatible flags:%s%s%s%s%s\n"
+               "Incompatible flags:%s%s%s%s%s%s%s\n"
                "Header size: %"PRIu64"\n"
                "Arena size: %"PRIu64"\n"
                "Data hash table size: %"PRIu64"\n"
@@ -3321,6 +4066,8 @@ void journal_file_print_header(JournalFile *f) {
                JOURNAL_HEADER_COMPRESSED_LZ4(f->header) ? " COMPRESSED-LZ4" : "",
                JOURNAL_HEADER_COMPRESSED_ZSTD(f->header) ? " COMPRESSED-ZSTD" : "",
                JOURNAL_HEADER_KEYED_HASH(f->header) ? " KEYED-HASH" : "",
+               JOURNAL_HEADER_COMPRESSION_DICTIONARY(f->header) ? " COMPRESSION-DICTIONARY" : "",
+               JOURNAL_HEADER_COMPACT(f->header) ? " COMPACT" : "",
                (le32toh(f->header->incompatible_flags) & ~HEADER_INCOMPATIBLE_ANY) ? " ???" : "",
                le64toh(f->header->header_size),
                le64toh(f->header->arena_size),
@@ -3465,21 +4212,32 @@ int journal_file_open(
         } else
                 f->keyed_hash = r;
 
+        /* Compact files can't be read by older versions, hence they have to be asked for explicitly */
+        r = getenv_bool("SYSTEMD_JOURNAL_COMPACT");
+        if (r < 0) {
+                if (r != -ENXIO)
+                        log_debug_errno(r, "Failed to parse $SYSTEMD_JOURNAL_COMPACT environment variable, ignoring.");
+                f->compact = false;
+        } else
+                f->compact = r;
+
         if (DEBUG_LOGGING) {
-                static int last_seal = -1, last_compress = -1, last_keyed_hash = -1;
+                static int last_seal = -1, last_compress = -1, last_keyed_hash = -1, last_compact = -1;
                 static uint64_t last_bytes = UINT64_MAX;
                 char bytes[FORMAT_BYTES_MAX];
 
                 if (last_seal != f->seal ||
                     last_keyed_hash != f->keyed_hash ||
+                    last_compact != f->compact ||
                     last_compress != JOURNAL_FILE_COMPRESS(f) ||
                     last_bytes != f->compress_threshold_bytes) {
 
-                        log_debug("Journal effective settings seal=%s keyed_hash=%s compress=%s compress_threshold_bytes=%s",
-                                  yes_no(f->seal), yes_no(f->keyed_hash), yes_no(JOURNAL_FILE_COMPRESS(f)),
+                        log_debug("Journal effective settings seal=%s keyed_hash=%s compact=%s compress=%s compress_threshold_bytes=%s",
+                                  yes_no(f->seal), yes_no(f->keyed_hash), yes_no(f->compact), yes_no(JOURNAL_FILE_COMPRESS(f)),
                                   format_bytes(bytes, sizeof bytes, f->compress_threshold_bytes));
                         last_seal = f->seal;
                         last_keyed_hash = f->keyed_hash;
+                        last_compact = f->compact;
                         last_compress = JOURNAL_FILE_COMPRESS(f);
                         last_bytes = f->compress_threshold_bytes;
                 }
@@ -3602,6 +4360,12 @@ int journal_file_open(
                 r = journal_file_verify_header(f);
                 if (r < 0)
                         goto fail;
+
+#if HAVE_COMPRESSION
+                r = journal_file_load_compression_dictionary(f);
+                if (r < 0)
+                        goto fail;
+#endif
         }
 
 #if HAVE_GCRYPT
@@ -3631,14 +4395,29 @@ int journal_file_open(
 #endif
 
         if (newly_created) {
-                r = journal_file_setup_field_hash_table(f);
+                r = journal_file_setup_field_hash_table(f, template);
                 if (r < 0)
                         goto fail;
 
-                r = journal_file_setup_data_hash_table(f);
+                r = journal_file_setup_data_hash_table(f, template);
                 if (r < 0)
                         goto fail;
 
+#if HAVE_COMPRESSION
+                /* Dictionaries change the file format incompatibly, hence they are opt-in for now. They
+                 * are trained on the file we replace, i.e. only on rotation. */
+                if (f->compress_zstd && template) {
+                        r = getenv_bool("SYSTEMD_JOURNAL_COMPRESSION_DICTIONARY");
+                        if (r < 0 && r != -ENXIO)
+                                log_debug_errno(r, "Failed to parse $SYSTEMD_JOURNAL_COMPRESSION_DICTIONARY environment variable, ignoring.");
+                        if (r > 0) {
+                                r = journal_file_setup_compression_dictionary(f, template);
+                                if (r < 0)
+                                        log_debug_errno(r, "Failed to set up compression dictionary for %s, ignoring: %m", f->path);
+                        }
+                }
+#endif
+
 #if HAVE_GCRYPT
                 r = journal_file_append_first_tag(f);
                 if (r < 0)
@@ -3651,6 +4430,16 @@ int journal_file_open(
                 goto fail;
         }
 
+#if HAVE_COMPRESSION
+        if (f->compression_dictionary && compress_threshold_bytes == UINT64_MAX)
+                f->compress_threshold_bytes = DEFAULT_DICTIONARY_COMPRESS_THRESHOLD;
+#endif
+
+        if (template) {
+                f->n_offload_threads = template->n_offload_threads;
+                f->grep_index = template->grep_index;
+        }
+
         if (template && template->post_change_timer) {
                 r = journal_file_enable_post_change_timer(
                                 f,
@@ -3678,6 +4467,7 @@ fail:
 
 int journal_file_archive(JournalFile *f) {
         _cleanup_free_ char *p = NULL;
+        int r;
 
         assert(f);
 
@@ -3707,6 +4497,13 @@ int journal_file_archive(JournalFile *f) {
         /* Sync the rename to disk */
         (void) fsync_directory_of_file(f->fd);
 
+        /* Nothing is going to be added to the file anymore, hence now is the time to index it */
+        if (f->grep_index) {
+                r = journal_grep_index_build(f, p);
+                if (r < 0)
+                        log_debug_errno(r, "Failed to build grep index for %s, ignoring: %m", p);
+        }
+
         /* Set as archive so offlining commits w/state=STATE_ARCHIVED. Previously we would set old_file->header->state
          * to STATE_ARCHIVED directly here, but journal_file_set_offline() short-circuits when state != STATE_ONLINE,
          * which would result in the rotated journal never getting fsync() called before closing.  Now we simply queue
@@ -3864,7 +4661,55 @@ int journal_file_open_reliably(
                                  deferred_closes, template, ret);
 }
 
-int journal_file_copy_entry(JournalFile *from, JournalFile *to, Object *o, uint64_t p) {
+typedef struct CopiedData {
+        /* The key: a DATA object in the source file */
+        JournalFile *from;
+        uint64_t from_offset;
+
+        /* Where it ended up in the target file */
+        uint64_t to_offset;
+        le64_t to_hash;
+        uint64_t xor_hash;
+} CopiedData;
+
+static void copied_data_hash_func(const CopiedData *d, struct siphash *state) {
+        siphash24_compress(&d->from, sizeof(d->from), state);
+        siphash24_compress(&d->from_offset, sizeof(d->from_offset), state);
+}
+
+static int copied_data_compare_func(const CopiedData *a, const CopiedData *b) {
+        int r;
+
+        r = CMP(a->from, b->from);
+        if (r != 0)
+                return r;
+
+        return CMP(a->from_offset, b->from_offset);
+}
+
+DEFINE_PRIVATE_HASH_OPS_WITH_KEY_DESTRUCTOR(copied_data_hash_ops, CopiedData, copied_data_hash_func, copied_data_compare_func, free);
+
+static int copied_data_remember(Set **cache, JournalFile *from, uint64_t from_offset, uint64_t to_offset, le64_t to_hash, uint64_t xor_hash) {
+        _cleanup_free_ CopiedData *d = NULL;
+        int r;
+
+        d = new(CopiedData, 1);
+        if (!d)
+                return -ENOMEM;
+
+        *d = (CopiedData) {
+                .from = from,
+                .from_offset = from_offset,
+                .to_offset = to_offset,
+                .to_hash = to_hash,
+                .xor_hash = xor_hash,
+        };
+
+        r = set_ensure_consume(cache, &copied_data_hash_ops, TAKE_PTR(d));
+        return r < 0 ? r : 0;
+}
+
+int journal_file_copy_entry(JournalFile *from, JournalFile *to, Object *o, uint64_t p, Set **data_cache) {
         uint64_t q, n, xor_hash = 0;
         const sd_id128_t *boot_id;
         dual_timestamp ts;
@@ -3883,27 +4728,44 @@ int journal_file_copy_entry(JournalFile *from, JournalFile *to, Object *o, uint6
         ts.realtime = le64toh(o->entry.realtime);
         boot_id = &o->entry.boot_id;
 
-        n = journal_file_entry_n_items(o);
+        n = journal_file_entry_n_items(from, o);
         /* alloca() can't take 0, hence let's allocate at least one */
         items = newa(EntryItem, MAX(1u, n));
 
         for (uint64_t i = 0; i < n; i++) {
-                uint64_t l, h;
-                le64_t le_hash;
+                uint64_t l, h, x, n_entries;
+                le64_t le_hash = 0;
                 size_t t;
                 void *data;
                 Object *u;
 
-                q = le64toh(o->entry.items[i].object_offset);
-                le_hash = o->entry.items[i].hash;
+                q = journal_file_entry_item_object_offset(from, o, i);
+
+                if (data_cache) {
+                        CopiedData *d;
+
+                        /* Already copied this payload before? Then reuse the object in the target. */
+                        d = set_get(*data_cache, &(const CopiedData) { .from = from, .from_offset = q });
+                        if (d) {
+                                xor_hash ^= d->xor_hash;
+                                items[i].object_offset = htole64(d->to_offset);
+                                items[i].hash = d->to_hash;
+                                continue;
+                        }
+                }
+
+                if (!from->compact)
+                        le_hash = o->entry.items.regular[i].hash;
 
                 r = journal_file_move_to_object(from, OBJECT_DATA, q, &o);
                 if (r < 0)
                         return r;
 
-                if (le_hash != o->data.hash)
+                if (!from->compact && le_hash != o->data.hash)
                         return -EBADMSG;
 
+                n_entries = le64toh(o->data.n_entries);
+
                 l = le64toh(READ_NOW(o->object.size));
                 if (l < offsetof(Object, data.payload))
                         return -EBADMSG;
@@ -3919,8 +4781,8 @@ int journal_file_copy_entry(JournalFile *from, JournalFile *to, Object *o, uint6
 #if HAVE_COMPRESSION
                         size_t rsize = 0;
 
-                        r = decompress_blob(o->object.flags & OBJECT_COMPRESSION_MASK,
-                                            o->data.payload, l, &from->compress_buffer, &from->compress_buffer_size, &rsize, 0);
+                        r = decompress_blob_full(o->object.flags & OBJECT_COMPRESSION_MASK, from->compression_dictionary,
+                                                 o->data.payload, l, &from->compress_buffer, &from->compress_buffer_size, &rsize, 0);
                         if (r < 0)
                                 return r;
 
@@ -3937,20 +4799,28 @@ int journal_file_copy_entry(JournalFile *from, JournalFile *to, Object *o, uint6
                         return r;
 
                 if (JOURNAL_HEADER_KEYED_HASH(to->header))
-                        xor_hash ^= jenkins_hash64(data, l);
+                        x = jenkins_hash64(data, l);
                 else
-                        xor_hash ^= le64toh(u->data.hash);
+                        x = le64toh(u->data.hash);
 
+                xor_hash ^= x;
                 items[i].object_offset = htole64(h);
                 items[i].hash = u->data.hash;
 
+                /* Only remember payloads that other entries of the source file reference too */
+                if (data_cache && n_entries > 1) {
+                        r = copied_data_remember(data_cache, from, q, h, u->data.hash, x);
+                        if (r < 0)
+                                return r;
+                }
+
                 r = journal_file_move_to_object(from, OBJECT_ENTRY, p, &o);
                 if (r < 0)
                         return r;
         }
 
         r = journal_file_append_entry_internal(to, &ts, boot_id, xor_hash, items, n,
-                                               NULL, NULL, NULL);
+                                               NULL, NULL, NULL, NULL);
 
         if (mmap_cache_got_sigbus(to->mmap, to->cache_fd))
                 return -EIO;
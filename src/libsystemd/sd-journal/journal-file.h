@@ -11,6 +11,7 @@
 #include "sd-event.h"
 #include "sd-id128.h"
 
+#include "compress.h"
 #include "hashmap.h"
 #include "journal-def.h"
 #include "mmap-cache.h"
@@ -71,11 +72,15 @@ typedef struct JournalFile {
         bool defrag_on_close:1;
         bool close_fd:1;
         bool archive:1;
+        bool grep_index:1;
         bool keyed_hash:1;
+        bool compact:1;
+        bool prefetch:1;
 
         direction_t last_direction;
         LocationType location_type;
         uint64_t last_n_entries;
+        unsigned location_prioq_idx;
 
         char *path;
         struct stat last_stat;
@@ -98,8 +103,23 @@ typedef struct JournalFile {
         sd_event_source *post_change_timer;
         usec_t post_change_timer_period;
 
+        /* Number of threads to hash and compress large payloads in, see journal_file_append_entries() */
+        unsigned n_offload_threads;
+
         OrderedHashmap *chain_cache;
 
+        /* The file range we already asked the kernel to read ahead, and the entry array whose successor we
+         * asked for, if prefetching is enabled */
+        uint64_t prefetch_begin, prefetch_end;
+        uint64_t prefetch_entry_array;
+
+        /* The boot IDs of all entries in the file, collected lazily when reading, and the number of entries
+         * at the time they were collected */
+        sd_id128_t *boot_ids;
+        size_t n_boot_ids;
+        uint64_t boot_ids_n_entries;
+        bool boot_ids_valid;
+
         pthread_t offline_thread;
         volatile OfflineState offline_state;
 
@@ -109,6 +129,9 @@ typedef struct JournalFile {
 #if HAVE_COMPRESSION
         void *compress_buffer;
         size_t compress_buffer_size;
+
+        /* The dictionary referenced from the header, if there is one */
+        CompressionDictionary *compression_dictionary;
 #endif
 
 #if HAVE_GCRYPT
@@ -126,6 +149,8 @@ typedef struct JournalFile {
 
         void *fsprg_seed;
         size_t fsprg_seed_size;
+
+        void *fsprg_msk; /* derived from fsprg_seed when seeking */
 #endif
 } JournalFile;
 
@@ -202,12 +227,45 @@ static inline bool VALID_EPOCH(uint64_t u) {
 #define JOURNAL_HEADER_KEYED_HASH(h) \
         FLAGS_SET(le32toh((h)->incompatible_flags), HEADER_INCOMPATIBLE_KEYED_HASH)
 
+#define JOURNAL_HEADER_COMPRESSION_DICTIONARY(h) \
+        FLAGS_SET(le32toh((h)->incompatible_flags), HEADER_INCOMPATIBLE_COMPRESSION_DICTIONARY)
+
+#define JOURNAL_HEADER_COMPACT(h) \
+        FLAGS_SET(le32toh((h)->incompatible_flags), HEADER_INCOMPATIBLE_COMPACT)
+
+/* Compact files store 32bit offsets, and hence may not grow beyond 4G */
+#define JOURNAL_COMPACT_SIZE_MAX ((uint64_t) UINT32_MAX)
+
 int journal_file_move_to_object(JournalFile *f, ObjectType type, uint64_t offset, Object **ret);
 
-uint64_t journal_file_entry_n_items(Object *o) _pure_;
-uint64_t journal_file_entry_array_n_items(Object *o) _pure_;
+static inline uint64_t journal_file_entry_item_size(JournalFile *f) {
+        return f->compact ? sizeof(CompactEntryItem) : sizeof(EntryItem);
+}
+
+static inline uint64_t journal_file_entry_array_item_size(JournalFile *f) {
+        return f->compact ? sizeof(le32_t) : sizeof(le64_t);
+}
+
+static inline uint64_t journal_file_entry_item_object_offset(JournalFile *f, Object *o, uint64_t i) {
+        return f->compact ? le32toh(o->entry.items.compact[i].object_offset) : le64toh(o->entry.items.regular[i].object_offset);
+}
+
+static inline uint64_t journal_file_entry_array_item(JournalFile *f, Object *o, uint64_t i) {
+        return f->compact ? le32toh(o->entry_array.items.compact[i]) : le64toh(o->entry_array.items.regular[i]);
+}
+
+uint64_t journal_file_entry_n_items(JournalFile *f, Object *o) _pure_;
+uint64_t journal_file_entry_array_n_items(JournalFile *f, Object *o) _pure_;
 uint64_t journal_file_hash_table_n_items(Object *o) _pure_;
 
+/* One entry to append with journal_file_append_entries() */
+typedef struct JournalFileEntry {
+        dual_timestamp ts;
+        const sd_id128_t *boot_id; /* NULL for the current boot */
+        const struct iovec *iovec;
+        size_t n_iovec;
+} JournalFileEntry;
+
 int journal_file_append_object(JournalFile *f, ObjectType type, uint64_t size, Object **ret, uint64_t *offset);
 int journal_file_append_entry(
                 JournalFile *f,
@@ -217,6 +275,11 @@ int journal_file_append_entry(
                 uint64_t *seqno,
                 Object **ret,
                 uint64_t *offset);
+int journal_file_append_entries(
+                JournalFile *f,
+                const JournalFileEntry entries[], size_t n_entries,
+                uint64_t *seqno,
+                size_t *ret_n_appended);
 
 int journal_file_find_data_object(JournalFile *f, const void *data, uint64_t size, Object **ret, uint64_t *offset);
 int journal_file_find_data_object_with_hash(JournalFile *f, const void *data, uint64_t size, uint64_t hash, Object **ret, uint64_t *offset);
@@ -240,7 +303,10 @@ int journal_file_move_to_entry_by_seqnum_for_data(JournalFile *f, uint64_t data_
 int journal_file_move_to_entry_by_realtime_for_data(JournalFile *f, uint64_t data_offset, uint64_t realtime, direction_t direction, Object **ret, uint64_t *offset);
 int journal_file_move_to_entry_by_monotonic_for_data(JournalFile *f, uint64_t data_offset, sd_id128_t boot_id, uint64_t monotonic, direction_t direction, Object **ret, uint64_t *offset);
 
-int journal_file_copy_entry(JournalFile *from, JournalFile *to, Object *o, uint64_t p);
+/* If 'data_cache' is non-NULL, it is used to remember which DATA objects of 'from' have already been copied to
+ * 'to', so that subsequent entries referencing the same payloads don't need to read, hash and look them up again.
+ * It must be freed with set_free() and must not be reused once 'to' changes. */
+int journal_file_copy_entry(JournalFile *from, JournalFile *to, Object *o, uint64_t p, Set **data_cache);
 
 void journal_file_dump(JournalFile *f);
 void journal_file_print_header(JournalFile *f);
@@ -253,6 +319,7 @@ int journal_file_dispose(int dir_fd, const char *fname);
 
 void journal_file_post_change(JournalFile *f);
 int journal_file_enable_post_change_timer(JournalFile *f, sd_event *e, usec_t t);
+void journal_file_set_offload_threads(JournalFile *f, unsigned n);
 
 void journal_reset_metrics(JournalMetrics *m);
 void journal_default_metrics(JournalMetrics *m, int fd);
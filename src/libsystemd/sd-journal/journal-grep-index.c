@@ -0,0 +1,670 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "alloc-util.h"
+#include "compress.h"
+#include "fd-util.h"
+#include "fs-util.h"
+#include "io-util.h"
+#include "journal-grep-index.h"
+#include "memory-util.h"
+#include "sort-util.h"
+#include "sparse-endian.h"
+#include "string-util.h"
+#include "tmpfile-util.h"
+
+#define GREP_INDEX_SIGNATURE ((const char[]) { 'L', 'P', 'K', 'S', 'G', 'R', 'P', '1' })
+
+/* Don't let the index grow without bounds for files with lots of huge unique messages. Each pair of
+ * trigram and DATA object costs us 8 bytes while building. */
+#define GREP_INDEX_PAIRS_MAX (32U*1024U*1024U)
+
+typedef struct GrepIndexHeader {
+        uint8_t signature[8];
+        sd_id128_t file_id;
+        /* Used to detect whether the journal file changed after the index was built */
+        le64_t n_data;
+        le64_t tail_entry_seqnum;
+        le64_t n_trigrams;
+        le64_t n_postings;
+} _packed_ GrepIndexHeader;
+
+/* The header is followed by n_trigrams of these, sorted by trigram, followed by n_postings little endian
+ * 32bit DATA object offsets, divided by 8. The postings of each trigram are sorted too. */
+typedef struct GrepIndexTrigram {
+        le32_t trigram;
+        le32_t n_postings;
+        le64_t first_posting;
+} _packed_ GrepIndexTrigram;
+
+static uint32_t trigram_make(const uint8_t *p) {
+        return (uint32_t) ascii_tolower(p[0]) << 16 |
+               (uint32_t) ascii_tolower(p[1]) << 8 |
+               (uint32_t) ascii_tolower(p[2]);
+}
+
+static int uint32_compare(const uint32_t *a, const uint32_t *b) {
+        return CMP(*a, *b);
+}
+
+static int uint64_compare(const uint64_t *a, const uint64_t *b) {
+        return CMP(*a, *b);
+}
+
+static size_t uint32_sort_uniq(uint32_t *a, size_t n) {
+        size_t k = 0;
+
+        typesafe_qsort(a, n, uint32_compare);
+
+        for (size_t i = 0; i < n; i++)
+                if (k == 0 || a[k-1] != a[i])
+                        a[k++] = a[i];
+
+        return k;
+}
+
+int journal_grep_index_path(const char *journal_path, char **ret) {
+        char *p;
+
+        assert(journal_path);
+        assert(ret);
+
+        p = strjoin(journal_path, JOURNAL_GREP_INDEX_SUFFIX);
+        if (!p)
+                return -ENOMEM;
+
+        *ret = p;
+        return 0;
+}
+
+static int data_payload(JournalFile *f, Object *o, const void **ret, size_t *ret_size) {
+        uint64_t l;
+        int compression;
+
+        assert(f);
+        assert(o);
+        assert(ret);
+        assert(ret_size);
+
+        l = le64toh(READ_NOW(o->object.size));
+        if (l < offsetof(Object, data.payload))
+                return -EBADMSG;
+
+        l -= offsetof(Object, data.payload);
+        if ((uint64_t) (size_t) l != l)
+                return -E2BIG;
+
+        compression = o->object.flags & OBJECT_COMPRESSION_MASK;
+        if (compression) {
+#if HAVE_COMPRESSION
+                size_t rsize = 0;
+                int r;
+
+                r = decompress_blob_full(compression, f->compression_dictionary,
+                                         o->data.payload, l, &f->compress_buffer, &f->compress_buffer_size, &rsize, 0);
+                if (r < 0)
+                        return r;
+
+                *ret = f->compress_buffer;
+                *ret_size = rsize;
+                return 0;
+#else
+                return -EPROTONOSUPPORT;
+#endif
+        }
+
+        *ret = o->data.payload;
+        *ret_size = l;
+        return 0;
+}
+
+static int grep_index_serialize(
+                JournalFile *f,
+                const uint64_t *pairs, size_t n_pairs,
+                void **ret, size_t *ret_size) {
+
+        _cleanup_free_ void *buf = NULL;
+        GrepIndexTrigram *table;
+        GrepIndexHeader *h;
+        size_t n_trigrams = 0, k = 0, size;
+        le32_t *postings;
+
+        assert(f);
+        assert(pairs || n_pairs == 0);
+        assert(ret);
+        assert(ret_size);
+
+        for (size_t i = 0; i < n_pairs; i++)
+                if (i == 0 || pairs[i-1] >> 32 != pairs[i] >> 32)
+                        n_trigrams++;
+
+        size = sizeof(GrepIndexHeader) + n_trigrams * sizeof(GrepIndexTrigram) + n_pairs * sizeof(le32_t);
+        buf = malloc0(size);
+        if (!buf)
+                return -ENOMEM;
+
+        h = buf;
+        table = (GrepIndexTrigram*) (h + 1);
+        postings = (le32_t*) (table + n_trigrams);
+
+        memcpy(h->signature, GREP_INDEX_SIGNATURE, sizeof(h->signature));
+        h->file_id = f->header->file_id;
+        h->n_data = f->header->n_data;
+        h->tail_entry_seqnum = f->header->tail_entry_seqnum;
+        h->n_trigrams = htole64(n_trigrams);
+        h->n_postings = htole64(n_pairs);
+
+        for (size_t i = 0; i < n_pairs; i++) {
+                if (i == 0 || pairs[i-1] >> 32 != pairs[i] >> 32) {
+                        if (i > 0)
+                                k++;
+
+                        table[k] = (GrepIndexTrigram) {
+                                .trigram = htole32(pairs[i] >> 32),
+                                .first_posting = htole64(i),
+                        };
+                }
+
+                table[k].n_postings = htole32(le32toh(table[k].n_postings) + 1);
+                postings[i] = htole32((uint32_t) pairs[i]);
+        }
+
+        *ret = TAKE_PTR(buf);
+        *ret_size = size;
+        return 0;
+}
+
+int journal_grep_index_build(JournalFile *f, const char *journal_path) {
+        _cleanup_free_ char *path = NULL, *tmp = NULL;
+        _cleanup_free_ uint32_t *trigrams = NULL;
+        _cleanup_free_ uint64_t *pairs = NULL;
+        _cleanup_free_ void *buf = NULL;
+        _cleanup_close_ int fd = -1;
+        size_t n_pairs = 0, n_pairs_allocated = 0, n_trigrams_allocated = 0, size;
+        uint64_t p = 0, n_data;
+        Object *o;
+        int r;
+
+        assert(f);
+        assert(f->header);
+        assert(journal_path);
+
+        /* Collects the trigrams of all MESSAGE= fields of the file, and writes them out as a sidecar file
+         * next to the journal file. Should only be called on files that are not going to be modified
+         * anymore, i.e. from journal_file_archive(). */
+
+        r = journal_grep_index_path(journal_path, &path);
+        if (r < 0)
+                return r;
+
+        r = journal_file_find_field_object(f, "MESSAGE", STRLEN("MESSAGE"), &o, NULL);
+        if (r < 0)
+                return r;
+        if (r > 0)
+                p = le64toh(o->field.head_data_offset);
+
+        n_data = le64toh(f->header->n_data);
+
+        for (uint64_t n = 0; p != 0; n++) {
+                const uint8_t *data;
+                size_t l, n_trigrams;
+                uint64_t next;
+
+                /* Protect against loops in corrupted files */
+                if (n >= n_data)
+                        return -EBADMSG;
+
+                /* We store offsets divided by 8 in 32bit */
+                if (p >> 3 > UINT32_MAX)
+                        return -EFBIG;
+
+                r = journal_file_move_to_object(f, OBJECT_DATA, p, &o);
+                if (r < 0)
+                        return r;
+
+                next = le64toh(o->data.next_field_offset);
+
+                r = data_payload(f, o, (const void**) &data, &l);
+                if (r < 0)
+                        return r;
+
+                if (l < STRLEN("MESSAGE=") || memcmp(data, "MESSAGE=", STRLEN("MESSAGE=")) != 0)
+                        return -EBADMSG;
+
+                data += STRLEN("MESSAGE=");
+                l -= STRLEN("MESSAGE=");
+
+                if (l >= 3) {
+                        if (!GREEDY_REALLOC(trigrams, n_trigrams_allocated, l - 2))
+                                return -ENOMEM;
+
+                        for (size_t i = 0; i < l - 2; i++)
+                                trigrams[i] = trigram_make(data + i);
+
+                        n_trigrams = uint32_sort_uniq(trigrams, l - 2);
+
+                        if (n_pairs + n_trigrams > GREP_INDEX_PAIRS_MAX)
+                                return log_debug_errno(SYNTHETIC_ERRNO(E2BIG),
+                                                       "Too many distinct messages in %s, not building grep index.",
+                                                       journal_path);
+
+                        if (!GREEDY_REALLOC(pairs, n_pairs_allocated, n_pairs + n_trigrams))
+                                return -ENOMEM;
+
+                        for (size_t i = 0; i < n_trigrams; i++)
+                                pairs[n_pairs++] = (uint64_t) trigrams[i] << 32 | p >> 3;
+                }
+
+                p = next;
+        }
+
+        typesafe_qsort(pairs, n_pairs, uint64_compare);
+
+        r = grep_index_serialize(f, pairs, n_pairs, &buf, &size);
+        if (r < 0)
+                return r;
+
+        fd = open_tmpfile_linkable(path, O_WRONLY|O_CLOEXEC, &tmp);
+        if (fd < 0)
+                return fd;
+
+        r = loop_write(fd, buf, size, false);
+        if (r < 0)
+                goto fail;
+
+        if (fchmod(fd, f->mode & 0666) < 0) {
+                r = -errno;
+                goto fail;
+        }
+
+        /* An index left over from an earlier file of the same name is useless anyway */
+        (void) unlink(path);
+
+        r = link_tmpfile(fd, tmp, path);
+        if (r < 0)
+                goto fail;
+
+        log_debug("Wrote grep index for %s with %zu postings.", journal_path, n_pairs);
+        return 0;
+
+fail:
+        if (tmp)
+                (void) unlink(tmp);
+
+        return r;
+}
+
+int journal_grep_index_unlink(int dir_fd, const char *journal_fname) {
+        const char *p;
+
+        assert(journal_fname);
+
+        p = strjoina(journal_fname, JOURNAL_GREP_INDEX_SUFFIX);
+        if (unlinkat(dir_fd, p, 0) < 0)
+                return errno == ENOENT ? 0 : -errno;
+
+        return 1;
+}
+
+static int pattern_flush(const char *run, size_t n_run, uint32_t **trigrams, size_t *n_trigrams, size_t *n_allocated) {
+        if (n_run < 3)
+                return 0;
+
+        if (!GREEDY_REALLOC(*trigrams, *n_allocated, *n_trigrams + n_run - 2))
+                return -ENOMEM;
+
+        for (size_t i = 0; i < n_run - 2; i++)
+                (*trigrams)[(*n_trigrams)++] = trigram_make((const uint8_t*) run + i);
+
+        return 0;
+}
+
+static bool pattern_is_counted_repeat(const char *p) {
+        /* Checks whether p points to a "{n}", "{n,}" or "{n,m}" quantifier */
+
+        assert(*p == '{');
+
+        p++;
+        if (!strchr(DIGITS, *p) || *p == 0)
+                return false;
+
+        p += strspn(p, DIGITS);
+        if (*p == ',') {
+                p++;
+                p += strspn(p, DIGITS);
+        }
+
+        return *p == '}';
+}
+
+int journal_grep_pattern_trigrams(const char *pattern, uint32_t **ret, size_t *ret_n) {
+        _cleanup_free_ uint32_t *trigrams = NULL;
+        _cleanup_free_ char *run = NULL;
+        size_t n_trigrams = 0, n_allocated = 0, n_run = 0;
+        bool last_literal = false;
+        int r;
+
+        assert(pattern);
+        assert(ret);
+        assert(ret_n);
+
+        /* Extracts the trigrams that any subject matching the PCRE2 pattern must contain. This is
+         * deliberately conservative: only runs of plain literal characters are considered, and any construct
+         * that could make those optional (alternatives, optional groups, option settings, ...) makes us give
+         * up. Returns 0 if no such trigrams could be determined, 1 otherwise. */
+
+        run = new(char, strlen(pattern) + 1);
+        if (!run)
+                return -ENOMEM;
+
+#define FLUSH                                                                   \
+        do {                                                                    \
+                r = pattern_flush(run, n_run, &trigrams, &n_trigrams, &n_allocated); \
+                if (r < 0)                                                      \
+                        return r;                                               \
+                n_run = 0;                                                      \
+                last_literal = false;                                           \
+        } while (false)
+
+        for (const char *p = pattern; *p; ) {
+                switch (*p) {
+
+                case '|':
+                        goto give_up;
+
+                case '(':
+                        /* (?...) might change options, (*...) might change the encoding */
+                        if (IN_SET(p[1], '?', '*'))
+                                goto give_up;
+
+                        FLUSH;
+                        p++;
+                        break;
+
+                case ')':
+                        FLUSH;
+                        p++;
+
+                        /* The preceding group is optional */
+                        if (IN_SET(*p, '?', '*') || (*p == '{' && pattern_is_counted_repeat(p)))
+                                goto give_up;
+                        break;
+
+                case '[':
+                        FLUSH;
+                        p++;
+
+                        if (*p == '^')
+                                p++;
+                        if (*p == ']')
+                                p++;
+
+                        while (*p != ']') {
+                                if (*p == 0)
+                                        goto give_up;
+
+                                if (*p == '\\' && p[1] != 0)
+                                        p++;
+                                else if (p[0] == '[' && p[1] == ':') {
+                                        const char *e;
+
+                                        e = strstr(p + 2, ":]");
+                                        if (!e)
+                                                goto give_up;
+                                        p = e + 1;
+                                }
+
+                                p++;
+                        }
+
+                        p++;
+                        break;
+
+                case '{':
+                        if (!pattern_is_counted_repeat(p)) {
+                                run[n_run++] = *p++;
+                                last_literal = true;
+                                break;
+                        }
+
+                        p = strchr(p, '}');
+                        _fallthrough_;
+                case '?':
+                case '*':
+                        /* The previous character might not be there at all */
+                        if (last_literal)
+                                n_run--;
+
+                        FLUSH;
+                        p++;
+                        break;
+
+                case '+':
+                case '.':
+                case '^':
+                case '$':
+                        FLUSH;
+                        p++;
+                        break;
+
+                case '\\':
+                        if (p[1] == 0)
+                                goto give_up;
+
+                        if (strchr(ALPHANUMERICAL, p[1])) {
+                                /* Character types and assertions are fine, anything else (\Q...\E, \x..,
+                                 * back references, ...) we don't bother to parse. */
+                                if (!strchr("dDwWsSbBAzZhHvVRK", p[1]))
+                                        goto give_up;
+
+                                FLUSH;
+                        } else {
+                                run[n_run++] = p[1];
+                                last_literal = true;
+                        }
+
+                        p += 2;
+                        break;
+
+                default:
+                        run[n_run++] = *p++;
+                        last_literal = true;
+                }
+        }
+
+        FLUSH;
+
+#undef FLUSH
+
+        n_trigrams = uint32_sort_uniq(trigrams, n_trigrams);
+        if (n_trigrams == 0)
+                goto give_up;
+
+        *ret = TAKE_PTR(trigrams);
+        *ret_n = n_trigrams;
+        return 1;
+
+give_up:
+        *ret = NULL;
+        *ret_n = 0;
+        return 0;
+}
+
+static const GrepIndexTrigram *grep_index_find_trigram(const GrepIndexTrigram *table, size_t n, uint32_t trigram) {
+        size_t a = 0, b = n;
+
+        while (a < b) {
+                size_t m = a + (b - a) / 2;
+                uint32_t t = le32toh(table[m].trigram);
+
+                if (t == trigram)
+                        return table + m;
+                if (t < trigram)
+                        a = m + 1;
+                else
+                        b = m;
+        }
+
+        return NULL;
+}
+
+static bool uint32_bsearch(const uint32_t *a, size_t n, uint32_t v) {
+        return typesafe_bsearch(&v, a, n, uint32_compare);
+}
+
+int journal_grep_index_query(
+                JournalFile *f,
+                const uint32_t *trigrams, size_t n_trigrams,
+                uint32_t **ret_candidates, size_t *ret_n_candidates) {
+
+        _cleanup_free_ uint32_t *candidates = NULL;
+        _cleanup_free_ char *path = NULL;
+        _cleanup_close_ int fd = -1;
+        const GrepIndexTrigram *table, *smallest = NULL;
+        const GrepIndexHeader *h;
+        const le32_t *postings;
+        uint64_t n_table, n_postings;
+        size_t n_candidates = 0;
+        void *map = MAP_FAILED;
+        struct stat st;
+        int r;
+
+        assert(f);
+        assert(f->header);
+        assert(trigrams);
+        assert(n_trigrams > 0);
+        assert(ret_candidates);
+        assert(ret_n_candidates);
+
+        /* Looks up the DATA objects whose MESSAGE= field contains all the specified trigrams. Returns 0 if
+         * there's no usable index for the file, 1 if the candidates have been determined. */
+
+        r = journal_grep_index_path(f->path, &path);
+        if (r < 0)
+                return r;
+
+        fd = open(path, O_RDONLY|O_CLOEXEC|O_NOCTTY);
+        if (fd < 0)
+                return errno == ENOENT ? 0 : -errno;
+
+        if (fstat(fd, &st) < 0)
+                return -errno;
+
+        if ((uint64_t) st.st_size < sizeof(GrepIndexHeader) || (uint64_t) st.st_size > SIZE_MAX)
+                goto invalid;
+
+        map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED)
+                return -errno;
+
+        h = map;
+        n_table = le64toh(h->n_trigrams);
+        n_postings = le64toh(h->n_postings);
+
+        if (memcmp(h->signature, GREP_INDEX_SIGNATURE, sizeof(h->signature)) != 0 ||
+            !sd_id128_equal(h->file_id, f->header->file_id) ||
+            h->n_data != f->header->n_data ||
+            h->tail_entry_seqnum != f->header->tail_entry_seqnum ||
+            n_table > (uint64_t) st.st_size / sizeof(GrepIndexTrigram) ||
+            n_postings > (uint64_t) st.st_size / sizeof(le32_t) ||
+            sizeof(GrepIndexHeader) + n_table * sizeof(GrepIndexTrigram) + n_postings * sizeof(le32_t) != (uint64_t) st.st_size)
+                goto invalid;
+
+        table = (const GrepIndexTrigram*) (h + 1);
+        postings = (const le32_t*) (table + n_table);
+
+        /* Start with the rarest trigram, and filter its postings by all the others */
+        for (size_t i = 0; i < n_trigrams; i++) {
+                const GrepIndexTrigram *t;
+
+                t = grep_index_find_trigram(table, n_table, trigrams[i]);
+                if (!t)
+                        goto finish; /* No message contains this one */
+
+                if (le64toh(t->first_posting) + le32toh(t->n_postings) > n_postings)
+                        goto invalid;
+
+                if (!smallest || le32toh(t->n_postings) < le32toh(smallest->n_postings))
+                        smallest = t;
+        }
+
+        candidates = new(uint32_t, le32toh(smallest->n_postings));
+        if (!candidates) {
+                r = -ENOMEM;
+                goto finish;
+        }
+
+        for (size_t i = 0; i < le32toh(smallest->n_postings); i++)
+                candidates[n_candidates++] = le32toh(postings[le64toh(smallest->first_posting) + i]);
+
+        for (size_t i = 0; i < n_trigrams && n_candidates > 0; i++) {
+                const GrepIndexTrigram *t;
+                const le32_t *q;
+                size_t k = 0, j = 0, n;
+
+                t = grep_index_find_trigram(table, n_table, trigrams[i]);
+                if (t == smallest)
+                        continue;
+
+                q = postings + le64toh(t->first_posting);
+                n = le32toh(t->n_postings);
+
+                /* Both lists are sorted, hence intersect them in one go */
+                for (size_t c = 0; c < n_candidates; c++) {
+                        while (j < n && le32toh(q[j]) < candidates[c])
+                                j++;
+                        if (j >= n)
+                                break;
+                        if (le32toh(q[j]) == candidates[c])
+                                candidates[k++] = candidates[c];
+                }
+
+                n_candidates = k;
+        }
+
+finish:
+        (void) munmap(map, st.st_size);
+
+        if (r < 0)
+                return r;
+
+        *ret_candidates = TAKE_PTR(candidates);
+        *ret_n_candidates = n_candidates;
+        return 1;
+
+invalid:
+        if (map != MAP_FAILED)
+                (void) munmap(map, st.st_size);
+
+        log_debug("Grep index %s is invalid or outdated, ignoring.", path);
+        return 0;
+}
+
+bool journal_grep_index_entry_may_match(
+                JournalFile *f,
+                Object *entry,
+                const uint32_t *candidates, size_t n_candidates) {
+
+        uint64_t n;
+
+        assert(f);
+        assert(entry);
+        assert(entry->object.type == OBJECT_ENTRY);
+
+        /* Checks whether any of the DATA objects of the entry is one of the candidates returned by
+         * journal_grep_index_query(). This doesn't require decompressing or even looking at the objects. */
+
+        n = journal_file_entry_n_items(f, entry);
+        for (uint64_t i = 0; i < n; i++) {
+                uint64_t p = journal_file_entry_item_object_offset(f, entry, i);
+
+                if (p >> 3 <= UINT32_MAX && uint32_bsearch(candidates, n_candidates, (uint32_t) (p >> 3)))
+                        return true;
+        }
+
+        return false;
+}
@@ -0,0 +1,31 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+#pragma once
+
+#include <inttypes.h>
+#include <stdbool.h>
+
+#include "journal-def.h"
+#include "journal-file.h"
+
+/* A sidecar file next to an archived journal file, mapping trigrams of the (ASCII lowercased) MESSAGE= fields
+ * to the DATA objects containing them. It allows "journalctl --grep" to skip entries whose MESSAGE= can't
+ * possibly match without decompressing and matching them. */
+
+#define JOURNAL_GREP_INDEX_SUFFIX ".grepidx"
+
+int journal_grep_index_path(const char *journal_path, char **ret);
+
+int journal_grep_index_build(JournalFile *f, const char *journal_path);
+int journal_grep_index_unlink(int dir_fd, const char *journal_fname);
+
+int journal_grep_pattern_trigrams(const char *pattern, uint32_t **ret, size_t *ret_n);
+
+int journal_grep_index_query(
+                JournalFile *f,
+                const uint32_t *trigrams, size_t n_trigrams,
+                uint32_t **ret_candidates, size_t *ret_n_candidates);
+
+bool journal_grep_index_entry_may_match(
+                JournalFile *f,
+                Object *entry,
+                const uint32_t *candidates, size_t n_candidates);
@@ -12,6 +12,7 @@
 #include "journal-def.h"
 #include "journal-file.h"
 #include "list.h"
+#include "prioq.h"
 #include "set.h"
 
 typedef struct Match Match;
@@ -33,6 +34,8 @@ struct Match {
         char *data;
         size_t size;
         uint64_t hash; /* old-style jenkins hash. New-style siphash is different per file, hence won't be cached here */
+        sd_id128_t boot_id; /* If this is a _BOOT_ID= match, the boot ID, so that we can check the per-file index */
+        bool is_boot_id;
 
         /* For terms */
         LIST_HEAD(Match, matches);
@@ -64,6 +67,11 @@ struct Directory {
         unsigned last_seen_generation;
 };
 
+typedef struct EntryFieldItem {
+        uint64_t hash;          /* jenkins hash of the field name */
+        size_t field_length;    /* SIZE_MAX if not known, e.g. because the payload is compressed */
+} EntryFieldItem;
+
 struct sd_journal {
         int toplevel_fd;
 
@@ -75,6 +83,13 @@ struct sd_journal {
         IteratedCache *files_cache;
         MMapCache *mmap;
 
+        /* Files with a candidate entry, ordered by the location of that entry in the direction we iterate
+         * in, and files at their end that might still get new entries. Dropped whenever the location or
+         * the set of files changes. */
+        Prioq *files_by_location;
+        Set *files_growing;
+        direction_t files_by_location_direction;
+
         Location current_location;
 
         JournalFile *current_file;
@@ -93,6 +108,7 @@ struct sd_journal {
         char *unique_field;
         JournalFile *unique_file;
         uint64_t unique_offset;
+        Set *unique_values; /* values returned so far, to skip them in later files */
 
         /* Iterating through known fields */
         JournalFile *fields_file;
@@ -101,6 +117,14 @@ struct sd_journal {
         char *fields_buffer;
         size_t fields_buffer_allocated;
 
+        /* Field names of the items of the current entry, collected by sd_journal_get_data() so that further
+         * lookups on the same entry can skip items that can't match */
+        JournalFile *entry_fields_file;
+        uint64_t entry_fields_offset;
+        EntryFieldItem *entry_fields;
+        size_t entry_fields_allocated;
+        uint64_t entry_fields_n_scanned;
+
         int flags;
 
         bool on_network:1;
@@ -113,6 +137,7 @@ struct sd_journal {
         bool fields_file_lost:1;
         bool has_runtime_files:1;
         bool has_persistent_files:1;
+        bool prefetch:1;
 
         size_t data_threshold;
 
@@ -124,6 +149,8 @@ struct sd_journal {
 
 char *journal_make_match_string(sd_journal *j);
 void journal_print_header(sd_journal *j);
+void journal_set_prefetch(sd_journal *j, bool b);
+int journal_seek_entry(sd_journal *j, const char *path, uint64_t offset);
 
 #define JOURNAL_FOREACH_DATA_RETVAL(j, data, l, retval)                     \
         for (sd_journal_restart_data(j); ((retval) = sd_journal_enumerate_data((j), &(data), &(l))) > 0; )
@@ -9,12 +9,17 @@
 #include "alloc-util.h"
 #include "dirent-util.h"
 #include "fd-util.h"
+#include "fileio.h"
 #include "format-util.h"
 #include "fs-util.h"
+#include "hashmap.h"
+#include "io-util.h"
 #include "journal-def.h"
 #include "journal-file.h"
+#include "journal-grep-index.h"
 #include "journal-vacuum.h"
-#include "sort-util.h"
+#include "prioq.h"
+#include "set.h"
 #include "string-util.h"
 #include "time-util.h"
 #include "xattr-util.h"
@@ -28,8 +33,32 @@ struct vacuum_info {
         sd_id128_t seqnum_id;
         uint64_t seqnum;
         bool have_seqnum;
+
+        unsigned prioq_idx;
 };
 
+struct JournalVacuumCache {
+        char *directory;
+        int dir_fd;
+        int inotify_fd; /* -1 if only used for a single run, in which case it is never valid */
+
+        /* Whether the fields below reflect the contents of the directory, i.e. the directory was read
+         * while the inotify watch was in place already and no events got lost since. */
+        bool valid;
+
+        Hashmap *archived; /* filename → struct vacuum_info */
+        Prioq *prioq;      /* struct vacuum_info, oldest first */
+        Set *active;       /* filenames of active journal files */
+        uint64_t sum;      /* disk usage of all archived files */
+};
+
+typedef enum VacuumFileType {
+        VACUUM_FILE_ACTIVE,
+        VACUUM_FILE_ARCHIVED,
+        VACUUM_FILE_GREP_INDEX,
+        VACUUM_FILE_UNKNOWN,
+} VacuumFileType;
+
 static int vacuum_compare(const struct vacuum_info *a, const struct vacuum_info *b) {
         int r;
 
@@ -118,204 +147,471 @@ static int journal_file_empty(int dir_fd, const char *name) {
         return le64toh(n_entries) <= 0;
 }
 
-int journal_directory_vacuum(
-                const char *directory,
-                uint64_t max_use,
-                uint64_t n_max_files,
-                usec_t max_retention_usec,
-                usec_t *oldest_usec,
-                bool verbose) {
+static int vacuum_prioq_compare(const void *a, const void *b) {
+        return vacuum_compare(a, b);
+}
 
-        uint64_t sum = 0, freed = 0, n_active_files = 0;
-        size_t n_list = 0, n_allocated = 0, i;
-        _cleanup_closedir_ DIR *d = NULL;
-        struct vacuum_info *list = NULL;
-        usec_t retention_limit = 0;
+static VacuumFileType vacuum_file_type(const char *fn, struct vacuum_info *ret) {
+        unsigned long long seqnum = 0, realtime;
+        sd_id128_t seqnum_id = {};
+        bool have_seqnum;
+        size_t q;
+
+        assert(fn);
+        assert(ret);
+
+        /* Determines from the file name alone what to do with a file, and for archived files the
+         * sequence number and time they are sorted by. */
+
+        q = strlen(fn);
+
+        if (endswith(fn, ".journal")) {
+
+                /* Vacuum archived files. Active files are
+                 * left around */
+
+                if (q < 1 + 32 + 1 + 16 + 1 + 16 + 8)
+                        return VACUUM_FILE_ACTIVE;
+
+                if (fn[q-8-16-1] != '-' ||
+                    fn[q-8-16-1-16-1] != '-' ||
+                    fn[q-8-16-1-16-1-32-1] != '@')
+                        return VACUUM_FILE_ACTIVE;
+
+                if (sd_id128_from_string(strndupa(fn + q-8-16-1-16-1-32, 32), &seqnum_id) < 0)
+                        return VACUUM_FILE_ACTIVE;
+
+                if (sscanf(fn + q-8-16-1-16, "%16llx-%16llx.journal", &seqnum, &realtime) != 2)
+                        return VACUUM_FILE_ACTIVE;
+
+                have_seqnum = true;
+
+        } else if (endswith(fn, ".journal~")) {
+                unsigned long long tmp;
+
+                /* Vacuum corrupted files */
+
+                if (q < 1 + 16 + 1 + 16 + 8 + 1)
+                        return VACUUM_FILE_ACTIVE;
+
+                if (fn[q-1-8-16-1] != '-' ||
+                    fn[q-1-8-16-1-16-1] != '@')
+                        return VACUUM_FILE_ACTIVE;
+
+                if (sscanf(fn + q-1-8-16-1-16, "%16llx-%16llx.journal~", &realtime, &tmp) != 2)
+                        return VACUUM_FILE_ACTIVE;
+
+                have_seqnum = false;
+
+        } else if (endswith(fn, ".journal" JOURNAL_GREP_INDEX_SUFFIX))
+                return VACUUM_FILE_GREP_INDEX;
+        else
+                return VACUUM_FILE_UNKNOWN;
+
+        *ret = (struct vacuum_info) {
+                .seqnum = seqnum,
+                .realtime = realtime,
+                .seqnum_id = seqnum_id,
+                .have_seqnum = have_seqnum,
+                .prioq_idx = PRIOQ_IDX_NULL,
+        };
+
+        return VACUUM_FILE_ARCHIVED;
+}
+
+static void vacuum_cache_forget(JournalVacuumCache *c, const char *fn) {
+        struct vacuum_info *i;
+
+        assert(c);
+        assert(fn);
+
+        free(set_remove(c->active, fn));
+
+        i = hashmap_remove(c->archived, fn);
+        if (!i)
+                return;
+
+        assert_se(prioq_remove(c->prioq, i, &i->prioq_idx) > 0);
+        c->sum = LESS_BY(c->sum, i->usage);
+
+        free(i->filename);
+        free(i);
+}
+
+static void vacuum_cache_clear(JournalVacuumCache *c) {
+        struct vacuum_info *i;
+
+        assert(c);
+
+        while ((i = prioq_pop(c->prioq))) {
+                free(i->filename);
+                free(i);
+        }
+
+        hashmap_clear(c->archived);
+        set_clear_free(c->active);
+        c->sum = 0;
+}
+
+static int vacuum_cache_add(JournalVacuumCache *c, const char *fn, bool verbose, uint64_t *freed) {
+        _cleanup_free_ struct vacuum_info *i = NULL;
         char sbytes[FORMAT_BYTES_MAX];
-        struct dirent *de;
+        struct vacuum_info info;
+        unsigned long long realtime;
+        struct stat st;
+        uint64_t size;
         int r;
 
-        assert(directory);
+        assert(c);
+        assert(fn);
+        assert(freed);
 
-        if (max_use <= 0 && max_retention_usec <= 0 && n_max_files <= 0)
+        /* (Re-)reads the metadata of the specified file, in case it changed */
+        vacuum_cache_forget(c, fn);
+
+        if (fstatat(c->dir_fd, fn, &st, AT_SYMLINK_NOFOLLOW) < 0) {
+                if (errno != ENOENT)
+                        log_debug_errno(errno, "Failed to stat file %s while vacuuming, ignoring: %m", fn);
                 return 0;
+        }
 
-        if (max_retention_usec > 0)
-                retention_limit = usec_sub_unsigned(now(CLOCK_REALTIME), max_retention_usec);
+        if (!S_ISREG(st.st_mode))
+                return 0;
 
-        d = opendir(directory);
-        if (!d)
-                return -errno;
+        switch (vacuum_file_type(fn, &info)) {
 
-        FOREACH_DIRENT_ALL(de, d, r = -errno; goto finish) {
+        case VACUUM_FILE_ACTIVE:
+                r = set_put_strdup(&c->active, fn);
+                return r < 0 ? r : 0;
 
-                unsigned long long seqnum = 0, realtime;
-                _cleanup_free_ char *p = NULL;
-                sd_id128_t seqnum_id;
-                bool have_seqnum;
-                uint64_t size;
-                struct stat st;
-                size_t q;
+        case VACUUM_FILE_GREP_INDEX: {
+                const char *j;
 
-                if (fstatat(dirfd(d), de->d_name, &st, AT_SYMLINK_NOFOLLOW) < 0) {
-                        log_debug_errno(errno, "Failed to stat file %s while vacuuming, ignoring: %m", de->d_name);
-                        continue;
+                /* Remove indexes whose journal file is gone */
+
+                j = strndupa(fn, strlen(fn) - STRLEN(JOURNAL_GREP_INDEX_SUFFIX));
+                if (faccessat(c->dir_fd, j, F_OK, AT_SYMLINK_NOFOLLOW) < 0 && errno == ENOENT) {
+                        r = journal_grep_index_unlink(c->dir_fd, j);
+                        if (r < 0)
+                                log_debug_errno(r, "Failed to remove stale grep index of %s/%s, ignoring: %m", c->directory, j);
                 }
 
-                if (!S_ISREG(st.st_mode))
-                        continue;
+                return 0;
+        }
 
-                q = strlen(de->d_name);
+        case VACUUM_FILE_UNKNOWN:
+                /* We do not vacuum unknown files! */
+                log_debug("Not vacuuming unknown file %s.", fn);
+                return 0;
 
-                if (endswith(de->d_name, ".journal")) {
+        case VACUUM_FILE_ARCHIVED:
+                break;
+        }
 
-                        /* Vacuum archived files. Active files are
-                         * left around */
+        size = 512UL * (uint64_t) st.st_blocks;
 
-                        if (q < 1 + 32 + 1 + 16 + 1 + 16 + 8) {
-                                n_active_files++;
-                                continue;
-                        }
+        r = journal_file_empty(c->dir_fd, fn);
+        if (r < 0) {
+                log_debug_errno(r, "Failed check if %s is empty, ignoring: %m", fn);
+                return 0;
+        }
+        if (r > 0) {
+                /* Always vacuum empty non-online files. */
 
-                        if (de->d_name[q-8-16-1] != '-' ||
-                            de->d_name[q-8-16-1-16-1] != '-' ||
-                            de->d_name[q-8-16-1-16-1-32-1] != '@') {
-                                n_active_files++;
-                                continue;
-                        }
+                r = unlinkat_deallocate(c->dir_fd, fn, 0);
+                if (r >= 0) {
+                        (void) journal_grep_index_unlink(c->dir_fd, fn);
 
-                        p = strdup(de->d_name);
-                        if (!p) {
-                                r = -ENOMEM;
-                                goto finish;
-                        }
+                        log_full(verbose ? LOG_INFO : LOG_DEBUG,
+                                 "Deleted empty archived journal %s/%s (%s).", c->directory, fn, format_bytes(sbytes, sizeof(sbytes), size));
 
-                        de->d_name[q-8-16-1-16-1] = 0;
-                        if (sd_id128_from_string(de->d_name + q-8-16-1-16-1-32, &seqnum_id) < 0) {
-                                n_active_files++;
-                                continue;
-                        }
+                        *freed += size;
+                } else if (r != -ENOENT)
+                        log_warning_errno(r, "Failed to delete empty archived journal %s/%s: %m", c->directory, fn);
 
-                        if (sscanf(de->d_name + q-8-16-1-16, "%16llx-%16llx.journal", &seqnum, &realtime) != 2) {
-                                n_active_files++;
-                                continue;
-                        }
+                return 0;
+        }
+
+        realtime = info.realtime;
+        patch_realtime(c->dir_fd, fn, &st, &realtime);
+
+        i = newdup(struct vacuum_info, &info, 1);
+        if (!i)
+                return -ENOMEM;
+
+        i->realtime = realtime;
+        i->usage = size;
+        i->filename = strdup(fn);
+        if (!i->filename)
+                return -ENOMEM;
+
+        r = hashmap_ensure_put(&c->archived, &string_hash_ops, i->filename, i);
+        if (r < 0) {
+                free(i->filename);
+                return r;
+        }
+
+        r = prioq_ensure_allocated(&c->prioq, vacuum_prioq_compare);
+        if (r >= 0)
+                r = prioq_put(c->prioq, i, &i->prioq_idx);
+        if (r < 0) {
+                assert_se(hashmap_remove(c->archived, i->filename) == i);
+                free(i->filename);
+                return r;
+        }
+
+        c->sum += size;
+        TAKE_PTR(i);
+
+        return 0;
+}
 
-                        have_seqnum = true;
+static int vacuum_cache_rescan(JournalVacuumCache *c, bool verbose, uint64_t *freed) {
+        _cleanup_closedir_ DIR *d = NULL;
+        bool watched = false;
+        struct dirent *de;
+        int r;
 
-                } else if (endswith(de->d_name, ".journal~")) {
-                        unsigned long long tmp;
+        assert(c);
 
-                        /* Vacuum corrupted files */
+        vacuum_cache_clear(c);
+        c->dir_fd = safe_close(c->dir_fd);
 
-                        if (q < 1 + 16 + 1 + 16 + 8 + 1) {
-                                n_active_files++;
+        c->dir_fd = open(c->directory, O_RDONLY|O_DIRECTORY|O_CLOEXEC);
+        if (c->dir_fd < 0)
+                return -errno;
+
+        /* Install the watch before reading the directory, so that we don't miss anything that happens
+         * in between. A watch that was installed before is simply updated, and whatever it queued up so
+         * far is outdated by reading the directory. */
+        if (c->inotify_fd >= 0) {
+                (void) flush_fd(c->inotify_fd);
+
+                r = inotify_add_watch_fd(c->inotify_fd, c->dir_fd,
+                                         IN_CREATE|IN_DELETE|IN_MOVED_FROM|IN_MOVED_TO|IN_CLOSE_WRITE|
+                                         IN_DELETE_SELF|IN_MOVE_SELF|IN_ONLYDIR);
+                if (r < 0)
+                        log_debug_errno(r, "Failed to watch %s, rereading it on every vacuum: %m", c->directory);
+                else
+                        watched = true;
+        }
+
+        d = xopendirat(c->dir_fd, ".", 0);
+        if (!d)
+                return -errno;
+
+        FOREACH_DIRENT_ALL(de, d, return -errno) {
+                r = vacuum_cache_add(c, de->d_name, verbose, freed);
+                if (r < 0)
+                        return r;
+        }
+
+        c->valid = watched;
+        return 0;
+}
+
+static int vacuum_cache_process_events(JournalVacuumCache *c, bool verbose, uint64_t *freed) {
+        union inotify_event_buffer buffer;
+        struct inotify_event *e;
+        ssize_t l;
+        int r;
+
+        assert(c);
+        assert(c->inotify_fd >= 0);
+
+        /* Applies whatever happened in the directory since we looked last, so that we only have to look at
+         * the files that changed. */
+
+        for (;;) {
+                l = read(c->inotify_fd, &buffer, sizeof(buffer));
+                if (l < 0) {
+                        if (IN_SET(errno, EAGAIN, EINTR))
+                                return 0;
+
+                        return -errno;
+                }
+
+                FOREACH_INOTIFY_EVENT(e, buffer, l) {
+                        if (e->mask & (IN_Q_OVERFLOW|IN_IGNORED|IN_DELETE_SELF|IN_MOVE_SELF|IN_UNMOUNT)) {
+                                c->valid = false;
                                 continue;
                         }
 
-                        if (de->d_name[q-1-8-16-1] != '-' ||
-                            de->d_name[q-1-8-16-1-16-1] != '@') {
-                                n_active_files++;
+                        if (!c->valid || e->len == 0)
                                 continue;
-                        }
 
-                        p = strdup(de->d_name);
-                        if (!p) {
-                                r = -ENOMEM;
-                                goto finish;
+                        if (e->mask & (IN_DELETE|IN_MOVED_FROM))
+                                vacuum_cache_forget(c, e->name);
+                        else {
+                                r = vacuum_cache_add(c, e->name, verbose, freed);
+                                if (r < 0)
+                                        c->valid = false;
                         }
+                }
+        }
+}
 
-                        if (sscanf(de->d_name + q-1-8-16-1-16, "%16llx-%16llx.journal~", &realtime, &tmp) != 2) {
-                                n_active_files++;
-                                continue;
-                        }
+static int vacuum_cache_new(const char *directory, bool watch, JournalVacuumCache **ret) {
+        _cleanup_(journal_vacuum_cache_freep) JournalVacuumCache *c = NULL;
 
-                        have_seqnum = false;
-                } else {
-                        /* We do not vacuum unknown files! */
-                        log_debug("Not vacuuming unknown file %s.", de->d_name);
-                        continue;
-                }
+        assert(directory);
+        assert(ret);
 
-                size = 512UL * (uint64_t) st.st_blocks;
+        c = new(JournalVacuumCache, 1);
+        if (!c)
+                return -ENOMEM;
 
-                r = journal_file_empty(dirfd(d), p);
-                if (r < 0) {
-                        log_debug_errno(r, "Failed check if %s is empty, ignoring: %m", p);
-                        continue;
-                }
-                if (r > 0) {
-                        /* Always vacuum empty non-online files. */
+        *c = (JournalVacuumCache) {
+                .dir_fd = -1,
+                .inotify_fd = -1,
+        };
 
-                        r = unlinkat_deallocate(dirfd(d), p, 0);
-                        if (r >= 0) {
+        c->directory = strdup(directory);
+        if (!c->directory)
+                return -ENOMEM;
 
-                                log_full(verbose ? LOG_INFO : LOG_DEBUG,
-                                         "Deleted empty archived journal %s/%s (%s).", directory, p, format_bytes(sbytes, sizeof(sbytes), size));
+        if (watch) {
+                c->inotify_fd = inotify_init1(IN_NONBLOCK|IN_CLOEXEC);
+                if (c->inotify_fd < 0)
+                        return -errno;
+        }
 
-                                freed += size;
-                        } else if (r != -ENOENT)
-                                log_warning_errno(r, "Failed to delete empty archived journal %s/%s: %m", directory, p);
+        *ret = TAKE_PTR(c);
+        return 0;
+}
 
-                        continue;
-                }
+int journal_vacuum_cache_new(const char *directory, JournalVacuumCache **ret) {
+        return vacuum_cache_new(directory, true, ret);
+}
 
-                patch_realtime(dirfd(d), p, &st, &realtime);
+JournalVacuumCache* journal_vacuum_cache_free(JournalVacuumCache *c) {
+        if (!c)
+                return NULL;
 
-                if (!GREEDY_REALLOC(list, n_allocated, n_list + 1)) {
-                        r = -ENOMEM;
-                        goto finish;
-                }
+        vacuum_cache_clear(c);
+        hashmap_free(c->archived);
+        prioq_free(c->prioq);
+        set_free(c->active);
 
-                list[n_list++] = (struct vacuum_info) {
-                        .filename = TAKE_PTR(p),
-                        .usage = size,
-                        .seqnum = seqnum,
-                        .realtime = realtime,
-                        .seqnum_id = seqnum_id,
-                        .have_seqnum = have_seqnum,
-                };
+        safe_close(c->dir_fd);
+        safe_close(c->inotify_fd);
+        free(c->directory);
 
-                sum += size;
-        }
+        return mfree(c);
+}
 
-        typesafe_qsort(list, n_list, vacuum_compare);
+int journal_vacuum_cache_vacuum(
+                JournalVacuumCache *c,
+                uint64_t max_use,
+                uint64_t n_max_files,
+                usec_t max_retention_usec,
+                usec_t *oldest_usec,
+                bool verbose) {
+
+        _cleanup_free_ struct vacuum_info **failed = NULL;
+        size_t n_failed = 0, n_failed_allocated = 0;
+        uint64_t freed = 0, left;
+        struct vacuum_info *i;
+        usec_t retention_limit = 0;
+        char sbytes[FORMAT_BYTES_MAX];
+        int r;
+
+        assert(c);
+
+        /* Like journal_directory_vacuum(), but only rereads the directory if we lost track of it. Otherwise
+         * only the files are looked at that were added or changed since the last run. */
+
+        if (max_use <= 0 && max_retention_usec <= 0 && n_max_files <= 0)
+                return 0;
+
+        if (max_retention_usec > 0)
+                retention_limit = usec_sub_unsigned(now(CLOCK_REALTIME), max_retention_usec);
+
+        if (c->valid) {
+                r = vacuum_cache_process_events(c, verbose, &freed);
+                if (r < 0)
+                        log_debug_errno(r, "Failed to read inotify events for %s, rereading directory: %m", c->directory);
+        }
+        if (!c->valid) {
+                r = vacuum_cache_rescan(c, verbose, &freed);
+                if (r < 0)
+                        goto finish;
+        }
 
-        for (i = 0; i < n_list; i++) {
-                uint64_t left;
+        left = set_size(c->active) + prioq_size(c->prioq);
 
-                left = n_active_files + n_list - i;
+        while ((i = prioq_peek(c->prioq))) {
 
-                if ((max_retention_usec <= 0 || list[i].realtime >= retention_limit) &&
-                    (max_use <= 0 || sum <= max_use) &&
+                if ((max_retention_usec <= 0 || i->realtime >= retention_limit) &&
+                    (max_use <= 0 || c->sum <= max_use) &&
                     (n_max_files <= 0 || left <= n_max_files))
                         break;
 
-                r = unlinkat_deallocate(dirfd(d), list[i].filename, 0);
+                left--;
+
+                r = unlinkat_deallocate(c->dir_fd, i->filename, 0);
                 if (r >= 0) {
-                        log_full(verbose ? LOG_INFO : LOG_DEBUG, "Deleted archived journal %s/%s (%s).", directory, list[i].filename, format_bytes(sbytes, sizeof(sbytes), list[i].usage));
-                        freed += list[i].usage;
+                        (void) journal_grep_index_unlink(c->dir_fd, i->filename);
+                        log_full(verbose ? LOG_INFO : LOG_DEBUG, "Deleted archived journal %s/%s (%s).", c->directory, i->filename, format_bytes(sbytes, sizeof(sbytes), i->usage));
+                        freed += i->usage;
+                } else if (r != -ENOENT) {
+                        log_warning_errno(r, "Failed to delete archived journal %s/%s: %m", c->directory, i->filename);
+
+                        /* Try again next time, but move on to the next file for now. It still counts towards
+                         * the disk usage. */
+                        if (!GREEDY_REALLOC(failed, n_failed_allocated, n_failed + 1)) {
+                                r = -ENOMEM;
+                                goto finish;
+                        }
 
-                        if (list[i].usage < sum)
-                                sum -= list[i].usage;
-                        else
-                                sum = 0;
+                        assert_se(prioq_pop(c->prioq) == i);
+                        failed[n_failed++] = i;
+                        continue;
+                }
 
-                } else if (r != -ENOENT)
-                        log_warning_errno(r, "Failed to delete archived journal %s/%s: %m", directory, list[i].filename);
+                vacuum_cache_forget(c, i->filename);
         }
 
-        if (oldest_usec && i < n_list && (*oldest_usec == 0 || list[i].realtime < *oldest_usec))
-                *oldest_usec = list[i].realtime;
+        if (oldest_usec && i && (*oldest_usec == 0 || i->realtime < *oldest_usec))
+                *oldest_usec = i->realtime;
 
         r = 0;
 
 finish:
-        for (i = 0; i < n_list; i++)
-                free(list[i].filename);
-        free(list);
+        for (size_t k = 0; k < n_failed; k++)
+                if (prioq_put(c->prioq, failed[k], &failed[k]->prioq_idx) < 0) {
+                        /* Can't happen, as the queue had room for this entry before, but let's be safe */
+                        assert_se(hashmap_remove(c->archived, failed[k]->filename) == failed[k]);
+                        c->sum = LESS_BY(c->sum, failed[k]->usage);
+                        free(failed[k]->filename);
+                        free(failed[k]);
+                }
 
-        log_full(verbose ? LOG_INFO : LOG_DEBUG, "Vacuuming done, freed %s of archived journals from %s.", format_bytes(sbytes, sizeof(sbytes), freed), directory);
+        log_full(verbose ? LOG_INFO : LOG_DEBUG, "Vacuuming done, freed %s of archived journals from %s.", format_bytes(sbytes, sizeof(sbytes), freed), c->directory);
 
         return r;
 }
+
+int journal_directory_vacuum(
+                const char *directory,
+                uint64_t max_use,
+                uint64_t n_max_files,
+                usec_t max_retention_usec,
+                usec_t *oldest_usec,
+                bool verbose) {
+
+        _cleanup_(journal_vacuum_cache_freep) JournalVacuumCache *c = NULL;
+        int r;
+
+        assert(directory);
+
+        if (max_use <= 0 && max_retention_usec <= 0 && n_max_files <= 0)
+                return 0;
+
+        /* A one-shot cache without an inotify watch, i.e. reads the whole directory */
+        r = vacuum_cache_new(directory, false, &c);
+        if (r < 0)
+                return r;
+
+        return journal_vacuum_cache_vacuum(c, max_use, n_max_files, max_retention_usec, oldest_usec, verbose);
+}
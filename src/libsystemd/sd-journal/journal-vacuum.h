@@ -4,6 +4,17 @@
 #include <inttypes.h>
 #include <stdbool.h>
 
+#include "macro.h"
 #include "time-util.h"
 
+/* Keeps track of the archived files in a journal directory with an inotify watch, so that repeated vacuuming
+ * of the same directory only has to look at the files that changed since the last run. */
+typedef struct JournalVacuumCache JournalVacuumCache;
+
+int journal_vacuum_cache_new(const char *directory, JournalVacuumCache **ret);
+JournalVacuumCache* journal_vacuum_cache_free(JournalVacuumCache *c);
+DEFINE_TRIVIAL_CLEANUP_FUNC(JournalVacuumCache*, journal_vacuum_cache_free);
+
+int journal_vacuum_cache_vacuum(JournalVacuumCache *c, uint64_t max_use, uint64_t n_max_files, usec_t max_retention_usec, usec_t *oldest_usec, bool verbose);
+
 int journal_directory_vacuum(const char *directory, uint64_t max_use, uint64_t n_max_files, usec_t max_retention_usec, usec_t *oldest_usec, bool verbose);
@@ -7,6 +7,7 @@
 #include "alloc-util.h"
 #include "errno-util.h"
 #include "fd-util.h"
+#include "format-util.h"
 #include "hashmap.h"
 #include "list.h"
 #include "log.h"
@@ -45,19 +46,31 @@ struct Context {
         LIST_FIELDS(Context, by_window);
 };
 
+typedef struct AccessPattern {
+        /* The range of the window created last for this context, and the size to use for the next one */
+        uint64_t offset;
+        uint64_t size;
+        uint64_t window_size;
+} AccessPattern;
+
 struct MMapFileDescriptor {
         MMapCache *cache;
         int fd;
         int prot;
         bool sigbus;
         LIST_HEAD(Window, windows);
+
+        AccessPattern access[MMAP_CACHE_MAX_CONTEXTS];
 };
 
 struct MMapCache {
         unsigned n_ref;
         unsigned n_windows;
 
-        unsigned n_context_cache_hit, n_window_list_hit, n_missed;
+        unsigned n_context_cache_hit, n_window_list_hit, n_missed, n_evicted;
+        unsigned n_window_grown, n_window_shrunk;
+
+        uint64_t n_bytes_mapped, n_bytes_mapped_max;
 
         Hashmap *fds;
         Context *contexts[MMAP_CACHE_MAX_CONTEXTS];
@@ -70,11 +83,21 @@ struct MMapCache {
 
 #if ENABLE_DEBUG_MMAP_CACHE
 /* Tiny windows increase mmap activity and the chance of exposing unsafe use. */
-# define WINDOW_SIZE (page_size())
+# define WINDOW_SIZE_DEFAULT (page_size())
+# define WINDOW_SIZE_MIN (page_size())
+# define WINDOW_SIZE_MAX (page_size())
 #else
-# define WINDOW_SIZE (8ULL*1024ULL*1024ULL)
+/* Windows start out at the default size, grow for sequential scans and shrink for random access, such as
+ * bisection. */
+# define WINDOW_SIZE_DEFAULT (8ULL*1024ULL*1024ULL)
+# define WINDOW_SIZE_MIN (1ULL*1024ULL*1024ULL)
+# define WINDOW_SIZE_MAX (64ULL*1024ULL*1024ULL)
 #endif
 
+/* Once this many bytes are mapped, unused windows are released before new ones are created, regardless of
+ * WINDOWS_MIN. Windows that are in use are never released, hence this is a soft limit. */
+#define MAPPED_BYTES_MAX (sizeof(void*) > 4 ? 1024ULL*1024ULL*1024ULL : 256ULL*1024ULL*1024ULL)
+
 MMapCache* mmap_cache_new(void) {
         MMapCache *m;
 
@@ -91,9 +114,13 @@ static void window_unlink(Window *w) {
 
         assert(w);
 
-        if (w->ptr)
+        if (w->ptr) {
                 munmap(w->ptr, w->size);
 
+                assert(w->cache->n_bytes_mapped >= w->size);
+                w->cache->n_bytes_mapped -= w->size;
+        }
+
         if (w->fd)
                 LIST_REMOVE(by_fd, w->fd->windows, w);
 
@@ -158,7 +185,7 @@ static Window *window_add(MMapCache *m, MMapFileDescriptor *f, bool keep_always,
         assert(m);
         assert(f);
 
-        if (!m->last_unused || m->n_windows <= WINDOWS_MIN) {
+        if (!m->last_unused || (m->n_windows <= WINDOWS_MIN && m->n_bytes_mapped + size <= MAPPED_BYTES_MAX)) {
 
                 /* Allocate a new window */
                 w = new(Window, 1);
@@ -170,6 +197,7 @@ static Window *window_add(MMapCache *m, MMapFileDescriptor *f, bool keep_always,
                 /* Reuse an existing one */
                 w = m->last_unused;
                 window_unlink(w);
+                m->n_evicted++;
         }
 
         *w = (Window) {
@@ -183,6 +211,9 @@ static Window *window_add(MMapCache *m, MMapFileDescriptor *f, bool keep_always,
 
         LIST_PREPEND(by_fd, f->windows, w);
 
+        m->n_bytes_mapped += size;
+        m->n_bytes_mapped_max = MAX(m->n_bytes_mapped_max, m->n_bytes_mapped);
+
         return w;
 }
 
@@ -296,6 +327,7 @@ static int make_room(MMapCache *m) {
                 return 0;
 
         window_free(m->last_unused);
+        m->n_evicted++;
         return 1;
 }
 
@@ -408,6 +440,56 @@ static int mmap_try_harder(MMapCache *m, void *addr, MMapFileDescriptor *f, int
         return 0;
 }
 
+static uint64_t access_pattern_next_window(
+                MMapCache *m,
+                AccessPattern *a,
+                uint64_t offset,
+                size_t size,
+                int *ret_direction) {
+
+        int direction = 0;
+
+        assert(m);
+        assert(a);
+        assert(size > 0);
+        assert(ret_direction);
+
+        if (a->window_size == 0)
+                a->window_size = WINDOW_SIZE_DEFAULT;
+
+        /* A miss right after or right before the window we created last for this context indicates a
+         * sequential scan, anything else is considered random access. */
+        if (a->size > 0) {
+                if (offset >= a->offset && offset <= a->offset + a->size + a->window_size)
+                        direction = 1;
+                else if (offset < a->offset && offset + size + a->window_size >= a->offset)
+                        direction = -1;
+        }
+
+        if (direction != 0) {
+                if (a->window_size < WINDOW_SIZE_MAX) {
+                        a->window_size = MIN(a->window_size * 2, WINDOW_SIZE_MAX);
+                        m->n_window_grown++;
+                }
+        } else if (a->size > 0 && a->window_size > WINDOW_SIZE_MIN) {
+                a->window_size = MAX(a->window_size / 2, WINDOW_SIZE_MIN);
+                m->n_window_shrunk++;
+        }
+
+        *ret_direction = direction;
+        return a->window_size;
+}
+
+static void make_room_for(MMapCache *m, uint64_t size) {
+        assert(m);
+
+        /* Release unused windows until the new one fits into the budget, or there is nothing left to
+         * release. */
+        while (m->n_bytes_mapped + size > MAPPED_BYTES_MAX)
+                if (make_room(m) <= 0)
+                        break;
+}
+
 static int add_mmap(
                 MMapCache *m,
                 MMapFileDescriptor *f,
@@ -418,7 +500,9 @@ static int add_mmap(
                 struct stat *st,
                 void **ret) {
 
-        uint64_t woffset, wsize;
+        uint64_t woffset, wsize, window_size;
+        AccessPattern *a;
+        int direction;
         Context *c;
         Window *w;
         void *d;
@@ -430,21 +514,31 @@ static int add_mmap(
         assert(size > 0);
         assert(ret);
 
+        a = f->access + context;
+        window_size = access_pattern_next_window(m, a, offset, size, &direction);
+
         woffset = offset & ~((uint64_t) page_size() - 1ULL);
         wsize = size + (offset - woffset);
         wsize = PAGE_ALIGN(wsize);
 
-        if (wsize < WINDOW_SIZE) {
+        if (wsize < window_size) {
                 uint64_t delta;
 
-                delta = PAGE_ALIGN((WINDOW_SIZE - wsize) / 2);
+                /* Extend the window in the direction of the scan, or center it on the requested range if
+                 * there is no discernible direction. */
+                if (direction > 0)
+                        delta = 0;
+                else if (direction < 0)
+                        delta = window_size - wsize;
+                else
+                        delta = PAGE_ALIGN((window_size - wsize) / 2);
 
-                if (delta > offset)
+                if (delta > woffset)
                         woffset = 0;
                 else
                         woffset -= delta;
 
-                wsize = WINDOW_SIZE;
+                wsize = window_size;
         }
 
         if (st) {
@@ -459,6 +553,8 @@ static int add_mmap(
                         wsize = PAGE_ALIGN(st->st_size - woffset);
         }
 
+        make_room_for(m, wsize);
+
         r = mmap_try_harder(m, NULL, f, MAP_SHARED, woffset, wsize, &d);
         if (r < 0)
                 return r;
@@ -473,6 +569,9 @@ static int add_mmap(
 
         context_attach_window(c, w);
 
+        a->offset = woffset;
+        a->size = wsize;
+
         *ret = (uint8_t*) w->ptr + (offset - w->offset);
 
         return 1;
@@ -522,9 +621,16 @@ int mmap_cache_get(
 }
 
 void mmap_cache_stats_log_debug(MMapCache *m) {
+        char cur[FORMAT_BYTES_MAX], max[FORMAT_BYTES_MAX];
+
         assert(m);
 
-        log_debug("mmap cache statistics: %u context cache hit, %u window list hit, %u miss", m->n_context_cache_hit, m->n_window_list_hit, m->n_missed);
+        log_debug("mmap cache statistics: %u context cache hit, %u window list hit, %u miss, %u evicted, "
+                  "%u windows grown, %u windows shrunk, %u windows, %s mapped (%s max)",
+                  m->n_context_cache_hit, m->n_window_list_hit, m->n_missed, m->n_evicted,
+                  m->n_window_grown, m->n_window_shrunk, m->n_windows,
+                  format_bytes(cur, sizeof(cur), m->n_bytes_mapped),
+                  format_bytes(max, sizeof(max), m->n_bytes_mapped_max));
 }
 
 static void mmap_cache_process_sigbus(MMapCache *m) {
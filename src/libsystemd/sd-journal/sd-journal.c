@@ -52,6 +52,7 @@
 #define DEFAULT_DATA_THRESHOLD (64*1024)
 
 static void remove_file_real(sd_journal *j, JournalFile *f);
+static int return_data(sd_journal *j, JournalFile *f, Object *o, const void **data, size_t *size);
 
 static bool journal_pid_changed(sd_journal *j) {
         assert(j);
@@ -98,6 +99,21 @@ static int journal_put_error(sd_journal *j, int r, const char *path) {
         return 0;
 }
 
+static void invalidate_files_by_location(sd_journal *j) {
+        JournalFile *f;
+
+        assert(j);
+
+        if (!j->files_by_location && !j->files_growing)
+                return;
+
+        j->files_by_location = prioq_free(j->files_by_location);
+        j->files_growing = set_free(j->files_growing);
+
+        ORDERED_HASHMAP_FOREACH(f, j->files)
+                f->location_prioq_idx = PRIOQ_IDX_NULL;
+}
+
 static void detach_location(sd_journal *j) {
         JournalFile *f;
 
@@ -106,6 +122,8 @@ static void detach_location(sd_journal *j) {
         j->current_file = NULL;
         j->current_field = 0;
 
+        invalidate_files_by_location(j);
+
         ORDERED_HASHMAP_FOREACH(f, j->files)
                 journal_file_reset_location(f);
 }
@@ -316,6 +334,15 @@ _public_ int sd_journal_add_match(sd_journal *j, const void *data, size_t size)
         if (!m->data)
                 goto fail;
 
+        if (size == STRLEN("_BOOT_ID=") + 32 && memcmp(data, "_BOOT_ID=", STRLEN("_BOOT_ID=")) == 0) {
+                char id[SD_ID128_STRING_MAX];
+
+                memcpy(id, m->data + STRLEN("_BOOT_ID="), 32);
+                id[32] = 0;
+
+                m->is_boot_id = sd_id128_from_string(id, &m->boot_id) >= 0;
+        }
+
         detach_location(j);
 
         return 0;
@@ -481,6 +508,97 @@ _pure_ static int compare_with_location(const JournalFile *f, const Location *l,
         return 0;
 }
 
+static int file_collect_boot_ids(sd_journal *j, JournalFile *f) {
+        _cleanup_free_ sd_id128_t *ids = NULL;
+        size_t n = 0, allocated = 0;
+        uint64_t p, n_entries;
+        Object *o;
+        int r;
+
+        assert(j);
+        assert(f);
+
+        /* Collects the boot IDs of the file by walking the data objects of the _BOOT_ID= field, so that
+         * boot ID matches can be checked against memory rather than the on-disk hash table of every file.
+         * Archived files never change, for all others we redo this when new entries show up. */
+
+        if (!JOURNAL_HEADER_CONTAINS(f->header, n_data))
+                return -EOPNOTSUPP;
+
+        n_entries = le64toh(READ_NOW(f->header->n_entries));
+        if (f->boot_ids_valid && f->boot_ids_n_entries == n_entries)
+                return 0;
+
+        r = journal_file_find_field_object(f, "_BOOT_ID", STRLEN("_BOOT_ID"), &o, NULL);
+        if (r < 0)
+                return r;
+
+        for (p = r > 0 ? le64toh(o->field.head_data_offset) : 0; p > 0; p = le64toh(o->data.next_field_offset)) {
+                char id[SD_ID128_STRING_MAX];
+                const void *data;
+                size_t size;
+
+                /* Don't get caught in loops on corrupted files */
+                if (n >= le64toh(f->header->n_data))
+                        return -EBADMSG;
+
+                r = journal_file_move_to_object(f, OBJECT_DATA, p, &o);
+                if (r < 0)
+                        return r;
+
+                r = return_data(j, f, o, &data, &size);
+                if (r < 0)
+                        return r;
+
+                if (size != STRLEN("_BOOT_ID=") + 32 || memcmp(data, "_BOOT_ID=", STRLEN("_BOOT_ID=")) != 0)
+                        return -EBADMSG;
+
+                memcpy(id, (const char*) data + STRLEN("_BOOT_ID="), 32);
+                id[32] = 0;
+
+                if (!GREEDY_REALLOC(ids, allocated, n + 1))
+                        return -ENOMEM;
+
+                r = sd_id128_from_string(id, ids + n);
+                if (r < 0)
+                        return r;
+
+                n++;
+        }
+
+        free_and_replace(f->boot_ids, ids);
+        f->n_boot_ids = n;
+        f->boot_ids_n_entries = n_entries;
+        f->boot_ids_valid = true;
+
+        return 0;
+}
+
+static bool file_may_contain_match(sd_journal *j, JournalFile *f, Match *m) {
+        int r;
+
+        assert(j);
+        assert(f);
+        assert(m);
+        assert(m->type == MATCH_DISCRETE);
+
+        if (!m->is_boot_id)
+                return true;
+
+        r = file_collect_boot_ids(j, f);
+        if (r < 0) {
+                /* Let the regular lookup deal with it */
+                log_debug_errno(r, "Failed to collect boot IDs of %s, ignoring: %m", f->path);
+                return true;
+        }
+
+        for (size_t i = 0; i < f->n_boot_ids; i++)
+                if (sd_id128_equal(f->boot_ids[i], m->boot_id))
+                        return true;
+
+        return false;
+}
+
 static int next_for_match(
                 sd_journal *j,
                 Match *m,
@@ -501,6 +619,9 @@ static int next_for_match(
         if (m->type == MATCH_DISCRETE) {
                 uint64_t dp, hash;
 
+                if (!file_may_contain_match(j, f, m))
+                        return 0;
+
                 /* If the keyed hash logic is used, we need to calculate the hash fresh per file. Otherwise
                  * we can use what we pre-calculated. */
                 if (JOURNAL_HEADER_KEYED_HASH(f->header))
@@ -597,6 +718,9 @@ static int find_location_for_match(
         if (m->type == MATCH_DISCRETE) {
                 uint64_t dp, hash;
 
+                if (!file_may_contain_match(j, f, m))
+                        return 0;
+
                 if (JOURNAL_HEADER_KEYED_HASH(f->header))
                         hash = journal_file_hash_data(f, m->data, m->size);
                 else
@@ -745,6 +869,30 @@ static int next_with_matches(
                               direction, ret, offset);
 }
 
+static bool file_may_contain_location(sd_journal *j, JournalFile *f, direction_t direction) {
+        const Location *l;
+
+        assert(j);
+        assert(f);
+
+        /* When seeking by wallclock time only, files whose entries all lie before (or after, when going
+         * backwards) the seek position cannot contain a candidate, and there's no point in bisecting them. */
+
+        l = &j->current_location;
+        if (l->type != LOCATION_SEEK || !l->realtime_set || l->monotonic_set)
+                return true;
+        if (l->seqnum_set && sd_id128_equal(l->seqnum_id, f->header->seqnum_id))
+                return true;
+
+        if (le64toh(f->header->n_entries) == 0)
+                return true;
+
+        if (direction == DIRECTION_DOWN)
+                return le64toh(f->header->tail_entry_realtime) >= l->realtime;
+        else
+                return le64toh(f->header->head_entry_realtime) <= l->realtime;
+}
+
 static int next_beyond_location(sd_journal *j, JournalFile *f, direction_t direction) {
         Object *c;
         uint64_t cp, n_entries;
@@ -777,6 +925,9 @@ static int next_beyond_location(sd_journal *j, JournalFile *f, direction_t direc
         } else {
                 f->last_direction = direction;
 
+                if (!file_may_contain_location(j, f, direction))
+                        return 0;
+
                 r = find_location_with_matches(j, f, direction, &c, &cp);
                 if (r <= 0)
                         return r;
@@ -813,48 +964,136 @@ static int next_beyond_location(sd_journal *j, JournalFile *f, direction_t direc
         }
 }
 
-static int real_journal_next(sd_journal *j, direction_t direction) {
-        JournalFile *new_file = NULL;
-        unsigned i, n_files;
-        const void **files;
-        Object *o;
+static int file_location_compare_down(const void *a, const void *b) {
+        return journal_file_compare_locations((JournalFile*) a, (JournalFile*) b);
+}
+
+static int file_location_compare_up(const void *a, const void *b) {
+        return journal_file_compare_locations((JournalFile*) b, (JournalFile*) a);
+}
+
+static int update_file_location(sd_journal *j, JournalFile *f, direction_t direction) {
         int r;
 
-        assert_return(j, -EINVAL);
-        assert_return(!journal_pid_changed(j), -ECHILD);
+        assert(j);
+        assert(f);
+        assert(j->files_by_location);
+
+        /* Moves the file to its next candidate entry beyond the current location, and updates its place in
+         * the queue. Returns 0 if the file had to be dropped, which invalidates the queue. */
 
-        r = iterated_cache_get(j->files_cache, NULL, &files, &n_files);
+        r = next_beyond_location(j, f, direction);
+        if (r < 0) {
+                log_debug_errno(r, "Can't iterate through %s, ignoring: %m", f->path);
+                remove_file_real(j, f);
+                return 0;
+        }
+        if (r == 0) {
+                f->location_type = LOCATION_TAIL;
+                prioq_remove(j->files_by_location, f, &f->location_prioq_idx);
+
+                /* Archived files never change, hence there is no need to look at them again. */
+                if (f->header->state != STATE_ARCHIVED) {
+                        r = set_ensure_put(&j->files_growing, NULL, f);
+                        if (r < 0)
+                                return r;
+                }
+
+                return 1;
+        }
+
+        set_remove(j->files_growing, f);
+
+        if (f->location_prioq_idx == PRIOQ_IDX_NULL)
+                r = prioq_put(j->files_by_location, f, &f->location_prioq_idx);
+        else
+                r = prioq_reshuffle(j->files_by_location, f, &f->location_prioq_idx);
         if (r < 0)
                 return r;
 
-        for (i = 0; i < n_files; i++) {
-                JournalFile *f = (JournalFile *)files[i];
-                bool found;
+        return 1;
+}
 
-                r = next_beyond_location(j, f, direction);
-                if (r < 0) {
-                        log_debug_errno(r, "Can't iterate through %s, ignoring: %m", f->path);
-                        remove_file_real(j, f);
-                        continue;
-                } else if (r == 0) {
-                        f->location_type = LOCATION_TAIL;
-                        continue;
-                }
+static int update_files_by_location(sd_journal *j, direction_t direction) {
+        JournalFile *f;
+        int r;
 
-                if (!new_file)
-                        found = true;
-                else {
-                        int k;
+        assert(j);
+
+        if (!j->files_by_location || j->files_by_location_direction != direction) {
+                unsigned n_files;
+                const void **files;
+
+                /* Look at every file and queue its candidate entry */
+
+                invalidate_files_by_location(j);
+
+                j->files_by_location = prioq_new(direction == DIRECTION_DOWN ? file_location_compare_down : file_location_compare_up);
+                if (!j->files_by_location)
+                        return -ENOMEM;
+
+                j->files_by_location_direction = direction;
 
-                        k = journal_file_compare_locations(f, new_file);
+                r = iterated_cache_get(j->files_cache, NULL, &files, &n_files);
+                if (r < 0)
+                        return r;
 
-                        found = direction == DIRECTION_DOWN ? k < 0 : k > 0;
+                for (unsigned i = 0; i < n_files; i++) {
+                        r = update_file_location(j, (JournalFile*) files[i], direction);
+                        if (r <= 0)
+                                return r;
                 }
 
-                if (found)
-                        new_file = f;
+        } else {
+                /* Only the file whose entry we picked last moved, and files at their end might have new
+                 * entries now. All other files still point to their candidate entry. */
+
+                if (j->current_file && j->current_file->location_type == LOCATION_DISCRETE) {
+                        r = update_file_location(j, j->current_file, direction);
+                        if (r <= 0)
+                                return r;
+                }
+
+                SET_FOREACH(f, j->files_growing)
+                        if (le64toh(f->header->n_entries) != f->last_n_entries) {
+                                r = update_file_location(j, f, direction);
+                                if (r <= 0)
+                                        return r;
+                        }
         }
 
+        /* The candidate of the first file might be the very entry we are looking at right now, if it is
+         * also stored in another file. Advance it until it is beyond the current location. */
+        while ((f = prioq_peek(j->files_by_location))) {
+                uint64_t offset = f->current_offset;
+
+                r = update_file_location(j, f, direction);
+                if (r <= 0)
+                        return r;
+
+                if (f->location_type == LOCATION_SEEK && f->current_offset == offset)
+                        break;
+        }
+
+        return 1;
+}
+
+static int real_journal_next(sd_journal *j, direction_t direction) {
+        JournalFile *new_file;
+        Object *o;
+        int r;
+
+        assert_return(j, -EINVAL);
+        assert_return(!journal_pid_changed(j), -ECHILD);
+
+        /* Try again if a file had to be dropped */
+        do {
+                r = update_files_by_location(j, direction);
+                if (r < 0)
+                        return r;
+        } while (r == 0);
+
+        new_file = prioq_peek(j->files_by_location);
         if (!new_file)
                 return 0;
 
@@ -1355,6 +1594,9 @@ static int add_any_file(
         close_fd = false; /* the fd is now owned by the JournalFile object */
 
         f->last_seen_generation = j->generation;
+        f->prefetch = j->prefetch;
+        f->location_prioq_idx = PRIOQ_IDX_NULL;
+        invalidate_files_by_location(j);
 
         track_file_disposition(j, f);
         check_network(j, f->fd);
@@ -1423,6 +1665,8 @@ static void remove_file_real(sd_journal *j, JournalFile *f) {
         assert(j);
         assert(f);
 
+        invalidate_files_by_location(j);
+
         (void) ordered_hashmap_remove(j->files, f->path);
 
         log_debug("File %s removed.", f->path);
@@ -1447,6 +1691,9 @@ static void remove_file_real(sd_journal *j, JournalFile *f) {
                         j->fields_file_lost = true;
         }
 
+        if (j->entry_fields_file == f)
+                j->entry_fields_file = NULL;
+
         (void) journal_file_close(f);
 
         j->current_invalidate_counter++;
@@ -2152,6 +2399,7 @@ _public_ void sd_journal_close(sd_journal *j) {
 
         sd_journal_flush_matches(j);
 
+        invalidate_files_by_location(j);
         ordered_hashmap_free_with_destructor(j->files, journal_file_close);
         iterated_cache_free(j->files_cache);
 
@@ -2177,7 +2425,9 @@ _public_ void sd_journal_close(sd_journal *j) {
         free(j->prefix);
         free(j->namespace);
         free(j->unique_field);
+        set_free(j->unique_values);
         free(j->fields_buffer);
+        free(j->entry_fields);
         free(j);
 }
 
@@ -2273,7 +2523,7 @@ static bool field_is_valid(const char *field) {
 
 _public_ int sd_journal_get_data(sd_journal *j, const char *field, const void **data, size_t *size) {
         JournalFile *f;
-        uint64_t i, n;
+        uint64_t i, n, field_hash;
         size_t field_length;
         int r;
         Object *o;
@@ -2297,32 +2547,73 @@ _public_ int sd_journal_get_data(sd_journal *j, const char *field, const void **
                 return r;
 
         field_length = strlen(field);
+        field_hash = jenkins_hash64(field, field_length);
+
+        n = journal_file_entry_n_items(f, o);
+
+        /* Callers typically look up several fields of the same entry. Hence remember the field names of the
+         * items we looked at, so that we don't have to move to the DATA objects of items known not to match
+         * again. */
+        if (j->entry_fields_file != f || j->entry_fields_offset != f->current_offset) {
+                if (!GREEDY_REALLOC(j->entry_fields, j->entry_fields_allocated, MAX(n, 1U)))
+                        return -ENOMEM;
+
+                j->entry_fields_file = f;
+                j->entry_fields_offset = f->current_offset;
+                j->entry_fields_n_scanned = 0;
+        }
 
-        n = journal_file_entry_n_items(o);
         for (i = 0; i < n; i++) {
                 uint64_t p, l;
-                le64_t le_hash;
+                le64_t le_hash = 0;
                 size_t t;
                 int compression;
 
-                p = le64toh(o->entry.items[i].object_offset);
-                le_hash = o->entry.items[i].hash;
+                if (i < j->entry_fields_n_scanned) {
+                        const EntryFieldItem *e = j->entry_fields + i;
+
+                        if (e->field_length != SIZE_MAX &&
+                            (e->field_length != field_length || e->hash != field_hash))
+                                continue;
+                }
+
+                /* Compact files don't store the hashes of the DATA objects in the entry */
+                p = journal_file_entry_item_object_offset(f, o, i);
+                if (!f->compact)
+                        le_hash = o->entry.items.regular[i].hash;
                 r = journal_file_move_to_object(f, OBJECT_DATA, p, &o);
                 if (r < 0)
                         return r;
 
-                if (le_hash != o->data.hash)
+                if (!f->compact && le_hash != o->data.hash)
                         return -EBADMSG;
 
                 l = le64toh(o->object.size) - offsetof(Object, data.payload);
 
                 compression = o->object.flags & OBJECT_COMPRESSION_MASK;
+
+                if (i >= j->entry_fields_n_scanned) {
+                        EntryFieldItem *e = j->entry_fields + i;
+
+                        if (compression)
+                                e->field_length = SIZE_MAX;
+                        else {
+                                const uint8_t *eq;
+
+                                eq = memchr(o->data.payload, '=', l);
+                                e->field_length = eq ? (size_t) (eq - o->data.payload) : 0;
+                                e->hash = jenkins_hash64(o->data.payload, e->field_length);
+                        }
+
+                        j->entry_fields_n_scanned = i + 1;
+                }
+
                 if (compression) {
 #if HAVE_COMPRESSION
-                        r = decompress_startswith(compression,
-                                                  o->data.payload, l,
-                                                  &f->compress_buffer, &f->compress_buffer_size,
-                                                  field, field_length, '=');
+                        r = decompress_startswith_full(compression, f->compression_dictionary,
+                                                       o->data.payload, l,
+                                                       &f->compress_buffer, &f->compress_buffer_size,
+                                                       field, field_length, '=');
                         if (r < 0)
                                 log_debug_errno(r, "Cannot decompress %s object of length %"PRIu64" at offset "OFSfmt": %m",
                                                 object_compressed_to_string(compression), l, p);
@@ -2330,10 +2621,10 @@ _public_ int sd_journal_get_data(sd_journal *j, const char *field, const void **
 
                                 size_t rsize;
 
-                                r = decompress_blob(compression,
-                                                    o->data.payload, l,
-                                                    &f->compress_buffer, &f->compress_buffer_size, &rsize,
-                                                    j->data_threshold);
+                                r = decompress_blob_full(compression, f->compression_dictionary,
+                                                         o->data.payload, l,
+                                                         &f->compress_buffer, &f->compress_buffer_size, &rsize,
+                                                         j->data_threshold);
                                 if (r < 0)
                                         return r;
 
@@ -2389,9 +2680,9 @@ static int return_data(sd_journal *j, JournalFile *f, Object *o, const void **da
                 size_t rsize;
                 int r;
 
-                r = decompress_blob(compression,
-                                    o->data.payload, l, &f->compress_buffer,
-                                    &f->compress_buffer_size, &rsize, j->data_threshold);
+                r = decompress_blob_full(compression, f->compression_dictionary,
+                                         o->data.payload, l, &f->compress_buffer,
+                                         &f->compress_buffer_size, &rsize, j->data_threshold);
                 if (r < 0)
                         return r;
 
@@ -2411,7 +2702,7 @@ static int return_data(sd_journal *j, JournalFile *f, Object *o, const void **da
 _public_ int sd_journal_enumerate_data(sd_journal *j, const void **data, size_t *size) {
         JournalFile *f;
         uint64_t p, n;
-        le64_t le_hash;
+        le64_t le_hash = 0;
         int r;
         Object *o;
 
@@ -2431,17 +2722,18 @@ _public_ int sd_journal_enumerate_data(sd_journal *j, const void **data, size_t
         if (r < 0)
                 return r;
 
-        n = journal_file_entry_n_items(o);
+        n = journal_file_entry_n_items(f, o);
         if (j->current_field >= n)
                 return 0;
 
-        p = le64toh(o->entry.items[j->current_field].object_offset);
-        le_hash = o->entry.items[j->current_field].hash;
+        p = journal_file_entry_item_object_offset(f, o, j->current_field);
+        if (!f->compact)
+                le_hash = o->entry.items.regular[j->current_field].hash;
         r = journal_file_move_to_object(f, OBJECT_DATA, p, &o);
         if (r < 0)
                 return r;
 
-        if (le_hash != o->data.hash)
+        if (!f->compact && le_hash != o->data.hash)
                 return -EBADMSG;
 
         r = return_data(j, f, o, data, size);
@@ -2835,6 +3127,46 @@ void journal_print_header(sd_journal *j) {
         }
 }
 
+void journal_set_prefetch(sd_journal *j, bool b) {
+        JournalFile *f;
+
+        assert(j);
+
+        /* Enables asynchronous readahead of entry arrays and entry objects ahead of the iterator, for
+         * all files currently open and all files added later on. */
+
+        j->prefetch = b;
+
+        ORDERED_HASHMAP_FOREACH(f, j->files)
+                f->prefetch = b;
+}
+
+int journal_seek_entry(sd_journal *j, const char *path, uint64_t offset) {
+        JournalFile *f;
+        Object *o;
+        int r;
+
+        assert(j);
+        assert(path);
+
+        /* Makes the entry at the specified offset of the specified file the current one, as if we had
+         * iterated to it. This allows handing entries found while iterating one journal object over to
+         * another one opened on the same files. */
+
+        f = ordered_hashmap_get(j->files, path);
+        if (!f)
+                return -ENOENT;
+
+        r = journal_file_move_to_object(f, OBJECT_ENTRY, offset, &o);
+        if (r < 0)
+                return r;
+
+        journal_file_save_location(f, o, offset);
+        set_location(j, f, o);
+
+        return 0;
+}
+
 _public_ int sd_journal_get_usage(sd_journal *j, uint64_t *bytes) {
         JournalFile *f;
         uint64_t sum = 0;
@@ -2856,6 +3188,67 @@ _public_ int sd_journal_get_usage(sd_journal *j, uint64_t *bytes) {
         return 0;
 }
 
+typedef struct UniqueValue {
+        uint64_t hash;
+        size_t size;
+        uint8_t data[];
+} UniqueValue;
+
+static void unique_value_hash_func(const UniqueValue *v, struct siphash *state) {
+        siphash24_compress(&v->hash, sizeof(v->hash), state);
+}
+
+static int unique_value_compare_func(const UniqueValue *a, const UniqueValue *b) {
+        int r;
+
+        r = CMP(a->hash, b->hash);
+        if (r != 0)
+                return r;
+
+        r = CMP(a->size, b->size);
+        if (r != 0)
+                return r;
+
+        return memcmp(a->data, b->data, a->size);
+}
+
+DEFINE_PRIVATE_HASH_OPS_WITH_KEY_DESTRUCTOR(unique_value_hash_ops, UniqueValue, unique_value_hash_func, unique_value_compare_func, free);
+
+static int unique_value_add(sd_journal *j, JournalFile *f, Object *o, const void *data, size_t size) {
+        _cleanup_free_ UniqueValue *v = NULL;
+        int r;
+
+        assert(j);
+        assert(f);
+        assert(o);
+        assert(data || size == 0);
+
+        /* Remembers a value we returned, to suppress it when it shows up again in a later file. Returns 0 if
+         * that's the case already. The hash stored in the data object is the Jenkins hash of the payload,
+         * unless the file uses keyed hashes, or the payload got truncated by the data threshold. Otherwise,
+         * calculate the same hash by hand. */
+
+        v = malloc(offsetof(UniqueValue, data) + size);
+        if (!v)
+                return -ENOMEM;
+
+        if (!JOURNAL_HEADER_KEYED_HASH(f->header) &&
+            (!(o->object.flags & OBJECT_COMPRESSION_MASK) || j->data_threshold == 0 || size < j->data_threshold))
+                v->hash = le64toh(o->data.hash);
+        else
+                v->hash = jenkins_hash64(data, size);
+
+        v->size = size;
+        memcpy_safe(v->data, data, size);
+
+        r = set_ensure_put(&j->unique_values, &unique_value_hash_ops, v);
+        if (r <= 0)
+                return r == -EEXIST ? 0 : r;
+
+        TAKE_PTR(v);
+        return 1;
+}
+
 _public_ int sd_journal_query_unique(sd_journal *j, const char *field) {
         char *f;
 
@@ -2873,6 +3266,7 @@ _public_ int sd_journal_query_unique(sd_journal *j, const char *field) {
         j->unique_file = NULL;
         j->unique_offset = 0;
         j->unique_file_lost = false;
+        set_clear(j->unique_values);
 
         return 0;
 }
@@ -2900,11 +3294,9 @@ _public_ int sd_journal_enumerate_unique(sd_journal *j, const void **data, size_
         }
 
         for (;;) {
-                JournalFile *of;
                 Object *o;
                 const void *odata;
                 size_t ol;
-                bool found;
                 int r;
 
                 /* Proceed to next data object in the field's linked list */
@@ -2964,34 +3356,17 @@ _public_ int sd_journal_enumerate_unique(sd_journal *j, const void **data, size_
                                                j->unique_offset,
                                                j->unique_field);
 
-                /* OK, now let's see if we already returned this data
-                 * object by checking if it exists in the earlier
-                 * traversed files. */
-                found = false;
-                ORDERED_HASHMAP_FOREACH(of, j->files) {
-                        if (of == j->unique_file)
-                                break;
-
-                        /* Skip this file it didn't have any fields indexed */
-                        if (JOURNAL_HEADER_CONTAINS(of->header, n_fields) && le64toh(of->header->n_fields) <= 0)
-                                continue;
-
-                        r = journal_file_find_data_object_with_hash(of, odata, ol, le64toh(o->data.hash), NULL, NULL);
-                        if (r < 0)
-                                return r;
-                        if (r > 0) {
-                                found = true;
-                                break;
-                        }
-                }
-
-                if (found)
-                        continue;
-
-                r = return_data(j, j->unique_file, o, data, l);
+                /* OK, now let's see if we already returned this data object from an earlier file. Note
+                 * that data objects are unique within a file, hence this only ever matches for values seen
+                 * in other files. */
+                r = unique_value_add(j, j->unique_file, o, odata, ol);
                 if (r < 0)
                         return r;
+                if (r == 0)
+                        continue;
 
+                *data = odata;
+                *l = ol;
                 return 1;
         }
 }
@@ -3017,6 +3392,7 @@ _public_ void sd_journal_restart_unique(sd_journal *j) {
         j->unique_file = NULL;
         j->unique_offset = 0;
         j->unique_file_lost = false;
+        set_clear(j->unique_values);
 }
 
 _public_ int sd_journal_enumerate_fields(sd_journal *j, const char **field) {
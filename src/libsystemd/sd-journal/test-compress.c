@@ -266,6 +266,72 @@ static void test_lz4_decompress_partial(void) {
 }
 #endif
 
+#if HAVE_ZSTD
+static void test_zstd_dictionary(void) {
+        _cleanup_(compression_dictionary_freep) CompressionDictionary *d = NULL;
+        _cleanup_free_ char *samples = NULL, *decompressed = NULL;
+        _cleanup_free_ size_t *sizes = NULL;
+        _cleanup_free_ void *dictionary = NULL;
+        const char *message = "MESSAGE=Started Session 4711 of user lennart.";
+        char compressed[512], plain[512];
+        size_t n = 0, total = 0, size, csize, psize, usize = 0, dsize;
+        int r;
+
+        log_debug("/* %s */", __func__);
+
+        /* Short, repetitive log lines, which is what the journal typically stores */
+        assert_se(samples = malloc(2000 * 64));
+        assert_se(sizes = new(size_t, 2000));
+        for (unsigned i = 0; i < 2000; i++) {
+                int k;
+
+                if (i % 2 == 0)
+                        k = sprintf(samples + total, "MESSAGE=Started Session %u of user user%u.", i, i % 7);
+                else
+                        k = sprintf(samples + total, "_SYSTEMD_UNIT=session-%u.scope", i);
+                assert_se(k > 0);
+
+                sizes[n++] = k;
+                total += k;
+        }
+
+        r = compression_dictionary_train(samples, sizes, n, 4096, &dictionary, &size);
+        if (r == -ENODATA) {
+                log_info_errno(r, "Dictionary training failed, skipping test: %m");
+                return;
+        }
+        assert_se(r >= 0);
+        assert_se(size > 0 && size <= 4096);
+        log_info("Trained %zu byte dictionary from %zu samples", size, n);
+
+        assert_se(compression_dictionary_new(dictionary, size, &d) >= 0);
+
+        assert_se(compress_blob_zstd_dictionary(d, message, strlen(message), compressed, sizeof(compressed), &csize) == 0);
+        assert_se(compress_blob_zstd(message, strlen(message), plain, sizeof(plain), &psize) == 0);
+        log_info("Compressed %zu → %zu with dictionary, → %zu without", strlen(message), csize, psize);
+        assert_se(csize < psize);
+
+        assert_se(decompress_blob_zstd_dictionary(d, compressed, csize, (void**) &decompressed, &usize, &dsize, 0) == 0);
+        assert_se(dsize == strlen(message));
+        assert_se(memcmp(decompressed, message, dsize) == 0);
+
+        assert_se(decompress_blob_full(OBJECT_COMPRESSED_ZSTD, d, compressed, csize, (void**) &decompressed, &usize, &dsize, 0) == 0);
+        assert_se(memcmp(decompressed, message, dsize) == 0);
+
+        assert_se(decompress_startswith_full(OBJECT_COMPRESSED_ZSTD, d, compressed, csize, (void**) &decompressed, &usize,
+                                             "MESSAGE", STRLEN("MESSAGE"), '=') > 0);
+        assert_se(decompress_startswith_full(OBJECT_COMPRESSED_ZSTD, d, compressed, csize, (void**) &decompressed, &usize,
+                                             "MESSAGE", STRLEN("MESSAGE"), 'X') == 0);
+
+        /* Data compressed with a dictionary cannot be decompressed without it */
+        assert_se(decompress_blob_zstd(compressed, csize, (void**) &decompressed, &usize, &dsize, 0) < 0);
+
+        /* But data compressed without one can still be decompressed with it */
+        assert_se(decompress_blob_zstd_dictionary(d, plain, psize, (void**) &decompressed, &usize, &dsize, 0) == 0);
+        assert_se(memcmp(decompressed, message, dsize) == 0);
+}
+#endif
+
 int main(int argc, char *argv[]) {
 #if HAVE_COMPRESSION
         _unused_ const char text[] =
@@ -360,6 +426,8 @@ int main(int argc, char *argv[]) {
                              compress_stream_zstd, decompress_stream_zstd, srcfile);
 
         test_decompress_startswith_short("ZSTD", compress_blob_zstd, decompress_startswith_zstd);
+
+        test_zstd_dictionary();
 #else
         log_info("/* ZSTD test skipped */");
 #endif
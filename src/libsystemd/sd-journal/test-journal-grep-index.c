@@ -0,0 +1,188 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "alloc-util.h"
+#include "extract-word.h"
+#include "io-util.h"
+#include "journal-file.h"
+#include "journal-grep-index.h"
+#include "rm-rf.h"
+#include "string-util.h"
+#include "tests.h"
+
+static const char *messages[] = {
+        "MESSAGE=Request 4f3a9c finished",
+        "MESSAGE=request 4F3A9C started",
+        "MESSAGE=Something else entirely",
+        "MESSAGE=Connection refused",
+        "MESSAGE=Request 77aa01 finished",
+        "MESSAGE=xy",
+};
+
+static void test_pattern_one(const char *pattern, const char *expected) {
+        _cleanup_free_ uint32_t *trigrams = NULL;
+        size_t n_trigrams = 0;
+        int r;
+
+        log_info("/* %s(\"%s\") */", __func__, pattern);
+
+        r = journal_grep_pattern_trigrams(pattern, &trigrams, &n_trigrams);
+        assert_se(r >= 0);
+
+        if (!expected) {
+                assert_se(r == 0);
+                assert_se(!trigrams);
+                assert_se(n_trigrams == 0);
+                return;
+        }
+
+        assert_se(r > 0);
+
+        /* Each trigram from the expected strings must be there, and nothing else */
+        for (;;) {
+                _cleanup_free_ char *word = NULL;
+
+                assert_se(extract_first_word(&expected, &word, "|", 0) >= 0);
+                if (!word)
+                        break;
+
+                for (size_t i = 0; i + 2 < strlen(word); i++) {
+                        uint32_t t = (uint32_t) word[i] << 16 | (uint32_t) word[i+1] << 8 | (uint32_t) word[i+2];
+                        bool found = false;
+
+                        for (size_t k = 0; k < n_trigrams; k++)
+                                if (trigrams[k] == t)
+                                        found = true;
+
+                        assert_se(found);
+                        assert_se(n_trigrams > 0);
+                }
+        }
+
+        for (size_t k = 1; k < n_trigrams; k++)
+                assert_se(trigrams[k-1] < trigrams[k]);
+}
+
+static void test_pattern_trigrams(void) {
+        test_pattern_one("foobar", "foobar");
+        test_pattern_one("FooBar", "foobar");
+        test_pattern_one("fo", NULL);
+        test_pattern_one("foo|bar", NULL);
+        test_pattern_one("a.bcd", "bcd");
+        test_pattern_one("fooo?", "foo");
+        test_pattern_one("fooo*x", "foo");
+        test_pattern_one("foo+bar", "foo|bar");
+        test_pattern_one("foo(bar)", "foo|bar");
+        test_pattern_one("foo(bar)?", NULL);
+        test_pattern_one("foo(bar){0,1}", NULL);
+        test_pattern_one("(?i)foo", NULL);
+        test_pattern_one("(*UTF)foo", NULL);
+        test_pattern_one("[abc]def", "def");
+        test_pattern_one("[]x|]def", "def");
+        test_pattern_one("[[:alpha:]]def", "def");
+        test_pattern_one("x{2}abc", "abc");
+        test_pattern_one("x{abc", "x{abc");
+        test_pattern_one("^request-id \\d+$", "request-id ");
+        test_pattern_one("a\\.b\\.c", "a.b.c");
+        test_pattern_one("\\x41bcd", NULL);
+        test_pattern_one("\\Qfoo\\E", NULL);
+        test_pattern_one("[abc", NULL);
+}
+
+static void append_messages(JournalFile *f) {
+        dual_timestamp ts;
+
+        assert_se(dual_timestamp_get(&ts));
+
+        for (size_t i = 0; i < ELEMENTSOF(messages); i++) {
+                struct iovec iovec[] = {
+                        IOVEC_MAKE_STRING(messages[i]),
+                        IOVEC_MAKE_STRING("_HOSTNAME=test"),
+                };
+
+                assert_se(journal_file_append_entry(f, &ts, NULL, iovec, ELEMENTSOF(iovec), NULL, NULL, NULL) == 0);
+        }
+}
+
+static void check_query(JournalFile *f, const char *pattern, const char *needle) {
+        _cleanup_free_ uint32_t *trigrams = NULL, *candidates = NULL;
+        size_t n_trigrams = 0, n_candidates = 0, n_matches = 0;
+        uint64_t p = 0;
+        Object *o;
+
+        log_info("/* %s(\"%s\") */", __func__, pattern);
+
+        assert_se(journal_grep_pattern_trigrams(pattern, &trigrams, &n_trigrams) > 0);
+        assert_se(journal_grep_index_query(f, trigrams, n_trigrams, &candidates, &n_candidates) > 0);
+
+        for (size_t i = 0; i < ELEMENTSOF(messages); i++) {
+                bool matches = strcasestr(messages[i] + STRLEN("MESSAGE="), needle);
+
+                assert_se(journal_file_next_entry(f, p, DIRECTION_DOWN, &o, &p) == 1);
+
+                /* The index can't tell us about matches it doesn't know about, but all of our needles are
+                 * distinctive enough that there are no false positives either */
+                assert_se(journal_grep_index_entry_may_match(f, o, candidates, n_candidates) == matches);
+                n_matches += matches;
+        }
+
+        assert_se(n_candidates == n_matches);
+}
+
+static void test_build_and_query(uint64_t compress_threshold) {
+        _cleanup_free_ uint32_t *trigrams = NULL, *candidates = NULL;
+        size_t n_trigrams = 0, n_candidates = 0;
+        char t[] = "/var/tmp/journal-grep-index-XXXXXX";
+        JournalFile *f;
+
+        log_info("/* %s(%" PRIu64 ") */", __func__, compress_threshold);
+
+        assert_se(mkdtemp(t));
+        assert_se(chdir(t) >= 0);
+
+        assert_se(journal_file_open(-1, "test.journal", O_RDWR|O_CREAT, 0644, true, compress_threshold, false, NULL, NULL, NULL, NULL, &f) == 0);
+
+        append_messages(f);
+
+        /* No index yet */
+        assert_se(journal_grep_pattern_trigrams("finished", &trigrams, &n_trigrams) > 0);
+        assert_se(journal_grep_index_query(f, trigrams, n_trigrams, &candidates, &n_candidates) == 0);
+
+        assert_se(journal_grep_index_build(f, f->path) >= 0);
+        assert_se(access("test.journal" JOURNAL_GREP_INDEX_SUFFIX, F_OK) >= 0);
+
+        check_query(f, "finished", "finished");
+        check_query(f, "4F3a9C", "4f3a9c");
+        check_query(f, "^Request 4f3a9c \\w+", "request 4f3a9c ");
+        check_query(f, "not there", "not there");
+
+        /* Once the file changes, the index is not used anymore */
+        append_messages(f);
+        assert_se(journal_grep_index_query(f, trigrams, n_trigrams, &candidates, &n_candidates) == 0);
+
+        assert_se(journal_grep_index_unlink(AT_FDCWD, "test.journal") > 0);
+        assert_se(journal_grep_index_unlink(AT_FDCWD, "test.journal") == 0);
+
+        (void) journal_file_close(f);
+
+        assert_se(rm_rf(t, REMOVE_ROOT|REMOVE_PHYSICAL) >= 0);
+}
+
+int main(int argc, char *argv[]) {
+        test_setup_logging(LOG_DEBUG);
+
+        /* journal_file_open requires a valid machine id */
+        if (access("/etc/machine-id", F_OK) != 0)
+                return log_tests_skipped("/etc/machine-id not found");
+
+        test_pattern_trigrams();
+
+        test_build_and_query(UINT64_MAX);
+#if HAVE_COMPRESSION
+        test_build_and_query(8);
+#endif
+
+        return 0;
+}
@@ -9,10 +9,12 @@
 #include "chattr-util.h"
 #include "io-util.h"
 #include "journal-file.h"
+#include "journal-internal.h"
 #include "journal-vacuum.h"
 #include "log.h"
 #include "parse-util.h"
 #include "rm-rf.h"
+#include "stdio-util.h"
 #include "tests.h"
 #include "util.h"
 
@@ -143,6 +145,7 @@ static void mkdtemp_chdir_chattr(char *path) {
 static void test_skip(void (*setup)(void)) {
         char t[] = "/var/tmp/journal-skip-XXXXXX";
         sd_journal *j;
+        uint64_t realtime;
         int r;
 
         mkdtemp_chdir_chattr(t);
@@ -165,6 +168,18 @@ static void test_skip(void (*setup)(void)) {
         test_check_numbers_up(j, 4);
         sd_journal_close(j);
 
+        /* Same, with readahead enabled.
+         */
+        assert_ret(sd_journal_open_directory(&j, t, 0));
+        journal_set_prefetch(j, true);
+        assert_ret(sd_journal_seek_head(j));
+        assert_ret(sd_journal_next(j));
+        test_check_numbers_down(j, 4);
+        assert_ret(sd_journal_seek_tail(j));
+        assert_ret(sd_journal_previous(j));
+        test_check_numbers_up(j, 4);
+        sd_journal_close(j);
+
         /* Seek to tail, skip to head, iterate down.
          */
         assert_ret(sd_journal_open_directory(&j, t, 0));
@@ -183,6 +198,30 @@ static void test_skip(void (*setup)(void)) {
         test_check_numbers_up(j, 4);
         sd_journal_close(j);
 
+        /* Seek to the wallclock time of the third entry, iterate down, then to the one of the second entry,
+         * iterate up.
+         */
+        assert_ret(sd_journal_open_directory(&j, t, 0));
+        assert_ret(sd_journal_seek_head(j));
+        assert_ret(r = sd_journal_next_skip(j, 3));
+        assert_se(r == 3);
+        assert_ret(sd_journal_get_realtime_usec(j, &realtime));
+        assert_ret(sd_journal_seek_realtime_usec(j, realtime));
+        assert_ret(r = sd_journal_next(j));
+        assert_se(r == 1);
+        test_check_number(j, 3);
+        assert_ret(r = sd_journal_next(j));
+        assert_se(r == 1);
+        test_check_number(j, 4);
+        assert_ret(r = sd_journal_previous_skip(j, 2));
+        assert_se(r == 2);
+        assert_ret(sd_journal_get_realtime_usec(j, &realtime));
+        assert_ret(sd_journal_seek_realtime_usec(j, realtime));
+        assert_ret(r = sd_journal_previous(j));
+        assert_se(r == 1);
+        test_check_numbers_up(j, 2);
+        sd_journal_close(j);
+
         log_info("Done...");
 
         if (arg_keep)
@@ -196,6 +235,76 @@ static void test_skip(void (*setup)(void)) {
         puts("------------------------------------------------------------");
 }
 
+static void append_boot_id(JournalFile *f, sd_id128_t boot_id) {
+        char p[STRLEN("_BOOT_ID=") + SD_ID128_STRING_MAX];
+        struct iovec iovec[1];
+        dual_timestamp ts;
+
+        dual_timestamp_get(&ts);
+
+        xsprintf(p, "_BOOT_ID=" SD_ID128_FORMAT_STR, SD_ID128_FORMAT_VAL(boot_id));
+        iovec[0] = IOVEC_MAKE_STRING(p);
+        assert_ret(journal_file_append_entry(f, &ts, NULL, iovec, 1, NULL, NULL, NULL));
+}
+
+static unsigned count_boot_id(const char *path, sd_id128_t boot_id) {
+        char match[STRLEN("_BOOT_ID=") + SD_ID128_STRING_MAX];
+        sd_journal *j;
+        unsigned n = 0;
+
+        assert_ret(sd_journal_open_directory(&j, path, 0));
+
+        xsprintf(match, "_BOOT_ID=" SD_ID128_FORMAT_STR, SD_ID128_FORMAT_VAL(boot_id));
+        assert_ret(sd_journal_add_match(j, match, 0));
+
+        SD_JOURNAL_FOREACH(j)
+                n++;
+
+        /* And once more backwards, now that the boot IDs of the files are known */
+        SD_JOURNAL_FOREACH_BACKWARDS(j)
+                n++;
+
+        sd_journal_close(j);
+
+        return n;
+}
+
+static void test_boot_id_match(void) {
+        char t[] = "/var/tmp/journal-boot-XXXXXX";
+        sd_id128_t a, b, c;
+        JournalFile *one, *two;
+
+        mkdtemp_chdir_chattr(t);
+
+        assert_se(sd_id128_randomize(&a) >= 0);
+        assert_se(sd_id128_randomize(&b) >= 0);
+        assert_se(sd_id128_randomize(&c) >= 0);
+
+        one = test_open("one.journal");
+        two = test_open("two.journal");
+        append_boot_id(one, a);
+        append_boot_id(one, a);
+        append_boot_id(one, b);
+        append_boot_id(two, b);
+        append_boot_id(two, b);
+        test_close(one);
+        test_close(two);
+
+        assert_se(count_boot_id(t, a) == 2 * 2);
+        assert_se(count_boot_id(t, b) == 3 * 2);
+        assert_se(count_boot_id(t, c) == 0);
+
+        if (arg_keep)
+                log_info("Not removing %s", t);
+        else {
+                journal_directory_vacuum(".", 3000000, 0, 0, NULL, true);
+
+                assert_se(rm_rf(t, REMOVE_ROOT|REMOVE_PHYSICAL) >= 0);
+        }
+
+        puts("------------------------------------------------------------");
+}
+
 static void test_sequence_numbers(void) {
 
         char t[] = "/var/tmp/journal-seq-XXXXXX";
@@ -291,6 +400,7 @@ int main(int argc, char *argv[]) {
         test_skip(setup_interleaved);
 
         test_sequence_numbers();
+        test_boot_id_match();
 
         return 0;
 }
@@ -14,6 +14,7 @@
 #include "macro.h"
 #include "parse-util.h"
 #include "rm-rf.h"
+#include "set.h"
 #include "tests.h"
 #include "util.h"
 
@@ -64,6 +65,7 @@ static void run_test(void) {
         char t[] = "/var/tmp/journal-stream-XXXXXX";
         unsigned i;
         _cleanup_(sd_journal_closep) sd_journal *j = NULL;
+        _cleanup_set_free_free_ Set *values = NULL;
         char *z;
         const void *data;
         size_t l;
@@ -165,10 +167,23 @@ static void run_test(void) {
 
         verify_contents(j, 0);
 
+        /* Values that show up in more than one file must be returned only once */
         assert_se(sd_journal_query_unique(j, "NUMBER") >= 0);
-        SD_JOURNAL_FOREACH_UNIQUE(j, data, l)
+        SD_JOURNAL_FOREACH_UNIQUE(j, data, l) {
                 printf("%.*s\n", (int) l, (const char*) data);
 
+                assert_se(z = strndup(data, l));
+                assert_se(set_ensure_consume(&values, &string_hash_ops, z) > 0);
+        }
+        assert_se(set_size(values) == N_ENTRIES);
+
+        /* And again after a restart */
+        sd_journal_restart_unique(j);
+        i = 0;
+        SD_JOURNAL_FOREACH_UNIQUE(j, data, l)
+                i++;
+        assert_se(i == N_ENTRIES);
+
         assert_se(rm_rf(t, REMOVE_ROOT|REMOVE_PHYSICAL) >= 0);
 }
 
@@ -187,5 +202,10 @@ int main(int argc, char *argv[]) {
         assert_se(setenv("SYSTEMD_JOURNAL_KEYED_HASH", "0", 1) >= 0);
         run_test();
 
+        /* And once more in compact mode */
+        assert_se(setenv("SYSTEMD_JOURNAL_KEYED_HASH", "1", 1) >= 0);
+        assert_se(setenv("SYSTEMD_JOURNAL_COMPACT", "1", 1) >= 0);
+        run_test();
+
         return 0;
 }
@@ -4,12 +4,15 @@
 #include <unistd.h>
 
 #include "chattr-util.h"
+#include "dirent-util.h"
+#include "fd-util.h"
 #include "io-util.h"
 #include "journal-authenticate.h"
 #include "journal-file.h"
 #include "journal-vacuum.h"
 #include "log.h"
 #include "rm-rf.h"
+#include "stdio-util.h"
 #include "tests.h"
 
 static bool arg_keep = false;
@@ -158,6 +161,236 @@ static void test_empty(void) {
 }
 
 #if HAVE_COMPRESSION
+static void test_append_entries(void) {
+        JournalFileEntry entries[100];
+        struct iovec iovec[ELEMENTSOF(entries)][3];
+        char messages[ELEMENTSOF(entries)][STRLEN("MESSAGE=") + DECIMAL_STR_MAX(unsigned)];
+        static const char hostname[] = "_HOSTNAME=test", priority[] = "PRIORITY=6";
+        dual_timestamp ts;
+        JournalFile *f;
+        size_t n;
+        uint64_t p, seqnum = 0;
+        Object *o;
+        char t[] = "/var/tmp/journal-XXXXXX";
+
+        test_setup_logging(LOG_INFO);
+
+        mkdtemp_chdir_chattr(t);
+
+        assert_se(journal_file_open(-1, "test.journal", O_RDWR|O_CREAT, 0666, true, UINT64_MAX, false, NULL, NULL, NULL, NULL, &f) == 0);
+
+        assert_se(dual_timestamp_get(&ts));
+
+        for (unsigned i = 0; i < ELEMENTSOF(entries); i++) {
+                xsprintf(messages[i], "MESSAGE=%u", i);
+
+                iovec[i][0] = IOVEC_MAKE_STRING(messages[i]);
+                iovec[i][1] = IOVEC_MAKE_STRING(hostname);
+                iovec[i][2] = IOVEC_MAKE_STRING(priority);
+
+                entries[i] = (JournalFileEntry) {
+                        .ts = ts,
+                        .iovec = iovec[i],
+                        .n_iovec = ELEMENTSOF(iovec[i]),
+                };
+        }
+
+        /* An invalid entry in the middle stops the batch, and tells us how far we got */
+        entries[50].ts.realtime = 0;
+        assert_se(journal_file_append_entries(f, entries, ELEMENTSOF(entries), &seqnum, &n) == -EBADMSG);
+        assert_se(n == 50);
+        assert_se(seqnum == 50);
+
+        assert_se(journal_file_append_entries(f, entries + 51, ELEMENTSOF(entries) - 51, &seqnum, &n) == 0);
+        assert_se(n == ELEMENTSOF(entries) - 51);
+        assert_se(seqnum == ELEMENTSOF(entries) - 1);
+        assert_se(le64toh(f->header->n_entries) == ELEMENTSOF(entries) - 1);
+
+        /* Shared fields are stored once, and linked up with every entry */
+        assert_se(journal_file_find_data_object(f, hostname, strlen(hostname), &o, NULL) == 1);
+        assert_se(le64toh(o->data.n_entries) == ELEMENTSOF(entries) - 1);
+        assert_se(journal_file_find_data_object(f, priority, strlen(priority), &o, NULL) == 1);
+        assert_se(le64toh(o->data.n_entries) == ELEMENTSOF(entries) - 1);
+
+        p = 0;
+        for (unsigned i = 0; i < ELEMENTSOF(entries); i++) {
+                if (i == 50)
+                        continue;
+
+                assert_se(journal_file_next_entry(f, p, DIRECTION_DOWN, &o, &p) == 1);
+                assert_se(le64toh(o->entry.seqnum) == (i < 50 ? i + 1 : i));
+                assert_se(journal_file_entry_n_items(f, o) == 3);
+        }
+        assert_se(journal_file_next_entry(f, p, DIRECTION_DOWN, &o, &p) == 0);
+
+        assert_se(journal_file_find_data_object(f, messages[50], strlen(messages[50]), NULL, NULL) == 0);
+        assert_se(journal_file_find_data_object(f, messages[99], strlen(messages[99]), NULL, &p) == 1);
+        assert_se(journal_file_next_entry_for_data(f, NULL, 0, p, DIRECTION_DOWN, &o, NULL) == 1);
+        assert_se(le64toh(o->entry.seqnum) == ELEMENTSOF(entries) - 1);
+
+        (void) journal_file_close(f);
+
+        if (arg_keep)
+                log_info("Not removing %s", t);
+        else
+                assert_se(rm_rf(t, REMOVE_ROOT|REMOVE_PHYSICAL) >= 0);
+
+        puts("------------------------------------------------------------");
+}
+
+static unsigned count_archived(void) {
+        _cleanup_closedir_ DIR *d = NULL;
+        struct dirent *de;
+        unsigned n = 0;
+
+        assert_se(d = opendir("."));
+
+        FOREACH_DIRENT(de, d, assert_not_reached("Failed to read directory"))
+                if (strchr(de->d_name, '@'))
+                        n++;
+
+        return n;
+}
+
+static void append_and_rotate(JournalFile **f, unsigned n) {
+        static const char test[] = "TEST1=1";
+        struct iovec iovec = IOVEC_MAKE_STRING(test);
+        dual_timestamp ts;
+
+        for (unsigned i = 0; i < n; i++) {
+                assert_se(dual_timestamp_get(&ts));
+                assert_se(journal_file_append_entry(*f, &ts, NULL, &iovec, 1, NULL, NULL, NULL) == 0);
+                assert_se(journal_file_rotate(f, false, UINT64_MAX, false, NULL) >= 0);
+        }
+}
+
+static void test_vacuum_cache(void) {
+        _cleanup_(journal_vacuum_cache_freep) JournalVacuumCache *c = NULL;
+        _cleanup_closedir_ DIR *d = NULL;
+        char t[] = "/var/tmp/journal-XXXXXX";
+        struct dirent *de;
+        JournalFile *f;
+
+        test_setup_logging(LOG_DEBUG);
+
+        mkdtemp_chdir_chattr(t);
+
+        assert_se(journal_vacuum_cache_new(t, &c) >= 0);
+
+        assert_se(journal_file_open(-1, "test.journal", O_RDWR|O_CREAT, 0666, false, UINT64_MAX, false, NULL, NULL, NULL, NULL, &f) == 0);
+
+        /* The first run reads the directory, keep the active file and two archived ones */
+        append_and_rotate(&f, 5);
+        assert_se(count_archived() == 5);
+        assert_se(journal_vacuum_cache_vacuum(c, 0, 3, 0, NULL, true) >= 0);
+        assert_se(count_archived() == 2);
+
+        /* The later ones only look at what changed */
+        append_and_rotate(&f, 3);
+        assert_se(count_archived() == 5);
+        assert_se(journal_vacuum_cache_vacuum(c, 0, 4, 0, NULL, true) >= 0);
+        assert_se(count_archived() == 3);
+
+        /* Files removed behind our back are not counted anymore */
+        assert_se(d = opendir("."));
+        FOREACH_DIRENT(de, d, assert_not_reached("Failed to read directory"))
+                if (strchr(de->d_name, '@')) {
+                        assert_se(unlinkat(dirfd(d), de->d_name, 0) >= 0);
+                        break;
+                }
+        assert_se(count_archived() == 2);
+        assert_se(journal_vacuum_cache_vacuum(c, 0, 3, 0, NULL, true) >= 0);
+        assert_se(count_archived() == 2);
+
+        /* And we still get the same result as with a full run of the directory */
+        append_and_rotate(&f, 2);
+        assert_se(journal_vacuum_cache_vacuum(c, 0, 3, 0, NULL, true) >= 0);
+        assert_se(count_archived() == 2);
+        assert_se(journal_directory_vacuum(".", 0, 3, 0, NULL, true) >= 0);
+        assert_se(count_archived() == 2);
+
+        (void) journal_file_close(f);
+
+        if (arg_keep)
+                log_info("Not removing %s", t);
+        else
+                assert_se(rm_rf(t, REMOVE_ROOT|REMOVE_PHYSICAL) >= 0);
+
+        puts("------------------------------------------------------------");
+}
+
+static void test_append_entries_offload(void) {
+        JournalFileEntry entries[8];
+        struct iovec iovec[ELEMENTSOF(entries)][2];
+        _cleanup_free_ char *shared = NULL;
+        char *large[ELEMENTSOF(entries)] = {};
+        const size_t size = 32 * 1024;
+        dual_timestamp ts;
+        JournalFile *f;
+        uint64_t p;
+        size_t n;
+        Object *o;
+        char t[] = "/var/tmp/journal-XXXXXX";
+
+        test_setup_logging(LOG_INFO);
+
+        mkdtemp_chdir_chattr(t);
+
+        assert_se(journal_file_open(-1, "test.journal", O_RDWR|O_CREAT, 0666, true, UINT64_MAX, false, NULL, NULL, NULL, NULL, &f) == 0);
+        journal_file_set_offload_threads(f, 4);
+
+        assert_se(dual_timestamp_get(&ts));
+
+        /* One large field shared by all entries, and one that differs between them */
+        assert_se(shared = malloc(size));
+        memcpy(shared, "SHARED=", STRLEN("SHARED="));
+        memset(shared + STRLEN("SHARED="), 'x', size - STRLEN("SHARED="));
+
+        for (unsigned i = 0; i < ELEMENTSOF(entries); i++) {
+                assert_se(large[i] = malloc(size));
+                memcpy(large[i], "MESSAGE=", STRLEN("MESSAGE="));
+                memset(large[i] + STRLEN("MESSAGE="), 'a' + i, size - STRLEN("MESSAGE="));
+
+                iovec[i][0] = IOVEC_MAKE(large[i], size);
+                iovec[i][1] = IOVEC_MAKE(shared, size);
+
+                entries[i] = (JournalFileEntry) {
+                        .ts = ts,
+                        .iovec = iovec[i],
+                        .n_iovec = ELEMENTSOF(iovec[i]),
+                };
+        }
+
+        assert_se(journal_file_append_entries(f, entries, ELEMENTSOF(entries), NULL, &n) == 0);
+        assert_se(n == ELEMENTSOF(entries));
+
+        /* The objects must be found by the hashes calculated on the main thread */
+        assert_se(journal_file_find_data_object(f, shared, size, &o, NULL) == 1);
+        assert_se(le64toh(o->data.n_entries) == ELEMENTSOF(entries));
+        assert_se(o->object.flags & OBJECT_COMPRESSION_MASK);
+
+        for (unsigned i = 0; i < ELEMENTSOF(entries); i++) {
+                assert_se(journal_file_find_data_object(f, large[i], size, &o, &p) == 1);
+                assert_se(le64toh(o->data.n_entries) == 1);
+                assert_se(o->object.flags & OBJECT_COMPRESSION_MASK);
+
+                assert_se(journal_file_next_entry_for_data(f, NULL, 0, p, DIRECTION_DOWN, &o, NULL) == 1);
+                assert_se(le64toh(o->entry.seqnum) == i + 1);
+        }
+
+        (void) journal_file_close(f);
+
+        for (unsigned i = 0; i < ELEMENTSOF(entries); i++)
+                free(large[i]);
+
+        if (arg_keep)
+                log_info("Not removing %s", t);
+        else
+                assert_se(rm_rf(t, REMOVE_ROOT|REMOVE_PHYSICAL) >= 0);
+
+        puts("------------------------------------------------------------");
+}
+
 static bool check_compressed(uint64_t compress_threshold, uint64_t data_size) {
         dual_timestamp ts;
         JournalFile *f;
@@ -251,7 +484,10 @@ int main(int argc, char *argv[]) {
 
         test_non_empty();
         test_empty();
+        test_append_entries();
+        test_vacuum_cache();
 #if HAVE_COMPRESSION
+        test_append_entries_offload();
         test_min_compress_size();
 #endif
 
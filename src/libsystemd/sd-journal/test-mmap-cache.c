@@ -12,7 +12,7 @@
 #include "util.h"
 
 int main(int argc, char *argv[]) {
-        MMapFileDescriptor *fx;
+        MMapFileDescriptor *fx, *fy;
         int x, y, z, r;
         char px[] = "/tmp/testmmapXXXXXXX", py[] = "/tmp/testmmapYXXXXXX", pz[] = "/tmp/testmmapZXXXXXX";
         MMapCache *m;
@@ -56,6 +56,41 @@ int main(int argc, char *argv[]) {
         assert_se((uint8_t*) p + 1 == (uint8_t*) q);
 
         mmap_cache_free_fd(m, fx);
+
+        /* Scan a file sequentially in both directions, so that windows are grown and placed ahead of
+         * the read position, and then access it randomly, so that they are shrunk again. */
+        assert_se(ftruncate(y, 64ULL*1024ULL*1024ULL) >= 0);
+        for (uint64_t i = 0; i < 64; i++) {
+                uint8_t c = (uint8_t) i;
+
+                assert_se(pwrite(y, &c, 1, i * 1024ULL*1024ULL) == 1);
+        }
+
+        assert_se(fy = mmap_cache_add_fd(m, y, PROT_READ));
+
+        for (uint64_t i = 0; i < 64; i++) {
+                r = mmap_cache_get(m, fy, 0, false, i * 1024ULL*1024ULL, 1, NULL, &p);
+                assert_se(r >= 0);
+                assert_se(*(uint8_t*) p == (uint8_t) i);
+        }
+
+        for (uint64_t i = 64; i > 0; i--) {
+                r = mmap_cache_get(m, fy, 1, false, (i - 1) * 1024ULL*1024ULL, 1, NULL, &p);
+                assert_se(r >= 0);
+                assert_se(*(uint8_t*) p == (uint8_t) (i - 1));
+        }
+
+        for (uint64_t i = 0; i < 64; i++) {
+                uint64_t k = (i * 37) % 64;
+
+                r = mmap_cache_get(m, fy, 2, false, k * 1024ULL*1024ULL, 1, NULL, &p);
+                assert_se(r >= 0);
+                assert_se(*(uint8_t*) p == (uint8_t) k);
+        }
+
+        mmap_cache_stats_log_debug(m);
+
+        mmap_cache_free_fd(m, fy);
         mmap_cache_unref(m);
 
         safe_close(x);
@@ -14,8 +14,23 @@
 
 #define RTNL_RQUEUE_MAX 64*1024
 
+/* When batching, how many messages, and how many bytes, we collect at most before writing them out in a
+ * single datagram. The latter needs to stay well below the socket's send buffer size. */
+#define RTNL_WQUEUE_MAX 128
+#define RTNL_WQUEUE_BYTES_MAX (64U*1024U)
+
 #define RTNL_CONTAINER_DEPTH 32
 
+/* Up to which size we grow the receive buffer of the socket on our own when the kernel reports overruns */
+#define RTNL_RCVBUF_GROW_MAX (128U*1024U*1024U)
+
+/* A received datagram. The messages parsed from it point into it rather than having their own copy. */
+struct netlink_rbuffer {
+        unsigned n_ref;
+        size_t size;
+        uint8_t data[];
+};
+
 struct reply_callback {
         sd_netlink_message_handler_t callback;
         usec_t timeout;
@@ -77,10 +92,16 @@ struct sd_netlink {
         unsigned rqueue_partial_size;
         size_t rqueue_partial_allocated;
 
-        struct nlmsghdr *rbuffer;
-        size_t rbuffer_allocated;
+        unsigned n_overruns;
+
+        /* Messages sent asynchronously while batching is enabled, written out together before we poll */
+        sd_netlink_message **wqueue;
+        size_t wqueue_size;
+        size_t wqueue_allocated;
+        size_t wqueue_bytes;
 
         bool processing:1;
+        bool batching:1;
 
         uint32_t serial;
 
@@ -121,6 +142,7 @@ struct sd_netlink_message {
         int protocol;
 
         struct nlmsghdr *hdr;
+        struct netlink_rbuffer *rbuffer; /* if set, hdr points into this, and is not owned by us */
         struct netlink_container containers[RTNL_CONTAINER_DEPTH];
         unsigned n_containers; /* number of containers */
         bool sealed:1;
@@ -142,6 +164,8 @@ int socket_write_message(sd_netlink *nl, sd_netlink_message *m);
 int socket_writev_message(sd_netlink *nl, sd_netlink_message **m, size_t msgcount);
 int socket_read_message(sd_netlink *nl);
 
+struct netlink_rbuffer *netlink_rbuffer_unref(struct netlink_rbuffer *b);
+
 int rtnl_rqueue_make_room(sd_netlink *rtnl);
 int rtnl_rqueue_partial_make_room(sd_netlink *rtnl);
 
@@ -88,7 +88,7 @@ int sd_netlink_message_request_dump(sd_netlink_message *m, int dump) {
 
         assert_return(IN_SET(m->hdr->nlmsg_type,
                              RTM_GETLINK, RTM_GETLINKPROP, RTM_GETADDR, RTM_GETROUTE, RTM_GETNEIGH,
-                             RTM_GETRULE, RTM_GETADDRLABEL, RTM_GETNEXTHOP), -EINVAL);
+                             RTM_GETRULE, RTM_GETADDRLABEL, RTM_GETNEXTHOP, RTM_GETSTATS), -EINVAL);
 
         SET_FLAG(m->hdr->nlmsg_flags, NLM_F_DUMP, dump);
 
@@ -101,7 +101,10 @@ sd_netlink_message *sd_netlink_message_unref(sd_netlink_message *m) {
         while (m && --m->n_ref == 0) {
                 unsigned i;
 
-                free(m->hdr);
+                if (m->rbuffer)
+                        netlink_rbuffer_unref(m->rbuffer);
+                else
+                        free(m->hdr);
 
                 for (i = 0; i <= m->n_containers; i++)
                         free(m->containers[i].attributes);
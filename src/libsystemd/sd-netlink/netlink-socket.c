@@ -295,8 +295,24 @@ static int socket_recv_message(int fd, struct iovec *iov, uint32_t *ret_mcast_gr
  * If nothing useful was received 0 is returned.
  * On failure, a negative error code is returned.
  */
+struct netlink_rbuffer *netlink_rbuffer_unref(struct netlink_rbuffer *b) {
+        if (!b)
+                return NULL;
+
+        assert(b->n_ref > 0);
+
+        if (--b->n_ref == 0)
+                free(b);
+
+        return NULL;
+}
+
+DEFINE_TRIVIAL_CLEANUP_FUNC(struct netlink_rbuffer*, netlink_rbuffer_unref);
+
 int socket_read_message(sd_netlink *rtnl) {
         _cleanup_(sd_netlink_message_unrefp) sd_netlink_message *first = NULL;
+        _cleanup_(netlink_rbuffer_unrefp) struct netlink_rbuffer *buffer = NULL;
+        struct nlmsghdr *hdr;
         struct iovec iov = {};
         uint32_t group = 0;
         bool multi_part = false, done = false;
@@ -305,8 +321,6 @@ int socket_read_message(sd_netlink *rtnl) {
         unsigned i = 0;
 
         assert(rtnl);
-        assert(rtnl->rbuffer);
-        assert(rtnl->rbuffer_allocated >= sizeof(struct nlmsghdr));
 
         /* read nothing, just get the pending message size */
         r = socket_recv_message(rtnl->fd, &iov, NULL, true);
@@ -315,13 +329,18 @@ int socket_read_message(sd_netlink *rtnl) {
         else
                 len = (size_t) r;
 
-        /* make room for the pending message */
-        if (!greedy_realloc((void **)&rtnl->rbuffer,
-                            &rtnl->rbuffer_allocated,
-                            len, sizeof(uint8_t)))
+        /* Read the datagram into a buffer of its own, which the messages we parse from it then point into.
+         * Dumps carry many messages per datagram, this way we don't have to copy each of them. */
+        buffer = malloc(offsetof(struct netlink_rbuffer, data) + MAX(len, sizeof(struct nlmsghdr)));
+        if (!buffer)
                 return -ENOMEM;
 
-        iov = IOVEC_MAKE(rtnl->rbuffer, rtnl->rbuffer_allocated);
+        *buffer = (struct netlink_rbuffer) {
+                .n_ref = 1,
+                .size = MAX(len, sizeof(struct nlmsghdr)),
+        };
+
+        iov = IOVEC_MAKE(buffer->data, buffer->size);
 
         /* read the pending message */
         r = socket_recv_message(rtnl->fd, &iov, &group, false);
@@ -330,23 +349,25 @@ int socket_read_message(sd_netlink *rtnl) {
         else
                 len = (size_t) r;
 
-        if (len > rtnl->rbuffer_allocated)
+        if (len > buffer->size)
                 /* message did not fit in read buffer */
                 return -EIO;
 
-        if (NLMSG_OK(rtnl->rbuffer, len) && rtnl->rbuffer->nlmsg_flags & NLM_F_MULTI) {
+        hdr = (struct nlmsghdr*) buffer->data;
+
+        if (NLMSG_OK(hdr, len) && hdr->nlmsg_flags & NLM_F_MULTI) {
                 multi_part = true;
 
                 for (i = 0; i < rtnl->rqueue_partial_size; i++) {
                         if (rtnl_message_get_serial(rtnl->rqueue_partial[i]) ==
-                            rtnl->rbuffer->nlmsg_seq) {
+                            hdr->nlmsg_seq) {
                                 first = rtnl->rqueue_partial[i];
                                 break;
                         }
                 }
         }
 
-        for (struct nlmsghdr *new_msg = rtnl->rbuffer; NLMSG_OK(new_msg, len) && !done; new_msg = NLMSG_NEXT(new_msg, len)) {
+        for (struct nlmsghdr *new_msg = hdr; NLMSG_OK(new_msg, len) && !done; new_msg = NLMSG_NEXT(new_msg, len)) {
                 _cleanup_(sd_netlink_message_unrefp) sd_netlink_message *m = NULL;
                 const NLType *nl_type;
 
@@ -389,9 +410,9 @@ int socket_read_message(sd_netlink *rtnl) {
 
                 m->broadcast = !!group;
 
-                m->hdr = memdup(new_msg, new_msg->nlmsg_len);
-                if (!m->hdr)
-                        return -ENOMEM;
+                m->hdr = new_msg;
+                m->rbuffer = buffer;
+                buffer->n_ref++;
 
                 /* seal and parse the top-level message */
                 r = sd_netlink_message_rewind(m, rtnl);
@@ -1024,6 +1024,15 @@ static const NLTypeSystem rtnl_mdb_type_system = {
         .types = mdb_types,
 };
 
+static const NLType stats_types[] = {
+        [IFLA_STATS_LINK_64] = { .size = sizeof(struct rtnl_link_stats64) },
+};
+
+static const NLTypeSystem rtnl_stats_type_system = {
+        .count = ELEMENTSOF(stats_types),
+        .types = stats_types,
+};
+
 static const NLType error_types[] = {
         [NLMSGERR_ATTR_MSG]  = { .type = NETLINK_TYPE_STRING },
         [NLMSGERR_ATTR_OFFS] = { .type = NETLINK_TYPE_U32 },
@@ -1071,6 +1080,8 @@ static const NLType rtnl_types[] = {
         [RTM_NEWMDB]       = { .type = NETLINK_TYPE_NESTED, .type_system = &rtnl_mdb_type_system, .size = sizeof(struct br_port_msg) },
         [RTM_DELMDB]       = { .type = NETLINK_TYPE_NESTED, .type_system = &rtnl_mdb_type_system, .size = sizeof(struct br_port_msg) },
         [RTM_GETMDB]       = { .type = NETLINK_TYPE_NESTED, .type_system = &rtnl_mdb_type_system, .size = sizeof(struct br_port_msg) },
+        [RTM_NEWSTATS]     = { .type = NETLINK_TYPE_NESTED, .type_system = &rtnl_stats_type_system, .size = sizeof(struct if_stats_msg) },
+        [RTM_GETSTATS]     = { .type = NETLINK_TYPE_NESTED, .type_system = &rtnl_stats_type_system, .size = sizeof(struct if_stats_msg) },
 };
 
 const NLTypeSystem rtnl_type_system_root = {
@@ -325,6 +325,58 @@ int rtnl_get_link_iftype(sd_netlink **rtnl, int ifindex, unsigned short *ret) {
         return sd_rtnl_message_link_get_type(reply, ret);
 }
 
+int netlink_message_get_payload(sd_netlink_message *m, const void **ret, size_t *ret_size) {
+        assert_return(m, -EINVAL);
+        assert_return(m->hdr, -EINVAL);
+        assert_return(ret, -EINVAL);
+        assert_return(ret_size, -EINVAL);
+
+        /* Returns the message without the netlink header, i.e. without the sequence number and port id,
+         * which are assigned when the message is sent. */
+
+        *ret = NLMSG_DATA(m->hdr);
+        *ret_size = m->hdr->nlmsg_len - NLMSG_HDRLEN;
+
+        return 0;
+}
+
+int rtnl_message_new_stats(sd_netlink *rtnl, sd_netlink_message **ret, int ifindex, uint32_t filter_mask) {
+        struct if_stats_msg *ifs;
+        int r;
+
+        assert_return(rtnl, -EINVAL);
+        assert_return(ifindex >= 0, -EINVAL);
+        assert_return(ret, -EINVAL);
+
+        /* ifindex 0 together with a dump request returns the statistics of all links. Only the
+         * attributes selected by filter_mask (see IFLA_STATS_FILTER_BIT()) are included. */
+
+        r = message_new(rtnl, ret, RTM_GETSTATS);
+        if (r < 0)
+                return r;
+
+        ifs = NLMSG_DATA((*ret)->hdr);
+        ifs->family = AF_UNSPEC;
+        ifs->ifindex = ifindex;
+        ifs->filter_mask = filter_mask;
+
+        return 0;
+}
+
+int rtnl_message_stats_get_ifindex(sd_netlink_message *m, int *ret) {
+        struct if_stats_msg *ifs;
+
+        assert_return(m, -EINVAL);
+        assert_return(m->hdr, -EINVAL);
+        assert_return(rtnl_message_type_is_stats(m->hdr->nlmsg_type), -EINVAL);
+        assert_return(ret, -EINVAL);
+
+        ifs = NLMSG_DATA(m->hdr);
+        *ret = ifs->ifindex;
+
+        return 0;
+}
+
 int rtnl_message_new_synthetic_error(sd_netlink *rtnl, int error, uint32_t serial, sd_netlink_message **ret) {
         struct nlmsgerr *err;
         int r;
@@ -27,6 +27,13 @@ int rtnl_message_new_synthetic_error(sd_netlink *rtnl, int error, uint32_t seria
 uint32_t rtnl_message_get_serial(sd_netlink_message *m);
 void rtnl_message_seal(sd_netlink_message *m);
 
+int netlink_set_batching(sd_netlink *nl, bool b);
+
+int netlink_message_get_payload(sd_netlink_message *m, const void **ret, size_t *ret_size);
+
+int rtnl_message_new_stats(sd_netlink *rtnl, sd_netlink_message **ret, int ifindex, uint32_t filter_mask);
+int rtnl_message_stats_get_ifindex(sd_netlink_message *m, int *ret);
+
 static inline bool rtnl_message_type_is_neigh(uint16_t type) {
         return IN_SET(type, RTM_NEWNEIGH, RTM_GETNEIGH, RTM_DELNEIGH);
 }
@@ -45,6 +52,10 @@ static inline bool rtnl_message_type_is_link(uint16_t type) {
                       RTM_NEWLINKPROP, RTM_DELLINKPROP, RTM_GETLINKPROP);
 }
 
+static inline bool rtnl_message_type_is_stats(uint16_t type) {
+        return IN_SET(type, RTM_NEWSTATS, RTM_GETSTATS);
+}
+
 static inline bool rtnl_message_type_is_addr(uint16_t type) {
         return IN_SET(type, RTM_NEWADDR, RTM_GETADDR, RTM_DELADDR);
 }
@@ -61,12 +61,6 @@ static int sd_netlink_new(sd_netlink **ret) {
                 .serial = (uint32_t) (now(CLOCK_MONOTONIC) % UINT32_MAX) + 1,
         };
 
-        /* We guarantee that the read buffer has at least space for
-         * a message header */
-        if (!greedy_realloc((void**)&rtnl->rbuffer, &rtnl->rbuffer_allocated,
-                            sizeof(struct nlmsghdr), sizeof(uint8_t)))
-                return -ENOMEM;
-
         *ret = TAKE_PTR(rtnl);
 
         return 0;
@@ -169,12 +163,17 @@ int sd_netlink_inc_rcvbuf(sd_netlink *rtnl, size_t size) {
         return fd_inc_rcvbuf(rtnl->fd, size);
 }
 
+static int netlink_flush_wqueue(sd_netlink *nl);
+
 static sd_netlink *netlink_free(sd_netlink *rtnl) {
         sd_netlink_slot *s;
         unsigned i;
 
         assert(rtnl);
 
+        (void) netlink_flush_wqueue(rtnl);
+        free(rtnl->wqueue);
+
         for (i = 0; i < rtnl->rqueue_size; i++)
                 sd_netlink_message_unref(rtnl->rqueue[i]);
         free(rtnl->rqueue);
@@ -183,8 +182,6 @@ static sd_netlink *netlink_free(sd_netlink *rtnl) {
                 sd_netlink_message_unref(rtnl->rqueue_partial[i]);
         free(rtnl->rqueue_partial);
 
-        free(rtnl->rbuffer);
-
         while ((s = rtnl->slots)) {
                 assert(s->floating);
                 netlink_slot_disconnect(s, true);
@@ -229,6 +226,83 @@ static void rtnl_seal_message(sd_netlink *rtnl, sd_netlink_message *m) {
         rtnl_message_seal(m);
 }
 
+static int netlink_flush_wqueue(sd_netlink *nl) {
+        int r, k;
+
+        assert(nl);
+
+        if (nl->wqueue_size == 0)
+                return 0;
+
+        /* The kernel processes all netlink messages in a datagram one after the other, and acknowledges
+         * each of them individually. */
+        r = socket_writev_message(nl, nl->wqueue, nl->wqueue_size);
+        if (r < 0) {
+                log_debug_errno(r, "sd-netlink: failed to send %zu queued messages: %m", nl->wqueue_size);
+
+                /* Let the reply callbacks know */
+                for (size_t i = 0; i < nl->wqueue_size; i++) {
+                        _cleanup_(sd_netlink_message_unrefp) sd_netlink_message *m = NULL;
+
+                        k = rtnl_message_new_synthetic_error(nl, r, rtnl_message_get_serial(nl->wqueue[i]), &m);
+                        if (k < 0)
+                                break;
+
+                        k = rtnl_rqueue_make_room(nl);
+                        if (k < 0)
+                                break;
+
+                        nl->rqueue[nl->rqueue_size++] = TAKE_PTR(m);
+                }
+        }
+
+        for (size_t i = 0; i < nl->wqueue_size; i++)
+                sd_netlink_message_unref(nl->wqueue[i]);
+
+        nl->wqueue_size = 0;
+        nl->wqueue_bytes = 0;
+
+        return r;
+}
+
+static int netlink_queue_message(sd_netlink *nl, sd_netlink_message *m, uint32_t *serial) {
+        assert(nl);
+        assert(m);
+        assert(!m->sealed);
+
+        if (nl->wqueue_size >= RTNL_WQUEUE_MAX ||
+            nl->wqueue_bytes + m->hdr->nlmsg_len > RTNL_WQUEUE_BYTES_MAX)
+                (void) netlink_flush_wqueue(nl);
+
+        if (!GREEDY_REALLOC(nl->wqueue, nl->wqueue_allocated, nl->wqueue_size + 1))
+                return -ENOMEM;
+
+        rtnl_seal_message(nl, m);
+
+        nl->wqueue[nl->wqueue_size++] = sd_netlink_message_ref(m);
+        nl->wqueue_bytes += m->hdr->nlmsg_len;
+
+        if (serial)
+                *serial = rtnl_message_get_serial(m);
+
+        return 1;
+}
+
+int netlink_set_batching(sd_netlink *nl, bool b) {
+        assert_return(nl, -EINVAL);
+        assert_return(!rtnl_pid_changed(nl), -ECHILD);
+
+        /* When enabled, messages sent with sd_netlink_call_async() are queued up while the event loop
+         * dispatches, and are written out in a single datagram before it goes to sleep again. This only
+         * has an effect when the connection is attached to an event loop. */
+
+        if (!b)
+                (void) netlink_flush_wqueue(nl);
+
+        nl->batching = b;
+        return 0;
+}
+
 int sd_netlink_send(sd_netlink *nl,
                     sd_netlink_message *message,
                     uint32_t *serial) {
@@ -239,6 +313,9 @@ int sd_netlink_send(sd_netlink *nl,
         assert_return(message, -EINVAL);
         assert_return(!message->sealed, -EPERM);
 
+        /* Don't overtake messages that are still queued */
+        (void) netlink_flush_wqueue(nl);
+
         rtnl_seal_message(nl, message);
 
         r = socket_write_message(nl, message);
@@ -270,6 +347,8 @@ int sd_netlink_sendv(sd_netlink *nl,
                         return -ENOMEM;
         }
 
+        (void) netlink_flush_wqueue(nl);
+
         for (i = 0; i < msgcount; i++) {
                 assert_return(!messages[i]->sealed, -EPERM);
                 rtnl_seal_message(nl, messages[i]);
@@ -316,6 +395,34 @@ int rtnl_rqueue_partial_make_room(sd_netlink *rtnl) {
         return 0;
 }
 
+static void netlink_grow_rcvbuf(sd_netlink *rtnl) {
+        int size, r;
+
+        assert(rtnl);
+
+        r = getsockopt_int(rtnl->fd, SOL_SOCKET, SO_RCVBUF, &size);
+        if (r < 0) {
+                log_debug_errno(r, "sd-netlink: receive buffer overrun #%u, failed to get receive buffer size: %m",
+                                rtnl->n_overruns);
+                return;
+        }
+
+        /* The kernel reports twice the size that was set, to account for its bookkeeping overhead */
+        if ((size_t) size >= RTNL_RCVBUF_GROW_MAX) {
+                log_debug("sd-netlink: receive buffer overrun #%u, receive buffer is already %i bytes, ignoring.",
+                          rtnl->n_overruns, size);
+                return;
+        }
+
+        r = fd_inc_rcvbuf(rtnl->fd, MIN((size_t) size * 2, RTNL_RCVBUF_GROW_MAX));
+        if (r < 0)
+                log_debug_errno(r, "sd-netlink: receive buffer overrun #%u, failed to increase receive buffer size: %m",
+                                rtnl->n_overruns);
+        else
+                log_debug("sd-netlink: receive buffer overrun #%u, increased receive buffer size to %zu bytes.",
+                          rtnl->n_overruns, MIN((size_t) size * 2, RTNL_RCVBUF_GROW_MAX));
+}
+
 static int dispatch_rqueue(sd_netlink *rtnl, sd_netlink_message **message) {
         int r;
 
@@ -325,8 +432,12 @@ static int dispatch_rqueue(sd_netlink *rtnl, sd_netlink_message **message) {
         if (rtnl->rqueue_size <= 0) {
                 /* Try to read a new message */
                 r = socket_read_message(rtnl);
-                if (r == -ENOBUFS) { /* FIXME: ignore buffer overruns for now */
-                        log_debug_errno(r, "Got ENOBUFS from netlink socket, ignoring.");
+                if (r == -ENOBUFS) {
+                        /* The kernel dropped messages because the receive buffer was full. There's
+                         * nothing we can do about the lost messages, but let's make it less likely to
+                         * happen again. */
+                        rtnl->n_overruns++;
+                        netlink_grow_rcvbuf(rtnl);
                         return 1;
                 }
                 if (r <= 0)
@@ -564,22 +675,19 @@ int sd_netlink_wait(sd_netlink *nl, uint64_t timeout_usec) {
         assert_return(nl, -EINVAL);
         assert_return(!rtnl_pid_changed(nl), -ECHILD);
 
+        (void) netlink_flush_wqueue(nl);
+
         if (nl->rqueue_size > 0)
                 return 0;
 
         return rtnl_poll(nl, false, timeout_usec);
 }
 
-static int timeout_compare(const void *a, const void *b) {
-        const struct reply_callback *x = a, *y = b;
-
-        if (x->timeout != 0 && y->timeout == 0)
-                return -1;
-
-        if (x->timeout == 0 && y->timeout != 0)
-                return 1;
+static uint64_t timeout_key(const void *p) {
+        const struct reply_callback *c = p;
 
-        return CMP(x->timeout, y->timeout);
+        /* Callbacks without timeout go last */
+        return c->timeout == 0 ? UINT64_MAX : c->timeout;
 }
 
 int sd_netlink_call_async(
@@ -607,7 +715,7 @@ int sd_netlink_call_async(
                 return r;
 
         if (usec != UINT64_MAX) {
-                r = prioq_ensure_allocated(&nl->reply_callbacks_prioq, timeout_compare);
+                r = prioq_ensure_allocated_keyed(&nl->reply_callbacks_prioq, timeout_key, NULL);
                 if (r < 0)
                         return r;
         }
@@ -619,7 +727,10 @@ int sd_netlink_call_async(
         slot->reply_callback.callback = callback;
         slot->reply_callback.timeout = calc_elapse(usec);
 
-        k = sd_netlink_send(nl, m, &slot->reply_callback.serial);
+        if (nl->batching && nl->io_event_source)
+                k = netlink_queue_message(nl, m, &slot->reply_callback.serial);
+        else
+                k = sd_netlink_send(nl, m, &slot->reply_callback.serial);
         if (k < 0)
                 return k;
 
@@ -809,6 +920,10 @@ static int prepare_callback(sd_event_source *s, void *userdata) {
         assert(s);
         assert(rtnl);
 
+        /* Write out everything queued up while we were dispatching, before we go to sleep. If that fails,
+         * the failures are queued up as replies, and the timeout set up below makes us process them. */
+        (void) netlink_flush_wqueue(rtnl);
+
         e = sd_netlink_get_events(rtnl);
         if (e < 0)
                 return e;
@@ -891,6 +1006,8 @@ int sd_netlink_detach_event(sd_netlink *rtnl) {
         assert_return(rtnl, -EINVAL);
         assert_return(rtnl->event, -ENXIO);
 
+        (void) netlink_flush_wqueue(rtnl);
+
         rtnl->io_event_source = sd_event_source_unref(rtnl->io_event_source);
 
         rtnl->time_event_source = sd_event_source_unref(rtnl->time_event_source);
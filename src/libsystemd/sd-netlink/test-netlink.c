@@ -9,6 +9,7 @@
 #include "alloc-util.h"
 #include "ether-addr-util.h"
 #include "macro.h"
+#include "netlink-internal.h"
 #include "netlink-util.h"
 #include "socket-util.h"
 #include "stdio-util.h"
@@ -423,6 +424,36 @@ static void test_pipe(int ifindex) {
         assert_se((rtnl = sd_netlink_unref(rtnl)) == NULL);
 }
 
+static void test_pipe_batched(int ifindex) {
+        _cleanup_(sd_event_unrefp) sd_event *event = NULL;
+        _cleanup_(sd_netlink_unrefp) sd_netlink *rtnl = NULL;
+        int counter = 0;
+
+        assert_se(sd_event_new(&event) >= 0);
+        assert_se(sd_netlink_open(&rtnl) >= 0);
+        assert_se(sd_netlink_attach_event(rtnl, event, 0) >= 0);
+        assert_se(netlink_set_batching(rtnl, true) >= 0);
+
+        for (unsigned i = 0; i < 3; i++) {
+                _cleanup_(sd_netlink_message_unrefp) sd_netlink_message *m = NULL;
+
+                assert_se(sd_rtnl_message_new_link(rtnl, &m, RTM_GETLINK, ifindex) >= 0);
+
+                counter++;
+                assert_se(sd_netlink_call_async(rtnl, NULL, m, pipe_handler, NULL, &counter, 0, NULL) >= 0);
+        }
+
+        /* The requests are only written out once the event loop is about to wait */
+        assert_se(rtnl->wqueue_size == 3);
+
+        while (counter > 0)
+                assert_se(sd_event_run(event, UINT64_MAX) >= 0);
+
+        assert_se(rtnl->wqueue_size == 0);
+
+        assert_se(sd_netlink_detach_event(rtnl) >= 0);
+}
+
 static void test_container(sd_netlink *rtnl) {
         _cleanup_(sd_netlink_message_unrefp) sd_netlink_message *m = NULL;
         uint16_t u16_data;
@@ -607,6 +638,7 @@ int main(void) {
         test_slot_set(if_loopback);
         test_async_destroy_callback(if_loopback);
         test_pipe(if_loopback);
+        test_pipe_batched(if_loopback);
         test_event_loop(if_loopback);
         test_link_configure(rtnl, if_loopback);
 
@@ -11,6 +11,9 @@
 
 bool network_is_online(void);
 
+typedef struct Set Set;
+int network_monitor_flush_links(sd_network_monitor *m, Set **ret_changed);
+
 typedef enum LinkOperationalState {
         LINK_OPERSTATE_MISSING,
         LINK_OPERSTATE_OFF,
@@ -11,7 +11,9 @@
 #include "fd-util.h"
 #include "fs-util.h"
 #include "macro.h"
+#include "network-util.h"
 #include "parse-util.h"
+#include "set.h"
 #include "stdio-util.h"
 #include "string-util.h"
 #include "strv.h"
@@ -405,13 +407,13 @@ _public_ sd_network_monitor* sd_network_monitor_unref(sd_network_monitor *m) {
         return NULL;
 }
 
-_public_ int sd_network_monitor_flush(sd_network_monitor *m) {
+static int monitor_flush(sd_network_monitor *m, Set **changed, bool *all) {
         union inotify_event_buffer buffer;
         struct inotify_event *e;
         ssize_t l;
         int fd, k;
 
-        assert_return(m, -EINVAL);
+        assert(m);
 
         fd = MONITOR_TO_FD(m);
 
@@ -432,9 +434,65 @@ _public_ int sd_network_monitor_flush(sd_network_monitor *m) {
                         k = inotify_rm_watch(fd, e->wd);
                         if (k < 0)
                                 return -errno;
+
+                        /* The links directory just appeared, its contents were never reported. */
+                        if (all)
+                                *all = true;
+                        continue;
+                }
+
+                if (!changed || (all && *all))
+                        continue;
+
+                if (e->mask & IN_Q_OVERFLOW || e->len == 0) {
+                        if (all)
+                                *all = true;
+                        continue;
+                }
+
+                k = parse_ifindex(e->name);
+                if (k < 0) {
+                        if (all)
+                                *all = true;
+                        continue;
                 }
+
+                k = set_ensure_put(changed, NULL, INT_TO_PTR(k));
+                if (k < 0)
+                        return k;
+        }
+
+        return 0;
+}
+
+_public_ int sd_network_monitor_flush(sd_network_monitor *m) {
+        assert_return(m, -EINVAL);
+
+        return monitor_flush(m, NULL, NULL);
+}
+
+int network_monitor_flush_links(sd_network_monitor *m, Set **ret_changed) {
+        _cleanup_set_free_ Set *changed = NULL;
+        bool all = false;
+        int r;
+
+        assert(m);
+        assert(ret_changed);
+
+        /* Like sd_network_monitor_flush(), but also tells which links changed: returns 0 and the
+         * ifindexes of the links whose state files were updated or removed in *ret_changed, or 1 if
+         * that could not be determined and all links need to be checked. */
+
+        r = monitor_flush(m, &changed, &all);
+        if (r < 0)
+                return r;
+
+        if (all) {
+                *ret_changed = NULL;
+                return 1;
         }
 
+        *ret_changed = TAKE_PTR(changed);
         return 0;
 }
 
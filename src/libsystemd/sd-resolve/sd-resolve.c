@@ -25,9 +25,10 @@
 #include "process-util.h"
 #include "resolve-private.h"
 #include "socket-util.h"
+#include "string-util.h"
 
 #define WORKERS_MIN 1U
-#define WORKERS_MAX 16U
+#define WORKERS_MAX 32U
 #define QUERIES_MAX 256U
 #define BUFSIZE 10240U
 
@@ -84,6 +85,16 @@ struct sd_resolve_query {
         bool floating:1;
         unsigned id;
 
+        /* The id of the request the worker threads answer on behalf of this query. This is our own id,
+         * unless an identical lookup was already in flight when we were issued and we are piggybacking on
+         * its response. */
+        unsigned request_id;
+
+        /* The parameters of getaddrinfo() lookups, so that identical ones can be coalesced */
+        char *node, *service;
+        bool hints_valid;
+        int ai_flags, ai_family, ai_socktype, ai_protocol;
+
         int ret;
         int _errno;
         int _h_errno;
@@ -731,6 +742,45 @@ static int unserialize_addrinfo(const void **p, size_t *length, struct addrinfo
         return 0;
 }
 
+static int handle_addrinfo_response(sd_resolve *resolve, sd_resolve_query *q, const Packet *packet, size_t length) {
+        const AddrInfoResponse *ai_resp = &packet->addrinfo_response;
+        struct addrinfo *prev = NULL;
+        const void *p;
+        size_t l;
+        int r;
+
+        assert(resolve);
+        assert(q);
+        assert(packet);
+        assert(length >= sizeof(AddrInfoResponse));
+
+        query_assign_errno(q, ai_resp->ret, ai_resp->_errno, ai_resp->_h_errno);
+
+        l = length - sizeof(AddrInfoResponse);
+        p = (const uint8_t*) ai_resp + sizeof(AddrInfoResponse);
+
+        while (l > 0 && p) {
+                struct addrinfo *ai = NULL;
+
+                r = unserialize_addrinfo(&p, &l, &ai);
+                if (r < 0) {
+                        query_assign_errno(q, EAI_SYSTEM, r, 0);
+                        freeaddrinfo(q->addrinfo);
+                        q->addrinfo = NULL;
+                        break;
+                }
+
+                if (prev)
+                        prev->ai_next = ai;
+                else
+                        q->addrinfo = ai;
+
+                prev = ai;
+        }
+
+        return complete_query(resolve, q);
+}
+
 static int handle_response(sd_resolve *resolve, const Packet *packet, size_t length) {
         const RHeader *resp;
         sd_resolve_query *q;
@@ -752,46 +802,46 @@ static int handle_response(sd_resolve *resolve, const Packet *packet, size_t len
         resolve->n_outstanding--;
 
         q = lookup_query(resolve, resp->id);
-        if (!q)
-                return 0;
+        if (!q) {
+                if (resp->type != RESPONSE_ADDRINFO)
+                        return 0;
 
-        switch (resp->type) {
+                /* The query that issued the request is gone already, but others might have been coalesced
+                 * with it. Pick one of them to unpack the response into. */
+                LIST_FOREACH(queries, q, resolve->queries)
+                        if (q->type == REQUEST_ADDRINFO && !q->done && q->request_id == resp->id)
+                                break;
+                if (!q)
+                        return 0;
+        }
 
-        case RESPONSE_ADDRINFO: {
-                const AddrInfoResponse *ai_resp = &packet->addrinfo_response;
-                const void *p;
-                size_t l;
-                struct addrinfo *prev = NULL;
+        switch (resp->type) {
 
+        case RESPONSE_ADDRINFO:
                 assert_return(length >= sizeof(AddrInfoResponse), -EBADMSG);
                 assert_return(q->type == REQUEST_ADDRINFO, -EBADMSG);
 
-                query_assign_errno(q, ai_resp->ret, ai_resp->_errno, ai_resp->_h_errno);
-
-                l = length - sizeof(AddrInfoResponse);
-                p = (const uint8_t*) resp + sizeof(AddrInfoResponse);
+                r = handle_addrinfo_response(resolve, q, packet, length);
+                if (r < 0)
+                        return r;
 
-                while (l > 0 && p) {
-                        struct addrinfo *ai = NULL;
+                /* Complete all queries that were coalesced with this one, too. Note that the callbacks may
+                 * add and remove queries, hence look for the next one from the start each time. */
+                for (;;) {
+                        sd_resolve_query *i;
 
-                        r = unserialize_addrinfo(&p, &l, &ai);
-                        if (r < 0) {
-                                query_assign_errno(q, EAI_SYSTEM, r, 0);
-                                freeaddrinfo(q->addrinfo);
-                                q->addrinfo = NULL;
+                        LIST_FOREACH(queries, i, resolve->queries)
+                                if (i->type == REQUEST_ADDRINFO && !i->done && i->request_id == resp->id)
+                                        break;
+                        if (!i)
                                 break;
-                        }
 
-                        if (prev)
-                                prev->ai_next = ai;
-                        else
-                                q->addrinfo = ai;
-
-                        prev = ai;
+                        r = handle_addrinfo_response(resolve, i, packet, length);
+                        if (r < 0)
+                                return r;
                 }
 
-                return complete_query(resolve, q);
-        }
+                return 0;
 
         case RESPONSE_NAMEINFO: {
                 const NameInfoResponse *ni_resp = &packet->nameinfo_response;
@@ -907,7 +957,7 @@ static int alloc_query(sd_resolve *resolve, bool floating, sd_resolve_query **_q
         q->n_ref = 1;
         q->resolve = resolve;
         q->floating = floating;
-        q->id = resolve->current_id++;
+        q->id = q->request_id = resolve->current_id++;
 
         if (!floating)
                 sd_resolve_ref(resolve);
@@ -919,6 +969,33 @@ static int alloc_query(sd_resolve *resolve, bool floating, sd_resolve_query **_q
         return 0;
 }
 
+static sd_resolve_query *find_pending_addrinfo_query(sd_resolve *resolve, sd_resolve_query *q) {
+        sd_resolve_query *i;
+
+        assert(resolve);
+        assert(q);
+
+        LIST_FOREACH(queries, i, resolve->queries) {
+                if (i == q)
+                        continue;
+
+                if (i->type != REQUEST_ADDRINFO || i->done)
+                        continue;
+
+                if (i->hints_valid != q->hints_valid ||
+                    i->ai_flags != q->ai_flags ||
+                    i->ai_family != q->ai_family ||
+                    i->ai_socktype != q->ai_socktype ||
+                    i->ai_protocol != q->ai_protocol)
+                        continue;
+
+                if (streq_ptr(i->node, q->node) && streq_ptr(i->service, q->service))
+                        return i;
+        }
+
+        return NULL;
+}
+
 int resolve_getaddrinfo_with_destroy_callback(
                 sd_resolve *resolve,
                 sd_resolve_query **ret_query,
@@ -929,6 +1006,7 @@ int resolve_getaddrinfo_with_destroy_callback(
                 void *userdata) {
 
         _cleanup_(sd_resolve_query_unrefp) sd_resolve_query *q = NULL;
+        sd_resolve_query *other;
         size_t node_len, service_len;
         AddrInfoRequest req = {};
         struct iovec iov[3];
@@ -948,6 +1026,38 @@ int resolve_getaddrinfo_with_destroy_callback(
         q->getaddrinfo_handler = callback;
         q->userdata = userdata;
 
+        q->hints_valid = hints;
+        q->ai_flags = hints ? hints->ai_flags : 0;
+        q->ai_family = hints ? hints->ai_family : 0;
+        q->ai_socktype = hints ? hints->ai_socktype : 0;
+        q->ai_protocol = hints ? hints->ai_protocol : 0;
+
+        if (node) {
+                q->node = strdup(node);
+                if (!q->node)
+                        return -ENOMEM;
+        }
+
+        if (service) {
+                q->service = strdup(service);
+                if (!q->service)
+                        return -ENOMEM;
+        }
+
+        /* If an identical lookup is already in flight, don't bother the workers again, but share its
+         * response. */
+        other = find_pending_addrinfo_query(resolve, q);
+        if (other) {
+                q->request_id = other->request_id;
+                q->destroy_callback = destroy_callback;
+
+                if (ret_query)
+                        *ret_query = q;
+
+                TAKE_PTR(q);
+                return 0;
+        }
+
         node_len = node ? strlen(node) + 1 : 0;
         service_len = service ? strlen(service) + 1 : 0;
 
@@ -1152,6 +1262,8 @@ static sd_resolve_query *resolve_query_free(sd_resolve_query *q) {
         resolve_freeaddrinfo(q->addrinfo);
         free(q->host);
         free(q->serv);
+        free(q->node);
+        free(q->service);
 
         return mfree(q);
 }
@@ -50,6 +50,48 @@ static int getnameinfo_handler(sd_resolve_query *q, int ret, const char *host, c
         return 0;
 }
 
+static int getaddrinfo_count_handler(sd_resolve_query *q, int ret, const struct addrinfo *ai, void *userdata) {
+        unsigned *n = userdata;
+
+        assert_se(q);
+        assert_se(ret == 0);
+        assert_se(ai);
+
+        (*n)++;
+        return 0;
+}
+
+static void test_coalesce(void) {
+        _cleanup_(sd_resolve_query_unrefp) sd_resolve_query *q1 = NULL, *q2 = NULL, *q3 = NULL;
+        _cleanup_(sd_resolve_unrefp) sd_resolve *resolve = NULL;
+        unsigned n = 0;
+        int r;
+
+        assert_se(sd_resolve_new(&resolve) >= 0);
+
+        /* Identical lookups share a single request, and are all answered even if the one that issued the
+         * request goes away early */
+        assert_se(sd_resolve_getaddrinfo(resolve, &q1, "localhost", "http", NULL, getaddrinfo_count_handler, &n) >= 0);
+        assert_se(sd_resolve_getaddrinfo(resolve, &q2, "localhost", "http", NULL, getaddrinfo_count_handler, &n) >= 0);
+        assert_se(sd_resolve_getaddrinfo(resolve, &q3, "localhost", "http", NULL, getaddrinfo_count_handler, &n) >= 0);
+        q1 = sd_resolve_query_unref(q1);
+
+        for (;;) {
+                r = sd_resolve_wait(resolve, TEST_TIMEOUT_USEC);
+                if (r == 0)
+                        break;
+                if (r == -ETIMEDOUT) {
+                        log_notice_errno(r, "sd_resolve_wait() timed out, but that's OK");
+                        return;
+                }
+                assert_se(r >= 0);
+        }
+
+        assert_se(n == 2);
+        assert_se(sd_resolve_query_is_done(q2) > 0);
+        assert_se(sd_resolve_query_is_done(q3) > 0);
+}
+
 int main(int argc, char *argv[]) {
         _cleanup_(sd_resolve_query_unrefp) sd_resolve_query *q1 = NULL, *q2 = NULL;
         _cleanup_(sd_resolve_unrefp) sd_resolve *resolve = NULL;
@@ -66,6 +108,8 @@ int main(int argc, char *argv[]) {
                 .sin_port = htobe16(80)
         };
 
+        test_coalesce();
+
         assert_se(sd_resolve_default(&resolve) >= 0);
 
         /* Test a floating resolver query */
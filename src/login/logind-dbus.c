@@ -668,6 +668,7 @@ static int method_list_inhibitors(sd_bus_message *message, void *userdata, sd_bu
 
 static int method_create_session(sd_bus_message *message, void *userdata, sd_bus_error *error) {
         const char *service, *type, *class, *cseat, *tty, *display, *remote_user, *remote_host, *desktop;
+        usec_t begin = now(CLOCK_MONOTONIC);
         _cleanup_free_ char *id = NULL;
         Session *session = NULL;
         uint32_t audit_id = 0;
@@ -879,6 +880,8 @@ static int method_create_session(sd_bus_message *message, void *userdata, sd_bus
         if (r < 0)
                 goto fail;
 
+        session->create_begin_usec = begin;
+
         session_set_user(session, user);
         r = session_set_leader(session, leader);
         if (r < 0)
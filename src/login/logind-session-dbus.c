@@ -789,6 +789,16 @@ int session_send_create_reply(Session *s, sd_bus_error *error) {
         if (error)
                 return sd_bus_reply_method_error(c, error);
 
+        if (DEBUG_LOGGING && s->create_begin_usec > 0) {
+                char total[FORMAT_TIMESPAN_MAX], scope[FORMAT_TIMESPAN_MAX];
+
+                /* The remainder is spent waiting for the scope job and possibly user@.service to finish */
+                log_debug("Session %s is ready %s after it was requested, queueing the scope job took %s.",
+                          s->id,
+                          format_timespan(total, sizeof total, usec_sub_unsigned(now(CLOCK_MONOTONIC), s->create_begin_usec), USEC_PER_MSEC),
+                          format_timespan(scope, sizeof scope, s->create_scope_usec, USEC_PER_MSEC));
+        }
+
         fifo_fd = session_create_fifo(s);
         if (fifo_fd < 0)
                 return fifo_fd;
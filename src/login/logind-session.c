@@ -648,6 +648,7 @@ static int session_start_scope(Session *s, sd_bus_message *properties, sd_bus_er
         if (!s->scope) {
                 _cleanup_free_ char *scope = NULL;
                 const char *description;
+                usec_t begin;
 
                 s->scope_job = mfree(s->scope_job);
 
@@ -657,6 +658,8 @@ static int session_start_scope(Session *s, sd_bus_message *properties, sd_bus_er
 
                 description = strjoina("Session ", s->id, " of user ", s->user->user_record->user_name);
 
+                begin = now(CLOCK_MONOTONIC);
+
                 r = manager_start_scope(
                                 s->manager,
                                 scope,
@@ -679,6 +682,7 @@ static int session_start_scope(Session *s, sd_bus_message *properties, sd_bus_er
                         return log_error_errno(r, "Failed to start session scope %s: %s",
                                                scope, bus_error_message(error, r));
 
+                s->create_scope_usec = usec_sub_unsigned(now(CLOCK_MONOTONIC), begin);
                 s->scope = TAKE_PTR(scope);
         }
 
@@ -108,6 +108,11 @@ struct Session {
 
         sd_bus_message *create_message;
 
+        /* When the CreateSession() call was received, and how long it took to get the scope job queued
+         * (CLOCK_MONOTONIC), for logging the login latency */
+        usec_t create_begin_usec;
+        usec_t create_scope_usec;
+
         /* Set up when a client requested to release the session via the bus */
         sd_event_source *timer_event_source;
 
@@ -18,6 +18,7 @@
 #include "loop-util.h"
 #include "missing_capability.h"
 #include "mount-util.h"
+#include "nulstr-util.h"
 #include "os-util.h"
 #include "process-util.h"
 #include "raw-clone.h"
@@ -233,6 +234,8 @@ int bus_image_method_mark_read_only(
         if (r < 0)
                 return r;
 
+        manager_flush_discovered_images(m);
+
         return sd_bus_reply_method_return(message, NULL);
 }
 
@@ -272,6 +275,8 @@ int bus_image_method_set_limit(
         if (r < 0)
                 return r;
 
+        manager_flush_discovered_images(m);
+
         return sd_bus_reply_method_return(message, NULL);
 }
 
@@ -423,6 +428,123 @@ static int image_object_find(sd_bus *bus, const char *path, const char *interfac
         return 1;
 }
 
+/* Enumerating all images is expensive on hosts with many of them, since we have to look at the btrfs
+ * subvolume and quota data of each. Hence we keep the last result around, and drop it whenever inotify tells
+ * us that something changed in one of the image directories. Changes of the disk usage inside of an image
+ * are not reported that way, hence the result also expires after a short while. */
+#define DISCOVERED_IMAGES_MAX_AGE_USEC (5 * USEC_PER_SEC)
+
+void manager_flush_discovered_images(Manager *m) {
+        assert(m);
+
+        m->discovered_images = hashmap_free(m->discovered_images);
+        m->discovered_images_timestamp = 0;
+}
+
+static int image_pool_dispatch_inotify(sd_event_source *s, const struct inotify_event *event, void *userdata) {
+        Manager *m = userdata;
+
+        assert(s);
+        assert(event);
+        assert(m);
+
+        manager_flush_discovered_images(m);
+
+        if (event->mask & (IN_DELETE_SELF|IN_MOVE_SELF|IN_IGNORED)) {
+                sd_event_source *i;
+                const char *path;
+
+                /* The directory is gone, stop watching it. We'll try to add a new watch on the next
+                 * enumeration, should it reappear. */
+                HASHMAP_FOREACH_KEY(i, path, m->image_pool_watches)
+                        if (i == s) {
+                                (void) hashmap_remove(m->image_pool_watches, path);
+                                (void) sd_event_source_disable_unref(s);
+                                break;
+                        }
+        }
+
+        return 0;
+}
+
+static int image_pool_watch(Manager *m) {
+        const char *path;
+        bool changed = false;
+        int r;
+
+        assert(m);
+
+        NULSTR_FOREACH(path, image_class_search_path(IMAGE_MACHINE)) {
+                _cleanup_(sd_event_source_unrefp) sd_event_source *s = NULL;
+
+                if (hashmap_contains(m->image_pool_watches, path))
+                        continue;
+
+                r = sd_event_add_inotify(m->event, &s, path,
+                                         IN_CREATE|IN_DELETE|IN_MOVED_FROM|IN_MOVED_TO|IN_ATTRIB|IN_MODIFY|IN_CLOSE_WRITE|
+                                         IN_DELETE_SELF|IN_MOVE_SELF|IN_ONLYDIR,
+                                         image_pool_dispatch_inotify, m);
+                if (IN_SET(r, -ENOENT, -ENOTDIR))
+                        continue;
+                if (r < 0)
+                        return log_debug_errno(r, "Failed to watch image directory %s: %m", path);
+
+                (void) sd_event_source_set_description(s, "image-pool");
+
+                r = hashmap_ensure_put(&m->image_pool_watches, &string_hash_ops, path, s);
+                if (r < 0)
+                        return r;
+
+                TAKE_PTR(s);
+
+                /* A directory showed up we weren't watching before, any earlier result is incomplete */
+                changed = true;
+        }
+
+        return changed;
+}
+
+int manager_discover_images(Manager *m, Hashmap **ret) {
+        _cleanup_hashmap_free_ Hashmap *images = NULL;
+        usec_t n;
+        int r;
+
+        assert(m);
+        assert(ret);
+
+        /* Returns the images currently in the pool. The returned hashmap is owned by the manager and only
+         * valid until the next iteration of the event loop. */
+
+        /* If we failed to watch some directory we can't cache anything, and if we started to watch a
+         * new one the earlier result is incomplete. */
+        r = image_pool_watch(m);
+        if (r != 0)
+                manager_flush_discovered_images(m);
+
+        n = now(CLOCK_MONOTONIC);
+
+        if (m->discovered_images &&
+            n < usec_add(m->discovered_images_timestamp, DISCOVERED_IMAGES_MAX_AGE_USEC)) {
+                *ret = m->discovered_images;
+                return 0;
+        }
+
+        images = hashmap_new(&image_hash_ops);
+        if (!images)
+                return -ENOMEM;
+
+        r = image_discover(IMAGE_MACHINE, NULL, images);
+        if (r < 0)
+                return r;
+
+        hashmap_free(m->discovered_images);
+        m->discovered_images = TAKE_PTR(images);
+        m->discovered_images_timestamp = n;
+
+        *ret = m->discovered_images;
+        return 0;
+}
+
 char *image_bus_path(const char *name) {
         _cleanup_free_ char *e = NULL;
 
@@ -436,20 +558,18 @@ char *image_bus_path(const char *name) {
 }
 
 static int image_node_enumerator(sd_bus *bus, const char *path, void *userdata, char ***nodes, sd_bus_error *error) {
-        _cleanup_hashmap_free_ Hashmap *images = NULL;
         _cleanup_strv_free_ char **l = NULL;
+        Manager *m = userdata;
+        Hashmap *images;
         Image *image;
         int r;
 
         assert(bus);
         assert(path);
         assert(nodes);
+        assert(m);
 
-        images = hashmap_new(&image_hash_ops);
-        if (!images)
-                return -ENOMEM;
-
-        r = image_discover(IMAGE_MACHINE, NULL, images);
+        r = manager_discover_images(m, &images);
         if (r < 0)
                 return r;
 
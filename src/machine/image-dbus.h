@@ -8,6 +8,9 @@ extern const BusObjectImplementation image_object;
 
 char *image_bus_path(const char *name);
 
+int manager_discover_images(Manager *m, Hashmap **ret);
+void manager_flush_discovered_images(Manager *m);
+
 int bus_image_method_remove(sd_bus_message *message, void *userdata, sd_bus_error *error);
 int bus_image_method_rename(sd_bus_message *message, void *userdata, sd_bus_error *error);
 int bus_image_method_clone(sd_bus_message *message, void *userdata, sd_bus_error *error);
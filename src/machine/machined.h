@@ -29,6 +29,10 @@ struct Manager {
         Hashmap *image_cache;
         sd_event_source *image_cache_defer_event;
 
+        Hashmap *discovered_images;
+        usec_t discovered_images_timestamp;
+        Hashmap *image_pool_watches;
+
         LIST_HEAD(Machine, machine_gc_queue);
 
         Machine *host_machine;
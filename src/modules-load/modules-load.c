@@ -6,18 +6,24 @@
 #include <sys/stat.h>
 
 #include "conf-files.h"
+#include "cpu-set-util.h"
 #include "def.h"
 #include "fd-util.h"
 #include "fileio.h"
 #include "log.h"
 #include "main-func.h"
 #include "module-util.h"
+#include "ordered-set.h"
 #include "pretty-print.h"
 #include "proc-cmdline.h"
+#include "process-util.h"
 #include "string-util.h"
 #include "strv.h"
 #include "util.h"
 
+/* Upper bound for the number of worker processes loading modules in parallel */
+#define MODULES_LOAD_WORKERS_MAX 8U
+
 static char **arg_proc_cmdline_modules = NULL;
 static const char conf_file_dirs[] = CONF_PATHS_NULSTR("modules-load.d");
 
@@ -60,12 +66,12 @@ static int parse_proc_cmdline_item(const char *key, const char *value, void *dat
         return 0;
 }
 
-static int apply_file(struct kmod_ctx *ctx, const char *path, bool ignore_enoent) {
+static int apply_file(const char *path, bool ignore_enoent, OrderedSet **modules) {
         _cleanup_fclose_ FILE *f = NULL;
         int r;
 
-        assert(ctx);
         assert(path);
+        assert(modules);
 
         r = search_and_fopen_nulstr(path, "re", NULL, conf_file_dirs, &f);
         if (r < 0) {
@@ -93,10 +99,92 @@ static int apply_file(struct kmod_ctx *ctx, const char *path, bool ignore_enoent
                 if (strchr(COMMENTS, *l))
                         continue;
 
-                k = module_load_and_warn(ctx, l, true);
+                /* Only collect the module here, so that modules listed in multiple places are loaded just
+                 * once, and all of them can be loaded in parallel afterwards. */
+                if (ordered_set_put_strdup(modules, l) < 0)
+                        return log_oom();
+        }
+
+        return 0;
+}
+
+static int load_modules_one(struct kmod_ctx *ctx, char **modules, size_t n, size_t offset, size_t stride) {
+        int r = 0;
+
+        assert(ctx);
+        assert(stride > 0);
+
+        for (size_t i = offset; i < n; i += stride) {
+                int k;
+
+                k = module_load_and_warn(ctx, modules[i], true);
                 if (k == -ENOENT)
                         continue;
-                if (k < 0 && r >= 0)
+                if (k < 0 && r == 0)
+                        r = k;
+        }
+
+        return r;
+}
+
+static int load_modules(struct kmod_ctx *ctx, OrderedSet *set) {
+        _cleanup_free_ char **modules = NULL;
+        pid_t pids[MODULES_LOAD_WORKERS_MAX];
+        size_t n, n_workers;
+        int r = 0;
+
+        assert(ctx);
+
+        n = ordered_set_size(set);
+        if (n == 0)
+                return 0;
+
+        modules = ordered_set_get_strv(set);
+        if (!modules)
+                return log_oom();
+
+        /* Loading a module mostly means waiting for its init function, which for drivers probing hardware
+         * can take a while. Hence spread the modules over a couple of worker processes, which share the
+         * kmod context and its indexes loaded before forking. Dependencies shared between modules are
+         * fine: the kernel serializes concurrent loads of the same module, and libkmod treats modules
+         * that got loaded in the meantime as success. */
+        r = cpus_in_affinity_mask();
+        n_workers = MIN3(n, MODULES_LOAD_WORKERS_MAX, r > 0 ? (size_t) r : 1U);
+        if (n_workers <= 1)
+                return load_modules_one(ctx, modules, n, 0, 1);
+
+        log_debug("Loading %zu modules using %zu workers.", n, n_workers);
+
+        r = 0;
+        for (size_t i = 0; i < n_workers; i++) {
+                int k;
+
+                k = safe_fork("(modules-load)", FORK_RESET_SIGNALS|FORK_DEATHSIG|FORK_LOG, &pids[i]);
+                if (k < 0) {
+                        /* Load the rest of the modules ourselves, if we can't fork any more workers */
+                        for (size_t j = i; j < n_workers; j++) {
+                                k = load_modules_one(ctx, modules, n, j, n_workers);
+                                if (k < 0 && r == 0)
+                                        r = k;
+                        }
+
+                        n_workers = i;
+                        break;
+                }
+                if (k == 0) {
+                        /* Child */
+                        k = load_modules_one(ctx, modules, n, i, n_workers);
+                        _exit(k < 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+                }
+        }
+
+        for (size_t i = 0; i < n_workers; i++) {
+                int k;
+
+                k = wait_for_terminate_and_check("(modules-load)", pids[i], WAIT_LOG);
+                if (k >= 0 && k != EXIT_SUCCESS)
+                        k = -EPROTO; /* The worker already logged about the failure */
+                if (k < 0 && r == 0)
                         r = k;
         }
 
@@ -159,6 +247,7 @@ static int parse_argv(int argc, char *argv[]) {
 
 static int run(int argc, char *argv[]) {
         _cleanup_(kmod_unrefp) struct kmod_ctx *ctx = NULL;
+        _cleanup_ordered_set_free_ OrderedSet *modules = NULL;
         int r, k;
 
         r = parse_argv(argc, argv);
@@ -188,38 +277,38 @@ static int run(int argc, char *argv[]) {
                 int i;
 
                 for (i = optind; i < argc; i++) {
-                        k = apply_file(ctx, argv[i], false);
+                        k = apply_file(argv[i], false, &modules);
                         if (k < 0 && r == 0)
                                 r = k;
                 }
 
         } else {
                 _cleanup_strv_free_ char **files = NULL;
-                char **fn, **i;
+                char **fn;
 
-                STRV_FOREACH(i, arg_proc_cmdline_modules) {
-                        k = module_load_and_warn(ctx, *i, true);
-                        if (k == -ENOENT)
-                                continue;
-                        if (k < 0 && r == 0)
-                                r = k;
-                }
+                if (ordered_set_put_strdupv(&modules, arg_proc_cmdline_modules) < 0)
+                        return log_oom();
 
                 k = conf_files_list_nulstr(&files, ".conf", NULL, 0, conf_file_dirs);
                 if (k < 0) {
                         log_error_errno(k, "Failed to enumerate modules-load.d files: %m");
                         if (r == 0)
                                 r = k;
-                        return r;
+                        goto finish;
                 }
 
                 STRV_FOREACH(fn, files) {
-                        k = apply_file(ctx, *fn, true);
+                        k = apply_file(*fn, true, &modules);
                         if (k < 0 && r == 0)
                                 r = k;
                 }
         }
 
+finish:
+        k = load_modules(ctx, modules);
+        if (k < 0 && r == 0)
+                r = k;
+
         return r;
 }
 
@@ -156,6 +156,9 @@ typedef struct LinkInfo {
         uint64_t tx_bitrate;
         uint64_t rx_bitrate;
 
+        usec_t udev_usec;
+        usec_t configure_usec;
+
         /* bridge info */
         uint32_t forward_delay;
         uint32_t hello_time;
@@ -218,6 +221,7 @@ typedef struct LinkInfo {
         bool has_stats64:1;
         bool has_stats:1;
         bool has_bitrates:1;
+        bool has_setup_times:1;
         bool has_ethtool_link_info:1;
         bool has_wlan_link_info:1;
         bool has_tunnel_ipv4:1;
@@ -536,6 +540,25 @@ static int acquire_link_bitrates(sd_bus *bus, LinkInfo *link) {
         return 0;
 }
 
+static int acquire_link_setup_times(sd_bus *bus, LinkInfo *link) {
+        _cleanup_(sd_bus_message_unrefp) sd_bus_message *reply = NULL;
+        _cleanup_(sd_bus_error_free) sd_bus_error error = SD_BUS_ERROR_NULL;
+        int r;
+
+        r = link_get_property(bus, link, &error, &reply, "org.freedesktop.network1.Link", "SetupTimes");
+        if (r < 0)
+                return log_full_errno(sd_bus_error_has_name(&error, SD_BUS_ERROR_UNKNOWN_PROPERTY) ? LOG_DEBUG : LOG_WARNING,
+                                      r, "Failed to query link setup times: %s", bus_error_message(&error, r));
+
+        r = sd_bus_message_read(reply, "v", "(tt)", &link->udev_usec, &link->configure_usec);
+        if (r < 0)
+                return bus_log_parse_error(r);
+
+        link->has_setup_times = link->configure_usec != USEC_INFINITY;
+
+        return 0;
+}
+
 static void acquire_ether_link_info(int *fd, LinkInfo *link) {
         if (ethtool_get_link_info(fd, link->name,
                                   &link->autonegotiation,
@@ -644,8 +667,10 @@ static int acquire_link_info(sd_bus *bus, sd_netlink *rtnl, char **patterns, Lin
         typesafe_qsort(links, c, link_info_compare);
 
         if (bus)
-                for (size_t j = 0; j < c; j++)
+                for (size_t j = 0; j < c; j++) {
                         (void) acquire_link_bitrates(bus, links + j);
+                        (void) acquire_link_setup_times(bus, links + j);
+                }
 
         *ret = TAKE_PTR(links);
 
@@ -1982,6 +2007,24 @@ static int link_status_one(
                         return table_log_add_error(r);
         }
 
+        if (info->has_setup_times) {
+                char a[FORMAT_TIMESPAN_MAX], b[FORMAT_TIMESPAN_MAX];
+
+                r = table_add_many(table,
+                                   TABLE_EMPTY,
+                                   TABLE_STRING, "Setup Time:");
+                if (r < 0)
+                        return table_log_add_error(r);
+                if (info->udev_usec != USEC_INFINITY)
+                        r = table_add_cell_stringf(table, NULL, "%s (after %s waiting for udev)",
+                                                   format_timespan(a, sizeof a, info->configure_usec, USEC_PER_MSEC),
+                                                   format_timespan(b, sizeof b, info->udev_usec, USEC_PER_MSEC));
+                else
+                        r = table_add_cell(table, NULL, TABLE_TIMESPAN_MSEC, &info->configure_usec);
+                if (r < 0)
+                        return table_log_add_error(r);
+        }
+
         if (info->has_tx_queues || info->has_rx_queues) {
                 r = table_add_many(table,
                                    TABLE_EMPTY,
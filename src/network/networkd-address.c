@@ -606,22 +606,27 @@ int address_remove(
         return 0;
 }
 
-static bool link_is_static_address_configured(const Link *link, const Address *address) {
+static bool network_has_static_address(const Network *network, const Address *address) {
         Address *net_address;
 
-        assert(link);
         assert(address);
 
-        if (!link->network)
+        if (!network)
                 return false;
 
-        ORDERED_HASHMAP_FOREACH(net_address, link->network->addresses_by_section)
+        ORDERED_HASHMAP_FOREACH(net_address, network->addresses_by_section)
                 if (address_equal(net_address, address))
                         return true;
 
         return false;
 }
 
+static bool link_is_static_address_configured(const Link *link, const Address *address) {
+        assert(link);
+
+        return network_has_static_address(link->network, address);
+}
+
 bool link_address_is_dynamic(const Link *link, const Address *address) {
         Route *route;
 
@@ -760,7 +765,7 @@ static int remove_static_address_handler(sd_netlink *rtnl, sd_netlink_message *m
         return 1;
 }
 
-int link_drop_addresses(Link *link) {
+int link_drop_addresses(Link *link, const Network *keep) {
         Address *address, *pool_address;
         int k, r = 0;
 
@@ -771,6 +776,10 @@ int link_drop_addresses(Link *link) {
                 if (address->family == AF_INET6 && in_addr_is_link_local(AF_INET6, &address->in_addr) == 1 && link_ipv6ll_enabled(link))
                         continue;
 
+                /* the address will be configured again right away, do not remove it in between */
+                if (network_has_static_address(keep, address))
+                        continue;
+
                 k = address_remove(address, link, remove_static_address_handler);
                 if (k < 0 && r >= 0) {
                         r = k;
@@ -66,6 +66,27 @@ static int property_get_bit_rates(
         return sd_bus_message_append(reply, "(tt)", tx, rx);
 }
 
+static int property_get_setup_times(
+                sd_bus *bus,
+                const char *path,
+                const char *interface,
+                const char *property,
+                sd_bus_message *reply,
+                void *userdata,
+                sd_bus_error *error) {
+
+        Link *link = userdata;
+        usec_t udev, configure;
+
+        assert(bus);
+        assert(reply);
+        assert(userdata);
+
+        link_get_setup_times(link, &udev, &configure);
+
+        return sd_bus_message_append(reply, "(tt)", udev, configure);
+}
+
 static int verify_managed_link(Link *l, sd_bus_error *error) {
         assert(l);
 
@@ -686,6 +707,7 @@ const sd_bus_vtable link_vtable[] = {
         SD_BUS_PROPERTY("AddressState", "s", property_get_address_state, offsetof(Link, address_state), SD_BUS_VTABLE_PROPERTY_EMITS_CHANGE),
         SD_BUS_PROPERTY("AdministrativeState", "s", property_get_administrative_state, offsetof(Link, state), SD_BUS_VTABLE_PROPERTY_EMITS_CHANGE),
         SD_BUS_PROPERTY("BitRates", "(tt)", property_get_bit_rates, 0, 0),
+        SD_BUS_PROPERTY("SetupTimes", "(tt)", property_get_setup_times, 0, 0),
 
         SD_BUS_METHOD_WITH_ARGS("SetNTP",
                                 SD_BUS_ARGS("as", servers),
@@ -411,6 +411,8 @@ static int link_new(Manager *manager, sd_netlink_message *message, Link **ret) {
                 .dns_over_tls_mode = _DNS_OVER_TLS_MODE_INVALID,
         };
 
+        link->state_timestamp[LINK_STATE_PENDING] = now(clock_boottime_or_monotonic());
+
         link->ifname = strdup(ifname);
         if (!link->ifname)
                 return -ENOMEM;
@@ -519,6 +521,8 @@ static Link *link_free(Link *link) {
         link_ntp_settings_clear(link);
         link_dns_settings_clear(link);
 
+        link_traffic_control_forget_applied(link);
+
         link->routes = set_free(link->routes);
         link->routes_foreign = set_free(link->routes_foreign);
         link->dhcp_routes = set_free(link->dhcp_routes);
@@ -598,11 +602,31 @@ void link_set_state(Link *link, LinkState state) {
                        link_state_to_string(state));
 
         link->state = state;
+        link->state_timestamp[state] = now(clock_boottime_or_monotonic());
 
         link_send_changed(link, "AdministrativeState", NULL);
         link_dirty(link);
 }
 
+void link_get_setup_times(Link *link, usec_t *ret_udev, usec_t *ret_configure) {
+        usec_t pending, configuring, configured;
+
+        assert(link);
+
+        /* Returns how long the link waited for udev before configuration started, and how long the
+         * last configuration took until the link was configured. USEC_INFINITY if not (yet) known. */
+
+        pending = link->state_timestamp[LINK_STATE_PENDING];
+        configuring = link->state_timestamp[LINK_STATE_CONFIGURING];
+        configured = link->state_timestamp[LINK_STATE_CONFIGURED];
+
+        if (ret_udev)
+                *ret_udev = pending > 0 && configuring >= pending ? configuring - pending : USEC_INFINITY;
+        if (ret_configure)
+                *ret_configure = link->state == LINK_STATE_CONFIGURED && configuring > 0 && configured >= configuring ?
+                        configured - configuring : USEC_INFINITY;
+}
+
 static void link_enter_unmanaged(Link *link) {
         assert(link);
 
@@ -717,6 +741,16 @@ static void link_enter_configured(Link *link) {
 
         link_set_state(link, LINK_STATE_CONFIGURED);
 
+        if (DEBUG_LOGGING) {
+                char a[FORMAT_TIMESPAN_MAX], b[FORMAT_TIMESPAN_MAX];
+                usec_t udev, configure;
+
+                link_get_setup_times(link, &udev, &configure);
+                log_link_debug(link, "Configured in %s (%s waiting for udev).",
+                               format_timespan(a, sizeof a, configure, USEC_PER_MSEC),
+                               format_timespan(b, sizeof b, udev, USEC_PER_MSEC));
+        }
+
         (void) link_join_netdevs_after_configured(link);
 }
 
@@ -2015,19 +2049,22 @@ static int link_drop_foreign_config(Link *link) {
         return r;
 }
 
-static int link_drop_config(Link *link) {
+static int link_drop_config(Link *link, const Network *keep) {
         int k, r;
 
         assert(link);
         assert(link->manager);
 
-        r = link_drop_addresses(link);
+        /* When 'keep' is set, the link is about to be reconfigured with it. Static addresses and routes
+         * it configures as well are left in place, so that they do not vanish for a moment. */
+
+        r = link_drop_addresses(link, keep);
 
         k = link_drop_neighbors(link);
         if (k < 0 && r >= 0)
                 r = k;
 
-        k = link_drop_routes(link);
+        k = link_drop_routes(link, keep);
         if (k < 0 && r >= 0)
                 r = k;
 
@@ -2192,12 +2229,16 @@ static int link_reconfigure_internal(Link *link, sd_netlink_message *m, bool for
 
         log_link_info(link, "Re-configuring with %s", network->filename);
 
+        /* When forced, send all traffic control requests again, even if they did not change. */
+        if (force)
+                link_traffic_control_forget_applied(link);
+
         /* Dropping old .network file */
         r = link_stop_engines(link, false);
         if (r < 0)
                 return r;
 
-        r = link_drop_config(link);
+        r = link_drop_config(link, network);
         if (r < 0)
                 return r;
 
@@ -2633,7 +2674,7 @@ static int link_carrier_lost(Link *link) {
                 return r;
         }
 
-        r = link_drop_config(link);
+        r = link_drop_config(link, NULL);
         if (r < 0)
                 return r;
 
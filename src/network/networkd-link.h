@@ -72,6 +72,7 @@ typedef struct Link {
         Network *network;
 
         LinkState state;
+        usec_t state_timestamp[_LINK_STATE_MAX]; /* when each state was last entered */
         LinkOperationalState operstate;
         LinkCarrierState carrier_state;
         LinkAddressState address_state;
@@ -84,6 +85,7 @@ typedef struct Link {
         unsigned nexthop_messages;
         unsigned routing_policy_rule_messages;
         unsigned tc_messages;
+        Set *tc_applied; /* hashes of the traffic control requests sent for this link */
         unsigned sr_iov_messages;
         unsigned enslaving;
         unsigned bridge_mdb_messages;
@@ -209,6 +211,7 @@ int link_down(Link *link, link_netlink_message_handler_t callback);
 void link_enter_failed(Link *link);
 
 void link_set_state(Link *link, LinkState state);
+void link_get_setup_times(Link *link, usec_t *ret_udev, usec_t *ret_configure);
 void link_check_ready(Link *link);
 
 void link_update_operstate(Link *link, bool also_update_bond_master);
@@ -274,6 +274,11 @@ static int manager_connect_rtnl(Manager *m) {
         if (r < 0)
                 return r;
 
+        /* Many links, addresses and routes are configured at once, write the requests out together */
+        r = netlink_set_batching(m->rtnl, true);
+        if (r < 0)
+                return r;
+
         r = netlink_add_match(m->rtnl, NULL, RTM_NEWLINK, &manager_rtnl_process_link, NULL, m, "network-rtnl_process_link");
         if (r < 0)
                 return r;
@@ -618,17 +623,26 @@ static int manager_enumerate_addresses(Manager *m) {
 }
 
 static int manager_enumerate_neighbors(Manager *m) {
-        _cleanup_(sd_netlink_message_unrefp) sd_netlink_message *req = NULL;
         int r;
 
         assert(m);
         assert(m->rtnl);
 
-        r = sd_rtnl_message_new_neigh(m->rtnl, &req, RTM_GETNEIGH, 0, AF_UNSPEC);
-        if (r < 0)
-                return r;
+        /* Only IPv4 and IPv6 neighbors are tracked. Do not ask for AF_UNSPEC, as then the kernel also
+         * dumps the bridge FDB, which may be huge on bridges facing large L2 domains. */
+        for (size_t i = 0; i < 2; i++) {
+                _cleanup_(sd_netlink_message_unrefp) sd_netlink_message *req = NULL;
 
-        return manager_enumerate_internal(m, req, manager_rtnl_process_neighbor, NULL);
+                r = sd_rtnl_message_new_neigh(m->rtnl, &req, RTM_GETNEIGH, 0, i == 0 ? AF_INET : AF_INET6);
+                if (r < 0)
+                        return r;
+
+                r = manager_enumerate_internal(m, req, manager_rtnl_process_neighbor, NULL);
+                if (r < 0)
+                        return r;
+        }
+
+        return 0;
 }
 
 static int manager_enumerate_routes(Manager *m) {
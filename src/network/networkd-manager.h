@@ -72,6 +72,10 @@ struct Manager {
         Set *routes;
         Set *routes_foreign;
 
+        /* Number of routes we know about, by route protocol. If ManageForeignRoutes= is off, route
+         * messages with a protocol none of our routes uses are ignored without parsing them. */
+        unsigned n_routes_by_protocol[UINT8_MAX + 1];
+
         /* Route table name */
         Hashmap *route_table_numbers_by_name;
         Hashmap *route_table_names_by_number;
@@ -82,6 +86,7 @@ struct Manager {
         usec_t speed_meter_interval_usec;
         usec_t speed_meter_usec_new;
         usec_t speed_meter_usec_old;
+        bool speed_meter_use_getlink; /* RTM_GETSTATS is not supported by the kernel */
 
         bool dhcp4_prefix_root_cannot_set_table:1;
         bool bridge_mdb_on_master_not_supported:1;
@@ -460,7 +460,7 @@ int manager_rtnl_process_neighbor(sd_netlink *rtnl, sd_netlink_message *message,
         _cleanup_free_ char *addr_str = NULL, *lladdr_str = NULL;
         Neighbor *neighbor = NULL;
         uint16_t type, state;
-        int ifindex, r;
+        int ifindex, family, r;
         Link *link;
 
         assert(rtnl);
@@ -484,6 +484,17 @@ int manager_rtnl_process_neighbor(sd_netlink *rtnl, sd_netlink_message *message,
                 return 0;
         }
 
+        /* Bridge FDB entries are reported on the same multicast group. There may be a lot of them, and
+         * we do not track them, hence check the family first, before doing anything else. */
+        r = sd_rtnl_message_neigh_get_family(message, &family);
+        if (r < 0) {
+                log_warning_errno(r, "rtnl: received neighbor message without family, ignoring: %m");
+                return 0;
+        } else if (!IN_SET(family, AF_INET, AF_INET6)) {
+                log_debug("rtnl: received neighbor message with invalid family '%i', ignoring.", family);
+                return 0;
+        }
+
         r = sd_rtnl_message_neigh_get_state(message, &state);
         if (r < 0) {
                 log_warning_errno(r, "rtnl: received neighbor message with invalid state, ignoring: %m");
@@ -511,16 +522,13 @@ int manager_rtnl_process_neighbor(sd_netlink *rtnl, sd_netlink_message *message,
                 return 0;
         }
 
-        tmp = new0(Neighbor, 1);
+        tmp = new(Neighbor, 1);
+        if (!tmp)
+                return log_oom();
 
-        r = sd_rtnl_message_neigh_get_family(message, &tmp->family);
-        if (r < 0) {
-                log_link_warning(link, "rtnl: received neighbor message without family, ignoring.");
-                return 0;
-        } else if (!IN_SET(tmp->family, AF_INET, AF_INET6)) {
-                log_link_debug(link, "rtnl: received neighbor message with invalid family '%i', ignoring.", tmp->family);
-                return 0;
-        }
+        *tmp = (Neighbor) {
+                .family = family,
+        };
 
         r = netlink_message_read_in_addr_union(message, NDA_DST, tmp->family, &tmp->in_addr);
         if (r < 0) {
@@ -289,6 +289,8 @@ int network_load_one(Manager *manager, OrderedHashmap **networks, const char *fi
         _cleanup_free_ char *fname = NULL, *name = NULL;
         _cleanup_(network_unrefp) Network *network = NULL;
         const char *dropin_dirname;
+        uint64_t digest;
+        Network *old;
         char *d;
         int r;
 
@@ -321,6 +323,25 @@ int network_load_one(Manager *manager, OrderedHashmap **networks, const char *fi
 
         dropin_dirname = strjoina(name, ".network.d");
 
+        /* On reload, keep the already loaded network if neither the file nor any of its drop-ins
+         * changed, and don't bother parsing them again. */
+        r = config_files_digest(STRV_MAKE_CONST(filename), NETWORK_DIRS, dropin_dirname, &digest);
+        if (r < 0)
+                return r;
+
+        if (network_get_by_name(manager, name, &old) >= 0 &&
+            streq(old->filename, filename) &&
+            old->config_digest == digest) {
+                log_debug("%s: Unchanged, not parsing again.", filename);
+
+                r = ordered_hashmap_ensure_put(networks, &string_hash_ops, old->name, old);
+                if (r < 0)
+                        return r;
+
+                network_ref(old);
+                return 0;
+        }
+
         network = new(Network, 1);
         if (!network)
                 return log_oom();
@@ -331,6 +352,7 @@ int network_load_one(Manager *manager, OrderedHashmap **networks, const char *fi
 
                 .manager = manager,
                 .n_ref = 1,
+                .config_digest = digest,
 
                 .required_for_online = true,
                 .required_operstate_for_online = LINK_OPERSTATE_RANGE_DEFAULT,
@@ -74,6 +74,7 @@ struct Network {
         char *name;
         char *filename;
         usec_t timestamp;
+        uint64_t config_digest;
         char *description;
 
         /* [Match] section */
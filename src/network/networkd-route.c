@@ -288,6 +288,15 @@ Route *route_free(Route *route) {
                 set_remove(route->manager->routes_foreign, route);
         }
 
+        if (route->manager || route->link) {
+                Manager *m = route->manager ?: route->link->manager;
+
+                if (m) {
+                        assert(m->n_routes_by_protocol[route->protocol] > 0);
+                        m->n_routes_by_protocol[route->protocol]--;
+                }
+        }
+
         ordered_set_free_free(route->multipath_routes);
 
         sd_event_source_unref(route->expire);
@@ -533,6 +542,8 @@ static int route_add_internal(Manager *manager, Link *link, Set **routes, const
         route->link = link;
         route->manager = manager;
 
+        (manager ?: link->manager)->n_routes_by_protocol[route->protocol]++;
+
         if (ret)
                 *ret = route;
 
@@ -801,22 +812,27 @@ int route_remove(
         return 0;
 }
 
-static bool link_has_route(const Link *link, const Route *route) {
+static bool network_has_route(const Network *network, const Route *route) {
         Route *net_route;
 
-        assert(link);
         assert(route);
 
-        if (!link->network)
+        if (!network)
                 return false;
 
-        HASHMAP_FOREACH(net_route, link->network->routes_by_section)
+        HASHMAP_FOREACH(net_route, network->routes_by_section)
                 if (route_equal(net_route, route))
                         return true;
 
         return false;
 }
 
+static bool link_has_route(const Link *link, const Route *route) {
+        assert(link);
+
+        return network_has_route(link->network, route);
+}
+
 static bool links_have_route(const Manager *manager, const Route *route, const Link *except) {
         Link *link;
 
@@ -912,7 +928,7 @@ int link_drop_foreign_routes(Link *link) {
         return r;
 }
 
-int link_drop_routes(Link *link) {
+int link_drop_routes(Link *link, const Network *keep) {
         Route *route;
         int k, r = 0;
 
@@ -923,6 +939,10 @@ int link_drop_routes(Link *link) {
                 if (route->protocol == RTPROT_KERNEL)
                         continue;
 
+                /* the route will be configured again right away, do not remove it in between */
+                if (network_has_route(keep, route))
+                        continue;
+
                 k = route_remove(route, NULL, link, NULL);
                 if (k < 0 && r >= 0)
                         r = k;
@@ -1456,9 +1476,9 @@ int manager_rtnl_process_route(sd_netlink *rtnl, sd_netlink_message *message, Ma
         _cleanup_(route_freep) Route *tmp = NULL;
         _cleanup_free_ void *rta_multipath = NULL;
         Link *link = NULL;
+        unsigned char table, protocol;
         uint32_t ifindex;
         uint16_t type;
-        unsigned char table;
         size_t rta_len;
         int r;
 
@@ -1483,6 +1503,18 @@ int manager_rtnl_process_route(sd_netlink *rtnl, sd_netlink_message *message, Ma
                 return 0;
         }
 
+        r = sd_rtnl_message_route_get_protocol(message, &protocol);
+        if (r < 0) {
+                log_warning_errno(r, "rtnl: received route message without route protocol: %m");
+                return 0;
+        }
+
+        /* On hosts with full routing tables maintained by a routing daemon we'd otherwise parse and look
+         * up every single one of them. When we don't track foreign routes, a route with a protocol none
+         * of our routes has cannot be one of ours, as the protocol is part of the route's identity. */
+        if (!m->manage_foreign_routes && m->n_routes_by_protocol[protocol] == 0)
+                return 0;
+
         r = sd_netlink_message_read_u32(message, RTA_OIF, &ifindex);
         if (r < 0 && r != -ENODATA) {
                 log_warning_errno(r, "rtnl: could not get ifindex from route message, ignoring: %m");
@@ -1516,11 +1548,7 @@ int manager_rtnl_process_route(sd_netlink *rtnl, sd_netlink_message *message, Ma
                 return 0;
         }
 
-        r = sd_rtnl_message_route_get_protocol(message, &tmp->protocol);
-        if (r < 0) {
-                log_warning_errno(r, "rtnl: received route message without route protocol: %m");
-                return 0;
-        }
+        tmp->protocol = protocol;
 
         r = netlink_message_read_in_addr_union(message, RTA_DST, tmp->family, &tmp->dst);
         if (r < 0 && r != -ENODATA) {
@@ -76,7 +76,7 @@ int route_remove(const Route *route, Manager *manager, Link *link, link_netlink_
 
 int link_set_routes(Link *link);
 int link_set_routes_with_gateway(Link *link);
-int link_drop_routes(Link *link);
+int link_drop_routes(Link *link, const Network *keep);
 int link_drop_foreign_routes(Link *link);
 
 uint32_t link_get_dhcp_route_table(const Link *link);
@@ -5,6 +5,7 @@
 #include "sd-event.h"
 #include "sd-netlink.h"
 
+#include "netlink-util.h"
 #include "networkd-link-bus.h"
 #include "networkd-link.h"
 #include "networkd-manager.h"
@@ -19,10 +20,12 @@ static int process_message(Manager *manager, sd_netlink_message *message) {
         if (r < 0)
                 return r;
 
-        if (type != RTM_NEWLINK)
+        if (type == RTM_NEWSTATS)
+                r = rtnl_message_stats_get_ifindex(message, &ifindex);
+        else if (type == RTM_NEWLINK)
+                r = sd_rtnl_message_link_get_ifindex(message, &ifindex);
+        else
                 return 0;
-
-        r = sd_rtnl_message_link_get_ifindex(message, &ifindex);
         if (r < 0)
                 return r;
 
@@ -32,7 +35,8 @@ static int process_message(Manager *manager, sd_netlink_message *message) {
 
         link->stats_old = link->stats_new;
 
-        r = sd_netlink_message_read(message, IFLA_STATS64, sizeof link->stats_new, &link->stats_new);
+        r = sd_netlink_message_read(message, type == RTM_NEWSTATS ? IFLA_STATS_LINK_64 : IFLA_STATS64,
+                                    sizeof link->stats_new, &link->stats_new);
         if (r < 0)
                 return r;
 
@@ -41,8 +45,53 @@ static int process_message(Manager *manager, sd_netlink_message *message) {
         return 0;
 }
 
+static int speed_meter_dump(Manager *manager, sd_netlink_message **ret) {
+        _cleanup_(sd_netlink_message_unrefp) sd_netlink_message *req = NULL;
+        int r;
+
+        assert(manager);
+        assert(ret);
+
+        /* Prefer RTM_GETSTATS with a filter for the 64bit link counters: unlike a RTM_GETLINK dump, the
+         * reply then carries nothing but the counters, which matters with thousands of interfaces. */
+        if (!manager->speed_meter_use_getlink) {
+                r = rtnl_message_new_stats(manager->rtnl, &req, 0, IFLA_STATS_FILTER_BIT(IFLA_STATS_LINK_64));
+                if (r < 0)
+                        return log_warning_errno(r, "Failed to allocate RTM_GETSTATS netlink message: %m");
+
+                r = sd_netlink_message_request_dump(req, true);
+                if (r < 0)
+                        return log_warning_errno(r, "Failed to set dump flag: %m");
+
+                r = sd_netlink_call(manager->rtnl, req, 0, ret);
+                if (!IN_SET(r, -EOPNOTSUPP, -EINVAL)) {
+                        if (r < 0)
+                                return log_warning_errno(r, "Failed to call RTM_GETSTATS: %m");
+                        return 0;
+                }
+
+                log_debug_errno(r, "RTM_GETSTATS is not supported by the kernel, using RTM_GETLINK for the speed meter: %m");
+                manager->speed_meter_use_getlink = true;
+                req = sd_netlink_message_unref(req);
+        }
+
+        r = sd_rtnl_message_new_link(manager->rtnl, &req, RTM_GETLINK, 0);
+        if (r < 0)
+                return log_warning_errno(r, "Failed to allocate RTM_GETLINK netlink message: %m");
+
+        r = sd_netlink_message_request_dump(req, true);
+        if (r < 0)
+                return log_warning_errno(r, "Failed to set dump flag: %m");
+
+        r = sd_netlink_call(manager->rtnl, req, 0, ret);
+        if (r < 0)
+                return log_warning_errno(r, "Failed to call RTM_GETLINK: %m");
+
+        return 0;
+}
+
 static int speed_meter_handler(sd_event_source *s, uint64_t usec, void *userdata) {
-        _cleanup_(sd_netlink_message_unrefp) sd_netlink_message *req = NULL, *reply = NULL;
+        _cleanup_(sd_netlink_message_unrefp) sd_netlink_message *reply = NULL;
         Manager *manager = userdata;
         usec_t usec_now;
         Link *link;
@@ -65,23 +114,8 @@ static int speed_meter_handler(sd_event_source *s, uint64_t usec, void *userdata
         HASHMAP_FOREACH(link, manager->links)
                 link->stats_updated = false;
 
-        r = sd_rtnl_message_new_link(manager->rtnl, &req, RTM_GETLINK, 0);
-        if (r < 0) {
-                log_warning_errno(r, "Failed to allocate RTM_GETLINK netlink message, ignoring: %m");
+        if (speed_meter_dump(manager, &reply) < 0)
                 return 0;
-        }
-
-        r = sd_netlink_message_request_dump(req, true);
-        if (r < 0) {
-                log_warning_errno(r, "Failed to set dump flag, ignoring: %m");
-                return 0;
-        }
-
-        r = sd_netlink_call(manager->rtnl, req, 0, &reply);
-        if (r < 0) {
-                log_warning_errno(r, "Failed to call RTM_GETLINK, ignoring: %m");
-                return 0;
-        }
 
         for (sd_netlink_message *i = reply; i; i = sd_netlink_message_next(i))
                 (void) process_message(manager, i);
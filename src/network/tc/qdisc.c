@@ -160,6 +160,7 @@ static int qdisc_handler(sd_netlink *rtnl, sd_netlink_message *m, Link *link) {
         r = sd_netlink_message_get_errno(m);
         if (r < 0 && r != -EEXIST) {
                 log_link_message_error_errno(link, m, r, "Could not set QDisc");
+                link_traffic_control_forget_applied(link);
                 link_enter_failed(link);
                 return 1;
         }
@@ -218,9 +219,19 @@ int qdisc_configure(Link *link, QDisc *qdisc) {
                         return log_link_error_errno(link, r, "Could not append TCA_KIND attribute: %m");
         }
 
-        r = netlink_call_async(link->manager->rtnl, NULL, req, qdisc_handler, link_netlink_destroy_callback, link);
+        r = link_traffic_control_check_applied(link, req);
         if (r < 0)
+                return log_link_error_errno(link, r, "Could not remember QDisc request: %m");
+        if (r == 0) {
+                log_link_debug(link, "QDisc is unchanged, not configuring it again.");
+                return 0;
+        }
+
+        r = netlink_call_async(link->manager->rtnl, NULL, req, qdisc_handler, link_netlink_destroy_callback, link);
+        if (r < 0) {
+                link_traffic_control_forget_applied(link);
                 return log_link_error_errno(link, r, "Could not send rtnetlink message: %m");
+        }
 
         link_ref(link);
         link->tc_messages++;
@@ -1,10 +1,19 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
+#include "alloc-util.h"
+#include "hash-funcs.h"
 #include "macro.h"
+#include "netlink-util.h"
 #include "qdisc.h"
+#include "set.h"
+#include "siphash24.h"
 #include "tc.h"
 #include "tclass.h"
 
+#define TC_HASH_KEY SD_ID128_MAKE(61,1e,b3,4f,0c,95,4b,d2,a0,8d,5c,37,e2,49,1f,c8)
+
+DEFINE_PRIVATE_HASH_OPS_WITH_KEY_DESTRUCTOR(tc_hash_ops, uint64_t, uint64_hash_func, uint64_compare_func, free);
+
 void traffic_control_free(TrafficControl *tc) {
         if (!tc)
                 return;
@@ -35,6 +44,45 @@ static int traffic_control_configure(Link *link, TrafficControl *tc) {
         }
 }
 
+int link_traffic_control_check_applied(Link *link, sd_netlink_message *req) {
+        _cleanup_free_ uint64_t *h = NULL;
+        const void *payload;
+        size_t size;
+        int r;
+
+        assert(link);
+        assert(req);
+
+        /* Qdiscs and classes are created with NLM_F_EXCL, so sending an identical request again on
+         * reconfiguration only results in -EEXIST. Remember what was sent, and return 0 if the request
+         * is identical to one sent earlier and does not need to be sent again, 1 otherwise. */
+
+        r = netlink_message_get_payload(req, &payload, &size);
+        if (r < 0)
+                return r;
+
+        h = new(uint64_t, 1);
+        if (!h)
+                return -ENOMEM;
+
+        *h = siphash24(payload, size, TC_HASH_KEY.bytes);
+
+        if (set_contains(link->tc_applied, h))
+                return 0;
+
+        r = set_ensure_consume(&link->tc_applied, &tc_hash_ops, TAKE_PTR(h));
+        if (r < 0)
+                return r;
+
+        return 1;
+}
+
+void link_traffic_control_forget_applied(Link *link) {
+        assert(link);
+
+        link->tc_applied = set_free(link->tc_applied);
+}
+
 int link_configure_traffic_control(Link *link) {
         TrafficControl *tc;
         int r;
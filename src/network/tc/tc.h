@@ -29,4 +29,6 @@ typedef struct TrafficControl {
 
 void traffic_control_free(TrafficControl *tc);
 int link_configure_traffic_control(Link *link);
+int link_traffic_control_check_applied(Link *link, sd_netlink_message *req);
+void link_traffic_control_forget_applied(Link *link);
 void network_drop_invalid_traffic_control(Network *network);
@@ -115,6 +115,7 @@ static int tclass_handler(sd_netlink *rtnl, sd_netlink_message *m, Link *link) {
         r = sd_netlink_message_get_errno(m);
         if (r < 0 && r != -EEXIST) {
                 log_link_message_error_errno(link, m, r, "Could not set TClass");
+                link_traffic_control_forget_applied(link);
                 link_enter_failed(link);
                 return 1;
         }
@@ -161,9 +162,19 @@ int tclass_configure(Link *link, TClass *tclass) {
                         return r;
         }
 
-        r = netlink_call_async(link->manager->rtnl, NULL, req, tclass_handler, link_netlink_destroy_callback, link);
+        r = link_traffic_control_check_applied(link, req);
         if (r < 0)
+                return log_link_error_errno(link, r, "Could not remember TClass request: %m");
+        if (r == 0) {
+                log_link_debug(link, "TClass is unchanged, not configuring it again.");
+                return 0;
+        }
+
+        r = netlink_call_async(link->manager->rtnl, NULL, req, tclass_handler, link_netlink_destroy_callback, link);
+        if (r < 0) {
+                link_traffic_control_forget_applied(link);
                 return log_link_error_errno(link, r, "Could not send rtnetlink message: %m");
+        }
 
         link_ref(link);
         link->tc_messages++;
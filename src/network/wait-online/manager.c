@@ -8,6 +8,7 @@
 #include "link.h"
 #include "manager.h"
 #include "netlink-util.h"
+#include "set.h"
 #include "strv.h"
 #include "time-util.h"
 #include "util.h"
@@ -251,18 +252,35 @@ static int manager_rtnl_listen(Manager *m) {
 }
 
 static int on_network_event(sd_event_source *s, int fd, uint32_t revents, void *userdata) {
+        _cleanup_set_free_ Set *changed = NULL;
         Manager *m = userdata;
+        void *p;
         Link *l;
         int r;
 
         assert(m);
 
-        sd_network_monitor_flush(m->network_monitor);
+        /* Only re-read the state files of the links that changed, if we can tell which these are. */
+        r = network_monitor_flush_links(m->network_monitor, &changed);
+        if (r < 0)
+                log_warning_errno(r, "Failed to process network monitor events, ignoring: %m");
 
-        HASHMAP_FOREACH(l, m->links) {
-                r = link_update_monitor(l);
-                if (r < 0 && r != -ENODATA)
-                        log_link_warning_errno(l, r, "Failed to update link state, ignoring: %m");
+        if (r != 0) {
+                HASHMAP_FOREACH(l, m->links) {
+                        r = link_update_monitor(l);
+                        if (r < 0 && r != -ENODATA)
+                                log_link_warning_errno(l, r, "Failed to update link state, ignoring: %m");
+                }
+        } else {
+                SET_FOREACH(p, changed) {
+                        l = hashmap_get(m->links, p);
+                        if (!l)
+                                continue;
+
+                        r = link_update_monitor(l);
+                        if (r < 0 && r != -ENODATA)
+                                log_link_warning_errno(l, r, "Failed to update link state, ignoring: %m");
+                }
         }
 
         if (manager_configured(m))
@@ -2776,6 +2776,42 @@ static int setup_machine_id(const char *directory) {
         return 0;
 }
 
+static int idmap_root(const char *directory, DissectedImage *dissected_image) {
+        struct stat st;
+        int r;
+
+        assert(directory);
+
+        /* If the tree still has to be shifted, try to map its UIDs/GIDs with an ID mapped mount instead of
+         * chown()ing every single inode. Returns > 0 if that worked, 0 if recursive_chown() needs to do its
+         * job. */
+
+        if (arg_userns_mode == USER_NAMESPACE_NO || !arg_userns_chown || arg_uid_shift == 0)
+                return 0;
+
+        /* Only the root mount is mapped, but images might bring further partitions */
+        if (dissected_image)
+                return 0;
+
+        if (stat(directory, &st) < 0)
+                return log_error_errno(errno, "Failed to stat %s: %m", directory);
+
+        /* The mapping is from the unshifted range, hence only use it if the tree isn't shifted yet */
+        if (st.st_uid != 0 || st.st_gid != 0)
+                return 0;
+
+        r = remount_idmap(directory, arg_uid_shift, arg_uid_range, REMOUNT_IDMAP_HOST_ROOT);
+        if (r < 0) {
+                /* Kernel or file system might not support ID mapped mounts, and we can't really tell this
+                 * apart from other errors. Hence, fall back in any case. */
+                log_debug_errno(r, "Failed to set up ID mapped mount for %s, reverting to recursive chown()ing: %m", directory);
+                return 0;
+        }
+
+        log_debug("Mapped UIDs/GIDs of %s with an ID mapped mount, skipping recursive chown operation.", directory);
+        return 1;
+}
+
 static int recursive_chown(const char *directory, uid_t shift, uid_t range) {
         int r;
 
@@ -3538,6 +3574,7 @@ static int outer_child(
 
         _cleanup_strv_free_ char **os_release_pairs = NULL;
         _cleanup_close_ int fd = -1;
+        bool idmapped;
         const char *p;
         pid_t pid;
         ssize_t l;
@@ -3705,6 +3742,11 @@ static int outer_child(
                 unified_cgroup_hierarchy_socket = safe_close(unified_cgroup_hierarchy_socket);
         }
 
+        r = idmap_root(directory, dissected_image);
+        if (r < 0)
+                return r;
+        idmapped = r > 0;
+
         /* Mark everything as shared so our mounts get propagated down. This is
          * required to make new bind mounts available in systemd services
          * inside the container that create a new mount namespace.
@@ -3720,9 +3762,11 @@ static int outer_child(
         if (r < 0)
                 return r;
 
-        r = recursive_chown(directory, arg_uid_shift, arg_uid_range);
-        if (r < 0)
-                return r;
+        if (!idmapped) {
+                r = recursive_chown(directory, arg_uid_shift, arg_uid_range);
+                if (r < 0)
+                        return r;
+        }
 
         r = base_filesystem_create(directory, arg_uid_shift, (gid_t) arg_uid_shift);
         if (r < 0)
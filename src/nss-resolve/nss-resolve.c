@@ -62,6 +62,10 @@ static int connect_to_resolved(Varlink **ret) {
         if (r < 0)
                 return r;
 
+        r = varlink_negotiate_binary(link);
+        if (r < 0)
+                return r;
+
         *ret = TAKE_PTR(link);
         return 0;
 }
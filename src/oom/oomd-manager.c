@@ -312,7 +312,8 @@ static int monitor_swap_contexts_handler(sd_event_source *s, uint64_t usec, void
         if (r < 0)
                 return log_error_errno(r, "Failed to reset event timer: %m");
 
-        r = sd_event_source_set_time_relative(s, SWAP_INTERVAL_USEC);
+        r = sd_event_source_set_time_relative(s, hashmap_isempty(m->monitored_swap_cgroup_contexts) ?
+                                              SWAP_IDLE_INTERVAL_USEC : SWAP_INTERVAL_USEC);
         if (r < 0)
                 return log_error_errno(r, "Failed to set relative time for timer: %m");
 
@@ -359,6 +360,7 @@ static int monitor_swap_contexts_handler(sd_event_source *s, uint64_t usec, void
 
                 threshold = m->system_context.swap_total * THRESHOLD_SWAP_USED_PERCENT / 100;
                 r = oomd_kill_by_swap_usage(candidates, threshold, m->dry_run, &selected);
+                m->swap_decision_latency_usec = usec_sub_unsigned(now(CLOCK_MONOTONIC), usec_now);
                 if (r == -ENOMEM)
                         return log_oom();
                 if (r < 0)
@@ -376,6 +378,24 @@ static int monitor_swap_contexts_handler(sd_event_source *s, uint64_t usec, void
         return 0;
 }
 
+static usec_t mem_pressure_interval(Manager *m) {
+        OomdCGroupContext *c;
+
+        assert(m);
+
+        /* Poll faster only while it matters: when a monitored cgroup is above its limit, or right after
+         * we acted on one. */
+
+        if (m->mem_pressure_post_action_delay_start > 0)
+                return MEM_PRESSURE_INTERVAL_USEC;
+
+        HASHMAP_FOREACH(c, m->monitored_mem_pressure_cgroup_contexts)
+                if (c->mem_pressure_limit_hit_start > 0)
+                        return MEM_PRESSURE_INTERVAL_USEC;
+
+        return MEM_PRESSURE_IDLE_INTERVAL_USEC;
+}
+
 static void clear_candidate_hashmapp(Manager **m) {
         if (*m)
                 hashmap_clear((*m)->monitored_mem_pressure_cgroup_contexts_candidates);
@@ -399,7 +419,7 @@ static int monitor_memory_pressure_contexts_handler(sd_event_source *s, uint64_t
         if (r < 0)
                 return log_error_errno(r, "Failed to reset event timer: %m");
 
-        r = sd_event_source_set_time_relative(s, MEM_PRESSURE_INTERVAL_USEC);
+        r = sd_event_source_set_time_relative(s, mem_pressure_interval(m));
         if (r < 0)
                 return log_error_errno(r, "Failed to set relative time for timer: %m");
 
@@ -474,6 +494,7 @@ static int monitor_memory_pressure_contexts_handler(sd_event_source *s, uint64_t
                                 clear_candidates = NULL;
 
                         r = oomd_kill_by_pgscan_rate(m->monitored_mem_pressure_cgroup_contexts_candidates, t->path, m->dry_run, &selected);
+                        m->mem_pressure_decision_latency_usec = usec_sub_unsigned(now(CLOCK_MONOTONIC), usec_now);
                         if (r == -ENOMEM)
                                 return log_oom();
                         if (r < 0)
@@ -711,7 +732,7 @@ int manager_start(
 int manager_get_dump_string(Manager *m, char **ret) {
         _cleanup_free_ char *dump = NULL;
         _cleanup_fclose_ FILE *f = NULL;
-        char buf[FORMAT_TIMESPAN_MAX];
+        char buf[FORMAT_TIMESPAN_MAX], buf2[FORMAT_TIMESPAN_MAX], buf3[FORMAT_TIMESPAN_MAX];
         OomdCGroupContext *c;
         size_t size;
         char *key;
@@ -729,11 +750,17 @@ int manager_get_dump_string(Manager *m, char **ret) {
                 "Swap Used Limit: " PERMYRIAD_AS_PERCENT_FORMAT_STR "\n"
                 "Default Memory Pressure Limit: %lu.%02lu%%\n"
                 "Default Memory Pressure Duration: %s\n"
+                "Last Swap Decision Latency: %s\n"
+                "Last Memory Pressure Decision Latency: %s\n"
                 "System Context:\n",
                 yes_no(m->dry_run),
                 PERMYRIAD_AS_PERCENT_FORMAT_VAL(m->swap_used_limit_permyriad),
                 LOAD_INT(m->default_mem_pressure_limit), LOAD_FRAC(m->default_mem_pressure_limit),
-                format_timespan(buf, sizeof(buf), m->default_mem_pressure_duration_usec, USEC_PER_SEC));
+                format_timespan(buf, sizeof(buf), m->default_mem_pressure_duration_usec, USEC_PER_SEC),
+                m->swap_decision_latency_usec > 0 ?
+                        format_timespan(buf2, sizeof(buf2), m->swap_decision_latency_usec, 1) : "n/a",
+                m->mem_pressure_decision_latency_usec > 0 ?
+                        format_timespan(buf3, sizeof(buf3), m->mem_pressure_decision_latency_usec, 1) : "n/a");
         oomd_dump_system_context(&m->system_context, f, "\t");
 
         fprintf(f, "Swap Monitored CGroups:\n");
@@ -8,8 +8,12 @@
 
 /* Polling interval for monitoring stats */
 #define SWAP_INTERVAL_USEC 150000 /* 0.15 seconds */
+/* Swap is still polled for oomctl if no unit requests swap monitoring, but there is no hurry then */
+#define SWAP_IDLE_INTERVAL_USEC (1 * USEC_PER_SEC)
 /* Pressure counters are lagging (~2 seconds) compared to swap so polling too frequently just wastes CPU */
 #define MEM_PRESSURE_INTERVAL_USEC (1 * USEC_PER_SEC)
+/* The kernel updates the pressure averages every 2 seconds, poll at that rate while no cgroup is above its limit */
+#define MEM_PRESSURE_IDLE_INTERVAL_USEC (2 * USEC_PER_SEC)
 
 /* Take action if 10s of memory pressure > 60 for more than 30s. We use the "full" value from PSI so this is the
  * percentage of time all tasks were delayed (i.e. unproductive).
@@ -48,6 +52,10 @@ struct Manager {
 
         usec_t mem_pressure_post_action_delay_start;
 
+        /* How long it took from waking up until the last kill decision was made */
+        usec_t swap_decision_latency_usec;
+        usec_t mem_pressure_decision_latency_usec;
+
         sd_event_source *swap_context_event_source;
         sd_event_source *mem_pressure_context_event_source;
 
@@ -131,13 +131,12 @@ bool oomd_swap_free_below(const OomdSystemContext *ctx, int threshold_permyriad)
         return (ctx->swap_total - ctx->swap_used) < swap_threshold;
 }
 
-int oomd_sort_cgroup_contexts(Hashmap *h, oomd_compare_t compare_func, const char *prefix, OomdCGroupContext ***ret) {
+static int oomd_collect_cgroup_contexts(Hashmap *h, const char *prefix, OomdCGroupContext ***ret) {
         _cleanup_free_ OomdCGroupContext **sorted = NULL;
         OomdCGroupContext *item;
         size_t k = 0;
 
         assert(h);
-        assert(compare_func);
         assert(ret);
 
         sorted = new0(OomdCGroupContext*, hashmap_size(h));
@@ -152,14 +151,44 @@ int oomd_sort_cgroup_contexts(Hashmap *h, oomd_compare_t compare_func, const cha
                 sorted[k++] = item;
         }
 
-        typesafe_qsort(sorted, k, compare_func);
-
         *ret = TAKE_PTR(sorted);
 
         assert(k <= INT_MAX);
         return (int) k;
 }
 
+int oomd_sort_cgroup_contexts(Hashmap *h, oomd_compare_t compare_func, const char *prefix, OomdCGroupContext ***ret) {
+        _cleanup_free_ OomdCGroupContext **sorted = NULL;
+        int n;
+
+        assert(h);
+        assert(compare_func);
+        assert(ret);
+
+        n = oomd_collect_cgroup_contexts(h, prefix, &sorted);
+        if (n < 0)
+                return n;
+
+        typesafe_qsort(sorted, n, compare_func);
+
+        *ret = TAKE_PTR(sorted);
+        return n;
+}
+
+static void oomd_move_first_to_front(OomdCGroupContext **array, int n, oomd_compare_t compare_func) {
+        int best = 0;
+
+        assert(array || n == 0);
+        assert(compare_func);
+
+        for (int i = 1; i < n; i++)
+                if (compare_func(array + i, array + best) < 0)
+                        best = i;
+
+        if (best > 0)
+                SWAP_TWO(array[0], array[best]);
+}
+
 int oomd_cgroup_kill(const char *path, bool recurse, bool dry_run) {
         _cleanup_set_free_ Set *pids_killed = NULL;
         int r;
@@ -202,11 +231,20 @@ int oomd_kill_by_pgscan_rate(Hashmap *h, const char *prefix, bool dry_run, char
         assert(h);
         assert(ret_selected);
 
-        n = oomd_sort_cgroup_contexts(h, compare_pgscan_rate_and_memory_usage, prefix, &sorted);
+        /* Usually the first candidate is the one that gets killed. Hence only look for that one first,
+         * and sort the others only if we actually need to go on. */
+        n = oomd_collect_cgroup_contexts(h, prefix, &sorted);
         if (n < 0)
                 return n;
 
+        oomd_move_first_to_front(sorted, n, compare_pgscan_rate_and_memory_usage);
+
         for (int i = 0; i < n; i++) {
+                if (i == 1) {
+                        OomdCGroupContext **rest = sorted + 1;
+                        typesafe_qsort(rest, n - 1, compare_pgscan_rate_and_memory_usage);
+                }
+
                 /* Skip cgroups with no reclaim and memory usage; it won't alleviate pressure.
                  * Continue since there might be "avoid" cgroups at the end. */
                 if (sorted[i]->pgscan == 0 && sorted[i]->current_memory_usage == 0)
@@ -240,13 +278,22 @@ int oomd_kill_by_swap_usage(Hashmap *h, uint64_t threshold_usage, bool dry_run,
         assert(h);
         assert(ret_selected);
 
-        n = oomd_sort_cgroup_contexts(h, compare_swap_usage, NULL, &sorted);
+        /* Usually the first candidate is the one that gets killed. Hence only look for that one first,
+         * and sort the others only if we actually need to go on. */
+        n = oomd_collect_cgroup_contexts(h, NULL, &sorted);
         if (n < 0)
                 return n;
 
+        oomd_move_first_to_front(sorted, n, compare_swap_usage);
+
         /* Try to kill cgroups with non-zero swap usage until we either succeed in killing or we get to a cgroup with
          * no swap usage. Threshold killing only cgroups with more than threshold swap usage. */
         for (int i = 0; i < n; i++) {
+                if (i == 1) {
+                        OomdCGroupContext **rest = sorted + 1;
+                        typesafe_qsort(rest, n - 1, compare_swap_usage);
+                }
+
                 /* Skip over cgroups with not enough swap usage. Don't break since there might be "avoid"
                  * cgroups at the end. */
                 if (sorted[i]->swap_usage <= threshold_usage)
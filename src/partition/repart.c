@@ -2561,6 +2561,7 @@ static int deactivate_luks(struct crypt_device *cd, const char *node) {
 }
 
 static int context_copy_blocks(Context *context) {
+        bool need_sync = false;
         Partition *p;
         int whole_fd = -1, r;
 
@@ -2622,10 +2623,10 @@ static int context_copy_blocks(Context *context) {
                 if (r < 0)
                         return log_error_errno(r, "Failed to copy in data from '%s': %m", p->copy_blocks_path);
 
-                if (fsync(target_fd) < 0)
-                        return log_error_errno(r, "Failed to synchronize copied data blocks: %m");
-
                 if (p->encrypt != ENCRYPT_OFF) {
+                        if (fsync(target_fd) < 0)
+                                return log_error_errno(errno, "Failed to synchronize copied data blocks: %m");
+
                         encrypted_dev_fd = safe_close(encrypted_dev_fd);
 
                         r = deactivate_luks(cd, encrypted);
@@ -2638,11 +2639,17 @@ static int context_copy_blocks(Context *context) {
                         r = loop_device_sync(d);
                         if (r < 0)
                                 return log_error_errno(r, "Failed to sync loopback device: %m");
-                }
+                } else
+                        /* Data written directly to the whole device is synchronized once for all
+                         * partitions below, rather than flushing the device after each of them. */
+                        need_sync = true;
 
                 log_info("Copying in of '%s' on block level completed.", p->copy_blocks_path);
         }
 
+        if (need_sync && fsync(whole_fd) < 0)
+                return log_error_errno(errno, "Failed to synchronize copied data blocks: %m");
+
         return 0;
 }
 
@@ -2865,7 +2872,7 @@ static int context_mkfs(Context *context) {
 
                 if (p->encrypt != ENCRYPT_OFF) {
                         if (fsync(encrypted_dev_fd) < 0)
-                                return log_error_errno(r, "Failed to synchronize LUKS volume: %m");
+                                return log_error_errno(errno, "Failed to synchronize LUKS volume: %m");
                         encrypted_dev_fd = safe_close(encrypted_dev_fd);
 
                         r = deactivate_luks(cd, encrypted);
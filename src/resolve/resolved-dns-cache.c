@@ -11,10 +11,6 @@
 #include "resolved-dns-packet.h"
 #include "string-util.h"
 
-/* Never cache more than 4K entries. RFC 1536, Section 5 suggests to
- * leave DNS caches unbounded, but that's crazy. */
-#define CACHE_MAX 4096
-
 /* We never keep any item longer than 2h in our cache */
 #define CACHE_TTL_MAX_USEC (2 * USEC_PER_HOUR)
 
@@ -24,6 +20,11 @@
 
 #define CACHEABLE_QUERY_FLAGS (SD_RESOLVED_AUTHENTICATED|SD_RESOLVED_CONFIDENTIAL)
 
+/* Positive entries that are hit during the last tenth of their lifetime are refreshed in the background, but
+ * only if they are cached long enough for that to make sense */
+#define CACHE_PREFETCH_FRACTION 10
+#define CACHE_PREFETCH_MIN_USEC (10 * USEC_PER_SEC)
+
 typedef enum DnsCacheItemType DnsCacheItemType;
 typedef struct DnsCacheItem DnsCacheItem;
 
@@ -42,6 +43,7 @@ struct DnsCacheItem {
         DnsAnswer *answer;       /* The full validated answer, if this is an RRset acquired via a "primary" lookup */
         DnsPacket *full_packet;  /* The full packet this information was acquired with */
 
+        usec_t created;          /* When the item was added or last updated, only set for positive items */
         usec_t until;
         uint64_t query_flags;    /* SD_RESOLVED_AUTHENTICATED and/or SD_RESOLVED_CONFIDENTIAL */
         DnssecResult dnssec_result;
@@ -52,8 +54,10 @@ struct DnsCacheItem {
 
         unsigned prioq_idx;
         LIST_FIELDS(DnsCacheItem, by_key);
+        LIST_FIELDS(DnsCacheItem, by_use);
 
         bool shared_owner;
+        bool prefetch;           /* A background refresh was requested already */
 };
 
 /* Returns true if this is a cache item created as result of an explicit lookup, or created as "side-effect"
@@ -95,6 +99,47 @@ static DnsCacheItem* dns_cache_item_free(DnsCacheItem *i) {
 }
 DEFINE_TRIVIAL_CLEANUP_FUNC(DnsCacheItem*, dns_cache_item_free);
 
+static void dns_cache_item_unlink_use(DnsCache *c, DnsCacheItem *i) {
+        assert(c);
+        assert(i);
+
+        if (c->by_use_tail == i)
+                c->by_use_tail = i->by_use_prev;
+        LIST_REMOVE(by_use, c->by_use, i);
+}
+
+static void dns_cache_item_link_use(DnsCache *c, DnsCacheItem *i) {
+        assert(c);
+        assert(i);
+
+        LIST_PREPEND(by_use, c->by_use, i);
+        if (!c->by_use_tail)
+                c->by_use_tail = i;
+}
+
+static void dns_cache_item_touch(DnsCache *c, DnsCacheItem *i) {
+        assert(c);
+        assert(i);
+
+        /* Move the item to the front of the use list, so that it is evicted last */
+        if (c->by_use == i)
+                return;
+
+        dns_cache_item_unlink_use(c, i);
+        dns_cache_item_link_use(c, i);
+}
+
+static void dns_cache_hit(DnsCache *c, DnsCacheItem *first) {
+        DnsCacheItem *j;
+
+        assert(c);
+
+        LIST_FOREACH(by_key, j, first)
+                dns_cache_item_touch(c, j);
+
+        c->n_hit++;
+}
+
 static void dns_cache_item_unlink_and_free(DnsCache *c, DnsCacheItem *i) {
         DnsCacheItem *first;
 
@@ -103,6 +148,8 @@ static void dns_cache_item_unlink_and_free(DnsCache *c, DnsCacheItem *i) {
         if (!i)
                 return;
 
+        dns_cache_item_unlink_use(c, i);
+
         first = hashmap_get(c->by_key, i->key);
         LIST_REMOVE(by_key, first, i);
 
@@ -146,6 +193,7 @@ static bool dns_cache_remove_by_key(DnsCache *c, DnsResourceKey *key) {
 
         LIST_FOREACH_SAFE(by_key, i, n, first) {
                 prioq_remove(c->by_expiry, i, &i->prioq_idx);
+                dns_cache_item_unlink_use(c, i);
                 dns_cache_item_free(i);
         }
 
@@ -162,22 +210,34 @@ void dns_cache_flush(DnsCache *c) {
 
         assert(hashmap_size(c->by_key) == 0);
         assert(prioq_size(c->by_expiry) == 0);
+        assert(!c->by_use && !c->by_use_tail);
 
         c->by_key = hashmap_free(c->by_key);
         c->by_expiry = prioq_free(c->by_expiry);
 }
 
+static unsigned dns_cache_max_entries(DnsCache *c) {
+        assert(c);
+
+        return c->max_entries > 0 ? c->max_entries : DNS_CACHE_MAX_ENTRIES_DEFAULT;
+}
+
 static void dns_cache_make_space(DnsCache *c, unsigned add) {
+        unsigned max;
+        usec_t t = 0;
+
         assert(c);
 
         if (add <= 0)
                 return;
 
         /* Makes space for n new entries. Note that we actually allow
-         * the cache to grow beyond CACHE_MAX, but only when we shall
-         * add more RRs to the cache than CACHE_MAX at once. In that
+         * the cache to grow beyond the limit, but only when we shall
+         * add more RRs to the cache than the limit at once. In that
          * case the cache will be emptied completely otherwise. */
 
+        max = dns_cache_max_entries(c);
+
         for (;;) {
                 _cleanup_(dns_resource_key_unrefp) DnsResourceKey *key = NULL;
                 DnsCacheItem *i;
@@ -185,12 +245,25 @@ static void dns_cache_make_space(DnsCache *c, unsigned add) {
                 if (prioq_size(c->by_expiry) <= 0)
                         break;
 
-                if (prioq_size(c->by_expiry) + add < CACHE_MAX)
+                if (prioq_size(c->by_expiry) + add < max)
                         break;
 
+                /* Drop entries that are past their TTL first. If there are none, drop the least recently
+                 * used entry instead of the one expiring next, so that popular entries survive in a cache
+                 * that is too small for the working set. */
                 i = prioq_peek(c->by_expiry);
                 assert(i);
 
+                if (t <= 0)
+                        t = now(clock_boottime_or_monotonic());
+
+                if (i->until > t) {
+                        i = c->by_use_tail;
+                        assert(i);
+                }
+
+                c->n_evicted++;
+
                 /* Take an extra reference to the key so that it
                  * doesn't go away in the middle of the remove call */
                 key = dns_resource_key_ref(i->key);
@@ -239,10 +312,10 @@ void dns_cache_prune(DnsCache *c) {
         }
 }
 
-static int dns_cache_item_prioq_compare_func(const void *a, const void *b) {
-        const DnsCacheItem *x = a, *y = b;
+static uint64_t dns_cache_item_prioq_key_func(const void *p) {
+        const DnsCacheItem *i = p;
 
-        return CMP(x->until, y->until);
+        return i->until;
 }
 
 static int dns_cache_init(DnsCache *c) {
@@ -250,7 +323,7 @@ static int dns_cache_init(DnsCache *c) {
 
         assert(c);
 
-        r = prioq_ensure_allocated(&c->by_expiry, dns_cache_item_prioq_compare_func);
+        r = prioq_ensure_allocated_keyed(&c->by_expiry, dns_cache_item_prioq_key_func, NULL);
         if (r < 0)
                 return r;
 
@@ -272,6 +345,8 @@ static int dns_cache_link_item(DnsCache *c, DnsCacheItem *i) {
         if (r < 0)
                 return r;
 
+        dns_cache_item_link_use(c, i);
+
         first = hashmap_get(c->by_key, i->key);
         if (first) {
                 _cleanup_(dns_resource_key_unrefp) DnsResourceKey *k = NULL;
@@ -293,6 +368,7 @@ static int dns_cache_link_item(DnsCache *c, DnsCacheItem *i) {
                 r = hashmap_put(c->by_key, i->key, i);
                 if (r < 0) {
                         prioq_remove(c->by_expiry, i, &i->prioq_idx);
+                        dns_cache_item_unlink_use(c, i);
                         return r;
                 }
         }
@@ -395,7 +471,9 @@ static void dns_cache_item_update_positive(
         dns_packet_unref(i->full_packet);
         i->full_packet = full_packet;
 
+        i->created = timestamp;
         i->until = calculate_until(rr, min_ttl, UINT32_MAX, timestamp, false);
+        i->prefetch = false;
         i->query_flags = query_flags & CACHEABLE_QUERY_FLAGS;
         i->shared_owner = shared_owner;
         i->dnssec_result = dnssec_result;
@@ -406,6 +484,7 @@ static void dns_cache_item_update_positive(
         i->owner_address = *owner_address;
 
         prioq_reshuffle(c->by_expiry, i, &i->prioq_idx);
+        dns_cache_item_touch(c, i);
 }
 
 static int dns_cache_put_positive(
@@ -488,6 +567,7 @@ static int dns_cache_put_positive(
                 .rr = dns_resource_record_ref(rr),
                 .answer = dns_answer_ref(answer),
                 .full_packet = dns_packet_ref(full_packet),
+                .created = timestamp,
                 .until = calculate_until(rr, min_ttl, UINT32_MAX, timestamp, false),
                 .query_flags = query_flags & CACHEABLE_QUERY_FLAGS,
                 .shared_owner = shared_owner,
@@ -1130,7 +1210,7 @@ int dns_cache_lookup(
                 if (ret_dnssec_result)
                         *ret_dnssec_result = dnssec_result;
 
-                c->n_hit++;
+                dns_cache_hit(c, first);
                 return 1;
         }
 
@@ -1158,7 +1238,7 @@ int dns_cache_lookup(
                 if (!bitmap_isset(nsec->rr->nsec.types, key->type) &&
                     !bitmap_isset(nsec->rr->nsec.types, DNS_TYPE_CNAME) &&
                     !bitmap_isset(nsec->rr->nsec.types, DNS_TYPE_DNAME)) {
-                        c->n_hit++;
+                        dns_cache_hit(c, first);
                         return 1;
                 }
 
@@ -1172,7 +1252,7 @@ int dns_cache_lookup(
                   dns_resource_key_to_string(key, key_str, sizeof key_str));
 
         if (n <= 0) {
-                c->n_hit++;
+                dns_cache_hit(c, first);
 
                 if (ret_rcode)
                         *ret_rcode = nxdomain ? DNS_RCODE_NXDOMAIN : DNS_RCODE_SUCCESS;
@@ -1190,7 +1270,7 @@ int dns_cache_lookup(
                 return 1;
         }
 
-        c->n_hit++;
+        dns_cache_hit(c, first);
 
         if (ret_rcode)
                 *ret_rcode = DNS_RCODE_SUCCESS;
@@ -1223,6 +1303,46 @@ miss:
         return 0;
 }
 
+bool dns_cache_should_prefetch(DnsCache *c, DnsResourceKey *key) {
+        DnsCacheItem *first, *i;
+        bool found = false;
+        usec_t t;
+
+        assert(c);
+        assert(key);
+
+        /* Returns true if the positive entries for the key are about to expire and should be refreshed in the
+         * background. This returns true only once for each set of entries, until the refresh replaces them. */
+
+        first = dns_cache_get_by_key_follow_cname_dname_nsec(c, key);
+        if (!first)
+                return false;
+
+        t = now(clock_boottime_or_monotonic());
+
+        LIST_FOREACH(by_key, i, first) {
+                usec_t lifetime;
+
+                if (i->type != DNS_CACHE_POSITIVE || i->shared_owner || i->prefetch)
+                        return false;
+
+                lifetime = usec_sub_unsigned(i->until, i->created);
+                if (lifetime < CACHE_PREFETCH_MIN_USEC)
+                        continue;
+
+                if (usec_sub_unsigned(i->until, t) <= lifetime / CACHE_PREFETCH_FRACTION)
+                        found = true;
+        }
+
+        if (!found)
+                return false;
+
+        LIST_FOREACH(by_key, i, first)
+                i->prefetch = true;
+
+        return true;
+}
+
 int dns_cache_check_conflicts(DnsCache *cache, DnsResourceRecord *rr, int owner_family, const union in_addr_union *owner_address) {
         DnsCacheItem *i, *first;
         bool same_owner = true;
@@ -1316,6 +1436,10 @@ void dns_cache_dump(DnsCache *cache, FILE *f) {
         if (!f)
                 f = stdout;
 
+        fprintf(f, "\tsize=%u max=%u hits=%u misses=%u evicted=%u\n",
+                dns_cache_size(cache), dns_cache_max_entries(cache),
+                cache->n_hit, cache->n_miss, cache->n_evicted);
+
         HASHMAP_FOREACH(i, cache->by_key) {
                 DnsCacheItem *j;
 
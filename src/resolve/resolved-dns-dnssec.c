@@ -9,6 +9,7 @@
 #include "memory-util.h"
 #include "resolved-dns-dnssec.h"
 #include "resolved-dns-packet.h"
+#include "siphash24.h"
 #include "sort-util.h"
 #include "string-table.h"
 
@@ -21,6 +22,10 @@
 /* Maximum number of NSEC3 iterations we'll do. RFC5155 says 2500 shall be the maximum useful value */
 #define NSEC3_ITERATIONS_MAX 2500
 
+/* Size of the SHA256 digests we identify signature checks by, and how many of their outcomes we remember */
+#define DNSSEC_VERIFY_DIGEST_SIZE 32
+#define DNSSEC_VERIFY_CACHE_MAX 4096
+
 /*
  * The DNSSEC Chain of trust:
  *
@@ -627,26 +632,211 @@ static void dnssec_fix_rrset_ttl(
         rrsig->expiry = rrsig->rrsig.expiration * USEC_PER_SEC;
 }
 
-int dnssec_verify_rrset(
+struct DnssecVerifyCacheEntry {
+        uint8_t digest[DNSSEC_VERIFY_DIGEST_SIZE];
+        bool valid;
+        usec_t until; /* CLOCK_REALTIME */
+};
+
+static void dnssec_verify_digest_hash_func(const uint8_t *digest, struct siphash *state) {
+        siphash24_compress(digest, DNSSEC_VERIFY_DIGEST_SIZE, state);
+}
+
+static int dnssec_verify_digest_compare_func(const uint8_t *a, const uint8_t *b) {
+        return memcmp(a, b, DNSSEC_VERIFY_DIGEST_SIZE);
+}
+
+DEFINE_PRIVATE_HASH_OPS_WITH_VALUE_DESTRUCTOR(
+                dnssec_verify_cache_hash_ops,
+                uint8_t, dnssec_verify_digest_hash_func, dnssec_verify_digest_compare_func,
+                DnssecVerifyCacheEntry, free);
+
+static int dnssec_verify_signature(
+                DnsResourceRecord *rrsig,
+                DnsResourceRecord *dnskey,
+                int md_algorithm,
+                const void *sig_data,
+                size_t sig_size) {
+
+        _cleanup_(gcry_md_closep) gcry_md_hd_t md = NULL;
+        size_t hash_size = 0;
+        void *hash = NULL;
+
+        /* Does the actual public key operation, returns > 0 if the signature is valid, 0 if not */
+
+        if (md_algorithm > 0) {
+                /* Calculate the digest of the RRset in canonical order */
+                gcry_md_open(&md, md_algorithm, 0);
+                if (!md)
+                        return -EIO;
+
+                hash_size = gcry_md_get_algo_dlen(md_algorithm);
+                assert(hash_size > 0);
+
+                gcry_md_write(md, sig_data, sig_size);
+
+                hash = gcry_md_read(md, 0);
+                if (!hash)
+                        return -EIO;
+        }
+
+        switch (rrsig->rrsig.algorithm) {
+
+        case DNSSEC_ALGORITHM_RSASHA1:
+        case DNSSEC_ALGORITHM_RSASHA1_NSEC3_SHA1:
+        case DNSSEC_ALGORITHM_RSASHA256:
+        case DNSSEC_ALGORITHM_RSASHA512:
+                return dnssec_rsa_verify(
+                                gcry_md_algo_name(md_algorithm),
+                                hash, hash_size,
+                                rrsig,
+                                dnskey);
+
+        case DNSSEC_ALGORITHM_ECDSAP256SHA256:
+        case DNSSEC_ALGORITHM_ECDSAP384SHA384:
+                return dnssec_ecdsa_verify(
+                                gcry_md_algo_name(md_algorithm),
+                                rrsig->rrsig.algorithm,
+                                hash, hash_size,
+                                rrsig,
+                                dnskey);
+#if GCRYPT_VERSION_NUMBER >= 0x010600
+        case DNSSEC_ALGORITHM_ED25519:
+                return dnssec_eddsa_verify(
+                                rrsig->rrsig.algorithm,
+                                sig_data, sig_size,
+                                rrsig,
+                                dnskey);
+#endif
+        default:
+                return -EOPNOTSUPP;
+        }
+}
+
+static int dnssec_verify_digest(
+                DnsResourceRecord *rrsig,
+                DnsResourceRecord *dnskey,
+                const void *sig_data,
+                size_t sig_size,
+                uint8_t ret[static DNSSEC_VERIFY_DIGEST_SIZE]) {
+
+        _cleanup_(gcry_md_closep) gcry_md_hd_t md = NULL;
+        void *h;
+
+        /* Identifies a signature check by a cryptographic digest of everything that goes into it: the
+         * signed data (i.e. the RRSIG fields and the RRset in canonical form), the signature and the
+         * public key. Each part is prefixed by its size so that they cannot be shifted into each other. */
+
+        gcry_md_open(&md, GCRY_MD_SHA256, 0);
+        if (!md)
+                return -EIO;
+
+        gcry_md_write(md, &sig_size, sizeof(sig_size));
+        gcry_md_write(md, sig_data, sig_size);
+        gcry_md_write(md, &rrsig->rrsig.signature_size, sizeof(rrsig->rrsig.signature_size));
+        gcry_md_write(md, rrsig->rrsig.signature, rrsig->rrsig.signature_size);
+        gcry_md_write(md, &dnskey->dnskey.key_size, sizeof(dnskey->dnskey.key_size));
+        gcry_md_write(md, dnskey->dnskey.key, dnskey->dnskey.key_size);
+
+        h = gcry_md_read(md, GCRY_MD_SHA256);
+        if (!h)
+                return -EIO;
+
+        memcpy(ret, h, DNSSEC_VERIFY_DIGEST_SIZE);
+        return 0;
+}
+
+static int dnssec_verify_cache_lookup(
+                Hashmap **verify_cache,
+                DnsResourceRecord *rrsig,
+                DnsResourceRecord *dnskey,
+                const void *sig_data,
+                size_t sig_size,
+                uint8_t digest[static DNSSEC_VERIFY_DIGEST_SIZE],
+                bool *ret_valid) {
+
+        DnssecVerifyCacheEntry *e;
+        int r;
+
+        /* Returns > 0 if we already know the outcome of this exact signature check */
+
+        if (!verify_cache)
+                return 0;
+
+        r = dnssec_verify_digest(rrsig, dnskey, sig_data, sig_size, digest);
+        if (r < 0)
+                return r;
+
+        e = hashmap_get(*verify_cache, digest);
+        if (!e)
+                return 0;
+
+        *ret_valid = e->valid;
+        return 1;
+}
+
+static int dnssec_verify_cache_add(
+                Hashmap **verify_cache,
+                DnsResourceRecord *rrsig,
+                const uint8_t digest[static DNSSEC_VERIFY_DIGEST_SIZE],
+                bool valid,
+                usec_t realtime) {
+
+        _cleanup_free_ DnssecVerifyCacheEntry *e = NULL;
+        DnssecVerifyCacheEntry *i;
+        int r;
+
+        if (!verify_cache)
+                return 0;
+
+        if (hashmap_size(*verify_cache) >= DNSSEC_VERIFY_CACHE_MAX) {
+                /* Make room: first drop everything whose signature expired, and if that's not enough
+                 * start from scratch. */
+                HASHMAP_FOREACH(i, *verify_cache)
+                        if (i->until < realtime)
+                                free(hashmap_remove(*verify_cache, i->digest));
+
+                if (hashmap_size(*verify_cache) >= DNSSEC_VERIFY_CACHE_MAX)
+                        hashmap_clear(*verify_cache);
+        }
+
+        e = new(DnssecVerifyCacheEntry, 1);
+        if (!e)
+                return -ENOMEM;
+
+        *e = (DnssecVerifyCacheEntry) {
+                .valid = valid,
+                .until = usec_add(rrsig->rrsig.expiration * USEC_PER_SEC, SKEW_MAX),
+        };
+        memcpy(e->digest, digest, DNSSEC_VERIFY_DIGEST_SIZE);
+
+        r = hashmap_ensure_put(verify_cache, &dnssec_verify_cache_hash_ops, e->digest, e);
+        if (r < 0)
+                return r;
+
+        TAKE_PTR(e);
+        return 1;
+}
+
+static int dnssec_verify_rrset_full(
                 DnsAnswer *a,
                 const DnsResourceKey *key,
                 DnsResourceRecord *rrsig,
                 DnsResourceRecord *dnskey,
                 usec_t realtime,
+                Hashmap **verify_cache,
                 DnssecResult *result) {
 
         uint8_t wire_format_name[DNS_WIRE_FORMAT_HOSTNAME_MAX];
+        uint8_t digest[DNSSEC_VERIFY_DIGEST_SIZE];
         DnsResourceRecord **list, *rr;
         const char *source, *name;
-        _cleanup_(gcry_md_closep) gcry_md_hd_t md = NULL;
         int r, md_algorithm;
         size_t k, n = 0;
         size_t sig_size = 0;
         _cleanup_free_ char *sig_data = NULL;
         _cleanup_fclose_ FILE *f = NULL;
-        size_t hash_size;
-        void *hash;
-        bool wildcard;
+        bool wildcard, valid;
 
         assert(key);
         assert(rrsig);
@@ -800,6 +990,7 @@ int dnssec_verify_rrset(
         switch (rrsig->rrsig.algorithm) {
 #if GCRYPT_VERSION_NUMBER >= 0x010600
         case DNSSEC_ALGORITHM_ED25519:
+                md_algorithm = 0; /* EdDSA hashes the data itself */
                 break;
 #else
         case DNSSEC_ALGORITHM_ED25519:
@@ -808,7 +999,6 @@ int dnssec_verify_rrset(
                 *result = DNSSEC_UNSUPPORTED_ALGORITHM;
                 return 0;
         default:
-                /* OK, the RRs are now in canonical order. Let's calculate the digest */
                 md_algorithm = algorithm_to_gcrypt_md(rrsig->rrsig.algorithm);
                 if (md_algorithm == -EOPNOTSUPP) {
                         *result = DNSSEC_UNSUPPORTED_ALGORITHM;
@@ -816,55 +1006,22 @@ int dnssec_verify_rrset(
                 }
                 if (md_algorithm < 0)
                         return md_algorithm;
-
-                gcry_md_open(&md, md_algorithm, 0);
-                if (!md)
-                        return -EIO;
-
-                hash_size = gcry_md_get_algo_dlen(md_algorithm);
-                assert(hash_size > 0);
-
-                gcry_md_write(md, sig_data, sig_size);
-
-                hash = gcry_md_read(md, 0);
-                if (!hash)
-                        return -EIO;
         }
 
-        switch (rrsig->rrsig.algorithm) {
-
-        case DNSSEC_ALGORITHM_RSASHA1:
-        case DNSSEC_ALGORITHM_RSASHA1_NSEC3_SHA1:
-        case DNSSEC_ALGORITHM_RSASHA256:
-        case DNSSEC_ALGORITHM_RSASHA512:
-                r = dnssec_rsa_verify(
-                                gcry_md_algo_name(md_algorithm),
-                                hash, hash_size,
-                                rrsig,
-                                dnskey);
-                break;
-
-        case DNSSEC_ALGORITHM_ECDSAP256SHA256:
-        case DNSSEC_ALGORITHM_ECDSAP384SHA384:
-                r = dnssec_ecdsa_verify(
-                                gcry_md_algo_name(md_algorithm),
-                                rrsig->rrsig.algorithm,
-                                hash, hash_size,
-                                rrsig,
-                                dnskey);
-                break;
-#if GCRYPT_VERSION_NUMBER >= 0x010600
-        case DNSSEC_ALGORITHM_ED25519:
-                r = dnssec_eddsa_verify(
-                                rrsig->rrsig.algorithm,
-                                sig_data, sig_size,
-                                rrsig,
-                                dnskey);
-                break;
-#endif
-        }
+        /* The public key operations are expensive, hence remember their outcome, so that we don't have
+         * to do them again when we see the very same RRset, RRSIG and DNSKEY again. */
+        r = dnssec_verify_cache_lookup(verify_cache, rrsig, dnskey, sig_data, sig_size, digest, &valid);
         if (r < 0)
                 return r;
+        if (r > 0)
+                r = valid;
+        else {
+                r = dnssec_verify_signature(rrsig, dnskey, md_algorithm, sig_data, sig_size);
+                if (r < 0)
+                        return r;
+
+                (void) dnssec_verify_cache_add(verify_cache, rrsig, digest, r > 0, realtime);
+        }
 
         /* Now, fix the ttl, expiry, and remember the synthesizing source and the signer */
         if (r > 0)
@@ -880,6 +1037,17 @@ int dnssec_verify_rrset(
         return 0;
 }
 
+int dnssec_verify_rrset(
+                DnsAnswer *a,
+                const DnsResourceKey *key,
+                DnsResourceRecord *rrsig,
+                DnsResourceRecord *dnskey,
+                usec_t realtime,
+                DnssecResult *result) {
+
+        return dnssec_verify_rrset_full(a, key, rrsig, dnskey, realtime, NULL, result);
+}
+
 int dnssec_rrsig_match_dnskey(DnsResourceRecord *rrsig, DnsResourceRecord *dnskey, bool revoked_ok) {
 
         assert(rrsig);
@@ -931,6 +1099,7 @@ int dnssec_verify_rrset_search(
                 const DnsResourceKey *key,
                 DnsAnswer *validated_dnskeys,
                 usec_t realtime,
+                Hashmap **verify_cache,
                 DnssecResult *result,
                 DnsResourceRecord **ret_rrsig) {
 
@@ -985,7 +1154,7 @@ int dnssec_verify_rrset_search(
                          * the RRSet against the RRSIG and DNSKEY
                          * combination. */
 
-                        r = dnssec_verify_rrset(a, key, rrsig, dnskey, realtime, &one_result);
+                        r = dnssec_verify_rrset_full(a, key, rrsig, dnskey, realtime, verify_cache, &one_result);
                         if (r < 0)
                                 return r;
 
@@ -2190,6 +2359,7 @@ int dnssec_verify_rrset_search(
                 const DnsResourceKey *key,
                 DnsAnswer *validated_dnskeys,
                 usec_t realtime,
+                Hashmap **verify_cache,
                 DnssecResult *result,
                 DnsResourceRecord **ret_rrsig) {
 
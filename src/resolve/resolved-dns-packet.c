@@ -212,6 +212,7 @@ static void dns_packet_free(DnsPacket *p) {
         dns_question_unref(p->question);
         dns_answer_unref(p->answer);
         dns_resource_record_unref(p->opt);
+        dns_resource_key_unref(p->last_key);
 
         while ((s = hashmap_steal_first_key(p->names)))
                 free(s);
@@ -404,6 +405,8 @@ void dns_packet_truncate(DnsPacket *p, size_t sz) {
                 free(s);
         }
 
+        p->last_key = dns_resource_key_unref(p->last_key);
+
         p->size = sz;
 }
 
@@ -1444,7 +1447,10 @@ int dns_packet_read_name(
 
         _cleanup_(rewind_dns_packet) DnsPacketRewinder rewinder;
         size_t after_rindex = 0, jump_barrier;
-        _cleanup_free_ char *name = NULL;
+        /* Decode into a buffer on the stack, and only copy the result to the heap once we know its size.
+         * Names that don't fit (which requires heavy escaping) are moved to the heap. */
+        char buf[DNS_HOSTNAME_MAX + 1 + DNS_LABEL_ESCAPED_MAX], *name = buf;
+        _cleanup_free_ char *allocated_name = NULL;
         size_t n = 0, allocated = 0;
         bool first = true;
         int r;
@@ -1475,8 +1481,17 @@ int dns_packet_read_name(
                         if (r < 0)
                                 return r;
 
-                        if (!GREEDY_REALLOC(name, allocated, n + !first + DNS_LABEL_ESCAPED_MAX))
-                                return -ENOMEM;
+                        if (!allocated_name && n + !first + DNS_LABEL_ESCAPED_MAX > sizeof(buf)) {
+                                if (!GREEDY_REALLOC(allocated_name, allocated, n + !first + DNS_LABEL_ESCAPED_MAX))
+                                        return -ENOMEM;
+
+                                name = memcpy(allocated_name, buf, n);
+                        } else if (allocated_name) {
+                                if (!GREEDY_REALLOC(allocated_name, allocated, n + !first + DNS_LABEL_ESCAPED_MAX))
+                                        return -ENOMEM;
+
+                                name = allocated_name;
+                        }
 
                         if (first)
                                 first = false;
@@ -1511,16 +1526,27 @@ int dns_packet_read_name(
                         return -EBADMSG;
         }
 
-        if (!GREEDY_REALLOC(name, allocated, n + 1))
-                return -ENOMEM;
+        if (allocated_name) {
+                if (!GREEDY_REALLOC(allocated_name, allocated, n + 1))
+                        return -ENOMEM;
+
+                name = allocated_name;
+        }
 
         name[n] = 0;
 
         if (after_rindex != 0)
                 p->rindex= after_rindex;
 
-        if (ret)
-                *ret = TAKE_PTR(name);
+        if (ret) {
+                if (allocated_name)
+                        *ret = TAKE_PTR(allocated_name);
+                else {
+                        *ret = memdup(buf, n + 1);
+                        if (!*ret)
+                                return -ENOMEM;
+                }
+        }
         if (ret_start)
                 *ret_start = rewinder.saved_rindex;
 
@@ -1635,11 +1661,35 @@ int dns_packet_read_key(
         _cleanup_free_ char *name = NULL;
         bool cache_flush = false;
         uint16_t class, type;
+        const uint8_t *wire;
         int r;
 
         assert(p);
         INIT_REWINDER(rewinder, p);
 
+        /* If the name is a compression pointer, and pointer, type and class are the same as for the last
+         * key we read that way, the key is the same too. The pointer target lies before that earlier key,
+         * hence the jump is valid here as well. */
+        if (ret && p->last_key && !p->refuse_compression &&
+            p->rindex + sizeof(p->last_key_wire) <= p->size) {
+
+                wire = DNS_PACKET_DATA(p) + p->rindex;
+                if (memcmp(wire, p->last_key_wire, sizeof(p->last_key_wire)) == 0) {
+                        p->rindex += sizeof(p->last_key_wire);
+
+                        *ret = dns_resource_key_ref(p->last_key);
+                        if (ret_cache_flush)
+                                *ret_cache_flush = p->last_key_cache_flush;
+                        if (ret_start)
+                                *ret_start = rewinder.saved_rindex;
+
+                        CANCEL_REWINDER(rewinder);
+                        return 0;
+                }
+        }
+
+        wire = DNS_PACKET_DATA(p) + p->rindex;
+
         r = dns_packet_read_name(p, &name, true, NULL);
         if (r < 0)
                 return r;
@@ -1670,6 +1720,14 @@ int dns_packet_read_key(
 
                 TAKE_PTR(name);
                 *ret = key;
+
+                /* Remember keys whose name consists of nothing but a compression pointer */
+                if (p->rindex - rewinder.saved_rindex == sizeof(p->last_key_wire) && FLAGS_SET(wire[0], 0xc0)) {
+                        memcpy(p->last_key_wire, wire, sizeof(p->last_key_wire));
+                        dns_resource_key_unref(p->last_key);
+                        p->last_key = dns_resource_key_ref(key);
+                        p->last_key_cache_flush = cache_flush;
+                }
         }
 
         if (ret_cache_flush)
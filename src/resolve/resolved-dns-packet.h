@@ -71,6 +71,13 @@ struct DnsPacket {
         DnsAnswer *answer;
         DnsResourceRecord *opt;
 
+        /* The last key we read whose name was a compression pointer, together with the raw pointer, type
+         * and class fields it was read from. Answers tend to carry many RRs for the same name, this lets us
+         * share the key between them. */
+        DnsResourceKey *last_key;
+        uint8_t last_key_wire[6];
+        bool last_key_cache_flush;
+
         /* Packet reception metadata */
         int ifindex;
         int family, ipproto;
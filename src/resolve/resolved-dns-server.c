@@ -19,6 +19,27 @@
 /* The number of times we will attempt a certain feature set before degrading */
 #define DNS_SERVER_FEATURE_RETRY_ATTEMPTS 3
 
+static void dns_server_record_rtt(DnsServer *s, int protocol, usec_t rtt) {
+        unsigned bucket = 0;
+
+        assert(s);
+
+        for (usec_t limit = USEC_PER_MSEC; rtt >= limit && bucket < DNS_SERVER_RTT_HISTOGRAM_BUCKETS - 1; limit *= 2)
+                bucket++;
+
+        s->rtt_histogram[bucket]++;
+
+        /* TCP replies include the connection setup, hence only use UDP ones for the UDP resend timeout */
+        if (protocol != IPPROTO_UDP)
+                return;
+
+        /* Base the resend timeout on the slowest reply we saw, not on the average: a recursive server
+         * answers cached names more quickly than uncached ones, and resending too early would make us
+         * think UDP packets got lost. */
+        s->max_rtt = MAX(s->max_rtt, rtt);
+        s->resend_timeout = CLAMP(s->max_rtt * 2, DNS_TIMEOUT_MIN_USEC, DNS_TIMEOUT_MAX_USEC);
+}
+
 int dns_server_new(
                 Manager *m,
                 DnsServer **ret,
@@ -255,9 +276,11 @@ static void dns_server_reset_counters(DnsServer *s) {
          * incomplete. */
 }
 
-void dns_server_packet_received(DnsServer *s, int protocol, DnsServerFeatureLevel level, size_t fragsize) {
+void dns_server_packet_received(DnsServer *s, int protocol, DnsServerFeatureLevel level, usec_t rtt, size_t fragsize) {
         assert(s);
 
+        dns_server_record_rtt(s, protocol, rtt);
+
         if (protocol == IPPROTO_UDP) {
                 if (s->possible_feature_level == level)
                         s->n_failed_udp = 0;
@@ -302,9 +325,12 @@ void dns_server_packet_lost(DnsServer *s, int protocol, DnsServerFeatureLevel le
         if (s->possible_feature_level != level)
                 return;
 
-        if (protocol == IPPROTO_UDP)
+        if (protocol == IPPROTO_UDP) {
                 s->n_failed_udp++;
-        else if (protocol == IPPROTO_TCP) {
+
+                /* Back off, in case the server just got slower */
+                s->resend_timeout = MIN(s->resend_timeout * 2, DNS_TIMEOUT_MAX_USEC);
+        } else if (protocol == IPPROTO_TCP) {
                 if (DNS_SERVER_FEATURE_LEVEL_IS_TLS(level))
                         s->n_failed_tls++;
                 else
@@ -991,6 +1017,9 @@ void dns_server_reset_features(DnsServer *s) {
 
         s->features_grace_period_usec = DNS_SERVER_FEATURE_GRACE_PERIOD_MIN_USEC;
 
+        s->max_rtt = 0;
+        s->resend_timeout = DNS_TIMEOUT_MAX_USEC;
+
         s->warned_downgrade = false;
 
         dns_server_reset_counters(s);
@@ -1007,6 +1036,8 @@ void dns_server_reset_features_all(DnsServer *s) {
 }
 
 void dns_server_dump(DnsServer *s, FILE *f) {
+        char buf[FORMAT_TIMESPAN_MAX], buf2[FORMAT_TIMESPAN_MAX];
+
         assert(s);
 
         if (!f)
@@ -1059,6 +1090,20 @@ void dns_server_dump(DnsServer *s, FILE *f) {
                 yes_no(s->packet_rrsig_missing),
                 yes_no(s->packet_invalid),
                 yes_no(s->packet_do_off));
+
+        fprintf(f,
+                "\tMaximum UDP round-trip time: %s\n"
+                "\tResend timeout: %s\n"
+                "\tRound-trip times:",
+                format_timespan(buf, sizeof buf, s->max_rtt, USEC_PER_MSEC),
+                format_timespan(buf2, sizeof buf2, s->resend_timeout, USEC_PER_MSEC));
+
+        for (unsigned i = 0; i < DNS_SERVER_RTT_HISTOGRAM_BUCKETS; i++)
+                fprintf(f, " %s%ums: %u",
+                        i < DNS_SERVER_RTT_HISTOGRAM_BUCKETS - 1 ? "<" : ">=",
+                        i < DNS_SERVER_RTT_HISTOGRAM_BUCKETS - 1 ? 1U << i : 1U << (i - 1),
+                        s->rtt_histogram[i]);
+        fputc('\n', f);
 }
 
 void dns_server_unref_stream(DnsServer *s) {
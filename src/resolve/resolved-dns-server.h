@@ -45,6 +45,9 @@ typedef enum DnsServerFeatureLevel {
 #define DNS_SERVER_FEATURE_LEVEL_IS_DNSSEC(x) ((x) >= DNS_SERVER_FEATURE_LEVEL_DO)
 #define DNS_SERVER_FEATURE_LEVEL_IS_UDP(x) IN_SET(x, DNS_SERVER_FEATURE_LEVEL_UDP, DNS_SERVER_FEATURE_LEVEL_EDNS0, DNS_SERVER_FEATURE_LEVEL_DO, DNS_SERVER_FEATURE_LEVEL_LARGE)
 
+/* Round-trip times are counted in power-of-two millisecond buckets: < 1ms, < 2ms, < 4ms, …, ≥ 1024ms */
+#define DNS_SERVER_RTT_HISTOGRAM_BUCKETS 12
+
 const char* dns_server_feature_level_to_string(int i) _const_;
 int dns_server_feature_level_from_string(const char *s) _pure_;
 
@@ -81,6 +84,11 @@ struct DnsServer {
         unsigned n_failed_tcp;
         unsigned n_failed_tls;
 
+        /* Round-trip times of replies on this server, and the UDP resend timeout derived from them */
+        usec_t max_rtt;
+        usec_t resend_timeout;
+        unsigned rtt_histogram[DNS_SERVER_RTT_HISTOGRAM_BUCKETS];
+
         bool packet_truncated:1;        /* Set when TC bit was set on reply */
         bool packet_bad_opt:1;          /* Set when OPT was missing or otherwise bad on reply */
         bool packet_rrsig_missing:1;    /* Set when RRSIG was missing */
@@ -119,7 +127,7 @@ DnsServer* dns_server_unref(DnsServer *s);
 void dns_server_unlink(DnsServer *s);
 void dns_server_move_back_and_unmark(DnsServer *s);
 
-void dns_server_packet_received(DnsServer *s, int protocol, DnsServerFeatureLevel level, size_t fragsize);
+void dns_server_packet_received(DnsServer *s, int protocol, DnsServerFeatureLevel level, usec_t rtt, size_t fragsize);
 void dns_server_packet_lost(DnsServer *s, int protocol, DnsServerFeatureLevel level);
 void dns_server_packet_truncated(DnsServer *s, DnsServerFeatureLevel level);
 void dns_server_packet_rrsig_missing(DnsServer *s, DnsServerFeatureLevel level);
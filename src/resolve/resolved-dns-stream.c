@@ -273,6 +273,29 @@ static ssize_t dns_stream_read(DnsStream *s, void *buf, size_t count) {
         return ss;
 }
 
+static int dns_stream_restart_timeout(DnsStream *s) {
+        usec_t usec = DNS_STREAM_TIMEOUT_USEC;
+        int r;
+
+        assert(s);
+
+        /* Lookup streams towards upstream servers are kept around for reuse after the last reply, use the
+         * configured idle timeout once nothing is pending on them anymore. */
+        if (s->type == DNS_STREAM_LOOKUP &&
+            !s->transactions &&
+            ordered_set_isempty(s->write_queue))
+                usec = s->manager->stream_idle_timeout_usec;
+
+        if (usec == USEC_INFINITY)
+                return sd_event_source_set_enabled(s->timeout_event_source, SD_EVENT_OFF);
+
+        r = sd_event_source_set_time_relative(s->timeout_event_source, usec);
+        if (r < 0)
+                return r;
+
+        return sd_event_source_set_enabled(s->timeout_event_source, SD_EVENT_ONESHOT);
+}
+
 static int on_stream_timeout(sd_event_source *es, usec_t usec, void *userdata) {
         DnsStream *s = userdata;
 
@@ -438,9 +461,9 @@ static int on_stream_io(sd_event_source *es, int fd, uint32_t revents, void *use
 
         /* If we did something, let's restart the timeout event source */
         if (progressed && s->timeout_event_source) {
-                r = sd_event_source_set_time_relative(s->timeout_event_source, DNS_STREAM_TIMEOUT_USEC);
+                r = dns_stream_restart_timeout(s);
                 if (r < 0)
-                        log_warning_errno(errno, "Couldn't restart TCP connection timeout, ignoring: %m");
+                        log_warning_errno(r, "Couldn't restart TCP connection timeout, ignoring: %m");
         }
 
         return 0;
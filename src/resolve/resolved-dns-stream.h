@@ -26,6 +26,9 @@ typedef enum DnsStreamType {
 
 #define DNS_STREAM_WRITE_TLS_DATA 1
 
+/* How long to keep idle lookup streams towards upstream servers around for reuse, by default */
+#define DNS_STREAM_IDLE_TIMEOUT_DEFAULT_USEC (10 * USEC_PER_SEC)
+
 /* Streams are used by three subsystems:
  *
  *   1. The normal transaction logic when doing a DNS or LLMNR lookup via TCP
@@ -8,6 +8,7 @@
 #include "missing_network.h"
 #include "missing_socket.h"
 #include "resolved-dns-stub.h"
+#include "resolved-etc-hosts.h"
 #include "socket-netlink.h"
 #include "socket-util.h"
 #include "stdio-util.h"
@@ -20,6 +21,9 @@
 /* On the extra stubs, use a more conservative choice */
 #define ADVERTISE_EXTRA_DATAGRAM_SIZE_MAX DNS_PACKET_UNICAST_SIZE_LARGE_MAX
 
+/* How many UDP queries to read per wakeup at most, so that a busy stub doesn't starve other event sources */
+#define STUB_UDP_READ_MAX 32U
+
 static int manager_dns_stub_fd_extra(Manager *m, DnsStubListenerExtra *l, int type);
 
 static void dns_stub_listener_extra_hash_func(const DnsStubListenerExtra *a, struct siphash *state) {
@@ -243,14 +247,19 @@ static int dns_stub_collect_answer_by_section(
         return 0;
 }
 
-static int dns_stub_assign_sections(
-                DnsQuery *q,
+static int dns_stub_assign_answer_sections(
+                DnsAnswer **reply_answer,
+                DnsAnswer **reply_authoritative,
+                DnsAnswer **reply_additional,
+                DnsAnswer *answer,
                 DnsQuestion *question,
                 bool edns0_do) {
 
         int r;
 
-        assert(q);
+        assert(reply_answer);
+        assert(reply_authoritative);
+        assert(reply_additional);
         assert(question);
 
         /* Let's assign the 'answer' RRs we collected to their respective sections in the reply datagram. We
@@ -267,8 +276,8 @@ static int dns_stub_assign_sections(
 
         /* Include all RRs that directly answer the question in the answer section */
         r = dns_stub_collect_answer_by_question(
-                        &q->reply_answer,
-                        q->answer,
+                        reply_answer,
+                        answer,
                         question,
                         edns0_do);
         if (r < 0)
@@ -277,10 +286,10 @@ static int dns_stub_assign_sections(
         /* Include all RRs that originate from the authority sections, and aren't already listed in the
          * answer section, in the authority section */
         r = dns_stub_collect_answer_by_section(
-                        &q->reply_authoritative,
-                        q->answer,
+                        reply_authoritative,
+                        answer,
                         DNS_ANSWER_SECTION_AUTHORITY,
-                        q->reply_answer, NULL,
+                        *reply_answer, NULL,
                         edns0_do);
         if (r < 0)
                 return r;
@@ -288,26 +297,26 @@ static int dns_stub_assign_sections(
         /* Include all RRs that originate from the answer or additional sections in the additional section
          * (except if already listed in the other two sections). Also add all RRs with no section marking. */
         r = dns_stub_collect_answer_by_section(
-                        &q->reply_additional,
-                        q->answer,
+                        reply_additional,
+                        answer,
                         DNS_ANSWER_SECTION_ANSWER,
-                        q->reply_answer, q->reply_authoritative,
+                        *reply_answer, *reply_authoritative,
                         edns0_do);
         if (r < 0)
                 return r;
         r = dns_stub_collect_answer_by_section(
-                        &q->reply_additional,
-                        q->answer,
+                        reply_additional,
+                        answer,
                         DNS_ANSWER_SECTION_ADDITIONAL,
-                        q->reply_answer, q->reply_authoritative,
+                        *reply_answer, *reply_authoritative,
                         edns0_do);
         if (r < 0)
                 return r;
         r = dns_stub_collect_answer_by_section(
-                        &q->reply_additional,
-                        q->answer,
+                        reply_additional,
+                        answer,
                         0,
-                        q->reply_answer, q->reply_authoritative,
+                        *reply_answer, *reply_authoritative,
                         edns0_do);
         if (r < 0)
                 return r;
@@ -315,6 +324,22 @@ static int dns_stub_assign_sections(
         return 0;
 }
 
+static int dns_stub_assign_sections(
+                DnsQuery *q,
+                DnsQuestion *question,
+                bool edns0_do) {
+
+        assert(q);
+
+        return dns_stub_assign_answer_sections(
+                        &q->reply_answer,
+                        &q->reply_authoritative,
+                        &q->reply_additional,
+                        q->answer,
+                        question,
+                        edns0_do);
+}
+
 static int dns_stub_make_reply_packet(
                 DnsPacket **ret,
                 size_t max_size,
@@ -840,6 +865,161 @@ static int dns_stub_stream_complete(DnsStream *s, int error) {
         return 0;
 }
 
+static DnsScope *dns_stub_pick_cache_scope(Manager *m, uint64_t flags, const char *name) {
+        DnsScopeMatch found = DNS_SCOPE_NO;
+        DnsScope *s, *scope = NULL;
+        bool ambiguous = false;
+
+        assert(m);
+        assert(name);
+
+        /* Determines the scope dns_query_go() would send the query to, but only if this is a single unicast
+         * DNS scope. Otherwise, we'd have to merge the replies of multiple scopes, which is left to the full
+         * query logic. */
+
+        LIST_FOREACH(scopes, s, m->dns_scopes) {
+                DnsScopeMatch match;
+
+                match = dns_scope_good_domain(s, 0, flags, name);
+                if (match < 0)
+                        return NULL;
+
+                if (match > found) {
+                        found = match;
+                        scope = s;
+                        ambiguous = false;
+                } else if (match == found && found != DNS_SCOPE_NO)
+                        ambiguous = true;
+        }
+
+        if (found == DNS_SCOPE_NO || ambiguous || scope->protocol != DNS_PROTOCOL_DNS)
+                return NULL;
+
+        return scope;
+}
+
+static int dns_stub_reply_from_cache(Manager *m, DnsStubListenerExtra *l, DnsStream *s, DnsPacket *p, uint64_t flags) {
+        _cleanup_(dns_answer_unrefp) DnsAnswer *answer = NULL, *reply_answer = NULL, *reply_authoritative = NULL, *reply_additional = NULL;
+        _cleanup_(dns_packet_unrefp) DnsPacket *reply = NULL;
+        DnssecResult dnssec_result;
+        uint64_t answer_query_flags;
+        DnsAnswerItem *item;
+        DnsResourceKey *key;
+        DnsScope *scope;
+        bool truncated;
+        int rcode, r;
+
+        assert(m);
+        assert(p);
+
+        /* Fast path for plain queries that can be answered from the cache of a single unicast DNS scope
+         * right away: we reply here, without allocating a DnsQuery and DnsTransaction objects. Returns 0 if
+         * the query shall be processed by the full query logic instead. This is the case for everything
+         * that needs more than a single cache lookup: DNSSEC aware clients, CNAME/DNAME redirects,
+         * /etc/hosts entries, RRs that might come from the trust anchor, or names that multiple scopes are
+         * responsible for. */
+
+        if (DNS_PACKET_DO(p))
+                return 0;
+
+        if (dns_question_size(p->question) != 1 ||
+            dns_question_is_valid_for_query(p->question) <= 0)
+                return 0;
+
+        key = p->question->keys[0];
+        if (dns_type_is_dnssec(key->type))
+                return 0;
+
+        r = manager_etc_hosts_lookup(m, p->question, &answer);
+        if (r != 0)
+                return 0;
+
+        scope = dns_stub_pick_cache_scope(m, flags, dns_resource_key_name(key));
+        if (!scope)
+                return 0;
+
+        /* Same as dns_transaction_prepare() does */
+        (void) dns_scope_get_dns_server(scope);
+        dns_cache_prune(&scope->cache);
+
+        r = dns_cache_lookup(&scope->cache, key, flags, &rcode, &answer, NULL, &answer_query_flags, &dnssec_result);
+        if (r <= 0) {
+                /* The full query logic will look into the cache again, don't count this lookup twice */
+                if (r == 0)
+                        scope->cache.n_miss--;
+                return 0;
+        }
+
+        DNS_ANSWER_FOREACH_ITEM(item, answer) {
+                r = dns_question_matches_rr(p->question, item->rr, NULL);
+                if (r > 0)
+                        continue;
+                if (r == 0)
+                        r = dns_question_matches_cname_or_dname(p->question, item->rr, NULL);
+                if (r != 0) {
+                        /* A redirect, let the full query logic follow it */
+                        scope->cache.n_hit--;
+                        return 0;
+                }
+        }
+
+        if (rcode == DNS_RCODE_SUCCESS && dns_cache_should_prefetch(&scope->cache, key))
+                dns_transaction_prefetch(scope, key, flags);
+
+        /* Return a different order of the RRs each time, the same as dns_transaction_randomize_answer() */
+        if (dns_answer_size(answer) > 1 && dns_answer_reserve_or_clone(&answer, 0) >= 0)
+                dns_answer_randomize(answer);
+
+        r = dns_stub_assign_answer_sections(
+                        &reply_answer,
+                        &reply_authoritative,
+                        &reply_additional,
+                        answer,
+                        p->question,
+                        /* edns0_do = */ false);
+        if (r < 0)
+                return log_debug_errno(r, "Failed to assign sections: %m");
+
+        r = dns_stub_make_reply_packet(
+                        &reply,
+                        DNS_PACKET_PAYLOAD_SIZE_MAX(p),
+                        p->question,
+                        &truncated);
+        if (r < 0)
+                return log_debug_errno(r, "Failed to build reply packet: %m");
+
+        r = dns_stub_add_reply_packet_body(
+                        reply,
+                        reply_answer,
+                        reply_authoritative,
+                        reply_additional,
+                        /* edns0_do = */ false,
+                        &truncated);
+        if (r < 0)
+                return log_debug_errno(r, "Failed to append reply packet body: %m");
+
+        r = dns_stub_finish_reply_packet(
+                        reply,
+                        DNS_PACKET_ID(p),
+                        rcode,
+                        truncated,
+                        /* aa = */ false,
+                        DNS_PACKET_RD(p),
+                        !!p->opt,
+                        /* edns0_do = */ false,
+                        DNS_PACKET_AD(p) && FLAGS_SET(answer_query_flags, SD_RESOLVED_AUTHENTICATED),
+                        DNS_PACKET_CD(p),
+                        l ? ADVERTISE_EXTRA_DATAGRAM_SIZE_MAX : ADVERTISE_DATAGRAM_SIZE_MAX,
+                        dns_packet_has_nsid_request(p) > 0 && !l);
+        if (r < 0)
+                return log_debug_errno(r, "Failed to build reply packet: %m");
+
+        log_debug("Answered stub query for id %u from cache.", DNS_PACKET_ID(p));
+
+        (void) dns_stub_send(m, l, s, p, reply);
+        return 1;
+}
+
 static void dns_stub_process_query(Manager *m, DnsStubListenerExtra *l, DnsStream *s, DnsPacket *p) {
         _cleanup_(dns_query_freep) DnsQuery *q = NULL;
         Hashmap **queries_by_packet;
@@ -901,6 +1081,13 @@ static void dns_stub_process_query(Manager *m, DnsStubListenerExtra *l, DnsStrea
                 return;
         }
 
+        r = dns_stub_reply_from_cache(m, l, s, p,
+                                      SD_RESOLVED_PROTOCOLS_ALL|
+                                      SD_RESOLVED_NO_SEARCH|
+                                      SD_RESOLVED_CLAMP_TTL);
+        if (r > 0)
+                return;
+
         r = hashmap_ensure_allocated(queries_by_packet, &stub_packet_hash_ops);
         if (r < 0) {
                 log_oom();
@@ -963,19 +1150,24 @@ static void dns_stub_process_query(Manager *m, DnsStubListenerExtra *l, DnsStrea
 }
 
 static int on_dns_stub_packet_internal(sd_event_source *s, int fd, uint32_t revents, Manager *m, DnsStubListenerExtra *l) {
-        _cleanup_(dns_packet_unrefp) DnsPacket *p = NULL;
         int r;
 
-        r = manager_recv(m, fd, DNS_PROTOCOL_DNS, &p);
-        if (r <= 0)
-                return r;
+        /* Under load many queries are queued on the socket at once, hence process a number of them per
+         * wakeup instead of going back to the event loop for each one. */
+        for (unsigned n = 0; n < STUB_UDP_READ_MAX; n++) {
+                _cleanup_(dns_packet_unrefp) DnsPacket *p = NULL;
 
-        if (dns_packet_validate_query(p) > 0) {
-                log_debug("Got DNS stub UDP query packet for id %u", DNS_PACKET_ID(p));
+                r = manager_recv(m, fd, DNS_PROTOCOL_DNS, &p);
+                if (r <= 0)
+                        return r;
 
-                dns_stub_process_query(m, l, NULL, p);
-        } else
-                log_debug("Invalid DNS stub UDP packet, ignoring.");
+                if (dns_packet_validate_query(p) > 0) {
+                        log_debug("Got DNS stub UDP query packet for id %u", DNS_PACKET_ID(p));
+
+                        dns_stub_process_query(m, l, NULL, p);
+                } else
+                        log_debug("Invalid DNS stub UDP packet, ignoring.");
+        }
 
         return 0;
 }
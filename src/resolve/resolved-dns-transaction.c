@@ -18,9 +18,6 @@
 #define TRANSACTIONS_MAX 4096
 #define TRANSACTION_TCP_TIMEOUT_USEC (10U*USEC_PER_SEC)
 
-/* After how much time to repeat classic DNS requests */
-#define DNS_TIMEOUT_USEC (SD_RESOLVED_QUERY_TIMEOUT_USEC / DNS_TRANSACTION_ATTEMPTS_MAX)
-
 static void dns_transaction_reset_answer(DnsTransaction *t) {
         assert(t);
 
@@ -447,6 +444,12 @@ void dns_transaction_complete(DnsTransaction *t, DnsTransactionState state) {
                 dns_transaction_notify(d, t);
         SWAP_TWO(t->notify_transactions, t->notify_transactions_done);
 
+        if (t->prefetch) {
+                /* Drop the reference the background refresh kept on itself, see dns_transaction_prefetch() */
+                t->prefetch = false;
+                t->block_gc--;
+        }
+
         t->block_gc--;
         dns_transaction_gc(t);
 }
@@ -1322,7 +1325,7 @@ void dns_transaction_process_reply(DnsTransaction *t, DnsPacket *p, bool encrypt
                 /* Report that we successfully received a packet. We keep track of the largest packet
                  * size/fragment size we got. Which is useful for announcing the EDNS(0) packet size we can
                  * receive to our server. */
-                dns_server_packet_received(t->server, p->ipproto, t->current_feature_level, dns_packet_size_unfragmented(p));
+                dns_server_packet_received(t->server, p->ipproto, t->current_feature_level, p->timestamp - t->start_usec, dns_packet_size_unfragmented(p));
         }
 
         /* See if we know things we didn't know before that indicate we better restart the lookup immediately. */
@@ -1554,7 +1557,10 @@ static usec_t transaction_get_resend_timeout(DnsTransaction *t) {
                 if (t->stream)
                         return TRANSACTION_TCP_TIMEOUT_USEC;
 
-                return DNS_TIMEOUT_USEC;
+                /* For UDP follow what we learnt about the server's round-trip times, so that we fail over
+                 * quickly if a usually fast server stops responding. */
+                assert(t->server);
+                return t->server->resend_timeout;
 
         case DNS_PROTOCOL_MDNS:
                 assert(t->n_attempts > 0);
@@ -1595,6 +1601,46 @@ static void dns_transaction_randomize_answer(DnsTransaction *t) {
         dns_answer_randomize(t->answer);
 }
 
+void dns_transaction_prefetch(DnsScope *s, DnsResourceKey *key, uint64_t query_flags) {
+        char key_str[DNS_RESOURCE_KEY_STRING_MAX];
+        DnsTransaction *aux;
+        int r;
+
+        assert(s);
+        assert(key);
+
+        /* A popular cache entry is about to expire. Refresh it from the network in the background, so that
+         * clients keep being answered from the cache. The refresh is validated like any other transaction,
+         * and its answer replaces the cache entry when it is complete. Nobody owns the transaction, hence it
+         * blocks its own GC until it is complete. */
+
+        query_flags |= SD_RESOLVED_NO_CACHE;
+
+        if (dns_scope_find_transaction(s, key, query_flags))
+                return;
+
+        r = dns_transaction_new(&aux, s, key, NULL, query_flags);
+        if (r < 0) {
+                log_debug_errno(r, "Failed to allocate transaction for refreshing cache entry, ignoring: %m");
+                return;
+        }
+
+        log_debug("Refreshing cache entry for %s in transaction %" PRIu16 ".",
+                  dns_resource_key_to_string(key, key_str, sizeof key_str), aux->id);
+
+        aux->prefetch = true;
+        aux->block_gc += 2; /* One for the refresh, and one while we are looking at it here */
+
+        r = dns_transaction_go(aux);
+
+        aux->block_gc--;
+        if (r < 0 && aux->prefetch) {
+                log_debug_errno(r, "Failed to start transaction for refreshing cache entry, ignoring: %m");
+                dns_transaction_complete_errno(aux, r);
+        } else
+                dns_transaction_gc(aux);
+}
+
 static int dns_transaction_prepare(DnsTransaction *t, usec_t ts) {
         int r;
 
@@ -1724,6 +1770,13 @@ static int dns_transaction_prepare(DnsTransaction *t, usec_t ts) {
                                 dns_transaction_reset_answer(t);
                         else {
                                 t->answer_source = DNS_TRANSACTION_CACHE;
+
+                                if (t->scope->protocol == DNS_PROTOCOL_DNS &&
+                                    t->answer_rcode == DNS_RCODE_SUCCESS &&
+                                    !FLAGS_SET(t->query_flags, SD_RESOLVED_NO_NETWORK) &&
+                                    dns_cache_should_prefetch(&t->scope->cache, dns_transaction_key(t)))
+                                        dns_transaction_prefetch(t->scope, dns_transaction_key(t), t->query_flags);
+
                                 if (t->answer_rcode == DNS_RCODE_SUCCESS)
                                         dns_transaction_complete(t, DNS_TRANSACTION_SUCCESS);
                                 else
@@ -3124,6 +3177,7 @@ static int dnssec_validate_records(
                                 rr->key,
                                 t->validated_keys,
                                 USEC_INFINITY,
+                                &t->scope->manager->dnssec_verify_cache,
                                 &result,
                                 &rrsig);
                 if (r < 0)
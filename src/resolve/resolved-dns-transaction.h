@@ -68,6 +68,9 @@ struct DnsTransaction {
 
         bool probing:1;
 
+        /* Background refresh of a cache entry, nobody waits for the result */
+        bool prefetch:1;
+
         DnsPacket *sent, *received;
 
         DnsAnswer *answer;
@@ -151,6 +154,8 @@ int dns_transaction_go(DnsTransaction *t);
 void dns_transaction_process_reply(DnsTransaction *t, DnsPacket *p, bool encrypted);
 void dns_transaction_complete(DnsTransaction *t, DnsTransactionState state);
 
+void dns_transaction_prefetch(DnsScope *s, DnsResourceKey *key, uint64_t query_flags);
+
 void dns_transaction_notify(DnsTransaction *t, DnsTransaction *source);
 int dns_transaction_validate_dnssec(DnsTransaction *t);
 int dns_transaction_request_dnssec_keys(DnsTransaction *t);
@@ -212,6 +217,11 @@ DnsTransactionSource dns_transaction_source_from_string(const char *s) _pure_;
 /* Maximum attempts to send DNS requests, across all DNS servers */
 #define DNS_TRANSACTION_ATTEMPTS_MAX 24
 
+/* After how much time to repeat classic DNS requests at most, and at least once we know the round-trip
+ * times of a server */
+#define DNS_TIMEOUT_MAX_USEC (SD_RESOLVED_QUERY_TIMEOUT_USEC / DNS_TRANSACTION_ATTEMPTS_MAX)
+#define DNS_TIMEOUT_MIN_USEC (750 * USEC_PER_MSEC)
+
 /* Maximum attempts to send LLMNR requests, see RFC 4795 Section 2.7 */
 #define LLMNR_TRANSACTION_ATTEMPTS_MAX 3
 
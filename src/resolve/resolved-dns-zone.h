@@ -39,6 +39,9 @@ struct DnsZoneItem {
 
         bool probing_enabled;
 
+        /* For mDNS: when we last multicast this RR in a reply */
+        usec_t multicast_usec;
+
         LIST_FIELDS(DnsZoneItem, by_key);
         LIST_FIELDS(DnsZoneItem, by_name);
 
@@ -9,6 +9,7 @@
 #include "hostname-util.h"
 #include "resolved-dns-synthesize.h"
 #include "resolved-etc-hosts.h"
+#include "siphash24.h"
 #include "socket-netlink.h"
 #include "stat-util.h"
 #include "string-util.h"
@@ -18,6 +19,8 @@
 /* Recheck /etc/hosts at most once every 2s */
 #define ETC_HOSTS_RECHECK_USEC (2*USEC_PER_SEC)
 
+#define ETC_HOSTS_HASH_KEY SD_ID128_MAKE(5c,92,8f,0e,b1,6a,4e,3b,9d,27,c4,a8,13,f6,70,e5)
+
 static void etc_hosts_item_free(EtcHostsItem *item) {
         strv_free(item->names);
         free(item);
@@ -124,10 +127,17 @@ static int parse_line(EtcHosts *hosts, unsigned nr, const char *line) {
                         continue;
                 }
 
-                r = strv_extend(&item->names, name);
-                if (r < 0)
+                /* Track the number of names, so that adding many names to the same address doesn't get
+                 * quadratic, as strv_extend() would */
+                if (!GREEDY_REALLOC(item->names, item->n_allocated, item->n_names + 2))
+                        return log_oom();
+
+                item->names[item->n_names] = strdup(name);
+                if (!item->names[item->n_names])
                         return log_oom();
 
+                item->names[++item->n_names] = NULL;
+
                 bn = hashmap_get(hosts->by_name, name);
                 if (!bn) {
                         r = hashmap_ensure_allocated(&hosts->by_name, &dns_name_hash_ops);
@@ -288,7 +298,10 @@ int etc_hosts_parse(EtcHosts *hosts, FILE *f) {
 
 static int manager_etc_hosts_read(Manager *m) {
         _cleanup_fclose_ FILE *f = NULL;
+        _cleanup_free_ char *data = NULL;
         struct stat st;
+        uint64_t hash;
+        size_t size;
         usec_t ts;
         int r;
 
@@ -329,11 +342,28 @@ static int manager_etc_hosts_read(Manager *m) {
         if (r < 0)
                 return log_error_errno(errno, "Failed to fstat() /etc/hosts: %m");
 
+        /* Tools managing /etc/hosts frequently rewrite it without changing its contents. Parsing large files
+         * is a lot more expensive than reading and hashing them, hence skip it if the contents are the same
+         * as last time. */
+        r = read_full_stream(f, &data, &size);
+        if (r < 0)
+                return log_error_errno(r, "Failed to read /etc/hosts: %m");
+
+        hash = siphash24(data, size, ETC_HOSTS_HASH_KEY.bytes);
+        if (m->etc_hosts_stat.st_mode != 0 && hash == m->etc_hosts_hash) {
+                log_debug("/etc/hosts was modified, but its contents didn't change, not parsing it again.");
+                m->etc_hosts_stat = st;
+                return 0;
+        }
+
+        rewind(f);
+
         r = etc_hosts_parse(&m->etc_hosts, f);
         if (r < 0)
                 return r;
 
         m->etc_hosts_stat = st;
+        m->etc_hosts_hash = hash;
         m->etc_hosts_last = ts;
 
         return 1;
@@ -592,6 +592,8 @@ int manager_new(Manager **ret) {
                 .dnssec_mode = DEFAULT_DNSSEC_MODE,
                 .dns_over_tls_mode = DEFAULT_DNS_OVER_TLS_MODE,
                 .enable_cache = DNS_CACHE_MODE_YES,
+                .cache_max_entries = DNS_CACHE_MAX_ENTRIES_DEFAULT,
+                .stream_idle_timeout_usec = DNS_STREAM_IDLE_TIMEOUT_DEFAULT_USEC,
                 .dns_stub_listener_mode = DNS_STUB_LISTENER_YES,
                 .read_resolv_conf = true,
                 .need_builtin_fallbacks = true,
@@ -709,6 +711,7 @@ Manager *manager_free(Manager *m) {
 
         hashmap_free(m->links);
         hashmap_free(m->dns_transactions);
+        hashmap_free(m->dnssec_verify_cache);
 
         sd_event_source_unref(m->network_event_source);
         sd_network_monitor_unref(m->network_monitor);
@@ -782,6 +785,8 @@ int manager_recv(Manager *m, int fd, DnsProtocol protocol, DnsPacket **ret) {
         assert(ret);
 
         ms = next_datagram_size_fd(fd);
+        if (IN_SET(ms, -EAGAIN, -EINTR))
+                return 0;
         if (ms < 0)
                 return ms;
 
@@ -1498,6 +1503,8 @@ void manager_flush_caches(Manager *m, int log_level) {
         LIST_FOREACH(scopes, scope, m->dns_scopes)
                 dns_cache_flush(&scope->cache);
 
+        hashmap_clear(m->dnssec_verify_cache);
+
         log_full(log_level, "Flushed all caches.");
 }
 
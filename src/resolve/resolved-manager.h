@@ -41,7 +41,9 @@ struct Manager {
         DnsOverTlsMode dns_over_tls_mode;
         DnsCacheMode enable_cache;
         bool cache_from_localhost;
+        unsigned cache_max_entries;
         DnsStubListenerMode dns_stub_listener_mode;
+        usec_t stream_idle_timeout_usec;
 
 #if ENABLE_DNS_OVER_TLS
         DnsTlsManagerData dnstls_data;
@@ -128,10 +130,14 @@ struct Manager {
         unsigned n_transactions_total;
         unsigned n_dnssec_verdict[_DNSSEC_VERDICT_MAX];
 
+        /* Outcomes of RRSIG checks, shared by all transactions */
+        Hashmap *dnssec_verify_cache;
+
         /* Data from /etc/hosts */
         EtcHosts etc_hosts;
         usec_t etc_hosts_last;
         struct stat etc_hosts_stat;
+        uint64_t etc_hosts_hash;
         bool read_etc_hosts;
 
         OrderedSet *dns_extra_stub_listeners;
@@ -12,6 +12,9 @@
 
 #define CLEAR_CACHE_FLUSH(x) (~MDNS_RR_CACHE_FLUSH & (x))
 
+/* RFC 6762, Section 6: don't multicast the same record more often than once per second */
+#define MDNS_MULTICAST_INTERVAL_USEC (1 * USEC_PER_SEC)
+
 void manager_mdns_stop(Manager *m) {
         assert(m);
 
@@ -173,12 +176,82 @@ static int mdns_do_tiebreak(DnsResourceKey *key, DnsAnswer *answer, DnsPacket *p
         return 0;
 }
 
+static int mdns_rr_suppressed(DnsScope *s, DnsPacket *p, DnsResourceRecord *rr, usec_t ts) {
+        DnsResourceRecord *known;
+        DnsAnswerFlags flags;
+        DnsZoneItem *i;
+        int r;
+
+        assert(s);
+        assert(p);
+        assert(rr);
+
+        /* Known-answer suppression, see RFC 6762, Section 7.1: don't reply with records the querier
+         * already listed in the answer section, as long as it still has at least half of their TTL. */
+        DNS_ANSWER_FOREACH_FLAGS(known, flags, p->answer) {
+                if (!FLAGS_SET(flags, DNS_ANSWER_SECTION_ANSWER))
+                        continue;
+                if (known->ttl < rr->ttl / 2)
+                        continue;
+
+                r = dns_resource_record_equal(rr, known);
+                if (r != 0)
+                        return r;
+        }
+
+        /* If many hosts ask the same question at about the same time, answer only once. Probes carry an
+         * authority section and are answered right away, so that conflicts are resolved quickly. */
+        if (DNS_PACKET_NSCOUNT(p) > 0)
+                return false;
+
+        i = dns_zone_get(&s->zone, rr);
+        if (!i || i->multicast_usec == 0)
+                return false;
+
+        return ts < usec_add(i->multicast_usec, MDNS_MULTICAST_INTERVAL_USEC);
+}
+
+static int mdns_answer_suppress(DnsScope *s, DnsPacket *p, DnsAnswer **answer, usec_t ts) {
+        _cleanup_(dns_answer_unrefp) DnsAnswer *filtered = NULL;
+        DnsAnswerItem *item;
+        int r;
+
+        assert(s);
+        assert(p);
+        assert(answer);
+
+        if (dns_answer_isempty(*answer))
+                return 0;
+
+        filtered = dns_answer_new(dns_answer_size(*answer));
+        if (!filtered)
+                return -ENOMEM;
+
+        DNS_ANSWER_FOREACH_ITEM(item, *answer) {
+                r = mdns_rr_suppressed(s, p, item->rr, ts);
+                if (r < 0)
+                        return r;
+                if (r > 0)
+                        continue;
+
+                r = dns_answer_add(filtered, item->rr, item->ifindex, item->flags, item->rrsig);
+                if (r < 0)
+                        return r;
+        }
+
+        dns_answer_unref(*answer);
+        *answer = TAKE_PTR(filtered);
+
+        return 0;
+}
+
 static int mdns_scope_process_query(DnsScope *s, DnsPacket *p) {
         _cleanup_(dns_answer_unrefp) DnsAnswer *full_answer = NULL;
         _cleanup_(dns_packet_unrefp) DnsPacket *reply = NULL;
         DnsResourceKey *key = NULL;
         DnsResourceRecord *rr;
         bool tentative = false;
+        usec_t ts;
         int r;
 
         assert(s);
@@ -188,6 +261,8 @@ static int mdns_scope_process_query(DnsScope *s, DnsPacket *p) {
         if (r < 0)
                 return log_debug_errno(r, "Failed to extract resource records from incoming packet: %m");
 
+        ts = now(clock_boottime_or_monotonic());
+
         assert_return((dns_question_size(p->question) > 0), -EINVAL);
 
         DNS_QUESTION_FOREACH(key, p->question) {
@@ -222,6 +297,10 @@ static int mdns_scope_process_query(DnsScope *s, DnsPacket *p) {
                         }
                 }
 
+                r = mdns_answer_suppress(s, p, &answer, ts);
+                if (r < 0)
+                        return log_debug_errno(r, "Failed to apply known-answer suppression: %m");
+
                 r = dns_answer_extend(&full_answer, answer);
                 if (r < 0)
                         return log_debug_errno(r, "Failed to extend answer: %m");
@@ -241,6 +320,14 @@ static int mdns_scope_process_query(DnsScope *s, DnsPacket *p) {
         if (r < 0)
                 return log_debug_errno(r, "Failed to send reply packet: %m");
 
+        DNS_ANSWER_FOREACH(rr, full_answer) {
+                DnsZoneItem *i;
+
+                i = dns_zone_get(&s->zone, rr);
+                if (i)
+                        i->multicast_usec = ts;
+        }
+
         return 0;
 }
 
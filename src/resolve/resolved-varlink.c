@@ -1,6 +1,7 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
 #include "in-addr-util.h"
+#include "metrics.h"
 #include "resolved-dns-synthesize.h"
 #include "resolved-varlink.h"
 #include "socket-netlink.h"
@@ -518,6 +519,38 @@ fail:
         return r;
 }
 
+static int vl_method_list_metrics(Varlink *link, JsonVariant *parameters, VarlinkMethodFlags flags, void *userdata) {
+        uint64_t cache_size = 0, cache_hit = 0, cache_miss = 0;
+        DnsScope *s;
+        Manager *m;
+
+        assert(link);
+
+        m = varlink_server_get_userdata(varlink_get_server(link));
+        assert(m);
+
+        LIST_FOREACH(scopes, s, m->dns_scopes) {
+                cache_size += dns_cache_size(&s->cache);
+                cache_hit += s->cache.n_hit;
+                cache_miss += s->cache.n_miss;
+        }
+
+        const Metric metrics[] = {
+                METRIC_GAUGE_MAKE("queries", "Queries in progress", m->n_dns_queries),
+                METRIC_GAUGE_MAKE("transactions", "Transactions in progress", hashmap_size(m->dns_transactions)),
+                METRIC_COUNTER_MAKE("transactionsTotal", "Transactions started", m->n_transactions_total),
+                METRIC_GAUGE_MAKE("cacheSize", "Cached resource records", cache_size),
+                METRIC_COUNTER_MAKE("cacheHits", "Cache hits", cache_hit),
+                METRIC_COUNTER_MAKE("cacheMisses", "Cache misses", cache_miss),
+                METRIC_COUNTER_MAKE("dnssecSecure", "DNSSEC validations with result 'secure'", m->n_dnssec_verdict[DNSSEC_SECURE]),
+                METRIC_COUNTER_MAKE("dnssecInsecure", "DNSSEC validations with result 'insecure'", m->n_dnssec_verdict[DNSSEC_INSECURE]),
+                METRIC_COUNTER_MAKE("dnssecBogus", "DNSSEC validations with result 'bogus'", m->n_dnssec_verdict[DNSSEC_BOGUS]),
+                METRIC_COUNTER_MAKE("dnssecIndeterminate", "DNSSEC validations with result 'indeterminate'", m->n_dnssec_verdict[DNSSEC_INDETERMINATE]),
+        };
+
+        return varlink_reply_metrics(link, parameters, metrics, ELEMENTSOF(metrics));
+}
+
 int manager_varlink_init(Manager *m) {
         _cleanup_(varlink_server_unrefp) VarlinkServer *s = NULL;
         int r;
@@ -536,7 +569,8 @@ int manager_varlink_init(Manager *m) {
         r = varlink_server_bind_method_many(
                         s,
                         "io.systemd.Resolve.ResolveHostname",  vl_method_resolve_hostname,
-                        "io.systemd.Resolve.ResolveAddress", vl_method_resolve_address);
+                        "io.systemd.Resolve.ResolveAddress", vl_method_resolve_address,
+                        "io.systemd.Metrics.List", vl_method_list_metrics);
         if (r < 0)
                 return log_error_errno(r, "Failed to register varlink methods: %m");
 
@@ -298,7 +298,9 @@ static void test_dnssec_verify_rrset(void) {
         };
 
         _cleanup_(dns_resource_record_unrefp) DnsResourceRecord *a = NULL, *rrsig = NULL, *dnskey = NULL;
-        _cleanup_(dns_answer_unrefp) DnsAnswer *answer = NULL;
+        _cleanup_(dns_answer_unrefp) DnsAnswer *answer = NULL, *validated = NULL;
+        _cleanup_hashmap_free_ Hashmap *verify_cache = NULL;
+        DnsResourceRecord *found;
         DnssecResult result;
 
         a = dns_resource_record_new_full(DNS_CLASS_IN, DNS_TYPE_A, "nAsA.gov");
@@ -349,6 +351,26 @@ static void test_dnssec_verify_rrset(void) {
         /* Validate the RR as it if was 2015-12-2 today */
         assert_se(dnssec_verify_rrset(answer, a->key, rrsig, dnskey, 1449092754*USEC_PER_SEC, &result) >= 0);
         assert_se(result == DNSSEC_VALIDATED);
+
+        /* Once more via the search logic, with the outcome remembered in a cache */
+        assert_se(dns_answer_add(answer, rrsig, 0, DNS_ANSWER_AUTHENTICATED, NULL) >= 0);
+        validated = dns_answer_new(1);
+        assert_se(validated);
+        assert_se(dns_answer_add(validated, dnskey, 0, DNS_ANSWER_AUTHENTICATED, NULL) >= 0);
+
+        for (unsigned i = 0; i < 2; i++) {
+                found = NULL;
+                assert_se(dnssec_verify_rrset_search(answer, a->key, validated, 1449092754*USEC_PER_SEC, &verify_cache, &result, &found) >= 0);
+                assert_se(result == DNSSEC_VALIDATED);
+                assert_se(found == rrsig);
+                assert_se(hashmap_size(verify_cache) == 1);
+        }
+
+        /* A different signature must not be mistaken for the cached one */
+        ((uint8_t*) rrsig->rrsig.signature)[0] ^= 0xFF;
+        assert_se(dnssec_verify_rrset_search(answer, a->key, validated, 1449092754*USEC_PER_SEC, &verify_cache, &result, NULL) >= 0);
+        assert_se(result == DNSSEC_INVALID);
+        assert_se(hashmap_size(verify_cache) == 2);
 }
 
 static void test_dnssec_verify_rrset2(void) {
@@ -1,8 +1,17 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
+#include <sys/mman.h>
+
 #include "bus-message-util.h"
 
+#include "fd-util.h"
+#include "io-util.h"
+#include "memfd-util.h"
 #include "resolve-util.h"
+#include "string-util.h"
+
+/* Below this, copying is cheaper than creating, sealing and mapping a memfd */
+#define BUS_BLOB_MEMFD_MIN (64U*1024U)
 
 int bus_message_read_ifindex(sd_bus_message *message, sd_bus_error *error, int *ret) {
         int ifindex, r;
@@ -183,3 +192,126 @@ clear:
 
         return r;
 }
+
+void bus_blob_done(BusBlob *b) {
+        assert(b);
+
+        if (b->map)
+                (void) munmap(b->map, b->map_size);
+
+        *b = (BusBlob) {};
+}
+
+int bus_message_append_blob(sd_bus_message *message, const void *data, size_t size) {
+        _cleanup_close_ int fd = -1;
+        int r;
+
+        assert(message);
+        assert(data || size == 0);
+
+        if (size < BUS_BLOB_MEMFD_MIN ||
+            sd_bus_can_send(sd_bus_message_get_bus(message), SD_BUS_TYPE_UNIX_FD) <= 0) {
+                r = sd_bus_message_open_container(message, 'v', "ay");
+                if (r < 0)
+                        return r;
+
+                r = sd_bus_message_append_array(message, 'y', data, size);
+                if (r < 0)
+                        return r;
+
+                return sd_bus_message_close_container(message);
+        }
+
+        fd = memfd_new("bus-blob");
+        if (fd < 0)
+                return fd;
+
+        r = loop_write(fd, data, size, false);
+        if (r < 0)
+                return r;
+
+        r = memfd_set_sealed(fd);
+        if (r < 0)
+                return r;
+
+        return sd_bus_message_append(message, "v", "h", fd);
+}
+
+int bus_message_read_blob(sd_bus_message *message, BusBlob *ret) {
+        const char *contents;
+        uint64_t sz;
+        void *p;
+        char type;
+        int fd, r;
+
+        assert(message);
+        assert(ret);
+
+        r = sd_bus_message_peek_type(message, &type, &contents);
+        if (r < 0)
+                return r;
+        if (r == 0 || type != SD_BUS_TYPE_VARIANT)
+                return -ENXIO;
+
+        if (streq(contents, "ay")) {
+                const void *data;
+                size_t size;
+
+                r = sd_bus_message_enter_container(message, 'v', "ay");
+                if (r < 0)
+                        return r;
+
+                r = sd_bus_message_read_array(message, 'y', &data, &size);
+                if (r < 0)
+                        return r;
+
+                r = sd_bus_message_exit_container(message);
+                if (r < 0)
+                        return r;
+
+                *ret = (BusBlob) {
+                        .data = data,
+                        .size = size,
+                };
+
+                return 0;
+        }
+
+        if (!streq(contents, "h"))
+                return -ENXIO;
+
+        r = sd_bus_message_read(message, "v", "h", &fd);
+        if (r < 0)
+                return r;
+
+        /* Without the seals the sender could modify the blob while we look at it, or truncate it, and make us
+         * crash with SIGBUS when accessing the mapping. */
+        r = memfd_get_sealed(fd);
+        if (r < 0)
+                return r;
+        if (r == 0)
+                return -EPERM;
+
+        r = memfd_get_size(fd, &sz);
+        if (r < 0)
+                return r;
+        if (sz > SIZE_MAX)
+                return -E2BIG;
+        if (sz == 0) {
+                *ret = (BusBlob) {};
+                return 0;
+        }
+
+        r = memfd_map(fd, 0, sz, &p);
+        if (r < 0)
+                return r;
+
+        *ret = (BusBlob) {
+                .data = p,
+                .size = sz,
+                .map = p,
+                .map_size = sz,
+        };
+
+        return 0;
+}
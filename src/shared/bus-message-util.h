@@ -16,3 +16,19 @@ int bus_message_read_dns_servers(
                         bool extended,
                         struct in_addr_full ***ret_dns,
                         size_t *ret_n_dns);
+
+/* Blobs are sent as a variant: large ones as "h", referring to a sealed memfd, if the connection supports fd
+ * passing, all others inline as "ay". The receiver maps a memfd read-only instead of copying its contents out
+ * of the byte stream. The seals guarantee that the sender can neither change nor truncate it under us. */
+typedef struct BusBlob {
+        const void *data;
+        size_t size;
+
+        void *map; /* set if the blob was received as memfd, and has to be unmapped */
+        size_t map_size;
+} BusBlob;
+
+void bus_blob_done(BusBlob *b);
+
+int bus_message_append_blob(sd_bus_message *message, const void *data, size_t size);
+int bus_message_read_blob(sd_bus_message *message, BusBlob *ret);
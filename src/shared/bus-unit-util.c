@@ -896,6 +896,7 @@ static int bus_append_execute_property(sd_bus_message *m, const char *field, con
                               "PrivateUsers",
                               "PrivateMounts",
                               "PrivateIPC",
+                              "ReuseMountNamespace",
                               "NoNewPrivileges",
                               "SyslogLevelPrefix",
                               "MemoryDenyWriteExecute",
@@ -2100,6 +2101,7 @@ static int bus_append_socket_property(sd_bus_message *m, const char *field, cons
                               "PassSecurity",
                               "PassPacketInfo",
                               "ReusePort",
+                              "ShardListeners",
                               "RemoveOnStop",
                               "SELinuxContextFromNet"))
                 return bus_append_parse_boolean(m, field, eq);
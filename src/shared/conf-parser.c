@@ -5,6 +5,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 
 #include "alloc-util.h"
@@ -28,6 +29,7 @@
 #include "sd-id128.h"
 #include "set.h"
 #include "signal-util.h"
+#include "siphash24.h"
 #include "socket-util.h"
 #include "string-util.h"
 #include "strv.h"
@@ -486,6 +488,23 @@ int config_parse_many_nulstr(
                                        ret_mtime);
 }
 
+static int config_list_dropins(
+                const char* const* conf_file_dirs,
+                const char *dropin_dirname,
+                char ***ret) {
+
+        _cleanup_strv_free_ char **dropin_dirs = NULL;
+        const char *suffix;
+        int r;
+
+        suffix = strjoina("/", dropin_dirname);
+        r = strv_extend_strv_concat(&dropin_dirs, (char**) conf_file_dirs, suffix);
+        if (r < 0)
+                return r;
+
+        return conf_files_list_strv(ret, ".conf", NULL, 0, (const char* const*) dropin_dirs);
+}
+
 /* Parse each config file in the directories specified as strv. */
 int config_parse_many(
                 const char* const* conf_files,
@@ -498,21 +517,69 @@ int config_parse_many(
                 void *userdata,
                 usec_t *ret_mtime) {
 
-        _cleanup_strv_free_ char **dropin_dirs = NULL;
         _cleanup_strv_free_ char **files = NULL;
-        const char *suffix;
         int r;
 
-        suffix = strjoina("/", dropin_dirname);
-        r = strv_extend_strv_concat(&dropin_dirs, (char**) conf_file_dirs, suffix);
+        r = config_list_dropins(conf_file_dirs, dropin_dirname, &files);
         if (r < 0)
                 return r;
 
-        r = conf_files_list_strv(&files, ".conf", NULL, 0, (const char* const*) dropin_dirs);
+        return config_parse_many_files(conf_files, files, sections, lookup, table, flags, userdata, ret_mtime);
+}
+
+#define CONFIG_DIGEST_KEY SD_ID128_MAKE(5e,d4,31,a2,7b,0c,4f,96,8a,63,e1,1f,d2,07,c8,4b)
+
+static void config_digest_file(const char *path, struct siphash *state) {
+        struct stat st;
+
+        assert(path);
+        assert(state);
+
+        siphash24_compress_string(path, state);
+
+        if (stat(path, &st) < 0) {
+                /* Mix in the error, so that a file that went away is noticed */
+                siphash24_compress(&errno, sizeof(errno), state);
+                return;
+        }
+
+        siphash24_compress(&st.st_dev, sizeof(st.st_dev), state);
+        siphash24_compress(&st.st_ino, sizeof(st.st_ino), state);
+        siphash24_compress(&st.st_size, sizeof(st.st_size), state);
+        siphash24_compress_usec_t(timespec_load(&st.st_mtim), state);
+}
+
+/* Calculates a digest over the identity of the files config_parse_many() with the same arguments would
+ * read, i.e. the paths, inode numbers, sizes and modification times of the main files and all their
+ * drop-ins. Daemons can compare it with the digest they got when they parsed the files the last time,
+ * and skip parsing them again on reload if nothing changed. */
+int config_files_digest(
+                const char* const* conf_files,
+                const char* const* conf_file_dirs,
+                const char *dropin_dirname,
+                uint64_t *ret) {
+
+        _cleanup_strv_free_ char **files = NULL;
+        struct siphash state;
+        char **fn;
+        int r;
+
+        assert(ret);
+
+        r = config_list_dropins(conf_file_dirs, dropin_dirname, &files);
         if (r < 0)
                 return r;
 
-        return config_parse_many_files(conf_files, files, sections, lookup, table, flags, userdata, ret_mtime);
+        siphash24_init(&state, CONFIG_DIGEST_KEY.bytes);
+
+        STRV_FOREACH(fn, (char**) conf_files)
+                config_digest_file(*fn, &state);
+
+        STRV_FOREACH(fn, files)
+                config_digest_file(*fn, &state);
+
+        *ret = siphash24_finalize(&state);
+        return 0;
 }
 
 #define DEFINE_PARSER(type, vartype, conv_func)                         \
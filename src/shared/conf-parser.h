@@ -112,6 +112,12 @@ int config_parse_many(
                 void *userdata,
                 usec_t *ret_mtime);         /* possibly NULL */
 
+int config_files_digest(
+                const char* const* conf_files,  /* possibly empty */
+                const char* const* conf_file_dirs,
+                const char *dropin_dirname,
+                uint64_t *ret);
+
 CONFIG_PARSER_PROTOTYPE(config_parse_int);
 CONFIG_PARSER_PROTOTYPE(config_parse_unsigned);
 CONFIG_PARSER_PROTOTYPE(config_parse_long);
@@ -62,6 +62,13 @@ static const char* const image_search_path[_IMAGE_CLASS_MAX] = {
                             "/usr/lib/extensions\0",
 };
 
+const char *image_class_search_path(ImageClass class) {
+        assert(class >= 0);
+        assert(class < _IMAGE_CLASS_MAX);
+
+        return image_search_path[class];
+}
+
 static Image *image_free(Image *i) {
         assert(i);
 
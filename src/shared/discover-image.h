@@ -67,6 +67,7 @@ int image_find(ImageClass class, const char *root, const char *name, Image **ret
 int image_from_path(const char *path, Image **ret);
 int image_find_harder(ImageClass class, const char *root, const char *name_or_path, Image **ret);
 int image_discover(ImageClass class, const char *root, Hashmap *map);
+const char *image_class_search_path(ImageClass class) _const_;
 
 int image_remove(Image *i);
 int image_rename(Image *i, const char *new_name);
@@ -229,9 +229,10 @@ static int device_is_partition(sd_device *d, sd_device *expected_parent, blkid_p
 static int find_partition(
                 sd_device *parent,
                 blkid_partition pp,
+                sd_device_enumerator *e,
                 sd_device **ret) {
 
-        _cleanup_(sd_device_enumerator_unrefp) sd_device_enumerator *e = NULL;
+        _cleanup_(sd_device_enumerator_unrefp) sd_device_enumerator *fresh = NULL;
         sd_device *q;
         int r;
 
@@ -239,9 +240,15 @@ static int find_partition(
         assert(pp);
         assert(ret);
 
-        r = enumerator_for_parent(parent, &e);
-        if (r < 0)
-                return r;
+        /* If an enumerator is passed in, its (possibly cached) list of partitions is used, otherwise the
+         * partitions are enumerated anew. */
+        if (!e) {
+                r = enumerator_for_parent(parent, &fresh);
+                if (r < 0)
+                        return r;
+
+                e = fresh;
+        }
 
         FOREACH_DEVICE(e, q) {
                 r = device_is_partition(q, parent, pp);
@@ -293,6 +300,7 @@ finish:
 static int wait_for_partition_device(
                 sd_device *parent,
                 blkid_partition pp,
+                sd_device_enumerator *e,
                 usec_t deadline,
                 sd_device **ret) {
 
@@ -305,7 +313,7 @@ static int wait_for_partition_device(
         assert(pp);
         assert(ret);
 
-        r = find_partition(parent, pp, ret);
+        r = find_partition(parent, pp, e, ret);
         if (r != -ENXIO)
                 return r;
 
@@ -343,7 +351,7 @@ static int wait_for_partition_device(
                 return r;
 
         /* Check again, the partition might have appeared in the meantime */
-        r = find_partition(parent, pp, ret);
+        r = find_partition(parent, pp, NULL, ret);
         if (r != -ENXIO)
                 return r;
 
@@ -504,6 +512,7 @@ int dissect_image(
 #endif
         bool is_gpt, is_mbr, multiple_generic = false,
                 generic_rw = false;  /* initialize to appease gcc */
+        _cleanup_(sd_device_enumerator_unrefp) sd_device_enumerator *e = NULL;
         _cleanup_(sd_device_unrefp) sd_device *d = NULL;
         _cleanup_(dissected_image_unrefp) DissectedImage *m = NULL;
         _cleanup_(blkid_free_probep) blkid_probe b = NULL;
@@ -731,6 +740,13 @@ int dissect_image(
         if (n_partitions < 0)
                 return errno_or_else(EIO);
 
+        /* Enumerate the partition devices only once for all partitions, instead of once per partition. The
+         * list is built on first use, and then reused. Only partitions that haven't shown up yet at that
+         * point require another look. */
+        r = enumerator_for_parent(d, &e);
+        if (r < 0)
+                return r;
+
         deadline = usec_add(now(CLOCK_MONOTONIC), DEVICE_TIMEOUT_USEC);
         for (int i = 0; i < n_partitions; i++) {
                 _cleanup_(sd_device_unrefp) sd_device *q = NULL;
@@ -744,7 +760,7 @@ int dissect_image(
                 if (!pp)
                         return errno_or_else(EIO);
 
-                r = wait_for_partition_device(d, pp, deadline, &q);
+                r = wait_for_partition_device(d, pp, e, deadline, &q);
                 if (r < 0)
                         return r;
 
@@ -0,0 +1,202 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <pthread.h>
+#include <signal.h>
+#include <sys/eventfd.h>
+
+#include "alloc-util.h"
+#include "event-group.h"
+#include "fd-util.h"
+#include "log.h"
+
+typedef struct EventGroupLoop {
+        sd_event *event;
+        int stop_fd;
+        pthread_t thread;
+        bool running;
+        int result;
+} EventGroupLoop;
+
+struct EventGroup {
+        EventGroupLoop *loops;
+        unsigned n_loops;
+        unsigned next;
+        bool started;
+};
+
+static int on_stop(sd_event_source *s, int fd, uint32_t revents, void *userdata) {
+        uint64_t x;
+
+        (void) read(fd, &x, sizeof x);
+
+        return sd_event_exit(sd_event_source_get_event(s), 0);
+}
+
+int event_group_new(unsigned n_threads, EventGroup **ret) {
+        _cleanup_(event_group_freep) EventGroup *g = NULL;
+        int r;
+
+        assert(n_threads > 0);
+        assert(ret);
+
+        g = new0(EventGroup, 1);
+        if (!g)
+                return -ENOMEM;
+
+        g->loops = new0(EventGroupLoop, MIN(n_threads, EVENT_GROUP_THREADS_MAX));
+        if (!g->loops)
+                return -ENOMEM;
+
+        for (unsigned i = 0; i < MIN(n_threads, EVENT_GROUP_THREADS_MAX); i++) {
+                EventGroupLoop *l = g->loops + i;
+
+                l->stop_fd = -1;
+                g->n_loops++;
+
+                r = sd_event_new(&l->event);
+                if (r < 0)
+                        return r;
+
+                l->stop_fd = eventfd(0, EFD_CLOEXEC|EFD_NONBLOCK);
+                if (l->stop_fd < 0)
+                        return -errno;
+
+                r = sd_event_add_io(l->event, NULL, l->stop_fd, EPOLLIN, on_stop, NULL);
+                if (r < 0)
+                        return r;
+        }
+
+        *ret = TAKE_PTR(g);
+        return 0;
+}
+
+EventGroup* event_group_free(EventGroup *g) {
+        if (!g)
+                return NULL;
+
+        (void) event_group_stop(g);
+
+        for (unsigned i = 0; i < g->n_loops; i++) {
+                sd_event_unref(g->loops[i].event);
+                safe_close(g->loops[i].stop_fd);
+        }
+
+        free(g->loops);
+        return mfree(g);
+}
+
+unsigned event_group_size(EventGroup *g) {
+        assert(g);
+
+        return g->n_loops;
+}
+
+sd_event* event_group_get_event(EventGroup *g, unsigned i) {
+        assert(g);
+        assert(i < g->n_loops);
+
+        return g->loops[i].event;
+}
+
+sd_event* event_group_next_event(EventGroup *g) {
+        assert(g);
+        assert(!g->started);
+
+        return g->loops[g->next++ % g->n_loops].event;
+}
+
+int event_group_add_io(EventGroup *g, int fd, uint32_t events, sd_event_io_handler_t callback, void *userdata) {
+        int r;
+
+        assert(g);
+        assert(!g->started);
+        assert(fd >= 0);
+        assert(callback);
+
+        /* The same fd is watched by all loops. Each of them gets woken up when it becomes ready, hence
+         * the handler must deal with others having taken care of it already, e.g. accept() failing with
+         * EAGAIN. The sources are floating, and go away with the loops. */
+        for (unsigned i = 0; i < g->n_loops; i++) {
+                r = sd_event_add_io(g->loops[i].event, NULL, fd, events, callback, userdata);
+                if (r < 0)
+                        return r;
+        }
+
+        return 0;
+}
+
+static void* event_group_thread(void *userdata) {
+        EventGroupLoop *l = userdata;
+
+        (void) pthread_setname_np(pthread_self(), "event-loop");
+
+        l->result = sd_event_loop(l->event);
+        return NULL;
+}
+
+int event_group_start(EventGroup *g) {
+        sigset_t ss, saved_ss;
+        int r = 0;
+
+        assert(g);
+        assert(!g->started);
+
+        /* Signals are left to the event loop of the main thread */
+        assert_se(sigfillset(&ss) >= 0);
+        r = pthread_sigmask(SIG_BLOCK, &ss, &saved_ss);
+        if (r > 0)
+                return -r;
+
+        g->started = true;
+
+        for (unsigned i = 0; i < g->n_loops; i++) {
+                EventGroupLoop *l = g->loops + i;
+
+                r = pthread_create(&l->thread, NULL, event_group_thread, l);
+                if (r > 0) {
+                        r = -r;
+                        break;
+                }
+
+                l->running = true;
+                r = 0;
+        }
+
+        (void) pthread_sigmask(SIG_SETMASK, &saved_ss, NULL);
+
+        if (r < 0) {
+                (void) event_group_stop(g);
+                return r;
+        }
+
+        return 0;
+}
+
+int event_group_stop(EventGroup *g) {
+        int r = 0;
+
+        assert(g);
+
+        /* Makes all loops exit, waits for their threads and returns the first error any of them failed
+         * with. The loops can't be started again afterwards. */
+
+        for (unsigned i = 0; i < g->n_loops; i++)
+                if (g->loops[i].running &&
+                    eventfd_write(g->loops[i].stop_fd, 1) < 0)
+                        return log_debug_errno(errno, "Failed to notify event loop thread: %m");
+
+        for (unsigned i = 0; i < g->n_loops; i++) {
+                EventGroupLoop *l = g->loops + i;
+
+                if (!l->running)
+                        continue;
+
+                assert_se(pthread_join(l->thread, NULL) == 0);
+                l->running = false;
+
+                if (l->result < 0 && r >= 0)
+                        r = l->result;
+        }
+
+        return r;
+}
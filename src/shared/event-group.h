@@ -0,0 +1,28 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+#pragma once
+
+#include "sd-event.h"
+
+#include "macro.h"
+
+/* A group of event loops, each running on a thread of its own once the group is started. Each loop is an
+ * ordinary sd_event object with all its restrictions: after event_group_start() it may only be touched from
+ * event source handlers running on it. Work is spread by attaching event sources to the loops round-robin
+ * with event_group_next_event(), and by adding a source for a shared listening socket to all loops with
+ * event_group_add_io(): whichever loop accepts a connection adds the source for it to itself. */
+typedef struct EventGroup EventGroup;
+
+#define EVENT_GROUP_THREADS_MAX 64U
+
+int event_group_new(unsigned n_threads, EventGroup **ret);
+EventGroup* event_group_free(EventGroup *g);
+DEFINE_TRIVIAL_CLEANUP_FUNC(EventGroup*, event_group_free);
+
+unsigned event_group_size(EventGroup *g);
+sd_event* event_group_get_event(EventGroup *g, unsigned i);
+sd_event* event_group_next_event(EventGroup *g);
+
+int event_group_add_io(EventGroup *g, int fd, uint32_t events, sd_event_io_handler_t callback, void *userdata);
+
+int event_group_start(EventGroup *g);
+int event_group_stop(EventGroup *g);
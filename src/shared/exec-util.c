@@ -4,6 +4,7 @@
 #include <errno.h>
 #include <sys/prctl.h>
 #include <sys/types.h>
+#include <sys/wait.h>
 #include <unistd.h>
 #include <stdio.h>
 
@@ -13,11 +14,13 @@
 #include "env-util.h"
 #include "errno-util.h"
 #include "exec-util.h"
+#include "extract-word.h"
 #include "fd-util.h"
 #include "fileio.h"
 #include "hashmap.h"
 #include "macro.h"
 #include "missing_syscall.h"
+#include "parse-util.h"
 #include "process-util.h"
 #include "rlimit-util.h"
 #include "serialize.h"
@@ -79,12 +82,46 @@ static int do_spawn(const char *path, char *argv[], int stdout_fd, pid_t *pid, b
         return 1;
 }
 
+typedef struct ExecChild {
+        usec_t start;
+        char path[];
+} ExecChild;
+
+static ExecChild* exec_child_new(const char *path) {
+        ExecChild *c;
+        size_t l;
+
+        l = strlen(path);
+        c = malloc(offsetof(ExecChild, path) + l + 1);
+        if (!c)
+                return NULL;
+
+        c->start = USEC_INFINITY;
+        memcpy(c->path, path, l + 1);
+        return c;
+}
+
+static void exec_child_record_timing(const ExecChild *c, int timing_fd) {
+        assert(c);
+
+        /* Passes the runtime of a script back to the caller of execute_directories_full(). Paths are the
+         * last field, and conf_files_list_strv() never returns paths with newlines, so this is trivially
+         * parsable. */
+
+        if (timing_fd < 0 || c->start == USEC_INFINITY)
+                return;
+
+        if (dprintf(timing_fd, USEC_FMT " " USEC_FMT " %s\n", c->start, now(CLOCK_MONOTONIC), c->path) < 0)
+                log_debug_errno(errno, "Failed to record runtime of %s, ignoring: %m", c->path);
+}
+
 static int do_execute(
                 char **directories,
                 usec_t timeout,
                 gather_stdout_callback_t const callbacks[_STDOUT_CONSUME_MAX],
                 void* const callback_args[_STDOUT_CONSUME_MAX],
                 int output_fd,
+                int timing_fd,
                 char *argv[],
                 char *envp[],
                 ExecDirFlags flags) {
@@ -124,12 +161,12 @@ static int do_execute(
                         return log_error_errno(errno, "Failed to set environment variable: %m");
 
         STRV_FOREACH(path, paths) {
-                _cleanup_free_ char *t = NULL;
+                _cleanup_free_ ExecChild *c = NULL;
                 _cleanup_close_ int fd = -1;
                 pid_t pid;
 
-                t = strdup(*path);
-                if (!t)
+                c = exec_child_new(*path);
+                if (!c)
                         return log_oom();
 
                 if (callbacks) {
@@ -138,17 +175,20 @@ static int do_execute(
                                 return log_error_errno(fd, "Failed to open serialization file: %m");
                 }
 
-                r = do_spawn(t, argv, fd, &pid, FLAGS_SET(flags, EXEC_DIR_SET_SYSTEMD_EXEC_PID));
+                c->start = now(CLOCK_MONOTONIC);
+
+                r = do_spawn(c->path, argv, fd, &pid, FLAGS_SET(flags, EXEC_DIR_SET_SYSTEMD_EXEC_PID));
                 if (r <= 0)
                         continue;
 
                 if (parallel_execution) {
-                        r = hashmap_put(pids, PID_TO_PTR(pid), t);
+                        r = hashmap_put(pids, PID_TO_PTR(pid), c);
                         if (r < 0)
                                 return log_oom();
-                        t = NULL;
+                        TAKE_PTR(c);
                 } else {
-                        r = wait_for_terminate_and_check(t, pid, WAIT_LOG);
+                        r = wait_for_terminate_and_check(c->path, pid, WAIT_LOG);
+                        exec_child_record_timing(c, timing_fd);
                         if (FLAGS_SET(flags, EXEC_DIR_IGNORE_ERRORS)) {
                                 if (r < 0)
                                         continue;
@@ -174,16 +214,27 @@ static int do_execute(
         }
 
         while (!hashmap_isempty(pids)) {
-                _cleanup_free_ char *t = NULL;
+                _cleanup_free_ ExecChild *c = NULL;
+                siginfo_t si = {};
                 pid_t pid;
 
-                pid = PTR_TO_PID(hashmap_first_key(pids));
+                /* Reap the scripts in the order they finish, so that the recorded runtimes are accurate.
+                 * We only peek here, wait_for_terminate_and_check() does the actual reaping and logging. */
+                if (waitid(P_ALL, 0, &si, WEXITED|WNOWAIT) < 0) {
+                        if (errno == EINTR)
+                                continue;
+
+                        return log_error_errno(errno, "Failed to wait for child processes: %m");
+                }
+
+                pid = si.si_pid;
                 assert(pid > 0);
 
-                t = hashmap_remove(pids, PID_TO_PTR(pid));
-                assert(t);
+                c = hashmap_remove(pids, PID_TO_PTR(pid));
+                assert(c);
 
-                r = wait_for_terminate_and_check(t, pid, WAIT_LOG);
+                r = wait_for_terminate_and_check(c->path, pid, WAIT_LOG);
+                exec_child_record_timing(c, timing_fd);
                 if (!FLAGS_SET(flags, EXEC_DIR_IGNORE_ERRORS) && r > 0)
                         return r;
         }
@@ -191,21 +242,101 @@ static int do_execute(
         return 0;
 }
 
-int execute_directories(
+ExecDirTiming* exec_dir_timing_free_many(ExecDirTiming *timings, size_t n) {
+        assert(timings || n == 0);
+
+        for (size_t i = 0; i < n; i++)
+                free(timings[i].path);
+
+        return mfree(timings);
+}
+
+static int read_timings(int *fd, ExecDirTiming **ret, size_t *ret_n) {
+        _cleanup_fclose_ FILE *f = NULL;
+        ExecDirTiming *timings = NULL;
+        size_t n = 0, allocated = 0;
+        int r;
+
+        assert(fd);
+        assert(*fd >= 0);
+        assert(ret);
+        assert(ret_n);
+
+        if (lseek(*fd, 0, SEEK_SET) < 0)
+                return log_error_errno(errno, "Failed to rewind timing fd: %m");
+
+        f = take_fdopen(fd, "r");
+        if (!f)
+                return log_error_errno(errno, "Failed to open timing fd: %m");
+
+        for (;;) {
+                _cleanup_free_ char *line = NULL, *start = NULL, *finish = NULL;
+                ExecDirTiming t = {};
+                const char *p;
+
+                r = read_line(f, LONG_LINE_MAX, &line);
+                if (r < 0) {
+                        log_error_errno(r, "Failed to read timing data: %m");
+                        goto fail;
+                }
+                if (r == 0)
+                        break;
+
+                p = line;
+                r = extract_many_words(&p, NULL, 0, &start, &finish, NULL);
+                if (r < 0) {
+                        log_error_errno(r, "Failed to parse timing data: %m");
+                        goto fail;
+                }
+                if (r < 2 || isempty(p) ||
+                    safe_atou64(start, &t.start) < 0 ||
+                    safe_atou64(finish, &t.finish) < 0) {
+                        log_debug("Invalid timing data, ignoring: %s", line);
+                        continue;
+                }
+
+                if (!GREEDY_REALLOC(timings, allocated, n + 1)) {
+                        r = log_oom();
+                        goto fail;
+                }
+
+                t.path = strdup(p);
+                if (!t.path) {
+                        r = log_oom();
+                        goto fail;
+                }
+
+                timings[n++] = t;
+        }
+
+        *ret = timings;
+        *ret_n = n;
+        return 0;
+
+fail:
+        exec_dir_timing_free_many(timings, n);
+        return r;
+}
+
+int execute_directories_full(
                 const char* const* directories,
                 usec_t timeout,
                 gather_stdout_callback_t const callbacks[_STDOUT_CONSUME_MAX],
                 void* const callback_args[_STDOUT_CONSUME_MAX],
                 char *argv[],
                 char *envp[],
-                ExecDirFlags flags) {
+                ExecDirFlags flags,
+                ExecDirTiming **ret_timings,
+                size_t *ret_n_timings) {
 
         char **dirs = (char**) directories;
-        _cleanup_close_ int fd = -1;
+        _cleanup_close_ int fd = -1, timing_fd = -1;
         char *name;
-        int r;
+        int r, k;
         pid_t executor_pid;
 
+        assert(!!ret_timings == !!ret_n_timings);
+
         assert(!strv_isempty(dirs));
 
         name = basename(dirs[0]);
@@ -222,6 +353,12 @@ int execute_directories(
                         return log_error_errno(fd, "Failed to open serialization file: %m");
         }
 
+        if (ret_timings) {
+                timing_fd = open_serialization_fd("timings");
+                if (timing_fd < 0)
+                        return log_error_errno(timing_fd, "Failed to open timing file: %m");
+        }
+
         /* Executes all binaries in the directories serially or in parallel and waits for
          * them to finish. Optionally a timeout is applied. If a file with the same name
          * exists in more than one directory, the earliest one wins. */
@@ -230,11 +367,20 @@ int execute_directories(
         if (r < 0)
                 return r;
         if (r == 0) {
-                r = do_execute(dirs, timeout, callbacks, callback_args, fd, argv, envp, flags);
+                r = do_execute(dirs, timeout, callbacks, callback_args, fd, timing_fd, argv, envp, flags);
                 _exit(r < 0 ? EXIT_FAILURE : r);
         }
 
         r = wait_for_terminate_and_check("(sd-executor)", executor_pid, 0);
+
+        /* Also return the runtimes of the scripts that finished if the executor failed or timed out, they
+         * are most interesting in that case. */
+        if (ret_timings) {
+                k = read_timings(&timing_fd, ret_timings, ret_n_timings);
+                if (k < 0)
+                        return k;
+        }
+
         if (r < 0)
                 return r;
         if (!FLAGS_SET(flags, EXEC_DIR_IGNORE_ERRORS) && r > 0)
@@ -19,9 +19,11 @@
 #include "fd-util.h"
 #include "fileio.h"
 #include "fs-util.h"
+#include "glob-util.h"
 #include "hashmap.h"
 #include "install-printf.h"
 #include "install.h"
+#include "list.h"
 #include "locale-util.h"
 #include "log.h"
 #include "macro.h"
@@ -60,6 +62,7 @@ struct UnitFilePresetRule {
         char *pattern;
         PresetAction action;
         char **instances;
+        bool indexed;
 };
 
 static bool unit_file_install_info_has_rules(const UnitFileInstallInfo *i) {
@@ -87,6 +90,7 @@ void unit_file_presets_freep(UnitFilePresets *p) {
 
         free(p->rules);
         p->n_rules = 0;
+        p->literal_rules = hashmap_free(p->literal_rules);
 }
 
 static const char *const unit_file_type_table[_UNIT_FILE_TYPE_MAX] = {
@@ -705,6 +709,97 @@ static int is_symlink_with_known_name(const UnitFileInstallInfo *i, const char *
         return false;
 }
 
+static int symlink_matches(
+                const UnitFileInstallInfo *i,
+                const char *dir_path,
+                const char *name,
+                const char *dest,
+                bool match_aliases,
+                bool ignore_same_name,
+                const char *config_path,
+                bool *same_name_link) {
+
+        bool found_path = false, found_dest, b = false;
+        int r;
+
+        assert(i);
+        assert(dir_path);
+        assert(name);
+        assert(dest);
+
+        /* Checks whether the symlink 'name' in 'dir_path' pointing to the absolute path 'dest' refers to
+         * the unit we are looking for. Returns > 0 if so. */
+
+        assert(unit_name_is_valid(i->name, UNIT_NAME_ANY));
+        if (!ignore_same_name)
+                /* Check if the symlink itself matches what we are looking for.
+                 *
+                 * If ignore_same_name is specified, we are in one of the directories which
+                 * have lower priority than the unit file, and even if a file or symlink with
+                 * this name was found, we should ignore it. */
+                found_path = streq(name, i->name);
+
+        /* Check if what the symlink points to matches what we are looking for */
+        found_dest = streq(basename(dest), i->name);
+
+        if (found_path && found_dest) {
+                _cleanup_free_ char *p = NULL, *t = NULL;
+
+                /* Filter out same name links in the main
+                 * config path */
+                p = path_make_absolute(name, dir_path);
+                t = path_make_absolute(i->name, config_path);
+
+                if (!p || !t)
+                        return -ENOMEM;
+
+                b = path_equal(p, t);
+        }
+
+        if (b)
+                *same_name_link = true;
+        else if (found_path || found_dest) {
+                if (!match_aliases)
+                        return 1;
+
+                /* Check if symlink name is in the set of names used by [Install] */
+                r = is_symlink_with_known_name(i, name);
+                if (r != 0)
+                        return r;
+        }
+
+        return 0;
+}
+
+static int read_symlink_absolute(DIR *dir, const char *dir_path, const char *name, char **ret) {
+        _cleanup_free_ char *dest = NULL;
+        int r;
+
+        assert(dir);
+        assert(dir_path);
+        assert(name);
+        assert(ret);
+
+        /* Acquire symlink destination */
+        r = readlinkat_malloc(dirfd(dir), name, &dest);
+        if (r < 0)
+                return r;
+
+        /* Make absolute */
+        if (!path_is_absolute(dest)) {
+                char *x;
+
+                x = path_join(dir_path, dest);
+                if (!x)
+                        return -ENOMEM;
+
+                free_and_replace(dest, x);
+        }
+
+        *ret = TAKE_PTR(dest);
+        return 0;
+}
+
 static int find_symlinks_in_directory(
                 DIR *dir,
                 const char *dir_path,
@@ -720,7 +815,6 @@ static int find_symlinks_in_directory(
 
         FOREACH_DIRENT(de, dir, return -errno) {
                 _cleanup_free_ char *dest = NULL;
-                bool found_path = false, found_dest, b = false;
                 int q;
 
                 dirent_ensure_type(dir, de);
@@ -728,8 +822,9 @@ static int find_symlinks_in_directory(
                 if (de->d_type != DT_LNK)
                         continue;
 
-                /* Acquire symlink destination */
-                q = readlinkat_malloc(dirfd(dir), de->d_name, &dest);
+                q = read_symlink_absolute(dir, dir_path, de->d_name, &dest);
+                if (q == -ENOMEM)
+                        return q;
                 if (q == -ENOENT)
                         continue;
                 if (q < 0) {
@@ -738,56 +833,9 @@ static int find_symlinks_in_directory(
                         continue;
                 }
 
-                /* Make absolute */
-                if (!path_is_absolute(dest)) {
-                        char *x;
-
-                        x = path_join(dir_path, dest);
-                        if (!x)
-                                return -ENOMEM;
-
-                        free_and_replace(dest, x);
-                }
-
-                assert(unit_name_is_valid(i->name, UNIT_NAME_ANY));
-                if (!ignore_same_name)
-                               /* Check if the symlink itself matches what we are looking for.
-                                *
-                                * If ignore_same_name is specified, we are in one of the directories which
-                                * have lower priority than the unit file, and even if a file or symlink with
-                                * this name was found, we should ignore it. */
-                                found_path = streq(de->d_name, i->name);
-
-                /* Check if what the symlink points to matches what we are looking for */
-                found_dest = streq(basename(dest), i->name);
-
-                if (found_path && found_dest) {
-                        _cleanup_free_ char *p = NULL, *t = NULL;
-
-                        /* Filter out same name links in the main
-                         * config path */
-                        p = path_make_absolute(de->d_name, dir_path);
-                        t = path_make_absolute(i->name, config_path);
-
-                        if (!p || !t)
-                                return -ENOMEM;
-
-                        b = path_equal(p, t);
-                }
-
-                if (b)
-                        *same_name_link = true;
-                else if (found_path || found_dest) {
-                        if (!match_aliases)
-                                return 1;
-
-                        /* Check if symlink name is in the set of names used by [Install] */
-                        q = is_symlink_with_known_name(i, de->d_name);
-                        if (q < 0)
-                                return q;
-                        if (q > 0)
-                                return 1;
-                }
+                q = symlink_matches(i, dir_path, de->d_name, dest, match_aliases, ignore_same_name, config_path, same_name_link);
+                if (q != 0)
+                        return q;
         }
 
         return r;
@@ -852,9 +900,263 @@ static int find_symlinks(
         return find_symlinks_in_directory(config_dir, config_path, root_dir, i, match_name, ignore_same_name, config_path, same_name_link);
 }
 
+typedef struct SymlinkEntry SymlinkEntry;
+
+struct SymlinkEntry {
+        char *dir_path;
+        char *name;
+        char *dest;
+
+        LIST_FIELDS(SymlinkEntry, entries);
+        LIST_FIELDS(SymlinkEntry, by_name);
+        LIST_FIELDS(SymlinkEntry, by_dest);
+};
+
+/* An index of all symlinks in one config directory and its .wants/ and .requires/ subdirectories, by the
+ * name of the symlink and by the name of the file it points to. It allows answering the question which
+ * links refer to a unit without rescanning all directories for each unit, which matters when the state
+ * of all unit files is determined in one go. */
+typedef struct SymlinkDirIndex {
+        char *config_path;
+        LIST_HEAD(SymlinkEntry, entries);
+        Hashmap *by_name;
+        Hashmap *by_dest;
+        int error;
+} SymlinkDirIndex;
+
+static SymlinkDirIndex* symlink_dir_index_free(SymlinkDirIndex *idx) {
+        SymlinkEntry *e;
+
+        if (!idx)
+                return NULL;
+
+        while ((e = idx->entries)) {
+                LIST_REMOVE(entries, idx->entries, e);
+                free(e->dir_path);
+                free(e->name);
+                free(e->dest);
+                free(e);
+        }
+
+        hashmap_free(idx->by_name);
+        hashmap_free(idx->by_dest);
+        free(idx->config_path);
+        return mfree(idx);
+}
+
+DEFINE_TRIVIAL_CLEANUP_FUNC(SymlinkDirIndex*, symlink_dir_index_free);
+
+DEFINE_PRIVATE_HASH_OPS_WITH_VALUE_DESTRUCTOR(symlink_dir_index_hash_ops, char, string_hash_func, string_compare_func,
+                                              SymlinkDirIndex, symlink_dir_index_free);
+
+static int symlink_dir_index_add(SymlinkDirIndex *idx, const char *dir_path, const char *name, char **dest) {
+        SymlinkEntry *e, *head;
+        int r;
+
+        assert(idx);
+        assert(dir_path);
+        assert(name);
+        assert(dest && *dest);
+
+        r = hashmap_ensure_allocated(&idx->by_name, &string_hash_ops);
+        if (r < 0)
+                return r;
+
+        r = hashmap_ensure_allocated(&idx->by_dest, &string_hash_ops);
+        if (r < 0)
+                return r;
+
+        e = new(SymlinkEntry, 1);
+        if (!e)
+                return -ENOMEM;
+
+        *e = (SymlinkEntry) {
+                .dir_path = strdup(dir_path),
+                .name = strdup(name),
+        };
+        LIST_PREPEND(entries, idx->entries, e);
+
+        if (!e->dir_path || !e->name)
+                return -ENOMEM;
+
+        e->dest = TAKE_PTR(*dest);
+
+        head = hashmap_get(idx->by_name, e->name);
+        LIST_PREPEND(by_name, head, e);
+        r = hashmap_replace(idx->by_name, e->name, head);
+        if (r < 0)
+                return r;
+
+        head = hashmap_get(idx->by_dest, basename(e->dest));
+        LIST_PREPEND(by_dest, head, e);
+        return hashmap_replace(idx->by_dest, basename(e->dest), head);
+}
+
+static int symlink_dir_index_add_directory(SymlinkDirIndex *idx, DIR *dir, const char *dir_path, int *ret_error) {
+        struct dirent *de;
+        int r;
+
+        assert(idx);
+        assert(dir);
+        assert(dir_path);
+        assert(ret_error);
+
+        FOREACH_DIRENT(de, dir, return -errno) {
+                _cleanup_free_ char *dest = NULL;
+
+                dirent_ensure_type(dir, de);
+
+                if (de->d_type != DT_LNK)
+                        continue;
+
+                r = read_symlink_absolute(dir, dir_path, de->d_name, &dest);
+                if (r == -ENOMEM)
+                        return r;
+                if (r == -ENOENT)
+                        continue;
+                if (r < 0) {
+                        if (*ret_error == 0)
+                                *ret_error = r;
+                        continue;
+                }
+
+                r = symlink_dir_index_add(idx, dir_path, de->d_name, &dest);
+                if (r < 0)
+                        return r;
+        }
+
+        return 0;
+}
+
+static int symlink_dir_index_build(const char *config_path, SymlinkDirIndex **ret) {
+        _cleanup_(symlink_dir_index_freep) SymlinkDirIndex *idx = NULL;
+        _cleanup_closedir_ DIR *config_dir = NULL;
+        struct dirent *de;
+        int r;
+
+        assert(config_path);
+        assert(ret);
+
+        idx = new0(SymlinkDirIndex, 1);
+        if (!idx)
+                return -ENOMEM;
+
+        idx->config_path = strdup(config_path);
+        if (!idx->config_path)
+                return -ENOMEM;
+
+        config_dir = opendir(config_path);
+        if (!config_dir) {
+                if (!IN_SET(errno, ENOENT, ENOTDIR, EACCES))
+                        idx->error = -errno;
+
+                *ret = TAKE_PTR(idx);
+                return 0;
+        }
+
+        /* Same directories as find_symlinks() looks at. Errors are handled the same way too: failures in
+         * the subdirectories are logged and ignored, failures in the config directory itself are reported
+         * if no suitable symlink is found. */
+        FOREACH_DIRENT(de, config_dir, return -errno) {
+                _cleanup_free_ const char *path = NULL;
+                _cleanup_closedir_ DIR *d = NULL;
+                const char *suffix;
+                int error = 0;
+
+                dirent_ensure_type(config_dir, de);
+
+                if (de->d_type != DT_DIR)
+                        continue;
+
+                suffix = strrchr(de->d_name, '.');
+                if (!STRPTR_IN_SET(suffix, ".wants", ".requires"))
+                        continue;
+
+                path = path_join(config_path, de->d_name);
+                if (!path)
+                        return -ENOMEM;
+
+                d = opendir(path);
+                if (!d) {
+                        log_error_errno(errno, "Failed to open directory '%s' while scanning for symlinks, ignoring: %m", path);
+                        continue;
+                }
+
+                r = symlink_dir_index_add_directory(idx, d, path, &error);
+                if (r == -ENOMEM)
+                        return r;
+                if (r < 0 || error < 0)
+                        log_debug_errno(r < 0 ? r : error, "Failed to lookup for symlinks in '%s': %m", path);
+        }
+
+        rewinddir(config_dir);
+        r = symlink_dir_index_add_directory(idx, config_dir, config_path, &idx->error);
+        if (r == -ENOMEM)
+                return r;
+        if (r < 0)
+                idx->error = r;
+
+        *ret = TAKE_PTR(idx);
+        return 0;
+}
+
+static int find_symlinks_indexed(
+                Hashmap **cache,
+                const UnitFileInstallInfo *i,
+                bool match_name,
+                bool ignore_same_name,
+                const char *config_path,
+                bool *same_name_link) {
+
+        SymlinkDirIndex *idx;
+        SymlinkEntry *e;
+        int r;
+
+        assert(cache);
+        assert(i);
+        assert(config_path);
+        assert(same_name_link);
+
+        /* Like find_symlinks(), but scans each config directory only once, and then looks up the symlinks
+         * referring to the unit in the index. */
+
+        idx = hashmap_get(*cache, config_path);
+        if (!idx) {
+                _cleanup_(symlink_dir_index_freep) SymlinkDirIndex *n = NULL;
+
+                r = symlink_dir_index_build(config_path, &n);
+                if (r < 0)
+                        return r;
+
+                r = hashmap_ensure_put(cache, &symlink_dir_index_hash_ops, n->config_path, n);
+                if (r < 0)
+                        return r;
+
+                idx = TAKE_PTR(n);
+        }
+
+        LIST_FOREACH(by_name, e, hashmap_get(idx->by_name, i->name)) {
+                r = symlink_matches(i, e->dir_path, e->name, e->dest, match_name, ignore_same_name, config_path, same_name_link);
+                if (r != 0)
+                        return r;
+        }
+
+        LIST_FOREACH(by_dest, e, hashmap_get(idx->by_dest, i->name)) {
+                if (streq(e->name, i->name))
+                        continue; /* Already checked above */
+
+                r = symlink_matches(i, e->dir_path, e->name, e->dest, match_name, ignore_same_name, config_path, same_name_link);
+                if (r != 0)
+                        return r;
+        }
+
+        return idx->error;
+}
+
 static int find_symlinks_in_scope(
                 UnitFileScope scope,
                 const LookupPaths *paths,
+                Hashmap **cache,
                 const UnitFileInstallInfo *i,
                 bool match_name,
                 UnitFileState *state) {
@@ -875,7 +1177,10 @@ static int find_symlinks_in_scope(
         STRV_FOREACH(p, paths->search_path)  {
                 bool same_name_link = false;
 
-                r = find_symlinks(paths->root_dir, i, match_name, ignore_same_name, *p, &same_name_link);
+                if (cache)
+                        r = find_symlinks_indexed(cache, i, match_name, ignore_same_name, *p, &same_name_link);
+                else
+                        r = find_symlinks(paths->root_dir, i, match_name, ignore_same_name, *p, &same_name_link);
                 if (r < 0)
                         return r;
                 if (r > 0) {
@@ -2746,9 +3051,10 @@ int unit_file_get_default(
         return 0;
 }
 
-int unit_file_lookup_state(
+static int unit_file_lookup_state_full(
                 UnitFileScope scope,
                 const LookupPaths *paths,
+                Hashmap **symlink_cache,
                 const char *name,
                 UnitFileState *ret) {
 
@@ -2812,7 +3118,7 @@ int unit_file_lookup_state(
                 /* Check if any of the Alias= symlinks have been created.
                  * We ignore other aliases, and only check those that would
                  * be created by systemctl enable for this unit. */
-                r = find_symlinks_in_scope(scope, paths, i, true, &state);
+                r = find_symlinks_in_scope(scope, paths, symlink_cache, i, true, &state);
                 if (r < 0)
                         return r;
                 if (r > 0)
@@ -2820,7 +3126,7 @@ int unit_file_lookup_state(
 
                 /* Check if the file is known under other names. If it is,
                  * it might be in use. Report that as UNIT_FILE_INDIRECT. */
-                r = find_symlinks_in_scope(scope, paths, i, false, &state);
+                r = find_symlinks_in_scope(scope, paths, symlink_cache, i, false, &state);
                 if (r < 0)
                         return r;
                 if (r > 0)
@@ -2844,6 +3150,15 @@ int unit_file_lookup_state(
         return 0;
 }
 
+int unit_file_lookup_state(
+                UnitFileScope scope,
+                const LookupPaths *paths,
+                const char *name,
+                UnitFileState *ret) {
+
+        return unit_file_lookup_state_full(scope, paths, NULL, name, ret);
+}
+
 int unit_file_get_state(
                 UnitFileScope scope,
                 const char *root_dir,
@@ -3026,6 +3341,25 @@ static int read_presets(UnitFileScope scope, const char *root_dir, UnitFilePrese
                 }
         }
 
+        /* Rules that match a single name only are indexed, so that looking up the preset for a unit does
+         * not need to try every rule in turn. Only the first rule for each name matters. Rules with
+         * instances also match by template name, see pattern_match_multiple_instances(), hence are
+         * always checked in order. */
+        for (size_t i = 0; i < ps.n_rules; i++) {
+                UnitFilePresetRule *rule = ps.rules + i;
+
+                if (rule->instances || string_is_glob(rule->pattern))
+                        continue;
+
+                r = hashmap_ensure_put(&ps.literal_rules, &string_hash_ops, rule->pattern, SIZE_TO_PTR(i + 1));
+                if (r == -EEXIST)
+                        continue;
+                if (r < 0)
+                        return r;
+
+                rule->indexed = true;
+        }
+
         ps.initialized = true;
         *presets = ps;
         ps = (UnitFilePresets){};
@@ -3087,16 +3421,29 @@ static int pattern_match_multiple_instances(
 
 static int query_presets(const char *name, const UnitFilePresets *presets, char ***instance_name_list) {
         PresetAction action = PRESET_UNKNOWN;
+        size_t n;
+        void *p;
 
         if (!unit_name_is_valid(name, UNIT_NAME_ANY))
                 return -EINVAL;
 
-        for (size_t i = 0; i < presets->n_rules; i++)
+        /* If there's a rule for exactly this name, only the rules before it need to be tried */
+        p = hashmap_get(presets->literal_rules, name);
+        n = p ? PTR_TO_SIZE(p) - 1 : presets->n_rules;
+
+        for (size_t i = 0; i < n; i++) {
+                if (presets->rules[i].indexed)
+                        continue;
+
                 if (pattern_match_multiple_instances(presets->rules[i], name, instance_name_list) > 0 ||
                     fnmatch(presets->rules[i].pattern, name, FNM_NOESCAPE) == 0) {
                         action = presets->rules[i].action;
                         break;
                 }
+        }
+
+        if (action == PRESET_UNKNOWN && p)
+                action = presets->rules[n].action;
 
         switch (action) {
         case PRESET_UNKNOWN:
@@ -3285,6 +3632,7 @@ int unit_file_preset_all(
         _cleanup_(install_context_done) InstallContext plus = {}, minus = {};
         _cleanup_(lookup_paths_free) LookupPaths paths = {};
         _cleanup_(unit_file_presets_freep) UnitFilePresets presets = {};
+        _cleanup_set_free_ Set *seen = NULL;
         const char *config_path = NULL;
         char **i;
         int r;
@@ -3327,6 +3675,14 @@ int unit_file_preset_all(
                         if (!IN_SET(de->d_type, DT_LNK, DT_REG))
                                 continue;
 
+                        /* The same unit is usually found in more than one search path, but the outcome
+                         * doesn't depend on where we found it, so handle each name only once. */
+                        r = set_put_strdup(&seen, de->d_name);
+                        if (r < 0)
+                                return r;
+                        if (r == 0)
+                                continue;
+
                         /* we don't pass changes[] in, because we want to handle errors on our own */
                         r = preset_prepare_one(scope, &plus, &minus, &paths, de->d_name, &presets, NULL, 0);
                         if (r == -ERFKILL)
@@ -3367,6 +3723,7 @@ int unit_file_get_list(
                 char **patterns) {
 
         _cleanup_(lookup_paths_free) LookupPaths paths = {};
+        _cleanup_hashmap_free_ Hashmap *symlink_cache = NULL;
         char **dirname;
         int r;
 
@@ -3419,7 +3776,7 @@ int unit_file_get_list(
                         if (!f->path)
                                 return -ENOMEM;
 
-                        r = unit_file_lookup_state(scope, &paths, de->d_name, &f->state);
+                        r = unit_file_lookup_state_full(scope, &paths, &symlink_cache, de->d_name, &f->state);
                         if (r < 0)
                                 f->state = UNIT_FILE_BAD;
 
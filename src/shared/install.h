@@ -196,6 +196,7 @@ typedef struct UnitFilePresetRule UnitFilePresetRule;
 typedef struct {
         UnitFilePresetRule *rules;
         size_t n_rules;
+        Hashmap *literal_rules;
         bool initialized;
 } UnitFilePresets;
 
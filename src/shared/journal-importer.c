@@ -280,7 +280,7 @@ static int process_special_field(JournalImporter *imp, char *line) {
         return 0;
 }
 
-int journal_importer_process_data(JournalImporter *imp) {
+static int process_field(JournalImporter *imp) {
         int r;
 
         switch(imp->state) {
@@ -423,6 +423,20 @@ int journal_importer_process_data(JournalImporter *imp) {
         }
 }
 
+int journal_importer_process_data(JournalImporter *imp) {
+        int r;
+
+        assert(imp);
+
+        /* Runs until a full entry is parsed, we run out of data for now, or hit EOF or an error. Returning
+         * for each field instead would mean an event loop iteration in our callers for each of them. */
+        do
+                r = process_field(imp);
+        while (r == 0 && imp->state != IMPORTER_STATE_EOF);
+
+        return r;
+}
+
 int journal_importer_push_data(JournalImporter *imp, const char *data, size_t size) {
         assert(imp);
         assert(imp->state != IMPORTER_STATE_EOF);
@@ -23,6 +23,7 @@
 #include "string-util.h"
 #include "strv.h"
 #include "terminal-util.h"
+#include "unaligned.h"
 #include "user-util.h"
 #include "utf8.h"
 
@@ -1792,6 +1793,159 @@ int json_variant_format(JsonVariant *v, JsonFormatFlags flags, char **ret) {
         return (int) sz - 1;
 }
 
+/* The binary encoding is the subset of CBOR (RFC 8949) that is needed to express JSON: unsigned and negative
+ * integers, text strings, arrays and maps of definite length, doubles, booleans and null. */
+enum {
+        CBOR_MAJOR_UNSIGNED = 0,
+        CBOR_MAJOR_NEGATIVE = 1,
+        CBOR_MAJOR_TEXT     = 3,
+        CBOR_MAJOR_ARRAY    = 4,
+        CBOR_MAJOR_MAP      = 5,
+        CBOR_MAJOR_SIMPLE   = 7,
+};
+
+enum {
+        CBOR_FALSE  = 20,
+        CBOR_TRUE   = 21,
+        CBOR_NULL   = 22,
+        CBOR_DOUBLE = 27,
+};
+
+static int cbor_append_head(uint8_t **buf, size_t *allocated, size_t *size, unsigned major, uint64_t value) {
+        uint8_t *p;
+
+        assert(buf);
+        assert(allocated);
+        assert(size);
+
+        if (!GREEDY_REALLOC(*buf, *allocated, *size + 9))
+                return -ENOMEM;
+
+        p = *buf + *size;
+
+        if (value < 24) {
+                p[0] = major << 5 | value;
+                *size += 1;
+        } else if (value <= UINT8_MAX) {
+                p[0] = major << 5 | 24;
+                p[1] = value;
+                *size += 2;
+        } else if (value <= UINT16_MAX) {
+                p[0] = major << 5 | 25;
+                unaligned_write_be16(p + 1, value);
+                *size += 3;
+        } else if (value <= UINT32_MAX) {
+                p[0] = major << 5 | 26;
+                unaligned_write_be32(p + 1, value);
+                *size += 5;
+        } else {
+                p[0] = major << 5 | 27;
+                unaligned_write_be64(p + 1, value);
+                *size += 9;
+        }
+
+        return 0;
+}
+
+static int json_variant_format_binary_one(JsonVariant *v, uint8_t **buf, size_t *allocated, size_t *size) {
+        int r;
+
+        switch (json_variant_type(v)) {
+
+        case JSON_VARIANT_NULL:
+                return cbor_append_head(buf, allocated, size, CBOR_MAJOR_SIMPLE, CBOR_NULL);
+
+        case JSON_VARIANT_BOOLEAN:
+                return cbor_append_head(buf, allocated, size, CBOR_MAJOR_SIMPLE, json_variant_boolean(v) ? CBOR_TRUE : CBOR_FALSE);
+
+        case JSON_VARIANT_INTEGER: {
+                intmax_t i = json_variant_integer(v);
+
+                if (i >= 0)
+                        return cbor_append_head(buf, allocated, size, CBOR_MAJOR_UNSIGNED, (uint64_t) i);
+
+                return cbor_append_head(buf, allocated, size, CBOR_MAJOR_NEGATIVE, (uint64_t) -(i + 1));
+        }
+
+        case JSON_VARIANT_UNSIGNED:
+                return cbor_append_head(buf, allocated, size, CBOR_MAJOR_UNSIGNED, json_variant_unsigned(v));
+
+        case JSON_VARIANT_REAL: {
+                union {
+                        double d;
+                        uint64_t u;
+                } x = {
+                        .d = (double) json_variant_real(v),
+                };
+
+                /* Note that this loses precision on archs where long double is wider than double */
+                if (!GREEDY_REALLOC(*buf, *allocated, *size + 9))
+                        return -ENOMEM;
+
+                (*buf)[*size] = CBOR_MAJOR_SIMPLE << 5 | CBOR_DOUBLE;
+                unaligned_write_be64(*buf + *size + 1, x.u);
+                *size += 9;
+                return 0;
+        }
+
+        case JSON_VARIANT_STRING: {
+                const char *s = json_variant_string(v);
+                size_t n = strlen(s);
+
+                r = cbor_append_head(buf, allocated, size, CBOR_MAJOR_TEXT, n);
+                if (r < 0)
+                        return r;
+
+                if (!GREEDY_REALLOC(*buf, *allocated, *size + n))
+                        return -ENOMEM;
+
+                memcpy_safe(*buf + *size, s, n);
+                *size += n;
+                return 0;
+        }
+
+        case JSON_VARIANT_ARRAY:
+        case JSON_VARIANT_OBJECT: {
+                size_t n = json_variant_elements(v);
+
+                r = cbor_append_head(buf, allocated, size,
+                                     json_variant_is_object(v) ? CBOR_MAJOR_MAP : CBOR_MAJOR_ARRAY,
+                                     json_variant_is_object(v) ? n / 2 : n);
+                if (r < 0)
+                        return r;
+
+                for (size_t i = 0; i < n; i++) {
+                        r = json_variant_format_binary_one(json_variant_by_index(v, i), buf, allocated, size);
+                        if (r < 0)
+                                return r;
+                }
+
+                return 0;
+        }
+
+        default:
+                assert_not_reached("Unexpected variant type.");
+        }
+}
+
+int json_variant_format_binary(JsonVariant *v, void **ret, size_t *ret_size) {
+        _cleanup_free_ uint8_t *buf = NULL;
+        size_t allocated = 0, size = 0;
+        int r;
+
+        assert_return(v, -EINVAL);
+        assert_return(ret, -EINVAL);
+        assert_return(ret_size, -EINVAL);
+
+        r = json_variant_format_binary_one(v, &buf, &allocated, &size);
+        if (r < 0)
+                return r;
+
+        *ret = TAKE_PTR(buf);
+        *ret_size = size;
+        return 0;
+}
+
 void json_variant_dump(JsonVariant *v, JsonFormatFlags flags, FILE *f, const char *prefix) {
         if (!v)
                 return;
@@ -2397,6 +2551,11 @@ static int unhex_ucs2(const char *c, uint16_t *ret) {
         return 0;
 }
 
+static inline bool json_char_is_verbatim(char c) {
+        /* Printable ASCII, except for the characters that terminate or escape a string */
+        return c >= ' ' && c < 0x7f && !IN_SET(c, '"', '\\');
+}
+
 static int json_parse_string(const char **p, char **ret) {
         _cleanup_free_ char *s = NULL;
         size_t n = 0, allocated = 0;
@@ -2414,8 +2573,36 @@ static int json_parse_string(const char **p, char **ret) {
         c++;
 
         for (;;) {
+                const char *run = c;
                 int len;
 
+                /* Consume the longest stretch of characters that is copied verbatim, so that it can be appended
+                 * with a single allocation and copy, instead of one per character. Printable ASCII is checked
+                 * inline, only everything above that needs UTF-8 validation. */
+                for (;;) {
+                        if (json_char_is_verbatim(*c)) {
+                                c++;
+                                continue;
+                        }
+
+                        if ((uint8_t) *c < 0x80)
+                                break;
+
+                        len = utf8_encoded_valid_unichar(c, SIZE_MAX);
+                        if (len < 0)
+                                return len;
+
+                        c += len;
+                }
+
+                if (c > run) {
+                        if (!GREEDY_REALLOC(s, allocated, n + (c - run) + 1))
+                                return -ENOMEM;
+
+                        memcpy(s + n, run, c - run);
+                        n += c - run;
+                }
+
                 /* Check for EOF */
                 if (*c == 0)
                         return -EINVAL;
@@ -2508,16 +2695,7 @@ static int json_parse_string(const char **p, char **ret) {
                         continue;
                 }
 
-                len = utf8_encoded_valid_unichar(c, SIZE_MAX);
-                if (len < 0)
-                        return len;
-
-                if (!GREEDY_REALLOC(s, allocated, n + len + 1))
-                        return -ENOMEM;
-
-                memcpy(s + n, c, len);
-                n += len;
-                c += len;
+                assert_not_reached("Unexpected character in JSON string");
         }
 }
 
@@ -3227,6 +3405,179 @@ int json_parse_file_at(FILE *f, int dir_fd, const char *path, JsonParseFlags fla
         return json_parse_internal(&p, source, flags, ret, ret_line, ret_column, false);
 }
 
+static int cbor_read_head(const uint8_t **p, const uint8_t *end, unsigned *ret_major, uint64_t *ret_value) {
+        const uint8_t *c;
+        unsigned info;
+        size_t n;
+
+        assert(p);
+        assert(*p);
+        assert(end);
+        assert(ret_major);
+        assert(ret_value);
+
+        c = *p;
+        if (c >= end)
+                return -EBADMSG;
+
+        info = *c & 31;
+
+        if (info < 24) {
+                *ret_major = *c >> 5;
+                *ret_value = info;
+                *p = c + 1;
+                return 0;
+        }
+
+        if (info > 27) /* Indefinite lengths and reserved values are not supported */
+                return -EBADMSG;
+
+        n = 1U << (info - 24);
+        if ((size_t) (end - c) < n + 1)
+                return -EBADMSG;
+
+        *ret_major = *c >> 5;
+        *ret_value = n == 1 ? c[1] :
+                     n == 2 ? unaligned_read_be16(c + 1) :
+                     n == 4 ? unaligned_read_be32(c + 1) :
+                              unaligned_read_be64(c + 1);
+        *p = c + n + 1;
+        return 0;
+}
+
+static int json_parse_binary_one(const uint8_t **p, const uint8_t *end, JsonParseFlags flags, unsigned depth, JsonVariant **ret) {
+        JsonVariant **elements = NULL;
+        const uint8_t *start;
+        size_t n_elements = 0;
+        unsigned major;
+        uint64_t value;
+        int r;
+
+        assert(p);
+        assert(end);
+        assert(ret);
+
+        /* Remember where the head starts, as for simple values its size tells them apart */
+        start = *p;
+
+        r = cbor_read_head(p, end, &major, &value);
+        if (r < 0)
+                return r;
+
+        switch (major) {
+
+        case CBOR_MAJOR_UNSIGNED:
+                return json_variant_new_unsigned(ret, value);
+
+        case CBOR_MAJOR_NEGATIVE:
+                if (value > INTMAX_MAX) /* Like the text parser, fall back to a real for values that don't fit */
+                        return json_variant_new_real(ret, -1.0L - (long double) value);
+
+                return json_variant_new_integer(ret, -1 - (intmax_t) value);
+
+        case CBOR_MAJOR_TEXT:
+                if (value > (uint64_t) (end - *p))
+                        return -EBADMSG;
+
+                r = json_variant_new_stringn(ret, (const char*) *p, value);
+                if (r < 0)
+                        return r;
+
+                *p += value;
+                return 0;
+
+        case CBOR_MAJOR_ARRAY:
+        case CBOR_MAJOR_MAP:
+                if (depth >= DEPTH_MAX)
+                        return -ELNRNG;
+
+                /* Each element takes at least one byte, refuse lengths that can't possibly be right before
+                 * allocating anything */
+                if (value > (uint64_t) (end - *p) || (major == CBOR_MAJOR_MAP && value * 2 > (uint64_t) (end - *p)))
+                        return -EBADMSG;
+
+                n_elements = major == CBOR_MAJOR_MAP ? value * 2 : value;
+                if (n_elements == 0)
+                        return major == CBOR_MAJOR_MAP ? json_variant_new_object(ret, NULL, 0) : json_variant_new_array(ret, NULL, 0);
+
+                elements = new0(JsonVariant*, n_elements);
+                if (!elements)
+                        return -ENOMEM;
+
+                for (size_t i = 0; i < n_elements; i++) {
+                        r = json_parse_binary_one(p, end, flags, depth + 1, elements + i);
+                        if (r < 0)
+                                goto finish;
+
+                        /* Mark variants sensitive right away, like the text parser does */
+                        if (FLAGS_SET(flags, JSON_PARSE_SENSITIVE))
+                                json_variant_sensitive(elements[i]);
+
+                        if (major == CBOR_MAJOR_MAP && i % 2 == 0 && !json_variant_is_string(elements[i])) {
+                                r = -EBADMSG;
+                                goto finish;
+                        }
+                }
+
+                if (major == CBOR_MAJOR_MAP)
+                        r = json_variant_new_object(ret, elements, n_elements);
+                else
+                        r = json_variant_new_array(ret, elements, n_elements);
+
+        finish:
+                json_variant_unref_many(elements, n_elements);
+                free(elements);
+                return r;
+
+        case CBOR_MAJOR_SIMPLE:
+                if (*p - start == 1 && value == CBOR_NULL)
+                        return json_variant_new_null(ret);
+                if (*p - start == 1 && IN_SET(value, CBOR_FALSE, CBOR_TRUE))
+                        return json_variant_new_boolean(ret, value == CBOR_TRUE);
+                if (*start == (CBOR_MAJOR_SIMPLE << 5 | CBOR_DOUBLE)) {
+                        union {
+                                double d;
+                                uint64_t u;
+                        } x = {
+                                .u = value,
+                        };
+
+                        return json_variant_new_real(ret, x.d);
+                }
+
+                return -EBADMSG;
+
+        default: /* Byte strings and tags have no JSON equivalent */
+                return -EBADMSG;
+        }
+}
+
+int json_parse_binary(const void *data, size_t size, JsonParseFlags flags, JsonVariant **ret) {
+        _cleanup_(json_variant_unrefp) JsonVariant *v = NULL;
+        const uint8_t *p;
+        int r;
+
+        assert_return(data || size == 0, -EINVAL);
+        assert_return(ret, -EINVAL);
+
+        if (size == 0)
+                return -EBADMSG;
+
+        p = data;
+        r = json_parse_binary_one(&p, p + size, flags, 0, &v);
+        if (r < 0)
+                return r;
+
+        if (p != (const uint8_t*) data + size) /* Trailing garbage */
+                return -EBADMSG;
+
+        if (FLAGS_SET(flags, JSON_PARSE_SENSITIVE))
+                json_variant_sensitive(v);
+
+        *ret = TAKE_PTR(v);
+        return 0;
+}
+
 int json_buildv(JsonVariant **ret, va_list ap) {
         JsonStack *stack = NULL;
         size_t n_stack = 1, n_stack_allocated = 0, i;
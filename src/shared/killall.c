@@ -4,7 +4,9 @@
 ***/
 
 #include <errno.h>
+#include <poll.h>
 #include <signal.h>
+#include <sys/signalfd.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
@@ -14,6 +16,7 @@
 #include "fd-util.h"
 #include "format-util.h"
 #include "killall.h"
+#include "missing_syscall.h"
 #include "parse-util.h"
 #include "process-util.h"
 #include "set.h"
@@ -99,8 +102,160 @@ static void log_children_no_yet_killed(Set *pids) {
         log_warning("Waiting for process: %s", lst_child + 2);
 }
 
+static int reap_children(Set *pids) {
+        /* Let the kernel inform us about killed children. Most processes will probably be our children,
+         * but some are not (might be our grandchildren instead...). */
+        for (;;) {
+                pid_t pid;
+
+                pid = waitpid(-1, NULL, WNOHANG);
+                if (pid == 0)
+                        return 0;
+                if (pid < 0) {
+                        if (errno == ECHILD)
+                                return 0;
+
+                        return log_error_errno(errno, "waitpid() failed: %m");
+                }
+
+                (void) set_remove(pids, PID_TO_PTR(pid));
+        }
+}
+
+static void remove_dead_processes(Set *pids, Set *unwatched) {
+        void *p;
+
+        /* Explicitly check who might be remaining, who might not be our child. */
+        SET_FOREACH(p, unwatched) {
+
+                /* kill(pid, 0) sends no signal, but it tells us whether the process still exists. */
+                if (kill(PTR_TO_PID(p), 0) == 0)
+                        continue;
+
+                if (errno != ESRCH)
+                        continue;
+
+                set_remove(unwatched, p);
+                set_remove(pids, p);
+        }
+}
+
+static int wait_for_children_pidfd(Set *pids, sigset_t *mask, usec_t timeout) {
+        _cleanup_set_free_ Set *unwatched = NULL;
+        _cleanup_free_ struct pollfd *pollfds = NULL;
+        _cleanup_free_ pid_t *pollfd_pids = NULL;
+        _cleanup_close_ int sfd = -1;
+        usec_t until, date_log_child, n;
+        size_t n_pollfds = 0;
+        void *p;
+        int r;
+
+        assert(mask);
+
+        /* Like wait_for_children() below, but rather than checking every remaining process with kill()
+         * whenever we are woken up, watch them via pidfds, which tell us exactly who is gone. Processes we
+         * cannot get a pidfd for are still checked the old way. The first poll entry is a signalfd for
+         * SIGCHLD, so that we notice when there's something to reap. Returns -EOPNOTSUPP if the signalfd
+         * cannot be set up. */
+
+        sfd = signalfd(-1, mask, SFD_NONBLOCK|SFD_CLOEXEC);
+        if (sfd < 0)
+                return log_debug_errno(SYNTHETIC_ERRNO(EOPNOTSUPP), "Failed to allocate signalfd, not using pidfds: %m");
+
+        pollfds = new(struct pollfd, set_size(pids) + 1);
+        pollfd_pids = new(pid_t, set_size(pids) + 1);
+        if (!pollfds || !pollfd_pids)
+                return log_oom();
+
+        pollfds[n_pollfds] = (struct pollfd) { .fd = sfd, .events = POLLIN };
+        pollfd_pids[n_pollfds++] = 0;
+
+        SET_FOREACH(p, pids) {
+                int fd;
+
+                fd = pidfd_open(PTR_TO_PID(p), 0);
+                if (fd < 0) {
+                        if (errno == ESRCH) {
+                                set_remove(pids, p);
+                                continue;
+                        }
+
+                        r = set_ensure_put(&unwatched, NULL, p);
+                        if (r < 0)
+                                log_oom();
+                        continue;
+                }
+
+                pollfds[n_pollfds] = (struct pollfd) { .fd = fd, .events = POLLIN };
+                pollfd_pids[n_pollfds++] = PTR_TO_PID(p);
+        }
+
+        n = now(CLOCK_MONOTONIC);
+        until = usec_add(n, timeout);
+        date_log_child = usec_add(n, 10u * USEC_PER_SEC);
+        if (date_log_child > until)
+                date_log_child = usec_add(n, timeout / 2u);
+
+        for (;;) {
+                struct signalfd_siginfo si;
+                struct timespec ts;
+
+                /* Drain the signalfd, all we care about is that something happened */
+                while (read(sfd, &si, sizeof(si)) > 0)
+                        ;
+
+                r = reap_children(pids);
+                if (r < 0)
+                        goto finish;
+
+                for (size_t i = 1; i < n_pollfds; i++) {
+                        if (pollfds[i].fd < 0 || !(pollfds[i].revents & (POLLIN|POLLHUP|POLLERR)))
+                                continue;
+
+                        (void) set_remove(pids, PID_TO_PTR(pollfd_pids[i]));
+                        pollfds[i].fd = safe_close(pollfds[i].fd);
+                }
+
+                remove_dead_processes(pids, unwatched);
+
+                if (set_isempty(pids)) {
+                        r = 0;
+                        goto finish;
+                }
+
+                n = now(CLOCK_MONOTONIC);
+                if (date_log_child > 0 && n >= date_log_child) {
+                        log_children_no_yet_killed(pids);
+                        /* Log the children not yet killed only once */
+                        date_log_child = 0;
+                }
+
+                if (n >= until) {
+                        r = set_size(pids);
+                        goto finish;
+                }
+
+                if (date_log_child > 0)
+                        timespec_store(&ts, MIN(until - n, date_log_child - n));
+                else
+                        timespec_store(&ts, until - n);
+
+                if (ppoll(pollfds, n_pollfds, &ts, NULL) < 0 && errno != EINTR) {
+                        r = log_error_errno(errno, "ppoll() failed: %m");
+                        goto finish;
+                }
+        }
+
+finish:
+        for (size_t i = 1; i < n_pollfds; i++)
+                safe_close(pollfds[i].fd);
+
+        return r;
+}
+
 static int wait_for_children(Set *pids, sigset_t *mask, usec_t timeout) {
         usec_t until, date_log_child, n;
+        int r;
 
         assert(mask);
 
@@ -110,6 +265,10 @@ static int wait_for_children(Set *pids, sigset_t *mask, usec_t timeout) {
         if (set_isempty(pids))
                 return 0;
 
+        r = wait_for_children_pidfd(pids, mask, timeout);
+        if (r != -EOPNOTSUPP)
+                return r;
+
         n = now(CLOCK_MONOTONIC);
         until = usec_add(n, timeout);
         date_log_child = usec_add(n, 10u * USEC_PER_SEC);
@@ -119,42 +278,12 @@ static int wait_for_children(Set *pids, sigset_t *mask, usec_t timeout) {
         for (;;) {
                 struct timespec ts;
                 int k;
-                void *p;
-
-                /* First, let the kernel inform us about killed
-                 * children. Most processes will probably be our
-                 * children, but some are not (might be our
-                 * grandchildren instead...). */
-                for (;;) {
-                        pid_t pid;
-
-                        pid = waitpid(-1, NULL, WNOHANG);
-                        if (pid == 0)
-                                break;
-                        if (pid < 0) {
-                                if (errno == ECHILD)
-                                        break;
-
-                                return log_error_errno(errno, "waitpid() failed: %m");
-                        }
-
-                        (void) set_remove(pids, PID_TO_PTR(pid));
-                }
 
-                /* Now explicitly check who might be remaining, who
-                 * might not be our child. */
-                SET_FOREACH(p, pids) {
+                r = reap_children(pids);
+                if (r < 0)
+                        return r;
 
-                        /* kill(pid, 0) sends no signal, but it tells
-                         * us whether the process still exists. */
-                        if (kill(PTR_TO_PID(p), 0) == 0)
-                                continue;
-
-                        if (errno != ESRCH)
-                                continue;
-
-                        set_remove(pids, p);
-                }
+                remove_dead_processes(pids, pids);
 
                 if (set_isempty(pids))
                         return 0;
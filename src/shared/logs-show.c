@@ -31,6 +31,8 @@
 #include "parse-util.h"
 #include "pretty-print.h"
 #include "process-util.h"
+#include "random-util.h"
+#include "siphash24.h"
 #include "sparse-endian.h"
 #include "stdio-util.h"
 #include "string-table.h"
@@ -983,6 +985,323 @@ static int update_json_data_split(
         return update_json_data(h, flags, name, eq + 1, size - fieldlen - 1);
 }
 
+/* Scratch space for output_json_stream(), reused for all entries. The fields of an entry are collected first,
+ * since the JSON object has to list all values of a field together, and since the data returned by
+ * sd_journal_enumerate_data() is only valid until the next call. */
+typedef struct JsonStreamField {
+        size_t offset;   /* of the field name in the buffer, directly followed by the value */
+        size_t name_len;
+        size_t size;
+        size_t next;     /* next field with the same name, or SIZE_MAX */
+        size_t last;     /* last field with the same name, only valid for the first one */
+        bool duplicate;  /* not the first field with this name */
+} JsonStreamField;
+
+typedef struct JsonStreamScratch {
+        char *buffer;
+        size_t buffer_size, buffer_allocated;
+
+        JsonStreamField *fields;
+        size_t n_fields, n_fields_allocated;
+
+        size_t *table;   /* open addressing, indexes into fields, SIZE_MAX if unused */
+        size_t table_size;
+
+        uint8_t hash_key[16];
+} JsonStreamScratch;
+
+static thread_local JsonStreamScratch json_stream_scratch = {};
+
+static void json_stream_scratch_reset(JsonStreamScratch *s) {
+        assert(s);
+
+        s->buffer_size = 0;
+        s->n_fields = 0;
+
+        for (size_t i = 0; i < s->table_size; i++)
+                s->table[i] = SIZE_MAX;
+}
+
+static size_t *json_stream_scratch_slot(JsonStreamScratch *s, const char *name, size_t name_len) {
+        size_t i;
+
+        assert(s);
+        assert(s->table_size > 0);
+
+        /* Returns the slot of the table where the specified field name is, or should go */
+
+        i = siphash24(name, name_len, s->hash_key) & (s->table_size - 1);
+        for (;;) {
+                const JsonStreamField *q;
+
+                if (s->table[i] == SIZE_MAX)
+                        return s->table + i;
+
+                q = s->fields + s->table[i];
+                if (q->name_len == name_len && memcmp(s->buffer + q->offset, name, name_len) == 0)
+                        return s->table + i;
+
+                i = (i + 1) & (s->table_size - 1);
+        }
+}
+
+static int json_stream_scratch_grow_table(JsonStreamScratch *s) {
+        size_t *t, n;
+
+        assert(s);
+
+        /* Keeps the table at most half full */
+        if (s->n_fields * 2 < s->table_size)
+                return 0;
+
+        n = MAX(s->table_size * 2, 64U);
+        t = reallocarray(s->table, n, sizeof(size_t));
+        if (!t)
+                return -ENOMEM;
+
+        s->table = t;
+        s->table_size = n;
+
+        for (size_t i = 0; i < n; i++)
+                t[i] = SIZE_MAX;
+
+        for (size_t k = 0; k < s->n_fields; k++)
+                if (!s->fields[k].duplicate)
+                        *json_stream_scratch_slot(s, s->buffer + s->fields[k].offset, s->fields[k].name_len) = k;
+
+        return 0;
+}
+
+static int json_stream_scratch_add(
+                JsonStreamScratch *s,
+                const char *name, size_t name_len,
+                const void *value, size_t size) {
+
+        JsonStreamField *field;
+        size_t *slot;
+        int r;
+
+        assert(s);
+        assert(name);
+        assert(value || size == 0);
+
+        r = json_stream_scratch_grow_table(s);
+        if (r < 0)
+                return r;
+
+        if (!GREEDY_REALLOC(s->fields, s->n_fields_allocated, s->n_fields + 1))
+                return -ENOMEM;
+        if (!GREEDY_REALLOC(s->buffer, s->buffer_allocated, s->buffer_size + name_len + size))
+                return -ENOMEM;
+
+        field = s->fields + s->n_fields;
+        *field = (JsonStreamField) {
+                .offset = s->buffer_size,
+                .name_len = name_len,
+                .size = size,
+                .next = SIZE_MAX,
+                .last = s->n_fields,
+        };
+
+        memcpy(mempcpy(s->buffer + s->buffer_size, name, name_len), value, size);
+        s->buffer_size += name_len + size;
+
+        slot = json_stream_scratch_slot(s, name, name_len);
+        if (*slot == SIZE_MAX)
+                *slot = s->n_fields;
+        else {
+                JsonStreamField *first = s->fields + *slot;
+
+                s->fields[first->last].next = s->n_fields;
+                first->last = s->n_fields;
+                field->duplicate = true;
+        }
+
+        s->n_fields++;
+        return 0;
+}
+
+static void json_stream_string(FILE *f, const char *p, size_t l) {
+        /* Same escaping as json_variant_dump() */
+
+        fputc('"', f);
+
+        for (; l > 0; p++, l--)
+                switch (*p) {
+                case '"':
+                        fputs("\\\"", f);
+                        break;
+
+                case '\\':
+                        fputs("\\\\", f);
+                        break;
+
+                case '\b':
+                        fputs("\\b", f);
+                        break;
+
+                case '\f':
+                        fputs("\\f", f);
+                        break;
+
+                case '\n':
+                        fputs("\\n", f);
+                        break;
+
+                case '\r':
+                        fputs("\\r", f);
+                        break;
+
+                case '\t':
+                        fputs("\\t", f);
+                        break;
+
+                default:
+                        if ((signed char) *p >= 0 && *p < ' ')
+                                fprintf(f, "\\u%04x", *p);
+                        else
+                                fputc(*p, f);
+                        break;
+                }
+
+        fputc('"', f);
+}
+
+static void json_stream_value(FILE *f, OutputFlags flags, const JsonStreamScratch *s, const JsonStreamField *field) {
+        const char *value = s->buffer + field->offset + field->name_len;
+
+        /* Same representation as update_json_data() */
+
+        if (!(flags & OUTPUT_SHOW_ALL) && field->name_len + 1 + field->size >= JSON_THRESHOLD)
+                fputs("null", f);
+        else if (utf8_is_printable(value, field->size))
+                json_stream_string(f, value, field->size);
+        else {
+                fputc('[', f);
+                for (size_t i = 0; i < field->size; i++)
+                        fprintf(f, i > 0 ? ",%u" : "%u", (uint8_t) value[i]);
+                fputc(']', f);
+        }
+}
+
+static int output_json_stream(
+                FILE *f,
+                sd_journal *j,
+                OutputMode mode,
+                OutputFlags flags,
+                const Set *output_fields,
+                const char *cursor,
+                uint64_t realtime,
+                uint64_t monotonic,
+                sd_id128_t boot_id) {
+
+        JsonStreamScratch *s = &json_stream_scratch;
+        char sid[SD_ID128_STRING_MAX], usecbuf[DECIMAL_STR_MAX(usec_t)];
+        bool first = true;
+        int r;
+
+        assert(f);
+        assert(j);
+        assert(cursor);
+
+        /* Writes the same as output_json() in the compact formats, straight from the journal data, without
+         * building a JsonVariant object first. Fields are listed in the order they first appear in. */
+
+        if (s->table_size == 0)
+                random_bytes(s->hash_key, sizeof(s->hash_key));
+
+        json_stream_scratch_reset(s);
+
+#define ADD_META(name, value) json_stream_scratch_add(s, name, STRLEN(name), value, strlen(value))
+
+        r = ADD_META("__CURSOR", cursor);
+        if (r >= 0) {
+                xsprintf(usecbuf, USEC_FMT, realtime);
+                r = ADD_META("__REALTIME_TIMESTAMP", usecbuf);
+        }
+        if (r >= 0) {
+                xsprintf(usecbuf, USEC_FMT, monotonic);
+                r = ADD_META("__MONOTONIC_TIMESTAMP", usecbuf);
+        }
+        if (r >= 0)
+                r = ADD_META("_BOOT_ID", sd_id128_to_string(boot_id, sid));
+        if (r < 0)
+                return log_oom();
+
+#undef ADD_META
+
+        for (;;) {
+                const void *data;
+                const char *eq;
+                size_t size, fieldlen;
+
+                r = sd_journal_enumerate_data(j, &data, &size);
+                if (r == -EBADMSG) {
+                        log_debug_errno(r, "Skipping message we can't read: %m");
+                        return 0;
+                }
+                if (r < 0)
+                        return log_error_errno(r, "Failed to read journal: %m");
+                if (r == 0)
+                        break;
+
+                if (memory_startswith(data, size, "_BOOT_ID="))
+                        continue;
+
+                eq = memchr(data, '=', MIN(size, JSON_THRESHOLD));
+                if (!eq)
+                        continue;
+
+                fieldlen = eq - (const char*) data;
+                if (!journal_field_valid(data, fieldlen, true))
+                        return log_error_errno(SYNTHETIC_ERRNO(EINVAL), "Invalid field.");
+
+                if (output_fields && !set_contains(output_fields, strndupa(data, fieldlen)))
+                        continue;
+
+                r = json_stream_scratch_add(s, data, fieldlen, eq + 1, size - fieldlen - 1);
+                if (r < 0)
+                        return log_oom();
+        }
+
+        if (mode == OUTPUT_JSON_SSE)
+                fputs("data: ", f);
+        else if (mode == OUTPUT_JSON_SEQ)
+                fputc('\x1e', f); /* ASCII Record Separator */
+
+        fputc('{', f);
+
+        for (size_t i = 0; i < s->n_fields; i++) {
+                const JsonStreamField *field = s->fields + i;
+
+                if (field->duplicate)
+                        continue;
+
+                if (!first)
+                        fputc(',', f);
+                first = false;
+
+                json_stream_string(f, s->buffer + field->offset, field->name_len);
+                fputc(':', f);
+
+                if (field->next == SIZE_MAX)
+                        json_stream_value(f, flags, s, field);
+                else {
+                        fputc('[', f);
+                        for (size_t k = i; k != SIZE_MAX; k = s->fields[k].next) {
+                                if (k != i)
+                                        fputc(',', f);
+                                json_stream_value(f, flags, s, s->fields + k);
+                        }
+                        fputc(']', f);
+                }
+        }
+
+        fputs(mode == OUTPUT_JSON_SSE ? "}\n\n" : "}\n", f);
+
+        return 0;
+}
+
 static int output_json(
                 FILE *f,
                 sd_journal *j,
@@ -1019,6 +1338,10 @@ static int output_json(
         if (r < 0)
                 return log_error_errno(r, "Failed to get cursor: %m");
 
+        /* Pretty printing and colors are left to the JSON code, everything else is encoded directly */
+        if (mode != OUTPUT_JSON_PRETTY && !FLAGS_SET(flags, OUTPUT_COLOR))
+                return output_json_stream(f, j, mode, flags, output_fields, cursor, realtime, monotonic, boot_id);
+
         h = hashmap_new(&string_hash_ops);
         if (!h)
                 return log_oom();
@@ -1607,8 +1930,9 @@ int add_match_this_boot(sd_journal *j, const char *machine) {
         return 0;
 }
 
-int show_journal_by_unit(
+int show_journal_by_unit_full(
                 FILE *f,
+                sd_journal **journal,
                 const char *unit,
                 const char *log_namespace,
                 OutputMode mode,
@@ -1621,19 +1945,38 @@ int show_journal_by_unit(
                 bool system_unit,
                 bool *ellipsized) {
 
-        _cleanup_(sd_journal_closep) sd_journal *j = NULL;
+        _cleanup_(sd_journal_closep) sd_journal *opened = NULL;
+        sd_journal *j;
         int r;
 
         assert(mode >= 0);
         assert(mode < _OUTPUT_MODE_MAX);
         assert(unit);
 
+        /* If 'journal' is non-NULL, the journal is opened only once and kept open in it, and later calls
+         * reuse it. This saves callers that show the logs of many units from opening and mapping all
+         * journal files again for each of them. */
+
         if (how_many <= 0)
                 return 0;
 
-        r = sd_journal_open_namespace(&j, log_namespace, journal_open_flags | SD_JOURNAL_INCLUDE_DEFAULT_NAMESPACE);
-        if (r < 0)
-                return log_error_errno(r, "Failed to open journal: %m");
+        if (journal && *journal) {
+                j = *journal;
+
+                sd_journal_flush_matches(j);
+
+                r = sd_journal_seek_head(j);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to seek to head: %m");
+        } else {
+                r = sd_journal_open_namespace(&opened, log_namespace, journal_open_flags | SD_JOURNAL_INCLUDE_DEFAULT_NAMESPACE);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to open journal: %m");
+
+                j = opened;
+                if (journal)
+                        *journal = TAKE_PTR(opened);
+        }
 
         if (system_unit)
                 r = add_matches_for_unit(j, unit);
@@ -43,8 +43,9 @@ int add_matches_for_user_unit(
                 const char *unit,
                 uid_t uid);
 
-int show_journal_by_unit(
+int show_journal_by_unit_full(
                 FILE *f,
+                sd_journal **journal,
                 const char *unit,
                 const char *namespace,
                 OutputMode mode,
@@ -56,6 +57,22 @@ int show_journal_by_unit(
                 int journal_open_flags,
                 bool system_unit,
                 bool *ellipsized);
+static inline int show_journal_by_unit(
+                FILE *f,
+                const char *unit,
+                const char *namespace,
+                OutputMode mode,
+                unsigned n_columns,
+                usec_t not_before,
+                unsigned how_many,
+                uid_t uid,
+                OutputFlags flags,
+                int journal_open_flags,
+                bool system_unit,
+                bool *ellipsized) {
+        return show_journal_by_unit_full(f, NULL, unit, namespace, mode, n_columns, not_before, how_many,
+                                         uid, flags, journal_open_flags, system_unit, ellipsized);
+}
 
 void json_escape(
                 FILE *f,
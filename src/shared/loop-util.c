@@ -18,6 +18,7 @@
 #include "alloc-util.h"
 #include "blockdev-util.h"
 #include "device-util.h"
+#include "env-util.h"
 #include "errno-util.h"
 #include "fd-util.h"
 #include "fileio.h"
@@ -255,6 +256,11 @@ static int loop_configure(
                               random_u64() % (UINT64_C(240) * USEC_PER_MSEC * n_attempts/64));
         }
 
+        /* LOOP_SET_STATUS64 doesn't allow setting the direct I/O flag, there's a separate ioctl for that */
+        if (FLAGS_SET(c->info.lo_flags, LO_FLAGS_DIRECT_IO) &&
+            ioctl(fd, LOOP_SET_DIRECT_IO, 1UL) < 0)
+                log_debug_errno(errno, "Failed to enable direct I/O mode on loopback device /dev/loop%i, ignoring: %m", nr);
+
         return 0;
 
 fail:
@@ -309,6 +315,7 @@ int loop_device_make(
                 LoopDevice **ret) {
 
         _cleanup_free_ char *loopdev = NULL;
+        _cleanup_close_ int direct_io_fd = -1;
         bool try_loop_configure = true;
         struct loop_config config;
         LoopDevice *d = NULL;
@@ -362,6 +369,18 @@ int loop_device_make(
                 r = stat_verify_regular(&st);
                 if (r < 0)
                         return r;
+
+                if (FLAGS_SET(loop_flags, LO_FLAGS_DIRECT_IO)) {
+                        /* The kernel only does direct I/O on the backing file if it is opened with O_DIRECT.
+                         * This avoids caching every block twice, once for the loopback device and once for
+                         * the backing file. If the file system doesn't support that, use buffered I/O. */
+                        direct_io_fd = fd_reopen(fd, open_flags|O_CLOEXEC|O_NONBLOCK|O_NOCTTY|O_DIRECT);
+                        if (direct_io_fd < 0) {
+                                log_debug_errno(direct_io_fd, "Failed to reopen file with O_DIRECT, using buffered I/O: %m");
+                                loop_flags &= ~LO_FLAGS_DIRECT_IO;
+                        } else
+                                fd = direct_io_fd;
+                }
         }
 
         _cleanup_close_ int control = -1;
@@ -465,6 +484,13 @@ int loop_device_make_by_path(const char *path, int open_flags, uint32_t loop_fla
         } else if (open_flags < 0)
                 open_flags = O_RDWR;
 
+        /* Use direct I/O for image files unless turned off explicitly */
+        r = getenv_bool("SYSTEMD_LOOP_DIRECT_IO");
+        if (r < 0 && r != -ENXIO)
+                log_debug_errno(r, "Failed to parse $SYSTEMD_LOOP_DIRECT_IO, ignoring: %m");
+        if (r != 0)
+                loop_flags |= LO_FLAGS_DIRECT_IO;
+
         return loop_device_make(fd, open_flags, 0, 0, loop_flags, ret);
 }
 
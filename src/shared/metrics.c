@@ -0,0 +1,128 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include "metrics.h"
+#include "string-table.h"
+
+void metric_histogram_record(MetricHistogram *h, usec_t d) {
+        size_t i = 0;
+
+        assert(h);
+
+        for (usec_t limit = 10; i < METRIC_HISTOGRAM_BUCKETS - 1 && d >= limit; limit *= 10)
+                i++;
+
+        h->buckets[i]++;
+        h->count++;
+        h->sum = usec_add(h->sum, d);
+        h->max = MAX(h->max, d);
+}
+
+int metric_histogram_build_json(const MetricHistogram *h, JsonVariant **ret) {
+        _cleanup_(json_variant_unrefp) JsonVariant *v = NULL;
+        usec_t limit = 10;
+        int r;
+
+        assert(h);
+        assert(ret);
+
+        for (size_t i = 0; i < METRIC_HISTOGRAM_BUCKETS; i++, limit *= 10) {
+                _cleanup_(json_variant_unrefp) JsonVariant *e = NULL;
+                bool last = i == METRIC_HISTOGRAM_BUCKETS - 1;
+
+                r = json_build(&e, JSON_BUILD_OBJECT(
+                                       JSON_BUILD_PAIR_CONDITION(!last, "belowUSec", JSON_BUILD_UNSIGNED(limit)),
+                                       JSON_BUILD_PAIR("count", JSON_BUILD_UNSIGNED(h->buckets[i]))));
+                if (r < 0)
+                        return r;
+
+                r = json_variant_append_array(&v, e);
+                if (r < 0)
+                        return r;
+        }
+
+        *ret = TAKE_PTR(v);
+        return 0;
+}
+
+static int metric_build_json(const Metric *m, JsonVariant **ret) {
+        _cleanup_(json_variant_unrefp) JsonVariant *buckets = NULL;
+        int r;
+
+        assert(m);
+        assert(m->name);
+        assert(ret);
+
+        if (m->type != METRIC_HISTOGRAM)
+                return json_build(ret, JSON_BUILD_OBJECT(
+                                          JSON_BUILD_PAIR("name", JSON_BUILD_STRING(m->name)),
+                                          JSON_BUILD_PAIR("type", JSON_BUILD_STRING(metric_type_to_string(m->type))),
+                                          JSON_BUILD_PAIR_CONDITION(m->description, "description", JSON_BUILD_STRING(m->description)),
+                                          JSON_BUILD_PAIR("value", JSON_BUILD_UNSIGNED(m->value))));
+
+        assert(m->histogram);
+
+        r = metric_histogram_build_json(m->histogram, &buckets);
+        if (r < 0)
+                return r;
+
+        return json_build(ret, JSON_BUILD_OBJECT(
+                                  JSON_BUILD_PAIR("name", JSON_BUILD_STRING(m->name)),
+                                  JSON_BUILD_PAIR("type", JSON_BUILD_STRING(metric_type_to_string(m->type))),
+                                  JSON_BUILD_PAIR_CONDITION(m->description, "description", JSON_BUILD_STRING(m->description)),
+                                  JSON_BUILD_PAIR("count", JSON_BUILD_UNSIGNED(m->histogram->count)),
+                                  JSON_BUILD_PAIR("sumUSec", JSON_BUILD_UNSIGNED(m->histogram->sum)),
+                                  JSON_BUILD_PAIR("maxUSec", JSON_BUILD_UNSIGNED(m->histogram->max)),
+                                  JSON_BUILD_PAIR("buckets", JSON_BUILD_VARIANT(buckets))));
+}
+
+int metrics_build_json(const Metric *metrics, size_t n_metrics, JsonVariant **ret) {
+        _cleanup_(json_variant_unrefp) JsonVariant *array = NULL;
+        int r;
+
+        assert(metrics || n_metrics == 0);
+        assert(ret);
+
+        for (size_t i = 0; i < n_metrics; i++) {
+                _cleanup_(json_variant_unrefp) JsonVariant *e = NULL;
+
+                r = metric_build_json(metrics + i, &e);
+                if (r < 0)
+                        return r;
+
+                r = json_variant_append_array(&array, e);
+                if (r < 0)
+                        return r;
+        }
+
+        if (!array) {
+                r = json_variant_new_array(&array, NULL, 0);
+                if (r < 0)
+                        return r;
+        }
+
+        return json_build(ret, JSON_BUILD_OBJECT(JSON_BUILD_PAIR("metrics", JSON_BUILD_VARIANT(array))));
+}
+
+int varlink_reply_metrics(Varlink *link, JsonVariant *parameters, const Metric *metrics, size_t n_metrics) {
+        _cleanup_(json_variant_unrefp) JsonVariant *v = NULL;
+        int r;
+
+        assert(link);
+
+        if (json_variant_elements(parameters) > 0)
+                return varlink_error_invalid_parameter(link, parameters);
+
+        r = metrics_build_json(metrics, n_metrics, &v);
+        if (r < 0)
+                return r;
+
+        return varlink_reply(link, v);
+}
+
+static const char* const metric_type_table[_METRIC_TYPE_MAX] = {
+        [METRIC_COUNTER]   = "counter",
+        [METRIC_GAUGE]     = "gauge",
+        [METRIC_HISTOGRAM] = "histogram",
+};
+
+DEFINE_STRING_TABLE_LOOKUP(metric_type, MetricType);
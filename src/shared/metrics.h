@@ -0,0 +1,64 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+#pragma once
+
+#include <errno.h>
+#include <inttypes.h>
+
+#include "json.h"
+#include "macro.h"
+#include "time-util.h"
+#include "varlink.h"
+
+/* A common way for daemons to expose live performance data, via the io.systemd.Metrics.List() varlink
+ * method on their existing varlink sockets, so that one scraper covers all of them.
+ *
+ * Daemons keep their counters wherever they like (usually plain integers in their manager object, our
+ * daemons are single threaded), and only describe them as an array of Metric when asked. Only latency
+ * histograms need a data structure of their own, see MetricHistogram below. */
+
+typedef enum MetricType {
+        METRIC_COUNTER,   /* monotonically increasing */
+        METRIC_GAUGE,     /* current value, may go up and down */
+        METRIC_HISTOGRAM, /* distribution of durations */
+        _METRIC_TYPE_MAX,
+        _METRIC_TYPE_INVALID = -EINVAL,
+} MetricType;
+
+/* Latency histograms have one bucket per decade, the first one for durations below 10µs, the last one for
+ * everything from 1s on. */
+#define METRIC_HISTOGRAM_BUCKETS 7
+
+typedef struct MetricHistogram {
+        uint64_t buckets[METRIC_HISTOGRAM_BUCKETS];
+        uint64_t count;
+        usec_t sum;
+        usec_t max;
+} MetricHistogram;
+
+typedef struct Metric {
+        const char *name;
+        const char *description;
+        MetricType type;
+        union {
+                uint64_t value;
+                const MetricHistogram *histogram;
+        };
+} Metric;
+
+#define METRIC_COUNTER_MAKE(n, d, v)                                    \
+        (Metric) { .name = (n), .description = (d), .type = METRIC_COUNTER, .value = (v) }
+#define METRIC_GAUGE_MAKE(n, d, v)                                      \
+        (Metric) { .name = (n), .description = (d), .type = METRIC_GAUGE, .value = (v) }
+#define METRIC_HISTOGRAM_MAKE(n, d, h)                                  \
+        (Metric) { .name = (n), .description = (d), .type = METRIC_HISTOGRAM, .histogram = (h) }
+
+void metric_histogram_record(MetricHistogram *h, usec_t d);
+int metric_histogram_build_json(const MetricHistogram *h, JsonVariant **ret);
+
+int metrics_build_json(const Metric *metrics, size_t n_metrics, JsonVariant **ret);
+
+/* To be called from a daemon's io.systemd.Metrics.List() method implementation */
+int varlink_reply_metrics(Varlink *link, JsonVariant *parameters, const Metric *metrics, size_t n_metrics);
+
+const char* metric_type_to_string(MetricType t) _const_;
+MetricType metric_type_from_string(const char *s) _pure_;
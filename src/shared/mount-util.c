@@ -4,6 +4,7 @@
 #include <linux/loop.h>
 #include <stdlib.h>
 #include <sys/mount.h>
+#include <sys/prctl.h>
 #include <sys/stat.h>
 #include <sys/statvfs.h>
 #include <unistd.h>
@@ -16,6 +17,7 @@
 #include "fs-util.h"
 #include "hashmap.h"
 #include "libmount-util.h"
+#include "missing_syscall.h"
 #include "mkdir.h"
 #include "mount-util.h"
 #include "mountpoint-util.h"
@@ -23,6 +25,7 @@
 #include "parse-util.h"
 #include "path-util.h"
 #include "process-util.h"
+#include "raw-clone.h"
 #include "set.h"
 #include "stat-util.h"
 #include "stdio-util.h"
@@ -986,3 +989,91 @@ int mount_image_in_namespace(
 
         return mount_in_namespace(target, propagate_path, incoming_path, src, dest, read_only, make_file_or_directory, options, true);
 }
+
+static int make_userns(uid_t uid_shift, uid_t uid_range, RemountIdmapFlags flags) {
+        char line[DECIMAL_STR_MAX(uid_t)*6+6+2+1];
+        _cleanup_(sigkill_waitp) pid_t pid = 0;
+        _cleanup_close_ int userns_fd = -1;
+        const char *p;
+        int r;
+
+        /* Allocates a user namespace file descriptor with the mapping we need. For this we clone off a child
+         * process into a new user namespace, whose only purpose is to keep it alive until we opened it. It's
+         * killed once we have it. */
+
+        pid = raw_clone(SIGCHLD|CLONE_NEWUSER);
+        if (pid < 0)
+                return log_debug_errno(errno, "Failed to allocate user namespace: %m");
+        if (pid == 0) {
+                /* Child. Don't touch anything, just wait until we get killed. */
+                (void) prctl(PR_SET_PDEATHSIG, SIGKILL);
+                for (;;)
+                        pause();
+        }
+
+        if (FLAGS_SET(flags, REMOUNT_IDMAP_HOST_ROOT))
+                xsprintf(line,
+                         UID_FMT " " UID_FMT " " UID_FMT "\n"
+                         UID_FMT " " UID_FMT " " UID_FMT "\n",
+                         0, uid_shift, uid_range,
+                         UID_MAPPED_ROOT, 0, 1);
+        else
+                xsprintf(line, UID_FMT " " UID_FMT " " UID_FMT "\n", 0, uid_shift, uid_range);
+
+        p = procfs_file_alloca(pid, "uid_map");
+        r = write_string_file(p, line, WRITE_STRING_FILE_DISABLE_BUFFER);
+        if (r < 0)
+                return log_debug_errno(r, "Failed to write UID map: %m");
+
+        /* We always assign the same UID and GID ranges */
+        p = procfs_file_alloca(pid, "gid_map");
+        r = write_string_file(p, line, WRITE_STRING_FILE_DISABLE_BUFFER);
+        if (r < 0)
+                return log_debug_errno(r, "Failed to write GID map: %m");
+
+        r = namespace_open(pid, NULL, NULL, NULL, &userns_fd, NULL);
+        if (r < 0)
+                return log_debug_errno(r, "Failed to open user namespace: %m");
+
+        return TAKE_FD(userns_fd);
+}
+
+int remount_idmap(const char *p, uid_t uid_shift, uid_t uid_range, RemountIdmapFlags flags) {
+        _cleanup_close_ int mount_fd = -1, userns_fd = -1;
+
+        assert(p);
+
+        /* Overmounts the mount at 'p' with an ID mapped clone of itself, so that files owned by UIDs/GIDs
+         * 0…uid_range-1 on disk appear as owned by uid_shift…uid_shift+uid_range-1. This is O(1), unlike
+         * chown()ing the whole tree. Note that only the mount itself is mapped, not its submounts. The
+         * original mount stays in place below the new one, so that nothing is lost if we fail half-way. */
+
+        if (uid_range <= 0 || uid_shift > UID_INVALID - uid_range)
+                return -EINVAL;
+        if (FLAGS_SET(flags, REMOUNT_IDMAP_HOST_ROOT) && uid_range > UID_MAPPED_ROOT)
+                return -EINVAL;
+
+        /* Clone the mount point */
+        mount_fd = open_tree(AT_FDCWD, p, OPEN_TREE_CLONE|OPEN_TREE_CLOEXEC);
+        if (mount_fd < 0)
+                return log_debug_errno(errno, "Failed to open tree of mounted file system '%s': %m", p);
+
+        /* Create a user namespace mapping */
+        userns_fd = make_userns(uid_shift, uid_range, flags);
+        if (userns_fd < 0)
+                return userns_fd;
+
+        /* Set the user namespace mapping attribute on the cloned mount point */
+        if (mount_setattr(mount_fd, "", AT_EMPTY_PATH,
+                          &(struct mount_attr) {
+                                  .attr_set = MOUNT_ATTR_IDMAP,
+                                  .userns_fd = userns_fd,
+                          }, MOUNT_ATTR_SIZE_VER0) < 0)
+                return log_debug_errno(errno, "Failed to set up ID mapping on mount of '%s': %m", p);
+
+        /* And place the cloned version on top */
+        if (move_mount(mount_fd, "", AT_FDCWD, p, MOVE_MOUNT_F_EMPTY_PATH) < 0)
+                return log_debug_errno(errno, "Failed to attach ID mapped mount to '%s': %m", p);
+
+        return 0;
+}
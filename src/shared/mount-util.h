@@ -101,3 +101,16 @@ DEFINE_TRIVIAL_CLEANUP_FUNC(char*, umount_and_rmdir_and_free);
 
 int bind_mount_in_namespace(pid_t target, const char *propagate_path, const char *incoming_path, const char *src, const char *dest, bool read_only, bool make_file_or_directory);
 int mount_image_in_namespace(pid_t target, const char *propagate_path, const char *incoming_path, const char *src, const char *dest, bool read_only, bool make_file_or_directory, const MountOptions *options);
+
+/* Files created by the host's root user on ID mapped mounts with REMOUNT_IDMAP_HOST_ROOT end up owned by this
+ * UID/GID on disk */
+#define UID_MAPPED_ROOT ((uid_t) (INT32_MAX-1))
+
+typedef enum RemountIdmapFlags {
+        /* Also map UID_MAPPED_ROOT on disk to the host's root user. Without this the host's root user
+         * cannot create inodes on the ID mapped mount, as it has no UID there, and attempts are refused
+         * with EOVERFLOW. */
+        REMOUNT_IDMAP_HOST_ROOT = 1 << 0,
+} RemountIdmapFlags;
+
+int remount_idmap(const char *p, uid_t uid_shift, uid_t uid_range, RemountIdmapFlags flags);
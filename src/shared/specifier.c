@@ -18,6 +18,7 @@
 #include "specifier.h"
 #include "string-util.h"
 #include "strv.h"
+#include "strxcpyx.h"
 #include "user-util.h"
 
 /*
@@ -40,6 +41,17 @@ int specifier_printf(const char *text, const Specifier table[], const void *user
         assert(text);
         assert(table);
 
+        /* Most strings we are called for (e.g. ExecStart= lines of template instances) contain no specifiers
+         * at all, hence shortcut this and avoid the walk and the allocation dance below. */
+        if (!strchr(text, '%')) {
+                ret = strdup(text);
+                if (!ret)
+                        return -ENOMEM;
+
+                *_ret = TAKE_PTR(ret);
+                return 0;
+        }
+
         l = strlen(text);
         if (!GREEDY_REALLOC(ret, allocated, l + 1))
                 return -ENOMEM;
@@ -172,15 +184,20 @@ int specifier_short_host_name(char specifier, const void *data, const void *user
 }
 
 int specifier_kernel_release(char specifier, const void *data, const void *userdata, char **ret) {
-        struct utsname uts;
+        static thread_local char cached[sizeof_field(struct utsname, release)] = {};
         char *n;
-        int r;
 
-        r = uname(&uts);
-        if (r < 0)
-                return -errno;
+        /* The kernel release cannot change while we are running, hence query it only once */
+        if (cached[0] == 0) {
+                struct utsname uts;
+
+                if (uname(&uts) < 0)
+                        return -errno;
+
+                strscpy(cached, sizeof(cached), uts.release);
+        }
 
-        n = strdup(uts.release);
+        n = strdup(cached);
         if (!n)
                 return -ENOMEM;
 
@@ -35,6 +35,7 @@ struct UserDBIterator {
         bool nss_systemd_blocked:1;
         int error;
         unsigned n_found;
+        usec_t query_begin_usec;                  /* CLOCK_MONOTONIC, when the queries were sent out */
         sd_event *event;
         UserRecord *found_user;                   /* when .what == LOOKUP_USER */
         GroupRecord *found_group;                 /* when .what == LOOKUP_GROUP */
@@ -146,6 +147,15 @@ static int userdb_on_query_reply(
 
         assert(iterator);
 
+        if (DEBUG_LOGGING) {
+                char buf[FORMAT_TIMESPAN_MAX];
+
+                /* All queries are sent out at the same time, hence this tells how long each service took */
+                log_debug("Got reply from %s after %s.",
+                          strna(varlink_get_description(link)),
+                          format_timespan(buf, sizeof buf, usec_sub_unsigned(now(CLOCK_MONOTONIC), iterator->query_begin_usec), 1));
+        }
+
         if (error_id) {
                 log_debug("Got lookup error: %s", error_id);
 
@@ -371,6 +381,11 @@ static int userdb_connect(
         if (r < 0)
                 return log_debug_errno(r, "Failed to bind reply callback: %m");
 
+        /* Lookups are frequent and records large, hence spare both sides the JSON work if possible */
+        r = varlink_negotiate_binary(vl);
+        if (r < 0)
+                return log_debug_errno(r, "Failed to request binary encoding: %m");
+
         if (more)
                 r = varlink_observe(vl, method, query);
         else
@@ -419,6 +434,8 @@ static int userdb_start_query(
                         return -ENOMEM;
         }
 
+        iterator->query_begin_usec = now(CLOCK_MONOTONIC);
+
         /* First, let's talk to the multiplexer, if we can */
         if ((flags & (USERDB_AVOID_MULTIPLEXER|USERDB_AVOID_DYNAMIC_USER|USERDB_AVOID_NSS|USERDB_DONT_SYNTHESIZE)) == 0 &&
             !strv_contains(except, "io.systemd.Multiplexer") &&
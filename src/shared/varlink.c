@@ -3,11 +3,13 @@
 #include <sys/poll.h>
 
 #include "alloc-util.h"
+#include "env-util.h"
 #include "errno-util.h"
 #include "fd-util.h"
 #include "hashmap.h"
 #include "io-util.h"
 #include "list.h"
+#include "memory-util.h"
 #include "process-util.h"
 #include "selinux-util.h"
 #include "set.h"
@@ -17,6 +19,7 @@
 #include "strv.h"
 #include "time-util.h"
 #include "umask-util.h"
+#include "unaligned.h"
 #include "user-util.h"
 #include "varlink.h"
 
@@ -26,6 +29,14 @@
 #define VARLINK_DEFAULT_TIMEOUT_USEC (45U*USEC_PER_SEC)
 #define VARLINK_BUFFER_MAX (16U*1024U*1024U)
 #define VARLINK_READ_SIZE (64U*1024U)
+#define VARLINK_WRITE_SIZE (64U*1024U)
+
+/* Messages in the binary encoding are prefixed by a marker byte (which can never start a JSON message, as it
+ * is not valid UTF-8), followed by the size of the payload as little endian 32bit integer. */
+#define VARLINK_BINARY_MARKER 0xffU
+#define VARLINK_BINARY_HEADER_SIZE 5U
+
+#define VARLINK_METHOD_SET_ENCODING "io.systemd.Varlink.SetEncoding"
 
 typedef enum VarlinkState {
         /* Client side states */
@@ -135,6 +146,7 @@ struct Varlink {
         bool read_disconnected:1;
         bool prefer_read_write:1;
         bool got_pollhup:1;
+        bool binary:1; /* The peer understands the binary encoding, hence use it for everything we send */
 
         usec_t timestamp;
         usec_t timeout;
@@ -511,25 +523,15 @@ static int varlink_read(Varlink *v) {
 
                 add = MIN(VARLINK_BUFFER_MAX - v->input_buffer_size, VARLINK_READ_SIZE);
 
-                if (v->input_buffer_index == 0) {
-
-                        if (!GREEDY_REALLOC(v->input_buffer, v->input_buffer_allocated, v->input_buffer_size + add))
-                                return -ENOMEM;
-
-                } else {
-                        char *b;
-
-                        b = new(char, v->input_buffer_size + add);
-                        if (!b)
-                                return -ENOMEM;
-
-                        memcpy(b, v->input_buffer + v->input_buffer_index, v->input_buffer_size);
-
-                        free_and_replace(v->input_buffer, b);
-
-                        v->input_buffer_allocated = v->input_buffer_size + add;
+                /* Move what's left of partially consumed data to the front, so that we don't have to grow
+                 * the buffer when a client pipelines many calls */
+                if (v->input_buffer_index > 0) {
+                        memmove(v->input_buffer, v->input_buffer + v->input_buffer_index, v->input_buffer_size);
                         v->input_buffer_index = 0;
                 }
+
+                if (!GREEDY_REALLOC(v->input_buffer, v->input_buffer_allocated, v->input_buffer_size + add))
+                        return -ENOMEM;
         }
 
         rs = v->input_buffer_allocated - (v->input_buffer_index + v->input_buffer_size);
@@ -581,24 +583,61 @@ static int varlink_parse_message(Varlink *v) {
 
         begin = v->input_buffer + v->input_buffer_index;
 
-        e = memchr(begin + v->input_buffer_size - v->input_buffer_unscanned, 0, v->input_buffer_unscanned);
-        if (!e) {
-                v->input_buffer_unscanned = 0;
-                return 0;
-        }
+        if ((uint8_t) begin[0] == VARLINK_BINARY_MARKER) {
+                uint32_t n;
 
-        sz = e - begin + 1;
+                if (v->input_buffer_size < VARLINK_BINARY_HEADER_SIZE) {
+                        v->input_buffer_unscanned = 0;
+                        return 0;
+                }
 
-        varlink_log(v, "New incoming message: %s", begin); /* FIXME: should we output the whole message here before validation?
-                                                            * This may produce a non-printable journal entry if the message
-                                                            * is invalid. We may also expose privileged information. */
+                n = unaligned_read_le32(begin + 1);
+                if (n > VARLINK_BUFFER_MAX - VARLINK_BINARY_HEADER_SIZE) {
+                        v->input_buffer_index = v->input_buffer_size = v->input_buffer_unscanned = 0;
+                        return varlink_log_errno(v, SYNTHETIC_ERRNO(EBADMSG), "Binary message too large, refusing.");
+                }
 
-        r = json_parse(begin, 0, &v->current, NULL, NULL);
-        if (r < 0) {
-                /* If we encounter a parse failure flush all data. We cannot possibly recover from this,
-                 * hence drop all buffered data now. */
-                v->input_buffer_index = v->input_buffer_size = v->input_buffer_unscanned = 0;
-                return varlink_log_errno(v, r, "Failed to parse JSON: %m");
+                sz = VARLINK_BINARY_HEADER_SIZE + n;
+                if (v->input_buffer_size < sz) {
+                        v->input_buffer_unscanned = 0;
+                        return 0;
+                }
+
+                r = json_parse_binary(begin + VARLINK_BINARY_HEADER_SIZE, n, 0, &v->current);
+                if (r < 0) {
+                        v->input_buffer_index = v->input_buffer_size = v->input_buffer_unscanned = 0;
+                        return varlink_log_errno(v, r, "Failed to parse binary message: %m");
+                }
+
+                if (DEBUG_LOGGING) {
+                        _cleanup_free_ char *text = NULL;
+
+                        (void) json_variant_format(v->current, 0, &text);
+                        varlink_log(v, "New incoming binary message: %s", strna(text));
+                }
+
+                /* The peer evidently understands the binary encoding, hence use it for our messages too */
+                v->binary = true;
+        } else {
+                e = memchr(begin + v->input_buffer_size - v->input_buffer_unscanned, 0, v->input_buffer_unscanned);
+                if (!e) {
+                        v->input_buffer_unscanned = 0;
+                        return 0;
+                }
+
+                sz = e - begin + 1;
+
+                varlink_log(v, "New incoming message: %s", begin); /* FIXME: should we output the whole message here before validation?
+                                                                    * This may produce a non-printable journal entry if the message
+                                                                    * is invalid. We may also expose privileged information. */
+
+                r = json_parse(begin, 0, &v->current, NULL, NULL);
+                if (r < 0) {
+                        /* If we encounter a parse failure flush all data. We cannot possibly recover from this,
+                         * hence drop all buffered data now. */
+                        v->input_buffer_index = v->input_buffer_size = v->input_buffer_unscanned = 0;
+                        return varlink_log_errno(v, r, "Failed to parse JSON: %m");
+                }
         }
 
         v->input_buffer_size -= sz;
@@ -783,6 +822,31 @@ invalid:
         return 1;
 }
 
+static int varlink_method_set_encoding(Varlink *v, JsonVariant *parameters, VarlinkMethodFlags flags, void *userdata) {
+        JsonVariant *e;
+
+        assert(v);
+
+        /* This is our own extension to the protocol: the client tells us that it can read messages in the
+         * binary encoding, see varlink_negotiate_binary(). */
+
+        e = json_variant_by_key(parameters, "encoding");
+        if (!e || !json_variant_is_string(e) || !streq(json_variant_string(e), "cbor")) {
+                if (FLAGS_SET(flags, VARLINK_METHOD_ONEWAY))
+                        return -EINVAL;
+
+                return varlink_error_invalid_parameter(v, JSON_VARIANT_STRING_CONST("encoding"));
+        }
+
+        varlink_log(v, "Switching to binary encoding.");
+        v->binary = true;
+
+        if (FLAGS_SET(flags, VARLINK_METHOD_ONEWAY))
+                return 0;
+
+        return varlink_reply(v, NULL);
+}
+
 static int varlink_dispatch_method(Varlink *v) {
         _cleanup_(json_variant_unrefp) JsonVariant *parameters = NULL;
         VarlinkMethodFlags flags = 0;
@@ -866,6 +930,9 @@ static int varlink_dispatch_method(Varlink *v) {
         } else if (startswith(method, "org.varlink.service.")) {
                 callback = NULL;
                 error = VARLINK_ERROR_METHOD_NOT_FOUND;
+        } else if (streq(method, VARLINK_METHOD_SET_ENCODING)) {
+                callback = varlink_method_set_encoding;
+                error = NULL;
         } else {
                 callback = hashmap_get(v->server->methods, method);
                 error = VARLINK_ERROR_METHOD_NOT_FOUND;
@@ -1255,52 +1322,81 @@ Varlink* varlink_flush_close_unref(Varlink *v) {
 }
 
 static int varlink_enqueue_json(Varlink *v, JsonVariant *m) {
-        _cleanup_free_ char *text = NULL;
+        uint8_t header[VARLINK_BINARY_HEADER_SIZE];
+        _cleanup_free_ char *data = NULL;
+        size_t size, header_size = 0;
         int r;
 
         assert(v);
         assert(m);
 
-        r = json_variant_format(m, 0, &text);
-        if (r < 0)
-                return r;
-        assert(text[r] == '\0');
+        if (v->binary) {
+                r = json_variant_format_binary(m, (void**) &data, &size);
+                if (r < 0)
+                        return r;
+                if (size > VARLINK_BUFFER_MAX - VARLINK_BINARY_HEADER_SIZE)
+                        return -ENOBUFS;
 
-        if (v->output_buffer_size + r + 1 > VARLINK_BUFFER_MAX)
-                return -ENOBUFS;
+                header[0] = VARLINK_BINARY_MARKER;
+                unaligned_write_le32(header + 1, size);
+                header_size = sizeof(header);
+        } else {
+                r = json_variant_format(m, 0, &data);
+                if (r < 0)
+                        return r;
+                assert(data[r] == '\0');
+
+                size = r + 1;
+        }
 
-        varlink_log(v, "Sending message: %s", text);
+        /* Servers streaming many replies (e.g. userdb enumerations with "more") may queue more than we are
+         * willing to buffer before getting back to the event loop. Try to make room by writing out what we
+         * have first. Errors are left for the next varlink_process() to pick up. */
+        while (v->output_buffer_size > 0 && v->output_buffer_size + header_size + size > VARLINK_BUFFER_MAX)
+                if (varlink_write(v) <= 0 || v->write_disconnected)
+                        break;
 
-        if (v->output_buffer_size == 0) {
+        if (v->output_buffer_size + header_size + size > VARLINK_BUFFER_MAX)
+                return -ENOBUFS;
 
-                free_and_replace(v->output_buffer, text);
+        if (!v->binary)
+                varlink_log(v, "Sending message: %s", data);
+        else if (DEBUG_LOGGING) {
+                _cleanup_free_ char *text = NULL;
 
-                v->output_buffer_size = v->output_buffer_allocated = r + 1;
-                v->output_buffer_index = 0;
+                (void) json_variant_format(m, 0, &text);
+                varlink_log(v, "Sending binary message: %s", strna(text));
+        }
 
-        } else if (v->output_buffer_index == 0) {
+        if (v->output_buffer_size == 0 && header_size == 0) {
 
-                if (!GREEDY_REALLOC(v->output_buffer, v->output_buffer_allocated, v->output_buffer_size + r + 1))
-                        return -ENOMEM;
+                free_and_replace(v->output_buffer, data);
 
-                memcpy(v->output_buffer + v->output_buffer_size, text, r + 1);
-                v->output_buffer_size += r + 1;
+                v->output_buffer_size = v->output_buffer_allocated = size;
+                v->output_buffer_index = 0;
 
         } else {
-                char *n;
-                const size_t new_size = v->output_buffer_size + r + 1;
+                /* Reuse the space of what has already been written, instead of reallocating and copying
+                 * the whole buffer for each message while the peer is reading slowly */
+                if (v->output_buffer_index > 0 &&
+                    v->output_buffer_index + v->output_buffer_size + header_size + size > v->output_buffer_allocated) {
+                        memmove(v->output_buffer, v->output_buffer + v->output_buffer_index, v->output_buffer_size);
+                        v->output_buffer_index = 0;
+                }
 
-                n = new(char, new_size);
-                if (!n)
+                if (!GREEDY_REALLOC(v->output_buffer, v->output_buffer_allocated, v->output_buffer_index + v->output_buffer_size + header_size + size))
                         return -ENOMEM;
 
-                memcpy(mempcpy(n, v->output_buffer + v->output_buffer_index, v->output_buffer_size), text, r + 1);
-
-                free_and_replace(v->output_buffer, n);
-                v->output_buffer_allocated = v->output_buffer_size = new_size;
-                v->output_buffer_index = 0;
+                memcpy_safe(v->output_buffer + v->output_buffer_index + v->output_buffer_size, header, header_size);
+                memcpy(v->output_buffer + v->output_buffer_index + v->output_buffer_size + header_size, data, size);
+                v->output_buffer_size += header_size + size;
         }
 
+        /* Stream large amounts of queued data out right away rather than waiting until we get back to the
+         * event loop, so that the peer can start processing it, and our buffer stays small. */
+        if (v->output_buffer_size >= VARLINK_WRITE_SIZE)
+                (void) varlink_write(v);
+
         return 0;
 }
 
@@ -1338,6 +1434,30 @@ int varlink_send(Varlink *v, const char *method, JsonVariant *parameters) {
         return 0;
 }
 
+int varlink_negotiate_binary(Varlink *v) {
+        int r;
+
+        assert_return(v, -EINVAL);
+
+        /* Asks the server to send its messages in the compact binary encoding instead of JSON. This is
+         * enqueued as one-way call, so that it is pipelined with the next method call instead of costing a
+         * roundtrip. Servers that don't know about it will ignore it, and the connection keeps using JSON
+         * then. Once the first binary message from the server arrives we switch our own messages over
+         * too. */
+
+        if (v->binary)
+                return 0;
+
+        r = getenv_bool_secure("SYSTEMD_VARLINK_BINARY");
+        if (r == 0)
+                return 0;
+        if (r < 0 && r != -ENXIO)
+                log_debug_errno(r, "Failed to parse $SYSTEMD_VARLINK_BINARY, ignoring: %m");
+
+        return varlink_sendb(v, VARLINK_METHOD_SET_ENCODING,
+                             JSON_BUILD_OBJECT(JSON_BUILD_PAIR("encoding", JSON_BUILD_STRING("cbor"))));
+}
+
 int varlink_sendb(Varlink *v, const char *method, ...) {
         _cleanup_(json_variant_unrefp) JsonVariant *parameters = NULL;
         va_list ap;
@@ -1852,6 +1972,12 @@ int varlink_set_description(Varlink *v, const char *description) {
         return free_and_strdup(&v->description, description);
 }
 
+const char* varlink_get_description(Varlink *v) {
+        assert_return(v, NULL);
+
+        return v->description;
+}
+
 static int io_callback(sd_event_source *s, int fd, uint32_t revents, void *userdata) {
         Varlink *v = userdata;
 
@@ -77,6 +77,9 @@ int varlink_close(Varlink *v);
 Varlink* varlink_flush_close_unref(Varlink *v);
 Varlink* varlink_close_unref(Varlink *v);
 
+/* Ask the server to switch to the binary encoding, if it supports it */
+int varlink_negotiate_binary(Varlink *v);
+
 /* Enqueue method call, not expecting a reply */
 int varlink_send(Varlink *v, const char *method, JsonVariant *parameters);
 int varlink_sendb(Varlink *v, const char *method, ...);
@@ -121,6 +124,7 @@ int varlink_set_relative_timeout(Varlink *v, usec_t usec);
 VarlinkServer* varlink_get_server(Varlink *v);
 
 int varlink_set_description(Varlink *v, const char *d);
+const char* varlink_get_description(Varlink *v);
 
 /* Create a varlink server */
 int varlink_server_new(VarlinkServer **ret, VarlinkServerFlags flags);
@@ -269,6 +269,18 @@ static void sync_with_progress(void) {
         (void) kill(pid, SIGKILL);
 }
 
+static void log_step_duration(const char *step, usec_t start) {
+        char ts[FORMAT_TIMESPAN_MAX];
+        usec_t d;
+
+        assert(step);
+
+        /* Only bother the console with steps that took noticeable time */
+        d = usec_sub_unsigned(now(CLOCK_MONOTONIC), start);
+        log_full(d >= USEC_PER_SEC ? LOG_INFO : LOG_DEBUG,
+                 "%s took %s.", step, format_timespan(ts, sizeof(ts), d, USEC_PER_MSEC));
+}
+
 static int read_current_sysctl_printk_log_level(void) {
         _cleanup_free_ char *sysctl_printk_vals = NULL, *sysctl_printk_curr = NULL;
         int current_lvl;
@@ -408,6 +420,7 @@ int main(int argc, char *argv[]) {
         /* Unmount all mountpoints, swaps, and loopback devices */
         for (;;) {
                 bool changed = false;
+                usec_t start;
 
                 if (use_watchdog)
                         (void) watchdog_ping();
@@ -421,7 +434,9 @@ int main(int argc, char *argv[]) {
 
                 if (need_umount) {
                         log_info("Unmounting file systems.");
+                        start = now(CLOCK_MONOTONIC);
                         r = umount_all(&changed, umount_log_level);
+                        log_step_duration("Unmounting file systems", start);
                         if (r == 0) {
                                 need_umount = false;
                                 log_info("All filesystems unmounted.");
@@ -433,7 +448,9 @@ int main(int argc, char *argv[]) {
 
                 if (need_swapoff) {
                         log_info("Deactivating swaps.");
+                        start = now(CLOCK_MONOTONIC);
                         r = swapoff_all(&changed);
+                        log_step_duration("Deactivating swaps", start);
                         if (r == 0) {
                                 need_swapoff = false;
                                 log_info("All swaps deactivated.");
@@ -445,7 +462,9 @@ int main(int argc, char *argv[]) {
 
                 if (need_loop_detach) {
                         log_info("Detaching loop devices.");
+                        start = now(CLOCK_MONOTONIC);
                         r = loopback_detach_all(&changed, umount_log_level);
+                        log_step_duration("Detaching loop devices", start);
                         if (r == 0) {
                                 need_loop_detach = false;
                                 log_info("All loop devices detached.");
@@ -457,7 +476,9 @@ int main(int argc, char *argv[]) {
 
                 if (need_md_detach) {
                         log_info("Stopping MD devices.");
+                        start = now(CLOCK_MONOTONIC);
                         r = md_detach_all(&changed, umount_log_level);
+                        log_step_duration("Stopping MD devices", start);
                         if (r == 0) {
                                 need_md_detach = false;
                                 log_info("All MD devices stopped.");
@@ -469,7 +490,9 @@ int main(int argc, char *argv[]) {
 
                 if (need_dm_detach) {
                         log_info("Detaching DM devices.");
+                        start = now(CLOCK_MONOTONIC);
                         r = dm_detach_all(&changed, umount_log_level);
+                        log_step_duration("Detaching DM devices", start);
                         if (r == 0) {
                                 need_dm_detach = false;
                                 log_info("All DM devices detached.");
@@ -538,16 +538,24 @@ static int remount_with_timeout(MountPoint *m, int umount_log_level) {
         return r;
 }
 
-static int umount_with_timeout(MountPoint *m, int umount_log_level) {
+/* How many umount operations to run at the same time at most */
+#define UMOUNT_PARALLEL_MAX 16U
+
+typedef struct UmountChild {
+        MountPoint *mount;
         pid_t pid;
-        int r;
+} UmountChild;
 
-        BLOCK_SIGNALS(SIGCHLD);
+static int umount_fork(MountPoint *m, int umount_log_level, pid_t *ret_pid) {
+        pid_t pid;
+        int r;
 
         assert(m);
+        assert(ret_pid);
 
         /* Due to the possibility of a umount operation hanging, we fork a child process and set a
-         * timeout. If the timeout lapses, the assumption is that the particular umount failed. */
+         * timeout. If the timeout lapses, the assumption is that the particular umount failed. The caller
+         * must have blocked SIGCHLD. */
         r = safe_fork("(sd-umount)", FORK_RESET_SIGNALS|FORK_CLOSE_ALL_FDS|FORK_LOG|FORK_REOPEN_LOG, &pid);
         if (r < 0)
                 return r;
@@ -568,28 +576,118 @@ static int umount_with_timeout(MountPoint *m, int umount_log_level) {
                 _exit(r < 0 ? EXIT_FAILURE : EXIT_SUCCESS);
         }
 
-        r = wait_for_terminate_with_timeout(pid, DEFAULT_TIMEOUT_USEC);
-        if (r == -ETIMEDOUT) {
-                log_error_errno(r, "Unmounting '%s' timed out, issuing SIGKILL to PID " PID_FMT ".", m->path, pid);
-                (void) kill(pid, SIGKILL);
-        } else if (r == -EPROTO)
-                log_debug_errno(r, "Unmounting '%s' failed abnormally, child process " PID_FMT " aborted or exited non-zero.", m->path, pid);
-        else if (r < 0)
-                log_error_errno(r, "Unmounting '%s' failed unexpectedly, couldn't wait for child process " PID_FMT ": %m", m->path, pid);
+        *ret_pid = pid;
+        return 0;
+}
 
-        return r;
+static int umount_children_wait(UmountChild *children, size_t *n_children, bool *changed) {
+        size_t n_left;
+        int n_failed = 0;
+        sigset_t mask;
+        usec_t until;
+
+        assert(children || *n_children == 0);
+        assert(n_children);
+        assert(changed);
+
+        /* Waits for all umount children to finish, sharing one timeout among them. Children which hang
+         * beyond that are killed and their umount considered failed. */
+
+        assert_se(sigemptyset(&mask) == 0);
+        assert_se(sigaddset(&mask, SIGCHLD) == 0);
+
+        until = usec_add(now(CLOCK_MONOTONIC), DEFAULT_TIMEOUT_USEC);
+
+        for (n_left = *n_children; n_left > 0;) {
+                struct timespec ts;
+                usec_t n;
+
+                for (size_t i = 0; i < *n_children; i++) {
+                        UmountChild *c = children + i;
+                        siginfo_t status = {};
+
+                        if (c->pid <= 0)
+                                continue;
+
+                        if (waitid(P_PID, c->pid, &status, WEXITED|WNOHANG) < 0) {
+                                log_error_errno(errno, "Unmounting '%s' failed unexpectedly, couldn't wait for child process " PID_FMT ": %m", c->mount->path, c->pid);
+                                n_failed++;
+                        } else if (status.si_pid != c->pid)
+                                continue; /* still running */
+                        else if (status.si_code == CLD_EXITED && status.si_status == 0)
+                                *changed = true;
+                        else {
+                                log_debug("Unmounting '%s' failed abnormally, child process " PID_FMT " aborted or exited non-zero.", c->mount->path, c->pid);
+                                n_failed++;
+                        }
+
+                        c->pid = 0;
+                        n_left--;
+                }
+
+                if (n_left == 0)
+                        break;
+
+                n = now(CLOCK_MONOTONIC);
+                if (n >= until)
+                        break;
+
+                if (sigtimedwait(&mask, NULL, timespec_store(&ts, until - n)) < 0 &&
+                    !IN_SET(errno, EAGAIN, EINTR)) {
+                        log_error_errno(errno, "Failed to wait for umount child processes: %m");
+                        break;
+                }
+        }
+
+        for (size_t i = 0; i < *n_children; i++) {
+                UmountChild *c = children + i;
+
+                if (c->pid <= 0)
+                        continue;
+
+                log_error("Unmounting '%s' timed out, issuing SIGKILL to PID " PID_FMT ".", c->mount->path, c->pid);
+                (void) kill(c->pid, SIGKILL);
+                n_failed++;
+        }
+
+        *n_children = 0;
+        return n_failed;
+}
+
+static bool umount_children_conflict(const UmountChild *children, size_t n_children, const MountPoint *m) {
+        assert(children || n_children == 0);
+        assert(m);
+
+        /* A mount point may only be dealt with once everything mounted below it is gone, and vice versa. */
+        for (size_t i = 0; i < n_children; i++)
+                if (path_startswith(children[i].mount->path, m->path) ||
+                    path_startswith(m->path, children[i].mount->path))
+                        return true;
+
+        return false;
 }
 
 /* This includes remounting readonly, which changes the kernel mount options.  Therefore the list passed to
  * this function is invalidated, and should not be reused. */
 static int mount_points_list_umount(MountPoint **head, bool *changed, int umount_log_level) {
+        UmountChild children[UMOUNT_PARALLEL_MAX];
+        size_t n_children = 0;
         MountPoint *m;
-        int n_failed = 0;
+        int n_failed = 0, r;
+
+        BLOCK_SIGNALS(SIGCHLD);
 
         assert(head);
         assert(changed);
 
+        /* Mounts are listed newest first. Consecutive mounts that are not nested in each other are
+         * unmounted in parallel, everything else is done in order. */
+
         LIST_FOREACH(mount_point, m, *head) {
+                if (n_children >= UMOUNT_PARALLEL_MAX ||
+                    umount_children_conflict(children, n_children, m))
+                        n_failed += umount_children_wait(children, &n_children, changed);
+
                 if (m->try_remount_ro) {
                         /* We always try to remount directories read-only first, before we go on and umount
                          * them.
@@ -619,12 +717,17 @@ static int mount_points_list_umount(MountPoint **head, bool *changed, int umount
                         continue;
 
                 /* Trying to umount */
-                if (umount_with_timeout(m, umount_log_level) < 0)
+                r = umount_fork(m, umount_log_level, &children[n_children].pid);
+                if (r < 0) {
                         n_failed++;
-                else
-                        *changed = true;
+                        continue;
+                }
+
+                children[n_children++].mount = m;
         }
 
+        n_failed += umount_children_wait(children, &n_children, changed);
+
         return n_failed;
 }
 
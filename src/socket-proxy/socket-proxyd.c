@@ -16,6 +16,7 @@
 #include "alloc-util.h"
 #include "errno-util.h"
 #include "fd-util.h"
+#include "format-util.h"
 #include "log.h"
 #include "main-func.h"
 #include "parse-util.h"
@@ -29,10 +30,21 @@
 
 #define BUFFER_SIZE (256 * 1024)
 
+/* How many idle splice pipes to keep around for reuse by later connections */
+#define PIPE_POOL_MAX 64
+
+/* How often to update the STATUS= string at most */
+#define STATUS_UPDATE_USEC (1 * USEC_PER_SEC)
+
 static unsigned arg_connections_max = 256;
 static const char *arg_remote_host = NULL;
 static usec_t arg_exit_idle_time = USEC_INFINITY;
 
+typedef struct PoolPipe {
+        int fds[2];
+        size_t size;
+} PoolPipe;
+
 typedef struct Context {
         sd_event *event;
         sd_resolve *resolve;
@@ -40,6 +52,13 @@ typedef struct Context {
 
         Set *listen;
         Set *connections;
+
+        PoolPipe pipe_pool[PIPE_POOL_MAX];
+        size_t n_pipe_pool;
+
+        uint64_t n_connections_total;
+        uint64_t n_bytes;
+        usec_t status_timestamp;
 } Context;
 
 typedef struct Connection {
@@ -57,6 +76,27 @@ typedef struct Connection {
         sd_resolve_query *resolve_query;
 } Connection;
 
+static void context_release_pipe(Context *context, int buffer[static 2], size_t full, size_t sz) {
+        assert(buffer);
+
+        if (buffer[0] < 0)
+                return;
+
+        /* Only pipes that were fully drained may be reused, we don't want to leak data from one connection
+         * into another */
+        if (context && full == 0 && context->n_pipe_pool < PIPE_POOL_MAX) {
+                context->pipe_pool[context->n_pipe_pool++] = (PoolPipe) {
+                        .fds = { buffer[0], buffer[1] },
+                        .size = sz,
+                };
+
+                buffer[0] = buffer[1] = -1;
+                return;
+        }
+
+        safe_close_pair(buffer);
+}
+
 static void connection_free(Connection *c) {
         assert(c);
 
@@ -69,8 +109,8 @@ static void connection_free(Connection *c) {
         safe_close(c->server_fd);
         safe_close(c->client_fd);
 
-        safe_close_pair(c->server_to_client_buffer);
-        safe_close_pair(c->client_to_server_buffer);
+        context_release_pipe(c->context, c->server_to_client_buffer, c->server_to_client_buffer_full, c->server_to_client_buffer_size);
+        context_release_pipe(c->context, c->client_to_server_buffer, c->client_to_server_buffer_full, c->client_to_server_buffer_size);
 
         sd_resolve_query_unref(c->resolve_query);
 
@@ -94,12 +134,33 @@ static int idle_time_cb(sd_event_source *s, uint64_t usec, void *userdata) {
         return 0;
 }
 
+static void context_update_status(Context *context, bool force) {
+        char buf[FORMAT_BYTES_MAX];
+        usec_t n;
+
+        assert(context);
+
+        n = now(CLOCK_MONOTONIC);
+        if (!force && context->status_timestamp + STATUS_UPDATE_USEC > n)
+                return;
+
+        context->status_timestamp = n;
+
+        (void) sd_notifyf(false,
+                          "STATUS=%u active connections, %" PRIu64 " total, %s transferred.",
+                          set_size(context->connections),
+                          context->n_connections_total,
+                          format_bytes(buf, sizeof(buf), context->n_bytes));
+}
+
 static int connection_release(Connection *c) {
         Context *context = c->context;
         int r;
 
         connection_free(c);
 
+        context_update_status(context, set_isempty(context->connections));
+
         if (arg_exit_idle_time < USEC_INFINITY && set_isempty(context->connections)) {
                 if (context->idle_time) {
                         r = sd_event_source_set_time_relative(context->idle_time, arg_exit_idle_time);
@@ -127,6 +188,10 @@ static void context_clear(Context *context) {
         set_free_with_destructor(context->listen, sd_event_source_unref);
         set_free_with_destructor(context->connections, connection_free);
 
+        for (size_t i = 0; i < context->n_pipe_pool; i++)
+                safe_close_pair(context->pipe_pool[i].fds);
+        context->n_pipe_pool = 0;
+
         sd_event_unref(context->event);
         sd_resolve_unref(context->resolve);
         sd_event_source_unref(context->idle_time);
@@ -142,6 +207,15 @@ static int connection_create_pipes(Connection *c, int buffer[static 2], size_t *
         if (buffer[0] >= 0)
                 return 0;
 
+        if (c->context->n_pipe_pool > 0) {
+                PoolPipe *p = c->context->pipe_pool + --c->context->n_pipe_pool;
+
+                buffer[0] = p->fds[0];
+                buffer[1] = p->fds[1];
+                *sz = p->size;
+                return 0;
+        }
+
         r = pipe2(buffer, O_CLOEXEC|O_NONBLOCK);
         if (r < 0)
                 return log_error_errno(errno, "Failed to allocate pipe buffer: %m");
@@ -198,6 +272,7 @@ static int connection_shovel(
                         z = splice(buffer[0], NULL, *to, NULL, *full, SPLICE_F_MOVE|SPLICE_F_NONBLOCK);
                         if (z > 0) {
                                 *full -= z;
+                                c->context->n_bytes += z;
                                 shoveled = true;
                         } else if (z == 0 || ERRNO_IS_DISCONNECT(errno)) {
                                 *to_source = sd_event_source_unref(*to_source);
@@ -499,6 +574,9 @@ static int add_connection_socket(Context *context, int fd) {
                 return 0;
         }
 
+        context->n_connections_total++;
+        context_update_status(context, false);
+
         return resolve_remote(c);
 }
 
@@ -1,6 +1,7 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
 #include <errno.h>
+#include <fnmatch.h>
 #include <getopt.h>
 #include <limits.h>
 #include <stdbool.h>
@@ -97,9 +98,43 @@ static Option *option_new(
         return TAKE_PTR(o);
 }
 
+static bool sysctl_value_equal(const char *a, const char *b) {
+        assert(a);
+        assert(b);
+
+        /* Compares word by word, since the kernel separates multiple values by tabs, while configuration
+         * files usually use spaces. */
+
+        for (;;) {
+                size_t n, m;
+
+                a += strspn(a, WHITESPACE);
+                b += strspn(b, WHITESPACE);
+
+                n = strcspn(a, WHITESPACE);
+                m = strcspn(b, WHITESPACE);
+                if (n != m || strncmp(a, b, n) != 0)
+                        return false;
+                if (n == 0)
+                        return true;
+
+                a += n;
+                b += m;
+        }
+}
+
 static int sysctl_write_or_warn(const char *key, const char *value, bool ignore_failure) {
+        _cleanup_free_ char *current = NULL;
         int r;
 
+        /* Don't write values that are already set. This is cheaper for keys matched by globs over many
+         * network interfaces, and avoids side effects some sysctls have when written. Write-only keys can't
+         * be read, and are always written. */
+        if (sysctl_read(key, &current) >= 0 && sysctl_value_equal(current, value)) {
+                log_debug("Not setting '%s', it is already set to '%.*s'.", key, (int) strcspn(value, NEWLINE), value);
+                return 0;
+        }
+
         r = sysctl_write(key, value);
         if (r < 0) {
                 /* If the sysctl is not available in the kernel or we are running with reduced privileges and
@@ -117,6 +152,104 @@ static int sysctl_write_or_warn(const char *key, const char *value, bool ignore_
         return 0;
 }
 
+static int glob_narrow_to_prefix(const char *key, const char *prefix, char **ret) {
+        _cleanup_strv_free_ char **k = NULL, **p = NULL;
+        _cleanup_free_ char *rest = NULL;
+        size_t n, i = 0;
+        char *s;
+
+        assert(key);
+        assert(prefix);
+        assert(ret);
+
+        /* Turns a glob and a prefix into a glob that matches only the paths below the prefix, so that we
+         * don't have to resolve a glob matching some setting of all network interfaces, if we are invoked
+         * for a single new interface. Returns 0 and NULL if nothing below the prefix can match, and
+         * -EOPNOTSUPP if the glob can't be narrowed down. */
+
+        if (string_is_glob(prefix) || strchr(key, '{'))
+                return -EOPNOTSUPP;
+
+        k = strv_split(key, "/");
+        p = strv_split(prefix, "/");
+        if (!k || !p)
+                return -ENOMEM;
+
+        /* Everything the glob matches is shorter than the prefix? Then nothing can be below it. */
+        n = strv_length(p);
+        if (n > strv_length(k)) {
+                *ret = NULL;
+                return 0;
+        }
+
+        for (i = 0; i < n; i++)
+                if (fnmatch(k[i], p[i], FNM_PERIOD) != 0) {
+                        *ret = NULL;
+                        return 0;
+                }
+
+        rest = strv_join(k + n, "/");
+        if (!rest)
+                return -ENOMEM;
+
+        s = path_join("/proc/sys", prefix, rest);
+        if (!s)
+                return -ENOMEM;
+
+        *ret = s;
+        return 0;
+}
+
+static int glob_resolve(const char *key, char ***ret) {
+        _cleanup_strv_free_ char **paths = NULL;
+        _cleanup_free_ char *pattern = NULL;
+        char **i;
+        int r;
+
+        assert(key);
+        assert(ret);
+
+        STRV_FOREACH(i, arg_prefixes) {
+                _cleanup_free_ char *narrowed = NULL;
+                const char *t;
+
+                t = path_startswith(*i, "/proc/sys/");
+                if (!t)
+                        t = *i;
+
+                r = glob_narrow_to_prefix(key, t, &narrowed);
+                if (r == -EOPNOTSUPP)
+                        goto full;
+                if (r < 0)
+                        return r;
+                if (!narrowed)
+                        continue;
+
+                r = glob_extend(&paths, narrowed, 0);
+                if (r < 0 && r != -ENOENT)
+                        return r;
+        }
+
+        if (!strv_isempty(arg_prefixes)) {
+                *ret = strv_uniq(TAKE_PTR(paths));
+                return 0;
+        }
+
+full:
+        paths = strv_free(paths);
+
+        pattern = path_join("/proc/sys", key);
+        if (!pattern)
+                return -ENOMEM;
+
+        r = glob_extend(&paths, pattern, GLOB_NOCHECK);
+        if (r < 0)
+                return r;
+
+        *ret = TAKE_PTR(paths);
+        return 0;
+}
+
 static int apply_all(OrderedHashmap *sysctl_options) {
         Option *option;
         int r = 0;
@@ -130,14 +263,11 @@ static int apply_all(OrderedHashmap *sysctl_options) {
 
                 if (string_is_glob(option->key)) {
                         _cleanup_strv_free_ char **paths = NULL;
-                        _cleanup_free_ char *pattern = NULL;
                         char **s;
 
-                        pattern = path_join("/proc/sys", option->key);
-                        if (!pattern)
+                        k = glob_resolve(option->key, &paths);
+                        if (k == -ENOMEM)
                                 return log_oom();
-
-                        k = glob_extend(&paths, pattern, GLOB_NOCHECK);
                         if (k < 0) {
                                 if (option->ignore_failure || ERRNO_IS_PRIVILEGE(k))
                                         log_debug_errno(k, "Failed to resolve glob '%s', ignoring: %m",
@@ -31,6 +31,7 @@ int daemon_reload(int argc, char *argv[], void *userdata) {
 
         case ACTION_SYSTEMCTL:
                 method = streq(argv[0], "daemon-reexec") ? "Reexecute" :
+                         arg_if_changed ? "ReloadIfChanged" :
                                      /* "daemon-reload" */ "Reload";
                 break;
 
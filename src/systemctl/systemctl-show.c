@@ -295,6 +295,7 @@ static void format_active_state(const char *active_state, const char **active_on
 static void print_status_info(
                 sd_bus *bus,
                 UnitStatusInfo *i,
+                sd_journal **journal,
                 bool *ellipsized) {
 
         char since1[FORMAT_TIMESTAMP_RELATIVE_MAX], since2[FORMAT_TIMESTAMP_MAX];
@@ -751,9 +752,11 @@ static void print_status_info(
                                           i->id, bus_error_message(&error, r));
         }
 
+        /* The journal is kept open across units, unless the unit logs to a namespace of its own */
         if (i->id && arg_transport == BUS_TRANSPORT_LOCAL)
-                show_journal_by_unit(
+                show_journal_by_unit_full(
                                 stdout,
+                                i->log_namespace ? NULL : journal,
                                 i->id,
                                 i->log_namespace,
                                 arg_output,
@@ -1723,6 +1726,7 @@ static int show_one(
                 const char *path,
                 const char *unit,
                 SystemctlShowMode show_mode,
+                sd_journal **journal,
                 bool *new_line,
                 bool *ellipsized) {
 
@@ -1872,7 +1876,7 @@ static int show_one(
         *new_line = true;
 
         if (show_mode == SYSTEMCTL_SHOW_STATUS) {
-                print_status_info(bus, &info, ellipsized);
+                print_status_info(bus, &info, journal, ellipsized);
 
                 if (info.active_state && !STR_IN_SET(info.active_state, "active", "reloading"))
                         return EXIT_PROGRAM_NOT_RUNNING;
@@ -1927,6 +1931,7 @@ static int get_unit_dbus_path_by_pid(
 
 static int show_all(
                 sd_bus *bus,
+                sd_journal **journal,
                 bool *new_line,
                 bool *ellipsized) {
 
@@ -1952,7 +1957,7 @@ static int show_all(
                 if (!p)
                         return log_oom();
 
-                r = show_one(bus, p, u->id, SYSTEMCTL_SHOW_STATUS, new_line, ellipsized);
+                r = show_one(bus, p, u->id, SYSTEMCTL_SHOW_STATUS, journal, new_line, ellipsized);
                 if (r < 0)
                         return r;
                 else if (r > 0 && ret == 0)
@@ -2029,6 +2034,7 @@ static int show_system_status(sd_bus *bus) {
 }
 
 int show(int argc, char *argv[], void *userdata) {
+        _cleanup_(sd_journal_closep) sd_journal *journal = NULL;
         bool new_line = false, ellipsized = false;
         SystemctlShowMode show_mode;
         int r, ret = 0;
@@ -2053,7 +2059,7 @@ int show(int argc, char *argv[], void *userdata) {
 
         /* If no argument is specified inspect the manager itself */
         if (show_mode == SYSTEMCTL_SHOW_PROPERTIES && argc <= 1)
-                return show_one(bus, "/org/freedesktop/systemd1", NULL, show_mode, &new_line, &ellipsized);
+                return show_one(bus, "/org/freedesktop/systemd1", NULL, show_mode, NULL, &new_line, &ellipsized);
 
         if (show_mode == SYSTEMCTL_SHOW_STATUS && argc <= 1) {
 
@@ -2061,7 +2067,7 @@ int show(int argc, char *argv[], void *userdata) {
                 new_line = true;
 
                 if (arg_all)
-                        ret = show_all(bus, &new_line, &ellipsized);
+                        ret = show_all(bus, &journal, &new_line, &ellipsized);
         } else {
                 _cleanup_free_ char **patterns = NULL;
                 char **name;
@@ -2093,7 +2099,7 @@ int show(int argc, char *argv[], void *userdata) {
                                         return log_oom();
                         }
 
-                        r = show_one(bus, path, unit, show_mode, &new_line, &ellipsized);
+                        r = show_one(bus, path, unit, show_mode, &journal, &new_line, &ellipsized);
                         if (r < 0)
                                 return r;
                         else if (r > 0 && ret == 0)
@@ -2118,7 +2124,7 @@ int show(int argc, char *argv[], void *userdata) {
                                 if (!path)
                                         return log_oom();
 
-                                r = show_one(bus, path, *name, show_mode, &new_line, &ellipsized);
+                                r = show_one(bus, path, *name, show_mode, &journal, &new_line, &ellipsized);
                                 if (r < 0)
                                         return r;
                                 if (r > 0 && ret == 0)
@@ -75,6 +75,7 @@ bool arg_no_wtmp = false;
 bool arg_no_sync = false;
 bool arg_no_wall = false;
 bool arg_no_reload = false;
+bool arg_if_changed = false;
 bool arg_value = false;
 bool arg_show_types = false;
 int arg_check_inhibitors = -1;
@@ -269,6 +270,7 @@ static int systemctl_help(void) {
                "     --no-block          Do not wait until operation finished\n"
                "     --no-wall           Don't send wall message before halt/power-off/reboot\n"
                "     --no-reload         Don't reload daemon after en-/dis-abling unit files\n"
+               "     --if-changed        Only reload daemon if unit files or generators changed\n"
                "     --legend=BOOL       Enable/disable the legend (column headers and hints)\n"
                "     --no-pager          Do not pipe output into a pager\n"
                "     --no-ask-password   Do not ask for system passwords\n"
@@ -398,6 +400,7 @@ static int systemctl_parse_argv(int argc, char *argv[]) {
                 ARG_NO_WALL,
                 ARG_ROOT,
                 ARG_NO_RELOAD,
+                ARG_IF_CHANGED,
                 ARG_KILL_WHO,
                 ARG_NO_ASK_PASSWORD,
                 ARG_FAILED,
@@ -453,6 +456,7 @@ static int systemctl_parse_argv(int argc, char *argv[]) {
                 { "quiet",               no_argument,       NULL, 'q'                     },
                 { "root",                required_argument, NULL, ARG_ROOT                },
                 { "force",               no_argument,       NULL, 'f'                     },
+                { "if-changed",          no_argument,       NULL, ARG_IF_CHANGED          },
                 { "no-reload",           no_argument,       NULL, ARG_NO_RELOAD           },
                 { "kill-who",            required_argument, NULL, ARG_KILL_WHO            },
                 { "signal",              required_argument, NULL, 's'                     },
@@ -687,6 +691,10 @@ static int systemctl_parse_argv(int argc, char *argv[]) {
                         arg_no_reload = true;
                         break;
 
+                case ARG_IF_CHANGED:
+                        arg_if_changed = true;
+                        break;
+
                 case ARG_KILL_WHO:
                         arg_kill_who = optarg;
                         break;
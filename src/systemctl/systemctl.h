@@ -58,6 +58,7 @@ extern bool arg_no_wtmp;
 extern bool arg_no_sync;
 extern bool arg_no_wall;
 extern bool arg_no_reload;
+extern bool arg_if_changed;
 extern bool arg_value;
 extern bool arg_show_types;
 extern int arg_check_inhibitors;
@@ -2059,6 +2059,13 @@ static int run(int argc, char *argv[]) {
         if (r < 0)
                 return r;
 
+        /* Package manager triggers tend to invoke us for configuration that declares nothing. Don't bother
+         * with locking and loading the databases in that case. */
+        if (ordered_hashmap_isempty(users) && ordered_hashmap_isempty(groups) && ordered_hashmap_isempty(members)) {
+                log_debug("No users or groups declared, nothing to do.");
+                return 0;
+        }
+
         lock = take_etc_passwd_lock(arg_root);
         if (lock < 0)
                 return log_error_errno(lock, "Failed to take /etc/passwd lock: %m");
@@ -0,0 +1,367 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include "alloc-util.h"
+#include "benchmark.h"
+#include "extract-word.h"
+#include "hashmap.h"
+#include "json.h"
+#include "path-util.h"
+#include "prioq.h"
+#include "random-util.h"
+#include "siphash24.h"
+#include "string-util.h"
+#include "strv.h"
+#include "unit-name.h"
+
+#define N_KEYS 10000U
+
+/* Results are written here, so that the compiler cannot optimize the measured operations away */
+static volatile uintptr_t sink;
+
+typedef struct HashmapState {
+        Hashmap *h;
+        char **keys;
+        unsigned i;
+} HashmapState;
+
+static HashmapState* hashmap_state_free(HashmapState *s) {
+        if (!s)
+                return NULL;
+
+        hashmap_free(s->h);
+        strv_free(s->keys);
+        return mfree(s);
+}
+
+DEFINE_TRIVIAL_CLEANUP_FUNC(HashmapState*, hashmap_state_free);
+
+static void hashmap_state_done(void *p) {
+        hashmap_state_free(p);
+}
+
+static int hashmap_state_new(const struct hash_ops *ops, bool fill, void **ret) {
+        _cleanup_(hashmap_state_freep) HashmapState *s = NULL;
+        int r;
+
+        s = new0(HashmapState, 1);
+        if (!s)
+                return -ENOMEM;
+
+        s->h = hashmap_new(ops);
+        if (!s->h)
+                return -ENOMEM;
+
+        for (unsigned i = 0; i < N_KEYS; i++) {
+                r = strv_extendf(&s->keys, "key-%u-%08" PRIx64, i, random_u64());
+                if (r < 0)
+                        return r;
+
+                if (!fill)
+                        continue;
+
+                r = hashmap_put(s->h, ops == &string_hash_ops ? (void*) s->keys[i] : UINT_TO_PTR(i + 1), s->keys[i]);
+                if (r < 0)
+                        return r;
+        }
+
+        *ret = TAKE_PTR(s);
+        return 0;
+}
+
+static int hashmap_string_setup(void **ret) {
+        return hashmap_state_new(&string_hash_ops, true, ret);
+}
+
+static int hashmap_string_empty_setup(void **ret) {
+        return hashmap_state_new(&string_hash_ops, false, ret);
+}
+
+static int hashmap_pointer_setup(void **ret) {
+        return hashmap_state_new(&trivial_hash_ops, true, ret);
+}
+
+static void hashmap_get_string_run(void *p) {
+        HashmapState *s = p;
+
+        sink = PTR_TO_UINT64(hashmap_get(s->h, s->keys[s->i++ % N_KEYS]));
+}
+
+static void hashmap_get_pointer_run(void *p) {
+        HashmapState *s = p;
+
+        sink = PTR_TO_UINT64(hashmap_get(s->h, UINT_TO_PTR(s->i++ % N_KEYS + 1)));
+}
+
+static void hashmap_put_remove_run(void *p) {
+        HashmapState *s = p;
+        const char *k = s->keys[s->i++ % N_KEYS];
+
+        assert_se(hashmap_put(s->h, k, (void*) k) > 0);
+        sink = PTR_TO_UINT64(hashmap_remove(s->h, k));
+}
+
+typedef struct PrioqState {
+        Prioq *q;
+        uint64_t next;
+} PrioqState;
+
+static uint64_t prioq_state_key(const void *p) {
+        return PTR_TO_UINT64(p);
+}
+
+static PrioqState* prioq_state_free(PrioqState *s) {
+        if (!s)
+                return NULL;
+
+        prioq_free(s->q);
+        return mfree(s);
+}
+
+DEFINE_TRIVIAL_CLEANUP_FUNC(PrioqState*, prioq_state_free);
+
+static void prioq_state_done(void *p) {
+        prioq_state_free(p);
+}
+
+static int prioq_setup(void **ret) {
+        _cleanup_(prioq_state_freep) PrioqState *s = NULL;
+        int r;
+
+        s = new0(PrioqState, 1);
+        if (!s)
+                return -ENOMEM;
+
+        s->q = prioq_new_keyed(prioq_state_key, NULL);
+        if (!s->q)
+                return -ENOMEM;
+
+        for (unsigned i = 0; i < N_KEYS; i++) {
+                r = prioq_put(s->q, UINT64_TO_PTR(random_u64() >> 16), NULL);
+                if (r < 0)
+                        return r;
+        }
+
+        *ret = TAKE_PTR(s);
+        return 0;
+}
+
+static void prioq_put_pop_run(void *p) {
+        PrioqState *s = p;
+
+        /* Pseudo random values, but from a cheap LCG, so that we don't measure the random number generator */
+        s->next = s->next * 6364136223846793005ULL + 1442695040888963407ULL;
+
+        assert_se(prioq_put(s->q, UINT64_TO_PTR(s->next >> 16), NULL) >= 0);
+        sink = PTR_TO_UINT64(prioq_pop(s->q));
+}
+
+static void strv_split_run(void *p) {
+        char **l;
+
+        assert_se(l = strv_split("multi-user.target graphical.target sockets.target timers.target paths.target", NULL));
+        sink = PTR_TO_UINT64(l[0]);
+        strv_free(l);
+}
+
+static void strv_join_run(void *p) {
+        char *s;
+
+        assert_se(s = strv_join(STRV_MAKE("multi-user.target", "graphical.target", "sockets.target", "timers.target"), " "));
+        sink = PTR_TO_UINT64(s);
+        free(s);
+}
+
+static void extract_first_word_run(void *p) {
+        const char *q = "/usr/bin/foo --bar='baz quux' \"waldo piep\" \\\"x\\\" -- y z";
+
+        for (;;) {
+                char *w;
+                int r;
+
+                r = extract_first_word(&q, &w, NULL, EXTRACT_UNQUOTE|EXTRACT_CUNESCAPE);
+                assert_se(r >= 0);
+                if (r == 0)
+                        break;
+
+                sink = PTR_TO_UINT64(w);
+                free(w);
+        }
+}
+
+static void unit_name_is_valid_run(void *p) {
+        sink = unit_name_is_valid("systemd-fsck@dev-disk-by\\x2duuid-1234\\x2d5678.service", UNIT_NAME_ANY);
+}
+
+static void unit_name_to_type_run(void *p) {
+        sink = unit_name_to_type("systemd-fsck@dev-disk-by\\x2duuid-1234\\x2d5678.service");
+}
+
+static void unit_name_from_path_run(void *p) {
+        char *n;
+
+        assert_se(unit_name_from_path("/dev/disk/by-uuid/1234-5678", ".device", &n) >= 0);
+        sink = PTR_TO_UINT64(n);
+        free(n);
+}
+
+static void path_simplify_run(void *p) {
+        char buf[] = "/usr//lib/./systemd/system//../system/multi-user.target.wants/";
+
+        sink = PTR_TO_UINT64(path_simplify(buf, true));
+}
+
+static void path_join_run(void *p) {
+        char *j;
+
+        assert_se(j = path_join("/usr/lib", "systemd/system", "multi-user.target.wants"));
+        sink = PTR_TO_UINT64(j);
+        free(j);
+}
+
+static void path_startswith_run(void *p) {
+        sink = PTR_TO_UINT64(path_startswith("/usr/lib/systemd/system/multi-user.target.wants/foo.service", "/usr/lib/systemd//system"));
+}
+
+static const char json_text[] =
+        "{ \"name\" : \"foo.service\", \"enabled\" : true, \"pid\" : 4711, \"weight\" : 0.5,"
+        "  \"environment\" : [ \"PATH=/usr/bin\", \"LANG=C.UTF-8\", \"TERM=linux\" ],"
+        "  \"limits\" : { \"nofile\" : 1024, \"nproc\" : null }, \"description\" : \"Foo \\u00e4 \\\"bar\\\"\" }";
+
+static void json_parse_run(void *p) {
+        JsonVariant *v;
+
+        assert_se(json_parse(json_text, 0, &v, NULL, NULL) >= 0);
+        sink = PTR_TO_UINT64(v);
+        json_variant_unref(v);
+}
+
+static const char json_strings_text[] =
+        "[ \"Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore\","
+        "  \"/usr/lib/systemd/system/multi-user.target.wants/systemd-networkd-wait-online.service\","
+        "  \"Gr\u00fc\u00dfe aus K\u00f6ln, \\\"zitiert\\\" und\\tmit\\nSteuerzeichen\","
+        "  \"Grüße aus Köln, ohne jede Escape-Sequenz, aber mit etwas mehr UTF-8: ☃ ♥ ✓ ∑\" ]";
+
+static void json_parse_strings_run(void *p) {
+        JsonVariant *v;
+
+        assert_se(json_parse(json_strings_text, 0, &v, NULL, NULL) >= 0);
+        sink = PTR_TO_UINT64(v);
+        json_variant_unref(v);
+}
+
+static int json_format_setup(void **ret) {
+        JsonVariant *v;
+        int r;
+
+        r = json_parse(json_text, 0, &v, NULL, NULL);
+        if (r < 0)
+                return r;
+
+        *ret = v;
+        return 0;
+}
+
+static void json_format_run(void *p) {
+        char *s;
+
+        assert_se(json_variant_format(p, 0, &s) >= 0);
+        sink = PTR_TO_UINT64(s);
+        free(s);
+}
+
+static void json_format_done(void *p) {
+        json_variant_unref(p);
+}
+
+typedef struct JsonBinaryState {
+        void *data;
+        size_t size;
+} JsonBinaryState;
+
+static int json_binary_setup(void **ret) {
+        _cleanup_(json_variant_unrefp) JsonVariant *v = NULL;
+        _cleanup_free_ JsonBinaryState *s = NULL;
+        int r;
+
+        r = json_parse(json_text, 0, &v, NULL, NULL);
+        if (r < 0)
+                return r;
+
+        s = new0(JsonBinaryState, 1);
+        if (!s)
+                return -ENOMEM;
+
+        r = json_variant_format_binary(v, &s->data, &s->size);
+        if (r < 0)
+                return r;
+
+        *ret = TAKE_PTR(s);
+        return 0;
+}
+
+static void json_parse_binary_run(void *p) {
+        JsonBinaryState *s = p;
+        JsonVariant *v;
+
+        assert_se(json_parse_binary(s->data, s->size, 0, &v) >= 0);
+        sink = PTR_TO_UINT64(v);
+        json_variant_unref(v);
+}
+
+static void json_binary_done(void *p) {
+        JsonBinaryState *s = p;
+
+        free(s->data);
+        free(s);
+}
+
+static void json_format_binary_run(void *p) {
+        void *data;
+        size_t size;
+
+        assert_se(json_variant_format_binary(p, &data, &size) >= 0);
+        sink = PTR_TO_UINT64(data);
+        free(data);
+}
+
+static const uint8_t siphash_key[16] = { 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7, 0x8,
+                                         0x9, 0xa, 0xb, 0xc, 0xd, 0xe, 0xf, 0x10 };
+static uint8_t siphash_data[4096];
+
+static void siphash24_16_run(void *p) {
+        sink = siphash24(siphash_data, 16, siphash_key);
+}
+
+static void siphash24_256_run(void *p) {
+        sink = siphash24(siphash_data, 256, siphash_key);
+}
+
+static void siphash24_4096_run(void *p) {
+        sink = siphash24(siphash_data, 4096, siphash_key);
+}
+
+static const Benchmark benchmarks[] = {
+        { "hashmap-get-string",        hashmap_string_setup,       hashmap_get_string_run,    hashmap_state_done },
+        { "hashmap-get-pointer",       hashmap_pointer_setup,      hashmap_get_pointer_run,   hashmap_state_done },
+        { "hashmap-put-remove-string", hashmap_string_empty_setup, hashmap_put_remove_run,    hashmap_state_done },
+        { "prioq-put-pop",             prioq_setup,                prioq_put_pop_run,         prioq_state_done   },
+        { "strv-split",                NULL,                       strv_split_run,            NULL               },
+        { "strv-join",                 NULL,                       strv_join_run,             NULL               },
+        { "extract-first-word",        NULL,                       extract_first_word_run,    NULL               },
+        { "unit-name-is-valid",        NULL,                       unit_name_is_valid_run,    NULL               },
+        { "unit-name-to-type",         NULL,                       unit_name_to_type_run,     NULL               },
+        { "unit-name-from-path",       NULL,                       unit_name_from_path_run,   NULL               },
+        { "path-simplify",             NULL,                       path_simplify_run,         NULL               },
+        { "path-join",                 NULL,                       path_join_run,             NULL               },
+        { "path-startswith",           NULL,                       path_startswith_run,       NULL               },
+        { "json-parse",                NULL,                       json_parse_run,            NULL               },
+        { "json-parse-strings",        NULL,                       json_parse_strings_run,    NULL               },
+        { "json-format",               json_format_setup,          json_format_run,           json_format_done   },
+        { "json-parse-binary",         json_binary_setup,          json_parse_binary_run,     json_binary_done   },
+        { "json-format-binary",        json_format_setup,          json_format_binary_run,    json_format_done   },
+        { "siphash24-16",              NULL,                       siphash24_16_run,          NULL               },
+        { "siphash24-256",             NULL,                       siphash24_256_run,         NULL               },
+        { "siphash24-4096",            NULL,                       siphash24_4096_run,        NULL               },
+};
+
+DEFINE_BENCHMARK_MAIN(benchmarks);
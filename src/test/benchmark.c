@@ -0,0 +1,283 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <fnmatch.h>
+#include <getopt.h>
+#include <sched.h>
+
+#include "alloc-util.h"
+#include "benchmark.h"
+#include "json.h"
+#include "log.h"
+#include "parse-util.h"
+#include "sort-util.h"
+#include "static-destruct.h"
+#include "strv.h"
+#include "time-util.h"
+
+typedef struct BenchmarkResult {
+        uint64_t n_operations;
+        double mean, min, p50, p90, p99, max; /* in ns per operation */
+} BenchmarkResult;
+
+static unsigned arg_samples = 50;
+static usec_t arg_warmup = 100 * USEC_PER_MSEC;
+static usec_t arg_sample_time = 5 * USEC_PER_MSEC;
+static bool arg_json = false;
+static char **arg_patterns = NULL;
+
+STATIC_DESTRUCTOR_REGISTER(arg_patterns, strv_freep);
+
+static int double_compare(const double *a, const double *b) {
+        return CMP(*a, *b);
+}
+
+static double percentile(const double *sorted, size_t n, unsigned p) {
+        size_t k;
+
+        assert(n > 0);
+        assert(p <= 100);
+
+        /* Nearest rank */
+        k = DIV_ROUND_UP(n * p, 100);
+        return sorted[k > 0 ? k - 1 : 0];
+}
+
+static int run_benchmark(const Benchmark *b, BenchmarkResult *ret) {
+        _cleanup_free_ double *samples = NULL;
+        uint64_t batch, n = 0;
+        void *state = NULL;
+        nsec_t start, end;
+        double sum = 0;
+        int r;
+
+        assert(b);
+        assert(b->run);
+        assert(ret);
+
+        samples = new(double, arg_samples);
+        if (!samples)
+                return log_oom();
+
+        if (b->setup) {
+                r = b->setup(&state);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to set up benchmark %s: %m", b->name);
+        }
+
+        /* Warm up the caches and the branch predictors, and find out how many operations fit in one sample */
+        start = end = now_nsec(CLOCK_MONOTONIC);
+        while (end - start < arg_warmup * NSEC_PER_USEC) {
+                b->run(state);
+                n++;
+
+                /* Don't read the clock after every operation, it might be slower than the operation itself */
+                if ((n & (n - 1)) == 0 || n % 1024 == 0)
+                        end = now_nsec(CLOCK_MONOTONIC);
+        }
+        batch = MAX(1u, (uint64_t) ((double) n * arg_sample_time / arg_warmup));
+
+        for (unsigned i = 0; i < arg_samples; i++) {
+                start = now_nsec(CLOCK_MONOTONIC);
+                for (uint64_t j = 0; j < batch; j++)
+                        b->run(state);
+                end = now_nsec(CLOCK_MONOTONIC);
+
+                samples[i] = (double) (end - start) / batch;
+                sum += samples[i];
+        }
+
+        if (b->done)
+                b->done(state);
+
+        typesafe_qsort(samples, arg_samples, double_compare);
+
+        *ret = (BenchmarkResult) {
+                .n_operations = batch * arg_samples,
+                .mean = sum / arg_samples,
+                .min = samples[0],
+                .p50 = percentile(samples, arg_samples, 50),
+                .p90 = percentile(samples, arg_samples, 90),
+                .p99 = percentile(samples, arg_samples, 99),
+                .max = samples[arg_samples - 1],
+        };
+
+        return 0;
+}
+
+static bool benchmark_selected(const Benchmark *b) {
+        char **p;
+
+        if (strv_isempty(arg_patterns))
+                return true;
+
+        STRV_FOREACH(p, arg_patterns)
+                if (fnmatch(*p, b->name, 0) == 0)
+                        return true;
+
+        return false;
+}
+
+static void pin_to_cpu(void) {
+        cpu_set_t set;
+        int cpu;
+
+        /* Don't let the scheduler move us around in the middle of a sample, it makes results noisy */
+
+        cpu = sched_getcpu();
+        if (cpu < 0)
+                return (void) log_debug_errno(errno, "Failed to determine current CPU, not pinning: %m");
+
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        if (sched_setaffinity(0, sizeof(set), &set) < 0)
+                log_debug_errno(errno, "Failed to pin to CPU %i, ignoring: %m", cpu);
+}
+
+static int help(const char *program) {
+        printf("%s [OPTIONS...] [PATTERN...]\n\n"
+               "Run microbenchmarks, optionally only those matching the patterns.\n\n"
+               "  -h --help              Show this help\n"
+               "     --json              Output results as JSON\n"
+               "     --samples=N         Number of samples per benchmark (default: %u)\n"
+               "     --warmup=TIME       Warmup time per benchmark\n"
+               "     --sample-time=TIME  Target time of one sample\n",
+               program, arg_samples);
+
+        return 0;
+}
+
+static int parse_argv(int argc, char *argv[]) {
+        enum {
+                ARG_JSON = 0x100,
+                ARG_SAMPLES,
+                ARG_WARMUP,
+                ARG_SAMPLE_TIME,
+        };
+
+        static const struct option options[] = {
+                { "help",        no_argument,       NULL, 'h'             },
+                { "json",        no_argument,       NULL, ARG_JSON        },
+                { "samples",     required_argument, NULL, ARG_SAMPLES     },
+                { "warmup",      required_argument, NULL, ARG_WARMUP      },
+                { "sample-time", required_argument, NULL, ARG_SAMPLE_TIME },
+                {},
+        };
+
+        int c, r;
+
+        assert(argc >= 0);
+        assert(argv);
+
+        while ((c = getopt_long(argc, argv, "h", options, NULL)) >= 0)
+                switch (c) {
+
+                case 'h':
+                        return help(program_invocation_short_name);
+
+                case ARG_JSON:
+                        arg_json = true;
+                        break;
+
+                case ARG_SAMPLES:
+                        r = safe_atou(optarg, &arg_samples);
+                        if (r < 0)
+                                return log_error_errno(r, "Failed to parse --samples= argument: %s", optarg);
+                        if (arg_samples == 0)
+                                return log_error_errno(SYNTHETIC_ERRNO(EINVAL), "Number of samples must be positive.");
+                        break;
+
+                case ARG_WARMUP:
+                        r = parse_sec(optarg, &arg_warmup);
+                        if (r < 0)
+                                return log_error_errno(r, "Failed to parse --warmup= argument: %s", optarg);
+                        if (arg_warmup == 0 || arg_warmup == USEC_INFINITY)
+                                return log_error_errno(SYNTHETIC_ERRNO(EINVAL), "Warmup time must be positive and finite.");
+                        break;
+
+                case ARG_SAMPLE_TIME:
+                        r = parse_sec(optarg, &arg_sample_time);
+                        if (r < 0)
+                                return log_error_errno(r, "Failed to parse --sample-time= argument: %s", optarg);
+                        if (arg_sample_time == USEC_INFINITY)
+                                return log_error_errno(SYNTHETIC_ERRNO(EINVAL), "Sample time must be finite.");
+                        break;
+
+                case '?':
+                        return -EINVAL;
+
+                default:
+                        assert_not_reached("Unhandled option");
+                }
+
+        arg_patterns = strv_copy(argv + optind);
+        if (!arg_patterns)
+                return log_oom();
+
+        return 1;
+}
+
+int benchmark_main(const Benchmark *benchmarks, size_t n_benchmarks, int argc, char *argv[]) {
+        _cleanup_(json_variant_unrefp) JsonVariant *array = NULL;
+        int r;
+
+        log_parse_environment();
+        log_open();
+
+        r = parse_argv(argc, argv);
+        if (r <= 0)
+                return r;
+
+        pin_to_cpu();
+
+        if (!arg_json)
+                printf("%-40s %12s %10s %10s %10s %10s %10s\n",
+                       "BENCHMARK", "OPERATIONS", "MIN", "P50", "P90", "P99", "MAX");
+
+        for (size_t i = 0; i < n_benchmarks; i++) {
+                const Benchmark *b = benchmarks + i;
+                BenchmarkResult result;
+
+                if (!benchmark_selected(b))
+                        continue;
+
+                r = run_benchmark(b, &result);
+                if (r < 0)
+                        return r;
+
+                if (arg_json) {
+                        _cleanup_(json_variant_unrefp) JsonVariant *v = NULL;
+
+                        r = json_build(&v, JSON_BUILD_OBJECT(
+                                                       JSON_BUILD_PAIR("name", JSON_BUILD_STRING(b->name)),
+                                                       JSON_BUILD_PAIR("operations", JSON_BUILD_UNSIGNED(result.n_operations)),
+                                                       JSON_BUILD_PAIR("mean_ns", JSON_BUILD_REAL(result.mean)),
+                                                       JSON_BUILD_PAIR("min_ns", JSON_BUILD_REAL(result.min)),
+                                                       JSON_BUILD_PAIR("p50_ns", JSON_BUILD_REAL(result.p50)),
+                                                       JSON_BUILD_PAIR("p90_ns", JSON_BUILD_REAL(result.p90)),
+                                                       JSON_BUILD_PAIR("p99_ns", JSON_BUILD_REAL(result.p99)),
+                                                       JSON_BUILD_PAIR("max_ns", JSON_BUILD_REAL(result.max))));
+                        if (r < 0)
+                                return log_error_errno(r, "Failed to build JSON object: %m");
+
+                        r = json_variant_append_array(&array, v);
+                        if (r < 0)
+                                return log_error_errno(r, "Failed to append JSON object: %m");
+                } else
+                        printf("%-40s %12" PRIu64 " %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+                               b->name, result.n_operations,
+                               result.min, result.p50, result.p90, result.p99, result.max);
+        }
+
+        if (arg_json) {
+                if (!array) {
+                        r = json_variant_new_array(&array, NULL, 0);
+                        if (r < 0)
+                                return log_error_errno(r, "Failed to allocate JSON array: %m");
+                }
+
+                json_variant_dump(array, JSON_FORMAT_PRETTY_AUTO|JSON_FORMAT_COLOR_AUTO, stdout, NULL);
+        } else
+                printf("\nAll times are in ns per operation.\n");
+
+        return 0;
+}
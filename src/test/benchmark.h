@@ -0,0 +1,30 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+#pragma once
+
+#include <stddef.h>
+
+#include "macro.h"
+#include "main-func.h"
+
+/* A minimal harness for microbenchmarks. Each benchmark measures a single operation: after a warmup phase,
+ * which is also used to calibrate how many operations make up one sample, the operation is timed in a number
+ * of samples, and the distribution of the time per operation is reported, either as a table or as JSON. */
+
+typedef struct Benchmark {
+        const char *name;
+
+        /* Optional, called before the warmup. The state it returns is passed to run() and done(). */
+        int (*setup)(void **ret_state);
+        /* Runs the measured operation once. */
+        void (*run)(void *state);
+        /* Optional, releases the state again. */
+        void (*done)(void *state);
+} Benchmark;
+
+int benchmark_main(const Benchmark *benchmarks, size_t n_benchmarks, int argc, char *argv[]);
+
+#define DEFINE_BENCHMARK_MAIN(benchmarks)                               \
+        static int run(int argc, char *argv[]) {                        \
+                return benchmark_main(benchmarks, ELEMENTSOF(benchmarks), argc, argv); \
+        }                                                               \
+        DEFINE_MAIN_FUNCTION(run)
@@ -0,0 +1,80 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <stdint.h>
+
+#include "arena.h"
+#include "memory-util.h"
+#include "string-util.h"
+#include "tests.h"
+
+static void test_arena_alloc(void) {
+        _cleanup_(arena_done) Arena a = {};
+        char *p[1000];
+
+        log_info("/* %s */", __func__);
+
+        for (unsigned i = 0; i < ELEMENTSOF(p); i++) {
+                assert_se(p[i] = arena_alloc(&a, i));
+                assert_se(((uintptr_t) p[i] & 7) == 0);
+                memset(p[i], i & 0xff, i);
+        }
+
+        /* Nothing got overwritten */
+        for (unsigned i = 0; i < ELEMENTSOF(p); i++)
+                for (unsigned k = 0; k < i; k++)
+                        assert_se((uint8_t) p[i][k] == (i & 0xff));
+
+        assert_se(p[0] != p[1]);
+}
+
+static void test_arena_large(void) {
+        _cleanup_(arena_done) Arena a = {};
+        char *small, *big, *small2;
+
+        log_info("/* %s */", __func__);
+
+        assert_se(small = arena_strdup(&a, "small"));
+        assert_se(big = arena_alloc0(&a, 1024 * 1024));
+        assert_se(memeqzero(big, 1024 * 1024));
+        memset(big, 'x', 1024 * 1024);
+
+        /* The chunk of the small allocation is still used after the big one */
+        assert_se(small2 = arena_strdup(&a, "small2"));
+        assert_se(small2 == small + 8);
+        assert_se(streq(small, "small"));
+        assert_se(streq(small2, "small2"));
+}
+
+static void test_arena_strings(void) {
+        _cleanup_(arena_done) Arena a = {};
+        const char *s;
+
+        log_info("/* %s */", __func__);
+
+        assert_se(s = arena_strdup(&a, "foobar"));
+        assert_se(streq(s, "foobar"));
+        assert_se(s = arena_strndup(&a, "foobar", 3));
+        assert_se(streq(s, "foo"));
+        assert_se(s = arena_strndup(&a, "foo", 10));
+        assert_se(streq(s, "foo"));
+        assert_se(s = arena_memdup(&a, "quux", 5));
+        assert_se(streq(s, "quux"));
+        assert_se(s = arena_strdup(&a, ""));
+        assert_se(isempty(s));
+
+        /* An arena can be reused after arena_done() */
+        arena_done(&a);
+        assert_se(!a.first_chunk);
+        assert_se(s = arena_strdup(&a, "again"));
+        assert_se(streq(s, "again"));
+}
+
+int main(int argc, char *argv[]) {
+        test_setup_logging(LOG_DEBUG);
+
+        test_arena_alloc();
+        test_arena_large();
+        test_arena_strings();
+
+        return 0;
+}
@@ -22,10 +22,10 @@ int main(int argc, char *argv[]) {
         };
 
         _cleanup_(rm_rf_physical_and_freep) char *runtime_dir = NULL;
-        CGroupContext *cc = NULL;
+        CGroupContext *cc = NULL, *cc2 = NULL;
         _cleanup_(bpf_program_unrefp) BPFProgram *p = NULL;
         _cleanup_(manager_freep) Manager *m = NULL;
-        Unit *u;
+        Unit *u, *u2;
         char log_buf[65535];
         struct rlimit rl;
         int r;
@@ -160,6 +160,23 @@ int main(int argc, char *argv[]) {
 
         assert(r >= 0);
 
+        /* A second unit with the same address lists must share the access maps, but not the accounting maps */
+        assert_se(u2 = unit_new(m, sizeof(Service)));
+        assert_se(unit_add_name(u2, "bar.service") == 0);
+        assert_se(cc2 = unit_get_cgroup_context(u2));
+        u2->perpetual = true;
+
+        cc2->ip_accounting = true;
+
+        assert_se(config_parse_ip_address_access(u2->id, "filename", 1, "Service", 1, "IPAddressAllow", 0, "127.0.0.2 10.0.1.0/24", &cc2->ip_address_allow, NULL) == 0);
+        assert_se(config_parse_ip_address_access(u2->id, "filename", 1, "Service", 1, "IPAddressDeny", 0, "127.0.0.3 10.0.3.2/24 127.0.0.1/25 127.0.0.4", &cc2->ip_address_deny, NULL) == 0);
+
+        assert_se(bpf_firewall_compile(u2) >= 0);
+        assert_se(u2->ip_allow_maps && u2->ip_allow_maps == u->ip_allow_maps);
+        assert_se(u2->ip_deny_maps && u2->ip_deny_maps == u->ip_deny_maps);
+        assert_se(u2->ip_accounting_ingress_map_fd >= 0);
+        assert_se(u2->ip_accounting_ingress_map_fd != u->ip_accounting_ingress_map_fd);
+
         assert_se(unit_start(u) >= 0);
 
         while (!IN_SET(SERVICE(u)->state, SERVICE_DEAD, SERVICE_FAILED))
@@ -0,0 +1,106 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <sys/socket.h>
+
+#include "sd-bus.h"
+
+#include "alloc-util.h"
+#include "bus-message-util.h"
+#include "memory-util.h"
+#include "random-util.h"
+#include "string-util.h"
+#include "tests.h"
+
+static void connect_pair(bool fds, sd_bus **ret_server, sd_bus **ret_client) {
+        _cleanup_(sd_bus_flush_close_unrefp) sd_bus *server = NULL, *client = NULL;
+        int pair[2];
+        sd_id128_t id;
+
+        assert_se(socketpair(AF_UNIX, SOCK_STREAM|SOCK_CLOEXEC|SOCK_NONBLOCK, 0, pair) >= 0);
+        assert_se(sd_id128_randomize(&id) >= 0);
+
+        assert_se(sd_bus_new(&server) >= 0);
+        assert_se(sd_bus_set_fd(server, pair[0], pair[0]) >= 0);
+        assert_se(sd_bus_set_server(server, true, id) >= 0);
+        assert_se(sd_bus_set_anonymous(server, true) >= 0);
+        assert_se(sd_bus_negotiate_fds(server, fds) >= 0);
+        assert_se(sd_bus_start(server) >= 0);
+
+        assert_se(sd_bus_new(&client) >= 0);
+        assert_se(sd_bus_set_fd(client, pair[1], pair[1]) >= 0);
+        assert_se(sd_bus_set_anonymous(client, true) >= 0);
+        assert_se(sd_bus_negotiate_fds(client, fds) >= 0);
+        assert_se(sd_bus_start(client) >= 0);
+
+        while (!sd_bus_is_ready(server) || !sd_bus_is_ready(client)) {
+                assert_se(sd_bus_process(client, NULL) >= 0);
+                assert_se(sd_bus_process(server, NULL) >= 0);
+        }
+
+        *ret_server = TAKE_PTR(server);
+        *ret_client = TAKE_PTR(client);
+}
+
+static void test_blob_one(bool fds, size_t size) {
+        _cleanup_(sd_bus_flush_close_unrefp) sd_bus *server = NULL, *client = NULL;
+        _cleanup_(sd_bus_message_unrefp) sd_bus_message *m = NULL, *received = NULL;
+        _cleanup_(bus_blob_done) BusBlob blob = {};
+        _cleanup_free_ void *data = NULL;
+
+        log_info("/* %s(fds=%s, size=%zu) */", __func__, yes_no(fds), size);
+
+        connect_pair(fds, &server, &client);
+
+        assert_se(data = malloc(MAX(size, 1u)));
+        random_bytes(data, size);
+
+        assert_se(sd_bus_message_new_signal(client, &m, "/test", "org.freedesktop.systemd.test", "Blob") >= 0);
+        assert_se(bus_message_append_blob(m, data, size) >= 0);
+        assert_se(sd_bus_send(client, m, NULL) >= 0);
+
+        while (!received) {
+                assert_se(sd_bus_process(client, NULL) >= 0);
+                if (sd_bus_process(server, &received) == 0)
+                        assert_se(sd_bus_wait(server, 100 * USEC_PER_MSEC) >= 0);
+        }
+
+        assert_se(streq(sd_bus_message_get_signature(received, true), "v"));
+        assert_se(bus_message_read_blob(received, &blob) >= 0);
+        assert_se(blob.size == size);
+        assert_se(memcmp_safe(blob.data, data, size) == 0);
+
+        /* Large blobs are sent as memfd, but only if the connection can pass fds */
+        assert_se(!!blob.map == (fds && size >= 64U*1024U));
+}
+
+static void test_blob_wrong_type(void) {
+        _cleanup_(sd_bus_flush_close_unrefp) sd_bus *server = NULL, *client = NULL;
+        _cleanup_(sd_bus_message_unrefp) sd_bus_message *m = NULL;
+        BusBlob blob;
+
+        log_info("/* %s */", __func__);
+
+        connect_pair(false, &server, &client);
+
+        assert_se(sd_bus_message_new_signal(client, &m, "/test", "org.freedesktop.systemd.test", "Blob") >= 0);
+        assert_se(sd_bus_message_append(m, "v", "s", "foo") >= 0);
+        assert_se(sd_bus_message_seal(m, 1, 0) >= 0);
+        assert_se(sd_bus_message_rewind(m, true) >= 0);
+
+        assert_se(bus_message_read_blob(m, &blob) == -ENXIO);
+}
+
+int main(int argc, char *argv[]) {
+        static const size_t sizes[] = { 0, 1000, 1024*1024 };
+
+        test_setup_logging(LOG_INFO);
+
+        for (size_t i = 0; i < ELEMENTSOF(sizes); i++) {
+                test_blob_one(false, sizes[i]);
+                test_blob_one(true, sizes[i]);
+        }
+
+        test_blob_wrong_type();
+
+        return 0;
+}
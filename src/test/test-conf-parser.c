@@ -2,9 +2,11 @@
 
 #include "conf-parser.h"
 #include "fd-util.h"
+#include "fileio.h"
 #include "fs-util.h"
 #include "log.h"
 #include "macro.h"
+#include "rm-rf.h"
 #include "string-util.h"
 #include "strv.h"
 #include "tmpfile-util.h"
@@ -385,6 +387,39 @@ static void test_config_parse(unsigned i, const char *s) {
         }
 }
 
+static void test_config_files_digest(void) {
+        _cleanup_(rm_rf_physical_and_freep) char *d = NULL;
+        uint64_t a, b, c;
+        const char *main_file, *dropin;
+
+        log_info("/* %s */", __func__);
+
+        assert_se(mkdtemp_malloc("/tmp/test-conf-parser-XXXXXX", &d) >= 0);
+        main_file = strjoina(d, "/foo.conf");
+        dropin = strjoina(d, "/foo.conf.d/50-bar.conf");
+
+        assert_se(write_string_file(main_file, "[Section]\nsetting1=1\n", WRITE_STRING_FILE_CREATE) >= 0);
+
+        assert_se(config_files_digest(STRV_MAKE_CONST(main_file), STRV_MAKE_CONST(d), "foo.conf.d", &a) >= 0);
+        assert_se(config_files_digest(STRV_MAKE_CONST(main_file), STRV_MAKE_CONST(d), "foo.conf.d", &b) >= 0);
+        assert_se(a == b);
+
+        /* Adding a drop-in changes the digest */
+        assert_se(write_string_file(dropin, "[Section]\nsetting1=2\n", WRITE_STRING_FILE_CREATE|WRITE_STRING_FILE_MKDIR_0755) >= 0);
+        assert_se(config_files_digest(STRV_MAKE_CONST(main_file), STRV_MAKE_CONST(d), "foo.conf.d", &b) >= 0);
+        assert_se(a != b);
+
+        /* And so does changing the main file */
+        assert_se(write_string_file(main_file, "[Section]\nsetting1=10\n", 0) >= 0);
+        assert_se(config_files_digest(STRV_MAKE_CONST(main_file), STRV_MAKE_CONST(d), "foo.conf.d", &c) >= 0);
+        assert_se(b != c);
+
+        /* As does removing it */
+        assert_se(unlink(main_file) >= 0);
+        assert_se(config_files_digest(STRV_MAKE_CONST(main_file), STRV_MAKE_CONST(d), "foo.conf.d", &b) >= 0);
+        assert_se(b != c);
+}
+
 int main(int argc, char **argv) {
         unsigned i;
 
@@ -403,6 +438,7 @@ int main(int argc, char **argv) {
         test_config_parse_sec();
         test_config_parse_nsec();
         test_config_parse_iec_uint64();
+        test_config_files_digest();
 
         for (i = 0; i < ELEMENTSOF(config_file); i++)
                 test_config_parse(i, config_file[i]);
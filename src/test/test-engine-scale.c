@@ -0,0 +1,244 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* Benchmark for the manager with large synthetic unit trees. This is a manual test, invoke it as
+ *
+ *     test-engine-scale [N_UNITS [FANOUT]]
+ *
+ * It generates N_UNITS services below bench.target, each pulling in FANOUT further services, plus template
+ * instances, drop-ins and generated units, and reports wall clock time and RSS for the individual
+ * phases. */
+
+#include <errno.h>
+#include <stdio.h>
+#include <sys/stat.h>
+
+#include "alloc-util.h"
+#include "fd-util.h"
+#include "fdset.h"
+#include "fileio.h"
+#include "format-util.h"
+#include "manager.h"
+#include "parse-util.h"
+#include "path-util.h"
+#include "rm-rf.h"
+#include "string-util.h"
+#include "tests.h"
+#include "time-util.h"
+#include "tmpfile-util.h"
+#include "unit.h"
+
+#define DEFAULT_N_UNITS 10000U
+#define DEFAULT_FANOUT 4U
+
+/* Every n-th unit also pulls in an instance of a template, and every n-th a generated unit */
+#define TEMPLATE_EVERY 8U
+#define GENERATED_EVERY 16U
+
+typedef struct Phase {
+        const char *name;
+        usec_t start;
+} Phase;
+
+static uint64_t current_rss(void) {
+        _cleanup_free_ char *field = NULL;
+        uint64_t kb;
+
+        if (get_proc_field("/proc/self/status", "VmRSS", WHITESPACE, &field) < 0)
+                return UINT64_MAX;
+
+        if (safe_atou64(field, &kb) < 0)
+                return UINT64_MAX;
+
+        return kb * 1024U;
+}
+
+static void phase_begin(Phase *p, const char *name) {
+        *p = (Phase) {
+                .name = name,
+                .start = now(CLOCK_MONOTONIC),
+        };
+}
+
+static void phase_end(Phase *p, Manager *m) {
+        char ts[FORMAT_TIMESPAN_MAX], rss[FORMAT_BYTES_MAX];
+
+        printf("%-24s %12s %10s %8u units\n",
+               p->name,
+               format_timespan(ts, sizeof ts, usec_sub_unsigned(now(CLOCK_MONOTONIC), p->start), USEC_PER_MSEC),
+               strna(format_bytes(rss, sizeof rss, current_rss())),
+               m ? hashmap_size(m->units) : 0);
+}
+
+static char *bench_extend(char **deps, const char *format, unsigned i, bool after) {
+        char name[STRLEN("bench-tmpl@.service") + DECIMAL_STR_MAX(unsigned)];
+
+        assert_se(snprintf(name, sizeof name, format, i) < (int) sizeof name);
+
+        return strextend(deps,
+                         "Wants=", name, "\n",
+                         after ? "After=" : "", after ? name : "", after ? "\n" : "");
+}
+
+static void write_unit_tree(const char *dir, unsigned n_units, unsigned fanout) {
+        _cleanup_free_ char *p = NULL;
+
+        p = path_join(dir, "bench.target");
+        assert_se(p);
+        assert_se(write_string_file(p,
+                                    "[Unit]\n"
+                                    "Description=Benchmark target\n"
+                                    "Wants=bench-0.service\n"
+                                    "After=bench-0.service\n",
+                                    WRITE_STRING_FILE_CREATE) >= 0);
+
+        p = mfree(p);
+        p = path_join(dir, "bench-tmpl@.service");
+        assert_se(p);
+        assert_se(write_string_file(p,
+                                    "[Unit]\n"
+                                    "Description=Benchmark template %i\n"
+                                    "\n"
+                                    "[Service]\n"
+                                    "ExecStart=/bin/true %i\n",
+                                    WRITE_STRING_FILE_CREATE) >= 0);
+
+        for (unsigned i = 0; i < n_units; i++) {
+                _cleanup_free_ char *unit = NULL, *dropin_dir = NULL, *dropin = NULL, *deps = NULL;
+
+                /* Build a tree: unit i pulls in and orders itself after units i*fanout+1 … i*fanout+fanout */
+                for (unsigned k = 1; k <= fanout; k++) {
+                        unsigned c = i * fanout + k;
+
+                        if (c >= n_units)
+                                break;
+
+                        assert_se(bench_extend(&deps, "bench-%u.service", c, true));
+                }
+
+                if (i % TEMPLATE_EVERY == 0)
+                        assert_se(bench_extend(&deps, "bench-tmpl@%u.service", i, false));
+                if (i % GENERATED_EVERY == 0)
+                        assert_se(bench_extend(&deps, "bench-gen-%u.service", i / GENERATED_EVERY, false));
+
+                assert_se(asprintf(&unit, "%s/bench-%u.service", dir, i) >= 0);
+                assert_se(write_string_filef(unit, WRITE_STRING_FILE_CREATE,
+                                             "[Unit]\n"
+                                             "Description=Benchmark service %u\n"
+                                             "%s"
+                                             "\n"
+                                             "[Service]\n"
+                                             "ExecStart=/bin/true %u\n",
+                                             i, strempty(deps), i) >= 0);
+
+                assert_se(asprintf(&dropin_dir, "%s/bench-%u.service.d", dir, i) >= 0);
+                assert_se(mkdir(dropin_dir, 0755) >= 0);
+
+                dropin = path_join(dropin_dir, "50-bench.conf");
+                assert_se(dropin);
+                assert_se(write_string_filef(dropin, WRITE_STRING_FILE_CREATE,
+                                             "[Service]\n"
+                                             "Environment=BENCH_INDEX=%u\n", i) >= 0);
+        }
+}
+
+static void write_generator(const char *dir, unsigned n_units) {
+        _cleanup_free_ char *p = NULL;
+
+        /* A generator writing one unit for every GENERATED_EVERY synthetic units, so that the cost of
+         * running generators and of reading their output is covered too. */
+
+        p = path_join(dir, "bench-generator");
+        assert_se(p);
+        assert_se(write_string_filef(p, WRITE_STRING_FILE_CREATE,
+                                     "#!/bin/sh\n"
+                                     "set -e\n"
+                                     "i=0\n"
+                                     "while [ $i -lt %u ]; do\n"
+                                     "    printf '[Service]\\nExecStart=/bin/true %%s\\n' $i >\"$1/bench-gen-$i.service\"\n"
+                                     "    i=$((i + 1))\n"
+                                     "done\n",
+                                     DIV_ROUND_UP(n_units, GENERATED_EVERY)) >= 0);
+        assert_se(chmod(p, 0755) >= 0);
+}
+
+int main(int argc, char *argv[]) {
+        _cleanup_(rm_rf_physical_and_freep) char *runtime_dir = NULL, *unit_dir = NULL, *generator_dir = NULL;
+        _cleanup_(sd_bus_error_free) sd_bus_error err = SD_BUS_ERROR_NULL;
+        _cleanup_(manager_freep) Manager *m = NULL;
+        _cleanup_fdset_free_ FDSet *fds = NULL;
+        _cleanup_free_ char *unit_path = NULL;
+        _cleanup_fclose_ FILE *f = NULL;
+        unsigned n_units = DEFAULT_N_UNITS, fanout = DEFAULT_FANOUT;
+        char size[FORMAT_BYTES_MAX];
+        Unit *target = NULL;
+        Phase phase;
+        Job *j;
+        int r;
+
+        test_setup_logging(LOG_NOTICE);
+
+        if (argc > 1)
+                assert_se(safe_atou(argv[1], &n_units) >= 0 && n_units > 0);
+        if (argc > 2)
+                assert_se(safe_atou(argv[2], &fanout) >= 0 && fanout > 0);
+
+        r = enter_cgroup_subroot(NULL);
+        if (r == -ENOMEDIUM)
+                return log_tests_skipped("cgroupfs not available");
+
+        assert_se(runtime_dir = setup_fake_runtime_dir());
+        assert_se(mkdtemp_malloc("/tmp/test-engine-scale-units-XXXXXX", &unit_dir) >= 0);
+        assert_se(mkdtemp_malloc("/tmp/test-engine-scale-generator-XXXXXX", &generator_dir) >= 0);
+
+        printf("Generating %u units with fan-out %u in %s\n", n_units, fanout, unit_dir);
+        write_unit_tree(unit_dir, n_units, fanout);
+        write_generator(generator_dir, n_units);
+
+        /* Append the default paths, so that the generator output directory is in the search path */
+        unit_path = strjoin(unit_dir, ":");
+        assert_se(unit_path);
+        assert_se(set_unit_path(unit_path) >= 0);
+        assert_se(setenv("SYSTEMD_GENERATOR_PATH", generator_dir, 1) >= 0);
+
+        phase_begin(&phase, "startup");
+        r = manager_new(UNIT_FILE_USER, MANAGER_TEST_RUN_BASIC|MANAGER_TEST_RUN_GENERATORS, &m);
+        if (manager_errno_skip_test(r))
+                return log_tests_skipped_errno(r, "manager_new");
+        assert_se(r >= 0);
+        assert_se(manager_startup(m, NULL, NULL) >= 0);
+        phase_end(&phase, m);
+
+        phase_begin(&phase, "unit load");
+        assert_se(manager_load_startable_unit_or_warn(m, "bench.target", NULL, &target) >= 0);
+        phase_end(&phase, m);
+
+        phase_begin(&phase, "transaction");
+        r = manager_add_job(m, JOB_START, target, JOB_REPLACE, NULL, &err, &j);
+        if (sd_bus_error_is_set(&err))
+                log_error("error: %s: %s", err.name, err.message);
+        assert_se(r >= 0);
+        phase_end(&phase, m);
+        printf("%-24s %12u\n", "jobs", hashmap_size(m->jobs));
+
+        phase_begin(&phase, "serialization");
+        assert_se(fds = fdset_new());
+        assert_se(manager_open_serialization(m, &f) >= 0);
+        assert_se(manager_serialize(m, f, fds, false) >= 0);
+        assert_se(fflush(f) == 0);
+        phase_end(&phase, m);
+        printf("%-24s %12s\n", "serialization size", strna(format_bytes(size, sizeof size, ftello(f))));
+        f = safe_fclose(f);
+
+        manager_clear_jobs(m);
+
+        phase_begin(&phase, "daemon-reload");
+        assert_se(manager_reload(m) >= 0);
+        phase_end(&phase, m);
+
+        phase_begin(&phase, "transaction after reload");
+        assert_se(manager_load_startable_unit_or_warn(m, "bench.target", NULL, &target) >= 0);
+        assert_se(manager_add_job(m, JOB_START, target, JOB_REPLACE, NULL, NULL, &j) >= 0);
+        phase_end(&phase, m);
+
+        return 0;
+}
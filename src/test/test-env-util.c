@@ -7,6 +7,7 @@
 #include "parse-util.h"
 #include "process-util.h"
 #include "serialize.h"
+#include "stdio-util.h"
 #include "string-util.h"
 #include "strv.h"
 #include "tests.h"
@@ -100,6 +101,56 @@ static void test_strv_env_merge(void) {
         assert_se(strv_length(r) == 5);
 }
 
+static void test_strv_env_merge_many(void) {
+        log_info("/* %s */", __func__);
+
+        _cleanup_strv_free_ char **a = NULL, **b = NULL, **r = NULL;
+
+        /* Large enough to go through the hashed code paths, but with the same leading entries as above */
+        a = strv_new("FOO=BAR", "WALDO=WALDO", "WALDO=", "PIEP", "SCHLUMPF=SMURF");
+        assert_se(a);
+
+        b = strv_new("FOO=KKK", "FOO=", "PIEP=", "SCHLUMPF=SMURFF", "NANANANA=YES");
+        assert_se(b);
+
+        for (unsigned i = 0; i < 100; i++) {
+                assert_se(strv_extendf(&a, "VAR%u=a", i) >= 0);
+                if (i % 2 == 0)
+                        assert_se(strv_extendf(&b, "VAR%u=b", i) >= 0);
+        }
+
+        r = strv_env_merge(2, a, b);
+        assert_se(r);
+        assert_se(streq(r[0], "FOO="));
+        assert_se(streq(r[1], "WALDO="));
+        assert_se(streq(r[2], "PIEP"));
+        assert_se(streq(r[3], "SCHLUMPF=SMURFF"));
+        for (unsigned i = 0; i < 100; i++) {
+                char buf[STRLEN("VAR=a") + DECIMAL_STR_MAX(unsigned)];
+
+                xsprintf(buf, "VAR%u=%c", i, i % 2 == 0 ? 'b' : 'a');
+                assert_se(streq(r[4 + i], buf));
+        }
+        assert_se(streq(r[104], "PIEP="));
+        assert_se(streq(r[105], "NANANANA=YES"));
+        assert_se(strv_length(r) == 106);
+
+        assert_se(strv_extend(&r, "VAR7=c") >= 0);
+        assert_se(strv_extend(&r, "FOO=again") >= 0);
+
+        assert_se(strv_env_clean(r) == r);
+        assert_se(streq(r[0], "WALDO="));
+        assert_se(streq(r[1], "SCHLUMPF=SMURFF"));
+        assert_se(streq(r[2], "VAR0=b"));
+        assert_se(streq(r[8], "VAR6=b"));
+        assert_se(streq(r[9], "VAR8=b"));
+        assert_se(streq(r[101], "PIEP="));
+        assert_se(streq(r[102], "NANANANA=YES"));
+        assert_se(streq(r[103], "VAR7=c"));
+        assert_se(streq(r[104], "FOO=again"));
+        assert_se(strv_length(r) == 105);
+}
+
 static void test_strv_env_replace_strdup(void) {
         log_info("/* %s */", __func__);
 
@@ -417,6 +468,7 @@ int main(int argc, char *argv[]) {
         test_strv_env_pairs_get();
         test_strv_env_unset();
         test_strv_env_merge();
+        test_strv_env_merge_many();
         test_strv_env_replace_strdup();
         test_strv_env_assign();
         test_env_strv_get_n();
@@ -0,0 +1,132 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "errno-util.h"
+#include "event-group.h"
+#include "fd-util.h"
+#include "socket-util.h"
+#include "tests.h"
+#include "time-util.h"
+
+static unsigned n_received = 0;
+
+static int on_connection(sd_event_source *s, int fd, uint32_t revents, void *userdata) {
+        char c;
+
+        assert_se(read(fd, &c, 1) == 1);
+        assert_se(c == 'x');
+
+        __atomic_add_fetch(&n_received, 1, __ATOMIC_SEQ_CST);
+
+        assert_se(sd_event_source_set_enabled(s, SD_EVENT_OFF) >= 0);
+        return 0;
+}
+
+static int on_listen(sd_event_source *s, int fd, uint32_t revents, void *userdata) {
+        sd_event_source *c;
+        int cfd;
+
+        cfd = accept4(fd, NULL, NULL, SOCK_NONBLOCK|SOCK_CLOEXEC);
+        if (cfd < 0) {
+                /* Another loop was quicker */
+                assert_se(ERRNO_IS_ACCEPT_AGAIN(errno));
+                return 0;
+        }
+
+        assert_se(sd_event_add_io(sd_event_source_get_event(s), &c, cfd, EPOLLIN, on_connection, NULL) >= 0);
+        assert_se(sd_event_source_set_io_fd_own(c, true) >= 0);
+        assert_se(sd_event_source_set_floating(c, true) >= 0);
+        sd_event_source_unref(c);
+        return 0;
+}
+
+static void test_event_group_shared_socket(void) {
+        _cleanup_close_ int lfd = -1;
+        _cleanup_(event_group_freep) EventGroup *g = NULL;
+        union sockaddr_union sa = {};
+        socklen_t salen = sizeof sa.un;
+        int cfds[32];
+
+        log_info("/* %s */", __func__);
+
+        assert_se(event_group_new(4, &g) >= 0);
+        assert_se(event_group_size(g) == 4);
+
+        /* Autobind to an abstract socket address */
+        assert_se((lfd = socket(AF_UNIX, SOCK_STREAM|SOCK_NONBLOCK|SOCK_CLOEXEC, 0)) >= 0);
+        sa.un.sun_family = AF_UNIX;
+        assert_se(bind(lfd, &sa.sa, offsetof(struct sockaddr_un, sun_path)) >= 0);
+        assert_se(getsockname(lfd, &sa.sa, &salen) >= 0);
+        assert_se(listen(lfd, SOMAXCONN) >= 0);
+
+        assert_se(event_group_add_io(g, lfd, EPOLLIN, on_listen, NULL) >= 0);
+        assert_se(event_group_start(g) >= 0);
+
+        for (size_t i = 0; i < ELEMENTSOF(cfds); i++) {
+                assert_se((cfds[i] = socket(AF_UNIX, SOCK_STREAM|SOCK_CLOEXEC, 0)) >= 0);
+                assert_se(connect(cfds[i], &sa.sa, salen) >= 0);
+                assert_se(write(cfds[i], "x", 1) == 1);
+        }
+
+        for (usec_t end = usec_add(now(CLOCK_MONOTONIC), 10 * USEC_PER_SEC);
+             __atomic_load_n(&n_received, __ATOMIC_SEQ_CST) < ELEMENTSOF(cfds);) {
+                assert_se(now(CLOCK_MONOTONIC) < end);
+                assert_se(usleep(10 * USEC_PER_MSEC) >= 0);
+        }
+
+        assert_se(event_group_stop(g) >= 0);
+
+        for (size_t i = 0; i < ELEMENTSOF(cfds); i++)
+                safe_close(cfds[i]);
+}
+
+static int on_defer(sd_event_source *s, void *userdata) {
+        __atomic_add_fetch((unsigned*) userdata, 1, __ATOMIC_SEQ_CST);
+        return 0;
+}
+
+static void test_event_group_round_robin(void) {
+        _cleanup_(event_group_freep) EventGroup *g = NULL;
+        unsigned counters[3] = {};
+
+        log_info("/* %s */", __func__);
+
+        assert_se(event_group_new(3, &g) >= 0);
+
+        for (unsigned i = 0; i < 3; i++)
+                assert_se(event_group_next_event(g) == event_group_get_event(g, i));
+
+        for (unsigned i = 0; i < 9; i++) {
+                unsigned k = i % 3;
+
+                assert_se(sd_event_add_defer(event_group_next_event(g), NULL, on_defer, counters + k) >= 0);
+        }
+
+        assert_se(event_group_start(g) >= 0);
+
+        for (usec_t end = usec_add(now(CLOCK_MONOTONIC), 10 * USEC_PER_SEC);;) {
+                unsigned n = 0;
+
+                for (unsigned k = 0; k < 3; k++)
+                        n += __atomic_load_n(counters + k, __ATOMIC_SEQ_CST);
+                if (n == 9)
+                        break;
+
+                assert_se(now(CLOCK_MONOTONIC) < end);
+                assert_se(usleep(10 * USEC_PER_MSEC) >= 0);
+        }
+
+        /* Freeing the group stops it */
+}
+
+int main(int argc, char *argv[]) {
+        test_setup_logging(LOG_DEBUG);
+
+        test_event_group_shared_socket();
+        test_event_group_round_robin();
+
+        return 0;
+}
@@ -20,6 +20,7 @@
 #include "string-util.h"
 #include "strv.h"
 #include "tests.h"
+#include "tmpfile-util.h"
 
 static int here = 0, here2 = 0, here3 = 0;
 void *ignore_stdout_args[] = {&here, &here2, &here3};
@@ -413,6 +414,42 @@ static void test_error_catching(void) {
         assert_se(r == 42);
 }
 
+static void test_timings(void) {
+        _cleanup_(rm_rf_physical_and_freep) char *tmpdir = NULL;
+        ExecDirTiming *timings = NULL;
+        const char *dirs[2] = {}, *fast, *slow;
+        size_t n = 0;
+        int r;
+
+        log_info("/* %s */", __func__);
+
+        assert_se(mkdtemp_malloc("/tmp/test-exec-util.XXXXXXX", &tmpdir) >= 0);
+        dirs[0] = tmpdir;
+
+        slow = strjoina(tmpdir, "/10-slow");
+        fast = strjoina(tmpdir, "/20-fast");
+
+        assert_se(write_string_file(slow, "#!/bin/sh\nsleep 0.5\n", WRITE_STRING_FILE_CREATE) == 0);
+        assert_se(write_string_file(fast, "#!/bin/sh\nexit 0\n", WRITE_STRING_FILE_CREATE) == 0);
+        assert_se(chmod(slow, 0755) == 0);
+        assert_se(chmod(fast, 0755) == 0);
+
+        if (access(slow, X_OK) < 0 && ERRNO_IS_PRIVILEGE(errno))
+                return;
+
+        r = execute_directories_full(dirs, DEFAULT_TIMEOUT_USEC, NULL, NULL, NULL, NULL, EXEC_DIR_PARALLEL, &timings, &n);
+        assert_se(r == 0);
+
+        /* Scripts are reaped in the order they finish */
+        assert_se(n == 2);
+        assert_se(streq(timings[0].path, fast));
+        assert_se(streq(timings[1].path, slow));
+        assert_se(timings[0].start <= timings[0].finish);
+        assert_se(timings[1].finish - timings[1].start >= 500 * USEC_PER_MSEC);
+
+        exec_dir_timing_free_many(timings, n);
+}
+
 static void test_exec_command_flags_from_strv(void) {
         ExecCommandFlags flags = 0;
         char **valid_strv = STRV_MAKE("no-env-expand", "no-setuid", "ignore-failure");
@@ -466,6 +503,7 @@ int main(int argc, char *argv[]) {
         test_stdout_gathering();
         test_environment_gathering();
         test_error_catching();
+        test_timings();
         test_exec_command_flags_from_strv();
         test_exec_command_flags_to_strv();
 
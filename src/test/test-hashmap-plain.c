@@ -783,6 +783,64 @@ static void test_hashmap_many(void) {
         }
 }
 
+static void benchmark_log(const char *title, const char *op, unsigned n, usec_t ts) {
+        char b[FORMAT_TIMESPAN_MAX];
+        usec_t d = now(CLOCK_MONOTONIC) - ts;
+
+        log_info("%s: %-7s %u entries in %s (%.1fns/op)",
+                 title, op, n, format_timespan(b, sizeof b, d, 1), (double) d * 1000 / n);
+}
+
+static void test_hashmap_benchmark(void) {
+        bool slow = slow_tests_enabled();
+        unsigned n_entries = slow ? 1 << 20 : 1 << 14;
+        _cleanup_strv_free_ char **strings = NULL;
+
+        log_info("/* %s (%s, %u entries) */", __func__, slow ? "slow" : "fast", n_entries);
+
+        assert_se(strings = new0(char*, n_entries + 1));
+        for (unsigned i = 0; i < n_entries; i++)
+                assert_se(asprintf(strings + i, "/sys/devices/virtual/net/veth%u", i) >= 0);
+
+        for (unsigned j = 0; j < 3; j++) {
+                const char *title = j == 0 ? "pointer keys" : j == 1 ? "pointer keys, fast" : "string keys";
+                _cleanup_hashmap_free_ Hashmap *h = NULL;
+                const void *k;
+                unsigned n = 0;
+                usec_t ts;
+                void *v;
+
+                assert_se(h = hashmap_new(j == 0 ? NULL : j == 1 ? &trivial_hash_ops_fast : &string_hash_ops));
+
+                ts = now(CLOCK_MONOTONIC);
+                for (unsigned i = 0; i < n_entries; i++)
+                        assert_se(hashmap_put(h, j < 2 ? (const void*) UINT_TO_PTR(i + 1) : strings[i], UINT_TO_PTR(i + 1)) > 0);
+                benchmark_log(title, "insert", n_entries, ts);
+
+                ts = now(CLOCK_MONOTONIC);
+                for (unsigned i = 0; i < n_entries; i++)
+                        assert_se(PTR_TO_UINT(hashmap_get(h, j < 2 ? (const void*) UINT_TO_PTR(i + 1) : strings[i])) == i + 1);
+                benchmark_log(title, "lookup", n_entries, ts);
+
+                ts = now(CLOCK_MONOTONIC);
+                for (unsigned i = 0; i < n_entries; i++)
+                        assert_se(!hashmap_get(h, j < 2 ? (const void*) UINT_TO_PTR(n_entries + i + 1) : strings[i] + 1));
+                benchmark_log(title, "miss", n_entries, ts);
+
+                ts = now(CLOCK_MONOTONIC);
+                HASHMAP_FOREACH_KEY(v, k, h)
+                        n++;
+                assert_se(n == n_entries);
+                benchmark_log(title, "iterate", n_entries, ts);
+
+                ts = now(CLOCK_MONOTONIC);
+                for (unsigned i = 0; i < n_entries; i++)
+                        assert_se(PTR_TO_UINT(hashmap_remove(h, j < 2 ? (const void*) UINT_TO_PTR(i + 1) : strings[i])) == i + 1);
+                assert_se(hashmap_isempty(h));
+                benchmark_log(title, "remove", n_entries, ts);
+        }
+}
+
 extern unsigned custom_counter;
 extern const struct hash_ops boring_hash_ops, custom_hash_ops;
 
@@ -1085,6 +1143,7 @@ void test_hashmap_funcs(void) {
         test_hashmap_size();
         test_hashmap_many();
         test_hashmap_free();
+        test_hashmap_benchmark();
         test_hashmap_free_with_destructor();
         test_hashmap_first();
         test_hashmap_first_key();
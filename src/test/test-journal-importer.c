@@ -5,6 +5,7 @@
 #include <fcntl.h>
 
 #include "alloc-util.h"
+#include "fileio.h"
 #include "log.h"
 #include "journal-importer.h"
 #include "path-util.h"
@@ -68,11 +69,48 @@ static void test_bad_input(void) {
         assert_se(journal_importer_eof(&imp));
 }
 
+static void test_passive_parsing(void) {
+        _cleanup_(journal_importer_cleanup) JournalImporter imp = JOURNAL_IMPORTER_INIT(-1);
+        _cleanup_free_ char *journal_data_path = NULL, *data = NULL;
+        size_t size, i = 0;
+        int r;
+
+        assert_se(get_testdata_dir("journal-data/journal-1.txt", &journal_data_path) >= 0);
+        assert_se(read_full_file(journal_data_path, &data, &size) >= 0);
+
+        /* Pushed in small pieces, the entry is only complete once the final newline came in, and we hear
+         * that we need more data in between */
+        imp.fd = STDIN_FILENO;
+        imp.passive_fd = true;
+
+        for (;;) {
+                size_t k = MIN(size - i, 7u);
+
+                assert_se(k > 0);
+                assert_se(journal_importer_push_data(&imp, data + i, k) >= 0);
+                i += k;
+
+                r = journal_importer_process_data(&imp);
+                if (r != -EAGAIN)
+                        break;
+        }
+        assert_se(r == 1);
+
+        assert_se(imp.iovw.count == 6);
+        assert_iovec_entry(&imp.iovw.iovec[0], "_BOOT_ID=1531fd22ec84429e85ae888b12fadb91");
+        assert_iovec_entry(&imp.iovw.iovec[1], "_TRANSPORT=journal");
+        assert_iovec_entry(&imp.iovw.iovec[2], COREDUMP_PROC_GROUP);
+        assert_iovec_entry(&imp.iovw.iovec[3], "COREDUMP_RLIMIT=-1");
+        assert_iovec_entry(&imp.iovw.iovec[4], COREDUMP_PROC_GROUP);
+        assert_iovec_entry(&imp.iovw.iovec[5], "_SOURCE_REALTIME_TIMESTAMP=1478389147837945");
+}
+
 int main(int argc, char **argv) {
         test_setup_logging(LOG_DEBUG);
 
         test_basic_parsing();
         test_bad_input();
+        test_passive_parsing();
 
         return 0;
 }
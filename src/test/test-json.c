@@ -391,6 +391,61 @@ static void test_source(void) {
         printf("--- pretty end ---\n");
 }
 
+static void test_binary(void) {
+        _cleanup_(json_variant_unrefp) JsonVariant *v = NULL, *w = NULL;
+        _cleanup_free_ void *data = NULL;
+        size_t size;
+
+        log_info("/* %s */", __func__);
+
+        assert_se(json_build(&v, JSON_BUILD_OBJECT(
+                                             JSON_BUILD_PAIR("a", JSON_BUILD_ARRAY(JSON_BUILD_UNSIGNED(1), JSON_BUILD_INTEGER(-2), JSON_BUILD_BOOLEAN(true), JSON_BUILD_NULL)))) >= 0);
+        assert_se(json_variant_format_binary(v, &data, &size) >= 0);
+        assert_se(size == 8);
+        assert_se(memcmp(data, (const uint8_t[]) { 0xa1, 0x61, 'a', 0x84, 0x01, 0x21, 0xf5, 0xf6 }, size) == 0);
+        assert_se(json_parse_binary(data, size, 0, &w) >= 0);
+        assert_se(json_variant_equal(v, w));
+
+        v = json_variant_unref(v);
+        w = json_variant_unref(w);
+        data = mfree(data);
+
+        assert_se(json_build(&v, JSON_BUILD_OBJECT(
+                                             JSON_BUILD_PAIR("empty", JSON_BUILD_STRING("")),
+                                             JSON_BUILD_PAIR("string", JSON_BUILD_STRING("Gr\xc3\xbc\xc3\x9f" "e \"foo\"\n")),
+                                             JSON_BUILD_PAIR("long", JSON_BUILD_STRING("Lorem ipsum dolor sit amet, consectetur adipiscing elit")),
+                                             JSON_BUILD_PAIR("max", JSON_BUILD_UNSIGNED(UINT64_MAX)),
+                                             JSON_BUILD_PAIR("min", JSON_BUILD_INTEGER(INT64_MIN)),
+                                             JSON_BUILD_PAIR("number", JSON_BUILD_UNSIGNED(65536)),
+                                             JSON_BUILD_PAIR("real", JSON_BUILD_REAL(0.125)),
+                                             JSON_BUILD_PAIR("false", JSON_BUILD_BOOLEAN(false)),
+                                             JSON_BUILD_PAIR("empty-array", JSON_BUILD_EMPTY_ARRAY),
+                                             JSON_BUILD_PAIR("empty-object", JSON_BUILD_EMPTY_OBJECT),
+                                             JSON_BUILD_PAIR("nested", JSON_BUILD_OBJECT(JSON_BUILD_PAIR("array", JSON_BUILD_ARRAY(JSON_BUILD_STRING("a"), JSON_BUILD_STRING("b"), JSON_BUILD_STRING("c"))))))) >= 0);
+        assert_se(json_variant_format_binary(v, &data, &size) >= 0);
+        assert_se(json_parse_binary(data, size, 0, &w) >= 0);
+        assert_se(json_variant_equal(v, w));
+        assert_se(json_variant_unsigned(json_variant_by_key(w, "max")) == UINT64_MAX);
+        assert_se(json_variant_integer(json_variant_by_key(w, "min")) == INT64_MIN);
+
+        /* Truncated input and trailing garbage */
+        assert_se(json_parse_binary(data, size - 1, 0, &w) == -EBADMSG);
+        assert_se(json_parse_binary((const uint8_t[]) { 0xf6, 0xf6 }, 2, 0, &w) == -EBADMSG);
+        assert_se(json_parse_binary(NULL, 0, 0, &w) == -EBADMSG);
+
+        /* Things that have no JSON equivalent or that we don't generate */
+        assert_se(json_parse_binary((const uint8_t[]) { 0x9f, 0xff }, 2, 0, &w) == -EBADMSG);
+        assert_se(json_parse_binary((const uint8_t[]) { 0x41, 'a' }, 2, 0, &w) == -EBADMSG);
+        assert_se(json_parse_binary((const uint8_t[]) { 0xc0, 0x01 }, 2, 0, &w) == -EBADMSG);
+        assert_se(json_parse_binary((const uint8_t[]) { 0xf7 }, 1, 0, &w) == -EBADMSG);
+        assert_se(json_parse_binary((const uint8_t[]) { 0xa1, 0x01, 0x02 }, 3, 0, &w) == -EBADMSG);
+        assert_se(json_parse_binary((const uint8_t[]) { 0x9b, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff }, 9, 0, &w) == -EBADMSG);
+
+        /* Strings must be valid JSON strings */
+        assert_se(json_parse_binary((const uint8_t[]) { 0x61, 0x00 }, 2, 0, &w) == -EINVAL);
+        assert_se(json_parse_binary((const uint8_t[]) { 0x61, 0xff }, 2, 0, &w) == -EUCLEAN);
+}
+
 static void test_depth(void) {
         log_info("/* %s */", __func__);
 
@@ -558,6 +613,11 @@ int main(int argc, char *argv[]) {
         test_tokenizer("\"\\ud800a\"", -EINVAL);
         test_tokenizer("\"\\udc00\\udc00\"", -EINVAL);
         test_tokenizer("\"\\ud801\\udc37\"", JSON_TOKEN_STRING, "\xf0\x90\x90\xb7", JSON_TOKEN_END);
+        test_tokenizer("\"foo \xc3\xa4\\tbar\\\"\xe2\x98\x83/baz\"", JSON_TOKEN_STRING, "foo \xc3\xa4\tbar\"\xe2\x98\x83/baz", JSON_TOKEN_END);
+        test_tokenizer("\"foo\x01\"", -EINVAL);
+        test_tokenizer("\"foo\x7f\"", -EINVAL);
+        test_tokenizer("\"foo\xc3\"", -EINVAL);
+        test_tokenizer("\"foo", -EINVAL);
 
         test_tokenizer("[1, 2, -3]", JSON_TOKEN_ARRAY_OPEN, JSON_TOKEN_UNSIGNED, (uintmax_t) 1, JSON_TOKEN_COMMA, JSON_TOKEN_UNSIGNED, (uintmax_t) 2, JSON_TOKEN_COMMA, JSON_TOKEN_INTEGER, (intmax_t) -3, JSON_TOKEN_ARRAY_CLOSE, JSON_TOKEN_END);
 
@@ -570,6 +630,7 @@ int main(int argc, char *argv[]) {
         test_build();
         test_source();
         test_depth();
+        test_binary();
 
         test_normalize();
         test_bisect();
@@ -0,0 +1,83 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include "metrics.h"
+#include "string-util.h"
+#include "tests.h"
+
+static void test_metric_histogram(void) {
+        _cleanup_(json_variant_unrefp) JsonVariant *v = NULL;
+        MetricHistogram h = {};
+
+        log_info("/* %s */", __func__);
+
+        metric_histogram_record(&h, 0);
+        metric_histogram_record(&h, 9);
+        metric_histogram_record(&h, 10);
+        metric_histogram_record(&h, 999999);
+        metric_histogram_record(&h, USEC_PER_SEC);
+        metric_histogram_record(&h, USEC_PER_HOUR);
+
+        assert_se(h.count == 6);
+        assert_se(h.max == USEC_PER_HOUR);
+        assert_se(h.sum == 9 + 10 + 999999 + USEC_PER_SEC + USEC_PER_HOUR);
+        assert_se(h.buckets[0] == 2);
+        assert_se(h.buckets[1] == 1);
+        assert_se(h.buckets[5] == 1);
+        assert_se(h.buckets[METRIC_HISTOGRAM_BUCKETS - 1] == 2);
+
+        assert_se(metric_histogram_build_json(&h, &v) >= 0);
+        assert_se(json_variant_elements(v) == METRIC_HISTOGRAM_BUCKETS);
+        assert_se(json_variant_unsigned(json_variant_by_key(json_variant_by_index(v, 0), "belowUSec")) == 10);
+        assert_se(json_variant_unsigned(json_variant_by_key(json_variant_by_index(v, 0), "count")) == 2);
+        assert_se(!json_variant_by_key(json_variant_by_index(v, METRIC_HISTOGRAM_BUCKETS - 1), "belowUSec"));
+}
+
+static void test_metrics_build_json(void) {
+        _cleanup_(json_variant_unrefp) JsonVariant *v = NULL;
+        MetricHistogram h = {};
+        JsonVariant *a, *e;
+
+        log_info("/* %s */", __func__);
+
+        metric_histogram_record(&h, 42);
+
+        const Metric metrics[] = {
+                METRIC_COUNTER_MAKE("foo", "Some counter", 7),
+                METRIC_GAUGE_MAKE("bar", NULL, 3),
+                METRIC_HISTOGRAM_MAKE("baz", "Some histogram", &h),
+        };
+
+        assert_se(metrics_build_json(metrics, ELEMENTSOF(metrics), &v) >= 0);
+        json_variant_dump(v, JSON_FORMAT_NEWLINE, stdout, NULL);
+
+        assert_se(a = json_variant_by_key(v, "metrics"));
+        assert_se(json_variant_elements(a) == 3);
+
+        e = json_variant_by_index(a, 0);
+        assert_se(streq(json_variant_string(json_variant_by_key(e, "name")), "foo"));
+        assert_se(streq(json_variant_string(json_variant_by_key(e, "type")), "counter"));
+        assert_se(json_variant_unsigned(json_variant_by_key(e, "value")) == 7);
+
+        e = json_variant_by_index(a, 1);
+        assert_se(streq(json_variant_string(json_variant_by_key(e, "type")), "gauge"));
+        assert_se(!json_variant_by_key(e, "description"));
+
+        e = json_variant_by_index(a, 2);
+        assert_se(streq(json_variant_string(json_variant_by_key(e, "type")), "histogram"));
+        assert_se(json_variant_unsigned(json_variant_by_key(e, "count")) == 1);
+        assert_se(json_variant_unsigned(json_variant_by_key(e, "sumUSec")) == 42);
+        assert_se(json_variant_elements(json_variant_by_key(e, "buckets")) == METRIC_HISTOGRAM_BUCKETS);
+
+        v = json_variant_unref(v);
+        assert_se(metrics_build_json(NULL, 0, &v) >= 0);
+        assert_se(json_variant_elements(json_variant_by_key(v, "metrics")) == 0);
+}
+
+int main(int argc, char *argv[]) {
+        test_setup_logging(LOG_INFO);
+
+        test_metric_histogram();
+        test_metrics_build_json();
+
+        return 0;
+}
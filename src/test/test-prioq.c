@@ -119,10 +119,59 @@ static void test_struct(void) {
         assert_se(set_isempty(s));
 }
 
+static uint64_t test_key(const void *p) {
+        const struct test *t = p;
+
+        /* Only the upper bits, so that many items share a key, and the compare function has to order them */
+        return t->value >> 24;
+}
+
+static void test_keyed(void) {
+        _cleanup_(prioq_freep) Prioq *q = NULL;
+        struct test *items;
+        unsigned previous = 0, i;
+
+        srand(0);
+
+        assert_se(q = prioq_new_keyed(test_key, (compare_func_t) test_compare));
+        assert_se(items = new(struct test, SET_SIZE));
+
+        for (i = 0; i < SET_SIZE; i++) {
+                items[i].value = (unsigned) rand();
+                assert_se(prioq_put(q, items + i, &items[i].idx) >= 0);
+        }
+
+        /* Move some items, one by one */
+        for (i = 0; i < SET_SIZE; i += 3) {
+                items[i].value = (unsigned) rand();
+                assert_se(prioq_reshuffle(q, items + i, &items[i].idx) == 1);
+        }
+
+        /* And then all of them at once */
+        for (i = 0; i < SET_SIZE; i++)
+                items[i].value = UINT_MAX - items[i].value;
+        prioq_reshuffle_all(q);
+
+        for (i = 0; i < SET_SIZE; i++)
+                assert_se(prioq_peek_by_index(q, items[i].idx) == items + i);
+
+        for (i = 0; i < SET_SIZE; i++) {
+                struct test *t;
+
+                assert_se(t = prioq_pop(q));
+                assert_se(previous <= t->value);
+                previous = t->value;
+        }
+
+        assert_se(prioq_isempty(q));
+        free(items);
+}
+
 int main(int argc, char* argv[]) {
 
         test_unsigned();
         test_struct();
+        test_keyed();
 
         return 0;
 }
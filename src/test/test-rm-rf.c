@@ -65,10 +65,42 @@ static void test_rm_rf_chmod(void) {
         test_rm_rf_chmod_inner();
 }
 
+static void test_rm_rf_empty_dirs(void) {
+        _cleanup_free_ char *d = NULL;
+        const char *x, *y, *z;
+
+        log_info("/* %s */", __func__);
+
+        assert_se(mkdtemp_malloc(NULL, &d) >= 0);
+
+        /* Mix empty leaf directories, which are removed directly, with non-empty ones */
+        x = strjoina(d, "/empty");
+        assert_se(mkdir(x, 0700) >= 0);
+        y = strjoina(d, "/full");
+        assert_se(mkdir(y, 0700) >= 0);
+        z = strjoina(y, "/empty");
+        assert_se(mkdir(z, 0700) >= 0);
+        z = strjoina(y, "/f");
+        assert_se(mknod(z, S_IFREG | 0600, 0) >= 0);
+
+        assert_se(rm_rf(d, REMOVE_PHYSICAL) >= 0);
+
+        assert_se(access(d, F_OK) >= 0);
+        errno = 0;
+        assert_se(access(x, F_OK) < 0 && errno == ENOENT);
+        errno = 0;
+        assert_se(access(y, F_OK) < 0 && errno == ENOENT);
+
+        assert_se(rm_rf(d, REMOVE_PHYSICAL|REMOVE_ROOT) >= 0);
+        errno = 0;
+        assert_se(access(d, F_OK) < 0 && errno == ENOENT);
+}
+
 int main(int argc, char **argv) {
         test_setup_logging(LOG_DEBUG);
 
         test_rm_rf_chmod();
+        test_rm_rf_empty_dirs();
 
         return 0;
 }
@@ -0,0 +1,70 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include "string-intern.h"
+#include "string-util.h"
+#include "strv.h"
+#include "tests.h"
+
+static void test_string_intern(void) {
+        _cleanup_(string_intern_table_freep) StringInternTable *t = NULL;
+        char buf[] = "foo";
+        const char *a, *b, *c;
+
+        log_info("/* %s */", __func__);
+
+        assert_se(string_intern_table_size(t) == 0);
+
+        assert_se(a = string_intern(&t, "foo"));
+        assert_se(b = string_intern(&t, buf));
+        assert_se(c = string_intern(&t, "bar"));
+        assert_se(a != buf);
+        assert_se(string_interned_equal(a, b));
+        assert_se(!string_interned_equal(a, c));
+        assert_se(streq(a, "foo"));
+        assert_se(streq(c, "bar"));
+        assert_se(string_intern_table_size(t) == 2);
+
+        assert_se(!string_unintern(t, a));
+        assert_se(string_intern_table_size(t) == 2);
+        assert_se(streq(b, "foo"));
+        assert_se(!string_unintern(t, b));
+        assert_se(string_intern_table_size(t) == 1);
+        assert_se(!string_unintern(t, c));
+        assert_se(string_intern_table_size(t) == 0);
+
+        assert_se(!string_unintern(t, NULL));
+}
+
+static void test_strv_intern(void) {
+        _cleanup_(string_intern_table_freep) StringInternTable *t = NULL;
+        char **a, **b;
+
+        log_info("/* %s */", __func__);
+
+        assert_se(a = strv_intern(&t, STRV_MAKE("a", "b", "c")));
+        assert_se(b = strv_intern(&t, STRV_MAKE("c", "d")));
+        assert_se(strv_equal(a, STRV_MAKE("a", "b", "c")));
+        assert_se(strv_equal(b, STRV_MAKE("c", "d")));
+        assert_se(a[2] == b[0]);
+        assert_se(string_intern_table_size(t) == 4);
+
+        assert_se(!strv_unintern(t, a));
+        assert_se(string_intern_table_size(t) == 2);
+        assert_se(streq(b[0], "c"));
+
+        assert_se(!strv_unintern(t, b));
+        assert_se(string_intern_table_size(t) == 0);
+
+        assert_se(a = strv_intern(&t, NULL));
+        assert_se(strv_isempty(a));
+        assert_se(!strv_unintern(t, a));
+}
+
+int main(int argc, char *argv[]) {
+        test_setup_logging(LOG_DEBUG);
+
+        test_string_intern();
+        test_strv_intern();
+
+        return 0;
+}
@@ -1,10 +1,18 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
+#include <unistd.h>
+
+#include "fileio.h"
+#include "fs-util.h"
+#include "mkdir.h"
 #include "path-lookup.h"
+#include "path-util.h"
+#include "rm-rf.h"
 #include "set.h"
 #include "special.h"
 #include "strv.h"
 #include "tests.h"
+#include "tmpfile-util.h"
 #include "unit-file.h"
 
 static void test_unit_validate_alias_symlink_and_warn(void) {
@@ -73,6 +81,84 @@ static void test_unit_file_build_name_map(char **ids) {
         }
 }
 
+static void test_lookup_paths_generated_hash(void) {
+        _cleanup_(lookup_paths_free) LookupPaths lp = {};
+        _cleanup_free_ char *a = NULL, *b = NULL, *c = NULL;
+        uint64_t h0, h1, h2, h;
+
+        log_info("/* %s */", __func__);
+
+        assert_se(lookup_paths_init(&lp, UNIT_FILE_SYSTEM, LOOKUP_PATHS_TEMPORARY_GENERATED, NULL) >= 0);
+        assert_se(mkdir_p(lp.generator, 0755) >= 0);
+        assert_se(mkdir_p(lp.generator_late, 0755) >= 0);
+
+        assert_se(a = path_join(lp.generator, "a.service"));
+        assert_se(b = path_join(lp.generator_late, "b.service"));
+        assert_se(c = path_join(lp.generator_late, "c.service"));
+
+        assert_se(lookup_paths_generated_hash(&lp, &h0) >= 0);
+
+        assert_se(write_string_file(a, "[Service]\nExecStart=/bin/true", WRITE_STRING_FILE_CREATE) >= 0);
+        assert_se(symlink("a.service", b) >= 0);
+        assert_se(lookup_paths_generated_hash(&lp, &h1) >= 0);
+        assert_se(h1 != h0);
+
+        /* Generators writing the same files again, in a different order, don't change the hash */
+        assert_se(rm_rf(lp.generator, REMOVE_PHYSICAL) >= 0);
+        assert_se(rm_rf(lp.generator_late, REMOVE_PHYSICAL) >= 0);
+        assert_se(lookup_paths_generated_hash(&lp, &h) >= 0);
+        assert_se(h == h0);
+        assert_se(symlink("a.service", b) >= 0);
+        assert_se(write_string_file(a, "[Service]\nExecStart=/bin/false", WRITE_STRING_FILE_CREATE) >= 0);
+        assert_se(lookup_paths_generated_hash(&lp, &h) >= 0);
+        assert_se(h == h1);
+
+        /* Different symlink targets, emptied files and additional files do */
+        assert_se(unlink(b) >= 0);
+        assert_se(symlink("/dev/null", b) >= 0);
+        assert_se(lookup_paths_generated_hash(&lp, &h2) >= 0);
+        assert_se(h2 != h0 && h2 != h1);
+
+        assert_se(write_string_file(a, "", WRITE_STRING_FILE_CREATE|WRITE_STRING_FILE_TRUNCATE|WRITE_STRING_FILE_AVOID_NEWLINE) >= 0);
+        assert_se(lookup_paths_generated_hash(&lp, &h) >= 0);
+        assert_se(h != h0 && h != h1 && h != h2);
+
+        assert_se(touch(c) >= 0);
+        assert_se(lookup_paths_generated_hash(&lp, &h2) >= 0);
+        assert_se(h2 != h);
+
+        assert_se(rm_rf(lp.temporary_dir, REMOVE_ROOT|REMOVE_PHYSICAL) >= 0);
+}
+
+static void test_lookup_paths_dirs_timestamp_hash(void) {
+        _cleanup_(rm_rf_physical_and_freep) char *root = NULL;
+        _cleanup_(lookup_paths_free) LookupPaths lp = {};
+        _cleanup_free_ char *unit_dir = NULL, *wants = NULL, *link = NULL;
+        uint64_t h0, h1, h, ts;
+
+        log_info("/* %s */", __func__);
+
+        assert_se(mkdtemp_malloc("/tmp/test-unit-file.XXXXXX", &root) >= 0);
+        assert_se(lookup_paths_init(&lp, UNIT_FILE_SYSTEM, 0, root) >= 0);
+
+        assert_se(unit_dir = path_join(root, "/etc/systemd/system"));
+        assert_se(wants = path_join(unit_dir, "multi-user.target.wants"));
+        assert_se(link = path_join(wants, "a.service"));
+        assert_se(mkdir_p(wants, 0755) >= 0);
+
+        assert_se(lookup_paths_dirs_timestamp_hash(&lp, &h0) >= 0);
+        assert_se(lookup_paths_dirs_timestamp_hash(&lp, &h) >= 0);
+        assert_se(h == h0);
+        (void) lookup_paths_timestamp_hash_same(&lp, 0, &ts);
+
+        /* Enabling a unit only touches the .wants/ directory, not the unit directory itself */
+        usleep(10 * USEC_PER_MSEC);
+        assert_se(symlink("/etc/systemd/system/a.service", link) >= 0);
+        assert_se(lookup_paths_dirs_timestamp_hash(&lp, &h1) >= 0);
+        assert_se(h1 != h0);
+        assert_se(lookup_paths_timestamp_hash_same(&lp, ts, NULL));
+}
+
 static void test_runlevel_to_target(void) {
         log_info("/* %s */", __func__);
 
@@ -96,6 +182,8 @@ int main(int argc, char **argv) {
 
         test_unit_validate_alias_symlink_and_warn();
         test_unit_file_build_name_map(strv_skip(argv, 1));
+        test_lookup_paths_generated_hash();
+        test_lookup_paths_dirs_timestamp_hash();
         test_runlevel_to_target();
 
         return 0;
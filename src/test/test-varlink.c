@@ -20,6 +20,10 @@
    should cover any auxiliary fds, the listener server fds, stdin/stdout/stderr and whatever else. */
 #define OVERLOAD_CONNECTIONS 333
 
+/* Enough replies to a single call to exceed the socket buffers many times over */
+#define STREAM_REPLIES 5000U
+#define STREAM_PAYLOAD_SIZE 1024U
+
 static int n_done = 0;
 static int block_write_fd = -1;
 
@@ -48,6 +52,27 @@ static int method_something(Varlink *link, JsonVariant *parameters, VarlinkMetho
         return varlink_reply(link, ret);
 }
 
+static int method_stream(Varlink *link, JsonVariant *parameters, VarlinkMethodFlags flags, void *userdata) {
+        char payload[STREAM_PAYLOAD_SIZE + 1];
+        int r;
+
+        if (!FLAGS_SET(flags, VARLINK_METHOD_MORE))
+                return varlink_error(link, VARLINK_ERROR_INVALID_PARAMETER, NULL);
+
+        memset(payload, 'x', STREAM_PAYLOAD_SIZE);
+        payload[STREAM_PAYLOAD_SIZE] = 0;
+
+        for (unsigned i = 0; i < STREAM_REPLIES - 1; i++) {
+                r = varlink_notifyb(link, JSON_BUILD_OBJECT(JSON_BUILD_PAIR("index", JSON_BUILD_UNSIGNED(i)),
+                                                            JSON_BUILD_PAIR("payload", JSON_BUILD_STRING(payload))));
+                if (r < 0)
+                        return r;
+        }
+
+        return varlink_replyb(link, JSON_BUILD_OBJECT(JSON_BUILD_PAIR("index", JSON_BUILD_UNSIGNED(STREAM_REPLIES - 1)),
+                                                      JSON_BUILD_PAIR("payload", JSON_BUILD_STRING(payload))));
+}
+
 static int method_done(Varlink *link, JsonVariant *parameters, VarlinkMethodFlags flags, void *userdata) {
 
         if (++n_done == 2)
@@ -140,6 +165,69 @@ static void flood_test(const char *address) {
                 connections[k] = varlink_unref(connections[k]);
 }
 
+static int stream_reply(Varlink *link, JsonVariant *parameters, const char *error_id, VarlinkReplyFlags flags, void *userdata) {
+        unsigned *n = userdata;
+
+        assert_se(!error_id);
+        assert_se(json_variant_unsigned(json_variant_by_key(parameters, "index")) == *n);
+        assert_se(strlen(json_variant_string(json_variant_by_key(parameters, "payload"))) == STREAM_PAYLOAD_SIZE);
+
+        (*n)++;
+
+        if (!FLAGS_SET(flags, VARLINK_REPLY_CONTINUES))
+                sd_event_exit(varlink_get_event(link), 0);
+
+        return 0;
+}
+
+static void stream_test(const char *address, bool binary) {
+        _cleanup_(varlink_flush_close_unrefp) Varlink *c = NULL;
+        _cleanup_(sd_event_unrefp) sd_event *e = NULL;
+        unsigned n = 0;
+
+        log_debug("Streaming replies (binary=%s)...", yes_no(binary));
+
+        assert_se(sd_event_new(&e) >= 0);
+
+        assert_se(varlink_connect_address(&c, address) >= 0);
+        assert_se(varlink_set_description(c, "stream-client") >= 0);
+        varlink_set_userdata(c, &n);
+        assert_se(varlink_bind_reply(c, stream_reply) >= 0);
+        assert_se(varlink_attach_event(c, e, 0) >= 0);
+        if (binary)
+                assert_se(varlink_negotiate_binary(c) >= 0);
+
+        assert_se(varlink_observeb(c, "io.test.Stream", JSON_BUILD_EMPTY_OBJECT) >= 0);
+        assert_se(sd_event_loop(e) >= 0);
+        assert_se(n == STREAM_REPLIES);
+}
+
+static void binary_test(const char *address) {
+        _cleanup_(varlink_flush_close_unrefp) Varlink *c = NULL;
+        JsonVariant *o = NULL;
+        const char *e;
+
+        log_debug("Calling with binary encoding...");
+
+        assert_se(varlink_connect_address(&c, address) >= 0);
+        assert_se(varlink_set_description(c, "binary-client") >= 0);
+        assert_se(varlink_negotiate_binary(c) >= 0);
+
+        /* The first call is sent as JSON, and the reply comes back binary, after which all our calls are
+         * binary too */
+        for (unsigned k = 0; k < 3; k++) {
+                assert_se(varlink_callb(c, "io.test.DoSomething", &o, &e, NULL,
+                                        JSON_BUILD_OBJECT(JSON_BUILD_PAIR("a", JSON_BUILD_INTEGER(-7)),
+                                                          JSON_BUILD_PAIR("b", JSON_BUILD_INTEGER(k)))) >= 0);
+                assert_se(json_variant_integer(json_variant_by_key(o, "sum")) == -7 + (int) k);
+                assert_se(!e);
+        }
+
+        assert_se(varlink_callb(c, "io.test.IDontExist", &o, &e, NULL, JSON_BUILD_OBJECT(JSON_BUILD_PAIR("x", JSON_BUILD_STRING("\xe2\x98\x83")))) >= 0);
+        assert_se(streq_ptr(json_variant_string(json_variant_by_key(o, "method")), "io.test.IDontExist"));
+        assert_se(streq(e, VARLINK_ERROR_METHOD_NOT_FOUND));
+}
+
 static void *thread(void *arg) {
         _cleanup_(varlink_flush_close_unrefp) Varlink *c = NULL;
         _cleanup_(json_variant_unrefp) JsonVariant *i = NULL;
@@ -160,6 +248,9 @@ static void *thread(void *arg) {
         assert_se(streq_ptr(json_variant_string(json_variant_by_key(o, "method")), "io.test.IDontExist"));
         assert_se(streq(e, VARLINK_ERROR_METHOD_NOT_FOUND));
 
+        binary_test(arg);
+        stream_test(arg, false);
+        stream_test(arg, true);
         flood_test(arg);
 
         assert_se(varlink_send(c, "io.test.Done", NULL) >= 0);
@@ -213,6 +304,7 @@ int main(int argc, char *argv[]) {
 
         assert_se(varlink_server_bind_method(s, "io.test.DoSomething", method_something) >= 0);
         assert_se(varlink_server_bind_method(s, "io.test.Done", method_done) >= 0);
+        assert_se(varlink_server_bind_method(s, "io.test.Stream", method_stream) >= 0);
         assert_se(varlink_server_bind_connect(s, on_connect) >= 0);
         assert_se(varlink_server_listen_address(s, sp, 0600) >= 0);
         assert_se(varlink_server_attach_event(s, e, 0) >= 0);
@@ -19,6 +19,7 @@
 #include "fs-util.h"
 #include "list.h"
 #include "log.h"
+#include "memory-util.h"
 #include "network-util.h"
 #include "ratelimit.h"
 #include "resolve-private.h"
@@ -323,8 +324,21 @@ static int manager_adjust_clock(Manager *m, double offset, int leap_sec) {
         return 0;
 }
 
+static void manager_reset_samples(Manager *m) {
+        assert(m);
+
+        /* Samples from different servers are not comparable (they might be asymmetrically routed, or
+         * simply be off by a bit), hence start over when switching servers, so that a good new server
+         * isn't judged by the history of a bad old one. */
+
+        zero(m->samples);
+        m->samples_idx = 0;
+        m->samples_jitter = 0;
+        m->packet_count = 0;
+}
+
 static bool manager_sample_spike_detection(Manager *m, double offset, double delay) {
-        unsigned i, idx_cur, idx_new, idx_min;
+        unsigned i, idx_cur, idx_new, idx_min, n = 0;
         double jitter;
         double j;
 
@@ -349,10 +363,17 @@ static bool manager_sample_spike_detection(Manager *m, double offset, double del
                 if (m->samples[i].delay > 0 && m->samples[i].delay < m->samples[idx_min].delay)
                         idx_min = i;
 
+        /* only look at slots that have been filled already, empty ones would skew the result */
         j = 0;
-        for (i = 0; i < ELEMENTSOF(m->samples); i++)
+        for (i = 0; i < ELEMENTSOF(m->samples); i++) {
+                if (m->samples[i].delay <= 0)
+                        continue;
+
                 j += pow(m->samples[i].offset - m->samples[idx_min].offset, 2);
-        m->samples_jitter = sqrt(j / (ELEMENTSOF(m->samples) - 1));
+                n++;
+        }
+        if (n > 1)
+                m->samples_jitter = sqrt(j / (n - 1));
 
         /* ignore samples when resyncing */
         if (m->poll_resync)
@@ -676,6 +697,7 @@ static int manager_begin(Manager *m) {
 
         m->good = false;
         m->missed_replies = NTP_MAX_MISSED_REPLIES;
+        manager_reset_samples(m);
         if (m->poll_interval_usec == 0)
                 m->poll_interval_usec = m->poll_interval_min_usec;
 
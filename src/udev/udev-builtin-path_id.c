@@ -533,7 +533,7 @@ static sd_device *handle_ap(sd_device *parent, char **path) {
         return skip_subsystem(parent, "ap");
 }
 
-static int builtin_path_id(sd_device *dev, int argc, char *argv[], bool test) {
+static int path_id_compose(sd_device *dev, char **ret_path, char **ret_compat_path) {
         sd_device *parent;
         _cleanup_free_ char *path = NULL;
         _cleanup_free_ char *compat_path = NULL;
@@ -679,39 +679,46 @@ static int builtin_path_id(sd_device *dev, int argc, char *argv[], bool test) {
             !supported_transport)
                 return -ENOENT;
 
-        {
-                char tag[UDEV_NAME_SIZE];
-                size_t i;
-                const char *p;
-
-                /* compose valid udev tag name */
-                for (p = path, i = 0; *p; p++) {
-                        if ((*p >= '0' && *p <= '9') ||
-                            (*p >= 'A' && *p <= 'Z') ||
-                            (*p >= 'a' && *p <= 'z') ||
-                            *p == '-') {
-                                tag[i++] = *p;
-                                continue;
-                        }
+        *ret_path = TAKE_PTR(path);
+        *ret_compat_path = TAKE_PTR(compat_path);
+        return 0;
+}
 
-                        /* skip all leading '_' */
-                        if (i == 0)
-                                continue;
+static void path_id_add_properties(sd_device *dev, bool test, const char *path, const char *compat_path) {
+        char tag[UDEV_NAME_SIZE];
+        size_t i;
+        const char *p;
 
-                        /* avoid second '_' */
-                        if (tag[i-1] == '_')
-                                continue;
+        assert(dev);
+        assert(path);
 
-                        tag[i++] = '_';
+        /* compose valid udev tag name */
+        for (p = path, i = 0; *p; p++) {
+                if ((*p >= '0' && *p <= '9') ||
+                    (*p >= 'A' && *p <= 'Z') ||
+                    (*p >= 'a' && *p <= 'z') ||
+                    *p == '-') {
+                        tag[i++] = *p;
+                        continue;
                 }
-                /* strip trailing '_' */
-                while (i > 0 && tag[i-1] == '_')
-                        i--;
-                tag[i] = '\0';
 
-                udev_builtin_add_property(dev, test, "ID_PATH", path);
-                udev_builtin_add_property(dev, test, "ID_PATH_TAG", tag);
+                /* skip all leading '_' */
+                if (i == 0)
+                        continue;
+
+                /* avoid second '_' */
+                if (tag[i-1] == '_')
+                        continue;
+
+                tag[i++] = '_';
         }
+        /* strip trailing '_' */
+        while (i > 0 && tag[i-1] == '_')
+                i--;
+        tag[i] = '\0';
+
+        udev_builtin_add_property(dev, test, "ID_PATH", path);
+        udev_builtin_add_property(dev, test, "ID_PATH_TAG", tag);
 
         /*
          * Compatible link generation for ATA devices
@@ -720,13 +727,119 @@ static int builtin_path_id(sd_device *dev, int argc, char *argv[], bool test) {
          */
         if (compat_path)
                 udev_builtin_add_property(dev, test, "ID_PATH_ATA_COMPAT", compat_path);
+}
+
+typedef struct PathIdCacheEntry {
+        char *path; /* NULL if the device has no persistent path */
+        char *compat_path;
+} PathIdCacheEntry;
+
+static PathIdCacheEntry* path_id_cache_entry_free(PathIdCacheEntry *e) {
+        if (!e)
+                return NULL;
+
+        free(e->path);
+        free(e->compat_path);
+        return mfree(e);
+}
+
+DEFINE_TRIVIAL_CLEANUP_FUNC(PathIdCacheEntry*, path_id_cache_entry_free);
+
+DEFINE_PRIVATE_HASH_OPS_FULL(path_id_cache_hash_ops, char, string_hash_func, string_compare_func, free,
+                             PathIdCacheEntry, path_id_cache_entry_free);
+
+/* Devices that emit a flood of "change" events (dm, loop, md) would otherwise have their parents walked and
+ * their sysfs attributes read again for every single event. The path of a device only depends on its
+ * position in the device tree, which cannot change without the device being removed and added again,
+ * hence the result of the last "add" or "change" event of a syspath is reused for "change" events. */
+#define PATH_ID_CACHE_MAX 4096U
+
+static Hashmap *path_id_cache = NULL;
+
+static void path_id_cache_put(const char *syspath, char *path, char *compat_path) {
+        _cleanup_(path_id_cache_entry_freep) PathIdCacheEntry *e = NULL;
+        _cleanup_free_ char *k = NULL;
+
+        e = new(PathIdCacheEntry, 1);
+        if (!e)
+                return;
+
+        *e = (PathIdCacheEntry) {
+                .path = path ? strdup(path) : NULL,
+                .compat_path = compat_path ? strdup(compat_path) : NULL,
+        };
+        if ((path && !e->path) || (compat_path && !e->compat_path))
+                return;
+
+        k = strdup(syspath);
+        if (!k)
+                return;
+
+        if (hashmap_size(path_id_cache) >= PATH_ID_CACHE_MAX)
+                hashmap_clear(path_id_cache);
+
+        if (hashmap_ensure_put(&path_id_cache, &path_id_cache_hash_ops, k, e) < 0)
+                return;
+
+        TAKE_PTR(k);
+        TAKE_PTR(e);
+}
+
+static int builtin_path_id(sd_device *dev, int argc, char *argv[], bool test) {
+        _cleanup_free_ char *path = NULL, *compat_path = NULL;
+        sd_device_action_t action;
+        const char *syspath;
+        int r;
+
+        assert(dev);
+
+        if (sd_device_get_syspath(dev, &syspath) < 0)
+                syspath = NULL;
+
+        if (test || sd_device_get_action(dev, &action) < 0)
+                action = _SD_DEVICE_ACTION_INVALID;
+
+        if (syspath) {
+                _cleanup_free_ char *old_syspath = NULL;
+                PathIdCacheEntry *e;
 
+                if (action == SD_DEVICE_CHANGE) {
+                        e = hashmap_get(path_id_cache, syspath);
+                        if (e) {
+                                if (!e->path)
+                                        return -ENOENT;
+
+                                path_id_add_properties(dev, test, e->path, e->compat_path);
+                                return 0;
+                        }
+                }
+
+                e = hashmap_remove2(path_id_cache, syspath, (void**) &old_syspath);
+                path_id_cache_entry_free(e);
+        }
+
+        r = path_id_compose(dev, &path, &compat_path);
+        if (r < 0 && r != -ENOENT)
+                return r;
+
+        if (syspath && IN_SET(action, SD_DEVICE_ADD, SD_DEVICE_CHANGE))
+                path_id_cache_put(syspath, path, compat_path);
+
+        if (r < 0)
+                return r;
+
+        path_id_add_properties(dev, test, path, compat_path);
         return 0;
 }
 
+static void builtin_path_id_exit(void) {
+        path_id_cache = hashmap_free(path_id_cache);
+}
+
 const UdevBuiltin udev_builtin_path_id = {
         .name = "path_id",
         .cmd = builtin_path_id,
+        .exit = builtin_path_id_exit,
         .help = "Compose persistent device path",
         .run_once = true,
 };
@@ -81,10 +81,12 @@ UdevEvent *udev_event_free(UdevEvent *event) {
         sd_device_unref(event->dev);
         sd_device_unref(event->dev_db_clone);
         sd_netlink_unref(event->rtnl);
-        ordered_hashmap_free_free_key(event->run_list);
-        ordered_hashmap_free_free_free(event->seclabel_list);
+        ordered_hashmap_free(event->run_list);
+        ordered_hashmap_free(event->seclabel_list);
+        arena_done(&event->arena);
         free(event->program_result);
         free(event->name);
+        free(event->spawn_max_cmd);
 
         return mfree(event);
 }
@@ -807,11 +809,25 @@ int udev_event_spawn(UdevEvent *event,
                 .result = result,
                 .result_size = ressize,
         };
+        usec_t start = now(CLOCK_MONOTONIC), d;
+        char buf[FORMAT_TIMESPAN_MAX];
+
         r = spawn_wait(&spawn);
+
+        d = usec_sub_unsigned(now(CLOCK_MONOTONIC), start);
+        event->spawn_usec += d;
+        if (d > event->spawn_max_usec) {
+                event->spawn_max_usec = d;
+                (void) free_and_strdup(&event->spawn_max_cmd, cmd);
+        }
+
         if (r < 0)
                 return log_device_error_errno(event->dev, r,
                                               "Failed to wait for spawned command '%s': %m", cmd);
 
+        log_device_debug(event->dev, "Command '%s' finished after %s.",
+                         cmd, format_timespan(buf, sizeof buf, d, USEC_PER_MSEC));
+
         if (result)
                 result[spawn.result_len] = '\0';
 
@@ -979,6 +995,7 @@ int udev_event_execute_rules(UdevEvent *event,
         const char *subsystem;
         sd_device_action_t action;
         sd_device *dev;
+        usec_t usec;
         int r;
 
         assert(event);
@@ -1017,7 +1034,9 @@ int udev_event_execute_rules(UdevEvent *event,
                         return r;
         }
 
+        usec = now(CLOCK_MONOTONIC);
         r = udev_rules_apply_to_event(rules, event, timeout_usec, timeout_signal, properties_list);
+        event->rules_usec = usec_sub_unsigned(now(CLOCK_MONOTONIC), usec);
         if (r < 0)
                 return log_device_debug_errno(dev, r, "Failed to apply udev rules: %m");
 
@@ -1025,6 +1044,7 @@ int udev_event_execute_rules(UdevEvent *event,
         if (r < 0)
                 return r;
 
+        usec = now(CLOCK_MONOTONIC);
         r = update_devnode(event);
         if (r < 0)
                 return r;
@@ -1052,10 +1072,12 @@ int udev_event_execute_rules(UdevEvent *event,
         if (r < 0)
                 return r;
 
+        event->node_usec = usec_sub_unsigned(now(CLOCK_MONOTONIC), usec);
         return 0;
 }
 
 void udev_event_execute_run(UdevEvent *event, usec_t timeout_usec, int timeout_signal) {
+        usec_t start = now(CLOCK_MONOTONIC);
         const char *command;
         void *val;
         int r;
@@ -1086,4 +1108,6 @@ void udev_event_execute_run(UdevEvent *event, usec_t timeout_usec, int timeout_s
                                 log_device_debug(event->dev, "Command \"%s\" returned %d (error), ignoring.", command, r);
                 }
         }
+
+        event->run_usec = usec_sub_unsigned(now(CLOCK_MONOTONIC), start);
 }
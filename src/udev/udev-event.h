@@ -8,6 +8,7 @@
 #include "sd-device.h"
 #include "sd-netlink.h"
 
+#include "arena.h"
 #include "hashmap.h"
 #include "macro.h"
 #include "udev-rules.h"
@@ -29,8 +30,16 @@ typedef struct UdevEvent {
         gid_t gid;
         OrderedHashmap *seclabel_list;
         OrderedHashmap *run_list;
+        Arena arena; /* strings that live as long as the event, e.g. the keys and values of the lists above */
         usec_t exec_delay_usec;
         usec_t birth_usec;
+        /* Time spent in the individual phases of processing the event */
+        usec_t rules_usec; /* evaluating rules, including PROGRAM= and IMPORT{program}= */
+        usec_t node_usec;  /* device node, symlinks and database */
+        usec_t run_usec;   /* RUN+= */
+        usec_t spawn_usec; /* total of all spawned programs */
+        usec_t spawn_max_usec;
+        char *spawn_max_cmd; /* the slowest spawned program */
         sd_netlink *rtnl;
         unsigned builtin_run;
         unsigned builtin_ret;
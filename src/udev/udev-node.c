@@ -16,6 +16,7 @@
 #include "format-util.h"
 #include "fs-util.h"
 #include "mkdir.h"
+#include "parse-util.h"
 #include "path-util.h"
 #include "selinux-util.h"
 #include "smack-util.h"
@@ -112,6 +113,7 @@ static int node_symlink(sd_device *dev, const char *node, const char *slink) {
 static int link_find_prioritized(sd_device *dev, bool add, const char *stackdir, char **ret) {
         _cleanup_closedir_ DIR *dir = NULL;
         _cleanup_free_ char *target = NULL;
+        const char *id_filename;
         struct dirent *dent;
         int r, priority = 0;
 
@@ -145,9 +147,13 @@ static int link_find_prioritized(sd_device *dev, bool add, const char *stackdir,
                 return -errno;
         }
 
+        if (device_get_id_filename(dev, &id_filename) < 0)
+                goto finish;
+
         FOREACH_DIRENT_ALL(dent, dir, break) {
                 _cleanup_(sd_device_unrefp) sd_device *dev_db = NULL;
-                const char *devnode, *id_filename;
+                _cleanup_free_ char *buf = NULL;
+                const char *devnode;
                 int db_prio = 0;
 
                 if (dent->d_name[0] == '\0')
@@ -157,26 +163,40 @@ static int link_find_prioritized(sd_device *dev, bool add, const char *stackdir,
 
                 log_device_debug(dev, "Found '%s' claiming '%s'", dent->d_name, stackdir);
 
-                if (device_get_id_filename(dev, &id_filename) < 0)
-                        continue;
-
                 /* did we find ourself? */
                 if (streq(dent->d_name, id_filename))
                         continue;
 
-                if (sd_device_new_from_device_id(&dev_db, dent->d_name) < 0)
-                        continue;
+                /* Entries are symlinks pointing to "<priority>:<devnode>", see link_update(), so that we
+                 * don't have to load the database of each device claiming the link. Entries written by older
+                 * versions are empty regular files, for which we still have to look at the database. */
+                if (dent->d_type != DT_REG && readlinkat_malloc(dirfd(dir), dent->d_name, &buf) >= 0) {
+                        char *colon;
 
-                if (sd_device_get_devname(dev_db, &devnode) < 0)
-                        continue;
+                        colon = strchr(buf, ':');
+                        if (!colon)
+                                continue;
 
-                if (device_get_devlink_priority(dev_db, &db_prio) < 0)
-                        continue;
+                        *colon = '\0';
+                        devnode = colon + 1;
+
+                        if (safe_atoi(buf, &db_prio) < 0 || !path_is_absolute(devnode))
+                                continue;
+                } else {
+                        if (sd_device_new_from_device_id(&dev_db, dent->d_name) < 0)
+                                continue;
+
+                        if (sd_device_get_devname(dev_db, &devnode) < 0)
+                                continue;
+
+                        if (device_get_devlink_priority(dev_db, &db_prio) < 0)
+                                continue;
+                }
 
                 if (target && db_prio <= priority)
                         continue;
 
-                log_device_debug(dev_db, "Device claims priority %i for '%s'", db_prio, stackdir);
+                log_device_debug(dev, "Device '%s' claims priority %i for '%s'", dent->d_name, db_prio, stackdir);
 
                 r = free_and_strdup(&target, devnode);
                 if (r < 0)
@@ -184,6 +204,7 @@ static int link_find_prioritized(sd_device *dev, bool add, const char *stackdir,
                 priority = db_prio;
         }
 
+finish:
         if (!target)
                 return -ENOENT;
 
@@ -250,20 +271,39 @@ static int link_update(sd_device *dev, const char *slink, bool add) {
         if (!add) {
                 if (unlink(filename) == 0)
                         (void) rmdir(dirname);
-        } else
-                for (;;) {
-                        _cleanup_close_ int fd = -1;
+        } else {
+                _cleanup_free_ char *data = NULL;
+                const char *devnode;
+                int priority;
+
+                /* Store the priority and the device node in the entry itself, so that whoever determines the
+                 * device with the highest priority doesn't have to read the database of all devices claiming
+                 * the link. The entry is replaced atomically, so readers always see either the old or the new
+                 * contents. */
+
+                r = device_get_devlink_priority(dev, &priority);
+                if (r < 0)
+                        return log_device_debug_errno(dev, r, "Failed to get devlink priority: %m");
+
+                r = sd_device_get_devname(dev, &devnode);
+                if (r < 0)
+                        return log_device_debug_errno(dev, r, "Failed to get device node: %m");
 
+                if (asprintf(&data, "%i:%s", priority, devnode) < 0)
+                        return log_oom();
+
+                for (;;) {
                         r = mkdir_parents(filename, 0755);
                         if (!IN_SET(r, 0, -ENOENT))
                                 return r;
 
-                        fd = open(filename, O_WRONLY|O_CREAT|O_CLOEXEC|O_TRUNC|O_NOFOLLOW, 0444);
-                        if (fd >= 0)
+                        r = symlink_atomic(data, filename);
+                        if (r >= 0)
                                 break;
-                        if (errno != ENOENT)
-                                return -errno;
+                        if (r != -ENOENT)
+                                return r;
                 }
+        }
 
         /* If the database entry is not written yet we will just do one iteration and possibly wrong symlink
          * will be fixed in the second invocation. */
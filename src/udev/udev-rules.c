@@ -46,12 +46,16 @@ typedef enum {
 } UdevRuleOperatorType;
 
 typedef enum {
-        MATCH_TYPE_EMPTY,            /* empty string */
-        MATCH_TYPE_PLAIN,            /* no special characters */
-        MATCH_TYPE_PLAIN_WITH_EMPTY, /* no special characters with empty string, e.g., "|foo" */
-        MATCH_TYPE_GLOB,             /* shell globs ?,*,[] */
-        MATCH_TYPE_GLOB_WITH_EMPTY,  /* shell globs ?,*,[] with empty string, e.g., "|foo*" */
-        MATCH_TYPE_SUBSYSTEM,        /* "subsystem", "bus", or "class" */
+        MATCH_TYPE_EMPTY,             /* empty string */
+        MATCH_TYPE_PLAIN,             /* no special characters */
+        MATCH_TYPE_PLAIN_WITH_EMPTY,  /* no special characters with empty string, e.g., "|foo" */
+        MATCH_TYPE_GLOB,              /* shell globs ?,*,[] */
+        MATCH_TYPE_GLOB_WITH_EMPTY,   /* shell globs ?,*,[] with empty string, e.g., "|foo[0-9]" */
+        MATCH_TYPE_PREFIX,            /* globs with a single trailing "*" only, e.g., "nvme*" */
+        MATCH_TYPE_PREFIX_WITH_EMPTY, /* the same with empty string, e.g., "|nvme*" */
+        MATCH_TYPE_SUFFIX,            /* globs with a single leading "*" only, e.g., "*-part" */
+        MATCH_TYPE_SUFFIX_WITH_EMPTY, /* the same with empty string, e.g., "|*-part" */
+        MATCH_TYPE_SUBSYSTEM,         /* "subsystem", "bus", or "class" */
         _MATCH_TYPE_MAX,
         _MATCH_TYPE_INVALID = -EINVAL,
 } UdevRuleMatchType;
@@ -160,8 +164,14 @@ struct UdevRuleLine {
         const char *goto_label;
         UdevRuleLine *goto_line;
 
+        /* A plain ACTION==, KERNEL== or SUBSYSTEM== match of the line, which is checked before anything
+         * else. If it does not match, all following lines with the identical match are skipped too, and
+         * evaluation continues at filter_skip_line. */
+        UdevRuleToken *filter_token;
+        UdevRuleLine *filter_skip_line;
+
         UdevRuleFile *rule_file;
-        UdevRuleToken *current_token;
+        UdevRuleToken *current_token; /* only used while parsing */
         LIST_HEAD(UdevRuleToken, tokens);
         LIST_FIELDS(UdevRuleLine, rule_lines);
 };
@@ -179,6 +189,10 @@ struct UdevRules {
         Hashmap *known_users;
         Hashmap *known_groups;
         UdevRuleFile *current_file;
+        /* The token being evaluated. This is deliberately not stored in the lines: workers share the
+         * rules with the main daemon copy-on-write, and writing to every line would give each worker its
+         * own copy of most of the pages. */
+        UdevRuleToken *current_token;
         LIST_HEAD(UdevRuleFile, rule_files);
 };
 
@@ -403,6 +417,38 @@ static void rule_line_append_token(UdevRuleLine *rule_line, UdevRuleToken *token
         rule_line->current_token = token;
 }
 
+static bool pattern_is_plain(const char *p, size_t n) {
+        assert(p);
+
+        for (size_t k = 0; k < n; k++)
+                if (strchr(GLOB_CHARS "\\", p[k]))
+                        return false;
+
+        return true;
+}
+
+static UdevRuleMatchType glob_match_type(const char *nulstr) {
+        bool prefix = true, suffix = true;
+        const char *i;
+
+        assert(nulstr);
+
+        /* Most globs in rules are "foo*" or "*foo". Detect values where all alternatives are of one of
+         * these kinds, so that they can be matched with a simple string comparison instead of fnmatch(). */
+        NULSTR_FOREACH(i, nulstr) {
+                size_t n = strlen(i);
+
+                if (prefix && !(i[n - 1] == '*' && pattern_is_plain(i, n - 1)))
+                        prefix = false;
+                if (suffix && !(i[0] == '*' && pattern_is_plain(i + 1, n - 1)))
+                        suffix = false;
+                if (!prefix && !suffix)
+                        return MATCH_TYPE_GLOB;
+        }
+
+        return prefix ? MATCH_TYPE_PREFIX : MATCH_TYPE_SUFFIX;
+}
+
 static int rule_line_add_token(UdevRuleLine *rule_line, UdevRuleTokenType type, UdevRuleOperatorType op, char *value, void *data) {
         UdevRuleToken *token;
         UdevRuleMatchType match_type = _MATCH_TYPE_INVALID;
@@ -457,11 +503,18 @@ static int rule_line_add_token(UdevRuleLine *rule_line, UdevRuleTokenType type,
                         if (bar)
                                 empty = true;
 
+                        if (match_type == MATCH_TYPE_GLOB)
+                                match_type = glob_match_type(value);
+
                         if (empty) {
                                 if (match_type == MATCH_TYPE_GLOB)
                                         match_type = MATCH_TYPE_GLOB_WITH_EMPTY;
                                 if (match_type == MATCH_TYPE_PLAIN)
                                         match_type = MATCH_TYPE_PLAIN_WITH_EMPTY;
+                                if (match_type == MATCH_TYPE_PREFIX)
+                                        match_type = MATCH_TYPE_PREFIX_WITH_EMPTY;
+                                if (match_type == MATCH_TYPE_SUFFIX)
+                                        match_type = MATCH_TYPE_SUFFIX_WITH_EMPTY;
                         }
                 }
         }
@@ -1167,6 +1220,69 @@ static void rule_resolve_goto(UdevRuleFile *rule_file) {
         }
 }
 
+static size_t token_value_size(const UdevRuleToken *token) {
+        const char *i;
+        size_t n = 0;
+
+        assert(token);
+
+        NULSTR_FOREACH(i, token->value)
+                n += strlen(i) + 1;
+
+        return n;
+}
+
+static bool token_filter_equal(const UdevRuleToken *a, const UdevRuleToken *b) {
+        size_t n;
+
+        if (!a || !b)
+                return false;
+
+        if (a->type != b->type || a->op != b->op)
+                return false;
+
+        n = token_value_size(a);
+        return n == token_value_size(b) && memcmp(a->value, b->value, n) == 0;
+}
+
+static void rule_resolve_filters(UdevRuleFile *rule_file) {
+        UdevRuleLine *line, *i;
+        UdevRuleToken *token;
+
+        assert(rule_file);
+
+        /* Pick the cheap per-event matches of each line, so that lines (and runs of lines) which can never
+         * apply to an event of some subsystem or action are skipped without evaluating any of their
+         * tokens. All other match tokens sorted before these have no side effects, hence checking them
+         * first does not change the result. */
+        LIST_FOREACH(rule_lines, line, rule_file->rule_lines) {
+                line->filter_token = NULL;
+
+                LIST_FOREACH(tokens, token, line->tokens) {
+                        if (token->type > TK_M_SUBSYSTEM)
+                                break;
+
+                        if (IN_SET(token->type, TK_M_ACTION, TK_M_KERNEL, TK_M_SUBSYSTEM) &&
+                            token->match_type == MATCH_TYPE_PLAIN) {
+                                line->filter_token = token;
+                                break;
+                        }
+                }
+        }
+
+        LIST_FOREACH(rule_lines, line, rule_file->rule_lines) {
+                if (!line->filter_token)
+                        continue;
+
+                line->filter_skip_line = NULL;
+                LIST_FOREACH_AFTER(rule_lines, i, line)
+                        if (!token_filter_equal(line->filter_token, i->filter_token)) {
+                                line->filter_skip_line = i;
+                                break;
+                        }
+        }
+}
+
 int udev_rules_parse_file(UdevRules *rules, const char *filename) {
         _cleanup_free_ char *continuation = NULL, *name = NULL;
         _cleanup_fclose_ FILE *f = NULL;
@@ -1267,6 +1383,7 @@ int udev_rules_parse_file(UdevRules *rules, const char *filename) {
         }
 
         rule_resolve_goto(rule_file);
+        rule_resolve_filters(rule_file);
         return 0;
 }
 
@@ -1361,6 +1478,32 @@ static bool token_match_string(UdevRuleToken *token, const char *str) {
                                 break;
                         }
                 break;
+        case MATCH_TYPE_PREFIX_WITH_EMPTY:
+                if (isempty(str)) {
+                        match = true;
+                        break;
+                }
+                _fallthrough_;
+        case MATCH_TYPE_PREFIX:
+                NULSTR_FOREACH(i, value)
+                        if (strneq(i, str, strlen(i) - 1)) {
+                                match = true;
+                                break;
+                        }
+                break;
+        case MATCH_TYPE_SUFFIX_WITH_EMPTY:
+                if (isempty(str)) {
+                        match = true;
+                        break;
+                }
+                _fallthrough_;
+        case MATCH_TYPE_SUFFIX:
+                NULSTR_FOREACH(i, value)
+                        if (endswith(str, i + 1)) {
+                                match = true;
+                                break;
+                        }
+                break;
         default:
                 assert_not_reached("Invalid match type");
         }
@@ -1542,7 +1685,7 @@ static int udev_rule_apply_token_to_event(
          * 1 on the current token matches the event, and
          * negative errno on some critical errors. */
 
-        token = rules->current_file->current_line->current_token;
+        token = rules->current_token;
 
         switch (token->type) {
         case TK_M_ACTION: {
@@ -1963,23 +2106,22 @@ static int udev_rule_apply_token_to_event(
                 log_rule_debug(dev, rules, "MODE %#o", event->mode);
                 break;
         case TK_A_SECLABEL: {
-                _cleanup_free_ char *name = NULL, *label = NULL;
-                char label_str[UDEV_LINE_SIZE] = {};
+                char label_str[UDEV_LINE_SIZE] = {}, *name, *label;
 
-                name = strdup(token->data);
+                name = arena_strdup(&event->arena, token->data);
                 if (!name)
                         return log_oom();
 
                 (void) udev_event_apply_format(event, token->value, label_str, sizeof(label_str), false);
                 if (!isempty(label_str))
-                        label = strdup(label_str);
+                        label = arena_strdup(&event->arena, label_str);
                 else
-                        label = strdup(token->value);
+                        label = arena_strdup(&event->arena, token->value);
                 if (!label)
                         return log_oom();
 
                 if (token->op == OP_ASSIGN)
-                        ordered_hashmap_clear_free_free(event->seclabel_list);
+                        ordered_hashmap_clear(event->seclabel_list);
 
                 r = ordered_hashmap_ensure_put(&event->seclabel_list, NULL, name, label);
                 if (r == -ENOMEM)
@@ -1988,9 +2130,6 @@ static int udev_rule_apply_token_to_event(
                         return log_rule_error_errno(dev, rules, r, "Failed to store SECLABEL{%s}='%s': %m", name, label);;
 
                 log_rule_debug(dev, rules, "SECLABEL{%s}='%s'", name, label);
-
-                TAKE_PTR(name);
-                TAKE_PTR(label);
                 break;
         }
         case TK_A_ENV: {
@@ -2142,7 +2281,7 @@ static int udev_rule_apply_token_to_event(
         }
         case TK_A_RUN_BUILTIN:
         case TK_A_RUN_PROGRAM: {
-                _cleanup_free_ char *cmd = NULL;
+                char *cmd;
 
                 if (event->run_final)
                         break;
@@ -2150,11 +2289,11 @@ static int udev_rule_apply_token_to_event(
                         event->run_final = true;
 
                 if (IN_SET(token->op, OP_ASSIGN, OP_ASSIGN_FINAL))
-                        ordered_hashmap_clear_free_key(event->run_list);
+                        ordered_hashmap_clear(event->run_list);
 
                 (void) udev_event_apply_format(event, token->value, buf, sizeof(buf), false);
 
-                cmd = strdup(buf);
+                cmd = arena_strdup(&event->arena, buf);
                 if (!cmd)
                         return log_oom();
 
@@ -2164,8 +2303,6 @@ static int udev_rule_apply_token_to_event(
                 if (r < 0)
                         return log_rule_error_errno(dev, rules, r, "Failed to store command '%s': %m", cmd);
 
-                TAKE_PTR(cmd);
-
                 log_rule_debug(dev, rules, "RUN '%s'", token->value);
                 break;
         }
@@ -2188,16 +2325,14 @@ static int udev_rule_apply_parent_token_to_event(
                 UdevEvent *event,
                 int timeout_signal) {
 
-        UdevRuleLine *line;
         UdevRuleToken *head;
         int r;
 
-        line = rules->current_file->current_line;
-        head = rules->current_file->current_line->current_token;
+        head = rules->current_token;
         event->dev_parent = event->dev;
         for (;;) {
-                LIST_FOREACH(tokens, line->current_token, head) {
-                        if (!token_is_for_parents(line->current_token))
+                LIST_FOREACH(tokens, rules->current_token, head) {
+                        if (!token_is_for_parents(rules->current_token))
                                 return true; /* All parent tokens match. */
                         r = udev_rule_apply_token_to_event(rules, event->dev_parent, event, 0, timeout_signal, NULL);
                         if (r < 0)
@@ -2205,7 +2340,7 @@ static int udev_rule_apply_parent_token_to_event(
                         if (r == 0)
                                 break;
                 }
-                if (!line->current_token)
+                if (!rules->current_token)
                         /* All parent tokens match. But no assign tokens in the line. Hmm... */
                         return true;
 
@@ -2216,39 +2351,94 @@ static int udev_rule_apply_parent_token_to_event(
         }
 }
 
+typedef struct UdevRuleEventInfo {
+        UdevRuleLineType mask;
+        const char *action;
+        const char *sysname;
+        const char *subsystem;
+} UdevRuleEventInfo;
+
+static int udev_rule_event_info_init(UdevRuleEventInfo *info, sd_device *dev) {
+        sd_device_action_t action;
+        int r;
+
+        assert(info);
+        assert(dev);
+
+        /* Everything here is constant during rule processing, look it up once per event rather than for
+         * each rule line. */
+
+        r = sd_device_get_action(dev, &action);
+        if (r < 0)
+                return r;
+
+        *info = (UdevRuleEventInfo) {
+                .mask = LINE_HAS_GOTO | LINE_UPDATE_SOMETHING,
+                .action = device_action_to_string(action),
+        };
+
+        if (action != SD_DEVICE_REMOVE) {
+                if (sd_device_get_devnum(dev, NULL) >= 0)
+                        info->mask |= LINE_HAS_DEVLINK;
+
+                if (sd_device_get_ifindex(dev, NULL) >= 0)
+                        info->mask |= LINE_HAS_NAME;
+        }
+
+        r = sd_device_get_sysname(dev, &info->sysname);
+        if (r < 0)
+                return r;
+
+        r = sd_device_get_subsystem(dev, &info->subsystem);
+        if (r < 0 && r != -ENOENT)
+                return r;
+
+        return 0;
+}
+
+static bool udev_rule_line_filter_match(UdevRuleLine *line, const UdevRuleEventInfo *info) {
+        UdevRuleToken *token = line->filter_token;
+
+        if (!token)
+                return true;
+
+        switch (token->type) {
+        case TK_M_ACTION:
+                return token_match_string(token, info->action);
+        case TK_M_KERNEL:
+                return token_match_string(token, info->sysname);
+        case TK_M_SUBSYSTEM:
+                return token_match_string(token, info->subsystem);
+        default:
+                assert_not_reached("Invalid filter token");
+        }
+}
+
 static int udev_rule_apply_line_to_event(
                 UdevRules *rules,
                 UdevEvent *event,
+                const UdevRuleEventInfo *info,
                 usec_t timeout_usec,
                 int timeout_signal,
                 Hashmap *properties_list,
                 UdevRuleLine **next_line) {
 
         UdevRuleLine *line = rules->current_file->current_line;
-        UdevRuleLineType mask = LINE_HAS_GOTO | LINE_UPDATE_SOMETHING;
         UdevRuleToken *token, *next_token;
         bool parents_done = false;
-        sd_device_action_t action;
         int r;
 
-        r = sd_device_get_action(event->dev, &action);
-        if (r < 0)
-                return r;
-
-        if (action != SD_DEVICE_REMOVE) {
-                if (sd_device_get_devnum(event->dev, NULL) >= 0)
-                        mask |= LINE_HAS_DEVLINK;
-
-                if (sd_device_get_ifindex(event->dev, NULL) >= 0)
-                        mask |= LINE_HAS_NAME;
+        if (!udev_rule_line_filter_match(line, info)) {
+                *next_line = line->filter_skip_line;
+                return 0;
         }
 
-        if ((line->type & mask) == 0)
+        if ((line->type & info->mask) == 0)
                 return 0;
 
         event->esc = ESCAPE_UNSET;
         LIST_FOREACH_SAFE(tokens, token, next_token, line->tokens) {
-                line->current_token = token;
+                rules->current_token = token;
 
                 if (token_is_for_parents(token)) {
                         if (parents_done)
@@ -2280,6 +2470,7 @@ int udev_rules_apply_to_event(
                 int timeout_signal,
                 Hashmap *properties_list) {
 
+        UdevRuleEventInfo info;
         UdevRuleFile *file;
         UdevRuleLine *next_line;
         int r;
@@ -2287,10 +2478,14 @@ int udev_rules_apply_to_event(
         assert(rules);
         assert(event);
 
+        r = udev_rule_event_info_init(&info, event->dev);
+        if (r < 0)
+                return r;
+
         LIST_FOREACH(rule_files, file, rules->rule_files) {
                 rules->current_file = file;
                 LIST_FOREACH_SAFE(rule_lines, file->current_line, next_line, file->rule_lines) {
-                        r = udev_rule_apply_line_to_event(rules, event, timeout_usec, timeout_signal, properties_list, &next_line);
+                        r = udev_rule_apply_line_to_event(rules, event, &info, timeout_usec, timeout_signal, properties_list, &next_line);
                         if (r < 0)
                                 return r;
                 }
@@ -88,6 +88,10 @@ typedef struct Manager {
         UdevRules *rules;
         Hashmap *properties;
 
+        /* Queued and running events indexed by devpath, devpath prefix, device node and network
+         * interface, see event_index_add(). */
+        Hashmap *event_groups;
+
         sd_netlink *rtnl;
 
         sd_device_monitor *monitor;
@@ -119,14 +123,33 @@ struct event {
         sd_device *dev_kernel; /* clone of originally received device */
 
         uint64_t seqnum;
-        uint64_t delaying_seqnum;
+
+        usec_t queued_usec;
+        usec_t started_usec;
 
         sd_event_source *timeout_warning_event;
         sd_event_source *timeout_event;
 
+        struct event_link *links;
+        size_t n_links;
+        char **wait_keys;
+
         LIST_FIELDS(struct event, event);
 };
 
+/* All events sharing one index key, ordered by seqnum */
+struct event_group {
+        char *key;
+        LIST_HEAD(struct event_link, links);
+        struct event_link *links_tail;
+};
+
+struct event_link {
+        struct event *event;
+        struct event_group *group;
+        LIST_FIELDS(struct event_link, links);
+};
+
 static void event_queue_cleanup(Manager *manager, enum event_state type);
 
 enum worker_state {
@@ -149,12 +172,36 @@ struct worker {
 struct worker_message {
 };
 
+static void event_index_remove(struct event *event) {
+        assert(event);
+
+        for (size_t i = 0; i < event->n_links; i++) {
+                struct event_link *link = event->links + i;
+                struct event_group *group = link->group;
+
+                if (group->links_tail == link)
+                        group->links_tail = link->links_prev;
+                LIST_REMOVE(links, group->links, link);
+
+                if (LIST_IS_EMPTY(group->links)) {
+                        hashmap_remove(event->manager->event_groups, group->key);
+                        free(group->key);
+                        free(group);
+                }
+        }
+
+        event->links = mfree(event->links);
+        event->n_links = 0;
+        event->wait_keys = strv_free(event->wait_keys);
+}
+
 static void event_free(struct event *event) {
         if (!event)
                 return;
 
         assert(event->manager);
 
+        event_index_remove(event);
         LIST_REMOVE(event, event->manager->events, event);
         sd_device_unref(event->dev);
         sd_device_unref(event->dev_kernel);
@@ -259,6 +306,7 @@ static void worker_attach_event(struct worker *worker, struct event *event) {
         worker->event = event;
         event->state = EVENT_RUNNING;
         event->worker = worker;
+        event->started_usec = now(CLOCK_MONOTONIC);
 
         e = worker->manager->event;
 
@@ -281,6 +329,8 @@ static void manager_clear_for_worker(Manager *manager) {
 
         manager->workers = hashmap_free(manager->workers);
         event_queue_cleanup(manager, EVENT_UNDEF);
+        assert(hashmap_isempty(manager->event_groups));
+        manager->event_groups = hashmap_free(manager->event_groups);
 
         manager->monitor = sd_device_monitor_unref(manager->monitor);
         manager->ctrl = udev_ctrl_unref(manager->ctrl);
@@ -426,6 +476,40 @@ static int worker_mark_block_device_read_only(sd_device *dev) {
         return 0;
 }
 
+static void worker_log_event_timing(UdevEvent *udev_event) {
+        char rules[FORMAT_TIMESPAN_MAX], node[FORMAT_TIMESPAN_MAX], run[FORMAT_TIMESPAN_MAX],
+                spawn[FORMAT_TIMESPAN_MAX];
+        const char *sysname = NULL, *devpath = NULL;
+        uint64_t seqnum = 0;
+
+        assert(udev_event);
+
+        if (!DEBUG_LOGGING)
+                return;
+
+        (void) sd_device_get_sysname(udev_event->dev, &sysname);
+        (void) sd_device_get_devpath(udev_event->dev, &devpath);
+        (void) sd_device_get_seqnum(udev_event->dev, &seqnum);
+
+        /* The numeric fields allow aggregating the timings with journalctl, e.g. to find the slowest rules. */
+        log_struct(LOG_DEBUG,
+                   LOG_MESSAGE("%s: Spent %s in rules, %s on the device node, %s in RUN; %s in spawned programs, slowest '%s'",
+                               strna(sysname),
+                               format_timespan(rules, sizeof rules, udev_event->rules_usec, USEC_PER_MSEC),
+                               format_timespan(node, sizeof node, udev_event->node_usec, USEC_PER_MSEC),
+                               format_timespan(run, sizeof run, udev_event->run_usec, USEC_PER_MSEC),
+                               format_timespan(spawn, sizeof spawn, udev_event->spawn_usec, USEC_PER_MSEC),
+                               strna(udev_event->spawn_max_cmd)),
+                   "DEVPATH=%s", strna(devpath),
+                   "SEQNUM=%" PRIu64, seqnum,
+                   "UDEV_RULES_USEC=" USEC_FMT, udev_event->rules_usec,
+                   "UDEV_NODE_USEC=" USEC_FMT, udev_event->node_usec,
+                   "UDEV_RUN_USEC=" USEC_FMT, udev_event->run_usec,
+                   "UDEV_PROGRAM_USEC=" USEC_FMT, udev_event->spawn_usec,
+                   "UDEV_SLOWEST_PROGRAM_USEC=" USEC_FMT, udev_event->spawn_max_usec,
+                   "UDEV_SLOWEST_PROGRAM=%s", strempty(udev_event->spawn_max_cmd));
+}
+
 static int worker_process_device(Manager *manager, sd_device *dev) {
         _cleanup_(udev_event_freep) UdevEvent *udev_event = NULL;
         _cleanup_close_ int fd_lock = -1;
@@ -504,6 +588,7 @@ static int worker_process_device(Manager *manager, sd_device *dev) {
                 (void) udev_watch_end(dev);
 
         log_device_uevent(dev, "Device processed");
+        worker_log_event_timing(udev_event);
         return 0;
 }
 
@@ -678,6 +763,133 @@ static void event_run(Manager *manager, struct event *event) {
         worker_spawn(manager, event);
 }
 
+static int event_index_keys(sd_device *dev, bool self, char ***ret) {
+        _cleanup_strv_free_ char **keys = NULL;
+        const char *subsystem, *devpath;
+        dev_t devnum;
+        int r, ifindex;
+
+        assert(dev);
+        assert(ret);
+
+        /* Returns the index keys of an event. With self=true, these are the keys the event is filed under:
+         * "=" followed by its devpath, "/" followed by the devpath itself and each of its parents, and the
+         * device node and interface index if any. Otherwise, these are the keys under which events are
+         * filed, that the event must wait for: the same device or interface, the devpath and each of its
+         * parents, the previous devpath of a renamed device, and "/" followed by the devpath for all
+         * child devices. */
+
+        r = sd_device_get_subsystem(dev, &subsystem);
+        if (r < 0)
+                return r;
+
+        r = sd_device_get_devpath(dev, &devpath);
+        if (r < 0)
+                return r;
+
+        r = strv_extendf(&keys, "/%s", devpath);
+        if (r < 0)
+                return r;
+
+        for (const char *p = strchr(devpath + 1, '/'); p; p = strchr(p + 1, '/')) {
+                r = strv_extendf(&keys, "%c%.*s", self ? '/' : '=', (int) (p - devpath), devpath);
+                if (r < 0)
+                        return r;
+        }
+
+        r = strv_extendf(&keys, "=%s", devpath);
+        if (r < 0)
+                return r;
+
+        if (!self) {
+                const char *devpath_old;
+
+                r = sd_device_get_property_value(dev, "DEVPATH_OLD", &devpath_old);
+                if (r >= 0)
+                        r = strv_extendf(&keys, "=%s", devpath_old);
+                if (r < 0 && r != -ENOENT)
+                        return r;
+        }
+
+        r = sd_device_get_devnum(dev, &devnum);
+        if (r >= 0 && major(devnum) != 0)
+                r = strv_extendf(&keys, "%c%u:%u", streq(subsystem, "block") ? 'b' : 'c', major(devnum), minor(devnum));
+        if (r < 0 && r != -ENOENT)
+                return r;
+
+        r = sd_device_get_ifindex(dev, &ifindex);
+        if (r >= 0 && ifindex > 0)
+                r = strv_extendf(&keys, "n%i", ifindex);
+        if (r < 0 && r != -ENOENT)
+                return r;
+
+        *ret = TAKE_PTR(keys);
+        return 0;
+}
+
+static int event_index_add(struct event *event) {
+        _cleanup_strv_free_ char **keys = NULL;
+        size_t n;
+        char **k;
+        int r;
+
+        assert(event);
+        assert(event->manager);
+        assert(!event->links);
+
+        /* Events are inserted in the order of their seqnum, hence appending keeps each group sorted and the
+         * first event in a group is the oldest one. This allows is_device_busy() to check for earlier events
+         * of the same, a parent or a child device with a few hash table lookups, rather than comparing
+         * with all queued events. */
+
+        r = event_index_keys(event->dev, true, &keys);
+        if (r < 0)
+                return r;
+
+        n = strv_length(keys);
+        event->links = new(struct event_link, n);
+        if (!event->links)
+                return -ENOMEM;
+
+        STRV_FOREACH(k, keys) {
+                struct event_link *link = event->links + event->n_links;
+                struct event_group *group;
+
+                group = hashmap_get(event->manager->event_groups, *k);
+                if (!group) {
+                        group = new(struct event_group, 1);
+                        if (!group)
+                                return -ENOMEM;
+
+                        *group = (struct event_group) {
+                                .key = strdup(*k),
+                        };
+                        if (!group->key) {
+                                free(group);
+                                return -ENOMEM;
+                        }
+
+                        r = hashmap_ensure_put(&event->manager->event_groups, &string_hash_ops, group->key, group);
+                        if (r < 0) {
+                                free(group->key);
+                                free(group);
+                                return r;
+                        }
+                }
+
+                *link = (struct event_link) {
+                        .event = event,
+                        .group = group,
+                };
+
+                LIST_INSERT_AFTER(links, group->links, group->links_tail, link);
+                group->links_tail = link;
+                event->n_links++;
+        }
+
+        return event_index_keys(event->dev, false, &event->wait_keys);
+}
+
 static int event_queue_insert(Manager *manager, sd_device *dev) {
         _cleanup_(sd_device_unrefp) sd_device *clone = NULL;
         struct event *event;
@@ -714,6 +926,7 @@ static int event_queue_insert(Manager *manager, sd_device *dev) {
                 .dev_kernel = TAKE_PTR(clone),
                 .seqnum = seqnum,
                 .state = EVENT_QUEUED,
+                .queued_usec = now(CLOCK_MONOTONIC),
         };
 
         if (LIST_IS_EMPTY(manager->events)) {
@@ -724,6 +937,12 @@ static int event_queue_insert(Manager *manager, sd_device *dev) {
 
         LIST_APPEND(event, manager->events, event);
 
+        r = event_index_add(event);
+        if (r < 0) {
+                event_free(event);
+                return r;
+        }
+
         log_device_uevent(dev, "Device is queued");
 
         return 0;
@@ -749,114 +968,28 @@ static void manager_kill_workers(Manager *manager, bool force) {
 }
 
 /* lookup event for identical, parent, child device */
-static int is_device_busy(Manager *manager, struct event *event) {
-        const char *subsystem, *devpath, *devpath_old = NULL;
-        dev_t devnum = makedev(0, 0);
-        struct event *loop_event;
-        size_t devpath_len;
-        int r, ifindex = 0;
-        bool is_block;
+static bool is_device_busy(Manager *manager, struct event *event) {
+        char **k;
 
-        r = sd_device_get_subsystem(event->dev, &subsystem);
-        if (r < 0)
-                return r;
-
-        is_block = streq(subsystem, "block");
-
-        r = sd_device_get_devpath(event->dev, &devpath);
-        if (r < 0)
-                return r;
+        STRV_FOREACH(k, event->wait_keys) {
+                struct event_group *group;
+                struct event *loop_event;
 
-        devpath_len = strlen(devpath);
-
-        r = sd_device_get_property_value(event->dev, "DEVPATH_OLD", &devpath_old);
-        if (r < 0 && r != -ENOENT)
-                return r;
-
-        r = sd_device_get_devnum(event->dev, &devnum);
-        if (r < 0 && r != -ENOENT)
-                return r;
-
-        r = sd_device_get_ifindex(event->dev, &ifindex);
-        if (r < 0 && r != -ENOENT)
-                return r;
-
-        /* check if queue contains events we depend on */
-        LIST_FOREACH(event, loop_event, manager->events) {
-                size_t loop_devpath_len, common;
-                const char *loop_devpath;
-
-                /* we already found a later event, earlier cannot block us, no need to check again */
-                if (loop_event->seqnum < event->delaying_seqnum)
+                group = hashmap_get(manager->event_groups, *k);
+                if (!group)
                         continue;
 
-                /* event we checked earlier still exists, no need to check again */
-                if (loop_event->seqnum == event->delaying_seqnum)
-                        return true;
-
-                /* found ourself, no later event can block us */
+                /* The oldest event with this key, if it is older than us, we need to wait for it */
+                loop_event = group->links->event;
                 if (loop_event->seqnum >= event->seqnum)
-                        break;
-
-                /* check major/minor */
-                if (major(devnum) != 0) {
-                        const char *s;
-                        dev_t d;
-
-                        if (sd_device_get_subsystem(loop_event->dev, &s) < 0)
-                                continue;
-
-                        if (sd_device_get_devnum(loop_event->dev, &d) >= 0 &&
-                            devnum == d && is_block == streq(s, "block"))
-                                goto set_delaying_seqnum;
-                }
-
-                /* check network device ifindex */
-                if (ifindex > 0) {
-                        int i;
-
-                        if (sd_device_get_ifindex(loop_event->dev, &i) >= 0 &&
-                            ifindex == i)
-                                goto set_delaying_seqnum;
-                }
-
-                if (sd_device_get_devpath(loop_event->dev, &loop_devpath) < 0)
                         continue;
 
-                /* check our old name */
-                if (devpath_old && streq(devpath_old, loop_devpath))
-                        goto set_delaying_seqnum;
-
-                loop_devpath_len = strlen(loop_devpath);
-
-                /* compare devpath */
-                common = MIN(devpath_len, loop_devpath_len);
-
-                /* one devpath is contained in the other? */
-                if (!strneq(devpath, loop_devpath, common))
-                        continue;
-
-                /* identical device event found */
-                if (devpath_len == loop_devpath_len)
-                        goto set_delaying_seqnum;
-
-                /* parent device event found */
-                if (devpath[common] == '/')
-                        goto set_delaying_seqnum;
-
-                /* child device event found */
-                if (loop_devpath[common] == '/')
-                        goto set_delaying_seqnum;
+                log_device_debug(event->dev, "SEQNUM=%" PRIu64 " blocked by SEQNUM=%" PRIu64,
+                                 event->seqnum, loop_event->seqnum);
+                return true;
         }
 
         return false;
-
-set_delaying_seqnum:
-        log_device_debug(event->dev, "SEQNUM=%" PRIu64 " blocked by SEQNUM=%" PRIu64,
-                         event->seqnum, loop_event->seqnum);
-
-        event->delaying_seqnum = loop_event->seqnum;
-        return true;
 }
 
 static void manager_exit(Manager *manager) {
@@ -951,7 +1084,7 @@ static void event_queue_start(Manager *manager) {
                         continue;
 
                 /* do not start event if parent or child event is still running */
-                if (is_device_busy(manager, event) != 0)
+                if (is_device_busy(manager, event))
                         continue;
 
                 event_run(manager, event);
@@ -1027,6 +1160,20 @@ static int on_worker(sd_event_source *s, int fd, uint32_t revents, void *userdat
                         worker->state = WORKER_IDLE;
 
                 /* worker returned */
+                if (worker->event && DEBUG_LOGGING) {
+                        char queued[FORMAT_TIMESPAN_MAX], processed[FORMAT_TIMESPAN_MAX];
+                        usec_t n = now(CLOCK_MONOTONIC);
+
+                        log_device_debug(worker->event->dev, "SEQNUM=%" PRIu64 " waited %s in the queue, processed in %s.",
+                                         worker->event->seqnum,
+                                         format_timespan(queued, sizeof queued,
+                                                         usec_sub_unsigned(worker->event->started_usec, worker->event->queued_usec),
+                                                         USEC_PER_MSEC),
+                                         format_timespan(processed, sizeof processed,
+                                                         usec_sub_unsigned(n, worker->event->started_usec),
+                                                         USEC_PER_MSEC));
+                }
+
                 event_free(worker->event);
         }
 